@@ -0,0 +1,69 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// Runs one ULT on each of an increasing number of execution streams,
+// all of them waiting on the same barrier in a loop, and reports the
+// time per barrier episode for the Argobots barriers (barrier,
+// xstream_barrier) and the spin_barrier and dissemination_barrier.
+
+static double run(std::size_t num_xstreams, unsigned iterations,
+                  const std::function<void(std::size_t)>& wait) {
+    std::vector<tl::managed<tl::xstream>> xstreams;
+    std::vector<tl::managed<tl::thread>>  threads;
+    for(std::size_t i = 0; i < num_xstreams; i++)
+        xstreams.push_back(tl::xstream::create());
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < num_xstreams; i++) {
+        threads.push_back(xstreams[i]->make_thread([i, iterations, &wait]() {
+            for(unsigned it = 0; it < iterations; it++) wait(i);
+        }));
+    }
+    for(auto& t : threads) t->join();
+    auto end = std::chrono::steady_clock::now();
+    threads.clear();
+    for(auto& x : xstreams) x->join();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char** argv) {
+    std::size_t max_xstreams = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16;
+    unsigned    iterations   = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+    tl::abt scope;
+    std::cout << "xstreams\tbarrier\txstream_barrier\tspin_barrier\tdissemination (ns/episode)"
+              << std::endl;
+    for(std::size_t n = 1; n <= max_xstreams; n *= 2) {
+        auto count = static_cast<std::uint32_t>(n);
+        double abt_ult, abt_es, spin, dissemination;
+        {
+            tl::barrier b(count);
+            abt_ult = run(n, iterations, [&b](std::size_t) { b.wait(); });
+        }
+        {
+            tl::xstream_barrier b(count);
+            abt_es = run(n, iterations, [&b](std::size_t) { b.wait(); });
+        }
+        {
+            tl::spin_barrier b(count);
+            spin = run(n, iterations, [&b](std::size_t) { b.wait(); });
+        }
+        {
+            tl::dissemination_barrier b(count);
+            dissemination = run(n, iterations, [&b](std::size_t i) { b.wait(i); });
+        }
+        std::cout << n << "\t" << abt_ult << "\t" << abt_es << "\t" << spin << "\t"
+                  << dissemination << std::endl;
+    }
+    return 0;
+}
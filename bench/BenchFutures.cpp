@@ -0,0 +1,56 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// Fan-in of n values into a future with a callback summing them, as
+// done when gathering the results of n RPCs, repeated a number of
+// times: future allocates its callback and a vector of pointers every
+// time it becomes ready, latch_future is created once and reset.
+
+int main(int argc, char** argv) {
+    std::uint32_t n          = argc > 1 ? std::atoi(argv[1]) : 1000;
+    unsigned      iterations = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    tl::abt          scope;
+    std::vector<int> values(n, 1);
+    long             sum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned it = 0; it < iterations; it++) {
+        tl::future<int> f(n, [&sum](const std::vector<int*>& v) {
+            for(auto p : v) sum += *p;
+        });
+        for(std::uint32_t i = 0; i < n; i++) f.set(&values[i]);
+        f.wait();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double t_future = std::chrono::duration<double, std::nano>(end - start).count()
+                    / (double(iterations) * n);
+
+    tl::latch_future<int> l(n, [&sum](tl::latch_values<int> v) {
+        for(auto p : v) sum += *p;
+    });
+    start = std::chrono::steady_clock::now();
+    for(unsigned it = 0; it < iterations; it++) {
+        for(std::uint32_t i = 0; i < n; i++) l.set(i, &values[i]);
+        l.wait();
+        l.reset();
+    }
+    end = std::chrono::steady_clock::now();
+    double t_latch = std::chrono::duration<double, std::nano>(end - start).count()
+                   / (double(iterations) * n);
+
+    if(sum != 2L * n * iterations) std::abort();
+    std::cout << "future:       " << t_future << " ns/value" << std::endl;
+    std::cout << "latch_future: " << t_latch << " ns/value" << std::endl;
+    return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// Exposes buffers of increasing sizes allocated on regular pages
+// (std::vector) and with huge_page_allocator, and reports, for each,
+// the time taken by engine::expose (memory registration) and the
+// bandwidth of pulling the buffer into another one through the self
+// address.
+
+template <typename Vector>
+static void run(tl::engine& engine, const char* label, std::size_t size,
+                unsigned iterations) {
+    Vector src(size), dst(size);
+    std::memset(src.data(), 'a', size);
+    std::memset(dst.data(), 'b', size);
+    std::vector<std::pair<void*, std::size_t>> src_seg{{src.data(), size}};
+    std::vector<std::pair<void*, std::size_t>> dst_seg{{dst.data(), size}};
+
+    auto start = std::chrono::steady_clock::now();
+    tl::bulk src_bulk = engine.expose(src_seg, tl::bulk_mode::read_only);
+    auto end = std::chrono::steady_clock::now();
+    double expose_us = std::chrono::duration<double, std::micro>(end - start).count();
+    tl::bulk dst_bulk = engine.expose(dst_seg, tl::bulk_mode::write_only);
+
+    tl::remote_bulk remote = src_bulk.on(engine.self());
+    remote >> dst_bulk.select(0, size); // warm up
+    start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < iterations; i++) remote >> dst_bulk.select(0, size);
+    end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double mib     = static_cast<double>(size) * iterations / (1024.0 * 1024.0);
+    if(std::memcmp(src.data(), dst.data(), size) != 0) {
+        std::cerr << "Data mismatch" << std::endl;
+        std::exit(1);
+    }
+    std::cout << size / (1024 * 1024) << "\t" << label << "\t"
+              << tl::huge_page_size_of(src.data()) << "\t" << expose_us << "\t"
+              << mib / seconds << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string protocol   = argc > 1 ? argv[1] : "na+sm";
+    std::size_t max_size   = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1024*1024*1024;
+    unsigned    iterations = argc > 3 ? std::atoi(argv[3]) : 10;
+
+    tl::engine engine(protocol, THALLIUM_SERVER_MODE);
+    std::cout << "MiB\tbuffer\tpage_size\texpose_us\tMiB/s" << std::endl;
+    for(std::size_t size = 4*1024*1024; size <= max_size; size *= 4) {
+        run<std::vector<char>>(engine, "4KiB", size, iterations);
+        run<tl::huge_page_vector<char>>(engine, "huge", size, iterations);
+        run<tl::huge_page_vector<char, tl::huge_page_1gb>>(engine, "huge_1GiB", size, iterations);
+    }
+    engine.finalize();
+    return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <thallium/inplace_function.hpp>
+
+namespace tl = thallium;
+
+// Mimics the lambdas built by forward() and respond(): a few
+// captured pointers and a call taking an opaque handle.
+struct fake_proc { int value; };
+
+template<typename Function>
+static double run(unsigned iterations) {
+    fake_proc p{0};
+    void* a = &p;
+    void* b = &iterations;
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < iterations; i++) {
+        Function fn = [a, b, &p](fake_proc* proc) {
+            proc->value += (a != b) ? 1 : 0;
+            return p.value;
+        };
+        fn(&p);
+    }
+    auto end = std::chrono::steady_clock::now();
+    if(p.value != static_cast<int>(iterations)) std::abort();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char** argv) {
+    unsigned iterations = argc > 1 ? std::atoi(argv[1]) : 10000000;
+    double t_std = run<std::function<int(fake_proc*)>>(iterations);
+    double t_ipf = run<tl::inplace_function<int(fake_proc*), 64>>(iterations);
+    std::cout << "std::function (construct + call):        " << t_std << " ns/call" << std::endl;
+    std::cout << "tl::inplace_function (construct + call): " << t_ipf << " ns/call" << std::endl;
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// Runs ULTs on execution streams bound to the CPUs of each NUMA node,
+// each repeatedly acquiring a slab from a bulk_pool, encoding a payload
+// into it (memcpy) and decoding it back (reading and summing), the way
+// handlers use pooled staging buffers. The pool is either a single
+// arena first touched by the main thread, which is where buffers end up
+// when the progress execution stream allocates them, or split into one
+// arena per node. Reports the bandwidth seen by the ULTs of each node;
+// on a machine with two sockets, the ULTs of the node the main thread
+// does not run on encode and decode across the interconnect with the
+// single arena, and locally with the per-node arenas.
+
+static double run(tl::bulk_pool& pool, int node, std::size_t per_node, std::size_t size,
+                  unsigned iterations) {
+    const auto& topo = tl::topology::get();
+    const auto& cpus = topo.cpus(node);
+    std::vector<tl::managed<tl::pool>>    pools;
+    std::vector<tl::managed<tl::xstream>> xstreams;
+    std::vector<tl::managed<tl::thread>>  threads;
+    for(std::size_t i = 0; i < per_node; i++) {
+        pools.push_back(tl::pool::create(tl::pool::access::mpmc));
+        xstreams.push_back(tl::topology::create_xstream(
+            cpus[i % cpus.size()], tl::scheduler::predef::basic_wait, *pools.back()));
+    }
+    std::vector<std::uint64_t> sums(per_node, 0);
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < per_node; i++) {
+        threads.push_back(pools[i]->make_thread([&pool, &sums, i, size, iterations]() {
+            std::vector<char> payload(size, static_cast<char>(i + 1));
+            std::uint64_t     sum = 0;
+            for(unsigned it = 0; it < iterations; it++) {
+                auto lease = pool.acquire(size);
+                std::memcpy(lease.data(), payload.data(), size);
+                const auto* p = static_cast<const std::uint64_t*>(lease.data());
+                for(std::size_t k = 0; k < size / sizeof(std::uint64_t); k++) sum += p[k];
+            }
+            sums[i] = sum;
+        }));
+    }
+    for(auto& t : threads) t->join();
+    auto end = std::chrono::steady_clock::now();
+    threads.clear();
+    for(auto& x : xstreams) x->join();
+    std::uint64_t check = 0;
+    for(auto s : sums) check += s;
+    if(check == 0) std::cerr << "Nothing decoded" << std::endl;
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double mib     = 2.0 * static_cast<double>(size) * iterations * per_node / (1024.0 * 1024.0);
+    return mib / seconds;
+}
+
+static void touch(tl::bulk_pool& pool, std::size_t size, std::size_t count) {
+    // the main thread acquires and zeroes every slab first, as the
+    // first allocator call from the progress execution stream would
+    std::vector<tl::bulk_pool::lease> leases;
+    for(std::size_t i = 0; i < count; i++) {
+        leases.push_back(pool.acquire(size));
+        std::memset(leases.back().data(), 0, size);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string protocol   = argc > 1 ? argv[1] : "na+sm";
+    std::size_t size       = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1024*1024;
+    std::size_t per_node   = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 4;
+    unsigned    iterations = argc > 4 ? std::atoi(argv[4]) : 2000;
+
+    tl::engine engine(protocol, THALLIUM_SERVER_MODE);
+    const auto& topo  = tl::topology::get();
+    auto        nodes = topo.numa_nodes();
+    std::size_t count = per_node * nodes.size();
+    if(nodes.size() < 2)
+        std::cerr << "Only one NUMA node: both pools are identical" << std::endl;
+    std::cout << "main thread on node " << tl::topology::current_numa_node() << std::endl;
+    std::cout << "node\tpool\tMiB/s" << std::endl;
+    for(int per_numa_node = 0; per_numa_node <= 1; per_numa_node++) {
+        // no local free lists, so that the slabs touched by the main
+        // thread do not stay in its own list
+        tl::bulk_pool pool(engine, {{size, count}}, tl::bulk_mode::read_write, 0, 64,
+                           per_numa_node != 0);
+        touch(pool, size, count);
+        for(int node : nodes) {
+            double bw = run(pool, node, per_node, size, iterations);
+            std::cout << node << "\t" << (per_numa_node ? "per_node" : "single") << "\t" << bw
+                      << std::endl;
+        }
+    }
+    engine.finalize();
+    return 0;
+}
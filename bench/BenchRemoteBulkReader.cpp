@@ -0,0 +1,55 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// Scans a buffer exposed by this process, through the self address, in
+// records of increasing sizes: once with a synchronous pull per record,
+// and once with a remote_bulk_reader, and reports the throughput of
+// each and the read-ahead depth the reader settled on.
+int main(int argc, char** argv) {
+    std::string protocol = argc > 1 ? argv[1] : "na+sm";
+    std::size_t size     = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256*1024*1024;
+
+    tl::engine engine(protocol, THALLIUM_SERVER_MODE);
+    {
+        std::vector<char> src(size, 'a');
+        std::vector<std::pair<void*, std::size_t>> src_seg{{src.data(), size}};
+        tl::bulk        src_bulk = engine.expose(src_seg, tl::bulk_mode::read_only);
+        tl::remote_bulk remote   = src_bulk.on(engine.self());
+
+        std::cout << "record\tsync MiB/s\treader MiB/s\tdepth" << std::endl;
+        for(std::size_t record = 4096; record <= 1024*1024; record *= 4) {
+            std::vector<char> dst(record);
+            std::vector<std::pair<void*, std::size_t>> dst_seg{{dst.data(), record}};
+            tl::bulk dst_bulk = engine.expose(dst_seg, tl::bulk_mode::write_only);
+            double   mib      = static_cast<double>(size) / (1024.0*1024.0);
+
+            auto start = std::chrono::steady_clock::now();
+            for(std::size_t offset = 0; offset + record <= size; offset += record)
+                remote.select(offset, record) >> dst_bulk.select(0, record);
+            auto   end  = std::chrono::steady_clock::now();
+            double sync = mib / std::chrono::duration<double>(end - start).count();
+
+            tl::remote_bulk_reader reader(engine, remote);
+            start = std::chrono::steady_clock::now();
+            while(reader.read(dst.data(), record) == record) {}
+            end = std::chrono::steady_clock::now();
+            double ahead = mib / std::chrono::duration<double>(end - start).count();
+
+            std::cout << record << "\t" << sync << "\t" << ahead << "\t" << reader.depth()
+                      << std::endl;
+        }
+    }
+    engine.finalize();
+    return 0;
+}
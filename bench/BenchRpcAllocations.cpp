@@ -0,0 +1,78 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// Counts the heap allocations made through operator new while this
+// process sends small RPCs to itself with a cached handle: those of
+// callable_remote_procedure::forward, of the handler installed by
+// engine::define, of request::respond and of the decoding of both
+// packed_data. Allocations made by margo, Mercury and Argobots go
+// through malloc and are not counted, being out of Thallium's hands.
+// Exits with an error if the average number of allocations per RPC
+// exceeds the budget.
+
+static std::atomic<bool>        counting{false};
+static std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    if(counting.load(std::memory_order_relaxed))
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+int main(int argc, char** argv) {
+    std::string protocol   = argc > 1 ? argv[1] : "na+sm";
+    unsigned    iterations = argc > 2 ? std::atoi(argv[2]) : 10000;
+    double      budget     = argc > 3 ? std::atof(argv[3]) : 0.0;
+
+    tl::engine engine(protocol, THALLIUM_SERVER_MODE);
+    engine.enable_handle_cache();
+    double per_rpc = 0.0;
+    {
+        auto echo = engine.define("echo", [](const tl::request& req, int x) {
+            req.respond(x + 1);
+        });
+        tl::endpoint self = engine.self();
+
+        // warms up the handle cache, the free lists and the hash tables
+        for(unsigned i = 0; i < 1000; i++) {
+            int r = echo.on(self)(static_cast<int>(i));
+            if(r != static_cast<int>(i) + 1) return 1;
+        }
+        counting = true;
+        for(unsigned i = 0; i < iterations; i++) {
+            int r = echo.on(self)(static_cast<int>(i));
+            if(r != static_cast<int>(i) + 1) return 1;
+        }
+        counting = false;
+        per_rpc = static_cast<double>(allocations.load()) / (iterations ? iterations : 1);
+        std::cout << "allocations\tRPCs\tper RPC" << std::endl;
+        std::cout << allocations.load() << "\t" << iterations << "\t" << per_rpc << std::endl;
+    }
+    engine.finalize();
+    if(per_rpc > budget) {
+        std::cerr << "More than " << budget << " allocation(s) per RPC" << std::endl;
+        return 1;
+    }
+    return 0;
+}
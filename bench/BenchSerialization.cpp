@@ -0,0 +1,247 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/map.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/tuple.hpp>
+#include <thallium/serialization/stl/unordered_map.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace tl = thallium;
+
+// Encodes and decodes representative types directly into a buffer
+// through an hg_proc_t (no network) with proc_output_archive and
+// proc_input_archive, and reports for each the number of bytes
+// produced, the time per encode and decode of the whole value, and the
+// corresponding throughput. Variants using the memcpy fast path
+// (tl::is_trivially_serializable), the varint encoding, the fixed-layout
+// encoding of RPC arguments that are all numbers (through
+// tl::proc_object_encode, as RPCs do) and, with C++17, a decode_arena
+// are reported next to their baseline.
+//
+// Usage: BenchSerialization [scale] [iterations]
+//   scale       multiplies the number of elements of each value (default 1)
+//   iterations  number of encodes and decodes of each value (default 100)
+
+// same layout and serialize() as the point of examples/06_custom
+template <int Variant> struct point {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+
+    template <typename A> void serialize(A& ar) {
+        ar & x;
+        ar & y;
+        ar & z;
+    }
+
+    bool operator==(const point& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+using point_fields = point<0>;
+using point_copy   = point<1>;
+
+namespace thallium {
+
+template <> struct is_trivially_serializable<point_copy> : std::true_type {};
+
+} // namespace thallium
+
+struct record {
+    std::uint64_t                 id = 0;
+    std::string                   name;
+    std::vector<std::int32_t>     tags;
+    std::map<std::string, double> attributes;
+
+    template <typename A> void serialize(A& ar) {
+        ar(id, name, tags, attributes);
+    }
+
+    bool operator==(const record& other) const {
+        return id == other.id && name == other.name && tags == other.tags
+            && attributes == other.attributes;
+    }
+};
+
+struct result {
+    std::size_t bytes     = 0;
+    double      encode_ns = 0;
+    double      decode_ns = 0;
+};
+
+static std::vector<char> buffer(256 * 1024 * 1024);
+
+template <typename Encode, typename Decode>
+static result run(hg_class_t* cls, unsigned iterations, Encode&& encode, Decode&& decode) {
+    hg_proc_t proc = HG_PROC_NULL;
+    hg_proc_create_set(cls, buffer.data(), buffer.size(), HG_ENCODE, HG_NOHASH, &proc);
+    result r;
+
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < iterations; i++) {
+        hg_proc_reset(proc, buffer.data(), buffer.size(), HG_ENCODE);
+        encode(proc);
+    }
+    auto end    = std::chrono::steady_clock::now();
+    r.bytes     = hg_proc_get_size_used(proc);
+    r.encode_ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < iterations; i++) {
+        hg_proc_reset(proc, buffer.data(), buffer.size(), HG_DECODE);
+        decode(proc);
+    }
+    end         = std::chrono::steady_clock::now();
+    r.decode_ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+
+    hg_proc_free(proc);
+    return r;
+}
+
+static void print(const std::string& name, const result& r) {
+    auto mb_per_s = [&r](double ns) { return r.bytes / ns * 1e9 / (1024.0 * 1024.0); };
+    std::cout << name << "\t" << r.bytes
+              << "\t" << r.encode_ns << "\t" << mb_per_s(r.encode_ns)
+              << "\t" << r.decode_ns << "\t" << mb_per_s(r.decode_ns) << std::endl;
+}
+
+template <typename T, typename... Ctx>
+static void bench(hg_class_t* cls, const std::string& name, const T& in,
+                  unsigned iterations, Ctx... c) {
+    std::tuple<Ctx...> ctx(c...);
+    T out;
+    auto r = run(cls, iterations,
+        [&](hg_proc_t proc) {
+            tl::proc_output_archive<Ctx...> ar(proc, ctx);
+            ar(in);
+        },
+        [&](hg_proc_t proc) {
+            out = T();
+            tl::proc_input_archive<Ctx...> ar(proc, ctx);
+            ar(out);
+        });
+    if(!(out == in))
+        std::cerr << "Error: decoded " << name << " differs from the encoded one" << std::endl;
+    print(name, r);
+}
+
+// encodes and decodes a small tuple of arguments the way RPCs do, one
+// RPC per iteration, taking the fixed-layout path for tuples of numbers
+template <typename... T>
+static void bench_args(hg_class_t* cls, margo_instance_id mid, const std::string& name,
+                       const std::tuple<T...>& in, unsigned iterations) {
+    std::tuple<>     ctx;
+    std::tuple<T...> out;
+    auto r = run(cls, iterations,
+        [&](hg_proc_t proc) {
+            tl::proc_object_encode(proc, const_cast<std::tuple<T...>&>(in), mid, ctx);
+        },
+        [&](hg_proc_t proc) {
+            tl::proc_object_decode(proc, out, mid, ctx);
+        });
+    if(!(out == in))
+        std::cerr << "Error: decoded " << name << " differs from the encoded one" << std::endl;
+    print(name, r);
+}
+
+template <typename P>
+static std::vector<P> make_points(std::size_t n) {
+    std::mt19937_64                        rng(42);
+    std::uniform_real_distribution<double> coord(-1.0, 1.0);
+    std::vector<P>                         points(n);
+    for(auto& p : points) {
+        p.x = coord(rng);
+        p.y = coord(rng);
+        p.z = coord(rng);
+    }
+    return points;
+}
+
+static std::vector<record> make_records(std::size_t n) {
+    std::vector<record> records(n);
+    for(std::size_t i = 0; i < n; i++) {
+        records[i].id   = i;
+        records[i].name = "record-" + std::to_string(i);
+        records[i].tags.assign(8, static_cast<std::int32_t>(i));
+        for(int j = 0; j < 4; j++) records[i].attributes["attr" + std::to_string(j)] = i * 0.5;
+    }
+    return records;
+}
+
+int main(int argc, char** argv) {
+    std::size_t scale      = argc > 1 ? std::atoi(argv[1]) : 1;
+    unsigned    iterations = argc > 2 ? std::atoi(argv[2]) : 100;
+    if(scale == 0) scale = 1;
+    if(iterations == 0) iterations = 1;
+
+    tl::engine  engine("na+sm", THALLIUM_CLIENT_MODE);
+    hg_class_t* cls = margo_get_class(engine.get_margo_instance());
+
+    std::cout << "type\tbytes\tencode_ns\tencode_mb/s\tdecode_ns\tdecode_mb/s" << std::endl;
+
+    bench(cls, "vector<double>", std::vector<double>(scale * 1024 * 1024, 3.14), iterations);
+    bench(cls, "vector<point>", make_points<point_fields>(scale * 100000), iterations);
+    bench(cls, "vector<point>/memcpy", make_points<point_copy>(scale * 100000), iterations);
+    bench(cls, "string", std::string(scale * 1024 * 1024, 's'), iterations);
+
+    std::vector<std::string> strings(scale * 10000, std::string(32, 's'));
+    bench(cls, "vector<string>", strings, iterations);
+
+    std::map<int, std::string> map;
+    for(std::size_t i = 0; i < scale * 10000; i++) map[i] = std::string(16, 'm');
+    bench(cls, "map<int,string>", map, iterations);
+
+    std::unordered_map<std::string, std::uint64_t> umap;
+    for(std::size_t i = 0; i < scale * 10000; i++) umap["key" + std::to_string(i)] = i;
+    bench(cls, "unordered_map<string,uint64>", umap, iterations);
+
+    bench(cls, "vector<record>", make_records(scale * 1000), iterations);
+
+    std::vector<std::uint64_t> small(scale * 100000);
+    for(std::size_t i = 0; i < small.size(); i++) small[i] = i % 1000;
+    bench(cls, "vector<uint64>", small, iterations);
+    bench(cls, "vector<uint64>/varint", small, iterations, tl::varint_encoding{});
+
+    // control-plane arguments: the archives versus the fixed layout
+    auto args = std::make_tuple(std::uint64_t(42), std::uint32_t(7), 3.5, std::int16_t(-1));
+    bench(cls, "args/archive", args, iterations * 1000);
+    bench_args(cls, engine.get_margo_instance(), "args/fixed", args, iterations * 1000);
+
+#ifdef THALLIUM_HAS_PMR
+    // decoding into a fresh arena each time, as RPC handlers do
+    auto r = run(cls, iterations,
+        [&](hg_proc_t proc) {
+            std::tuple<> ctx;
+            tl::proc_output_archive<> ar(proc, ctx);
+            ar(strings);
+        },
+        [&](hg_proc_t proc) {
+            tl::decode_arena                   arena;
+            std::pmr::vector<std::pmr::string> v(arena.resource());
+            std::tuple<>                       ctx;
+            tl::proc_input_archive<>           ar(proc, ctx);
+            ar(v);
+            if(v.size() != strings.size())
+                std::cerr << "Error: decoded pmr vector has the wrong size" << std::endl;
+        });
+    print("vector<string>/arena", r);
+#endif
+
+    engine.finalize();
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace tl = thallium;
+
+// Serializes the same vector of points directly into a buffer through an
+// hg_proc_t (no network), with the per-element serialize() function, with
+// the column-oriented layout of tl::soa_fields, and as a single block with
+// tl::is_trivially_serializable, and reports the number of bytes produced
+// and the encode and decode throughput (in vectors per second).
+
+template <int Layout> struct point {
+    double   x  = 0.0;
+    double   y  = 0.0;
+    double   z  = 0.0;
+    uint32_t id = 0;
+
+    template <typename A> void serialize(A& ar) { ar(x, y, z, id); }
+
+    bool operator==(const point& other) const {
+        return x == other.x && y == other.y && z == other.z && id == other.id;
+    }
+};
+
+using point_aos  = point<0>;
+using point_soa  = point<1>;
+using point_copy = point<2>;
+
+namespace thallium {
+
+template <> struct soa_fields<point_soa> {
+    static auto fields() {
+        return std::make_tuple(&point_soa::x, &point_soa::y, &point_soa::z, &point_soa::id);
+    }
+};
+
+template <> struct is_trivially_serializable<point_copy> : std::true_type {};
+
+} // namespace thallium
+
+struct result {
+    std::size_t bytes  = 0;
+    double      encode = 0;
+    double      decode = 0;
+};
+
+template <typename P>
+static result run(hg_class_t* cls, const std::vector<P>& in, unsigned iterations) {
+    std::tuple<>      ctx;
+    std::vector<char> buffer(64 * 1024 * 1024);
+    hg_proc_t         proc = HG_PROC_NULL;
+    hg_proc_create_set(cls, buffer.data(), buffer.size(), HG_ENCODE, HG_NOHASH, &proc);
+    result r;
+
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < iterations; i++) {
+        hg_proc_reset(proc, buffer.data(), buffer.size(), HG_ENCODE);
+        tl::proc_output_archive<> ar(proc, ctx);
+        ar(in);
+    }
+    auto end = std::chrono::steady_clock::now();
+    r.bytes  = hg_proc_get_size_used(proc);
+    r.encode = iterations / std::chrono::duration<double>(end - start).count();
+
+    std::vector<P> out;
+    start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < iterations; i++) {
+        hg_proc_reset(proc, buffer.data(), buffer.size(), HG_DECODE);
+        tl::proc_input_archive<> ar(proc, ctx);
+        ar(out);
+    }
+    end      = std::chrono::steady_clock::now();
+    r.decode = iterations / std::chrono::duration<double>(end - start).count();
+
+    hg_proc_free(proc);
+    if(out != in)
+        std::cerr << "Error: decoded vector differs from the encoded one" << std::endl;
+    return r;
+}
+
+template <typename P>
+static std::vector<P> make_points(unsigned n) {
+    std::mt19937_64                        rng(42);
+    std::uniform_real_distribution<double> coord(-1.0, 1.0);
+    std::vector<P>                         points(n);
+    for(unsigned i = 0; i < n; i++) {
+        points[i].x  = coord(rng);
+        points[i].y  = coord(rng);
+        points[i].z  = coord(rng);
+        points[i].id = i;
+    }
+    return points;
+}
+
+static void print(const std::string& name, const result& r) {
+    std::cout << name << "\t" << r.bytes << "\t" << r.encode << "\t" << r.decode << std::endl;
+}
+
+int main(int argc, char** argv) {
+    unsigned num_points = argc > 1 ? std::atoi(argv[1]) : 100000;
+    unsigned iterations = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    tl::engine engine("na+sm", THALLIUM_CLIENT_MODE);
+    hg_class_t* cls = margo_get_class(engine.get_margo_instance());
+
+    std::cout << "layout\tbytes\tencodes/s\tdecodes/s" << std::endl;
+    print("per-element", run(cls, make_points<point_aos>(num_points), iterations));
+    print("soa", run(cls, make_points<point_soa>(num_points), iterations));
+    print("memcpy", run(cls, make_points<point_copy>(num_points), iterations));
+
+    engine.finalize();
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// Pulls a buffer exposed by this process into another one through the
+// self address, splitting the transfer into an increasing number of
+// stripes, and reports the bandwidth obtained for each stripe count.
+int main(int argc, char** argv) {
+    std::string protocol   = argc > 1 ? argv[1] : "na+sm";
+    std::size_t size       = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64*1024*1024;
+    unsigned    iterations = argc > 3 ? std::atoi(argv[3]) : 20;
+
+    tl::engine engine(protocol, THALLIUM_SERVER_MODE);
+    {
+        std::vector<char> src(size, 'a');
+        std::vector<char> dst(size, 'b');
+        std::vector<std::pair<void*, std::size_t>> src_seg{{src.data(), size}};
+        std::vector<std::pair<void*, std::size_t>> dst_seg{{dst.data(), size}};
+        tl::bulk src_bulk = engine.expose(src_seg, tl::bulk_mode::read_only);
+        tl::bulk dst_bulk = engine.expose(dst_seg, tl::bulk_mode::write_only);
+        tl::remote_bulk remote = src_bulk.on(engine.self());
+
+        std::cout << "stripes\tMiB/s" << std::endl;
+        for(std::size_t stripes = 1; stripes <= 64; stripes *= 2) {
+            remote.pull_to(dst_bulk.select(0, size), stripes).wait(); // warm up
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned i = 0; i < iterations; i++) {
+                remote.pull_to(dst_bulk.select(0, size), stripes).wait();
+            }
+            auto end = std::chrono::steady_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+            double mib = static_cast<double>(size) * iterations / (1024.0*1024.0);
+            std::cout << stripes << "\t" << mib / seconds << std::endl;
+        }
+        if(dst != src) {
+            std::cerr << "Data mismatch" << std::endl;
+            return 1;
+        }
+    }
+    engine.finalize();
+    return 0;
+}
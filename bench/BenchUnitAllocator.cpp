@@ -0,0 +1,134 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// Creates tasks in a custom pool (the same as in examples/14_custom_sched)
+// served by a number of execution streams, once with units allocated by
+// std::allocator (the default) and once with pooled_unit_allocator, and
+// reports the rate at which tasks go through the pool.
+
+class my_unit {
+
+    tl::thread    m_thread;
+    tl::task      m_task;
+    tl::unit_type m_type;
+    bool          m_in_pool;
+
+    friend class my_pool;
+
+    public:
+
+    my_unit(const tl::thread& t)
+    : m_thread(t), m_type(tl::unit_type::thread), m_in_pool(false) {}
+
+    my_unit(const tl::task& t)
+    : m_task(t), m_type(tl::unit_type::task), m_in_pool(false) {}
+
+    tl::unit_type get_type() const {
+        return m_type;
+    }
+
+    const tl::thread& get_thread() const {
+        return m_thread;
+    }
+
+    const tl::task& get_task() const {
+        return m_task;
+    }
+
+    bool is_in_pool() const {
+        return m_in_pool;
+    }
+};
+
+class my_pool {
+
+    mutable std::mutex   m_mutex;
+    std::deque<my_unit*> m_units;
+
+    public:
+
+    static const tl::pool::access access_type = tl::pool::access::mpmc;
+
+    size_t get_size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_units.size();
+    }
+
+    void push(my_unit* u) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        u->m_in_pool = true;
+        m_units.push_back(u);
+    }
+
+    my_unit* pop() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_units.empty())
+            return nullptr;
+        my_unit* u = m_units.front();
+        m_units.pop_front();
+        u->m_in_pool = false;
+        return u;
+    }
+
+    void remove(my_unit* u) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find(m_units.begin(), m_units.end(), u);
+        if(it != m_units.end()) {
+            (*it)->m_in_pool = false;
+            m_units.erase(it);
+        }
+    }
+};
+
+static double run(tl::pool& pool, unsigned num_xstreams, unsigned num_tasks) {
+    std::vector<tl::managed<tl::xstream>> ess;
+    for(unsigned i = 0; i < num_xstreams; i++)
+        ess.push_back(tl::xstream::create(tl::scheduler::predef::basic, pool));
+    std::atomic<unsigned> done{0};
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < num_tasks; i++) {
+        pool.make_task([&done]() { done += 1; }, tl::anonymous());
+    }
+    while(done.load() != num_tasks) tl::thread::yield();
+    auto end = std::chrono::steady_clock::now();
+    for(auto& es : ess) es->join();
+    return num_tasks / std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+    unsigned num_tasks    = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    unsigned num_xstreams = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    tl::abt scope;
+
+    double rate_std, rate_pooled;
+    {
+        auto pool = tl::pool::create<my_pool, my_unit>();
+        rate_std = run(*pool, num_xstreams, num_tasks);
+    }
+    {
+        auto pool = tl::pool::create<my_pool, my_unit,
+                                     std::allocator<my_pool>,
+                                     tl::pooled_unit_allocator<my_unit>>();
+        rate_pooled = run(*pool, num_xstreams, num_tasks);
+    }
+    std::cout << "allocator\ttasks/s" << std::endl;
+    std::cout << "std::allocator\t" << rate_std << std::endl;
+    std::cout << "pooled_unit_allocator\t" << rate_pooled << std::endl;
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace tl = thallium;
+
+// Serializes the same payloads with the default fixed-width encoding and
+// with tl::varint_encoding, directly into a buffer through an hg_proc_t
+// (no network), and reports the number of bytes produced and the encode
+// and decode throughput (in payloads per second) for each encoding.
+
+struct payloads {
+    std::vector<uint64_t>              ids;    // small identifiers
+    std::vector<std::vector<uint32_t>> nested; // many small containers
+    std::vector<int64_t>               deltas; // small signed values
+};
+
+struct result {
+    std::size_t bytes  = 0;
+    double      encode = 0;
+    double      decode = 0;
+};
+
+template <typename... CtxArg>
+static result run(hg_class_t* cls, const payloads& in, unsigned iterations) {
+    std::tuple<CtxArg...> ctx;
+    std::vector<char>     buffer(64 * 1024 * 1024);
+    hg_proc_t             proc = HG_PROC_NULL;
+    hg_proc_create_set(cls, buffer.data(), buffer.size(), HG_ENCODE, HG_NOHASH, &proc);
+    result r;
+
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < iterations; i++) {
+        hg_proc_reset(proc, buffer.data(), buffer.size(), HG_ENCODE);
+        tl::proc_output_archive<CtxArg...> ar(proc, ctx);
+        ar(in.ids, in.nested, in.deltas);
+    }
+    auto end = std::chrono::steady_clock::now();
+    r.bytes  = hg_proc_get_size_used(proc);
+    r.encode = iterations / std::chrono::duration<double>(end - start).count();
+
+    payloads out;
+    start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < iterations; i++) {
+        hg_proc_reset(proc, buffer.data(), buffer.size(), HG_DECODE);
+        tl::proc_input_archive<CtxArg...> ar(proc, ctx);
+        ar(out.ids, out.nested, out.deltas);
+    }
+    end      = std::chrono::steady_clock::now();
+    r.decode = iterations / std::chrono::duration<double>(end - start).count();
+
+    hg_proc_free(proc);
+    if(out.ids != in.ids || out.nested != in.nested || out.deltas != in.deltas)
+        std::cerr << "Error: decoded payload differs from the encoded one" << std::endl;
+    return r;
+}
+
+static void print(const std::string& name, const result& r) {
+    std::cout << name << "\t" << r.bytes << "\t" << r.encode << "\t" << r.decode << std::endl;
+}
+
+int main(int argc, char** argv) {
+    unsigned num_ids    = argc > 1 ? std::atoi(argv[1]) : 100000;
+    unsigned iterations = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    tl::engine engine("na+sm", THALLIUM_CLIENT_MODE);
+    hg_class_t* cls = margo_get_class(engine.get_margo_instance());
+
+    std::mt19937_64 rng(42);
+    payloads        in;
+    for(unsigned i = 0; i < num_ids; i++) in.ids.push_back(rng() % (1 << 20));
+    for(unsigned i = 0; i < num_ids / 10; i++) {
+        std::vector<uint32_t> v(rng() % 8);
+        for(auto& x : v) x = rng() % 256;
+        in.nested.push_back(std::move(v));
+    }
+    for(unsigned i = 0; i < num_ids; i++)
+        in.deltas.push_back(static_cast<int64_t>(rng() % 2001) - 1000);
+
+    std::cout << "encoding\tbytes\tencodes/s\tdecodes/s" << std::endl;
+    print("fixed", run<>(cls, in, iterations));
+    print("varint", run<tl::varint_encoding>(cls, in, iterations));
+
+    engine.finalize();
+    return 0;
+}
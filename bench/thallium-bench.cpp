@@ -0,0 +1,331 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/map.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace tl = thallium;
+
+// thallium-bench measures RPC latency and throughput, bulk bandwidth and
+// serialization throughput. Results are printed on stdout as one JSON
+// object per line, so that runs of different versions can be compared.
+//
+// Usage: thallium-bench [-p protocol] [-n iterations] [-s | -a address]
+//   -s          only run the server side, printing its address on stderr
+//               and waiting for a client to shut it down
+//   -a address  only run the client side, against the given server
+// Without -s or -a, the client and the server run in the same process.
+
+using clock_type = std::chrono::steady_clock;
+
+static const std::vector<std::size_t> handler_pool_sizes = {1, 2, 4, 8};
+
+struct options {
+    std::string protocol   = "na+sm";
+    std::string address;
+    bool        serve      = false;
+    unsigned    iterations = 1000;
+};
+
+static double elapsed_us(clock_type::time_point start, clock_type::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+static void report(const std::string& bench, const std::string& params,
+                   std::vector<double>& samples_us, std::size_t bytes_per_op) {
+    std::sort(samples_us.begin(), samples_us.end());
+    double total = 0.0;
+    for(auto s : samples_us) total += s;
+    auto pct = [&samples_us](double p) {
+        std::size_t i = static_cast<std::size_t>(p / 100.0 * (samples_us.size() - 1));
+        return samples_us[i];
+    };
+    double mean = total / samples_us.size();
+    std::ostringstream out;
+    out << "{\"bench\":\"" << bench << "\"," << params
+        << ",\"iterations\":" << samples_us.size()
+        << ",\"mean_us\":" << mean
+        << ",\"p50_us\":" << pct(50)
+        << ",\"p99_us\":" << pct(99)
+        << ",\"ops_per_sec\":" << 1e6 / mean;
+    if(bytes_per_op)
+        out << ",\"mib_per_sec\":" << bytes_per_op / mean * 1e6 / (1024.0*1024.0);
+    out << "}";
+    std::cout << out.str() << std::endl;
+}
+
+static void report_throughput(const std::string& bench, const std::string& params,
+                              std::size_t ops, double total_us, std::size_t bytes_per_op) {
+    std::ostringstream out;
+    out << "{\"bench\":\"" << bench << "\"," << params
+        << ",\"iterations\":" << ops
+        << ",\"total_us\":" << total_us
+        << ",\"ops_per_sec\":" << ops / total_us * 1e6;
+    if(bytes_per_op)
+        out << ",\"mib_per_sec\":" << ops * bytes_per_op / total_us * 1e6 / (1024.0*1024.0);
+    out << "}";
+    std::cout << out.str() << std::endl;
+}
+
+// Server side: RPCs used by the client side of the benchmarks.
+class bench_server {
+
+    tl::engine&                           m_engine;
+    std::vector<tl::managed<tl::pool>>    m_pools;
+    std::vector<tl::managed<tl::xstream>> m_xstreams;
+
+  public:
+
+    bench_server(tl::engine& engine)
+    : m_engine(engine) {
+        m_engine.define("bench_empty", [](const tl::request& req) {
+            req.respond();
+        });
+        m_engine.define("bench_echo", [](const tl::request& req, const std::vector<char>& data) {
+            req.respond(data);
+        });
+        m_engine.define("bench_ack", [](const tl::request& req, const std::vector<char>& data) {
+            req.respond(data.size());
+        });
+        m_engine.define("bench_vector_double",
+            [](const tl::request& req, const std::vector<double>& data) {
+                req.respond(data.size());
+            });
+        m_engine.define("bench_vector_string",
+            [](const tl::request& req, const std::vector<std::string>& data) {
+                req.respond(data.size());
+            });
+        m_engine.define("bench_map",
+            [](const tl::request& req, const std::map<int, std::string>& data) {
+                req.respond(data.size());
+            });
+        m_engine.define("bench_bulk",
+            [this](const tl::request& req, tl::bulk& remote, bool pull) {
+                std::vector<char> buffer(remote.size());
+                std::vector<std::pair<void*, std::size_t>> segments{{buffer.data(), buffer.size()}};
+                tl::bulk local = m_engine.expose(segments, tl::bulk_mode::read_write);
+                if(pull) remote.on(req.get_endpoint()) >> local;
+                else     remote.on(req.get_endpoint()) << local;
+                req.respond(buffer.size());
+            });
+        // one RPC per handler pool size, each handler busy for ~20us
+        for(auto n : handler_pool_sizes) {
+            m_pools.push_back(tl::pool::create(tl::pool::access::mpmc));
+            auto& p = *m_pools.back();
+            for(std::size_t i = 0; i < n; i++)
+                m_xstreams.push_back(tl::xstream::create(tl::scheduler::predef::basic_wait, p));
+            m_engine.define("bench_pool_" + std::to_string(n), [](const tl::request& req) {
+                auto start = clock_type::now();
+                while(elapsed_us(start, clock_type::now()) < 20.0) {}
+                req.respond();
+            }, 0, p);
+        }
+    }
+
+    ~bench_server() {
+        for(auto& x : m_xstreams) x->join();
+    }
+};
+
+static void bench_rpc_latency(tl::engine& engine, const tl::endpoint& ep, unsigned iterations) {
+    auto empty = engine.define("bench_empty");
+    auto echo  = engine.define("bench_echo");
+    {
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        empty.on(ep)();
+        for(unsigned i = 0; i < iterations; i++) {
+            auto start = clock_type::now();
+            empty.on(ep)();
+            samples.push_back(elapsed_us(start, clock_type::now()));
+        }
+        report("rpc_latency", "\"size\":0", samples, 0);
+    }
+    for(std::size_t size : {std::size_t(8), std::size_t(4096), std::size_t(1024*1024)}) {
+        std::vector<char> data(size, 'x');
+        std::vector<double> samples;
+        unsigned n = size >= 1024*1024 ? std::max(1u, iterations / 10) : iterations;
+        samples.reserve(n);
+        std::vector<char> back = echo.on(ep)(data);
+        for(unsigned i = 0; i < n; i++) {
+            auto start = clock_type::now();
+            back = echo.on(ep)(data).as<std::vector<char>>();
+            samples.push_back(elapsed_us(start, clock_type::now()));
+        }
+        report("rpc_latency", "\"size\":" + std::to_string(size), samples, 2*size);
+    }
+}
+
+static void bench_rpc_concurrency(tl::engine& engine, const tl::endpoint& ep, unsigned iterations) {
+    auto ack = engine.define("bench_ack");
+    std::vector<char> data(8, 'x');
+    for(std::size_t depth : {1, 4, 16, 64}) {
+        std::vector<tl::async_response> in_flight;
+        in_flight.reserve(depth);
+        unsigned sent = 0;
+        auto start = clock_type::now();
+        while(sent < iterations && in_flight.size() < depth) {
+            in_flight.push_back(ack.on(ep).async(data));
+            sent++;
+        }
+        while(!in_flight.empty()) {
+            decltype(in_flight)::iterator done;
+            tl::async_response::wait_any(in_flight.begin(), in_flight.end(), done);
+            in_flight.erase(done);
+            if(sent < iterations) {
+                in_flight.push_back(ack.on(ep).async(data));
+                sent++;
+            }
+        }
+        report_throughput("rpc_concurrency", "\"depth\":" + std::to_string(depth),
+                          iterations, elapsed_us(start, clock_type::now()), 0);
+    }
+}
+
+static void bench_handler_pools(tl::engine& engine, const tl::endpoint& ep, unsigned iterations) {
+    const std::size_t depth = 64;
+    for(auto n : handler_pool_sizes) {
+        auto rpc = engine.define("bench_pool_" + std::to_string(n));
+        std::vector<tl::async_response> in_flight;
+        unsigned sent = 0;
+        auto start = clock_type::now();
+        while(sent < iterations && in_flight.size() < depth) {
+            in_flight.push_back(rpc.on(ep).async());
+            sent++;
+        }
+        while(!in_flight.empty()) {
+            decltype(in_flight)::iterator done;
+            tl::async_response::wait_any(in_flight.begin(), in_flight.end(), done);
+            in_flight.erase(done);
+            if(sent < iterations) {
+                in_flight.push_back(rpc.on(ep).async());
+                sent++;
+            }
+        }
+        report_throughput("handler_pool", "\"xstreams\":" + std::to_string(n),
+                          iterations, elapsed_us(start, clock_type::now()), 0);
+    }
+}
+
+static void bench_bulk(tl::engine& engine, const tl::endpoint& ep, unsigned iterations) {
+    auto rpc = engine.define("bench_bulk");
+    const std::size_t total = 4*1024*1024;
+    unsigned n = std::max(1u, iterations / 20);
+    std::vector<char> buffer(total, 'x');
+    for(bool pull : {true, false}) {
+        for(std::size_t count : {1, 4, 16, 64}) {
+            std::vector<std::pair<void*, std::size_t>> segments;
+            std::size_t seg_size = total / count;
+            for(std::size_t i = 0; i < count; i++)
+                segments.emplace_back(buffer.data() + i*seg_size, seg_size);
+            tl::bulk b = engine.expose(segments, tl::bulk_mode::read_write);
+            rpc.on(ep)(b, pull);
+            std::vector<double> samples;
+            for(unsigned i = 0; i < n; i++) {
+                auto start = clock_type::now();
+                rpc.on(ep)(b, pull);
+                samples.push_back(elapsed_us(start, clock_type::now()));
+            }
+            report(pull ? "bulk_pull" : "bulk_push",
+                   "\"segments\":" + std::to_string(count) + ",\"size\":" + std::to_string(total),
+                   samples, total);
+        }
+    }
+}
+
+template <typename T>
+static void bench_serialization_of(tl::engine& engine, const tl::endpoint& ep,
+                                   const std::string& rpc_name, const T& data,
+                                   unsigned iterations) {
+    auto rpc = engine.define(rpc_name);
+    std::size_t bytes = rpc.on(ep).get_encoded_size(data);
+    rpc.on(ep)(data);
+    std::vector<double> samples;
+    for(unsigned i = 0; i < iterations; i++) {
+        auto start = clock_type::now();
+        rpc.on(ep)(data);
+        samples.push_back(elapsed_us(start, clock_type::now()));
+    }
+    report("serialization", "\"type\":\"" + rpc_name.substr(6) + "\",\"bytes\":"
+           + std::to_string(bytes), samples, bytes);
+}
+
+static void bench_serialization(tl::engine& engine, const tl::endpoint& ep, unsigned iterations) {
+    unsigned n = std::max(1u, iterations / 10);
+    std::vector<double> doubles(64*1024, 3.14);
+    bench_serialization_of(engine, ep, "bench_vector_double", doubles, n);
+    std::vector<std::string> strings(4096, std::string(16, 's'));
+    bench_serialization_of(engine, ep, "bench_vector_string", strings, n);
+    std::map<int, std::string> map;
+    for(int i = 0; i < 4096; i++) map[i] = std::string(16, 'm');
+    bench_serialization_of(engine, ep, "bench_map", map, n);
+}
+
+static void run_client(tl::engine& engine, const tl::endpoint& ep, unsigned iterations) {
+    bench_rpc_latency(engine, ep, iterations);
+    bench_rpc_concurrency(engine, ep, iterations);
+    bench_handler_pools(engine, ep, iterations);
+    bench_bulk(engine, ep, iterations);
+    bench_serialization(engine, ep, iterations);
+}
+
+int main(int argc, char** argv) {
+    options opt;
+    int c;
+    while((c = getopt(argc, argv, "p:n:sa:")) != -1) {
+        switch(c) {
+        case 'p': opt.protocol   = optarg; break;
+        case 'n': opt.iterations = std::atoi(optarg); break;
+        case 's': opt.serve      = true; break;
+        case 'a': opt.address    = optarg; break;
+        default:
+            std::cerr << "Usage: " << argv[0]
+                      << " [-p protocol] [-n iterations] [-s | -a address]" << std::endl;
+            return 1;
+        }
+    }
+    if(opt.iterations == 0) opt.iterations = 1;
+
+    if(opt.serve) {
+        tl::engine engine(opt.protocol, THALLIUM_SERVER_MODE, true, 0);
+        engine.enable_remote_shutdown();
+        {
+            bench_server server(engine);
+            std::cerr << "Server running at address " << engine.self() << std::endl;
+            engine.wait_for_finalize();
+        }
+        return 0;
+    }
+
+    if(!opt.address.empty()) {
+        tl::engine engine(opt.protocol, THALLIUM_CLIENT_MODE, true, 0);
+        {
+            tl::endpoint ep = engine.lookup(opt.address);
+            run_client(engine, ep, opt.iterations);
+            engine.shutdown_remote_engine(ep);
+        }
+        engine.finalize();
+        return 0;
+    }
+
+    tl::engine engine(opt.protocol, THALLIUM_SERVER_MODE, true, 0);
+    {
+        bench_server server(engine);
+        run_client(engine, engine.self(), opt.iterations);
+        engine.finalize();
+    }
+    return 0;
+}
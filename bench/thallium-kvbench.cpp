@@ -0,0 +1,455 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace tl = thallium;
+
+// thallium-kvbench runs a sharded in-memory key-value provider and a
+// client driving it, so that changes to thallium are measured on the
+// combination of features a real service uses: providers, small and
+// large (RDMA) arguments, bulk responses, multi-key requests and
+// server-side batching or client-side aggregation. For each operation,
+// ults ULTs per client xstream issue requests back to back for the given
+// duration, on keys drawn uniformly among the preloaded ones. Results are
+// printed on stdout as one JSON object per line, as in thallium-bench.
+//
+// Usage: thallium-kvbench [-p protocol] [-s | -a address] [-o ops]
+//                         [-d seconds] [-x xstreams] [-c ults] [-k keys]
+//                         [-v value_size] [-m multi_get_size] [-n shards]
+//                         [-t handler_xstreams] [-b batch_size]
+//   -s          only run the server side, printing its address on stderr
+//               and waiting for a client to shut it down
+//   -a address  only run the client side, against the given server
+//   -o ops      comma-separated operations among put, get, multi_get,
+//               get_bulk, put_batched and put_aggregated (default all)
+//   -d seconds  duration of each operation (default 5)
+//   -x xstreams number of client xstreams (default 4)
+//   -c ults     ULTs issuing requests per client xstream (default 8)
+//   -k keys     number of keys (default 100000)
+//   -v bytes    size of the values (default 1024); values of 64 KiB or
+//               more are sent by RDMA by put
+//   -m count    keys per multi_get (default 16)
+//   -n shards   shards of the store (default 16)
+//   -t xstreams number of handler xstreams of the server (default 4)
+//   -b count    batch size of put_batched and put_aggregated (default 32)
+// Without -s or -a, the client and the server run in the same process.
+
+using clock_type = std::chrono::steady_clock;
+
+static const std::vector<std::string> all_ops = {
+    "put", "get", "multi_get", "get_bulk", "put_batched", "put_aggregated"};
+
+static const std::uint16_t kv_provider_id = 1;
+
+struct options {
+    std::string              protocol         = "na+sm";
+    std::string              address;
+    bool                     serve            = false;
+    std::vector<std::string> ops              = all_ops;
+    double                   duration         = 5.0;
+    unsigned                 xstreams         = 4;
+    unsigned                 ults             = 8;
+    std::size_t              keys             = 100000;
+    std::size_t              value_size       = 1024;
+    std::size_t              multi_get_size   = 16;
+    std::size_t              shards           = 16;
+    unsigned                 handler_xstreams = 4;
+    std::size_t              batch_size       = 32;
+};
+
+static double elapsed_us(clock_type::time_point start, clock_type::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+static std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::istringstream       in(s);
+    std::string              part;
+    while(std::getline(in, part, sep))
+        if(!part.empty()) parts.push_back(part);
+    return parts;
+}
+
+static std::string key_of(std::size_t i) {
+    return "key-" + std::to_string(i);
+}
+
+// Server side: a store split into shards, each protected by its own
+// mutex. Values are immutable once stored and shared with the handlers
+// reading them, so that a get_bulk pushes a value without copying it
+// and without holding the shard's lock during the transfer.
+class kv_provider : public tl::provider<kv_provider> {
+
+    using value_ptr = std::shared_ptr<const std::vector<char>>;
+
+    struct shard {
+        tl::mutex                                  mutex;
+        std::unordered_map<std::string, value_ptr> values;
+    };
+
+    std::vector<std::unique_ptr<shard>> m_shards;
+    std::vector<tl::remote_procedure>   m_rpcs;
+
+    shard& shard_of(const std::string& key) {
+        return *m_shards[std::hash<std::string>()(key) % m_shards.size()];
+    }
+
+    void store(const std::string& key, std::vector<char>&& value) {
+        auto  v = std::make_shared<const std::vector<char>>(std::move(value));
+        auto& s = shard_of(key);
+        std::lock_guard<tl::mutex> lock(s.mutex);
+        s.values[key] = std::move(v);
+    }
+
+    value_ptr find(const std::string& key) {
+        auto& s = shard_of(key);
+        std::lock_guard<tl::mutex> lock(s.mutex);
+        auto it = s.values.find(key);
+        return it == s.values.end() ? nullptr : it->second;
+    }
+
+    void put(const tl::request& req, const std::string& key,
+             tl::large<std::vector<char>>& value) {
+        store(key, std::move(value.get()));
+        req.respond(true);
+    }
+
+    void get(const tl::request& req, const std::string& key) {
+        auto v = find(key);
+        if(v) req.respond(*v);
+        else req.respond(std::vector<char>());
+    }
+
+    void multi_get(const tl::request& req, const std::vector<std::string>& keys) {
+        std::vector<std::vector<char>> result(keys.size());
+        for(std::size_t i = 0; i < keys.size(); i++) {
+            auto v = find(keys[i]);
+            if(v) result[i] = *v;
+        }
+        req.respond(result);
+    }
+
+    void get_bulk(const tl::request& req, const std::string& key, tl::bulk& remote) {
+        auto v = find(key);
+        if(!v) {
+            req.respond(std::size_t(0));
+            return;
+        }
+        std::size_t size = std::min(v->size(), remote.size());
+        std::vector<std::pair<void*, std::size_t>> segments{
+            {const_cast<char*>(v->data()), size}};
+        tl::bulk local = get_engine().expose(segments, tl::bulk_mode::read_only);
+        remote.on(req.get_endpoint()) << local(0, size);
+        req.respond(size);
+    }
+
+    // a batch of puts takes the lock of each shard involved once
+    void put_batch(tl::request_batch<std::string, std::vector<char>>& batch) {
+        std::vector<std::vector<std::size_t>> by_shard(m_shards.size());
+        for(std::size_t i = 0; i < batch.size(); i++) {
+            auto& key = std::get<0>(batch[i].second);
+            by_shard[std::hash<std::string>()(key) % m_shards.size()].push_back(i);
+        }
+        for(std::size_t s = 0; s < by_shard.size(); s++) {
+            if(by_shard[s].empty()) continue;
+            std::lock_guard<tl::mutex> lock(m_shards[s]->mutex);
+            for(auto i : by_shard[s]) {
+                auto& args = batch[i].second;
+                m_shards[s]->values[std::get<0>(args)] =
+                    std::make_shared<const std::vector<char>>(std::move(std::get<1>(args)));
+            }
+        }
+        for(auto& entry : batch) entry.first.respond(true);
+    }
+
+  public:
+
+    kv_provider(const tl::engine& e, std::uint16_t provider_id, std::size_t num_shards,
+                std::size_t batch_size, const tl::pool& pool)
+    : tl::provider<kv_provider>(e, provider_id, "kvbench") {
+        for(std::size_t i = 0; i < std::max<std::size_t>(num_shards, 1); i++)
+            m_shards.emplace_back(new shard);
+        m_rpcs.push_back(define("kv_put", &kv_provider::put, pool));
+        m_rpcs.push_back(define("kv_get", &kv_provider::get, pool));
+        m_rpcs.push_back(define("kv_multi_get", &kv_provider::multi_get, pool));
+        m_rpcs.push_back(define("kv_get_bulk", &kv_provider::get_bulk, pool));
+        tl::engine engine = get_engine();
+        m_rpcs.push_back(engine.define_batched(
+            "kv_put_batched",
+            std::function<void(tl::request_batch<std::string, std::vector<char>>&)>(
+                [this](tl::request_batch<std::string, std::vector<char>>& batch) {
+                    put_batch(batch);
+                }),
+            batch_size, std::chrono::microseconds(100), provider_id, pool));
+        m_rpcs.push_back(engine.define_aggregated(
+            "kv_put_aggregated",
+            std::function<void(const tl::request&, const std::string&, const std::vector<char>&)>(
+                [this](const tl::request&, const std::string& key, const std::vector<char>& value) {
+                    store(key, std::vector<char>(value));
+                }),
+            provider_id, pool));
+    }
+
+    ~kv_provider() {
+        for(auto& rpc : m_rpcs) rpc.deregister();
+    }
+};
+
+class kv_server {
+
+    tl::managed<tl::pool>                 m_pool;
+    std::vector<tl::managed<tl::xstream>> m_xstreams;
+    std::unique_ptr<kv_provider>          m_provider;
+
+  public:
+
+    kv_server(tl::engine& engine, const options& opt)
+    : m_pool(tl::pool::create(tl::pool::access::mpmc)) {
+        for(unsigned i = 0; i < std::max(opt.handler_xstreams, 1u); i++)
+            m_xstreams.push_back(tl::xstream::create(tl::scheduler::predef::basic_wait, *m_pool));
+        m_provider.reset(new kv_provider(engine, kv_provider_id, opt.shards,
+                                         opt.batch_size, *m_pool));
+    }
+
+    ~kv_server() {
+        m_provider.reset();
+        for(auto& x : m_xstreams) x->join();
+    }
+};
+
+// Client side: ults ULTs per xstream run the operation back to back.
+class kv_client {
+
+    tl::engine&         m_engine;
+    tl::provider_handle m_ph;
+    const options&      m_opt;
+    tl::remote_procedure m_put;
+    tl::remote_procedure m_get;
+    tl::remote_procedure m_multi_get;
+    tl::remote_procedure m_get_bulk;
+    tl::remote_procedure m_put_batched;
+
+    struct worker_state {
+        std::mt19937_64     rng;
+        std::vector<char>   value;
+        std::vector<char>   buffer;
+        tl::bulk            buffer_bulk;
+        std::vector<double> samples;
+        std::size_t         errors = 0;
+    };
+
+    std::string random_key(worker_state& w) {
+        return key_of(std::uniform_int_distribution<std::size_t>(0, m_opt.keys - 1)(w.rng));
+    }
+
+    void run_op(const std::string& op, worker_state& w,
+                tl::rpc_aggregator<std::string, std::vector<char>>* aggregator) {
+        if(op == "put") {
+            bool ok = m_put.on(m_ph)(random_key(w), tl::large<std::vector<char>>(w.value));
+            if(!ok) w.errors += 1;
+        } else if(op == "get") {
+            std::vector<char> v = m_get.on(m_ph)(random_key(w));
+            if(v.size() != m_opt.value_size) w.errors += 1;
+        } else if(op == "multi_get") {
+            std::vector<std::string> keys;
+            for(std::size_t i = 0; i < m_opt.multi_get_size; i++) keys.push_back(random_key(w));
+            std::vector<std::vector<char>> values = m_multi_get.on(m_ph)(keys);
+            if(values.size() != keys.size()) w.errors += 1;
+        } else if(op == "get_bulk") {
+            std::size_t size = m_get_bulk.on(m_ph)(random_key(w), w.buffer_bulk);
+            if(size != m_opt.value_size) w.errors += 1;
+        } else if(op == "put_batched") {
+            bool ok = m_put_batched.on(m_ph)(random_key(w), w.value);
+            if(!ok) w.errors += 1;
+        } else {
+            (*aggregator)(random_key(w), w.value);
+        }
+    }
+
+    void run_worker(const std::string& op, unsigned index, clock_type::time_point end,
+                    worker_state& w,
+                    tl::rpc_aggregator<std::string, std::vector<char>>* aggregator) {
+        w.rng.seed(index * 7919 + 1);
+        w.value.assign(m_opt.value_size, 'v');
+        w.buffer.resize(std::max<std::size_t>(m_opt.value_size, 1));
+        std::vector<std::pair<void*, std::size_t>> segments{{w.buffer.data(), w.buffer.size()}};
+        w.buffer_bulk = m_engine.expose(segments, tl::bulk_mode::write_only);
+        while(clock_type::now() < end) {
+            auto start = clock_type::now();
+            try {
+                run_op(op, w, aggregator);
+            } catch(const tl::exception&) {
+                w.errors += 1;
+            }
+            w.samples.push_back(elapsed_us(start, clock_type::now()));
+        }
+    }
+
+    void report(const std::string& op, std::vector<worker_state>& workers, double total_us) {
+        std::vector<double> all;
+        std::size_t         errors = 0;
+        for(auto& w : workers) {
+            all.insert(all.end(), w.samples.begin(), w.samples.end());
+            errors += w.errors;
+        }
+        std::sort(all.begin(), all.end());
+        auto pct = [&all](double p) {
+            if(all.empty()) return 0.0;
+            return all[static_cast<std::size_t>(p / 100.0 * (all.size() - 1))];
+        };
+        std::size_t keys_per_op = op == "multi_get" ? m_opt.multi_get_size : 1;
+        std::ostringstream out;
+        out << "{\"bench\":\"kv\",\"op\":\"" << op << "\""
+            << ",\"value_size\":" << m_opt.value_size
+            << ",\"concurrency\":" << m_opt.xstreams * m_opt.ults
+            << ",\"ops\":" << all.size()
+            << ",\"errors\":" << errors
+            << ",\"ops_per_sec\":" << all.size() / total_us * 1e6
+            << ",\"keys_per_sec\":" << all.size() * keys_per_op / total_us * 1e6
+            << ",\"p50_us\":" << pct(50)
+            << ",\"p99_us\":" << pct(99)
+            << ",\"p999_us\":" << pct(99.9)
+            << "}";
+        std::cout << out.str() << std::endl;
+    }
+
+  public:
+
+    kv_client(tl::engine& engine, const tl::endpoint& ep, const options& opt)
+    : m_engine(engine)
+    , m_ph(ep, kv_provider_id)
+    , m_opt(opt)
+    , m_put(engine.define("kv_put"))
+    , m_get(engine.define("kv_get"))
+    , m_multi_get(engine.define("kv_multi_get"))
+    , m_get_bulk(engine.define("kv_get_bulk"))
+    , m_put_batched(engine.define("kv_put_batched")) {}
+
+    // stores every key once, so that reads find their values
+    void preload() {
+        std::vector<char> value(m_opt.value_size, 'v');
+        for(std::size_t i = 0; i < m_opt.keys; i++)
+            m_put.on(m_ph)(key_of(i), tl::large<std::vector<char>>(value));
+    }
+
+    void run() {
+        std::vector<tl::managed<tl::xstream>> xstreams;
+        for(unsigned i = 0; i < m_opt.xstreams; i++) xstreams.push_back(tl::xstream::create());
+        for(auto& op : m_opt.ops) {
+            std::unique_ptr<tl::rpc_aggregator<std::string, std::vector<char>>> aggregator;
+            if(op == "put_aggregated")
+                aggregator.reset(new tl::rpc_aggregator<std::string, std::vector<char>>(
+                    m_engine, "kv_put_aggregated", m_ph, m_opt.batch_size,
+                    std::chrono::microseconds(100)));
+            std::vector<worker_state>            workers(m_opt.xstreams * m_opt.ults);
+            std::vector<tl::managed<tl::thread>> ults;
+            auto start = clock_type::now();
+            auto end   = start + std::chrono::duration_cast<clock_type::duration>(
+                                   std::chrono::duration<double>(m_opt.duration));
+            for(unsigned i = 0; i < workers.size(); i++) {
+                ults.push_back(xstreams[i % m_opt.xstreams]->make_thread(
+                    [this, &op, i, end, &workers, &aggregator]() {
+                        run_worker(op, i, end, workers[i], aggregator.get());
+                    }));
+            }
+            for(auto& t : ults) t->join();
+            // aggregated puts are only done once the last batch is sent
+            if(aggregator) aggregator->flush();
+            report(op, workers, elapsed_us(start, clock_type::now()));
+        }
+        for(auto& x : xstreams) x->join();
+    }
+};
+
+int main(int argc, char** argv) {
+    options opt;
+    int c;
+    while((c = getopt(argc, argv, "p:sa:o:d:x:c:k:v:m:n:t:b:")) != -1) {
+        switch(c) {
+        case 'p': opt.protocol         = optarg; break;
+        case 's': opt.serve            = true; break;
+        case 'a': opt.address          = optarg; break;
+        case 'd': opt.duration         = std::atof(optarg); break;
+        case 'x': opt.xstreams         = std::atoi(optarg); break;
+        case 'c': opt.ults             = std::atoi(optarg); break;
+        case 'k': opt.keys             = std::atoll(optarg); break;
+        case 'v': opt.value_size       = std::atoll(optarg); break;
+        case 'm': opt.multi_get_size   = std::atoi(optarg); break;
+        case 'n': opt.shards           = std::atoi(optarg); break;
+        case 't': opt.handler_xstreams = std::atoi(optarg); break;
+        case 'b': opt.batch_size       = std::atoi(optarg); break;
+        case 'o':
+            opt.ops = split(optarg, ',');
+            for(auto& op : opt.ops) {
+                if(std::find(all_ops.begin(), all_ops.end(), op) != all_ops.end()) continue;
+                std::cerr << "Invalid operation: " << op << std::endl;
+                return 1;
+            }
+            break;
+        default:
+            std::cerr << "Usage: " << argv[0]
+                      << " [-p protocol] [-s | -a address] [-o ops] [-d seconds]"
+                         " [-x xstreams] [-c ults] [-k keys] [-v value_size]"
+                         " [-m multi_get_size] [-n shards] [-t handler_xstreams]"
+                         " [-b batch_size]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if(opt.xstreams == 0) opt.xstreams = 1;
+    if(opt.ults == 0) opt.ults = 1;
+    if(opt.keys == 0) opt.keys = 1;
+    if(opt.batch_size == 0) opt.batch_size = 1;
+
+    if(opt.serve) {
+        tl::engine engine(opt.protocol, THALLIUM_SERVER_MODE, true, 0);
+        engine.enable_remote_shutdown();
+        {
+            kv_server server(engine, opt);
+            std::cerr << "Server running at address " << engine.self() << std::endl;
+            engine.wait_for_finalize();
+        }
+        return 0;
+    }
+
+    if(!opt.address.empty()) {
+        tl::engine engine(opt.protocol, THALLIUM_CLIENT_MODE, true, 0);
+        {
+            tl::endpoint ep = engine.lookup(opt.address);
+            kv_client    client(engine, ep, opt);
+            client.preload();
+            client.run();
+            engine.shutdown_remote_engine(ep);
+        }
+        engine.finalize();
+        return 0;
+    }
+
+    tl::engine engine(opt.protocol, THALLIUM_SERVER_MODE, true, 0);
+    {
+        kv_server server(engine, opt);
+        kv_client client(engine, engine.self(), opt);
+        client.preload();
+        client.run();
+        engine.finalize();
+    }
+    return 0;
+}
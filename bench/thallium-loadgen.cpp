@@ -0,0 +1,402 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace tl = thallium;
+
+// thallium-loadgen sends a mix of RPCs to a server at fixed arrival
+// rates (open loop) and reports, for each rate, the throughput achieved
+// and the latency distribution. Latencies are measured from the time at
+// which each RPC was meant to be sent, not from the time it was actually
+// sent: when the client falls behind (because the server or the client
+// saturates), the RPCs it could not send on time count the delay they
+// suffered, which a closed-loop benchmark would silently omit. The
+// uncorrected p99 is reported alongside for comparison. Results are
+// printed on stdout as one JSON object per line, as in thallium-bench.
+//
+// Usage: thallium-loadgen [-p protocol] [-s | -a address] [-r rates]
+//                         [-d seconds] [-x xstreams] [-w window]
+//                         [-m mix] [-S echo_size] [-B bulk_size]
+//                         [-W work_us] [-t handler_xstreams] [-P]
+//   -s          only run the server side, printing its address on stderr
+//               and waiting for a client to shut it down
+//   -a address  only run the client side, against the given server
+//   -r rates    comma-separated target rates, in RPCs per second
+//               (default 1000,2000,5000,10000,20000,50000)
+//   -d seconds  duration of each rate (default 5)
+//   -x xstreams number of sending xstreams (default 4)
+//   -w window   RPCs in flight per xstream at most (default 1024)
+//   -m mix      comma-separated weights of the RPCs empty, echo, bulk and
+//               work, as in empty=4,echo=2,bulk=1,work=1 (default empty=1)
+//   -S bytes    payload of echo RPCs (default 4096)
+//   -B bytes    size of the buffer pulled by bulk RPCs (default 1 MiB)
+//   -W us       busy time of the handler of work RPCs (default 50)
+//   -t xstreams number of handler xstreams of the server (default 4)
+//   -P          Poisson arrivals instead of evenly spaced ones
+// Without -s or -a, the client and the server run in the same process.
+
+using clock_type = std::chrono::steady_clock;
+
+static const std::vector<std::string> rpc_names = {"empty", "echo", "bulk", "work"};
+
+struct options {
+    std::string           protocol         = "na+sm";
+    std::string           address;
+    bool                  serve            = false;
+    std::vector<double>   rates            = {1000, 2000, 5000, 10000, 20000, 50000};
+    double                duration         = 5.0;
+    unsigned              xstreams         = 4;
+    std::size_t           window           = 1024;
+    std::vector<double>   mix              = {1, 0, 0, 0};
+    std::size_t           echo_size        = 4096;
+    std::size_t           bulk_size        = 1024 * 1024;
+    double                work_us          = 50.0;
+    unsigned              handler_xstreams = 4;
+    bool                  poisson          = false;
+};
+
+static double elapsed_us(clock_type::time_point start, clock_type::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+static std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> parts;
+    std::istringstream       in(s);
+    std::string              part;
+    while(std::getline(in, part, sep))
+        if(!part.empty()) parts.push_back(part);
+    return parts;
+}
+
+static bool parse_mix(const std::string& s, std::vector<double>& mix) {
+    mix.assign(rpc_names.size(), 0.0);
+    for(auto& item : split(s, ',')) {
+        auto eq  = item.find('=');
+        auto pos = std::find(rpc_names.begin(), rpc_names.end(), item.substr(0, eq));
+        if(pos == rpc_names.end()) return false;
+        double weight = eq == std::string::npos ? 1.0 : std::atof(item.c_str() + eq + 1);
+        mix[pos - rpc_names.begin()] = weight;
+    }
+    for(auto w : mix)
+        if(w > 0) return true;
+    return false;
+}
+
+// Server side: the RPCs of the mix, run by a pool of handler xstreams.
+class loadgen_server {
+
+    tl::engine&                           m_engine;
+    tl::managed<tl::pool>                 m_pool;
+    std::vector<tl::managed<tl::xstream>> m_xstreams;
+
+  public:
+
+    loadgen_server(tl::engine& engine, unsigned num_xstreams)
+    : m_engine(engine)
+    , m_pool(tl::pool::create(tl::pool::access::mpmc)) {
+        for(unsigned i = 0; i < num_xstreams; i++)
+            m_xstreams.push_back(tl::xstream::create(tl::scheduler::predef::basic_wait, *m_pool));
+        m_engine.define("loadgen_empty", [](const tl::request& req) {
+            req.respond();
+        }, 0, *m_pool);
+        m_engine.define("loadgen_echo", [](const tl::request& req, const std::vector<char>& data) {
+            req.respond(data);
+        }, 0, *m_pool);
+        m_engine.define("loadgen_bulk", [this](const tl::request& req, tl::bulk& remote) {
+            std::vector<char> buffer(remote.size());
+            std::vector<std::pair<void*, std::size_t>> segments{{buffer.data(), buffer.size()}};
+            tl::bulk local = m_engine.expose(segments, tl::bulk_mode::write_only);
+            remote.on(req.get_endpoint()) >> local;
+            req.respond(buffer.size());
+        }, 0, *m_pool);
+        m_engine.define("loadgen_work", [](const tl::request& req, double us) {
+            auto start = clock_type::now();
+            while(elapsed_us(start, clock_type::now()) < us) {}
+            req.respond();
+        }, 0, *m_pool);
+    }
+
+    ~loadgen_server() {
+        for(auto& x : m_xstreams) x->join();
+    }
+};
+
+// Latencies of the RPCs of one type sent by one xstream.
+struct samples {
+    std::vector<double> corrected;   // from the intended send time
+    std::vector<double> uncorrected; // from the actual send time
+    std::size_t         errors = 0;
+
+    void merge(const samples& other) {
+        corrected.insert(corrected.end(), other.corrected.begin(), other.corrected.end());
+        uncorrected.insert(uncorrected.end(), other.uncorrected.begin(), other.uncorrected.end());
+        errors += other.errors;
+    }
+};
+
+// Client side: one sender ULT per xstream, each sending its share of
+// the target rate.
+class loadgen_client {
+
+    struct in_flight {
+        std::size_t            type;
+        clock_type::time_point intended;
+        clock_type::time_point sent;
+    };
+
+    tl::engine&                       m_engine;
+    tl::endpoint                      m_ep;
+    const options&                    m_opt;
+    std::vector<tl::remote_procedure> m_rpcs;
+    std::vector<char>                 m_echo_payload;
+
+    static void complete(std::vector<tl::async_response>& responses,
+                         std::vector<in_flight>& info, std::size_t i,
+                         clock_type::time_point now, bool failed,
+                         std::vector<samples>& results) {
+        auto& s = results[info[i].type];
+        if(failed) {
+            s.errors += 1;
+        } else {
+            s.corrected.push_back(elapsed_us(info[i].intended, now));
+            s.uncorrected.push_back(elapsed_us(info[i].sent, now));
+        }
+        responses.erase(responses.begin() + i);
+        info.erase(info.begin() + i);
+    }
+
+    // waits for one response, blocking
+    static void wait_one(std::vector<tl::async_response>& responses,
+                         std::vector<in_flight>& info, std::vector<samples>& results) {
+        std::vector<tl::async_response>::iterator done;
+        bool failed = false;
+        try {
+            tl::async_response::wait_any(responses.begin(), responses.end(), done);
+        } catch(const tl::exception&) {
+            failed = true;
+        }
+        complete(responses, info, done - responses.begin(), clock_type::now(), failed, results);
+    }
+
+    // collects the responses already received, without blocking
+    static std::size_t reap(std::vector<tl::async_response>& responses,
+                            std::vector<in_flight>& info, std::vector<samples>& results) {
+        std::size_t count = 0;
+        for(std::size_t i = 0; i < responses.size();) {
+            if(!responses[i].received()) {
+                i++;
+                continue;
+            }
+            bool failed = false;
+            try {
+                responses[i].wait();
+            } catch(const tl::exception&) {
+                failed = true;
+            }
+            complete(responses, info, i, clock_type::now(), failed, results);
+            count += 1;
+        }
+        return count;
+    }
+
+    tl::async_response send(std::size_t type, const tl::bulk& bulk) {
+        auto& rpc = m_rpcs[type];
+        switch(type) {
+        case 0:  return rpc.on(m_ep).async();
+        case 1:  return rpc.on(m_ep).async(m_echo_payload);
+        case 2:  return rpc.on(m_ep).async(bulk);
+        default: return rpc.on(m_ep).async(m_opt.work_us);
+        }
+    }
+
+    void run_sender(unsigned index, double rate, clock_type::time_point start,
+                    std::vector<samples>& results) {
+        std::mt19937_64                  rng(index * 7919 + 1);
+        std::discrete_distribution<>     pick(m_opt.mix.begin(), m_opt.mix.end());
+        std::exponential_distribution<>  gap(rate);
+        std::vector<char>                buffer(m_opt.bulk_size, 'x');
+        std::vector<std::pair<void*, std::size_t>> segments{{buffer.data(), buffer.size()}};
+        tl::bulk bulk = m_engine.expose(segments, tl::bulk_mode::read_only);
+
+        std::vector<tl::async_response> responses;
+        std::vector<in_flight>          info;
+        responses.reserve(m_opt.window);
+        info.reserve(m_opt.window);
+
+        auto   end      = start + std::chrono::duration_cast<clock_type::duration>(
+                                      std::chrono::duration<double>(m_opt.duration));
+        // senders are staggered so that their arrivals interleave
+        double offset_s = m_opt.poisson ? gap(rng) : index / (rate * m_opt.xstreams);
+        auto   next     = start + std::chrono::duration_cast<clock_type::duration>(
+                                      std::chrono::duration<double>(offset_s));
+        while(next < end) {
+            auto now = clock_type::now();
+            if(now < next) {
+                if(reap(responses, info, results) == 0) tl::thread::yield();
+                continue;
+            }
+            if(responses.size() >= m_opt.window) {
+                wait_one(responses, info, results);
+                continue;
+            }
+            std::size_t type = pick(rng);
+            try {
+                responses.push_back(send(type, bulk));
+                info.push_back(in_flight{type, next, clock_type::now()});
+            } catch(const tl::exception&) {
+                results[type].errors += 1;
+            }
+            double interval_s = m_opt.poisson ? gap(rng) : 1.0 / rate;
+            next += std::chrono::duration_cast<clock_type::duration>(
+                std::chrono::duration<double>(interval_s));
+        }
+        while(!responses.empty()) wait_one(responses, info, results);
+    }
+
+    static void report(double target, const std::string& rpc, samples& s, double total_us) {
+        auto& c = s.corrected;
+        auto& u = s.uncorrected;
+        std::sort(c.begin(), c.end());
+        std::sort(u.begin(), u.end());
+        auto pct = [](const std::vector<double>& v, double p) {
+            if(v.empty()) return 0.0;
+            return v[static_cast<std::size_t>(p / 100.0 * (v.size() - 1))];
+        };
+        std::ostringstream out;
+        out << "{\"bench\":\"loadgen\",\"target_rps\":" << target
+            << ",\"rpc\":\"" << rpc << "\""
+            << ",\"completed\":" << c.size()
+            << ",\"errors\":" << s.errors
+            << ",\"achieved_rps\":" << c.size() / total_us * 1e6
+            << ",\"p50_us\":" << pct(c, 50)
+            << ",\"p90_us\":" << pct(c, 90)
+            << ",\"p99_us\":" << pct(c, 99)
+            << ",\"p999_us\":" << pct(c, 99.9)
+            << ",\"max_us\":" << (c.empty() ? 0.0 : c.back())
+            << ",\"p99_uncorrected_us\":" << pct(u, 99)
+            << "}";
+        std::cout << out.str() << std::endl;
+    }
+
+  public:
+
+    loadgen_client(tl::engine& engine, const tl::endpoint& ep, const options& opt)
+    : m_engine(engine)
+    , m_ep(ep)
+    , m_opt(opt)
+    , m_echo_payload(opt.echo_size, 'x') {
+        for(auto& name : rpc_names) m_rpcs.push_back(m_engine.define("loadgen_" + name));
+    }
+
+    void run() {
+        std::vector<tl::managed<tl::xstream>> xstreams;
+        for(unsigned i = 0; i < m_opt.xstreams; i++) xstreams.push_back(tl::xstream::create());
+        for(double rate : m_opt.rates) {
+            std::vector<std::vector<samples>> results(
+                m_opt.xstreams, std::vector<samples>(rpc_names.size()));
+            std::vector<tl::managed<tl::thread>> senders;
+            auto start = clock_type::now() + std::chrono::milliseconds(10);
+            for(unsigned i = 0; i < m_opt.xstreams; i++) {
+                senders.push_back(xstreams[i]->make_thread([this, i, rate, start, &results]() {
+                    run_sender(i, rate / m_opt.xstreams, start, results[i]);
+                }));
+            }
+            for(auto& t : senders) t->join();
+            double total_us = elapsed_us(start, clock_type::now());
+            samples all;
+            for(std::size_t type = 0; type < rpc_names.size(); type++) {
+                if(m_opt.mix[type] <= 0) continue;
+                samples s;
+                for(auto& r : results) s.merge(r[type]);
+                all.merge(s);
+                report(rate, rpc_names[type], s, total_us);
+            }
+            report(rate, "all", all, total_us);
+        }
+        for(auto& x : xstreams) x->join();
+    }
+};
+
+int main(int argc, char** argv) {
+    options opt;
+    int c;
+    while((c = getopt(argc, argv, "p:sa:r:d:x:w:m:S:B:W:t:P")) != -1) {
+        switch(c) {
+        case 'p': opt.protocol = optarg; break;
+        case 's': opt.serve    = true; break;
+        case 'a': opt.address  = optarg; break;
+        case 'r':
+            opt.rates.clear();
+            for(auto& r : split(optarg, ',')) opt.rates.push_back(std::atof(r.c_str()));
+            break;
+        case 'd': opt.duration         = std::atof(optarg); break;
+        case 'x': opt.xstreams         = std::atoi(optarg); break;
+        case 'w': opt.window           = std::atoi(optarg); break;
+        case 'S': opt.echo_size        = std::atoi(optarg); break;
+        case 'B': opt.bulk_size        = std::atoi(optarg); break;
+        case 'W': opt.work_us          = std::atof(optarg); break;
+        case 't': opt.handler_xstreams = std::atoi(optarg); break;
+        case 'P': opt.poisson          = true; break;
+        case 'm':
+            if(parse_mix(optarg, opt.mix)) break;
+            std::cerr << "Invalid mix: " << optarg << std::endl;
+            return 1;
+        default:
+            std::cerr << "Usage: " << argv[0]
+                      << " [-p protocol] [-s | -a address] [-r rates] [-d seconds]"
+                         " [-x xstreams] [-w window] [-m mix] [-S echo_size]"
+                         " [-B bulk_size] [-W work_us] [-t handler_xstreams] [-P]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if(opt.xstreams == 0) opt.xstreams = 1;
+    if(opt.window == 0) opt.window = 1;
+    if(opt.bulk_size == 0) opt.bulk_size = 1;
+    opt.rates.erase(std::remove_if(opt.rates.begin(), opt.rates.end(),
+                                   [](double r) { return r <= 0; }),
+                    opt.rates.end());
+
+    if(opt.serve) {
+        tl::engine engine(opt.protocol, THALLIUM_SERVER_MODE, true, 0);
+        engine.enable_remote_shutdown();
+        {
+            loadgen_server server(engine, opt.handler_xstreams);
+            std::cerr << "Server running at address " << engine.self() << std::endl;
+            engine.wait_for_finalize();
+        }
+        return 0;
+    }
+
+    if(!opt.address.empty()) {
+        tl::engine engine(opt.protocol, THALLIUM_CLIENT_MODE, true, 0);
+        {
+            tl::endpoint ep = engine.lookup(opt.address);
+            loadgen_client(engine, ep, opt).run();
+            engine.shutdown_remote_engine(ep);
+        }
+        engine.finalize();
+        return 0;
+    }
+
+    tl::engine engine(opt.protocol, THALLIUM_SERVER_MODE, true, 0);
+    {
+        loadgen_server server(engine, opt.handler_xstreams);
+        loadgen_client(engine, engine.self(), opt).run();
+        engine.finalize();
+    }
+    return 0;
+}
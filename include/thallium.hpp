@@ -7,29 +7,96 @@
 #include <thallium/anonymous.hpp>
 #include <thallium/bulk_mode.hpp>
 #include <thallium/bulk.hpp>
+#include <thallium/bulk_checksum.hpp>
+#include <thallium/bulk_pool.hpp>
+#include <thallium/huge_page_allocator.hpp>
+#include <thallium/device_bulk.hpp>
+#include <thallium/bulk_selection.hpp>
+#include <thallium/buffer_view.hpp>
+#include <thallium/opaque_payload.hpp>
+#include <thallium/decode_arena.hpp>
+#include <thallium/large.hpp>
+#include <thallium/proc_size_hints.hpp>
 #include <thallium/timeout.hpp>
+#include <thallium/expected.hpp>
 #include <thallium/engine.hpp>
+#include <thallium/engine_config.hpp>
+#include <thallium/engine_group.hpp>
 #include <thallium/endpoint.hpp>
 #include <thallium/remote_procedure.hpp>
+#include <thallium/typed_remote_procedure.hpp>
+#include <thallium/async_batch.hpp>
+#include <thallium/async_respond.hpp>
+#include <thallium/request_batch.hpp>
+#include <thallium/rpc_aggregator.hpp>
+#include <thallium/lock_stats.hpp>
+#include <thallium/rpc_stats.hpp>
+#include <thallium/pool_stats.hpp>
+#include <thallium/admission.hpp>
+#include <thallium/busy.hpp>
+#include <thallium/flow_control.hpp>
+#include <thallium/hedged.hpp>
+#include <thallium/cancellation.hpp>
+#include <thallium/tracing.hpp>
+#include <thallium/rpc_profiler.hpp>
+#include <thallium/rpc_capture.hpp>
+#include <thallium/rpc_replay.hpp>
+#include <thallium/drain.hpp>
+#include <thallium/local_dispatch.hpp>
 #include <thallium/callable_remote_procedure.hpp>
 #include <thallium/remote_bulk.hpp>
+#include <thallium/bulk_forward.hpp>
+#include <thallium/bulk_write_combiner.hpp>
+#include <thallium/remote_bulk_reader.hpp>
+#include <thallium/bulk_chain.hpp>
+#include <thallium/delta_sync.hpp>
+#include <thallium/response_stream.hpp>
 #include <thallium/provider.hpp>
 #include <thallium/provider_handle.hpp>
+#include <thallium/ordered_session.hpp>
+#include <thallium/response_cache.hpp>
+#include <thallium/provider_info.hpp>
+#include <thallium/provider_group.hpp>
+#include <thallium/collectives.hpp>
 #include <thallium/xstream.hpp>
+#include <thallium/topology.hpp>
 #include <thallium/barrier.hpp>
 #include <thallium/condition_variable.hpp>
 #include <thallium/eventual.hpp>
+#include <thallium/channel.hpp>
 #include <thallium/thread.hpp>
 #include <thallium/unit_type.hpp>
 #include <thallium/pool.hpp>
 #include <thallium/scheduler.hpp>
+#include <thallium/work_stealing_pool.hpp>
+#include <thallium/priority_pool.hpp>
+#include <thallium/parallel.hpp>
+#include <thallium/task_graph.hpp>
+#include <thallium/coroutine.hpp>
 #include <thallium/mutex.hpp>
 #include <thallium/rwlock.hpp>
+#include <thallium/rcu_ptr.hpp>
+#include <thallium/adaptive_mutex.hpp>
+#include <thallium/distributed_rwlock.hpp>
 #include <thallium/exception.hpp>
 #include <thallium/timer.hpp>
+#include <thallium/tsc_clock.hpp>
+#include <thallium/scoped_timer.hpp>
+#include <thallium/timer_wheel.hpp>
 #include <thallium/future.hpp>
+#include <thallium/latch_future.hpp>
 #include <thallium/xstream_barrier.hpp>
+#include <thallium/spin_barrier.hpp>
 #include <thallium/self.hpp>
+#include <thallium/ult_local.hpp>
+#include <thallium/xstream_local.hpp>
 #include <thallium/logger.hpp>
+#include <thallium/async_logger.hpp>
+#include <thallium/metrics_exporter.hpp>
+#include <thallium/elastic_xstreams.hpp>
+#include <thallium/pool_balancer.hpp>
+#include <thallium/peer_monitor.hpp>
+#include <thallium/failure_detector.hpp>
+#include <thallium/multi_rail.hpp>
 
 #endif
@@ -0,0 +1,118 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_ADAPTIVE_MUTEX_HPP
+#define __THALLIUM_ADAPTIVE_MUTEX_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <thallium/mutex.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Hints the CPU that the caller is spinning.
+ */
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#elif defined(__powerpc__) || defined(__ppc__)
+    __asm__ __volatile__("or 27,27,27");
+#endif
+}
+
+} // namespace detail
+
+/**
+ * @brief The adaptive_mutex class is a mutex tuned for short critical
+ * sections: lock() first spins, trying to acquire the lock without
+ * blocking, and only parks the calling ULT (as mutex::lock does) if the
+ * lock is still held after the spinning phase. The number of spins is
+ * adapted to the number of attempts that recent acquisitions needed,
+ * so that a lock whose holders release it quickly is acquired without
+ * a context switch, while a lock held for long stops wasting CPU.
+ *
+ * Since adaptive_mutex is a mutex, it can be used with std::lock_guard,
+ * std::unique_lock and thallium::condition_variable.
+ */
+class adaptive_mutex : public mutex {
+
+    std::atomic<int> m_spin_estimate{0};
+    int              m_max_spins;
+
+  public:
+    /**
+     * @brief Constructor.
+     *
+     * @param max_spins Maximum number of attempts before parking.
+     */
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    explicit adaptive_mutex(int max_spins = 100,
+                            const char* file = THALLIUM_LOCK_SITE_FILE,
+                            int line = THALLIUM_LOCK_SITE_LINE)
+    : mutex(false, file, line), m_max_spins(max_spins) {}
+#else
+    explicit adaptive_mutex(int max_spins = 100)
+    : mutex(false), m_max_spins(max_spins) {}
+#endif
+
+    adaptive_mutex(const adaptive_mutex&)            = delete;
+    adaptive_mutex& operator=(const adaptive_mutex&) = delete;
+
+    /**
+     * @brief Lock the mutex, spinning for a while before parking the
+     * calling ULT.
+     */
+    void lock() {
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        if(try_lock()) {
+            record_lock(0, false);
+            return;
+        }
+        auto start = detail::lock_site::now();
+#else
+        if(try_lock()) return;
+#endif
+        int estimate = m_spin_estimate.load(std::memory_order_relaxed);
+        int limit    = estimate * 2 + 10;
+        if(limit > m_max_spins) limit = m_max_spins;
+        int count = 0;
+        while(count < limit) {
+            count += 1;
+            detail::cpu_relax();
+            if(try_lock()) {
+                m_spin_estimate.store(estimate + (count - estimate) / 8,
+                                      std::memory_order_relaxed);
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+                record_lock(detail::lock_site::now() - start, true);
+#endif
+                return;
+            }
+        }
+        m_spin_estimate.store(estimate + (count - estimate) / 8,
+                              std::memory_order_relaxed);
+        lock_native();
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        record_lock(detail::lock_site::now() - start, true);
+#endif
+    }
+
+    /**
+     * @brief Returns the current number of spins lock() expects to need.
+     */
+    int spin_estimate() const noexcept {
+        return m_spin_estimate.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace thallium
+
+#endif /* end of include guard */
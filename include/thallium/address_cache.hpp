@@ -0,0 +1,127 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_ADDRESS_CACHE_HPP
+#define __THALLIUM_ADDRESS_CACHE_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <margo.h>
+#include <thallium/margo_exception.hpp>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Statistics reported by engine::get_address_cache_stats().
+ */
+struct address_cache_stats {
+    std::size_t hits   = 0; /*!< number of lookups served by the cache */
+    std::size_t misses = 0; /*!< number of lookups that went to Mercury */
+    std::size_t cached = 0; /*!< number of addresses currently in the cache */
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Cache of resolved addresses, indexed by their string form,
+ * attached to a margo instance by engine::enable_address_cache().
+ * The cache holds one reference to each hg_addr_t; endpoints handed
+ * out by engine::lookup share the address with it.
+ */
+class address_cache : public per_instance<address_cache> {
+
+    margo_instance_id        m_mid;
+    bool                     m_closed = false;
+    std::atomic<std::size_t> m_hits{0};
+    std::atomic<std::size_t> m_misses{0};
+    mutable std::mutex       m_mutex;
+    std::unordered_map<std::string, hg_addr_t> m_addrs;
+
+  public:
+
+    explicit address_cache(margo_instance_id mid)
+    : m_mid(mid) {}
+
+    address_cache(const address_cache&)            = delete;
+    address_cache& operator=(const address_cache&) = delete;
+
+    ~address_cache() {
+        clear();
+    }
+
+    /**
+     * @brief Returns a new reference (to be freed by the caller) to the
+     * cached address, or HG_ADDR_NULL on a miss.
+     */
+    hg_addr_t find(const std::string& address) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_addrs.find(address);
+        if(it == m_addrs.end()) {
+            m_misses += 1;
+            return HG_ADDR_NULL;
+        }
+        m_hits += 1;
+        hg_addr_t   addr = HG_ADDR_NULL;
+        hg_return_t ret  = margo_addr_dup(m_mid, it->second, &addr);
+        MARGO_ASSERT(ret, margo_addr_dup);
+        return addr;
+    }
+
+    /**
+     * @brief Caches a reference to an address resolved by the caller,
+     * unless the address is already cached (by a concurrent lookup).
+     */
+    void insert(const std::string& address, hg_addr_t addr) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_closed || m_addrs.count(address)) return;
+        hg_addr_t   copy = HG_ADDR_NULL;
+        hg_return_t ret  = margo_addr_dup(m_mid, addr, &copy);
+        MARGO_ASSERT(ret, margo_addr_dup);
+        m_addrs.emplace(address, copy);
+    }
+
+    /**
+     * @brief Removes an address from the cache, e.g. after the process
+     * at this address restarted.
+     */
+    void invalidate(const std::string& address) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_addrs.find(address);
+        if(it == m_addrs.end()) return;
+        margo_addr_free(m_mid, it->second);
+        m_addrs.erase(it);
+    }
+
+    /**
+     * @brief Frees all the cached addresses. If close is true, the cache
+     * will refuse any address inserted after this call.
+     */
+    void clear(bool close = false) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = m_closed || close;
+        for(auto& p : m_addrs) margo_addr_free(m_mid, p.second);
+        m_addrs.clear();
+    }
+
+    address_cache_stats stats() const {
+        address_cache_stats s;
+        s.hits   = m_hits.load();
+        s.misses = m_misses.load();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        s.cached = m_addrs.size();
+        return s;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
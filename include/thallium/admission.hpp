@@ -0,0 +1,547 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_ADMISSION_HPP
+#define __THALLIUM_ADMISSION_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <margo.h>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Request kept in the queue of an admission_limit until the
+ * bytes it needs are released.
+ */
+struct deferred_rpc {
+    margo_instance_id mid;
+    hg_handle_t       handle;
+    int               priority;
+    bool              has_priority;
+    std::size_t       bytes;
+    std::string       client;
+    std::uint64_t     arrival; // see thallium_dispatch_rpc
+};
+
+/**
+ * @private
+ * @brief Whether an admission_limit with a byte budget exists, so that
+ * bulk transfers only look for a request to charge when one may exist.
+ */
+inline std::atomic<bool>& admission_bytes_in_use() {
+    static std::atomic<bool> b{false};
+    return b;
+}
+
+/**
+ * @private
+ * @brief Shared state of an admission_limit. Limits with a byte budget
+ * or a queue of deferred requests keep what each request in flight was
+ * charged, by handle, under a mutex; the others only use in_flight.
+ */
+struct admission_state {
+    std::atomic<std::size_t>   in_flight{0};
+    std::atomic<std::uint64_t> admitted{0};
+    std::atomic<std::uint64_t> rejected{0};
+    std::size_t                max_in_flight = 0;
+    bool                       by_priority   = false;
+
+    std::size_t                max_bytes        = 0; // 0: no budget
+    std::size_t                max_client_bytes = 0; // 0: no budget
+    std::size_t                max_deferred     = 0; // 0: no queue
+    std::atomic<std::size_t>   bytes_in_flight{0};
+    std::atomic<std::uint64_t> deferred{0};
+
+    struct charge {
+        std::size_t bytes;
+        std::string client;
+    };
+
+    std::mutex                                   mutex;
+    std::unordered_map<hg_handle_t, charge>      charges;
+    std::unordered_map<std::string, std::size_t> client_bytes;
+    std::deque<deferred_rpc>                     queue;
+
+    bool accounted() const {
+        return max_bytes || max_client_bytes || max_deferred;
+    }
+
+    std::size_t capacity(int priority) const {
+        if(!by_priority || priority <= 0) return max_in_flight;
+        std::size_t c = max_in_flight / (1 + static_cast<std::size_t>(priority));
+        return c ? c : 1;
+    }
+
+    bool try_admit(int priority) {
+        std::size_t cap = capacity(priority);
+        std::size_t n   = in_flight.load(std::memory_order_relaxed);
+        do {
+            if(n >= cap) {
+                rejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while(!in_flight.compare_exchange_weak(n, n + 1, std::memory_order_acquire,
+                                                 std::memory_order_relaxed));
+        admitted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void release() {
+        in_flight.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Outcome of admit.
+     */
+    enum class verdict { admitted, deferred, rejected };
+
+    /**
+     * @brief Admits a request of an accounted limit, charging it its
+     * encoded input (and, with a per-client budget, the address of its
+     * sender), or defers or rejects it. Requests are deferred while
+     * others are queued, so that a large request is not overtaken
+     * forever by small ones. A request larger than a budget can never
+     * be admitted and is rejected.
+     */
+    verdict admit(margo_instance_id mid, hg_handle_t h, int priority, bool has_priority,
+                  std::uint64_t arrival) {
+        std::size_t bytes = max_bytes || max_client_bytes ? HG_Get_input_payload_size(h) : 0;
+        std::string client;
+        if(max_client_bytes) client = address_of(mid, h);
+        std::lock_guard<std::mutex> lock(mutex);
+        bool too_large = (max_bytes && bytes > max_bytes)
+                      || (max_client_bytes && bytes > max_client_bytes);
+        if(!too_large && queue.empty() && fits(priority, bytes, client)) {
+            take(h, bytes, client);
+            return verdict::admitted;
+        }
+        if(!too_large && queue.size() < max_deferred) {
+            queue.push_back(deferred_rpc{mid, h, priority, has_priority, bytes, std::move(client),
+                                          arrival});
+            deferred.fetch_add(1, std::memory_order_relaxed);
+            return verdict::deferred;
+        }
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return verdict::rejected;
+    }
+
+    /**
+     * @brief Adds bytes (pulled by its handler) to the charge of a
+     * request in flight. This never rejects the request, but counts
+     * against the requests admitted after it.
+     */
+    void add(hg_handle_t h, std::size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = charges.find(h);
+        if(it == charges.end()) return;
+        it->second.bytes += bytes;
+        bytes_in_flight.fetch_add(bytes, std::memory_order_relaxed);
+        if(max_client_bytes) client_bytes[it->second.client] += bytes;
+    }
+
+    /**
+     * @brief Releases what a request of an accounted limit was charged,
+     * and moves the deferred requests that now fit to ready, in order.
+     * They are charged, and must be dispatched by the caller.
+     */
+    void release(hg_handle_t h, std::vector<deferred_rpc>& ready) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = charges.find(h);
+        if(it == charges.end()) return;
+        bytes_in_flight.fetch_sub(it->second.bytes, std::memory_order_relaxed);
+        if(max_client_bytes) {
+            auto c = client_bytes.find(it->second.client);
+            if(c != client_bytes.end() && (c->second -= it->second.bytes) == 0)
+                client_bytes.erase(c);
+        }
+        charges.erase(it);
+        in_flight.fetch_sub(1, std::memory_order_release);
+        while(!queue.empty() && fits(queue.front().priority, queue.front().bytes,
+                                     queue.front().client)) {
+            auto& d = queue.front();
+            take(d.handle, d.bytes, d.client);
+            ready.push_back(std::move(d));
+            queue.pop_front();
+        }
+    }
+
+    /**
+     * @brief Destroys the deferred requests of a margo instance being
+     * finalized.
+     */
+    void drop_deferred(margo_instance_id mid) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(auto it = queue.begin(); it != queue.end();) {
+            if(it->mid != mid) {
+                ++it;
+                continue;
+            }
+            margo_destroy(it->handle);
+            it = queue.erase(it);
+        }
+    }
+
+  private:
+
+    bool fits(int priority, std::size_t bytes, const std::string& client) const {
+        if(in_flight.load(std::memory_order_relaxed) >= capacity(priority)) return false;
+        if(max_bytes && bytes_in_flight.load(std::memory_order_relaxed) + bytes > max_bytes)
+            return false;
+        if(max_client_bytes) {
+            auto it = client_bytes.find(client);
+            if(it != client_bytes.end() && it->second + bytes > max_client_bytes) return false;
+        }
+        return true;
+    }
+
+    void take(hg_handle_t h, std::size_t bytes, const std::string& client) {
+        in_flight.fetch_add(1, std::memory_order_acquire);
+        admitted.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_flight.fetch_add(bytes, std::memory_order_relaxed);
+        if(max_client_bytes) client_bytes[client] += bytes;
+        charges[h] = charge{bytes, client};
+    }
+
+    static std::string address_of(margo_instance_id mid, hg_handle_t h) {
+        const struct hg_info* info = margo_get_info(h);
+        if(!info) return std::string();
+        hg_size_t size = 0;
+        if(margo_addr_to_string(mid, nullptr, &size, info->addr) != HG_SUCCESS)
+            return std::string();
+        std::vector<char> buf(size);
+        if(margo_addr_to_string(mid, buf.data(), &size, info->addr) != HG_SUCCESS)
+            return std::string();
+        return std::string(buf.data());
+    }
+};
+
+/**
+ * @private
+ * @brief Makes a request of an accounted admission_limit the one the
+ * bulk transfers of the calling ULT are charged to, for the duration
+ * of its handler.
+ */
+class admission_charge_scope {
+
+    struct current {
+        admission_state* state;
+        hg_handle_t      handle;
+    };
+
+    current m_current;
+    void*   m_previous = nullptr;
+    bool    m_active   = false;
+
+    static ABT_key key() {
+        static ABT_key k = [] {
+            ABT_key k = ABT_KEY_NULL;
+            ABT_key_create(nullptr, &k);
+            return k;
+        }();
+        return k;
+    }
+
+  public:
+
+    admission_charge_scope(admission_state* state, hg_handle_t h)
+    : m_current{state, h} {
+        if(!state || !state->accounted()) return;
+        ABT_key_get(key(), &m_previous);
+        m_active = ABT_key_set(key(), &m_current) == ABT_SUCCESS;
+    }
+
+    admission_charge_scope(const admission_charge_scope&)            = delete;
+    admission_charge_scope& operator=(const admission_charge_scope&) = delete;
+
+    ~admission_charge_scope() {
+        if(m_active) ABT_key_set(key(), m_previous);
+    }
+
+    /**
+     * @brief Charges bytes pulled by the calling ULT to the request it
+     * is handling, if any.
+     */
+    static void add_pulled(std::size_t bytes) {
+        if(!admission_bytes_in_use().load(std::memory_order_relaxed)) return;
+        void* p = nullptr;
+        if(ABT_key_get(key(), &p) != ABT_SUCCESS || !p) return;
+        auto c = static_cast<current*>(p);
+        c->state->add(c->handle, bytes);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief An admission_limit bounds the number of requests of one or
+ * more RPCs that are in flight on a server, i.e. whose handler has been
+ * created (queued in its pool or running) but has not returned yet. An
+ * RPC arriving when the limit is reached is not turned into a ULT: the
+ * server immediately responds with a busy status, which the client
+ * sees as a tl::busy exception, instead of letting the pool grow
+ * without bound. RPCs with disabled responses are dropped.
+ *
+ * The same admission_limit can be given to several RPCs (e.g. all
+ * the RPCs sharing a handler pool), which then share the budget.
+ *
+ * With the shed_by_priority policy, requests of priority p (see
+ * remote_procedure::set_priority, 0 being the highest) are only
+ * admitted while fewer than max_in_flight/(1+p) requests are in
+ * flight, so that lower priorities are rejected first as the load
+ * grows.
+ *
+ * A count does not bound memory when a few clients send very large
+ * arguments, so a limit can also have byte budgets: a request is charged
+ * the size of its encoded input when it arrives, plus the bytes its
+ * handler pulls through remote_bulk (including large<T> arguments)
+ * until it returns, and is only admitted while the bytes in flight,
+ * in total (set_max_bytes) and from its sender (set_max_bytes_per_client),
+ * stay within the budgets. With defer_up_to, requests that do not fit
+ * wait in a bounded queue, in arrival order, and get their ULT when
+ * enough bytes are released, instead of being rejected; a deferred
+ * request keeps its input buffer, so the queue should be short.
+ *
+ * \code{.cpp}
+ * tl::admission_limit limit(1024);
+ * limit.set_max_bytes(1ULL << 30).set_max_bytes_per_client(64ULL << 20);
+ * engine.define("put", put_handler).set_admission(limit);
+ * engine.define("get", get_handler).set_admission(limit);
+ * // client
+ * try { rpc.on(ep)(args); } catch(const tl::busy&) { ... retry later ... }
+ * \endcode
+ */
+class admission_limit {
+
+  public:
+
+    enum class policy {
+        reject,          /*!< reject any request above the limit */
+        shed_by_priority /*!< lower priorities get a smaller share */
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param max_in_flight Maximum number of requests in flight.
+     * @param p Policy.
+     */
+    explicit admission_limit(std::size_t max_in_flight, policy p = policy::reject)
+    : m_state(std::make_shared<detail::admission_state>()) {
+        m_state->max_in_flight = max_in_flight;
+        m_state->by_priority   = p == policy::shed_by_priority;
+    }
+
+    /**
+     * @brief Creates a limit on the bytes in flight only.
+     *
+     * @param max_bytes Maximum number of bytes in flight.
+     * @param max_bytes_per_client Maximum number of bytes in flight
+     * from a single sender (0 for no per-client budget).
+     */
+    static admission_limit by_bytes(std::size_t max_bytes,
+                                    std::size_t max_bytes_per_client = 0) {
+        admission_limit limit(static_cast<std::size_t>(-1));
+        limit.set_max_bytes(max_bytes).set_max_bytes_per_client(max_bytes_per_client);
+        return limit;
+    }
+
+    /**
+     * @brief Sets the maximum number of bytes (encoded inputs and bulk
+     * data pulled by the handlers) in flight, 0 for no budget. Budgets
+     * must be set before the limit is given to an RPC.
+     */
+    admission_limit& set_max_bytes(std::size_t bytes) {
+        m_state->max_bytes = bytes;
+        if(bytes) detail::admission_bytes_in_use() = true;
+        return *this;
+    }
+
+    /**
+     * @brief Sets the maximum number of bytes in flight from a single
+     * sender address, 0 for no budget. Finding the address of the
+     * sender costs a string conversion per request.
+     */
+    admission_limit& set_max_bytes_per_client(std::size_t bytes) {
+        m_state->max_client_bytes = bytes;
+        if(bytes) detail::admission_bytes_in_use() = true;
+        return *this;
+    }
+
+    /**
+     * @brief Defers up to max_deferred requests over the limit in a
+     * queue, instead of rejecting them. 0 (the default) rejects them.
+     */
+    admission_limit& defer_up_to(std::size_t max_deferred) {
+        m_state->max_deferred = max_deferred;
+        return *this;
+    }
+
+    /**
+     * @brief Returns the number of bytes currently charged to the
+     * requests in flight.
+     */
+    std::size_t bytes_in_flight() const {
+        return m_state->bytes_in_flight.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the maximum number of bytes in flight (0 if none).
+     */
+    std::size_t max_bytes() const {
+        return m_state->max_bytes;
+    }
+
+    /**
+     * @brief Returns the number of requests deferred so far.
+     */
+    std::uint64_t deferred() const {
+        return m_state->deferred.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the number of requests currently in flight.
+     */
+    std::size_t in_flight() const {
+        return m_state->in_flight.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the maximum number of requests in flight.
+     */
+    std::size_t max_in_flight() const {
+        return m_state->max_in_flight;
+    }
+
+    /**
+     * @brief Returns the number of requests admitted so far.
+     */
+    std::uint64_t admitted() const {
+        return m_state->admitted.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the number of requests rejected so far.
+     */
+    std::uint64_t rejected() const {
+        return m_state->rejected.load(std::memory_order_relaxed);
+    }
+
+  private:
+
+    friend class remote_procedure;
+
+    std::shared_ptr<detail::admission_state> m_state;
+};
+
+/**
+ * @brief Admission gauges of an RPC, part of rpc_stats.
+ */
+struct rpc_admission_entry {
+    hg_id_t       id              = 0;
+    std::size_t   in_flight       = 0;
+    std::size_t   max_in_flight   = 0;
+    std::uint64_t admitted        = 0;
+    std::uint64_t rejected        = 0;
+    std::size_t   bytes_in_flight = 0; /*!< bytes charged to the requests in flight */
+    std::size_t   max_bytes       = 0; /*!< byte budget (0 if none) */
+    std::uint64_t deferred        = 0; /*!< requests deferred so far */
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Admission limits set with remote_procedure::set_admission, by
+ * RPC id, for each margo instance. They are checked by
+ * thallium_rpc_handler before creating the handler's ULT, and released
+ * by thallium_generic_rpc when the handler returns; requests reach the
+ * limit of their RPC through its rpc_policy.
+ */
+class rpc_admission_registry : public per_instance<rpc_admission_registry> {
+
+    std::mutex                                                   m_mutex;
+    std::unordered_map<hg_id_t, std::shared_ptr<admission_state>> m_limits;
+    // replaced limits may still be released by running handlers, so
+    // they are kept until the margo instance is finalized
+    std::vector<std::shared_ptr<admission_state>>                m_replaced;
+
+    static void on_finalize(void* arg) {
+        auto mid = static_cast<margo_instance_id>(arg);
+        auto reg = uninstall(mid);
+        if(!reg) return;
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        for(auto& p : reg->m_limits) p.second->drop_deferred(mid);
+        for(auto& s : reg->m_replaced) s->drop_deferred(mid);
+    }
+
+  public:
+
+    /**
+     * @brief Sets (or removes, if state is null) the admission limit
+     * of an RPC of a margo instance. Returns state.
+     */
+    static admission_state* set(margo_instance_id mid, hg_id_t id,
+                                std::shared_ptr<admission_state> state) {
+        bool created = false;
+        auto reg     = find_or_install(
+            mid, []() { return std::make_shared<rpc_admission_registry>(); }, created);
+        // finalize rather than prefinalize: handlers still
+        // running release their admission when they return
+        if(created)
+            margo_provider_push_finalize_callback(
+                mid, reg.get(), &rpc_admission_registry::on_finalize, mid);
+        admission_state* raw = state.get();
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        auto it = reg->m_limits.find(id);
+        if(it != reg->m_limits.end()) {
+            if(it->second != state) reg->m_replaced.push_back(std::move(it->second));
+            reg->m_limits.erase(it);
+        }
+        if(state) reg->m_limits[id] = std::move(state);
+        return raw;
+    }
+
+    /**
+     * @brief Returns the gauges of all the RPCs with an admission limit.
+     */
+    static std::vector<rpc_admission_entry> snapshot(margo_instance_id mid) {
+        std::vector<rpc_admission_entry> entries;
+        auto reg = find(mid);
+        if(!reg) return entries;
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        for(auto& p : reg->m_limits) {
+            rpc_admission_entry e;
+            e.id            = p.first;
+            e.in_flight     = p.second->in_flight.load(std::memory_order_relaxed);
+            e.max_in_flight = p.second->max_in_flight;
+            e.admitted      = p.second->admitted.load(std::memory_order_relaxed);
+            e.rejected      = p.second->rejected.load(std::memory_order_relaxed);
+            e.bytes_in_flight = p.second->bytes_in_flight.load(std::memory_order_relaxed);
+            e.max_bytes       = p.second->max_bytes;
+            e.deferred        = p.second->deferred.load(std::memory_order_relaxed);
+            entries.push_back(e);
+        }
+        return entries;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
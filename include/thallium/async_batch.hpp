@@ -0,0 +1,160 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_ASYNC_BATCH_HPP
+#define __THALLIUM_ASYNC_BATCH_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <thallium/async_response.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/margo_exception.hpp>
+#include <thallium/packed_data.hpp>
+#include <thallium/timeout.hpp>
+
+namespace thallium {
+
+class remote_procedure;
+
+/**
+ * @brief An async_batch is a set of RPCs issued together, for instance
+ * by remote_procedure::forward_batch. It allows waiting for all of them,
+ * or for them one at a time in completion order.
+ *
+ * The async_response objects and margo_request handles are kept in
+ * contiguous arrays allocated once when the batch is created. wait_all
+ * processes the responses in the order they arrive (see
+ * async_response::wait_all).
+ */
+class async_batch {
+    friend class remote_procedure;
+
+  private:
+    std::vector<async_response> m_responses;
+    std::vector<std::size_t>    m_pending;  // indices of responses not yet completed
+    std::vector<margo_request>  m_requests; // scratch array for margo_wait_any
+
+    void reserve(std::size_t n) {
+        m_responses.reserve(n);
+        m_pending.reserve(n);
+        m_requests.reserve(n);
+    }
+
+  public:
+
+    /**
+     * @brief Creates an empty batch.
+     */
+    async_batch() = default;
+
+    async_batch(const async_batch&)            = delete;
+    async_batch& operator=(const async_batch&) = delete;
+    async_batch(async_batch&&)                 = default;
+    async_batch& operator=(async_batch&&)      = default;
+
+    /**
+     * @brief Destructor. Any RPC still pending is waited on
+     * by the destructor of its async_response.
+     */
+    ~async_batch() = default;
+
+    /**
+     * @brief Adds an async_response to the batch.
+     */
+    void push_back(async_response&& response) {
+        m_pending.push_back(m_responses.size());
+        m_responses.push_back(std::move(response));
+    }
+
+    /**
+     * @brief Returns the number of RPCs in the batch.
+     */
+    std::size_t size() const {
+        return m_responses.size();
+    }
+
+    /**
+     * @brief Returns the number of RPCs that have not yet been
+     * returned by wait_any.
+     */
+    std::size_t pending() const {
+        return m_pending.size();
+    }
+
+    /**
+     * @brief Returns true if every RPC of the batch has been
+     * returned by wait_any.
+     */
+    bool done() const {
+        return m_pending.empty();
+    }
+
+    /**
+     * @brief Access the i-th async_response, in submission order.
+     */
+    async_response& operator[](std::size_t i) {
+        return m_responses[i];
+    }
+
+    /**
+     * @brief Waits for all the RPCs of the batch and returns their
+     * responses in submission order. RPCs with disabled responses
+     * produce an empty packed_data.
+     */
+    std::vector<packed_data<>> wait_all() {
+        m_pending.clear();
+        return async_response::wait_all(m_responses.begin(), m_responses.end());
+    }
+
+    /**
+     * @brief Waits for any of the pending RPCs to complete and returns
+     * its index in submission order along with its response. If the
+     * RPC timed out, the RPC is removed from the pending set and a
+     * timeout exception is thrown.
+     */
+    std::pair<std::size_t, packed_data<>> wait_any() {
+        if(m_pending.empty())
+            throw exception("Calling wait_any on an async_batch with no pending RPC");
+        m_requests.clear();
+        for(auto i : m_pending) m_requests.push_back(m_responses[i].m_request);
+        while(true) {
+            size_t      pos = 0;
+            hg_return_t ret = margo_wait_any(m_requests.size(), m_requests.data(), &pos);
+            if(pos >= m_pending.size()) {
+                MARGO_ASSERT(ret, margo_wait_any);
+                throw exception("margo_wait_any returned an invalid index");
+            }
+            std::size_t index    = m_pending[pos];
+            auto&       response = m_responses[index];
+            // margo_wait_any has already completed and released the request,
+            // unless it was sent again by its retry_policy
+            if(!response.mark_completed(ret)) {
+                m_requests[pos] = response.m_request;
+                continue;
+            }
+            m_pending.erase(m_pending.begin() + pos);
+            return std::make_pair(index, response.completed_response(ret));
+        }
+    }
+
+    /**
+     * @brief Calls f(index, response) for each pending RPC of the
+     * batch, in completion order.
+     *
+     * @tparam F Type of callable.
+     * @param f Callable taking a std::size_t and a packed_data<>&.
+     */
+    template <typename F> void for_each_completed(F&& f) {
+        while(!m_pending.empty()) {
+            auto p = wait_any();
+            f(p.first, p.second);
+        }
+    }
+};
+
+} // namespace thallium
+
+#endif
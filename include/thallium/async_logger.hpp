@@ -0,0 +1,330 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_ASYNC_LOGGER_HPP
+#define __THALLIUM_ASYNC_LOGGER_HPP
+
+#include <abt.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/engine.hpp>
+#include <thallium/logger.hpp>
+#include <thallium/pool.hpp>
+
+/**
+ * Lowest level (as a margo_log_level value) for which
+ * async_logger::log<L> formats messages. Calls for lower levels
+ * compile to nothing.
+ */
+#ifndef THALLIUM_LOG_MIN_LEVEL
+#define THALLIUM_LOG_MIN_LEVEL 0
+#endif
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Single-producer single-consumer ring of log records. Records
+ * are an 8-byte header (size and level) followed by the message,
+ * padded to 8 bytes; a header with size wrap_marker means the rest of
+ * the buffer is unused and the next record starts at its beginning.
+ */
+class log_ring {
+
+    static constexpr std::uint32_t wrap_marker = 0xffffffffu;
+
+    struct header {
+        std::uint32_t size;
+        std::int32_t  level;
+    };
+
+    std::unique_ptr<char[]> m_buffer;
+    std::size_t             m_capacity;
+    alignas(64) std::atomic<std::uint64_t> m_head{0}; // written by the producer
+    alignas(64) std::atomic<std::uint64_t> m_tail{0}; // written by the consumer
+
+    static std::size_t padded(std::size_t n) { return (n + 7) & ~std::size_t(7); }
+
+  public:
+
+    explicit log_ring(std::size_t capacity) {
+        std::size_t c = 64;
+        while(c < capacity) c <<= 1;
+        m_capacity = c;
+        m_buffer.reset(new char[c]);
+    }
+
+    /**
+     * @brief Appends a record, or returns false if the ring is full.
+     * Messages longer than a quarter of the ring are truncated.
+     */
+    bool push(int level, const char* msg, std::size_t len) {
+        len = std::min(len, m_capacity / 4 - sizeof(header));
+        std::size_t   need   = sizeof(header) + padded(len);
+        std::uint64_t head   = m_head.load(std::memory_order_relaxed);
+        std::uint64_t tail   = m_tail.load(std::memory_order_acquire);
+        std::size_t   offset = static_cast<std::size_t>(head & (m_capacity - 1));
+        std::size_t   pad    = offset + need > m_capacity ? m_capacity - offset : 0;
+        if(m_capacity - (head - tail) < pad + need) return false;
+        if(pad) {
+            header h{wrap_marker, 0};
+            std::memcpy(m_buffer.get() + offset, &h, sizeof(h));
+            head  += pad;
+            offset = 0;
+        }
+        header h{static_cast<std::uint32_t>(len), level};
+        std::memcpy(m_buffer.get() + offset, &h, sizeof(h));
+        std::memcpy(m_buffer.get() + offset + sizeof(h), msg, len);
+        m_head.store(head + need, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Calls f(level, msg, len) on each record and removes them.
+     */
+    template <typename F> void drain(F&& f) {
+        std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        std::uint64_t head = m_head.load(std::memory_order_acquire);
+        while(tail < head) {
+            std::size_t offset = static_cast<std::size_t>(tail & (m_capacity - 1));
+            header      h;
+            std::memcpy(&h, m_buffer.get() + offset, sizeof(h));
+            if(h.size == wrap_marker) {
+                tail += m_capacity - offset;
+                continue;
+            }
+            f(h.level, m_buffer.get() + offset + sizeof(h), static_cast<std::size_t>(h.size));
+            tail += sizeof(h) + padded(h.size);
+        }
+        m_tail.store(tail, std::memory_order_release);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Logger that doesn't block the ULTs (or the progress loop)
+ * logging messages: each execution stream appends its messages to its
+ * own lock-free ring buffer, and a ULT periodically drains the rings
+ * and hands the formatted lines to the sink in batches. Messages
+ * logged while a ring is full are dropped (and counted) rather than
+ * waited for.
+ *
+ * log<L>(fmt, ...) formats messages directly, skipping the formatting
+ * entirely when L is below the logger's level, or below
+ * THALLIUM_LOG_MIN_LEVEL at compile time.
+ *
+ * \code{.cpp}
+ * tl::async_logger logger(engine);
+ * engine.set_logger(&logger);
+ * logger.log<tl::logger::level::debug>("lookup %s took %d us", key, us);
+ * \endcode
+ *
+ * The logger must outlive its use by the engine; it stops draining (and
+ * flushes) when the engine is finalized.
+ */
+class async_logger : public logger {
+
+  public:
+
+    /**
+     * @brief Parameters of an async_logger.
+     */
+    struct options {
+        std::size_t ring_size         = 64 * 1024; /*!< bytes per execution stream */
+        double      flush_interval_ms = 10.0;      /*!< time between drains */
+        logger::level level           = logger::level::trace; /*!< level of log<L> */
+        pool        drain_pool;  /*!< pool of the draining ULT (default: handler pool) */
+        std::function<void(const char*, std::size_t)> sink; /*!< output (default: stderr) */
+    };
+
+    /**
+     * @brief Constructor. Starts the ULT draining the rings.
+     *
+     * @param e Engine whose progress loop times the drains.
+     * @param opts Options.
+     */
+    async_logger(const engine& e, options opts)
+    : m_mid(e.get_margo_instance())
+    , m_id(next_id())
+    , m_ring_size(opts.ring_size)
+    , m_interval_ms(opts.flush_interval_ms)
+    , m_sink(std::move(opts.sink))
+    , m_level(static_cast<int>(opts.level)) {
+        if(!m_sink) {
+            m_sink = [](const char* data, std::size_t size) {
+                std::fwrite(data, 1, size, stderr);
+                std::fflush(stderr);
+            };
+        }
+        pool p = opts.drain_pool.is_null() ? e.get_handler_pool() : opts.drain_pool;
+        m_drainer = p.make_thread([this]() { drain_loop(); });
+        margo_provider_push_prefinalize_callback(m_mid, this, &async_logger::on_finalize, this);
+    }
+
+    /**
+     * @brief Constructor with the default options.
+     */
+    explicit async_logger(const engine& e)
+    : async_logger(e, options()) {}
+
+    async_logger(const async_logger&)            = delete;
+    async_logger& operator=(const async_logger&) = delete;
+
+    ~async_logger() {
+        if(stop()) margo_provider_pop_prefinalize_callback(m_mid, this);
+        // messages logged after the engine was finalized
+        flush();
+    }
+
+    /**
+     * @brief Formats a message with printf-style arguments and logs it,
+     * unless L is filtered out.
+     */
+    template <logger::level L, typename... Args>
+    void log(const char* fmt, Args&&... args) const {
+        if(static_cast<int>(L) < THALLIUM_LOG_MIN_LEVEL) return;
+        if(static_cast<int>(L) < m_level.load(std::memory_order_relaxed)) return;
+        char buf[512];
+        int  n = std::snprintf(buf, sizeof(buf), fmt, std::forward<Args>(args)...);
+        if(n < 0) return;
+        push(static_cast<int>(L), buf, std::min<std::size_t>(n, sizeof(buf) - 1));
+    }
+
+    /**
+     * @brief Changes the level below which log<L> doesn't format messages.
+     */
+    void set_level(logger::level l) { m_level.store(static_cast<int>(l)); }
+
+    /**
+     * @brief Writes the messages logged so far to the sink.
+     */
+    void flush() const {
+        std::lock_guard<std::mutex> lock(m_drain_mutex);
+        std::string batch;
+        std::vector<std::shared_ptr<detail::log_ring>> rings;
+        {
+            std::lock_guard<std::mutex> rlock(m_rings_mutex);
+            rings = m_rings;
+        }
+        for(auto& r : rings) {
+            r->drain([&batch](int level, const char* msg, std::size_t len) {
+                batch += '[';
+                batch += level_name(level);
+                batch += "] ";
+                batch.append(msg, len);
+                batch += '\n';
+            });
+        }
+        if(!batch.empty()) m_sink(batch.data(), batch.size());
+    }
+
+    /**
+     * @brief Returns the number of messages dropped because a ring was full.
+     */
+    std::uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    void trace(const char* msg) const override { push(MARGO_LOG_TRACE, msg); }
+    void debug(const char* msg) const override { push(MARGO_LOG_DEBUG, msg); }
+    void info(const char* msg) const override { push(MARGO_LOG_INFO, msg); }
+    void warning(const char* msg) const override { push(MARGO_LOG_WARNING, msg); }
+    void error(const char* msg) const override { push(MARGO_LOG_ERROR, msg); }
+    void critical(const char* msg) const override { push(MARGO_LOG_CRITICAL, msg); }
+
+  private:
+
+    margo_instance_id                                        m_mid;
+    std::uint64_t                                            m_id;
+    std::size_t                                              m_ring_size;
+    double                                                   m_interval_ms;
+    std::function<void(const char*, std::size_t)>            m_sink;
+    std::atomic<int>                                         m_level;
+    mutable std::atomic<std::uint64_t>                       m_dropped{0};
+    mutable std::mutex                                       m_rings_mutex;
+    mutable std::vector<std::shared_ptr<detail::log_ring>>   m_rings;
+    mutable std::mutex                                       m_drain_mutex;
+    std::atomic<bool>                                        m_stop{false};
+    managed<thread>                                          m_drainer;
+
+    static std::uint64_t next_id() {
+        static std::atomic<std::uint64_t> id{1};
+        return id.fetch_add(1);
+    }
+
+    static const char* level_name(int level) {
+        switch(level) {
+            case MARGO_LOG_TRACE:    return "trace";
+            case MARGO_LOG_DEBUG:    return "debug";
+            case MARGO_LOG_INFO:     return "info";
+            case MARGO_LOG_WARNING:  return "warning";
+            case MARGO_LOG_ERROR:    return "error";
+            case MARGO_LOG_CRITICAL: return "critical";
+            default:                 return "external";
+        }
+    }
+
+    // ring of the calling OS thread (i.e. execution stream), created on
+    // its first message and found through a thread-local list of the
+    // rings it has, by logger
+    detail::log_ring* local_ring() const {
+        static thread_local std::vector<std::pair<std::uint64_t, detail::log_ring*>> local;
+        for(auto& p : local)
+            if(p.first == m_id) return p.second;
+        auto r = std::make_shared<detail::log_ring>(m_ring_size);
+        {
+            std::lock_guard<std::mutex> lock(m_rings_mutex);
+            m_rings.push_back(r);
+        }
+        local.emplace_back(m_id, r.get());
+        return r.get();
+    }
+
+    void push(int level, const char* msg) const {
+        push(level, msg, std::strlen(msg));
+    }
+
+    void push(int level, const char* msg, std::size_t len) const {
+        if(!local_ring()->push(level, msg, len))
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void drain_loop() {
+        while(!m_stop.load(std::memory_order_acquire)) {
+            margo_thread_sleep(m_mid, m_interval_ms);
+            flush();
+        }
+    }
+
+    // stops the draining ULT and flushes; returns false if already stopped
+    bool stop() {
+        if(m_stop.exchange(true)) return false;
+        m_drainer->join();
+        m_drainer.release();
+        flush();
+        return true;
+    }
+
+    static void on_finalize(void* arg) {
+        static_cast<async_logger*>(arg)->stop();
+    }
+};
+
+} // namespace thallium
+
+#endif
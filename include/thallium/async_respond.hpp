@@ -0,0 +1,151 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_ASYNC_RESPOND_HPP
+#define __THALLIUM_ASYNC_RESPOND_HPP
+
+#include <utility>
+#include <abt.h>
+#include <margo.h>
+#include <thallium/margo_exception.hpp>
+#include <thallium/unit_allocator.hpp>
+
+namespace thallium {
+
+template<typename... CtxArg> class request_with_context;
+
+/**
+ * @brief async_respond objects are returned by request::irespond and
+ * track a response being sent. The response has already been
+ * serialized when irespond returns, so the handler can release its
+ * resources and only wait (or not) for the response to be sent.
+ * If it has not been waited on, the destructor waits for it.
+ */
+class async_respond {
+
+    template<typename... CtxArg> friend class request_with_context;
+
+  private:
+
+    hg_handle_t   m_handle  = HG_HANDLE_NULL;
+    margo_request m_request = MARGO_REQUEST_NULL;
+
+    async_respond(hg_handle_t handle, margo_request req)
+    : m_handle(handle)
+    , m_request(req) {
+        margo_ref_incr(m_handle);
+    }
+
+  public:
+
+    async_respond() = default;
+
+    async_respond(const async_respond&)            = delete;
+    async_respond& operator=(const async_respond&) = delete;
+
+    async_respond(async_respond&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, HG_HANDLE_NULL))
+    , m_request(std::exchange(other.m_request, MARGO_REQUEST_NULL)) {}
+
+    async_respond& operator=(async_respond&& other) {
+        if(&other == this) return *this;
+        release();
+        m_handle  = std::exchange(other.m_handle, HG_HANDLE_NULL);
+        m_request = std::exchange(other.m_request, MARGO_REQUEST_NULL);
+        return *this;
+    }
+
+    /**
+     * @brief Destructor. Waits for the response to be sent, if needed.
+     */
+    ~async_respond() {
+        release();
+    }
+
+    /**
+     * @brief Returns true if the response has been sent.
+     */
+    bool test() const {
+        if(m_request == MARGO_REQUEST_NULL)
+            return true;
+        int flag;
+        int ret = margo_test(m_request, &flag);
+        MARGO_ASSERT((hg_return_t)ret, margo_test);
+        return flag != 0;
+    }
+
+    /**
+     * @brief Waits for the response to be sent.
+     */
+    void wait() {
+        if(m_request == MARGO_REQUEST_NULL)
+            return;
+        // margo_wait frees the request, even on failure
+        hg_return_t ret = margo_wait(std::exchange(m_request, MARGO_REQUEST_NULL));
+        MARGO_ASSERT(ret, margo_wait);
+    }
+
+  private:
+
+    void release() {
+        if(m_request != MARGO_REQUEST_NULL) {
+            hg_return_t ret = margo_wait(std::exchange(m_request, MARGO_REQUEST_NULL));
+            MARGO_ASSERT_TERMINATE(ret, margo_wait);
+        }
+        if(m_handle != HG_HANDLE_NULL) {
+            hg_return_t ret = margo_destroy(std::exchange(m_handle, HG_HANDLE_NULL));
+            MARGO_ASSERT_TERMINATE(ret, margo_destroy);
+        }
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Response posted by respond_detached, and the reference on its
+ * handle kept until it is sent.
+ */
+struct detached_response {
+    hg_handle_t   handle;
+    margo_request request;
+};
+
+inline void wait_detached_response(void* arg) {
+    auto* r = static_cast<detached_response*>(arg);
+    margo_wait(r->request);
+    margo_destroy(r->handle);
+    pooled_unit_allocator<detached_response>().deallocate(r, 1);
+}
+
+/**
+ * @private
+ * @brief Posts a response with margo_irespond without waiting for it.
+ * A ULT created in the progress pool waits for the request and
+ * releases the handle; errors happening after the response was posted
+ * are ignored. Does not block, so it can be called from tasklets and
+ * from the progress loop.
+ */
+inline hg_return_t respond_detached(hg_handle_t handle, void* out) {
+    margo_request req = MARGO_REQUEST_NULL;
+    hg_return_t   ret = margo_irespond(handle, out, &req);
+    if(ret != HG_SUCCESS) return ret;
+    margo_ref_incr(handle);
+    auto* r = pooled_unit_allocator<detached_response>().allocate(1);
+    *r      = detached_response{handle, req};
+    ABT_pool pool = ABT_POOL_NULL;
+    margo_get_progress_pool(margo_hg_handle_get_instance(handle), &pool);
+    if(pool == ABT_POOL_NULL
+    || ABT_thread_create(pool, wait_detached_response, r, ABT_THREAD_ATTR_NULL, nullptr)
+       != ABT_SUCCESS)
+        wait_detached_response(r);
+    return HG_SUCCESS;
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -6,11 +6,23 @@
 #ifndef __THALLIUM_ASYNC_RESPONSE_HPP
 #define __THALLIUM_ASYNC_RESPONSE_HPP
 
+#include <thallium/busy.hpp>
+#include <thallium/cancellation.hpp>
+#include <thallium/expected.hpp>
+#include <thallium/flow_control.hpp>
 #include <thallium/margo_instance_ref.hpp>
 #include <thallium/margo_exception.hpp>
+#include <thallium/non_blocking.hpp>
 #include <thallium/packed_data.hpp>
+#include <thallium/peer_monitor.hpp>
 #include <thallium/proc_object.hpp>
+#include <thallium/resume.hpp>
+#include <thallium/rpc_stats.hpp>
 #include <thallium/timeout.hpp>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
 #include <utility>
 #include <vector>
 
@@ -19,6 +31,27 @@ namespace thallium {
 
 template<typename ... CtxArg> class callable_remote_procedure_with_context;
 using callable_remote_procedure = callable_remote_procedure_with_context<>;
+class pool;
+template <typename T> class eventual;
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Throws the exception corresponding to the error code of an
+ * RPC: tl::cancelled if it was cancelled by the caller, tl::timeout,
+ * tl::busy, tl::peer_failure, or a margo_exception.
+ */
+[[noreturn]] inline void throw_rpc_error(hg_return_t ret, bool cancelled_by_caller,
+                                         const char* function) {
+    if(ret == HG_CANCELED && cancelled_by_caller) throw cancelled();
+    if(ret == HG_TIMEOUT) throw timeout();
+    if(ret == HG_BUSY) throw busy();
+    if(ret == HG_HOSTUNREACH) throw peer_failure();
+    throw margo_exception(function, __FILE__, __LINE__, ret, translate_margo_error_code(ret));
+}
+
+} // namespace detail
 
 /**
  * @brief async_response objects are created by sending an
@@ -27,12 +60,130 @@ using callable_remote_procedure = callable_remote_procedure_with_context<>;
  */
 class async_response {
     template<typename ... CtxArg> friend class callable_remote_procedure_with_context;
+    friend class async_batch;
 
   private:
     margo_instance_ref m_mid;
     margo_request      m_request = MARGO_REQUEST_NULL;
     hg_handle_t        m_handle  = HG_HANDLE_NULL;
     bool               m_ignore_response = false;
+    // set if the RPC was sent with a concurrency_limiter or retry_policy
+    std::shared_ptr<detail::flow_call> m_flow;
+    // token sent with the RPC if its cancellation reaches the server
+    std::uint64_t      m_token     = 0;
+    std::atomic<bool>  m_cancelled{false};
+    // pool in which wait() resumes the waiting ULT, if any
+    ABT_pool           m_resume_pool = ABT_POOL_NULL;
+    // set if the RPC was sent to a peer watched by a failure_detector
+    std::shared_ptr<detail::peer_call> m_peer;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    std::shared_ptr<detail::rpc_metrics> m_stats;
+    std::uint64_t                        m_stats_start = 0;
+    // client-side span of the RPC, if it is traced
+    detail::span_start                   m_span;
+
+    void record_round_trip() {
+        if(m_stats) {
+            m_stats->record(detail::rpc_metric::round_trip,
+                            detail::rpc_stats_now() - m_stats_start);
+            m_stats.reset();
+        }
+        m_span.finish(m_mid);
+    }
+#endif
+
+    /**
+     * @brief Same as wait() but does not throw tl::cancelled (used when
+     * the response is dropped).
+     */
+    void wait_cancelled() {
+        try {
+            wait();
+        } catch(const cancelled&) {}
+    }
+
+    /**
+     * @brief Called when margo_wait_any completed the request: releases
+     * its concurrency_limiter slot and, if its retry_policy asks for it,
+     * sends the RPC again, in which case the new request is in m_request
+     * and false is returned.
+     */
+    bool mark_completed(hg_return_t& ret) {
+        m_request = MARGO_REQUEST_NULL;
+        if(m_flow) {
+            // a cancelled RPC is not sent again
+            if(m_cancelled || detail::peer_monitor::failed(m_peer))
+                m_flow->has_payload = false;
+            if(m_flow->completed(ret, ret == HG_SUCCESS && !m_ignore_response
+                                      && detail::is_busy_response(m_handle),
+                                 m_handle, &m_request))
+                return false;
+            m_flow.reset();
+        }
+        detail::peer_monitor::release(m_peer, ret);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        record_round_trip();
+#endif
+        return true;
+    }
+
+    /**
+     * @brief Returns the response of a request that margo_wait_any
+     * completed with status ret, or throws the corresponding exception.
+     */
+    packed_data<> completed_response(hg_return_t ret) {
+        if(ret == HG_CANCELED && m_cancelled)
+            throw cancelled();
+        if(ret == HG_TIMEOUT)
+            throw timeout();
+        if(ret == HG_HOSTUNREACH)
+            throw peer_failure();
+        MARGO_ASSERT(ret, margo_wait_any);
+        if(m_ignore_response)
+            return packed_data<>();
+        if(detail::is_busy_response(m_handle))
+            throw busy();
+        return packed_data<>(margo_get_output, margo_free_output, m_handle, m_mid);
+    }
+
+    /**
+     * @brief Waits for the pending requests of [begin, end) and calls
+     * fn(it, index, ret) on each of them in the order they complete,
+     * until fn returns false. The requests are copied once into a single
+     * array passed to every call to margo_wait_any, in which completed
+     * requests are replaced by MARGO_REQUEST_NULL (which margo_wait_any
+     * skips), and retried ones by their new request.
+     */
+    template <typename Iterator, typename F>
+    static void wait_each(const Iterator& begin, const Iterator& end, F&& fn) {
+        std::vector<margo_request> reqs;
+        reqs.reserve(std::distance(begin, end));
+        std::size_t pending = 0;
+        for(auto it = begin; it != end; it++) {
+            if(it->m_handle == HG_HANDLE_NULL)
+                throw exception("Calling wait on an invalid async_response");
+            reqs.push_back(it->m_request);
+            if(it->m_request != MARGO_REQUEST_NULL) pending += 1;
+        }
+        while(pending) {
+            size_t      index = reqs.size();
+            hg_return_t ret   = margo_wait_any(reqs.size(), reqs.data(), &index);
+            if(index >= reqs.size()) {
+                MARGO_ASSERT(ret, margo_wait_any);
+                throw exception("margo_wait_any returned an invalid index");
+            }
+            auto it = begin;
+            std::advance(it, index);
+            // the request has been completed and released by margo_wait_any
+            if(!it->mark_completed(ret)) {
+                reqs[index] = it->m_request;
+                continue;
+            }
+            reqs[index] = MARGO_REQUEST_NULL;
+            pending -= 1;
+            if(!fn(it, static_cast<std::size_t>(index), ret)) return;
+        }
+    }
 
     /**
      * @brief Constructor. Made private since async_response
@@ -70,7 +221,18 @@ class async_response {
     : m_mid(std::move(other.m_mid))
     , m_request{std::exchange(other.m_request, MARGO_REQUEST_NULL)}
     , m_handle{std::exchange(other.m_handle, HG_HANDLE_NULL)}
-    , m_ignore_response(other.m_ignore_response) {}
+    , m_ignore_response(other.m_ignore_response)
+    , m_flow(std::move(other.m_flow))
+    , m_token(other.m_token)
+    , m_cancelled(other.m_cancelled.load())
+    , m_resume_pool(other.m_resume_pool)
+    , m_peer(std::move(other.m_peer))
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    , m_stats(std::move(other.m_stats))
+    , m_stats_start(other.m_stats_start)
+    , m_span(std::exchange(other.m_span, detail::span_start()))
+#endif
+    {}
 
     /**
      * @brief Copy-assignment operator is deleted.
@@ -83,13 +245,23 @@ class async_response {
     async_response& operator=(async_response&& other) {
         if(&other == this || m_request == other.m_request) return *this;
         if(m_request != MARGO_REQUEST_NULL)
-            wait();
+            wait_cancelled();
         if(m_handle != HG_HANDLE_NULL)
             margo_destroy(m_handle);
         m_mid             = std::move(other.m_mid);
         m_request         = std::exchange(other.m_request, MARGO_REQUEST_NULL);
         m_handle          = std::exchange(other.m_handle, HG_HANDLE_NULL);
         m_ignore_response = other.m_ignore_response;
+        m_flow            = std::move(other.m_flow);
+        m_token           = other.m_token;
+        m_cancelled       = other.m_cancelled.load();
+        m_resume_pool     = other.m_resume_pool;
+        m_peer            = std::move(other.m_peer);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        m_stats           = std::move(other.m_stats);
+        m_stats_start     = other.m_stats_start;
+        m_span            = std::exchange(other.m_span, detail::span_start());
+#endif
         return *this;
     }
 
@@ -97,12 +269,43 @@ class async_response {
      * @brief Destructor.
      */
     ~async_response() noexcept {
+        // a response nobody waits for is not worth sending again
+        if(m_flow) m_flow->has_payload = false;
         if(m_request != MARGO_REQUEST_NULL)
-            wait();
+            wait_cancelled();
         if(m_handle != HG_HANDLE_NULL)
             margo_destroy(m_handle);
     }
 
+    /**
+     * @brief Consumes the async_response and returns an eventual set
+     * with the result of fn(packed_data<>&) once the response has been
+     * received (or with the exception thrown by wait() or fn). Margo
+     * does not provide completion callbacks for RPCs, so a ULT is
+     * created in the provided pool to wait for the response; use
+     * eventual::then on the result to chain further steps as tasks.
+     *
+     * @param p Pool in which to wait for the response and run fn.
+     * @param fn Function taking a packed_data<>&.
+     *
+     * @return an eventual for the result of fn.
+     */
+    template <typename F>
+    auto then(const pool& p, F&& fn) &&
+    -> eventual<typename std::decay<decltype(fn(std::declval<packed_data<>&>()))>::type>;
+
+    /**
+     * @brief Makes the ULT calling wait() (or wait_any() returning this
+     * response) resume in pool p once the response has arrived, so that
+     * the response is deserialized and used by the execution streams
+     * that own the data it goes to (e.g. those of its NUMA node). The
+     * ULT is migrated only if it is not in p already and can be
+     * migrated.
+     *
+     * @param p Pool in which to resume the waiting ULT.
+     */
+    async_response& resume_in(const pool& p);
+
     /**
      * @brief Waits for the async_response to be ready and returns
      * a packed_data when the response has been received.
@@ -112,20 +315,80 @@ class async_response {
     packed_data<> wait() {
         if(m_handle == HG_HANDLE_NULL)
             throw exception("Calling wait on an invalid async_response");
-        hg_return_t ret;
+        auto result = try_wait();
+        if(!result) detail::throw_rpc_error(result.error(), m_cancelled, "margo_wait");
+        return std::move(result).value();
+    }
+
+    /**
+     * @brief Same as wait(), but returns the error code instead of
+     * throwing: HG_TIMEOUT for tl::timeout, HG_BUSY for tl::busy,
+     * HG_HOSTUNREACH for tl::peer_failure,
+     * HG_CANCELED if the RPC was cancelled, and HG_INVALID_ARG if the
+     * async_response is not associated with an RPC.
+     *
+     * @return the packed_data containing the response, or the error.
+     */
+    expected<packed_data<>> try_wait() {
+        if(m_handle == HG_HANDLE_NULL)
+            return expected<packed_data<>>::failure(HG_INVALID_ARG);
         if(m_request != MARGO_REQUEST_NULL) {
-            ret = margo_wait(m_request);
+            detail::check_can_block("async_response::wait");
+            hg_return_t ret = margo_wait(m_request);
             m_request = MARGO_REQUEST_NULL;
-            if(ret == HG_TIMEOUT) {
-                throw timeout();
+            // a cancelled RPC is not sent again
+            if(m_flow && (m_cancelled || detail::peer_monitor::failed(m_peer)))
+                m_flow->has_payload = false;
+            while(m_flow && m_flow->completed(ret, ret == HG_SUCCESS && !m_ignore_response
+                                                   && detail::is_busy_response(m_handle),
+                                              m_handle, &m_request)) {
+                ret = margo_wait(m_request);
+                m_request = MARGO_REQUEST_NULL;
             }
-            MARGO_ASSERT(ret, margo_wait);
+            m_flow.reset();
+            detail::peer_monitor::release(m_peer, ret);
+            detail::resume_in(m_resume_pool);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+            record_round_trip();
+#endif
+            if(ret != HG_SUCCESS)
+                return expected<packed_data<>>::failure(ret);
         }
         if(m_ignore_response)
             return packed_data<>();
+        if(detail::is_busy_response(m_handle))
+            return expected<packed_data<>>::failure(HG_BUSY);
         return packed_data<>(margo_get_output, margo_free_output, m_handle, m_mid);
     }
 
+    /**
+     * @brief Cancels the RPC if its response has not been received yet:
+     * the request is cancelled locally (with HG_Cancel), so that wait()
+     * returns as soon as possible and throws tl::cancelled, and if the
+     * RPC was set up with remote_procedure::enable_cancellation, the
+     * server is notified so that the handler is not run if it has not
+     * started yet, or sees request::is_cancelled() return true if it
+     * has. The response may still be received if it was already on its
+     * way, in which case wait() returns it as usual.
+     */
+    void cancel() {
+        if(m_request == MARGO_REQUEST_NULL || m_cancelled)
+            return;
+        m_cancelled = true;
+        if(m_token) {
+            const struct hg_info* info = margo_get_info(m_handle);
+            if(info) detail::rpc_control_registry::send_cancel(m_mid, info->addr, m_token);
+        }
+        HG_Cancel(m_handle);
+    }
+
+    /**
+     * @brief Returns true if cancel() was called.
+     */
+    bool cancel_requested() const {
+        return m_cancelled;
+    }
+
     /**
      * @brief Tests without blocking if the response has been received.
      *
@@ -159,28 +422,126 @@ class async_response {
     template <typename Iterator>
     static packed_data<> wait_any(const Iterator& begin, const Iterator& end,
                                   Iterator& completed) {
-        std::vector<margo_request> reqs;
-        size_t                     count = std::distance(begin, end);
-        reqs.reserve(count);
-        for(auto it = begin; it != end; it++) {
-            reqs.push_back(it->m_request);
-        }
+        hg_return_t ret   = HG_SUCCESS;
+        bool        found = false;
         completed         = begin;
-        size_t      index = 0;
-        hg_return_t ret   = margo_wait_any(count, reqs.data(), &index);
-        std::advance(completed, index);
-        if(ret == HG_TIMEOUT) {
-            throw timeout();
-        }
-        MARGO_ASSERT(ret, margo_wait_any);
-        if(completed->m_ignore_response) {
-            return packed_data<>();
+        wait_each(begin, end, [&](const Iterator& it, std::size_t, hg_return_t r) {
+            completed = it;
+            ret       = r;
+            found     = true;
+            return false;
+        });
+        if(!found)
+            throw exception("Calling wait_any without any pending async_response");
+        detail::resume_in(completed->m_resume_pool);
+        return completed->completed_response(ret);
+    }
+
+    /**
+     * @brief Waits for all the provided async_response and returns their
+     * responses in the order of the range. The responses are processed
+     * in the order they arrive, with a single array of margo requests
+     * for the whole call. If some of them fail, the exception of the
+     * first one (in the order of the range) is thrown once all of them
+     * completed; the others can still be retrieved with wait().
+     *
+     * @tparam Iterator Iterator type (e.g.
+     * std::vector<async_response>::iterator)
+     * @param begin Begin iterator
+     * @param end End iterator
+     *
+     * @return a packed_data per async_response.
+     */
+    template <typename Iterator>
+    static std::vector<packed_data<>> wait_all(const Iterator& begin, const Iterator& end) {
+        std::vector<packed_data<>>      results(std::distance(begin, end));
+        std::vector<std::exception_ptr> errors(results.size());
+        // responses received by previous calls are not waited for again
+        std::size_t i = 0;
+        for(auto it = begin; it != end; it++, i++) {
+            if(it->m_handle == HG_HANDLE_NULL || it->m_request != MARGO_REQUEST_NULL) continue;
+            try {
+                results[i] = it->completed_response(HG_SUCCESS);
+            } catch(...) {
+                errors[i] = std::current_exception();
+            }
         }
-        return packed_data<>(margo_get_output, margo_free_output,
-                completed->m_handle, completed->m_mid);
+        wait_each(begin, end, [&](const Iterator& it, std::size_t index, hg_return_t ret) {
+            try {
+                results[index] = it->completed_response(ret);
+            } catch(...) {
+                errors[index] = std::current_exception();
+            }
+            return true;
+        });
+        for(auto& e : errors)
+            if(e) std::rethrow_exception(e);
+        return results;
+    }
+
+    /**
+     * @brief Waits for the pending async_response of the range (those
+     * whose response has not been received yet) and calls
+     * fn(completed, data) on each of them as soon as its response
+     * arrives, where completed is its iterator and data its packed_data,
+     * until fn returns false or none is pending. A single array of margo
+     * requests serves the whole call.
+     *
+     * If an RPC fails, its exception is thrown right away; the
+     * async_response of the range not handed to fn yet can be waited for
+     * again.
+     *
+     * @tparam Iterator Iterator type (e.g.
+     * std::vector<async_response>::iterator)
+     * @tparam F Callable taking an Iterator and a packed_data<>&, and
+     * returning a bool.
+     * @param begin Begin iterator
+     * @param end End iterator
+     * @param fn Function called on each response.
+     *
+     * @return the number of responses handed to fn.
+     */
+    template <typename Iterator, typename F>
+    static std::size_t wait_some(const Iterator& begin, const Iterator& end, F&& fn) {
+        std::size_t count = 0;
+        wait_each(begin, end, [&](const Iterator& it, std::size_t, hg_return_t ret) {
+            packed_data<> data = it->completed_response(ret);
+            count += 1;
+            return static_cast<bool>(fn(it, data));
+        });
+        return count;
     }
 };
 
 } // namespace thallium
 
+#include <thallium/eventual.hpp>
+#include <thallium/pool.hpp>
+
+namespace thallium {
+
+inline async_response& async_response::resume_in(const pool& p) {
+    m_resume_pool = p.native_handle();
+    return *this;
+}
+
+template <typename F>
+auto async_response::then(const pool& p, F&& fn) &&
+-> eventual<typename std::decay<decltype(fn(std::declval<packed_data<>&>()))>::type> {
+    using R = typename std::decay<decltype(fn(std::declval<packed_data<>&>()))>::type;
+    eventual<R> result;
+    auto target = result.m_state;
+    detail::eventual_submit(p.native_handle(),
+        [target, self = std::move(*this), fn = std::forward<F>(fn)]() mutable {
+            auto wait_and_call = [&self, &fn]() {
+                packed_data<> data = self.wait();
+                return fn(data);
+            };
+            detail::eventual_fulfill<R>::call(*target, wait_and_call);
+        }, true);
+    return result;
+}
+
+} // namespace thallium
+
 #endif
@@ -0,0 +1,140 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BUFFER_VIEW_HPP
+#define __THALLIUM_BUFFER_VIEW_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <cereal/cereal.hpp>
+
+namespace thallium {
+
+template <typename ... CtxArg> class size_archive;
+
+/**
+ * @brief buffer_view is a non-owning (pointer, size) view over a
+ * sequence of bytes that can be used as an RPC argument or return value.
+ *
+ * When serialized, the bytes are copied into the Mercury buffer.
+ * When deserialized, no copy is made: the view points directly into
+ * the buffer of the underlying hg_handle_t. Such a view therefore
+ * remains valid only as long as the request (on the server side) or the
+ * packed_data (on the client side) it was decoded from is alive,
+ * and on the client side until the same callable_remote_procedure
+ * is used to send another RPC.
+ *
+ * The wire format is the same as that of std::string and
+ * std::vector<char>, so a client can send a std::string and
+ * the server can receive it as a buffer_view.
+ */
+class buffer_view {
+
+  public:
+
+    using value_type     = char;
+    using size_type      = std::size_t;
+    using const_iterator = const char*;
+
+    /**
+     * @brief Creates an empty buffer_view.
+     */
+    buffer_view() = default;
+
+    /**
+     * @brief Creates a buffer_view over the provided memory.
+     *
+     * @param data Pointer to the data.
+     * @param size Size of the data in bytes.
+     */
+    buffer_view(const void* data, std::size_t size)
+    : m_data(static_cast<const char*>(data))
+    , m_size(size) {}
+
+    /**
+     * @brief Creates a buffer_view over the content of a std::string.
+     */
+    buffer_view(const std::string& str)
+    : m_data(str.data())
+    , m_size(str.size()) {}
+
+    /**
+     * @brief Creates a buffer_view over the content of a std::vector<char>.
+     */
+    buffer_view(const std::vector<char>& vec)
+    : m_data(vec.data())
+    , m_size(vec.size()) {}
+
+    buffer_view(const buffer_view&)            = default;
+    buffer_view& operator=(const buffer_view&) = default;
+
+    /**
+     * @brief Returns a pointer to the viewed data.
+     */
+    const char* data() const { return m_data; }
+
+    /**
+     * @brief Returns the size of the viewed data, in bytes.
+     */
+    std::size_t size() const { return m_size; }
+
+    /**
+     * @brief Returns true if the buffer_view is empty.
+     */
+    bool empty() const { return m_size == 0; }
+
+    const_iterator begin() const { return m_data; }
+
+    const_iterator end() const { return m_data + m_size; }
+
+    char operator[](std::size_t i) const { return m_data[i]; }
+
+    /**
+     * @brief Copies the viewed data into a std::string.
+     */
+    std::string to_string() const { return std::string(m_data, m_size); }
+
+    template <typename A> void save(A& ar) const {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(m_size)));
+        if(m_size == 0) return;
+        void* buf = ar.save_ptr(m_size);
+        std::memcpy(buf, m_data, m_size);
+        ar.restore_ptr(buf, m_size);
+    }
+
+    /**
+     * @brief Counts the bytes save() writes, without copying the data.
+     *
+     * @param ar size_archive.
+     */
+    template <typename ... CtxArg> void save(size_archive<CtxArg...>& ar) const {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(m_size)));
+        ar.add(m_size);
+    }
+
+    template <typename A> void load(A& ar) {
+        cereal::size_type size;
+        ar(cereal::make_size_tag(size));
+        m_size = static_cast<std::size_t>(size);
+        if(m_size == 0) {
+            m_data = nullptr;
+            return;
+        }
+        void* buf = ar.save_ptr(m_size);
+        m_data    = static_cast<const char*>(buf);
+        ar.restore_ptr(buf, m_size);
+    }
+
+  private:
+
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+} // namespace thallium
+
+#endif
@@ -6,9 +6,20 @@
 #ifndef __THALLIUM_BULK_HPP
 #define __THALLIUM_BULK_HPP
 
+#include <thallium/expected.hpp>
+#include <thallium/bulk_checksum.hpp>
+#include <thallium/bulk_reaper.hpp>
+#include <thallium/inline_bulk.hpp>
 #include <thallium/margo_instance_ref.hpp>
 #include <thallium/margo_exception.hpp>
+#include <thallium/non_blocking.hpp>
+#include <thallium/resume.hpp>
+#include <thallium/timeout.hpp>
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <margo.h>
 #include <string>
@@ -18,10 +29,34 @@ namespace thallium {
 
 class engine;
 class endpoint;
+class pool;
 class remote_bulk;
 class bulk_segment;
+class bulk_forwarder;
+template <typename ... CtxArg> class size_archive;
 
 
+/**
+ * @brief Outcome of a bulk transfer, passed to the completion callbacks
+ * of remote_bulk::pull_to and remote_bulk::push_from.
+ */
+struct bulk_op_result {
+    std::size_t size;  /*!< number of bytes transfered (0 on failure) */
+    hg_return_t error; /*!< HG_SUCCESS or the Mercury error code */
+
+    /**
+     * @brief Returns true if the transfer succeeded.
+     */
+    bool ok() const {
+        return error == HG_SUCCESS;
+    }
+};
+
+/**
+ * @brief Type of the callbacks invoked when a bulk transfer completes.
+ */
+using bulk_callback = std::function<void(const bulk_op_result&)>;
+
 /**
  * @brief The async_bulk_op class is returned by the push_to and pull_from
  * methods and track a non-blocking RDMA operation.
@@ -32,7 +67,16 @@ class async_bulk_op {
 
     public:
 
+    /**
+     * @brief Creates an async_bulk_op not associated with any operation.
+     */
+    async_bulk_op()
+    : m_tranferred_size{0}
+    , m_request{MARGO_REQUEST_NULL}
+    {}
+
     bool test() const {
+        if(m_done) return true;
         if(m_request == MARGO_REQUEST_NULL)
             throw exception{"Calling async_bulk_op::test() on a null request"};
         int flag;
@@ -42,26 +86,99 @@ class async_bulk_op {
     }
 
     std::size_t wait() {
-        if(m_request == MARGO_REQUEST_NULL)
+        if(!m_done && m_request == MARGO_REQUEST_NULL)
             throw exception{"Calling async_bulk_op::wait() on a null request"};
-        hg_return_t ret = margo_wait(m_request);
-        MARGO_ASSERT(ret, margo_wait);
+        auto size = try_wait();
+        MARGO_ASSERT(size.error(), margo_wait);
+        return *size;
+    }
+
+    /**
+     * @brief Same as wait() but returns an expected holding the Mercury
+     * error code (HG_INVALID_ARG on a null request) instead of throwing.
+     */
+    expected<std::size_t> try_wait() {
+        if(m_done) return m_tranferred_size;
+        if(m_request == MARGO_REQUEST_NULL)
+            return expected<std::size_t>::failure(HG_INVALID_ARG);
+        detail::check_can_block("async_bulk_op::wait");
+        // margo_wait frees the request, even on failure
+        hg_return_t ret = margo_wait(std::exchange(m_request, MARGO_REQUEST_NULL));
+        detail::resume_in(m_resume_pool);
+        if(ret != HG_SUCCESS) return expected<std::size_t>::failure(ret);
         return m_tranferred_size;
     }
 
+    /**
+     * @brief Makes the ULT calling wait() (or wait_any() returning this
+     * operation) resume in pool p once the transfer has completed, so
+     * that it accesses the data from the execution streams that own the
+     * buffer (e.g. those of its NUMA node) rather than from whichever
+     * one the ULT was waiting on. The ULT is migrated only if it is not
+     * in p already and can be migrated.
+     *
+     * @param p Pool in which to resume the waiting ULT.
+     */
+    async_bulk_op& resume_in(const pool& p);
+
+    /**
+     * @brief Waits for any of the operations in the range [begin, end)
+     * to complete. The completed iterator is set to the one that
+     * completed, which can then no longer be waited on.
+     *
+     * @param begin Beginning of the range of async_bulk_op.
+     * @param end End of the range.
+     * @param completed Set to the operation that completed.
+     *
+     * @return the size of data transfered by the completed operation.
+     */
+    template <typename Iterator>
+    static std::size_t wait_any(const Iterator& begin, const Iterator& end,
+                                Iterator& completed) {
+        for(completed = begin; completed != end; completed++) {
+            if(!completed->m_done) continue;
+            completed->m_done = false;
+            return completed->m_tranferred_size;
+        }
+        std::vector<margo_request> reqs;
+        size_t                     count = std::distance(begin, end);
+        reqs.reserve(count);
+        for(auto it = begin; it != end; it++) {
+            reqs.push_back(it->m_request);
+        }
+        completed         = begin;
+        size_t      index = 0;
+        hg_return_t ret   = margo_wait_any(count, reqs.data(), &index);
+        std::advance(completed, index);
+        // the request has been completed and released by margo_wait_any
+        completed->m_request = MARGO_REQUEST_NULL;
+        if(index < count) detail::resume_in(completed->m_resume_pool);
+        if(ret == HG_TIMEOUT) {
+            throw timeout();
+        }
+        MARGO_ASSERT(ret, margo_wait_any);
+        return completed->m_tranferred_size;
+    }
+
     async_bulk_op(const async_bulk_op&) = delete;
 
     async_bulk_op(async_bulk_op&& other)
-    : m_request{std::exchange(other.m_request, MARGO_REQUEST_NULL)}
+    : m_tranferred_size{other.m_tranferred_size}
+    , m_request{std::exchange(other.m_request, MARGO_REQUEST_NULL)}
+    , m_done{std::exchange(other.m_done, false)}
+    , m_resume_pool{other.m_resume_pool}
     {}
 
     async_bulk_op& operator=(const async_bulk_op&) = delete;
 
     async_bulk_op& operator=(async_bulk_op&& other) {
-        if(&other == this || m_request == other.m_request) return *this;
-        if(m_request != MARGO_REQUEST_NULL)
+        if(&other == this) return *this;
+        if(m_request != MARGO_REQUEST_NULL && m_request != other.m_request)
             wait();
+        m_tranferred_size = other.m_tranferred_size;
         m_request = std::exchange(other.m_request, MARGO_REQUEST_NULL);
+        m_done    = std::exchange(other.m_done, false);
+        m_resume_pool = other.m_resume_pool;
         return *this;
     }
 
@@ -78,8 +195,74 @@ class async_bulk_op {
     , m_request{req}
     {}
 
+    /**
+     * @brief Returns an operation that already completed (a pull served
+     * from the data inlined in a bulk, see engine::enable_inline_bulk).
+     */
+    static async_bulk_op completed(std::size_t size) {
+        async_bulk_op op{size, MARGO_REQUEST_NULL};
+        op.m_done = true;
+        return op;
+    }
+
     std::size_t   m_tranferred_size;
     margo_request m_request;
+    bool          m_done        = false;
+    ABT_pool      m_resume_pool = ABT_POOL_NULL;
+};
+
+/**
+ * @brief The striped_bulk_op class is returned by the remote_bulk::pull_to
+ * and remote_bulk::push_from overloads that split one transfer into
+ * several concurrent RDMA operations. It tracks all of them as one.
+ */
+class striped_bulk_op {
+
+    friend class remote_bulk;
+    friend class multi_rail_endpoint;
+
+    public:
+
+    /**
+     * @brief Returns true if all the operations have completed.
+     */
+    bool test() const {
+        for(auto& op : m_ops) {
+            if(!op.test()) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Waits for all the operations to complete.
+     *
+     * @return the total size of data transfered.
+     */
+    std::size_t wait() {
+        std::size_t total = 0;
+        for(auto& op : m_ops) total += op.wait();
+        m_ops.clear();
+        return total;
+    }
+
+    /**
+     * @brief Returns the number of operations the transfer was split into.
+     */
+    std::size_t num_stripes() const {
+        return m_ops.size();
+    }
+
+    striped_bulk_op(const striped_bulk_op&)            = delete;
+    striped_bulk_op(striped_bulk_op&&)                 = default;
+    striped_bulk_op& operator=(const striped_bulk_op&) = delete;
+    striped_bulk_op& operator=(striped_bulk_op&&)      = default;
+    ~striped_bulk_op()                                 = default;
+
+    private:
+
+    striped_bulk_op() = default;
+
+    std::vector<async_bulk_op> m_ops;
 };
 
 /**
@@ -91,12 +274,84 @@ class bulk {
 
     friend class engine;
     friend class remote_bulk;
+    friend class bulk_forwarder;
+    friend class bulk_segment;
+    friend class bulk_write_combiner;
 
   private:
 
-    margo_instance_ref m_mid;
-    hg_bulk_t          m_bulk     = HG_BULK_NULL;
-    bool               m_is_local = false;
+    margo_instance_ref    m_mid;
+    hg_bulk_t             m_bulk     = HG_BULK_NULL;
+    bool                  m_is_local = false;
+    // whether the data of the bulk may be inlined: false for write-only
+    // and device memory, and for handles wrapped by engine::wrap
+    bool                  m_inlinable = false;
+    // memory exposed by the bulk, if the bulk keeps it alive (e.g. the
+    // file mapping of engine::expose_file); released after m_bulk
+    std::shared_ptr<void> m_storage;
+    // copy of the data of a remote bulk, if the sender inlined it
+    std::shared_ptr<const std::vector<char>> m_inline;
+
+    // frees m_bulk, or hands it (with m_storage) to the bulk_reaper of
+    // the margo instance if it has one (see enable_deferred_bulk_free)
+    hg_return_t free_handle() {
+        hg_bulk_t b = m_bulk;
+        m_bulk      = HG_BULK_NULL;
+        if(m_is_local) {
+            auto reaper = detail::bulk_reaper::find(m_mid);
+            if(reaper && reaper->defer(b, m_storage)) return HG_SUCCESS;
+        }
+        return margo_bulk_free(b);
+    }
+
+    // maximum number of segments of a bulk whose data is inlined
+    static constexpr hg_uint32_t max_inline_segments = 16;
+
+    /**
+     * @brief Returns the size of the data to inline when serializing
+     * the bulk, or 0 if it should not be inlined, and sets the pointers
+     * and sizes of its segments.
+     */
+    std::size_t inline_segments(void** ptrs, hg_size_t* sizes, hg_uint32_t& count) const {
+        if(!m_is_local || !m_inlinable || m_bulk == HG_BULK_NULL || !m_mid) return 0;
+        std::size_t threshold = detail::inline_bulk::threshold(m_mid);
+        std::size_t total     = size();
+        if(threshold == 0 || total == 0 || total > threshold
+        || segment_count() > max_inline_segments)
+            return 0;
+        hg_return_t ret = HG_Bulk_access(m_bulk, 0, total, HG_BULK_READ_ONLY,
+                                         max_inline_segments, ptrs, sizes, &count);
+        return ret == HG_SUCCESS ? total : 0;
+    }
+
+    /**
+     * @brief Copies size bytes of the inlined data, from offset, into
+     * the local memory exposed by dest_bulk at dest_offset.
+     */
+    void copy_inline(std::size_t offset, const bulk& dest_bulk, std::size_t dest_offset,
+                     std::size_t size) const {
+        if(offset > m_inline->size() || size > m_inline->size() - offset)
+            throw exception("Invalid range of a bulk transfer: ", size, " bytes at offset ",
+                            offset, " of an inlined bulk of ", m_inline->size(), " bytes");
+        void*       ptrs[max_inline_segments];
+        hg_size_t   sizes[max_inline_segments];
+        hg_uint32_t count = 0;
+        const char* src   = m_inline->data() + offset;
+        while(size > 0) {
+            hg_return_t ret = HG_Bulk_access(dest_bulk.m_bulk, dest_offset, size,
+                                             HG_BULK_READWRITE, max_inline_segments,
+                                             ptrs, sizes, &count);
+            MARGO_ASSERT(ret, HG_Bulk_access);
+            if(count == 0) throw exception("Invalid destination of a bulk transfer");
+            for(hg_uint32_t i = 0; i < count && size > 0; i++) {
+                std::size_t n = std::min<std::size_t>(sizes[i], size);
+                std::memcpy(ptrs[i], src, n);
+                src         += n;
+                dest_offset += n;
+                size        -= n;
+            }
+        }
+    }
 
     /**
      * @brief Constructor. Made private as bulk objects
@@ -107,11 +362,14 @@ class bulk {
      * @param b Mercury bulk handle.
      * @param local Whether the bulk handle referes to memory that is
      * local to this process.
+     * @param inlinable Whether the data may be inlined when the bulk is
+     * serialized (readable host memory).
      */
-    bulk(margo_instance_ref mid, hg_bulk_t b, bool local) noexcept
+    bulk(margo_instance_ref mid, hg_bulk_t b, bool local, bool inlinable = false) noexcept
     : m_mid{std::move(mid)}
     , m_bulk(b)
-    , m_is_local(local) {}
+    , m_is_local(local)
+    , m_inlinable(inlinable) {}
 
   public:
     /**
@@ -126,7 +384,10 @@ class bulk {
     bulk(const bulk& other)
     : m_mid{other.m_mid}
     , m_bulk(other.m_bulk)
-    , m_is_local(other.m_is_local) {
+    , m_is_local(other.m_is_local)
+    , m_inlinable(other.m_inlinable)
+    , m_storage(other.m_storage)
+    , m_inline(other.m_inline) {
         if(other.m_bulk != HG_BULK_NULL) {
             hg_return_t ret = margo_bulk_ref_incr(m_bulk);
             MARGO_ASSERT(ret, margo_bulk_ref_incr);
@@ -139,7 +400,10 @@ class bulk {
     bulk(bulk&& other) noexcept
     : m_mid(std::move(other.m_mid))
     , m_bulk(other.m_bulk)
-    , m_is_local(other.m_is_local) {
+    , m_is_local(other.m_is_local)
+    , m_inlinable(other.m_inlinable)
+    , m_storage(std::move(other.m_storage))
+    , m_inline(std::move(other.m_inline)) {
         other.m_bulk = HG_BULK_NULL;
     }
 
@@ -150,16 +414,19 @@ class bulk {
         if(this == &other)
             return *this;
         if(m_bulk != HG_BULK_NULL) {
-            hg_return_t ret = margo_bulk_free(m_bulk);
+            hg_return_t ret = free_handle();
             MARGO_ASSERT(ret, margo_bulk_free);
         }
-        m_bulk     = other.m_bulk;
-        m_is_local = other.m_is_local;
+        m_bulk      = other.m_bulk;
+        m_is_local  = other.m_is_local;
+        m_inlinable = other.m_inlinable;
         if(m_bulk != HG_BULK_NULL) {
             hg_return_t ret = margo_bulk_ref_incr(m_bulk);
             MARGO_ASSERT(ret, margo_bulk_ref_incr);
         }
-        m_mid = other.m_mid;
+        m_mid     = other.m_mid;
+        m_storage = other.m_storage;
+        m_inline  = other.m_inline;
         return *this;
     }
 
@@ -170,13 +437,16 @@ class bulk {
         if(this == &other)
             return *this;
         if(m_bulk != HG_BULK_NULL) {
-            hg_return_t ret = margo_bulk_free(m_bulk);
+            hg_return_t ret = free_handle();
             MARGO_ASSERT(ret, margo_bulk_free);
         }
         m_bulk        = other.m_bulk;
         m_is_local    = other.m_is_local;
+        m_inlinable   = other.m_inlinable;
         other.m_bulk  = HG_BULK_NULL;
         m_mid         = std::move(other.m_mid);
+        m_storage     = std::move(other.m_storage);
+        m_inline      = std::move(other.m_inline);
         return *this;
     }
 
@@ -185,7 +455,7 @@ class bulk {
      */
     ~bulk() noexcept {
         if(m_bulk != HG_BULK_NULL) {
-            hg_return_t ret = margo_bulk_free(m_bulk);
+            hg_return_t ret = free_handle();
             MARGO_ASSERT_TERMINATE(ret, margo_bulk_free);
         }
     }
@@ -307,21 +577,84 @@ class bulk {
 
     /**
      * @brief Function that serializes a bulk object into/from an archive.
+     * If inlining is enabled on the engine of a local bulk (see
+     * engine::enable_inline_bulk) and the bulk is small enough, its data
+     * is serialized along with its handle.
      *
      * @tparam A Archive type.
      * @param ar archive.
      */
     template <typename A> void serialize(A& ar) {
         using namespace std::string_literals;
-        auto ret = hg_proc_hg_bulk_t(ar.get_proc(), &m_bulk);
+        hg_proc_t   proc = ar.get_proc();
+        hg_return_t ret  = HG_SUCCESS;
+        if(hg_proc_get_op(proc) == HG_ENCODE) {
+            void*       ptrs[max_inline_segments];
+            hg_size_t   sizes[max_inline_segments];
+            hg_uint32_t count = 0;
+            std::size_t data  = inline_segments(ptrs, sizes, count);
+            if(data) {
+                hg_uint64_t head = detail::inline_bulk::tag | data;
+                ret = hg_proc_uint64_t(proc, &head);
+                for(hg_uint32_t i = 0; ret == HG_SUCCESS && i < count; i++)
+                    ret = hg_proc_memcpy(proc, ptrs[i], sizes[i]);
+            }
+        } else if(hg_proc_get_op(proc) == HG_DECODE) {
+            // a serialized handle starts with its size, which never has
+            // the tag bit set
+            hg_uint64_t head = 0;
+            if(hg_proc_get_size_left(proc) >= sizeof(head))
+                std::memcpy(&head, hg_proc_get_buf_ptr(proc), sizeof(head));
+            m_inline.reset();
+            if(head & detail::inline_bulk::tag) {
+                ret = hg_proc_uint64_t(proc, &head);
+                hg_uint64_t length = head & ~detail::inline_bulk::tag;
+                // the inlined data can't be longer than what is left
+                if(ret == HG_SUCCESS && length > hg_proc_get_size_left(proc))
+                    ret = HG_OVERFLOW;
+                if(ret == HG_SUCCESS) {
+                    auto data = std::make_shared<std::vector<char>>(
+                        static_cast<std::size_t>(length));
+                    ret = hg_proc_memcpy(proc, data->data(), data->size());
+                    m_inline = std::move(data);
+                }
+            }
+        }
+        if(ret == HG_SUCCESS)
+            ret = hg_proc_hg_bulk_t(proc, &m_bulk);
         if(ret != HG_SUCCESS) {
-            std::stringstream ss;
             throw exception{
                 "Error during serialization, hg_proc_hg_bulk_t returned "s +
                 HG_Error_to_string(ret)};
         }
+        // the inlined data is the whole content of the bulk
+        if(m_inline && m_inline->size() != HG_Bulk_get_size(m_bulk)) {
+            std::size_t length = m_inline->size();
+            m_inline.reset();
+            throw exception("Error during serialization: ", length,
+                            " bytes inlined for a bulk of ", HG_Bulk_get_size(m_bulk), " bytes");
+        }
         if(!m_mid) m_mid = ar.get_engine().get_margo_instance();
     }
+
+    /**
+     * @brief Counts the number of bytes that serializing the bulk
+     * object into a proc_output_archive would produce (a 64-bit size
+     * followed by the serialized handle, not including eager data,
+     * preceded by the inlined data if any).
+     *
+     * @param ar size_archive.
+     */
+    template <typename ... CtxArg> void serialize(size_archive<CtxArg...>& ar) {
+        void*       ptrs[max_inline_segments];
+        hg_size_t   sizes[max_inline_segments];
+        hg_uint32_t count = 0;
+        std::size_t data  = inline_segments(ptrs, sizes, count);
+        if(data) ar.add(sizeof(hg_uint64_t) + data);
+        ar.add(sizeof(hg_uint64_t));
+        if(m_bulk != HG_BULK_NULL)
+            ar.add(HG_Bulk_get_serialize_size(m_bulk, 0));
+    }
 };
 
 /**
@@ -330,6 +663,8 @@ class bulk {
  */
 class bulk_segment {
     friend class remote_bulk;
+    friend class bulk_forwarder;
+    friend class bulk_write_combiner;
 
     std::size_t m_offset;
     std::size_t m_size;
@@ -467,6 +802,17 @@ class bulk_segment {
             std::size_t size) const noexcept {
         return select(offset, size);
     }
+
+    /**
+     * @brief Computes the CRC32C of the local memory of the segment,
+     * e.g. for the sender of a bulk handle to provide it to a receiver
+     * calling remote_bulk::pull_verified.
+     *
+     * @param crc Checksum of the preceding data, if any (see crc32c).
+     *
+     * @return the checksum.
+     */
+    std::uint32_t checksum(std::uint32_t crc = 0) const;
 };
 
 } // namespace thallium
@@ -523,6 +869,27 @@ inline async_bulk_op bulk::push_to(const remote_bulk& b) const {
     return b.push_from(*this);
 }
 
+inline std::uint32_t bulk_segment::checksum(std::uint32_t crc) const {
+    void*       ptrs[16];
+    hg_size_t   sizes[16];
+    hg_uint32_t count  = 0;
+    std::size_t offset = m_offset;
+    std::size_t size   = m_size;
+    while(size > 0) {
+        hg_return_t ret = HG_Bulk_access(m_bulk.m_bulk, offset, size, HG_BULK_READ_ONLY,
+                                         16, ptrs, sizes, &count);
+        MARGO_ASSERT(ret, HG_Bulk_access);
+        if(count == 0) throw exception("Invalid bulk segment");
+        for(hg_uint32_t i = 0; i < count && size > 0; i++) {
+            std::size_t n = std::min<std::size_t>(sizes[i], size);
+            crc     = crc32c(ptrs[i], n, crc);
+            offset += n;
+            size   -= n;
+        }
+    }
+    return crc;
+}
+
 inline std::size_t bulk::operator<<(const remote_bulk& b) const {
     return b >> (this->select(0, size()));
 }
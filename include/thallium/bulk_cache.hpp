@@ -0,0 +1,282 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BULK_CACHE_HPP
+#define __THALLIUM_BULK_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <margo.h>
+#include <thallium/margo_exception.hpp>
+#include <thallium/bulk_mode.hpp>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Statistics reported by engine::get_bulk_cache_stats().
+ */
+struct bulk_cache_stats {
+    std::size_t hits         = 0; /*!< number of exposures served by the cache */
+    std::size_t misses       = 0; /*!< number of exposures that registered memory */
+    std::size_t evictions    = 0; /*!< number of registrations evicted */
+    std::size_t cached_bytes = 0; /*!< number of bytes currently registered by the cache */
+
+    /**
+     * @brief Fraction of exposures that were served by the cache.
+     */
+    double hit_rate() const {
+        auto total = hits + misses;
+        return total ? static_cast<double>(hits) / total : 0.0;
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Identifies a range of a file exposed by engine::expose_file:
+ * the file (device and inode), the version of its content (time of
+ * its last modification), the range and the bulk_mode.
+ */
+struct file_range_key {
+    std::uint64_t dev;
+    std::uint64_t ino;
+    std::uint64_t mtime_ns;
+    std::uint64_t offset;
+    std::uint64_t length;
+    bulk_mode     mode;
+
+    bool operator<(const file_range_key& other) const {
+        return std::tie(dev, ino, mtime_ns, offset, length, mode)
+             < std::tie(other.dev, other.ino, other.mtime_ns, other.offset, other.length,
+                        other.mode);
+    }
+};
+
+/**
+ * @private
+ * @brief Cache of memory registrations (hg_bulk_t), indexed by
+ * address range and bulk_mode and attached to a margo instance by
+ * engine::enable_bulk_cache(). Entries are evicted in LRU order when
+ * the total registered size exceeds the cache's capacity.
+ *
+ * Ranges of files exposed by engine::expose_file are indexed by
+ * file_range_key instead, and their entries keep the file mapping
+ * alive, until they are evicted.
+ */
+class bulk_cache : public per_instance<bulk_cache> {
+
+    struct entry {
+        std::uintptr_t        start;
+        std::size_t           size;
+        bulk_mode             mode;
+        hg_bulk_t             handle;
+        // memory owned by the entry (file mapping), released after the handle
+        std::shared_ptr<void> storage;
+        bool                  is_file = false;
+        file_range_key        file{};
+    };
+
+    using lru_list  = std::list<entry>;
+    using index_map = std::multimap<std::uintptr_t, lru_list::iterator>;
+    using file_map  = std::map<file_range_key, lru_list::iterator>;
+
+    std::size_t              m_max_bytes;
+    std::size_t              m_cached_bytes = 0;
+    std::size_t              m_max_size     = 0; // largest cached region
+    bool                     m_closed       = false;
+    std::atomic<std::size_t> m_hits{0};
+    std::atomic<std::size_t> m_misses{0};
+    std::atomic<std::size_t> m_evictions{0};
+    mutable std::mutex       m_mutex;
+    lru_list                 m_lru; // most recently used first
+    index_map                m_index;
+    file_map                 m_files;
+
+    static bool mode_covers(bulk_mode cached, bulk_mode requested) {
+        return cached == requested || cached == bulk_mode::read_write;
+    }
+
+    void erase(lru_list::iterator it) {
+        if(it->is_file) m_files.erase(it->file);
+        auto range = m_index.equal_range(it->start);
+        for(auto i = range.first; i != range.second; ++i) {
+            if(i->second == it) {
+                m_index.erase(i);
+                break;
+            }
+        }
+        m_cached_bytes -= it->size;
+        margo_bulk_free(it->handle);
+        m_lru.erase(it);
+    }
+
+  public:
+
+    bulk_cache(std::size_t max_bytes)
+    : m_max_bytes(max_bytes) {}
+
+    bulk_cache(const bulk_cache&)            = delete;
+    bulk_cache& operator=(const bulk_cache&) = delete;
+
+    ~bulk_cache() {
+        clear();
+    }
+
+    /**
+     * @brief Looks for a registration covering [ptr, ptr+size) with a
+     * compatible mode (read_write covers the other modes). If exact is
+     * true, only a registration of exactly this range is accepted.
+     * On a hit, sets result to the cached handle, with a reference owned
+     * by the caller, and offset to the position of ptr within it, and
+     * returns true.
+     */
+    bool find(const void* ptr, std::size_t size, bulk_mode mode, bool exact,
+              hg_bulk_t& result, std::size_t& offset) {
+        auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // candidate entries start at most m_max_size bytes before addr
+        auto it = m_index.upper_bound(addr);
+        while(it != m_index.begin()) {
+            --it;
+            auto& e = *it->second;
+            if(addr - e.start > m_max_size) break;
+            bool match = exact ? (e.start == addr && e.size == size)
+                               : (addr + size <= e.start + e.size);
+            if(match && mode_covers(e.mode, mode)) {
+                hg_return_t ret = margo_bulk_ref_incr(e.handle);
+                MARGO_ASSERT(ret, margo_bulk_ref_incr);
+                result = e.handle;
+                offset = addr - e.start;
+                m_lru.splice(m_lru.begin(), m_lru, it->second);
+                m_hits += 1;
+                return true;
+            }
+        }
+        m_misses += 1;
+        return false;
+    }
+
+    /**
+     * @brief Adds a registration to the cache, evicting least recently
+     * used ones if needed. Registrations larger than the capacity of the
+     * cache are not added. The cache takes its own reference on the handle.
+     */
+    void insert(const void* ptr, std::size_t size, bulk_mode mode, hg_bulk_t h) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_closed || size > m_max_bytes) return;
+        while(!m_lru.empty() && m_cached_bytes + size > m_max_bytes) {
+            erase(std::prev(m_lru.end()));
+            m_evictions += 1;
+        }
+        auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+        hg_return_t ret = margo_bulk_ref_incr(h);
+        MARGO_ASSERT(ret, margo_bulk_ref_incr);
+        m_lru.push_front(entry{addr, size, mode, h, nullptr});
+        m_index.emplace(addr, m_lru.begin());
+        m_cached_bytes += size;
+        if(size > m_max_size) m_max_size = size;
+    }
+
+    /**
+     * @brief Looks for the registration of a range of a file. On a hit,
+     * sets result to the cached handle, with a reference owned by the
+     * caller, and storage to the mapping it exposes, and returns true.
+     */
+    bool find_file(const file_range_key& key, hg_bulk_t& result,
+                   std::shared_ptr<void>& storage) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_files.find(key);
+        if(it == m_files.end()) {
+            m_misses += 1;
+            return false;
+        }
+        hg_return_t ret = margo_bulk_ref_incr(it->second->handle);
+        MARGO_ASSERT(ret, margo_bulk_ref_incr);
+        result  = it->second->handle;
+        storage = it->second->storage;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        m_hits += 1;
+        return true;
+    }
+
+    /**
+     * @brief Adds the registration of a range of a file, along with the
+     * mapping it exposes, evicting least recently used entries if needed.
+     */
+    void insert_file(const file_range_key& key, std::size_t size, hg_bulk_t h,
+                     std::shared_ptr<void> storage) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_closed || size > m_max_bytes || m_files.count(key)) return;
+        while(!m_lru.empty() && m_cached_bytes + size > m_max_bytes) {
+            erase(std::prev(m_lru.end()));
+            m_evictions += 1;
+        }
+        hg_return_t ret = margo_bulk_ref_incr(h);
+        MARGO_ASSERT(ret, margo_bulk_ref_incr);
+        entry e{reinterpret_cast<std::uintptr_t>(storage.get()), size, key.mode, h,
+                std::move(storage)};
+        e.is_file = true;
+        e.file    = key;
+        m_lru.push_front(std::move(e));
+        m_files.emplace(key, m_lru.begin());
+        m_cached_bytes += size;
+    }
+
+    /**
+     * @brief Removes from the cache any registration overlapping
+     * [ptr, ptr+size). Must be called before the memory is freed.
+     */
+    void invalidate(const void* ptr, std::size_t size) {
+        auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto it = m_lru.begin(); it != m_lru.end();) {
+            auto next = std::next(it);
+            if(it->start < addr + size && addr < it->start + it->size)
+                erase(it);
+            it = next;
+        }
+    }
+
+    /**
+     * @brief Releases all the registrations held by the cache. If close
+     * is true, the cache will refuse any registration inserted after
+     * this call.
+     */
+    void clear(bool close = false) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = m_closed || close;
+        for(auto& e : m_lru) margo_bulk_free(e.handle);
+        m_index.clear();
+        m_files.clear();
+        m_lru.clear();
+        m_cached_bytes = 0;
+        m_max_size     = 0;
+    }
+
+    bulk_cache_stats stats() const {
+        bulk_cache_stats s;
+        s.hits      = m_hits.load();
+        s.misses    = m_misses.load();
+        s.evictions = m_evictions.load();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        s.cached_bytes = m_cached_bytes;
+        return s;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
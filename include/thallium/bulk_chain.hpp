@@ -0,0 +1,347 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BULK_CHAIN_HPP
+#define __THALLIUM_BULK_CHAIN_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <thallium/async_response.hpp>
+#include <thallium/bulk.hpp>
+#include <thallium/bulk_forward.hpp>
+#include <thallium/condition_variable.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/mutex.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_bulk.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/request.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+inline const char* bulk_chain_rpc_name() {
+    return "__thallium_bulk_chain__";
+}
+
+inline const char* bulk_chain_ready_rpc_name() {
+    return "__thallium_bulk_chain_ready__";
+}
+
+/**
+ * @private
+ * @brief Progress notice telling a replica that the transfer failed upstream.
+ */
+constexpr std::uint64_t bulk_chain_aborted = std::numeric_limits<std::uint64_t>::max();
+
+/**
+ * @private
+ * @brief Number of bytes of a chain transfer that the upstream replica
+ * has received, and can therefore be pulled from it.
+ */
+struct bulk_chain_progress {
+
+    mutex              m_mutex;
+    condition_variable m_cv;
+    std::uint64_t      m_ready = 0;
+
+    void advance(std::uint64_t ready) {
+        {
+            std::lock_guard<mutex> lock(m_mutex);
+            if(m_ready == bulk_chain_aborted || ready <= m_ready) return;
+            m_ready = ready;
+        }
+        m_cv.notify_all();
+    }
+
+    // waits for more than done bytes to be available and returns how many are
+    std::uint64_t wait_beyond(std::uint64_t done) {
+        std::unique_lock<mutex> lock(m_mutex);
+        m_cv.wait(lock, [this, done]() { return m_ready > done; });
+        if(m_ready == bulk_chain_aborted) throw exception("An upstream replica failed");
+        return m_ready;
+    }
+};
+
+/**
+ * @private
+ * @brief Transfers of a bulk_chain in progress on a replica, by chain
+ * id. A progress notice may arrive before the transfer it belongs to,
+ * so either creates the entry; the ids of the last finished transfers
+ * are remembered so that late notices do not create it again.
+ */
+class bulk_chain_transfers {
+
+    static constexpr std::size_t max_finished = 1024;
+
+    std::mutex m_mutex;
+    std::unordered_map<std::uint64_t, std::shared_ptr<bulk_chain_progress>> m_transfers;
+    std::unordered_set<std::uint64_t> m_finished;
+    std::deque<std::uint64_t>         m_finished_order;
+
+  public:
+
+    /**
+     * @brief Returns the progress of a transfer, or nullptr if it has
+     * already finished.
+     */
+    std::shared_ptr<bulk_chain_progress> get(std::uint64_t id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_finished.count(id)) return nullptr;
+        auto& p = m_transfers[id];
+        if(!p) p = std::make_shared<bulk_chain_progress>();
+        return p;
+    }
+
+    void finish(std::uint64_t id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_transfers.erase(id);
+        if(!m_finished.insert(id).second) return;
+        m_finished_order.push_back(id);
+        if(m_finished_order.size() > max_finished) {
+            m_finished.erase(m_finished_order.front());
+            m_finished_order.pop_front();
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief A bulk_chain replicates a buffer to several servers while
+ * sending it only once from the client: the first replica pulls the
+ * client's buffer in chunks and, as each chunk arrives, tells the
+ * second replica, which pulls it from the first one's buffer, and so on
+ * down the chain. The client's outbound bandwidth stays that of a
+ * single transfer, and since every replica forwards chunks as soon as
+ * it has them, the whole replication takes little more than one
+ * transfer plus a chunk per additional replica.
+ *
+ * Replicas create a bulk_chain with a function returning, for a key
+ * and a size, the local buffer to receive the data into (exposed in
+ * read-write mode, since the next replica pulls from it), and
+ * optionally one called once the data is there. Clients create one
+ * without them.
+ *
+ * \code{.cpp}
+ * // on the servers
+ * tl::bulk_chain chain(engine, [&](const std::string& key, std::size_t size) {
+ *     return store.allocate(key, size); });
+ * // on the client
+ * tl::bulk_chain chain(engine);
+ * chain(data, {server1, server2, server3}, "object-42");
+ * \endcode
+ *
+ * Each replica only returns once those after it have received the
+ * data, so when the call returns all the replicas have it; otherwise
+ * an exception tells which one failed.
+ */
+class bulk_chain {
+
+  public:
+
+    using prepare_type  = std::function<bulk(const std::string& key, std::size_t size)>;
+    using complete_type = std::function<void(const std::string& key, std::size_t size)>;
+
+    /**
+     * @brief Defines the chain RPCs on a replica.
+     *
+     * @param e Engine of the replica.
+     * @param prepare Function returning the buffer to receive into.
+     * @param complete Function called once the data was received (may be null).
+     * @param provider_id Provider id of the RPCs.
+     * @param p Pool in which the handlers run.
+     */
+    bulk_chain(engine& e, prepare_type prepare, complete_type complete = complete_type(),
+               std::uint16_t provider_id = 0, const pool& p = pool())
+    : m_node(std::make_shared<node>()) {
+        m_node->prepare     = std::move(prepare);
+        m_node->complete    = std::move(complete);
+        m_node->provider_id = provider_id;
+        std::weak_ptr<node> weak = m_node;
+        std::function<void(const request&, std::uint64_t, const std::string&, const bulk&,
+                           std::uint64_t, std::uint64_t, std::uint64_t,
+                           const std::vector<std::string>&, bool)>
+            handler = [weak](const request& req, std::uint64_t id, const std::string& key,
+                             const bulk& src, std::uint64_t size, std::uint64_t chunk_size,
+                             std::uint64_t window, const std::vector<std::string>& rest,
+                             bool upstream_complete) {
+                auto n = weak.lock();
+                detail::bulk_forward_reply reply;
+                if(!n) reply.error = "Replica is shutting down";
+                else   reply = n->relay(req, id, key, src, size, chunk_size, window, rest,
+                                        upstream_complete);
+                req.respond(reply);
+            };
+        std::function<void(const request&, std::uint64_t, std::uint64_t)> ready =
+            [weak](const request& req, std::uint64_t id, std::uint64_t bytes) {
+                auto n = weak.lock();
+                auto progress = n ? n->transfers.get(id) : nullptr;
+                if(progress) progress->advance(bytes);
+                req.respond();
+            };
+        m_node->chain_rpc = e.define(detail::bulk_chain_rpc_name(), std::move(handler),
+                                     provider_id, p);
+        m_node->ready_rpc = e.define(detail::bulk_chain_ready_rpc_name(), std::move(ready),
+                                     provider_id, p);
+    }
+
+    /**
+     * @brief Defines the chain RPC on a client.
+     */
+    explicit bulk_chain(engine& e, std::uint16_t provider_id = 0)
+    : m_node(std::make_shared<node>()) {
+        m_node->provider_id = provider_id;
+        m_node->chain_rpc   = e.define(detail::bulk_chain_rpc_name());
+    }
+
+    bulk_chain(const bulk_chain&)            = delete;
+    bulk_chain& operator=(const bulk_chain&) = delete;
+
+    /**
+     * @brief Replicates a local buffer to a chain of replicas, in order.
+     * Throws an exception if a replica failed.
+     *
+     * @param src Local buffer, exposed in read-only or read-write mode.
+     * @param replicas Replicas, each running a bulk_chain with a
+     * prepare function.
+     * @param key Key passed to the replicas' prepare functions.
+     * @param chunk_size Size of the chunks a replica receives before
+     * the next one may pull them.
+     * @param window Number of chunks each replica pulls concurrently.
+     *
+     * @return the size of data replicated.
+     */
+    std::size_t operator()(const bulk& src, const std::vector<endpoint>& replicas,
+                           const std::string& key, std::size_t chunk_size = 4 * 1024 * 1024,
+                           std::size_t window = 4) const {
+        if(replicas.empty()) return 0;
+        std::vector<std::string> rest;
+        rest.reserve(replicas.size() - 1);
+        for(std::size_t i = 1; i < replicas.size(); i++)
+            rest.push_back(static_cast<std::string>(replicas[i]));
+        auto reply = m_node->chain_rpc.on(provider_handle(replicas[0], m_node->provider_id))(
+                             m_node->next_id(), key, src, std::uint64_t(src.size()),
+                             std::uint64_t(chunk_size), std::uint64_t(window), rest, true)
+                         .as<detail::bulk_forward_reply>();
+        if(!reply.error.empty())
+            throw exception("Chain replication failed: ", reply.error);
+        return static_cast<std::size_t>(reply.size);
+    }
+
+  private:
+
+    struct node {
+        prepare_type                 prepare;
+        complete_type                complete;
+        std::uint16_t                provider_id = 0;
+        remote_procedure             chain_rpc;
+        remote_procedure             ready_rpc;
+        detail::bulk_chain_transfers transfers;
+        std::atomic<std::uint64_t>   counter{std::random_device{}()};
+
+        std::uint64_t next_id() {
+            // ids only need to be unique among the transfers in flight
+            // on a replica; a random start avoids clashes between clients
+            return counter.fetch_add(0x9e3779b97f4a7c15ull, std::memory_order_relaxed);
+        }
+
+        detail::bulk_forward_reply relay(const request& req, std::uint64_t id,
+                                         const std::string& key, const bulk& src,
+                                         std::uint64_t size, std::uint64_t chunk_size,
+                                         std::uint64_t window,
+                                         const std::vector<std::string>& rest,
+                                         bool upstream_complete) {
+            detail::bulk_forward_reply      reply;
+            auto                            progress = transfers.get(id);
+            std::unique_ptr<async_response> downstream;
+            std::vector<async_response>     notices;
+            provider_handle                 next;
+            if(!progress) {
+                reply.error = "Chain transfer id was already used";
+                return reply;
+            }
+            if(upstream_complete) progress->advance(size);
+            try {
+                if(!prepare) throw exception("Replica has no prepare function");
+                bulk dest = prepare(key, size);
+                if(dest.size() < size)
+                    throw exception("Buffer prepared for ", key, " is too small");
+                if(!rest.empty()) {
+                    engine e(margo_hg_handle_get_instance(req.native_handle()));
+                    next = provider_handle(e.lookup(rest[0]), provider_id);
+                    std::vector<std::string> tail(rest.begin() + 1, rest.end());
+                    downstream = std::make_unique<async_response>(chain_rpc.on(next).async(
+                        id, key, dest, size, chunk_size, window, tail, false));
+                }
+                auto          remote = src.on(req.get_endpoint());
+                std::uint64_t done   = 0;
+                try {
+                    while(done < size) {
+                        std::uint64_t ready = progress->wait_beyond(done);
+                        remote.select(done, ready - done).pull_pipelined(
+                            dest.select(done, ready - done), chunk_size, window,
+                            [&](std::size_t offset, std::size_t n) {
+                                if(downstream)
+                                    notices.push_back(ready_rpc.on(next).async(
+                                        id, std::uint64_t(done + offset + n)));
+                            });
+                        done = ready;
+                    }
+                } catch(...) {
+                    // lets the next replica give up
+                    if(downstream)
+                        notices.push_back(ready_rpc.on(next).async(
+                            id, detail::bulk_chain_aborted));
+                    throw;
+                }
+                reply.size = size;
+                if(complete) complete(key, size);
+            } catch(const std::exception& ex) {
+                reply.error = static_cast<std::string>(engine(
+                    margo_hg_handle_get_instance(req.native_handle())).self()) + ": " + ex.what();
+            }
+            transfers.finish(id);
+            for(auto& notice : notices) {
+                try {
+                    notice.wait();
+                } catch(const std::exception&) {}
+            }
+            if(downstream) {
+                try {
+                    auto r = downstream->wait().as<detail::bulk_forward_reply>();
+                    if(reply.error.empty()) reply.error = r.error;
+                } catch(const std::exception& ex) {
+                    if(reply.error.empty()) reply.error = rest[0] + ": " + ex.what();
+                }
+            }
+            return reply;
+        }
+    };
+
+    std::shared_ptr<node> m_node;
+};
+
+} // namespace thallium
+
+#endif
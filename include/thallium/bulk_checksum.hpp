@@ -0,0 +1,146 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BULK_CHECKSUM_HPP
+#define __THALLIUM_BULK_CHECKSUM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <thallium/exception.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define THALLIUM_CRC32C_SSE42 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define THALLIUM_CRC32C_ARM 1
+#endif
+
+namespace thallium {
+
+/**
+ * Exception class thrown when the checksum of data received through
+ * a bulk transfer does not match the one provided by the sender.
+ */
+class checksum_exception : public exception {
+  public:
+    template <typename... Args>
+    checksum_exception(Args&&... args)
+    : exception(std::forward<Args>(args)...) {}
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Tables of the slicing-by-8 software implementation of CRC32C
+ * (Castagnoli polynomial, reflected).
+ */
+struct crc32c_tables {
+    std::uint32_t t[8][256];
+
+    crc32c_tables() noexcept {
+        for(std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t c = i;
+            for(int k = 0; k < 8; k++) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1u)));
+            t[0][i] = c;
+        }
+        for(std::uint32_t i = 0; i < 256; i++)
+            for(int s = 1; s < 8; s++) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+    }
+
+    static const crc32c_tables& get() noexcept {
+        static const crc32c_tables tables;
+        return tables;
+    }
+};
+
+inline std::uint32_t crc32c_software(std::uint32_t c, const unsigned char* p,
+                                     std::size_t n) noexcept {
+    const auto& t = crc32c_tables::get().t;
+    while(n >= 8) {
+        std::uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= c; // assumes a little-endian host, like the rest of the wire format
+        c = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff]
+          ^ t[4][lo >> 24] ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff]
+          ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        p += 8;
+        n -= 8;
+    }
+    while(n--) c = (c >> 8) ^ t[0][(c ^ *p++) & 0xff];
+    return c;
+}
+
+#ifdef THALLIUM_CRC32C_SSE42
+__attribute__((target("sse4.2")))
+inline std::uint32_t crc32c_hardware(std::uint32_t c, const unsigned char* p,
+                                     std::size_t n) noexcept {
+    std::uint64_t c64 = c;
+    while(n >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        c64 = _mm_crc32_u64(c64, word);
+        p += 8;
+        n -= 8;
+    }
+    c = static_cast<std::uint32_t>(c64);
+    while(n--) c = _mm_crc32_u8(c, *p++);
+    return c;
+}
+
+inline bool crc32c_hardware_available() noexcept {
+    static const bool available = __builtin_cpu_supports("sse4.2");
+    return available;
+}
+#elif defined(THALLIUM_CRC32C_ARM)
+inline std::uint32_t crc32c_hardware(std::uint32_t c, const unsigned char* p,
+                                     std::size_t n) noexcept {
+    while(n >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        c = __crc32cd(c, word);
+        p += 8;
+        n -= 8;
+    }
+    while(n--) c = __crc32cb(c, *p++);
+    return c;
+}
+
+inline bool crc32c_hardware_available() noexcept {
+    return true;
+}
+#endif
+
+} // namespace detail
+
+/**
+ * @brief Computes the CRC32C (Castagnoli) checksum of size bytes, using
+ * the SSE4.2 or ARMv8 CRC instructions when the CPU has them. Passing
+ * the checksum of a first buffer as crc continues it over a second one,
+ * so crc32c(b, nb, crc32c(a, na)) is the checksum of a followed by b.
+ *
+ * @param data Data to checksum.
+ * @param size Number of bytes.
+ * @param crc Checksum of the preceding data, if any.
+ *
+ * @return the checksum.
+ */
+inline std::uint32_t crc32c(const void* data, std::size_t size,
+                            std::uint32_t crc = 0) noexcept {
+    auto          p = static_cast<const unsigned char*>(data);
+    std::uint32_t c = ~crc;
+#if defined(THALLIUM_CRC32C_SSE42) || defined(THALLIUM_CRC32C_ARM)
+    if(detail::crc32c_hardware_available()) return ~detail::crc32c_hardware(c, p, size);
+#endif
+    return ~detail::crc32c_software(c, p, size);
+}
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BULK_FORWARD_HPP
+#define __THALLIUM_BULK_FORWARD_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/bulk.hpp>
+#include <thallium/bulk_mode.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_bulk.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/request.hpp>
+#include <thallium/serialization/stl/string.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+inline const char* bulk_forward_rpc_name() {
+    return "__thallium_bulk_forward__";
+}
+
+/**
+ * @private
+ * @brief Response of a process asked to forward a bulk: the size
+ * transferred, or the error that prevented it.
+ */
+struct bulk_forward_reply {
+    std::string   error;
+    std::uint64_t size = 0;
+
+    template <typename A> void serialize(A& ar) {
+        ar & error;
+        ar & size;
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief A bulk_forwarder transfers data between two remote buffers
+ * without going through the caller: given a remote_bulk exposed by a
+ * process A and one exposed by a process B, it sends A an RPC asking
+ * it to push the data directly to B, and returns once A reports that
+ * the transfer completed. Compared to pulling the data and pushing it
+ * again, this saves a network transfer and the caller's memory.
+ *
+ * Process A (the source) creates a bulk_forwarder with a function
+ * checking the memory it is asked to forward, which defines the RPC;
+ * callers create one without it. Nothing is required from process B.
+ *
+ * \code{.cpp}
+ * // on the servers, which only forward from their storage area
+ * tl::bulk_forwarder forwarder(engine, [&](const void* ptr, std::size_t size) {
+ *     return area.contains(ptr, size); });
+ * // on the client, src exposed by server A and dst by server B
+ * tl::bulk_forwarder forwarder(engine);
+ * std::size_t n = forwarder(src.on(server_a), dst.on(server_b));
+ * \endcode
+ *
+ * The source handle is sent back to the process that exposed it, which
+ * finds the memory it describes and exposes it again (through the bulk
+ * cache, if enabled, see engine::enable_bulk_cache) to push from it.
+ * Since the request names memory by its address, the check function
+ * is what prevents a caller from reading arbitrary memory of A; it may
+ * be null if all the callers are trusted.
+ */
+class bulk_forwarder {
+
+    remote_procedure m_rpc;
+    std::uint16_t    m_provider_id;
+
+    using check_type = std::function<bool(const void*, std::size_t)>;
+
+    static detail::bulk_forward_reply forward(margo_instance_id mid, const check_type& check,
+                                              const bulk& src, std::uint64_t src_offset,
+                                              std::uint64_t size, const bulk& dst,
+                                              std::uint64_t dst_offset,
+                                              const std::string& dst_address) {
+        detail::bulk_forward_reply reply;
+        try {
+            std::uint32_t          count = src.segment_count();
+            std::vector<void*>     ptrs(count);
+            std::vector<hg_size_t> sizes(count);
+            hg_uint32_t            actual = 0;
+            if(src.m_bulk == HG_BULK_NULL || size == 0)
+                throw exception("Nothing to forward");
+            hg_return_t ret = HG_Bulk_access(src.m_bulk, src_offset, size, HG_BULK_READ_ONLY,
+                                             count, ptrs.data(), sizes.data(), &actual);
+            MARGO_ASSERT(ret, HG_Bulk_access);
+            std::vector<std::pair<void*, std::size_t>> segments;
+            segments.reserve(actual);
+            for(hg_uint32_t i = 0; i < actual; i++) {
+                if(check && !check(ptrs[i], sizes[i]))
+                    throw exception("Forwarding this memory is not allowed");
+                segments.emplace_back(ptrs[i], sizes[i]);
+            }
+            engine e(mid);
+            bulk   local = e.expose(segments, bulk_mode::read_only);
+            auto   dest  = dst.on(e.lookup(dst_address)).select(dst_offset, size);
+            reply.size   = dest << local.select(0, size);
+        } catch(const std::exception& ex) {
+            reply.error = ex.what();
+        }
+        return reply;
+    }
+
+  public:
+
+    /**
+     * @brief Defines the forwarding RPC on a process exposing source
+     * buffers.
+     *
+     * @param e Engine of the process.
+     * @param check Function called with each range of memory to forward,
+     * returning false if it may not be read (null to accept any).
+     * @param provider_id Provider id of the RPC.
+     * @param p Pool in which the handlers run.
+     */
+    bulk_forwarder(engine& e, check_type check, std::uint16_t provider_id = 0,
+                   const pool& p = pool())
+    : m_provider_id(provider_id) {
+        std::function<void(const request&, const bulk&, std::uint64_t, std::uint64_t,
+                           const bulk&, std::uint64_t, const std::string&)>
+            handler = [check](const request& req, const bulk& src, std::uint64_t src_offset,
+                              std::uint64_t size, const bulk& dst, std::uint64_t dst_offset,
+                              const std::string& dst_address) {
+                req.respond(forward(margo_hg_handle_get_instance(req.native_handle()), check,
+                                    src, src_offset, size, dst, dst_offset, dst_address));
+            };
+        m_rpc = e.define(detail::bulk_forward_rpc_name(), std::move(handler), provider_id, p);
+    }
+
+    /**
+     * @brief Defines the forwarding RPC on a caller.
+     */
+    explicit bulk_forwarder(engine& e, std::uint16_t provider_id = 0)
+    : m_rpc(e.define(detail::bulk_forward_rpc_name()))
+    , m_provider_id(provider_id) {}
+
+    /**
+     * @brief Asks the process exposing src to push its data to dst.
+     * If the sizes don't match, the smallest size is used. Throws an
+     * exception if the transfer failed.
+     *
+     * @param src Source buffer, exposed by a process with a server
+     * bulk_forwarder.
+     * @param dst Destination buffer, exposed by any process.
+     *
+     * @return the size of data transferred.
+     */
+    std::size_t operator()(const remote_bulk& src, const remote_bulk& dst) const {
+        std::uint64_t size = std::min(src.size(), dst.size());
+        if(size == 0) return 0;
+        auto reply = m_rpc.on(provider_handle(src.m_endpoint, m_provider_id))(
+                              src.m_segment.m_bulk, std::uint64_t(src.m_segment.m_offset), size,
+                              dst.m_segment.m_bulk, std::uint64_t(dst.m_segment.m_offset),
+                              static_cast<std::string>(dst.m_endpoint))
+                         .as<detail::bulk_forward_reply>();
+        if(!reply.error.empty())
+            throw exception("Forwarding a bulk failed: ", reply.error);
+        return static_cast<std::size_t>(reply.size);
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -20,6 +20,26 @@ enum class bulk_mode : hg_uint32_t {
     write_only = HG_BULK_WRITE_ONLY
 };
 
+/**
+ * @brief memory_type indicates the kind of memory a bulk object
+ * exposes: host memory, or the memory of a CUDA, ROCm or Level Zero
+ * device (see engine::expose and device_bulk).
+ */
+enum class memory_type {
+    host,
+    cuda,
+    rocm,
+    ze
+};
+
+/**
+ * @brief Options of engine::expose_file.
+ */
+struct file_map_options {
+    bool populate   = false; /*!< fault the pages in when mapping (MAP_POPULATE) */
+    bool huge_pages = false; /*!< ask for transparent huge pages (MADV_HUGEPAGE) */
+};
+
 } // namespace thallium
 
 #endif
@@ -0,0 +1,448 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BULK_POOL_HPP
+#define __THALLIUM_BULK_POOL_HPP
+
+#include <abt.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <thallium/bulk.hpp>
+#include <thallium/bulk_mode.hpp>
+#include <thallium/condition_variable.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/huge_page_allocator.hpp>
+#include <thallium/mutex.hpp>
+#include <thallium/topology.hpp>
+
+namespace thallium {
+
+/**
+ * @brief A bulk_pool is a region of memory exposed once for RDMA and
+ * carved into fixed-size slabs of a few size classes. ULTs acquire
+ * leases on slabs to use as RDMA destinations or sources instead of
+ * allocating and exposing scratch buffers for each request.
+ *
+ * Released slabs are kept in a small free list local to the execution
+ * stream that released them, from which the same execution stream
+ * serves its next acquisitions without taking the pool's mutex (the
+ * local list is only guarded by an uncontended atomic flag, so that a
+ * ULT waiting for a slab can steal from other execution streams).
+ * Other slabs go through a shared free list protected by a mutex.
+ *
+ * The region is allocated like by a huge_page_allocator, so that large
+ * pools are backed by huge pages when the system provides them. On a
+ * machine with several NUMA nodes, the slabs of each size class are
+ * split into one arena per node, whose memory is placed on that node,
+ * and each execution stream acquires from the arena of its node (see
+ * topology::xstream_numa_node) first, so that handlers encode and
+ * decode into memory local to their socket whichever execution stream
+ * created the pool. Slabs are given back to the arena they belong to.
+ */
+class bulk_pool {
+
+  public:
+
+    /**
+     * @brief Description of a size class: count slabs of slab_size bytes.
+     */
+    struct size_class {
+        std::size_t slab_size;
+        std::size_t count;
+    };
+
+    /**
+     * @brief A lease on a slab of a bulk_pool. The slab is given back
+     * to the pool when the lease is destroyed or released.
+     */
+    class lease {
+
+        friend class bulk_pool;
+
+        bulk_pool*  m_pool  = nullptr;
+        std::size_t m_class = 0;
+        std::size_t m_slab  = 0;
+
+        lease(bulk_pool* p, std::size_t c, std::size_t slab)
+        : m_pool(p)
+        , m_class(c)
+        , m_slab(slab) {}
+
+      public:
+
+        /**
+         * @brief Creates an empty lease.
+         */
+        lease() = default;
+
+        lease(const lease&)            = delete;
+        lease& operator=(const lease&) = delete;
+
+        lease(lease&& other) noexcept
+        : m_pool(std::exchange(other.m_pool, nullptr))
+        , m_class(other.m_class)
+        , m_slab(other.m_slab) {}
+
+        lease& operator=(lease&& other) noexcept {
+            if(&other == this) return *this;
+            release();
+            m_pool  = std::exchange(other.m_pool, nullptr);
+            m_class = other.m_class;
+            m_slab  = other.m_slab;
+            return *this;
+        }
+
+        ~lease() {
+            release();
+        }
+
+        /**
+         * @brief Gives the slab back to the pool.
+         */
+        void release() {
+            if(m_pool) m_pool->give_back(m_class, m_slab);
+            m_pool = nullptr;
+        }
+
+        /**
+         * @brief Returns true if the lease holds a slab.
+         */
+        explicit operator bool() const {
+            return m_pool != nullptr;
+        }
+
+        /**
+         * @brief Pointer to the slab's memory.
+         */
+        void* data() const {
+            return m_pool->m_region.get() + offset();
+        }
+
+        /**
+         * @brief Size of the slab, which may be larger than requested.
+         */
+        std::size_t size() const {
+            return m_pool->m_classes[m_class].slab_size;
+        }
+
+        /**
+         * @brief Offset of the slab within the pool's bulk.
+         */
+        std::size_t offset() const {
+            return m_pool->slab_offset(m_class, m_slab);
+        }
+
+        /**
+         * @brief NUMA node the slab's memory was placed on, or -1 if
+         * the pool is not split per node.
+         */
+        int numa_node() const {
+            return m_pool->m_arena_nodes[m_pool->arena_of(m_class, m_slab)];
+        }
+
+        /**
+         * @brief Returns a bulk_segment covering the first size bytes
+         * of the slab (the whole slab by default), usable with
+         * remote_bulk::pull_to, operator>>, etc.
+         */
+        bulk_segment segment(std::size_t size = static_cast<std::size_t>(-1)) const {
+            return m_pool->m_bulk.select(offset(), std::min(size, this->size()));
+        }
+    };
+
+    /**
+     * @brief Constructor. Allocates and exposes the memory for all
+     * the slabs.
+     *
+     * @param e Engine used to expose the memory.
+     * @param classes Size classes.
+     * @param mode Access mode of the exposed memory.
+     * @param local_capacity Maximum number of slabs of each class kept in
+     * each execution stream's local free list.
+     * @param max_xstreams Number of execution streams (by rank) that get
+     * a local free list; others always use the shared list.
+     * @param per_numa_node Whether to split the slabs into one arena per
+     * NUMA node (the count of each size class is then divided among the
+     * nodes, rounded up). Ignored on machines with a single node.
+     */
+    bulk_pool(engine& e, std::vector<size_class> classes,
+              bulk_mode mode = bulk_mode::read_write,
+              std::size_t local_capacity = 8, std::size_t max_xstreams = 64,
+              bool per_numa_node = true)
+    : m_local_capacity(local_capacity) {
+        std::sort(classes.begin(), classes.end(),
+            [](const size_class& a, const size_class& b) {
+                return a.slab_size < b.slab_size;
+            });
+        if(per_numa_node && topology::get().num_numa_nodes() > 1)
+            m_arena_nodes = topology::get().numa_nodes();
+        else
+            m_arena_nodes.push_back(-1);
+        std::size_t arenas = m_arena_nodes.size();
+        for(auto& c : classes) {
+            class_info info;
+            // keep slabs cache-line aligned
+            info.slab_size = (c.slab_size + 63) & ~static_cast<std::size_t>(63);
+            info.count     = c.count;
+            info.per_arena = (c.count + arenas - 1) / arenas;
+            info.base      = m_arena_size;
+            info.free.resize(arenas);
+            for(std::size_t i = c.count; i-- > 0;)
+                info.free[i / info.per_arena].push_back(i);
+            m_arena_size += info.slab_size*info.per_arena;
+            m_classes.push_back(std::move(info));
+        }
+        if(m_arena_size == 0)
+            throw exception("bulk_pool created without any slab");
+        // arenas start on page boundaries so that each can be bound to
+        // its node before anything touches it
+        if(arenas > 1) m_arena_size = detail::huge_page_round_up(m_arena_size, huge_page_2mb);
+        std::size_t total = m_arena_size*arenas;
+        m_region.reset(static_cast<char*>(detail::huge_page_alloc(total, huge_page_2mb)));
+        if(arenas > 1) {
+            for(std::size_t a = 0; a < arenas; a++)
+                detail::numa_bind(m_region.get() + a*m_arena_size, m_arena_size,
+                                  m_arena_nodes[a]);
+        }
+        m_bulk = e.expose({{m_region.get(), total}}, mode);
+        m_num_locals = max_xstreams;
+        m_locals.reset(new local_lists[max_xstreams]);
+        for(std::size_t i = 0; i < m_num_locals; i++) {
+            m_locals[i].free.resize(m_classes.size());
+            for(auto& f : m_locals[i].free) f.reserve(m_local_capacity);
+        }
+    }
+
+    bulk_pool(const bulk_pool&)            = delete;
+    bulk_pool& operator=(const bulk_pool&) = delete;
+
+    /**
+     * @brief Destructor. All leases must have been released.
+     */
+    ~bulk_pool() = default;
+
+    /**
+     * @brief Returns the bulk object exposing the whole pool.
+     */
+    const bulk& get_bulk() const {
+        return m_bulk;
+    }
+
+    /**
+     * @brief Returns the size of the slabs of the largest size class.
+     */
+    std::size_t max_slab_size() const {
+        return m_classes.back().slab_size;
+    }
+
+    /**
+     * @brief Returns the NUMA nodes of the arenas, in the order of their
+     * memory in the pool's bulk, or {-1} if the pool is not split per node.
+     */
+    const std::vector<int>& numa_nodes() const {
+        return m_arena_nodes;
+    }
+
+    /**
+     * @brief Acquires a slab of at least size bytes, from the smallest
+     * size class that has one available, blocking the calling ULT until
+     * one is released if none is. Throws if size exceeds the largest
+     * size class.
+     */
+    lease acquire(std::size_t size) {
+        std::size_t c = class_for(size);
+        lease l = try_acquire_from(c);
+        if(l) return l;
+        std::size_t home = home_arena(self_lists());
+        std::unique_lock<mutex> lock(m_mutex);
+        m_waiters += 1;
+        while(true) {
+            std::size_t k, slab;
+            if(pop_shared(c, home, k, slab) || steal(c, k, slab)) {
+                m_waiters -= 1;
+                return lease(this, k, slab);
+            }
+            // a slab may land in a local list between steal() and
+            // the wait, hence the timeout
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 1000000;
+            if(deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec  += 1;
+                deadline.tv_nsec -= 1000000000;
+            }
+            m_cv.wait_until(lock, &deadline);
+        }
+    }
+
+    /**
+     * @brief Same as acquire but returns an empty lease instead of
+     * blocking if no slab is available.
+     */
+    lease try_acquire(std::size_t size) {
+        return try_acquire_from(class_for(size));
+    }
+
+  private:
+
+    struct class_info {
+        std::size_t slab_size = 0;
+        std::size_t count     = 0;
+        std::size_t per_arena = 0; // slabs [a*per_arena, (a+1)*per_arena) are in arena a
+        std::size_t base      = 0; // offset within an arena
+        // shared free lists, one per arena, protected by m_mutex
+        std::vector<std::vector<std::size_t>> free;
+    };
+
+    static constexpr std::size_t no_arena = static_cast<std::size_t>(-1);
+
+    struct local_lists {
+        std::atomic_flag                      busy = ATOMIC_FLAG_INIT;
+        std::vector<std::vector<std::size_t>> free; // one per size class
+        // arena of the owner's NUMA node, found on its first use
+        std::size_t                           arena = no_arena;
+        char padding[64];
+    };
+
+    struct region_deleter {
+        void operator()(char* p) const noexcept { detail::huge_page_free(p); }
+    };
+
+    std::unique_ptr<char, region_deleter> m_region;
+    bulk                                  m_bulk;
+    std::vector<class_info>               m_classes;
+    std::vector<int>                      m_arena_nodes;
+    std::size_t                           m_arena_size = 0;
+    std::unique_ptr<local_lists[]>        m_locals;
+    std::size_t                           m_num_locals = 0;
+    std::size_t                           m_local_capacity;
+    mutex                                 m_mutex;
+    condition_variable                    m_cv;
+    std::atomic<std::size_t>              m_waiters{0};
+
+    std::size_t class_for(std::size_t size) const {
+        for(std::size_t c = 0; c < m_classes.size(); c++) {
+            if(m_classes[c].slab_size >= size) return c;
+        }
+        throw exception("bulk_pool: requested size exceeds the largest size class");
+    }
+
+    local_lists* self_lists() {
+        int rank;
+        if(ABT_xstream_self_rank(&rank) != ABT_SUCCESS
+        || rank < 0 || static_cast<std::size_t>(rank) >= m_num_locals)
+            return nullptr;
+        auto& l = m_locals[rank];
+        if(l.arena == no_arena) l.arena = current_arena();
+        return &l;
+    }
+
+    std::size_t current_arena() const {
+        if(m_arena_nodes.size() == 1) return 0;
+        int node = topology::xstream_numa_node();
+        for(std::size_t a = 0; a < m_arena_nodes.size(); a++)
+            if(m_arena_nodes[a] == node) return a;
+        return 0;
+    }
+
+    std::size_t home_arena(local_lists* local) const {
+        return local ? local->arena : current_arena();
+    }
+
+    std::size_t arena_of(std::size_t c, std::size_t slab) const {
+        return slab / m_classes[c].per_arena;
+    }
+
+    std::size_t slab_offset(std::size_t c, std::size_t slab) const {
+        const auto& info  = m_classes[c];
+        std::size_t arena = slab / info.per_arena;
+        return arena*m_arena_size + info.base + (slab - arena*info.per_arena)*info.slab_size;
+    }
+
+    static bool pop_from(std::vector<std::vector<std::size_t>>& lists,
+                         std::size_t c, std::size_t& k, std::size_t& slab) {
+        for(k = c; k < lists.size(); k++) {
+            if(!lists[k].empty()) {
+                slab = lists[k].back();
+                lists[k].pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // must be called with m_mutex held; prefers the home arena, then
+    // the others in order
+    bool pop_shared(std::size_t c, std::size_t home, std::size_t& k, std::size_t& slab) {
+        std::size_t arenas = m_arena_nodes.size();
+        for(std::size_t i = 0; i < arenas; i++) {
+            std::size_t a = (home + i) % arenas;
+            for(k = c; k < m_classes.size(); k++) {
+                auto& f = m_classes[k].free[a];
+                if(!f.empty()) {
+                    slab = f.back();
+                    f.pop_back();
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool steal(std::size_t c, std::size_t& k, std::size_t& slab) {
+        for(std::size_t i = 0; i < m_num_locals; i++) {
+            auto& l = m_locals[i];
+            // owners never yield while holding the flag, so this is short
+            while(l.busy.test_and_set(std::memory_order_acquire)) {}
+            bool found = pop_from(l.free, c, k, slab);
+            l.busy.clear(std::memory_order_release);
+            if(found) return true;
+        }
+        return false;
+    }
+
+    lease try_acquire_from(std::size_t c) {
+        std::size_t k, slab;
+        auto local = self_lists();
+        if(local && !local->busy.test_and_set(std::memory_order_acquire)) {
+            bool found = pop_from(local->free, c, k, slab);
+            local->busy.clear(std::memory_order_release);
+            if(found) return lease(this, k, slab);
+        }
+        std::size_t home = home_arena(local);
+        std::lock_guard<mutex> lock(m_mutex);
+        if(pop_shared(c, home, k, slab)) return lease(this, k, slab);
+        return lease();
+    }
+
+    void give_back(std::size_t c, std::size_t slab) {
+        std::size_t arena = arena_of(c, slab);
+        if(m_waiters.load() == 0) {
+            auto local = self_lists();
+            // slabs of other nodes go back to their arena
+            if(local && local->arena == arena
+            && !local->busy.test_and_set(std::memory_order_acquire)) {
+                bool kept = local->free[c].size() < m_local_capacity;
+                if(kept) local->free[c].push_back(slab);
+                local->busy.clear(std::memory_order_release);
+                if(kept) return;
+            }
+        }
+        std::lock_guard<mutex> lock(m_mutex);
+        m_classes[c].free[arena].push_back(slab);
+        m_cv.notify_all();
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BULK_REAPER_HPP
+#define __THALLIUM_BULK_REAPER_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Deferred release of bulk handles, attached to a margo instance
+ * by engine::enable_deferred_bulk_free. Handles released by bulk objects
+ * are queued, and a ULT created in the reaper's pool when the queue
+ * stops being empty frees them in a batch, after the work already
+ * queued in that pool (e.g. the handler responding). At most
+ * max_pending handles are queued; beyond that, they are freed by the
+ * caller as if deferral was disabled.
+ */
+class bulk_reaper : public std::enable_shared_from_this<bulk_reaper>,
+                    public per_instance<bulk_reaper> {
+
+    struct item {
+        hg_bulk_t             handle;
+        std::shared_ptr<void> storage; // released after the handle
+    };
+
+    ABT_pool          m_pool;
+    std::size_t       m_max_pending;
+    std::mutex        m_mutex;
+    std::vector<item> m_queue;
+    bool              m_scheduled = false;
+    bool              m_closed    = false;
+
+    std::atomic<std::uint64_t> m_deferred{0};
+    std::atomic<std::uint64_t> m_batches{0};
+
+    static void run(void* arg) {
+        std::unique_ptr<std::shared_ptr<bulk_reaper>> self(
+            static_cast<std::shared_ptr<bulk_reaper>*>(arg));
+        (*self)->drain();
+    }
+
+    void drain() {
+        std::vector<item> batch;
+        for(;;) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if(m_queue.empty()) {
+                    m_scheduled = false;
+                    return;
+                }
+                batch.swap(m_queue);
+            }
+            for(auto& i : batch) margo_bulk_free(i.handle);
+            batch.clear();
+            m_batches.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+  public:
+
+    bulk_reaper(ABT_pool pool, std::size_t max_pending)
+    : m_pool(pool)
+    , m_max_pending(max_pending) {}
+
+    bulk_reaper(const bulk_reaper&)            = delete;
+    bulk_reaper& operator=(const bulk_reaper&) = delete;
+
+    /**
+     * @brief Queues a handle (and the storage it keeps alive) to be
+     * freed later. Returns false if the handle must be freed by the
+     * caller (queue full, or reaper closed).
+     */
+    bool defer(hg_bulk_t handle, std::shared_ptr<void>& storage) {
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_closed || m_queue.size() >= m_max_pending) return false;
+            m_queue.push_back(item{handle, std::move(storage)});
+            schedule    = !m_scheduled;
+            m_scheduled = true;
+        }
+        m_deferred.fetch_add(1, std::memory_order_relaxed);
+        if(!schedule) return true;
+        auto* arg = new std::shared_ptr<bulk_reaper>(shared_from_this());
+        if(ABT_thread_create(m_pool, &bulk_reaper::run, arg, ABT_THREAD_ATTR_NULL, nullptr)
+           != ABT_SUCCESS) {
+            // nothing will drain the queue: drain it here
+            delete arg;
+            drain();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Frees the queued handles and refuses new ones.
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        drain();
+    }
+
+    std::uint64_t deferred() const { return m_deferred.load(std::memory_order_relaxed); }
+
+    std::uint64_t batches() const { return m_batches.load(std::memory_order_relaxed); }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
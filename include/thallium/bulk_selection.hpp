@@ -0,0 +1,187 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BULK_SELECTION_HPP
+#define __THALLIUM_BULK_SELECTION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace thallium {
+
+/**
+ * @brief A bulk_selection describes a non-contiguous transfer between a
+ * remote_bulk and a local bulk, as a list of blocks, each block being
+ * copied from an offset in the remote_bulk to an offset in the local bulk.
+ * Blocks can be given one by one or as strided patterns (count blocks
+ * of blocklen bytes, separated by a stride on each side) that are
+ * stored as such rather than expanded into a list.
+ *
+ * A bulk_selection is transfered in one call with
+ * remote_bulk::pull_to(local, selection) or
+ * remote_bulk::push_from(local, selection), which issue all the RDMA
+ * operations concurrently. Blocks that are contiguous on both sides
+ * are merged into a single operation.
+ */
+class bulk_selection {
+
+  public:
+
+    /**
+     * @brief A strided pattern of count blocks of blocklen bytes.
+     * Block i is at remote_offset + i*remote_stride in the remote_bulk
+     * and at local_offset + i*local_stride in the local bulk.
+     */
+    struct pattern {
+        std::size_t remote_offset;
+        std::size_t local_offset;
+        std::size_t blocklen;
+        std::size_t count;
+        std::size_t remote_stride;
+        std::size_t local_stride;
+    };
+
+    bulk_selection() = default;
+
+    /**
+     * @brief Adds a single block.
+     *
+     * @param remote_offset Offset of the block in the remote_bulk.
+     * @param local_offset Offset of the block in the local bulk.
+     * @param size Size of the block.
+     *
+     * @return a reference to this bulk_selection.
+     */
+    bulk_selection& add(std::size_t remote_offset, std::size_t local_offset,
+                        std::size_t size) {
+        return add_strided(remote_offset, local_offset, 1, size, size, size);
+    }
+
+    /**
+     * @brief Adds count blocks of blocklen bytes.
+     *
+     * @param remote_offset Offset of the first block in the remote_bulk.
+     * @param local_offset Offset of the first block in the local bulk.
+     * @param count Number of blocks.
+     * @param blocklen Size of each block.
+     * @param remote_stride Distance between the starts of consecutive
+     * blocks in the remote_bulk.
+     * @param local_stride Distance between the starts of consecutive
+     * blocks in the local bulk.
+     *
+     * @return a reference to this bulk_selection.
+     */
+    bulk_selection& add_strided(std::size_t remote_offset, std::size_t local_offset,
+                                std::size_t count, std::size_t blocklen,
+                                std::size_t remote_stride, std::size_t local_stride) {
+        if(count == 0 || blocklen == 0) return *this;
+        // a pattern contiguous on both sides is a single block
+        if(count > 1 && remote_stride == blocklen && local_stride == blocklen) {
+            blocklen *= count;
+            count = 1;
+        }
+        if(count == 1) {
+            remote_stride = local_stride = blocklen;
+            // extend the previous block if this one follows it on both sides
+            if(!m_patterns.empty()) {
+                auto& last = m_patterns.back();
+                if(last.count == 1
+                && last.remote_offset + last.blocklen == remote_offset
+                && last.local_offset + last.blocklen == local_offset) {
+                    last.blocklen += blocklen;
+                    last.remote_stride = last.local_stride = last.blocklen;
+                    m_size += blocklen;
+                    return *this;
+                }
+            }
+        }
+        m_patterns.push_back(pattern{remote_offset, local_offset, blocklen,
+                                     count, remote_stride, local_stride});
+        m_size += count*blocklen;
+        m_num_blocks += count;
+        return *this;
+    }
+
+    /**
+     * @brief Adds count blocks of blocklen bytes, separated by the same
+     * stride on both sides.
+     */
+    bulk_selection& add_strided(std::size_t remote_offset, std::size_t local_offset,
+                                std::size_t count, std::size_t blocklen,
+                                std::size_t stride) {
+        return add_strided(remote_offset, local_offset, count, blocklen, stride, stride);
+    }
+
+    /**
+     * @brief Returns the patterns making up the selection.
+     */
+    const std::vector<pattern>& patterns() const {
+        return m_patterns;
+    }
+
+    /**
+     * @brief Returns the total number of bytes selected.
+     */
+    std::size_t size() const {
+        return m_size;
+    }
+
+    /**
+     * @brief Returns the number of RDMA operations needed to transfer
+     * the selection.
+     */
+    std::size_t num_blocks() const {
+        return m_num_blocks;
+    }
+
+    /**
+     * @brief Returns true if nothing is selected.
+     */
+    bool empty() const {
+        return m_patterns.empty();
+    }
+
+    /**
+     * @brief Returns the offset following the last byte selected in the
+     * remote_bulk.
+     */
+    std::size_t remote_extent() const {
+        std::size_t e = 0;
+        for(auto& p : m_patterns)
+            e = std::max(e, p.remote_offset + (p.count-1)*p.remote_stride + p.blocklen);
+        return e;
+    }
+
+    /**
+     * @brief Returns the offset following the last byte selected in the
+     * local bulk.
+     */
+    std::size_t local_extent() const {
+        std::size_t e = 0;
+        for(auto& p : m_patterns)
+            e = std::max(e, p.local_offset + (p.count-1)*p.local_stride + p.blocklen);
+        return e;
+    }
+
+    /**
+     * @brief Removes all the blocks.
+     */
+    void clear() {
+        m_patterns.clear();
+        m_size       = 0;
+        m_num_blocks = 0;
+    }
+
+  private:
+
+    std::vector<pattern> m_patterns;
+    std::size_t          m_size       = 0;
+    std::size_t          m_num_blocks = 0;
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BULK_TRAFFIC_HPP
+#define __THALLIUM_BULK_TRAFFIC_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <margo.h>
+#include <thallium/admission.hpp>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Bytes moved by the bulk transfers issued through an engine,
+ * counted while a metrics_exporter is attached to it.
+ */
+struct bulk_traffic_stats {
+    std::uint64_t pulls        = 0; /*!< number of pull operations */
+    std::uint64_t pushes       = 0; /*!< number of push operations */
+    std::uint64_t pulled_bytes = 0; /*!< bytes pulled from remote memory */
+    std::uint64_t pushed_bytes = 0; /*!< bytes pushed to remote memory */
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Bulk transfer counters of the margo instances for which
+ * counting was enabled. Recording costs a relaxed load when no
+ * instance counts, and a lookup and two relaxed increments otherwise.
+ */
+class bulk_traffic : public per_instance<bulk_traffic> {
+
+    std::atomic<std::uint64_t> m_pulls{0};
+    std::atomic<std::uint64_t> m_pushes{0};
+    std::atomic<std::uint64_t> m_pulled_bytes{0};
+    std::atomic<std::uint64_t> m_pushed_bytes{0};
+
+  public:
+
+    /**
+     * @brief Starts counting the transfers of a margo instance (until it
+     * is finalized).
+     */
+    static void enable(margo_instance_id mid) {
+        get(mid, instance_release::at_finalize);
+    }
+
+    /**
+     * @brief Counts a transfer that was issued. Pulls issued by an RPC
+     * handler are also charged to the request's admission_limit, if it
+     * has a byte budget.
+     */
+    static void record(margo_instance_id mid, hg_bulk_op_t op, std::size_t size) {
+        if(op == HG_BULK_PULL) admission_charge_scope::add_pulled(size);
+        auto t = find(mid);
+        if(!t) return;
+        if(op == HG_BULK_PULL) {
+            t->m_pulls.fetch_add(1, std::memory_order_relaxed);
+            t->m_pulled_bytes.fetch_add(size, std::memory_order_relaxed);
+        } else {
+            t->m_pushes.fetch_add(1, std::memory_order_relaxed);
+            t->m_pushed_bytes.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+
+    static bulk_traffic_stats snapshot(margo_instance_id mid) {
+        bulk_traffic_stats s;
+        auto t = find(mid);
+        if(!t) return s;
+        s.pulls        = t->m_pulls.load(std::memory_order_relaxed);
+        s.pushes       = t->m_pushes.load(std::memory_order_relaxed);
+        s.pulled_bytes = t->m_pulled_bytes.load(std::memory_order_relaxed);
+        s.pushed_bytes = t->m_pushed_bytes.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,248 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BULK_WRITE_COMBINER_HPP
+#define __THALLIUM_BULK_WRITE_COMBINER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/bulk.hpp>
+#include <thallium/bulk_mode.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/margo_exception.hpp>
+#include <thallium/remote_bulk.hpp>
+
+namespace thallium {
+
+/**
+ * @brief A bulk_write_combiner coalesces many small pushes to a
+ * remote_bulk into few RDMA transfers. Writes are copied into a staging
+ * buffer exposed once, covering a window of buffer_size bytes of the
+ * remote region that starts at the first write after a flush; adjacent
+ * and overlapping writes merge into a single extent, and all the
+ * extents of the window are pushed concurrently when it is flushed.
+ *
+ * \code{.cpp}
+ * tl::bulk_write_combiner out(engine, checkpoint.on(server));
+ * for(auto& field : fields)
+ *     out.write(field.offset, field.data, field.size);
+ * out.flush();
+ * \endcode
+ *
+ * The window is flushed when a write falls outside it, when it holds
+ * max_extents separate extents, on flush(), and on destruction (errors
+ * are then ignored; call flush() to get them). Writes of at least
+ * direct_threshold bytes are not staged: the window is flushed and they
+ * are pushed directly. Since a later write to the same range replaces
+ * the staged bytes, and flushes complete before further transfers are
+ * issued, the remote region ends up as if the writes were pushed one
+ * by one, in order. A bulk_write_combiner must not be used by several
+ * ULTs concurrently.
+ */
+class bulk_write_combiner {
+
+  public:
+
+    /**
+     * @brief Parameters of a bulk_write_combiner.
+     */
+    struct options {
+        std::size_t buffer_size      = 1024 * 1024; /*!< size of the staging buffer */
+        std::size_t direct_threshold = 64 * 1024;   /*!< size of writes pushed without staging */
+        std::size_t max_extents      = 64;          /*!< separate extents staged at most */
+    };
+
+    /**
+     * @brief Constructor. Allocates and exposes the staging buffer.
+     *
+     * @param e Engine used to expose the staging buffer.
+     * @param target Remote region to write to.
+     * @param opts Options.
+     */
+    bulk_write_combiner(engine& e, remote_bulk target, options opts)
+    : m_target(std::move(target))
+    , m_opts(opts)
+    , m_buffer(std::max<std::size_t>(opts.buffer_size, 1)) {
+        m_opts.buffer_size      = m_buffer.size();
+        m_opts.direct_threshold = std::min(m_opts.direct_threshold, m_opts.buffer_size);
+        if(m_opts.max_extents == 0) m_opts.max_extents = 1;
+        std::vector<std::pair<void*, std::size_t>> segments{{m_buffer.data(), m_buffer.size()}};
+        m_staging = e.expose(segments, bulk_mode::read_only);
+    }
+
+    /**
+     * @brief Constructor with the default options.
+     */
+    bulk_write_combiner(engine& e, remote_bulk target)
+    : bulk_write_combiner(e, std::move(target), options()) {}
+
+    bulk_write_combiner(const bulk_write_combiner&)            = delete;
+    bulk_write_combiner& operator=(const bulk_write_combiner&) = delete;
+
+    /**
+     * @brief Destructor. Flushes the staged writes, ignoring errors.
+     */
+    ~bulk_write_combiner() {
+        try {
+            flush();
+        } catch(...) {}
+    }
+
+    /**
+     * @brief Writes size bytes from data at the given offset of the
+     * remote region.
+     */
+    void write(std::size_t offset, const void* data, std::size_t size) {
+        check_range(offset, size);
+        if(size == 0) return;
+        m_writes += 1;
+        if(size >= m_opts.direct_threshold) {
+            flush();
+            std::size_t done = 0;
+            while(done < size) {
+                std::size_t n = std::min(size - done, m_opts.buffer_size);
+                std::memcpy(m_buffer.data(), static_cast<const char*>(data) + done, n);
+                transfer(offset + done, 0, n);
+                done += n;
+            }
+            return;
+        }
+        std::memcpy(stage(offset, size), data, size);
+    }
+
+    /**
+     * @brief Writes the content of a local bulk_segment at the given
+     * offset of the remote region.
+     */
+    void write(std::size_t offset, const bulk_segment& src) {
+        check_range(offset, src.m_size);
+        if(src.m_size == 0) return;
+        if(src.m_size >= m_opts.direct_threshold) {
+            m_writes += 1;
+            flush();
+            m_target.select(offset, src.m_size) << src;
+            m_transfers += 1;
+            return;
+        }
+        m_writes += 1;
+        char*       dst  = stage(offset, src.m_size);
+        std::size_t from = src.m_offset;
+        std::size_t left = src.m_size;
+        void*       ptrs[16];
+        hg_size_t   sizes[16];
+        hg_uint32_t count = 0;
+        while(left > 0) {
+            hg_return_t ret = HG_Bulk_access(src.m_bulk.m_bulk, from, left, HG_BULK_READ_ONLY,
+                                             16, ptrs, sizes, &count);
+            MARGO_ASSERT(ret, HG_Bulk_access);
+            if(count == 0) throw exception("Invalid bulk segment");
+            for(hg_uint32_t i = 0; i < count && left > 0; i++) {
+                std::size_t n = std::min<std::size_t>(sizes[i], left);
+                std::memcpy(dst, ptrs[i], n);
+                dst  += n;
+                from += n;
+                left -= n;
+            }
+        }
+    }
+
+    /**
+     * @brief Pushes the staged writes and waits for the transfers to
+     * complete.
+     */
+    void flush() {
+        if(m_extents.empty()) return;
+        std::vector<async_bulk_op> ops;
+        ops.reserve(m_extents.size());
+        for(auto& x : m_extents) {
+            ops.push_back(m_target.select(m_base + x.first, x.second - x.first)
+                              .push_from(m_staging.select(x.first, x.second - x.first)));
+        }
+        m_transfers += ops.size();
+        m_extents.clear();
+        for(auto& op : ops) op.wait();
+    }
+
+    /**
+     * @brief Number of writes so far.
+     */
+    std::size_t writes() const {
+        return m_writes;
+    }
+
+    /**
+     * @brief Number of RDMA transfers issued so far.
+     */
+    std::size_t transfers() const {
+        return m_transfers;
+    }
+
+  private:
+
+    remote_bulk       m_target;
+    options           m_opts;
+    std::vector<char> m_buffer;
+    bulk              m_staging;
+    // remote offset of the start of the window
+    std::size_t       m_base = 0;
+    // sorted, disjoint, non-adjacent [begin, end) ranges of the window
+    std::vector<std::pair<std::size_t, std::size_t>> m_extents;
+    std::size_t       m_writes    = 0;
+    std::size_t       m_transfers = 0;
+
+    void check_range(std::size_t offset, std::size_t size) const {
+        if(offset > m_target.size() || size > m_target.size() - offset)
+            throw exception("bulk_write_combiner: write of ", size, " bytes at offset ",
+                            offset, " exceeds the remote region");
+    }
+
+    void transfer(std::size_t remote_offset, std::size_t offset, std::size_t size) {
+        m_target.select(remote_offset, size) << m_staging.select(offset, size);
+        m_transfers += 1;
+    }
+
+    // records [offset, offset+size) in the window, flushing it first if
+    // needed, and returns where to copy the data
+    char* stage(std::size_t offset, std::size_t size) {
+        if(!m_extents.empty()
+        && (offset < m_base || offset + size - m_base > m_opts.buffer_size))
+            flush();
+        if(m_extents.empty()) m_base = offset;
+        std::size_t begin = offset - m_base;
+        std::size_t end   = begin + size;
+        auto it = std::lower_bound(m_extents.begin(), m_extents.end(), begin,
+            [](const std::pair<std::size_t, std::size_t>& x, std::size_t b) {
+                return x.second < b;
+            });
+        // it is the first extent ending at or after begin: merge the
+        // extents it overlaps or touches
+        auto last = it;
+        while(last != m_extents.end() && last->first <= end) {
+            begin = std::min(begin, last->first);
+            end   = std::max(end, last->second);
+            ++last;
+        }
+        if(it == last) {
+            if(m_extents.size() >= m_opts.max_extents) {
+                flush();
+                return stage(offset, size);
+            }
+            m_extents.insert(it, {begin, end});
+        } else {
+            *it = {begin, end};
+            m_extents.erase(it + 1, last);
+        }
+        return m_buffer.data() + (offset - m_base);
+    }
+};
+
+} // namespace thallium
+
+#endif
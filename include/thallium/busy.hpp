@@ -0,0 +1,72 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_BUSY_HPP
+#define __THALLIUM_BUSY_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <margo.h>
+#include <thallium/async_respond.hpp>
+#include <thallium/proc_object.hpp>
+
+namespace thallium {
+
+/**
+ * @brief This exception is thrown when a server rejected an RPC
+ * because of its admission limit (see admission_limit).
+ */
+class busy : public std::exception {
+  public:
+    virtual const char* what() const throw() { return "Server is busy"; }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Payload of a busy response. Only responses of exactly this
+ * size are inspected by clients.
+ */
+constexpr std::uint64_t busy_marker_0 = 0x74686c6d62757379ull;
+constexpr std::uint64_t busy_marker_1 = 0x9e3779b97f4a7c15ull;
+
+/**
+ * @private
+ * @brief Sends a busy response without blocking (called from the
+ * progress loop), as request::respond_detached does.
+ */
+inline void respond_busy(hg_handle_t handle) {
+    meta_proc_fn mproc = [](hg_proc_t proc) {
+        if(hg_proc_get_op(proc) != HG_ENCODE) return HG_SUCCESS;
+        std::uint64_t marker[2] = {busy_marker_0, busy_marker_1};
+        return hg_proc_memcpy(proc, marker, sizeof(marker));
+    };
+    respond_detached(handle, &mproc);
+}
+
+/**
+ * @private
+ * @brief Returns true if the response received on a handle is a busy
+ * response.
+ */
+inline bool is_busy_response(hg_handle_t handle) {
+    if(HG_Get_output_payload_size(handle) != 2*sizeof(std::uint64_t)) return false;
+    std::uint64_t marker[2] = {0, 0};
+    meta_proc_fn  mproc     = [&marker](hg_proc_t proc) {
+        if(hg_proc_get_op(proc) != HG_DECODE) return HG_SUCCESS;
+        return hg_proc_memcpy(proc, marker, sizeof(marker));
+    };
+    if(margo_get_output(handle, &mproc) != HG_SUCCESS) return false;
+    margo_free_output(handle, &mproc);
+    return marker[0] == busy_marker_0 && marker[1] == busy_marker_1;
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
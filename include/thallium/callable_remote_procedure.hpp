@@ -10,13 +10,21 @@
 #include <cstdint>
 #include <margo.h>
 #include <thallium/async_response.hpp>
+#include <thallium/busy.hpp>
+#include <thallium/cancellation.hpp>
+#include <thallium/expected.hpp>
+#include <thallium/flow_control.hpp>
+#include <thallium/handle_cache.hpp>
+#include <thallium/local_dispatch.hpp>
 #include <thallium/margo_exception.hpp>
 #include <thallium/packed_data.hpp>
+#include <thallium/proc_size_hints.hpp>
 #include <thallium/serialization/proc_output_archive.hpp>
 #include <thallium/serialization/serialize.hpp>
 #include <thallium/timeout.hpp>
 #include <thallium/margo_instance_ref.hpp>
 #include <thallium/reference_util.hpp>
+#include <thallium/rpc_stats.hpp>
 #include <tuple>
 #include <utility>
 
@@ -25,6 +33,7 @@ namespace thallium {
 class engine;
 class remote_procedure;
 class endpoint;
+template <typename T> class response_stream;
 
 /**
  * @brief callable_remote_procedure_with_context objects represent an RPC
@@ -40,10 +49,26 @@ class callable_remote_procedure_with_context {
 
   private:
     margo_instance_ref            m_mid;
-    hg_handle_t                   m_handle;
+    // created when first needed if the endpoint is the engine itself
+    // (see ensure_handle)
+    mutable hg_handle_t           m_handle = HG_HANDLE_NULL;
     bool                          m_ignore_response;
     uint16_t                      m_provider_id;
     mutable std::tuple<CtxArg...> m_context;
+    // handle cache the handle should be returned to, if any
+    std::shared_ptr<detail::handle_cache> m_cache;
+    mutable hg_addr_t             m_cache_addr = HG_ADDR_NULL;
+    mutable hg_id_t               m_cache_id   = 0;
+    // id of the RPC as registered, which margo may change on the
+    // handle when forwarding to a provider
+    hg_id_t                       m_rpc_id     = 0;
+    // congestion window of the endpoint and retry policy, if any
+    std::shared_ptr<detail::aimd_window> m_window;
+    retry_policy                  m_retry;
+    // whether the RPC carries a detail::rpc_control
+    bool                          m_control    = false;
+    // set if the endpoint is the engine itself and local dispatch is enabled
+    std::shared_ptr<detail::local_dispatch> m_local;
 
     callable_remote_procedure_with_context(
             margo_instance_ref mid,
@@ -81,72 +106,293 @@ class callable_remote_procedure_with_context {
     : m_mid(std::move(mid))
     , m_ignore_response(ignore_resp)
     , m_provider_id(provider_id)
-    , m_context(context) {
+    , m_context(context)
+    , m_rpc_id(id)
+    , m_control(detail::rpc_control_registry::enabled(m_mid, id)) {
         m_ignore_response = ignore_resp;
-        hg_return_t ret = margo_create(m_mid, ep.m_addr, id, &m_handle);
-        MARGO_ASSERT(ret, margo_create);
+        m_cache = detail::handle_cache::find(m_mid);
+        m_local = detail::local_dispatch::find(m_mid);
+        if(m_local && !m_local->is_self(ep.m_addr)) m_local.reset();
+        // calls the engine runs in the caller's ULT need no handle
+        if(!m_local) create_handle(ep.m_addr);
+    }
+
+    void create_handle(hg_addr_t addr) const {
+        if(m_cache) {
+            m_handle     = m_cache->acquire(addr, m_rpc_id);
+            m_cache_addr = addr;
+            m_cache_id   = m_rpc_id;
+        } else {
+            hg_return_t ret = margo_create(m_mid, addr, m_rpc_id, &m_handle);
+            MARGO_ASSERT(ret, margo_create);
+        }
+    }
+
+    /**
+     * @brief Creates the handle of an RPC the engine sends to itself,
+     * which is only needed once the RPC goes through Mercury.
+     */
+    void ensure_handle() const {
+        if(m_handle == HG_HANDLE_NULL && m_local) create_handle(m_local->self());
+    }
+
+    /**
+     * @brief Releases the reference this object holds on its handle,
+     * giving the handle back to the engine's handle cache if this
+     * was the last reference to it.
+     */
+    hg_return_t release_handle() {
+        hg_handle_t h = std::exchange(m_handle, HG_HANDLE_NULL);
+        if(h == HG_HANDLE_NULL)
+            return HG_SUCCESS;
+        if(m_cache && HG_Ref_get(h) == 1
+        && m_cache->release(m_cache_addr, m_cache_id, h))
+            return HG_SUCCESS;
+        return margo_destroy(h);
+    }
+
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    hg_id_t registered_id() const {
+        if(m_rpc_id != 0) return m_rpc_id;
+        const struct hg_info* info = margo_get_info(m_handle);
+        return info ? info->id : 0;
+    }
+
+    std::shared_ptr<detail::rpc_metrics> stats_metrics() const {
+        hg_id_t id = registered_id();
+        if(id == 0 || !detail::rpc_stats_registry::any_enabled()) return nullptr;
+        auto reg = detail::rpc_stats_registry::find(m_mid);
+        if(!reg || !reg->enabled()) return nullptr;
+        return reg->client(id, m_provider_id);
+    }
+#endif
+
+    /**
+     * @brief Returns the control information of the RPC sent now, if it
+     * carries some, and sets trace to the context of its client-side
+     * span: a child of the ULT's current trace, or the root of a new
+     * trace if it has none.
+     */
+    detail::rpc_control make_control(double timeout_ms, bool cancellable,
+                                     trace_context& trace) const {
+        detail::rpc_control control;
+        if(!m_control) return control;
+        if(cancellable) control.token = detail::new_rpc_token();
+        control.deadline = detail::rpc_deadline_after(timeout_ms);
+        trace_context current = current_trace();
+        trace = current.valid() ? current.child() : trace_context::new_root();
+        control.set_trace(trace);
+        return control;
+    }
+
+    /**
+     * @brief Appends the control information after the arguments if the
+     * RPC carries it and the arguments were encoded successfully.
+     */
+    hg_return_t encode_control(hg_proc_t proc, hg_return_t ret,
+                               detail::rpc_control& control) const {
+        if(ret != HG_SUCCESS || !m_control) return ret;
+        return detail::proc_rpc_control(proc, control);
+    }
+
+    /**
+     * @brief Calls send(result) (which sends the RPC once) within a slot
+     * of the endpoint's concurrency_limiter window, if any, and calls it
+     * again after a backoff if it returns HG_BUSY or HG_TIMEOUT and the
+     * retry_policy allows it.
+     */
+    template <typename F>
+    expected<packed_data<>> forward_with_flow_control(F&& send) const {
+        for(unsigned attempt = 1;; ++attempt) {
+            detail::flow_slot slot(m_window);
+            packed_data<>     result;
+            hg_return_t       ret = send(result);
+            if(ret == HG_SUCCESS) {
+                slot.release(detail::flow_outcome::success);
+                return expected<packed_data<>>(std::move(result));
+            }
+            if(ret != HG_TIMEOUT && ret != HG_BUSY)
+                return expected<packed_data<>>::failure(ret);
+            slot.release(detail::flow_outcome::overloaded);
+            if(!m_retry.should_retry(attempt, ret == HG_TIMEOUT))
+                return expected<packed_data<>>::failure(ret);
+            double ms = m_retry.backoff_ms(attempt);
+            if(ms > 0.0) margo_thread_sleep(m_mid, ms);
+        }
+    }
+
+    /**
+     * @brief Returns the state an async_response needs to release its
+     * slot and retry, or nullptr if neither a concurrency_limiter nor a
+     * retry_policy is used.
+     */
+    std::shared_ptr<detail::flow_call> make_flow_call(double timeout_ms) const {
+        if(!m_window && m_retry.max_attempts <= 1) return nullptr;
+        auto flow         = std::make_shared<detail::flow_call>();
+        flow->mid         = m_mid;
+        flow->window      = m_window;
+        flow->retry       = m_retry;
+        flow->provider_id = m_provider_id;
+        flow->timeout_ms  = timeout_ms;
+        flow->has_control = m_control;
+        return flow;
     }
 
     /**
      * @brief Sends the RPC to the endpoint (calls margo_forward), passing a
      * buffer in which the arguments have been serialized.
      *
-     * @param buf Buffer containing a serialized version of the arguments.
-     * @param timeout_ms Timeout in milliseconds. After this timeout, a timeout
-     * exception is thrown.
+     * @param args Arguments to serialize.
+     * @param timeout_ms Timeout in milliseconds, after which HG_TIMEOUT
+     * is returned.
+     * @param result Set to the packed_data from which the returned value
+     * can be deserialized.
+     * @param movable Mask of the arguments the handler of a local call
+     * may move from (see detail::local_call), cleared once a handler
+     * may have done so.
      *
-     * @return a packed_data object from which the returned value can be
-     * deserialized.
+     * @return HG_SUCCESS, HG_BUSY if the server rejected the RPC, or the
+     * error code of margo.
      */
     template <typename... T>
-    packed_data<> forward(const std::tuple<T...>& args,
-                            double                timeout_ms = -1.0) {
+    hg_return_t forward_once(const std::tuple<T...>& args, double timeout_ms,
+                             packed_data<>& result, std::uint64_t& movable) {
         hg_return_t  ret;
-        meta_proc_fn mproc = [this, &args](hg_proc_t proc) {
-            return proc_object_encode(proc, const_cast<std::tuple<T...>&>(args),
-                               m_mid, m_context);
+        trace_context       trace;
+        detail::rpc_control control = make_control(timeout_ms, false, trace);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        detail::rpc_stats_scope stats_scope(stats_metrics(), detail::rpc_metric::round_trip);
+        detail::span_scope      span(m_mid, trace, trace.valid() ? registered_id() : 0,
+                                     span_record::client);
+#endif
+        // an RPC sent to the engine itself hands its arguments by pointer
+        // if the handler takes the same types; the call blocks until the
+        // response, so the arguments outlive the handler's copy of them
+        auto pointers = detail::local_arg_pointers(args, std::index_sequence_for<T...>());
+        detail::local_call local_call{
+            detail::local_type_id<std::tuple<detail::local_arg_t<T>...>>(), &pointers,
+            nullptr, movable};
+        bool local = m_local && timeout_ms <= 0.0 && !m_ignore_response
+                  && sizeof...(CtxArg) == 0
+                  && detail::all_locally_passable<detail::local_arg_t<T>...>::value;
+        // without control information to send, the handler can run here,
+        // neither creating a handle nor going through Mercury
+        if(local && !m_control) {
+            eventual<void> responded;
+            local_call.responded = &responded;
+            if(m_local->invoke(detail::local_rpc_id(m_rpc_id, m_provider_id), local_call)) {
+                movable = 0;
+                responded.wait();
+                result         = packed_data<>();
+                result.m_mid   = m_mid;
+                result.m_local = std::move(local_call.response);
+                return HG_SUCCESS;
+            }
+            local_call.responded = nullptr;
+        }
+        ensure_handle();
+        bool posted = false;
+        struct withdraw_guard {
+            detail::local_dispatch* local;
+            hg_handle_t             handle;
+            bool&                   posted;
+            ~withdraw_guard() { if(posted) local->withdraw(handle); }
+        } guard{m_local.get(), m_handle, posted};
+        meta_proc_fn mproc = [this, &args, &control, &local_call, local, &posted,
+                              &movable](hg_proc_t proc) {
+            const struct hg_info* info = local ? margo_get_info(m_handle) : nullptr;
+            if(info && m_local->type(info->id) == local_call.type) {
+                m_local->post(m_handle, &local_call);
+                posted = true;
+                // a retry must not use arguments the handler moved from
+                movable = 0;
+                return encode_control(proc, HG_SUCCESS, control);
+            }
+            hg_return_t r = detail::encode_with_size_hint(proc, m_handle, false,
+                [this, &args](hg_proc_t p) {
+                    return proc_object_encode(p, const_cast<std::tuple<T...>&>(args),
+                                              m_mid, m_context);
+                });
+            return encode_control(proc, r, control);
         };
         if(timeout_ms > 0.0) {
             ret = margo_provider_forward_timed(
                 m_provider_id, m_handle,
                 const_cast<void*>(static_cast<const void*>(&mproc)),
                 timeout_ms);
-            if(ret == HG_TIMEOUT)
-                throw timeout();
-            MARGO_ASSERT(ret, margo_provider_iforward);
         } else {
             ret = margo_provider_forward(
                 m_provider_id, m_handle,
                 const_cast<void*>(static_cast<const void*>(&mproc)));
-            MARGO_ASSERT(ret, margo_provider_forward);
         }
-        if(m_ignore_response)
-            return packed_data<>();
-        return packed_data<>(margo_get_output, margo_free_output, m_handle, m_mid);
+        if(ret != HG_SUCCESS || m_ignore_response)
+            return ret;
+        if(detail::is_busy_response(m_handle))
+            return HG_BUSY;
+        result = packed_data<>(margo_get_output, margo_free_output, m_handle, m_mid);
+        if(posted) result.m_local = std::move(local_call.response);
+        return HG_SUCCESS;
     }
 
-    packed_data<> forward(double timeout_ms = -1.0) const {
+    hg_return_t forward_once(double timeout_ms, packed_data<>& result) const {
+        ensure_handle();
         hg_return_t  ret;
-        meta_proc_fn mproc = [this](hg_proc_t proc) {
-            return proc_void_object(proc, m_context);
+        trace_context       trace;
+        detail::rpc_control control = make_control(timeout_ms, false, trace);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        detail::rpc_stats_scope stats_scope(stats_metrics(), detail::rpc_metric::round_trip);
+        detail::span_scope      span(m_mid, trace, trace.valid() ? registered_id() : 0,
+                                     span_record::client);
+#endif
+        meta_proc_fn mproc = [this, &control](hg_proc_t proc) {
+            return encode_control(proc, proc_void_object(proc, m_context), control);
         };
         if(timeout_ms > 0.0) {
             ret = margo_provider_forward_timed(
                 m_provider_id, m_handle,
                 const_cast<void*>(static_cast<const void*>(&mproc)),
                 timeout_ms);
-            if(ret == HG_TIMEOUT)
-                throw timeout();
-            MARGO_ASSERT(ret, margo_provider_forward_timed);
         } else {
             ret = margo_provider_forward(
                 m_provider_id, m_handle,
                 const_cast<void*>(static_cast<const void*>(&mproc)));
-            MARGO_ASSERT(ret, margo_provider_forward);
         }
-        if(m_ignore_response)
-            return packed_data<>();
-        return packed_data<>(margo_get_output, margo_free_output, m_handle, m_mid);
+        if(ret != HG_SUCCESS || m_ignore_response)
+            return ret;
+        if(detail::is_busy_response(m_handle))
+            return HG_BUSY;
+        result = packed_data<>(margo_get_output, margo_free_output, m_handle, m_mid);
+        return HG_SUCCESS;
+    }
+
+    template <typename... T>
+    expected<packed_data<>> try_forward(const std::tuple<T...>& args,
+                                        double                  timeout_ms = -1.0,
+                                        std::uint64_t           movable    = 0) {
+        return forward_with_flow_control([this, &args, timeout_ms, &movable](packed_data<>& result) {
+            return forward_once(args, timeout_ms, result, movable);
+        });
+    }
+
+    expected<packed_data<>> try_forward(double timeout_ms = -1.0) const {
+        return forward_with_flow_control([this, timeout_ms](packed_data<>& result) {
+            return forward_once(timeout_ms, result);
+        });
+    }
+
+    template <typename... T>
+    packed_data<> forward(const std::tuple<T...>& args,
+                            double                timeout_ms = -1.0,
+                            std::uint64_t         movable    = 0) {
+        auto result = try_forward(args, timeout_ms, movable);
+        if(!result) detail::throw_rpc_error(result.error(), false, "margo_provider_forward");
+        return std::move(result).value();
+    }
+
+    packed_data<> forward(double timeout_ms = -1.0) const {
+        auto result = try_forward(timeout_ms);
+        if(!result) detail::throw_rpc_error(result.error(), false, "margo_provider_forward");
+        return std::move(result).value();
     }
 
     /**
@@ -164,48 +410,108 @@ class callable_remote_procedure_with_context {
      * calling wait() on the async_response.
      */
     template <typename... T>
-    async_response iforward(const std::tuple<T...>& args,
-                            double                  timeout_ms = -1.0) {
+    expected<async_response> try_iforward(const std::tuple<T...>& args,
+                                          double                  timeout_ms = -1.0) {
+        ensure_handle();
         hg_return_t   ret;
-        margo_request req;
-        meta_proc_fn  mproc = [this, &args](hg_proc_t proc) {
-            return proc_object_encode(proc, const_cast<std::tuple<T...>&>(args),
-                                      m_mid, m_context);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        auto          stats = stats_metrics();
+        std::uint64_t start = stats ? detail::rpc_stats_now() : 0;
+#endif
+        margo_request       req;
+        trace_context       trace;
+        detail::rpc_control control = make_control(timeout_ms, true, trace);
+        meta_proc_fn        mproc = [this, &args, &control](hg_proc_t proc) {
+            hg_return_t r = detail::encode_with_size_hint(proc, m_handle, false,
+                [this, &args](hg_proc_t p) {
+                    return proc_object_encode(p, const_cast<std::tuple<T...>&>(args),
+                                              m_mid, m_context);
+                });
+            return encode_control(proc, r, control);
         };
-        if(timeout_ms > 0.0) {
+        auto flow = make_flow_call(timeout_ms);
+        if(flow) {
+            std::size_t hint = m_retry.max_attempts > 1
+                ? thallium::get_encoded_size(args, m_mid, m_context) : 0;
+            ret = flow->send(m_handle, &req, mproc, hint);
+        } else if(timeout_ms > 0.0) {
             ret = margo_provider_iforward_timed(
                 m_provider_id, m_handle,
                 const_cast<void*>(static_cast<const void*>(&mproc)), timeout_ms,
                 &req);
-            MARGO_ASSERT(ret, margo_provider_iforward_timed);
         } else {
             ret = margo_provider_iforward(
                 m_provider_id, m_handle,
                 const_cast<void*>(static_cast<const void*>(&mproc)), &req);
-            MARGO_ASSERT(ret, margo_provider_iforward);
         }
-        return async_response(req, m_mid, m_handle, m_ignore_response);
+        if(ret != HG_SUCCESS)
+            return expected<async_response>::failure(ret);
+        async_response result(req, m_mid, m_handle, m_ignore_response);
+        result.m_flow  = std::move(flow);
+        result.m_token = control.token;
+        result.m_peer  = detail::peer_monitor::track(m_mid, m_handle);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        result.m_stats       = std::move(stats);
+        result.m_stats_start = start;
+        result.m_span.begin(trace, trace.valid() ? registered_id() : 0,
+                            span_record::client);
+#endif
+        return expected<async_response>(std::move(result));
     }
 
-    async_response iforward(double timeout_ms = -1.0) const {
+    expected<async_response> try_iforward(double timeout_ms = -1.0) const {
+        ensure_handle();
         hg_return_t   ret;
-        margo_request req;
-        meta_proc_fn  mproc = [this](hg_proc_t proc) {
-            return proc_void_object(proc, m_context);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        auto          stats = stats_metrics();
+        std::uint64_t start = stats ? detail::rpc_stats_now() : 0;
+#endif
+        margo_request       req;
+        trace_context       trace;
+        detail::rpc_control control = make_control(timeout_ms, true, trace);
+        meta_proc_fn        mproc = [this, &control](hg_proc_t proc) {
+            return encode_control(proc, proc_void_object(proc, m_context), control);
         };
-        if(timeout_ms > 0.0) {
+        auto flow = make_flow_call(timeout_ms);
+        if(flow) {
+            ret = flow->send(m_handle, &req, mproc, 0);
+        } else if(timeout_ms > 0.0) {
             ret = margo_provider_iforward_timed(
                 m_provider_id, m_handle,
                 const_cast<void*>(static_cast<const void*>(&mproc)), timeout_ms,
                 &req);
-            MARGO_ASSERT(ret, margo_provider_iforward_timed);
         } else {
             ret = margo_provider_iforward(
                 m_provider_id, m_handle,
                 const_cast<void*>(static_cast<const void*>(&mproc)), &req);
-            MARGO_ASSERT(ret, margo_provider_iforward);
         }
-        return async_response(req, m_mid, m_handle, m_ignore_response);
+        if(ret != HG_SUCCESS)
+            return expected<async_response>::failure(ret);
+        async_response result(req, m_mid, m_handle, m_ignore_response);
+        result.m_flow  = std::move(flow);
+        result.m_token = control.token;
+        result.m_peer  = detail::peer_monitor::track(m_mid, m_handle);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        result.m_stats       = std::move(stats);
+        result.m_stats_start = start;
+        result.m_span.begin(trace, trace.valid() ? registered_id() : 0,
+                            span_record::client);
+#endif
+        return expected<async_response>(std::move(result));
+    }
+
+    template <typename... T>
+    async_response iforward(const std::tuple<T...>& args,
+                            double                  timeout_ms = -1.0) {
+        auto result = try_iforward(args, timeout_ms);
+        if(!result) detail::throw_rpc_error(result.error(), false, "margo_provider_iforward");
+        return std::move(*result);
+    }
+
+    async_response iforward(double timeout_ms = -1.0) const {
+        auto result = try_iforward(timeout_ms);
+        if(!result) detail::throw_rpc_error(result.error(), false, "margo_provider_iforward");
+        return std::move(*result);
     }
 
   public:
@@ -218,7 +524,15 @@ class callable_remote_procedure_with_context {
     , m_handle(other.m_handle)
     , m_ignore_response(other.m_ignore_response)
     , m_provider_id(other.m_provider_id)
-    , m_context(other.m_context) {
+    , m_context(other.m_context)
+    , m_cache(other.m_cache)
+    , m_cache_addr(other.m_cache_addr)
+    , m_cache_id(other.m_cache_id)
+    , m_rpc_id(other.m_rpc_id)
+    , m_window(other.m_window)
+    , m_retry(other.m_retry)
+    , m_control(other.m_control)
+    , m_local(other.m_local) {
         hg_return_t ret;
         if(m_handle != HG_HANDLE_NULL) {
             ret = margo_ref_incr(m_handle);
@@ -235,7 +549,15 @@ class callable_remote_procedure_with_context {
     , m_handle(std::exchange(other.m_handle, HG_HANDLE_NULL))
     , m_ignore_response(other.m_ignore_response)
     , m_provider_id(other.m_provider_id)
-    , m_context(std::move(other.m_context)) {}
+    , m_context(std::move(other.m_context))
+    , m_cache(std::move(other.m_cache))
+    , m_cache_addr(other.m_cache_addr)
+    , m_cache_id(other.m_cache_id)
+    , m_rpc_id(other.m_rpc_id)
+    , m_window(std::move(other.m_window))
+    , m_retry(other.m_retry)
+    , m_control(other.m_control)
+    , m_local(std::move(other.m_local)) {}
 
     /**
      * @brief Copy-assignment operator.
@@ -245,17 +567,25 @@ class callable_remote_procedure_with_context {
         hg_return_t ret;
         if(&other == this)
             return *this;
-        if(m_handle != HG_HANDLE_NULL) {
-            ret = margo_destroy(m_handle);
-            MARGO_ASSERT(ret, margo_destroy);
-        }
+        ret = release_handle();
+        MARGO_ASSERT(ret, margo_destroy);
         m_handle          = other.m_handle;
         m_mid             = other.m_mid;
         m_ignore_response = other.m_ignore_response;
         m_provider_id     = other.m_provider_id;
         m_context         = other.m_context;
-        ret               = margo_ref_incr(m_handle);
-        MARGO_ASSERT(ret, margo_ref_incr);
+        m_cache           = other.m_cache;
+        m_cache_addr      = other.m_cache_addr;
+        m_cache_id        = other.m_cache_id;
+        m_rpc_id          = other.m_rpc_id;
+        m_window          = other.m_window;
+        m_retry           = other.m_retry;
+        m_control         = other.m_control;
+        m_local           = other.m_local;
+        if(m_handle != HG_HANDLE_NULL) {
+            ret = margo_ref_incr(m_handle);
+            MARGO_ASSERT(ret, margo_ref_incr);
+        }
         return *this;
     }
 
@@ -266,15 +596,21 @@ class callable_remote_procedure_with_context {
     operator=(callable_remote_procedure_with_context&& other) {
         if(&other == this)
             return *this;
-        if(m_handle != HG_HANDLE_NULL) {
-            hg_return_t ret = margo_destroy(m_handle);
-            MARGO_ASSERT(ret, margo_destroy);
-        }
+        hg_return_t ret = release_handle();
+        MARGO_ASSERT(ret, margo_destroy);
         m_handle          = std::exchange(other.m_handle, HG_HANDLE_NULL);
         m_mid             = std::move(other.m_mid);
         m_ignore_response = other.m_ignore_response;
         m_provider_id     = other.m_provider_id;
         m_context         = std::move(other.m_context);
+        m_cache           = std::move(other.m_cache);
+        m_cache_addr      = other.m_cache_addr;
+        m_cache_id        = other.m_cache_id;
+        m_rpc_id          = other.m_rpc_id;
+        m_window          = std::move(other.m_window);
+        m_retry           = other.m_retry;
+        m_control         = other.m_control;
+        m_local           = std::move(other.m_local);
         return *this;
     }
 
@@ -282,10 +618,8 @@ class callable_remote_procedure_with_context {
      * @brief Destructor.
      */
     ~callable_remote_procedure_with_context() {
-        if(m_handle != HG_HANDLE_NULL) {
-            hg_return_t ret = margo_destroy(m_handle);
-            MARGO_ASSERT_TERMINATE(ret, margo_destroy);
-        }
+        hg_return_t ret = release_handle();
+        MARGO_ASSERT_TERMINATE(ret, margo_destroy);
     }
 
     /**
@@ -297,29 +631,112 @@ class callable_remote_procedure_with_context {
      */
     template <typename ... NewCtxArg>
     auto with_serialization_context(NewCtxArg&&... args) const {
-        return callable_remote_procedure_with_context
+        // calls with a context go through Mercury
+        ensure_handle();
+        auto result = callable_remote_procedure_with_context
             <unwrap_decay_t<NewCtxArg>...>(
                 m_mid,
                 m_handle,
                 m_ignore_response,
                 m_provider_id,
                 std::make_tuple<NewCtxArg...>(std::forward<NewCtxArg>(args)...));
+        result.m_cache      = m_cache;
+        result.m_cache_addr = m_cache_addr;
+        result.m_cache_id   = m_cache_id;
+        result.m_rpc_id     = m_rpc_id;
+        result.m_window     = m_window;
+        result.m_retry      = m_retry;
+        result.m_control    = m_control;
+        return result;
+    }
+
+    /**
+     * @brief Returns a copy of this callable_remote_procedure_with_context
+     * that waits for a slot of the concurrency_limiter's window for its
+     * endpoint before sending the RPC.
+     *
+     * @param limiter concurrency_limiter to use.
+     */
+    callable_remote_procedure_with_context
+    with_concurrency_limiter(const concurrency_limiter& limiter) const {
+        ensure_handle();
+        callable_remote_procedure_with_context result(*this);
+        const struct hg_info* info = margo_get_info(m_handle);
+        if(!info) throw exception("Could not get the address of the RPC's handle");
+        result.m_window = limiter.m_state->window(m_mid, info->addr);
+        return result;
+    }
+
+    /**
+     * @brief Returns a copy of this callable_remote_procedure_with_context
+     * that sends the RPC again, according to the provided retry_policy,
+     * when it gets a busy response or times out.
+     *
+     * @param policy retry_policy to use.
+     */
+    callable_remote_procedure_with_context
+    with_retry(const retry_policy& policy) const {
+        callable_remote_procedure_with_context result(*this);
+        result.m_retry = policy;
+        return result;
     }
 
 
+    /**
+     * @brief Returns the number of bytes the provided arguments would
+     * take once serialized for this RPC. Nothing is sent.
+     *
+     * @tparam T Types of the parameters.
+     * @param args Parameters of the RPC.
+     */
+    template <typename... T>
+    std::size_t get_encoded_size(const T&... args) const {
+        auto t = std::make_tuple(std::cref(args)...);
+        return thallium::get_encoded_size(t, m_mid, m_context);
+    }
+
+    /**
+     * @brief Returns true if the provided arguments, once serialized,
+     * fit in Mercury's eager buffer. If they don't, calling the RPC with
+     * them will go through Mercury's overflow path (an extra allocation
+     * and an implicit RDMA transfer).
+     *
+     * @tparam T Types of the parameters.
+     * @param args Parameters of the RPC.
+     */
+    template <typename... T>
+    bool fits_eager_buffer(const T&... args) const {
+        return get_encoded_size(args...) <= engine(m_mid).get_input_eager_size();
+    }
+
     /**
      * @brief Operator to call the RPC. Will serialize the arguments
-     * in a buffer and send the RPC to the endpoint.
+     * in a buffer and send the RPC to the endpoint. Arguments passed as
+     * rvalues are moved to the handler of an RPC the engine sends to
+     * itself (see engine::enable_local_dispatch), and only read otherwise.
      *
      * @tparam T Types of the parameters.
      * @param t Parameters of the RPC.
      *
      * @return a packed_data object containing the returned value.
      */
-    template <typename... T> packed_data<> operator()(const T&... args) {
-        return forward(std::make_tuple(std::cref(args)...));
+    template <typename... T> packed_data<> operator()(T&&... args) {
+        return forward(std::make_tuple(std::cref(args)...), -1.0,
+                       detail::local_movable_mask<T...>());
     }
 
+    /**
+     * @brief Sends the RPC to a handler that answers by creating a
+     * stream_writer<T>, and returns a response_stream<T> yielding the
+     * elements the handler writes. Defined in thallium/response_stream.hpp.
+     *
+     * @tparam T Type of the elements of the stream.
+     * @param args Parameters of the RPC.
+     *
+     * @return a response_stream object.
+     */
+    template <typename T, typename... A> response_stream<T> stream(const A&... args);
+
     /**
      * @brief Same as operator() but takes a first parameter representing
      * a timeout (std::duration object). If no response is received from
@@ -421,6 +838,89 @@ class callable_remote_procedure_with_context {
         double                                    timeout_ms = fp_ms.count();
         return iforward(timeout_ms);
     }
+
+    /**
+     * @brief Same as operator() but returns an expected holding the
+     * Mercury error code instead of throwing if the RPC could not be
+     * sent, timed out, was cancelled or got a busy response (HG_BUSY).
+     * Errors of serialization still throw.
+     *
+     * @tparam T Types of the parameters.
+     * @param args Parameters of the RPC.
+     *
+     * @return an expected containing a packed_data object.
+     */
+    template <typename... T> expected<packed_data<>> try_call(T&&... args) {
+        return try_forward(std::make_tuple(std::cref(args)...), -1.0,
+                           detail::local_movable_mask<T...>());
+    }
+
+    /**
+     * @brief Same as timed() but returns an expected instead of throwing
+     * (HG_TIMEOUT if the timeout expires), see try_call().
+     */
+    template <typename R, typename P, typename... T>
+    expected<packed_data<>> try_timed(const std::chrono::duration<R, P>& t,
+                                      const T&... args) {
+        std::chrono::duration<double, std::milli> fp_ms      = t;
+        double                                    timeout_ms = fp_ms.count();
+        return try_forward(std::make_tuple(std::cref(args)...), timeout_ms);
+    }
+
+    /**
+     * @brief Same as try_call() without any argument.
+     */
+    expected<packed_data<>> try_call() const { return try_forward(); }
+
+    /**
+     * @brief Same as try_timed() without any argument.
+     */
+    template <typename R, typename P>
+    expected<packed_data<>> try_timed(const std::chrono::duration<R, P>& t) {
+        std::chrono::duration<double, std::milli> fp_ms      = t;
+        double                                    timeout_ms = fp_ms.count();
+        return try_forward(timeout_ms);
+    }
+
+    /**
+     * @brief Same as async() but returns an expected holding the Mercury
+     * error code instead of throwing if the RPC could not be sent. The
+     * response can then be waited on with async_response::try_wait().
+     *
+     * @tparam T Types of the parameters.
+     * @param args Parameters of the RPC.
+     *
+     * @return an expected containing an async_response object.
+     */
+    template <typename... T> expected<async_response> try_async(const T&... args) {
+        return try_iforward(std::make_tuple(std::cref(args)...));
+    }
+
+    /**
+     * @brief Same as timed_async() but returns an expected, see try_async().
+     */
+    template <typename R, typename P, typename... T>
+    expected<async_response> try_timed_async(const std::chrono::duration<R, P>& t,
+                                             const T&... args) {
+        std::chrono::duration<double, std::milli> fp_ms      = t;
+        double                                    timeout_ms = fp_ms.count();
+        return try_iforward(std::make_tuple(std::cref(args)...), timeout_ms);
+    }
+
+    /**
+     * @brief Same as try_async() without any argument.
+     */
+    expected<async_response> try_async() { return try_iforward(); }
+
+    /**
+     * @brief Same as try_timed_async() without any argument.
+     */
+    template <typename R, typename P>
+    expected<async_response> try_timed_async(const std::chrono::duration<R, P>& t) {
+        std::chrono::duration<double, std::milli> fp_ms      = t;
+        double                                    timeout_ms = fp_ms.count();
+        return try_iforward(timeout_ms);
+    }
 };
 
 using callable_remote_procedure = callable_remote_procedure_with_context<>;
@@ -0,0 +1,388 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_CANCELLATION_HPP
+#define __THALLIUM_CANCELLATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <margo.h>
+#include <mercury_proc.h>
+#include <thallium/per_instance.hpp>
+#include <thallium/proc_object.hpp>
+#include <thallium/rpc_policy.hpp>
+#include <thallium/tracing.hpp>
+#include <thallium/unit_allocator.hpp>
+
+namespace thallium {
+
+/**
+ * @brief This exception is thrown by async_response::wait() when the
+ * RPC was cancelled with async_response::cancel() before its response
+ * arrived.
+ */
+class cancelled : public std::exception {
+  public:
+    virtual const char* what() const throw() { return "Request was cancelled"; }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Control information appended after the arguments of the RPCs
+ * for which remote_procedure::enable_cancellation,
+ * remote_procedure::enable_deadline_propagation or
+ * remote_procedure::enable_tracing was called (on both the client and
+ * the server). A token of 0 means the request cannot be cancelled, a
+ * deadline of 0 that it has none; deadlines are in nanoseconds since
+ * the epoch of the system clock. The trace identifiers are those of the
+ * client's span for the RPC (0 if it has none).
+ */
+struct rpc_control {
+    std::uint64_t token      = 0;
+    std::uint64_t deadline   = 0;
+    std::uint64_t trace_high = 0;
+    std::uint64_t trace_low  = 0;
+    std::uint64_t span       = 0;
+
+    void set_trace(const trace_context& c) {
+        trace_high = c.trace_id_high;
+        trace_low  = c.trace_id_low;
+        span       = c.span_id;
+    }
+
+    bool has_trace() const { return trace_high != 0 || trace_low != 0; }
+
+    /**
+     * @brief Returns the context of the server's span, child of the
+     * client's one.
+     */
+    trace_context server_trace() const {
+        trace_context c;
+        if(!has_trace()) return c;
+        c.trace_id_high  = trace_high;
+        c.trace_id_low   = trace_low;
+        c.span_id        = trace_context::new_id();
+        c.parent_span_id = span;
+        return c;
+    }
+};
+
+inline hg_return_t proc_rpc_control(hg_proc_t proc, rpc_control& c) {
+    return hg_proc_memcpy(proc, &c, sizeof(c));
+}
+
+/**
+ * @private
+ * @brief Returns the system clock, in nanoseconds since its epoch.
+ */
+inline std::uint64_t rpc_deadline_now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @private
+ * @brief Returns the deadline of a request sent now with a timeout in
+ * milliseconds (0 if it has no timeout).
+ */
+inline std::uint64_t rpc_deadline_after(double timeout_ms) {
+    if(timeout_ms <= 0.0) return 0;
+    return rpc_deadline_now() + static_cast<std::uint64_t>(timeout_ms * 1e6);
+}
+
+/**
+ * @private
+ * @brief Returns a new token, unique within the process and random
+ * across processes.
+ */
+inline std::uint64_t new_rpc_token() {
+    static const std::uint64_t salt = [] {
+        std::random_device rd;
+        return (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+    }();
+    static std::atomic<std::uint64_t> counter{1};
+    // an odd multiplier makes this a bijection of the counter
+    std::uint64_t t = salt + counter.fetch_add(1, std::memory_order_relaxed)
+                    * 0x9e3779b97f4a7c15ull;
+    return t ? t : 1;
+}
+
+/**
+ * @private
+ * @brief RPCs with control information and requests that can be
+ * cancelled or have a deadline, for each margo instance. Cancellation
+ * requests are sent with a one-way RPC handled directly by
+ * thallium_rpc_handler (so they don't queue behind the handlers they
+ * cancel). A cancellation
+ * that arrives before its request was decoded is remembered (up to
+ * max_early_cancels of them) so that the request is dropped then.
+ * Requests whose deadline passed while they were queued are dropped
+ * too, since their client stopped waiting for them.
+ */
+class rpc_control_registry : public per_instance<rpc_control_registry> {
+
+    static constexpr std::size_t max_early_cancels = 4096;
+
+    struct running {
+        std::uint64_t token;
+        std::uint64_t deadline;
+        bool          cancelled;
+        trace_context trace;
+    };
+
+    std::mutex                                       m_mutex;
+    hg_id_t                                          m_cancel_id = 0;
+    pooled_unordered_map<hg_handle_t, running>       m_running;
+    pooled_unordered_map<std::uint64_t, hg_handle_t> m_tokens;
+    std::unordered_set<std::uint64_t>                m_early;
+    std::deque<std::uint64_t>                        m_early_order;
+
+    static std::shared_ptr<rpc_control_registry> get(margo_instance_id mid) {
+        // finalize rather than prefinalize: handlers still
+        // running end their request when they return
+        return per_instance::get(mid, instance_release::at_finalize);
+    }
+
+    void cancel(std::uint64_t token) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_tokens.find(token);
+        if(it != m_tokens.end()) {
+            m_running[it->second].cancelled = true;
+            return;
+        }
+        if(!m_early.insert(token).second) return;
+        m_early_order.push_back(token);
+        if(m_early_order.size() > max_early_cancels) {
+            m_early.erase(m_early_order.front());
+            m_early_order.pop_front();
+        }
+    }
+
+  public:
+
+    /**
+     * @brief Returns whether an RPC carries control information.
+     */
+    static bool enabled(margo_instance_id mid, hg_id_t id) {
+        return trailer_size(rpc_policy_table::find(mid, id)) != 0;
+    }
+
+    /**
+     * @brief Returns the size of the control information at the end of
+     * the input of the RPC of a policy (0 if it has none).
+     */
+    static std::size_t trailer_size(const rpc_policy* policy) {
+        return policy && policy->control.load(std::memory_order_relaxed)
+             ? sizeof(rpc_control) : 0;
+    }
+
+    /**
+     * @brief Same as above for the RPC a handle was received for.
+     */
+    static std::size_t trailer_size(margo_instance_id mid, hg_handle_t h) {
+        if(rpc_policy_table::empty()) return 0;
+        const struct hg_info* info = margo_get_info(h);
+        return info ? trailer_size(rpc_policy_table::find(mid, info->id)) : 0;
+    }
+
+    static hg_id_t cancel_rpc_id(margo_instance_id mid) {
+        auto reg = find(mid);
+        if(!reg) return 0;
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        return reg->m_cancel_id;
+    }
+
+    static void set_cancel_rpc_id(margo_instance_id mid, hg_id_t id) {
+        auto reg = get(mid);
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        reg->m_cancel_id = id;
+    }
+
+    /**
+     * @brief Called before running the handler of a request with the
+     * control information it was sent with. Returns false if the
+     * request was already cancelled or its deadline passed, in which
+     * case it is dropped. Otherwise sets trace to the context of the
+     * handler's span (invalid if the request has no trace).
+     */
+    static bool begin(margo_instance_id mid, hg_handle_t h, const rpc_control& c,
+                      trace_context& trace) {
+        trace = c.server_trace();
+        if(c.token == 0 && c.deadline == 0 && !trace.valid()) return true;
+        if(c.deadline != 0 && rpc_deadline_now() > c.deadline) return false;
+        auto reg = get(mid);
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        if(c.token != 0 && reg->m_early.erase(c.token)) return false;
+        reg->m_running[h] = running{c.token, c.deadline, false, trace};
+        if(c.token != 0) reg->m_tokens[c.token] = h;
+        return true;
+    }
+
+    /**
+     * @brief Called when the handler of a request returned.
+     */
+    static void end(margo_instance_id mid, hg_handle_t h) {
+        auto reg = find(mid);
+        if(!reg) return;
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        auto it = reg->m_running.find(h);
+        if(it == reg->m_running.end()) return;
+        if(it->second.token != 0) reg->m_tokens.erase(it->second.token);
+        reg->m_running.erase(it);
+    }
+
+    /**
+     * @brief Returns whether the client cancelled a request.
+     */
+    static bool is_cancelled(margo_instance_id mid, hg_handle_t h) {
+        auto reg = find(mid);
+        if(!reg) return false;
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        auto it = reg->m_running.find(h);
+        return it != reg->m_running.end() && it->second.cancelled;
+    }
+
+    /**
+     * @brief Returns the deadline of a request (0 if it has none).
+     */
+    static std::uint64_t deadline(margo_instance_id mid, hg_handle_t h) {
+        auto reg = find(mid);
+        if(!reg) return 0;
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        auto it = reg->m_running.find(h);
+        return it == reg->m_running.end() ? 0 : it->second.deadline;
+    }
+
+    /**
+     * @brief Returns the context of the span of a request's handler
+     * (invalid if it has none).
+     */
+    static trace_context trace(margo_instance_id mid, hg_handle_t h) {
+        auto reg = find(mid);
+        if(!reg) return trace_context();
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        auto it = reg->m_running.find(h);
+        return it == reg->m_running.end() ? trace_context() : it->second.trace;
+    }
+
+    /**
+     * @brief If h is a cancellation RPC, handles (and destroys) it and
+     * returns true. Called from the progress loop.
+     */
+    static bool handle_cancel_rpc(margo_instance_id mid, hg_handle_t h) {
+        auto reg = find(mid);
+        if(!reg) return false;
+        const struct hg_info* info = margo_get_info(h);
+        if(!info) return false;
+        {
+            std::lock_guard<std::mutex> lock(reg->m_mutex);
+            if(reg->m_cancel_id == 0 || info->id != reg->m_cancel_id)
+                return false;
+        }
+        std::uint64_t token = 0;
+        meta_proc_fn  mproc = [&token](hg_proc_t proc) {
+            return hg_proc_memcpy(proc, &token, sizeof(token));
+        };
+        if(margo_get_input(h, &mproc) == HG_SUCCESS) {
+            margo_free_input(h, &mproc);
+            if(token) reg->cancel(token);
+        }
+        margo_destroy(h);
+        return true;
+    }
+
+    /**
+     * @brief Sends a cancellation RPC for a token to an address.
+     */
+    static void send_cancel(margo_instance_id mid, hg_addr_t addr, std::uint64_t token) {
+        hg_id_t id = cancel_rpc_id(mid);
+        if(id == 0) return;
+        hg_handle_t h   = HG_HANDLE_NULL;
+        hg_return_t ret = margo_create(mid, addr, id, &h);
+        if(ret != HG_SUCCESS) return;
+        meta_proc_fn mproc = [&token](hg_proc_t proc) {
+            return hg_proc_memcpy(proc, &token, sizeof(token));
+        };
+        // responses are disabled: this returns once the RPC is sent
+        margo_forward(h, &mproc);
+        margo_destroy(h);
+    }
+};
+
+/**
+ * @private
+ * @brief Reads the control information of a received RPC without
+ * argument, whose policy is provided, and calls
+ * rpc_control_registry::begin.
+ */
+inline bool rpc_control_begin_void(const rpc_policy* policy, margo_instance_id mid,
+                                   hg_handle_t h, trace_context& trace) {
+    if(rpc_control_registry::trailer_size(policy) == 0) return true;
+    rpc_control   control;
+    std::tuple<>  ctx;
+    meta_proc_fn  mproc = [&control, &ctx](hg_proc_t proc) {
+        hg_return_t ret = proc_void_object(proc, ctx);
+        if(ret != HG_SUCCESS) return ret;
+        return proc_rpc_control(proc, control);
+    };
+    if(margo_get_input(h, &mproc) != HG_SUCCESS) return true;
+    margo_free_input(h, &mproc);
+    return rpc_control_registry::begin(mid, h, control, trace);
+}
+
+/**
+ * @private
+ * @brief Makes the span of an RPC's handler the current trace context
+ * of the ULT running it and, if the RPC statistics are compiled in,
+ * records the span when the handler returns.
+ */
+class rpc_handler_trace {
+
+    trace_scope m_scope;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    span_scope  m_span;
+#endif
+
+  public:
+
+    rpc_handler_trace(margo_instance_id mid, hg_handle_t h, const trace_context& trace)
+    : m_scope(trace)
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    , m_span(mid, trace, rpc_id(h, trace), span_record::server)
+#endif
+    {
+        (void)mid;
+        (void)h;
+    }
+
+    rpc_handler_trace(const rpc_handler_trace&)            = delete;
+    rpc_handler_trace& operator=(const rpc_handler_trace&) = delete;
+
+  private:
+
+    static std::uint64_t rpc_id(hg_handle_t h, const trace_context& trace) {
+        if(!trace.valid()) return 0;
+        const struct hg_info* info = margo_get_info(h);
+        return info ? info->id : 0;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
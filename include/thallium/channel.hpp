@@ -0,0 +1,422 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_CHANNEL_HPP
+#define __THALLIUM_CHANNEL_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <thallium/condition_variable.hpp>
+#include <thallium/eventual.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/mutex.hpp>
+
+namespace thallium {
+
+/**
+ * Exception class thrown by the channel class, e.g. when pushing
+ * into a closed channel.
+ */
+class channel_exception : public exception {
+  public:
+    template <typename... Args>
+    channel_exception(Args&&... args)
+    : exception(std::forward<Args>(args)...) {}
+};
+
+/**
+ * @brief A channel is a bounded multi-producer, multi-consumer queue
+ * for passing values between ULTs (or OS threads). Pushing into a
+ * channel that is not full and popping from one that is not empty are
+ * lock-free. A ULT blocks on an Argobots condition variable only when
+ * it has to wait for room or for a value, and the producer or consumer
+ * that unblocks it only takes the lock when someone is waiting.
+ *
+ * Values can also be received through an eventual with async_pop(),
+ * so that a consumer can use eventual::then (or co_await) instead of
+ * blocking a ULT.
+ *
+ * \code{.cpp}
+ * tl::channel<std::vector<char>> ch(64);
+ * // producer ULT
+ * ch.push(std::move(buffer));
+ * ch.close();
+ * // consumer ULT
+ * std::vector<char> buffer;
+ * while(ch.pop(buffer)) { ... }
+ * \endcode
+ *
+ * @tparam T Type of values. Must be default-constructible,
+ * move-constructible and move-assignable.
+ */
+template <typename T> class channel {
+
+    struct cell {
+        std::atomic<std::size_t> m_sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+
+        T* value() { return reinterpret_cast<T*>(&m_storage); }
+    };
+
+    // padding keeps the indices used by producers and consumers on
+    // different cache lines
+    struct padded_index {
+        std::atomic<std::size_t> m_value{0};
+        char                     m_padding[64 - sizeof(std::atomic<std::size_t>)];
+    };
+
+    std::size_t             m_mask;
+    std::unique_ptr<cell[]> m_cells;
+    padded_index            m_push_index;
+    padded_index            m_pop_index;
+
+    std::atomic<bool>        m_closed{false};
+    std::atomic<std::size_t> m_push_waiters{0};
+    std::atomic<std::size_t> m_pop_waiters{0};
+    std::atomic<std::size_t> m_num_async{0};
+
+    mutex              m_mutex;
+    condition_variable m_not_full;
+    condition_variable m_not_empty;
+    std::deque<std::shared_ptr<detail::eventual_state<T>>> m_async_pops;
+
+    static std::size_t round_up(std::size_t n) {
+        std::size_t p = 2;
+        while(p < n) p <<= 1;
+        return p;
+    }
+
+    template <typename U>
+    bool enqueue(U&& value) {
+        std::size_t pos = m_push_index.m_value.load(std::memory_order_relaxed);
+        while(true) {
+            cell&       c   = m_cells[pos & m_mask];
+            std::size_t seq = c.m_sequence.load(std::memory_order_acquire);
+            auto        dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if(dif == 0) {
+                if(m_push_index.m_value.compare_exchange_weak(pos, pos + 1,
+                                                              std::memory_order_relaxed)) {
+                    new(c.value()) T(std::forward<U>(value));
+                    c.m_sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(dif < 0) {
+                return false; // full
+            } else {
+                pos = m_push_index.m_value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool dequeue(T& out) {
+        std::size_t pos = m_pop_index.m_value.load(std::memory_order_relaxed);
+        while(true) {
+            cell&       c   = m_cells[pos & m_mask];
+            std::size_t seq = c.m_sequence.load(std::memory_order_acquire);
+            auto        dif = static_cast<std::ptrdiff_t>(seq)
+                            - static_cast<std::ptrdiff_t>(pos + 1);
+            if(dif == 0) {
+                if(m_pop_index.m_value.compare_exchange_weak(pos, pos + 1,
+                                                             std::memory_order_relaxed)) {
+                    out = std::move(*c.value());
+                    c.value()->~T();
+                    c.m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(dif < 0) {
+                return false; // empty
+            } else {
+                pos = m_pop_index.m_value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // called after values were pushed
+    void on_pushed(bool many) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_num_async.load() != 0) serve_async_pops();
+        if(m_pop_waiters.load() != 0) {
+            std::lock_guard<mutex> lock(m_mutex);
+            if(many) m_not_empty.notify_all();
+            else m_not_empty.notify_one();
+        }
+    }
+
+    // called after values were popped
+    void on_popped(bool many) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_push_waiters.load() != 0) {
+            std::lock_guard<mutex> lock(m_mutex);
+            if(many) m_not_full.notify_all();
+            else m_not_full.notify_one();
+        }
+    }
+
+    // hands values (or the closed error) to pending async_pop eventuals
+    void serve_async_pops() {
+        while(true) {
+            std::shared_ptr<detail::eventual_state<T>> target;
+            T    value{};
+            bool closed = false;
+            {
+                std::lock_guard<mutex> lock(m_mutex);
+                if(m_async_pops.empty()) return;
+                if(!dequeue(value)) {
+                    if(!m_closed.load()) return;
+                    closed = true;
+                }
+                target = std::move(m_async_pops.front());
+                m_async_pops.pop_front();
+                m_num_async.fetch_sub(1);
+            }
+            if(closed) {
+                std::exception_ptr error;
+                try {
+                    throw channel_exception("Popping from a closed channel");
+                } catch(...) {
+                    error = std::current_exception();
+                }
+                target->complete([]() {}, error);
+            } else {
+                auto t = target.get();
+                t->complete([t, &value]() { t->m_value = std::move(value); });
+                on_popped(false);
+            }
+        }
+    }
+
+    template <typename U>
+    void push_impl(U&& value) {
+        if(m_closed.load(std::memory_order_acquire))
+            throw channel_exception("Pushing into a closed channel");
+        if(!enqueue(std::forward<U>(value))) {
+            std::unique_lock<mutex> lock(m_mutex);
+            m_push_waiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while(!enqueue(std::forward<U>(value))) {
+                if(m_closed.load()) {
+                    m_push_waiters.fetch_sub(1);
+                    throw channel_exception("Pushing into a closed channel");
+                }
+                m_not_full.wait(lock);
+            }
+            m_push_waiters.fetch_sub(1);
+        }
+        on_pushed(false);
+    }
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param capacity Maximum number of values in the channel
+     * (rounded up to a power of 2).
+     */
+    explicit channel(std::size_t capacity)
+    : m_mask(round_up(capacity) - 1)
+    , m_cells(new cell[m_mask + 1]) {
+        for(std::size_t i = 0; i <= m_mask; i++)
+            m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+    }
+
+    channel(const channel&)            = delete;
+    channel& operator=(const channel&) = delete;
+
+    /**
+     * @brief Destructor. No ULT may be blocked on the channel.
+     */
+    ~channel() {
+        T value;
+        while(dequeue(value)) {}
+    }
+
+    /**
+     * @brief Returns the capacity of the channel.
+     */
+    std::size_t capacity() const noexcept { return m_mask + 1; }
+
+    /**
+     * @brief Returns the number of values in the channel (approximate
+     * if it is being used concurrently).
+     */
+    std::size_t size() const noexcept {
+        std::size_t push = m_push_index.m_value.load(std::memory_order_relaxed);
+        std::size_t pop  = m_pop_index.m_value.load(std::memory_order_relaxed);
+        return push > pop ? push - pop : 0;
+    }
+
+    /**
+     * @brief Pushes a value if the channel is not full, without blocking.
+     *
+     * @return true if the value was pushed.
+     */
+    bool try_push(const T& value) {
+        if(m_closed.load(std::memory_order_acquire)) return false;
+        if(!enqueue(value)) return false;
+        on_pushed(false);
+        return true;
+    }
+
+    bool try_push(T&& value) {
+        if(m_closed.load(std::memory_order_acquire)) return false;
+        if(!enqueue(std::move(value))) return false;
+        on_pushed(false);
+        return true;
+    }
+
+    /**
+     * @brief Pushes a value, blocking while the channel is full. Throws
+     * a channel_exception if the channel is (or gets) closed.
+     */
+    void push(const T& value) { push_impl(value); }
+
+    void push(T&& value) { push_impl(std::move(value)); }
+
+    /**
+     * @brief Pushes the values of the range [begin, end), blocking
+     * whenever the channel is full. Consumers are notified once per
+     * batch rather than once per value. Throws a channel_exception if
+     * the channel is (or gets) closed.
+     *
+     * @return the number of values pushed (i.e. the size of the range).
+     */
+    template <typename Iterator>
+    std::size_t push_batch(Iterator begin, Iterator end) {
+        std::size_t count = 0;
+        for(auto it = begin; it != end; ++it) {
+            if(m_closed.load(std::memory_order_acquire))
+                throw channel_exception("Pushing into a closed channel");
+            if(enqueue(*it)) {
+                count += 1;
+                continue;
+            }
+            // full: wake up the consumers for what was pushed so far
+            if(count) on_pushed(true);
+            push_impl(*it);
+            count += 1;
+        }
+        if(count) on_pushed(true);
+        return count;
+    }
+
+    /**
+     * @brief Pops a value if the channel is not empty, without blocking.
+     *
+     * @return true if a value was popped.
+     */
+    bool try_pop(T& value) {
+        if(!dequeue(value)) return false;
+        on_popped(false);
+        return true;
+    }
+
+    /**
+     * @brief Pops a value, blocking while the channel is empty.
+     *
+     * @return false if the channel is closed and empty.
+     */
+    bool pop(T& value) {
+        if(!dequeue(value)) {
+            std::unique_lock<mutex> lock(m_mutex);
+            m_pop_waiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while(!dequeue(value)) {
+                if(m_closed.load()) {
+                    m_pop_waiters.fetch_sub(1);
+                    return false;
+                }
+                m_not_empty.wait(lock);
+            }
+            m_pop_waiters.fetch_sub(1);
+        }
+        on_popped(false);
+        return true;
+    }
+
+    /**
+     * @brief Pops up to max values into out, without blocking.
+     *
+     * @return the number of values popped.
+     */
+    template <typename OutputIterator>
+    std::size_t try_pop_batch(OutputIterator out, std::size_t max) {
+        std::size_t count = 0;
+        T           value;
+        while(count < max && dequeue(value)) {
+            *out++ = std::move(value);
+            count += 1;
+        }
+        if(count) on_popped(count > 1);
+        return count;
+    }
+
+    /**
+     * @brief Pops up to max values into out, blocking until at least one
+     * is available.
+     *
+     * @return the number of values popped, 0 if the channel is closed
+     * and empty.
+     */
+    template <typename OutputIterator>
+    std::size_t pop_batch(OutputIterator out, std::size_t max) {
+        if(max == 0) return 0;
+        T value;
+        if(!pop(value)) return 0;
+        *out++ = std::move(value);
+        return 1 + try_pop_batch(out, max - 1);
+    }
+
+    /**
+     * @brief Returns an eventual that is set with the next value
+     * available in the channel (immediately if the channel is not
+     * empty), or with a channel_exception if the channel is closed
+     * and empty.
+     */
+    eventual<T> async_pop() {
+        eventual<T> result;
+        {
+            std::lock_guard<mutex> lock(m_mutex);
+            m_async_pops.push_back(result.m_state);
+            m_num_async.fetch_add(1);
+        }
+        serve_async_pops();
+        return result;
+    }
+
+    /**
+     * @brief Closes the channel: pushing is no longer allowed, and
+     * consumers get the remaining values, after which pop() returns
+     * false. Blocked producers and consumers are woken up.
+     */
+    void close() {
+        {
+            std::lock_guard<mutex> lock(m_mutex);
+            m_closed.store(true);
+            m_not_full.notify_all();
+            m_not_empty.notify_all();
+        }
+        serve_async_pops();
+    }
+
+    /**
+     * @brief Returns true if the channel was closed.
+     */
+    bool is_closed() const noexcept { return m_closed.load(); }
+};
+
+} // namespace thallium
+
+#endif /* end of include guard */
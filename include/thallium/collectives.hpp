@@ -0,0 +1,366 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_COLLECTIVES_HPP
+#define __THALLIUM_COLLECTIVES_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/async_response.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/request.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Response of a member of a tree collective to its parent: the
+ * value combined over its subtree, or the error that prevented it.
+ */
+template <typename Out> struct collective_reply {
+    std::string error;
+    Out         value;
+
+    template <typename A> void serialize(A& ar) {
+        ar & error;
+        ar & value;
+    }
+};
+
+/**
+ * @private
+ * @brief Splits the members following the first one into up to arity
+ * contiguous ranges of equal size (give or take one), the subtrees of
+ * the first member's children. A pre-order walk of the tree visits the
+ * members in their order.
+ */
+inline std::vector<std::vector<std::string>>
+collective_children(const std::vector<std::string>& members, std::size_t arity) {
+    std::vector<std::vector<std::string>> children;
+    if(members.size() < 2) return children;
+    std::size_t rest = members.size() - 1;
+    std::size_t k    = std::min(std::max<std::size_t>(arity, 1), rest);
+    children.reserve(k);
+    for(std::size_t i = 0; i < k; i++)
+        children.emplace_back(members.begin() + 1 + (rest * i) / k,
+                              members.begin() + 1 + (rest * (i + 1)) / k);
+    return children;
+}
+
+/**
+ * @private
+ * @brief State shared by a tree_reduce and the handler of its RPC.
+ */
+template <typename In, typename Out> struct tree_reduce_state {
+    remote_procedure                 rpc;
+    std::uint16_t                    provider_id;
+    std::function<Out(const In&)>    local;
+    std::function<Out(Out, Out)>     combine;
+
+    tree_reduce_state(std::uint16_t id, std::function<Out(const In&)> l,
+                      std::function<Out(Out, Out)> c)
+    : provider_id(id)
+    , local(std::move(l))
+    , combine(std::move(c)) {}
+
+    /**
+     * @brief Runs the collective on the subtree rooted at the member
+     * receiving it (members[0]): relays it to the roots of the subtrees
+     * of its children, computes its own value while they run, then
+     * combines the values in the order of the members.
+     */
+    collective_reply<Out> run(margo_instance_id mid, const std::vector<std::string>& members,
+                              std::uint32_t arity, const In& in) const {
+        collective_reply<Out> reply;
+        auto children = collective_children(members, arity);
+        std::vector<std::string> heads;
+        heads.reserve(children.size());
+        for(const auto& c : children) heads.push_back(c.front());
+        std::vector<async_response> pending;
+        pending.reserve(children.size());
+        try {
+            auto endpoints = engine(mid).lookup_async(heads).wait();
+            for(std::size_t i = 0; i < children.size(); i++)
+                pending.push_back(rpc.on(provider_handle(std::move(endpoints[i]), provider_id))
+                                     .async(children[i], arity, in));
+        } catch(const std::exception& ex) {
+            reply.error = std::string("relaying a collective from ")
+                        + members.front() + " failed: " + ex.what();
+        }
+        bool has_value = false;
+        if(reply.error.empty()) {
+            try {
+                reply.value = local(in);
+                has_value   = true;
+            } catch(const std::exception& ex) {
+                reply.error = members.front() + ": " + ex.what();
+            }
+        }
+        // every child is waited for, even after an error
+        for(std::size_t i = 0; i < pending.size(); i++) {
+            collective_reply<Out> child;
+            try {
+                child = pending[i].wait().template as<collective_reply<Out>>();
+            } catch(const std::exception& ex) {
+                child.error = heads[i] + ": " + ex.what();
+            }
+            if(!reply.error.empty()) continue;
+            if(!child.error.empty()) {
+                reply.error = std::move(child.error);
+                continue;
+            }
+            reply.value = combine(std::move(reply.value), std::move(child.value));
+        }
+        if(!reply.error.empty() && has_value) reply.value = Out();
+        return reply;
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief A tree_reduce is a collective operation over a set of servers
+ * (its members), each of which computes a value from the same input,
+ * the values being combined into the one returned to the caller.
+ *
+ * The caller sends the input to the first member only; each member
+ * relays it to up to arity others, which relay it in turn, and responds
+ * once it has combined its own value with those of its children, so
+ * that the caller waits for O(log N) round trips instead of sending N
+ * RPCs. The combiner must be associative: values are combined in the
+ * order of the members, with the member's own value first.
+ *
+ * Servers create a tree_reduce with a handler and a combiner, which
+ * defines its RPC; clients create one with the same name and provider
+ * id, without them. Any member (or client) can start the collective
+ * with operator().
+ *
+ * \code{.cpp}
+ * // on each server
+ * tl::tree_reduce<std::string, std::size_t> du(engine, "du",
+ *     [](const std::string& path) { return disk_usage(path); },
+ *     [](std::size_t a, std::size_t b) { return a + b; });
+ * // on the client
+ * tl::tree_reduce<std::string, std::size_t> du(engine, "du");
+ * std::size_t total = du(addresses, "/scratch");
+ * \endcode
+ *
+ * If a member fails or cannot be reached, operator() throws an
+ * exception naming it, after all the other members responded.
+ * The RPC remains defined until the engine is finalized.
+ *
+ * @tparam In Type of the input, sent to every member.
+ * @tparam Out Type of the values, default-constructible.
+ */
+template <typename In, typename Out> class tree_reduce {
+
+    std::shared_ptr<detail::tree_reduce_state<In, Out>> m_state;
+    engine                                              m_engine;
+    std::uint32_t                                       m_arity = 2;
+
+  public:
+
+    /**
+     * @brief Defines the RPC of a collective on a member.
+     *
+     * @param e Engine of the member.
+     * @param name Name of the collective's RPC.
+     * @param local Computes the member's value from the input.
+     * @param combine Combines two values.
+     * @param provider_id Provider id of the RPC.
+     * @param p Pool in which the handlers run.
+     */
+    tree_reduce(engine& e, const std::string& name, std::function<Out(const In&)> local,
+                std::function<Out(Out, Out)> combine, std::uint16_t provider_id = 0,
+                const pool& p = pool())
+    : m_state(std::make_shared<detail::tree_reduce_state<In, Out>>(
+          provider_id, std::move(local), std::move(combine)))
+    , m_engine(e) {
+        auto state = m_state;
+        std::function<void(const request&, const std::vector<std::string>&,
+                           std::uint32_t, const In&)>
+            handler = [state](const request& req, const std::vector<std::string>& members,
+                              std::uint32_t arity, const In& in) {
+                req.respond(state->run(margo_hg_handle_get_instance(req.native_handle()),
+                                       members, arity, in));
+            };
+        m_state->rpc = e.define(name, std::move(handler), provider_id, p);
+    }
+
+    /**
+     * @brief Defines the RPC of a collective on a client, which starts
+     * it without taking part in it.
+     */
+    tree_reduce(engine& e, const std::string& name, std::uint16_t provider_id = 0)
+    : m_state(std::make_shared<detail::tree_reduce_state<In, Out>>(
+          provider_id, nullptr, nullptr))
+    , m_engine(e) {
+        m_state->rpc = e.define(name);
+    }
+
+    /**
+     * @brief Sets the number of members each member relays the
+     * collective to (2 by default).
+     */
+    tree_reduce& set_arity(std::uint32_t arity) {
+        m_arity = arity ? arity : 1;
+        return *this;
+    }
+
+    std::uint32_t arity() const { return m_arity; }
+
+    /**
+     * @brief Runs the collective on the members and returns the
+     * combination of their values (a default-constructed Out if there
+     * are no members).
+     *
+     * @param members Addresses of the members, each appearing once.
+     * @param in Input sent to every member.
+     */
+    Out operator()(const std::vector<std::string>& members, const In& in) const {
+        if(members.empty()) return Out();
+        auto root  = provider_handle(m_engine.lookup(members.front()), m_state->provider_id);
+        auto reply = m_state->rpc.on(root)(members, m_arity, in)
+                         .template as<detail::collective_reply<Out>>();
+        if(!reply.error.empty())
+            throw exception("Collective operation failed: ", reply.error);
+        return std::move(reply.value);
+    }
+};
+
+/**
+ * @brief A tree_broadcast hands the same value to every member of a
+ * set of servers, relayed along a tree as with tree_reduce. Calling it
+ * returns the number of members the value was handed to, once all of
+ * them returned from their handler.
+ *
+ * \code{.cpp}
+ * // on each server
+ * tl::tree_broadcast<config> set_config(engine, "set_config",
+ *     [&](const config& c) { apply(c); });
+ * // on the client
+ * tl::tree_broadcast<config> set_config(engine, "set_config");
+ * set_config(addresses, cfg);
+ * \endcode
+ */
+template <typename T> class tree_broadcast {
+
+    tree_reduce<T, std::uint64_t> m_reduce;
+
+    static std::uint64_t sum(std::uint64_t a, std::uint64_t b) { return a + b; }
+
+  public:
+
+    /**
+     * @brief Defines the RPC of a broadcast on a member.
+     *
+     * @param e Engine of the member.
+     * @param name Name of the broadcast's RPC.
+     * @param handler Function called with the value on each member.
+     * @param provider_id Provider id of the RPC.
+     * @param p Pool in which the handlers run.
+     */
+    tree_broadcast(engine& e, const std::string& name, std::function<void(const T&)> handler,
+                   std::uint16_t provider_id = 0, const pool& p = pool())
+    : m_reduce(e, name,
+               [handler](const T& value) -> std::uint64_t {
+                   handler(value);
+                   return 1;
+               },
+               &tree_broadcast::sum, provider_id, p) {}
+
+    /**
+     * @brief Defines the RPC of a broadcast on a client.
+     */
+    tree_broadcast(engine& e, const std::string& name, std::uint16_t provider_id = 0)
+    : m_reduce(e, name, provider_id) {}
+
+    tree_broadcast& set_arity(std::uint32_t arity) {
+        m_reduce.set_arity(arity);
+        return *this;
+    }
+
+    /**
+     * @brief Hands value to the members, returning how many got it.
+     */
+    std::size_t operator()(const std::vector<std::string>& members, const T& value) const {
+        return static_cast<std::size_t>(m_reduce(members, value));
+    }
+};
+
+/**
+ * @brief A tree_gather collects a value from every member of a set of
+ * servers, relayed along a tree as with tree_reduce, and returns them
+ * in the order of the members. An allgather is a tree_gather whose
+ * result is then handed to the members with a tree_broadcast.
+ *
+ * @tparam In Type of the input, sent to every member.
+ * @tparam T Type of the value of each member.
+ */
+template <typename In, typename T> class tree_gather {
+
+    tree_reduce<In, std::vector<T>> m_reduce;
+
+    static std::vector<T> append(std::vector<T> a, std::vector<T> b) {
+        a.insert(a.end(), std::make_move_iterator(b.begin()), std::make_move_iterator(b.end()));
+        return a;
+    }
+
+  public:
+
+    /**
+     * @brief Defines the RPC of a gather on a member.
+     *
+     * @param e Engine of the member.
+     * @param name Name of the gather's RPC.
+     * @param local Computes the member's value from the input.
+     * @param provider_id Provider id of the RPC.
+     * @param p Pool in which the handlers run.
+     */
+    tree_gather(engine& e, const std::string& name, std::function<T(const In&)> local,
+                std::uint16_t provider_id = 0, const pool& p = pool())
+    : m_reduce(e, name,
+               [local](const In& in) { return std::vector<T>(1, local(in)); },
+               &tree_gather::append, provider_id, p) {}
+
+    /**
+     * @brief Defines the RPC of a gather on a client.
+     */
+    tree_gather(engine& e, const std::string& name, std::uint16_t provider_id = 0)
+    : m_reduce(e, name, provider_id) {}
+
+    tree_gather& set_arity(std::uint32_t arity) {
+        m_reduce.set_arity(arity);
+        return *this;
+    }
+
+    /**
+     * @brief Returns the value of each member, in the order of members.
+     */
+    std::vector<T> operator()(const std::vector<std::string>& members, const In& in) const {
+        return m_reduce(members, in);
+    }
+};
+
+} // namespace thallium
+
+#endif
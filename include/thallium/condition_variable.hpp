@@ -9,8 +9,13 @@
 
 #include <abt.h>
 #include <mutex>
+#include <type_traits>
 #include <thallium/exception.hpp>
 #include <thallium/mutex.hpp>
+#include <thallium/non_blocking.hpp>
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+#include <thallium/lock_stats.hpp>
+#endif
 
 namespace thallium {
 
@@ -42,6 +47,9 @@ class condition_variable_exception : public exception {
  */
 class condition_variable {
     ABT_cond m_cond;
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    detail::lock_site* m_site = nullptr;
+#endif
 
   public:
     /**
@@ -59,7 +67,15 @@ class condition_variable {
     /**
      * @brief Constructor.
      */
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    condition_variable(const char* file = THALLIUM_LOCK_SITE_FILE,
+                       int line = THALLIUM_LOCK_SITE_LINE)
+    : m_site(detail::lock_site::get(file, line, "condition_variable")) {
+        TL_CV_ASSERT(ABT_cond_create(&m_cond));
+    }
+#else
     condition_variable() { TL_CV_ASSERT(ABT_cond_create(&m_cond)); }
+#endif
 
     /**
      * @brief Destructor.
@@ -93,6 +109,9 @@ class condition_variable {
         }
         m_cond       = other.m_cond;
         other.m_cond = ABT_COND_NULL;
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        m_site       = other.m_site;
+#endif
         return *this;
     }
 
@@ -103,15 +122,28 @@ class condition_variable {
     condition_variable(condition_variable&& other) noexcept
     : m_cond(other.m_cond) {
         other.m_cond = ABT_COND_NULL;
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        m_site       = other.m_site;
+#endif
     }
 
     /**
      * @brief Wait on a condition variable.
      *
+     * @tparam Mutex mutex or a class derived from it (e.g. adaptive_mutex).
      * @param lock Mutex to lock when the condition is satisfied.
      */
-    void wait(std::unique_lock<mutex>& lock) {
+    template <class Mutex>
+    typename std::enable_if<std::is_base_of<mutex, Mutex>::value>::type
+    wait(std::unique_lock<Mutex>& lock) {
+        detail::check_can_block("condition_variable::wait");
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        auto start = detail::lock_site::now();
+        TL_CV_ASSERT(ABT_cond_wait(m_cond, lock.mutex()->native_handle()));
+        if(m_site) m_site->record(detail::lock_site::now() - start, true);
+#else
         TL_CV_ASSERT(ABT_cond_wait(m_cond, lock.mutex()->native_handle()));
+#endif
     }
 
     /**
@@ -123,8 +155,9 @@ class condition_variable {
      * @param lock Mutex to lock when the condition is satisfied.
      * @param pred Predicate to test.
      */
-    template <class Predicate>
-    void wait(std::unique_lock<mutex>& lock, Predicate&& pred) {
+    template <class Mutex, class Predicate>
+    typename std::enable_if<std::is_base_of<mutex, Mutex>::value>::type
+    wait(std::unique_lock<Mutex>& lock, Predicate&& pred) {
         while(!pred()) {
             wait(lock);
         }
@@ -148,10 +181,19 @@ class condition_variable {
      *
      * @return true if lock was acquired, false if timeout
      */
-    bool wait_until(std::unique_lock<mutex>& lock,
-                    const struct timespec*   abstime) {
+    template <class Mutex>
+    typename std::enable_if<std::is_base_of<mutex, Mutex>::value, bool>::type
+    wait_until(std::unique_lock<Mutex>& lock, const struct timespec* abstime) {
+        detail::check_can_block("condition_variable::wait_until");
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        auto start = detail::lock_site::now();
+        int ret =
+            ABT_cond_timedwait(m_cond, lock.mutex()->native_handle(), abstime);
+        if(m_site) m_site->record(detail::lock_site::now() - start, true);
+#else
         int ret =
             ABT_cond_timedwait(m_cond, lock.mutex()->native_handle(), abstime);
+#endif
         if(ABT_SUCCESS == ret) {
             return true;
         } else if(ABT_ERR_COND_TIMEDOUT == ret) {
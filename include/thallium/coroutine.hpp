@@ -0,0 +1,383 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_COROUTINE_HPP
+#define __THALLIUM_COROUTINE_HPP
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define THALLIUM_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifdef THALLIUM_HAS_COROUTINES
+
+#include <abt.h>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <thallium/async_response.hpp>
+#include <thallium/eventual.hpp>
+#include <thallium/function_util.hpp>
+#include <thallium/packed_data.hpp>
+#include <thallium/request.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Returns the pool of the calling ULT or task, or ABT_POOL_NULL.
+ */
+inline ABT_pool coroutine_current_pool() {
+    ABT_thread self = ABT_THREAD_NULL;
+    ABT_pool   pool = ABT_POOL_NULL;
+    if(ABT_self_get_thread(&self) != ABT_SUCCESS) return ABT_POOL_NULL;
+    if(ABT_thread_get_last_pool(self, &pool) != ABT_SUCCESS) return ABT_POOL_NULL;
+    return pool;
+}
+
+/**
+ * @private
+ * @brief Resumes a coroutine in a new ULT of the pool (in place if the
+ * pool is null). A ULT rather than a task is used since the code that
+ * follows a co_await commonly blocks (e.g. request::respond); its stack
+ * is only held until the coroutine suspends again or completes.
+ */
+inline void coroutine_resume_in(ABT_pool pool, std::coroutine_handle<> h) {
+    if(pool == ABT_POOL_NULL) {
+        h.resume();
+        return;
+    }
+    eventual_submit(pool, [h]() { h.resume(); }, true);
+}
+
+/**
+ * @private
+ * @brief Awaiter for eventual<T>: the coroutine is resumed in the pool
+ * it was running in once the eventual is set, without any ULT waiting.
+ */
+template <typename T> struct eventual_awaiter {
+
+    using value_type = typename eventual<T>::value_type;
+
+    std::shared_ptr<eventual_state<value_type>> m_state;
+    bool                                        m_move;
+
+    eventual_awaiter(eventual<T>& ev, bool move)
+    : m_state(ev.m_state), m_move(move) {}
+
+    bool await_ready() { return m_state->test(); }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        ABT_pool pool  = coroutine_current_pool();
+        auto     state = m_state;
+        state->on_ready([pool, h]() { coroutine_resume_in(pool, h); });
+    }
+
+    value_type await_resume() {
+        m_state->wait();
+        if(m_move) return std::move(m_state->m_value);
+        return m_state->m_value;
+    }
+};
+
+template <> struct eventual_awaiter<void> {
+
+    std::shared_ptr<eventual_state<void>> m_state;
+
+    eventual_awaiter(eventual<void>& ev, bool)
+    : m_state(ev.m_state) {}
+
+    bool await_ready() { return m_state->test(); }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        ABT_pool pool  = coroutine_current_pool();
+        auto     state = m_state;
+        state->on_ready([pool, h]() { coroutine_resume_in(pool, h); });
+    }
+
+    void await_resume() { m_state->wait(); }
+};
+
+/**
+ * @private
+ * @brief Awaiter for async_response. Margo has no completion callback
+ * for RPCs, so a ULT of the coroutine's pool waits for the response and
+ * resumes the coroutine.
+ */
+struct async_response_awaiter {
+
+    async_response               m_response;
+    std::optional<packed_data<>> m_result;
+    std::exception_ptr           m_error;
+
+    explicit async_response_awaiter(async_response&& r)
+    : m_response(std::move(r)) {}
+
+    bool await_ready() { return m_response.received(); }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        eventual_submit(coroutine_current_pool(), [this, h]() {
+            try {
+                m_result.emplace(m_response.wait());
+            } catch(...) {
+                m_error = std::current_exception();
+            }
+            h.resume();
+        }, true);
+    }
+
+    packed_data<> await_resume() {
+        if(m_error) std::rethrow_exception(m_error);
+        if(m_result) return std::move(*m_result);
+        return m_response.wait();
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief co_await on an eventual suspends the coroutine until the
+ * eventual is set, and resumes it in the pool it was running in.
+ */
+template <typename T>
+detail::eventual_awaiter<T> operator co_await(eventual<T>& ev) {
+    return detail::eventual_awaiter<T>(ev, false);
+}
+
+template <typename T>
+detail::eventual_awaiter<T> operator co_await(eventual<T>&& ev) {
+    return detail::eventual_awaiter<T>(ev, true);
+}
+
+/**
+ * @brief co_await on an async_response (e.g. returned by
+ * rpc.on(ep).async(args)) suspends the coroutine until the response is
+ * received and evaluates to the packed_data of the response.
+ */
+inline detail::async_response_awaiter operator co_await(async_response&& r) {
+    return detail::async_response_awaiter(std::move(r));
+}
+
+/**
+ * @brief Return type of coroutines using co_await on thallium objects.
+ * The coroutine starts running as soon as it is called. The coroutine
+ * object may be co_awaited by another coroutine, which obtains its
+ * result (or exception), or simply destroyed, in which case the
+ * coroutine keeps running detached and frees itself once it completes
+ * (an exception escaping it is then lost).
+ *
+ * \code{.cpp}
+ * engine.define("fetch", tl::coroutine_handler(
+ *     [&](tl::request req, tl::bulk remote) -> tl::coroutine<> {
+ *         auto size = co_await remote.on(req.get_endpoint()).async_pull_to(local);
+ *         int  r    = co_await other_rpc.on(ep).async(size);
+ *         req.respond(r);
+ *     }));
+ * \endcode
+ *
+ * @tparam T Type of value returned by the coroutine.
+ */
+template <typename T = void> class coroutine;
+
+namespace detail {
+
+enum coroutine_state : int {
+    coroutine_running   = 0,
+    coroutine_awaited   = 1,
+    coroutine_detached  = 2,
+    coroutine_completed = 3
+};
+
+struct coroutine_promise_base {
+
+    std::atomic<int>        m_state{coroutine_running};
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr      m_error;
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+
+    template <typename Promise>
+    struct final_awaiter {
+        bool await_ready() noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            auto& p    = h.promise();
+            int   prev = p.m_state.exchange(coroutine_completed, std::memory_order_acq_rel);
+            if(prev == coroutine_awaited) return p.m_continuation;
+            if(prev == coroutine_detached) h.destroy();
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    void unhandled_exception() noexcept { m_error = std::current_exception(); }
+};
+
+template <typename T> struct coroutine_promise : public coroutine_promise_base {
+    std::optional<T> m_value;
+
+    coroutine<T> get_return_object() noexcept;
+
+    final_awaiter<coroutine_promise> final_suspend() noexcept { return {}; }
+
+    template <typename U> void return_value(U&& v) { m_value.emplace(std::forward<U>(v)); }
+
+    T result() {
+        if(m_error) std::rethrow_exception(m_error);
+        return std::move(*m_value);
+    }
+};
+
+template <> struct coroutine_promise<void> : public coroutine_promise_base {
+
+    coroutine<void> get_return_object() noexcept;
+
+    final_awaiter<coroutine_promise> final_suspend() noexcept { return {}; }
+
+    void return_void() noexcept {}
+
+    void result() {
+        if(m_error) std::rethrow_exception(m_error);
+    }
+};
+
+} // namespace detail
+
+template <typename T> class coroutine {
+
+  public:
+
+    using promise_type = detail::coroutine_promise<T>;
+
+  private:
+
+    friend promise_type;
+
+    std::coroutine_handle<promise_type> m_handle;
+
+    explicit coroutine(std::coroutine_handle<promise_type> h) noexcept
+    : m_handle(h) {}
+
+    struct awaiter {
+        std::coroutine_handle<promise_type> m_handle;
+
+        bool await_ready() noexcept {
+            return m_handle.promise().m_state.load(std::memory_order_acquire)
+                == detail::coroutine_completed;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) noexcept {
+            auto& p          = m_handle.promise();
+            p.m_continuation = h;
+            int expected     = detail::coroutine_running;
+            // fails if the coroutine completed in the meantime
+            return p.m_state.compare_exchange_strong(expected, detail::coroutine_awaited,
+                                                     std::memory_order_acq_rel);
+        }
+
+        T await_resume() { return m_handle.promise().result(); }
+    };
+
+  public:
+
+    coroutine(const coroutine&)            = delete;
+    coroutine& operator=(const coroutine&) = delete;
+
+    coroutine(coroutine&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    coroutine& operator=(coroutine&& other) noexcept {
+        if(this == &other) return *this;
+        release();
+        m_handle = std::exchange(other.m_handle, nullptr);
+        return *this;
+    }
+
+    /**
+     * @brief Destructor. Detaches the coroutine if it is still running.
+     */
+    ~coroutine() { release(); }
+
+    /**
+     * @brief Returns true if the coroutine has completed.
+     */
+    bool done() const noexcept {
+        return !m_handle
+            || m_handle.promise().m_state.load(std::memory_order_acquire) == detail::coroutine_completed;
+    }
+
+    /**
+     * @brief co_await on a coroutine object suspends the calling
+     * coroutine until it completes, and evaluates to its result.
+     * A coroutine object can be awaited only once.
+     */
+    awaiter operator co_await() && noexcept { return awaiter{m_handle}; }
+
+  private:
+
+    void release() noexcept {
+        if(!m_handle) return;
+        auto h = std::exchange(m_handle, nullptr);
+        int prev = h.promise().m_state.exchange(detail::coroutine_detached, std::memory_order_acq_rel);
+        if(prev == detail::coroutine_completed) h.destroy();
+    }
+};
+
+namespace detail {
+
+template <typename T>
+coroutine<T> coroutine_promise<T>::get_return_object() noexcept {
+    return coroutine<T>(std::coroutine_handle<coroutine_promise<T>>::from_promise(*this));
+}
+
+inline coroutine<void> coroutine_promise<void>::get_return_object() noexcept {
+    return coroutine<void>(std::coroutine_handle<coroutine_promise<void>>::from_promise(*this));
+}
+
+template <typename Signature> struct coroutine_handler_traits;
+
+template <typename R, typename Req, typename... Args>
+struct coroutine_handler_traits<R(Req, Args...)> {
+    using function_type = std::function<void(const request&, Args...)>;
+
+    template <typename F>
+    static function_type wrap(F&& f) {
+        return [f = std::forward<F>(f)](const request& req, Args... args) mutable {
+            // the coroutine gets its own copy of the request, which outlives
+            // the call to the handler; the returned coroutine object is
+            // dropped, so the coroutine runs detached
+            f(request(req), std::forward<Args>(args)...);
+        };
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Adapts a coroutine taking a request (by value) and the RPC
+ * arguments so that it can be passed to engine::define or
+ * provider::define. The coroutine runs detached; it must take its
+ * arguments by value since they outlive the call of the handler.
+ */
+template <typename F>
+typename detail::coroutine_handler_traits<typename function_signature<F>::type>::function_type
+coroutine_handler(F&& f) {
+    using traits = detail::coroutine_handler_traits<typename function_signature<F>::type>;
+    return traits::wrap(std::forward<F>(f));
+}
+
+} // namespace thallium
+
+#endif // THALLIUM_HAS_COROUTINES
+
+#endif
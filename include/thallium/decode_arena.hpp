@@ -0,0 +1,184 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_DECODE_ARENA_HPP
+#define __THALLIUM_DECODE_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#include <optional>
+#define THALLIUM_HAS_PMR 1
+#endif
+#endif
+
+namespace thallium {
+
+#ifdef THALLIUM_HAS_PMR
+
+/**
+ * @brief A decode_arena is a monotonic memory resource into which
+ * std::pmr arguments and return values are decoded: the strings and
+ * containers of an RPC's arguments are carved out of a few large
+ * blocks, released in one step when the arena is destroyed, instead of
+ * each going through the global allocator.
+ *
+ * RPC handlers taking std::pmr types (e.g. std::pmr::string,
+ * std::pmr::vector<std::pmr::string>) have their arguments decoded
+ * into a decode_arena created for the request and destroyed when the
+ * handler returns; such arguments, and anything still referencing
+ * their memory, must therefore not outlive the handler (copy them into
+ * containers using another allocator to keep them). On the client
+ * side, an arena can be passed as serialization context:
+ *
+ * \code{.cpp}
+ * tl::decode_arena arena;
+ * auto resp = rpc.on(ep)(args);
+ * auto v = resp.with_serialization_context(std::ref(arena))
+ *              .as<std::pmr::vector<std::pmr::string>>();
+ * \endcode
+ *
+ * A decode_arena is not thread-safe.
+ */
+class decode_arena {
+
+    std::pmr::monotonic_buffer_resource m_resource;
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param initial_size Size of the first block requested upstream.
+     * @param upstream Resource blocks are requested from.
+     */
+    explicit decode_arena(std::size_t initial_size = 4096,
+                          std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+    : m_resource(initial_size, upstream) {}
+
+    /**
+     * @brief Constructor using a caller-provided buffer first.
+     */
+    decode_arena(void* buffer, std::size_t size,
+                 std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+    : m_resource(buffer, size, upstream) {}
+
+    decode_arena(const decode_arena&)            = delete;
+    decode_arena& operator=(const decode_arena&) = delete;
+
+    /**
+     * @brief Returns the underlying memory resource.
+     */
+    std::pmr::memory_resource* resource() noexcept { return &m_resource; }
+
+    /**
+     * @brief Returns an allocator using the arena.
+     */
+    std::pmr::polymorphic_allocator<std::byte> allocator() noexcept {
+        return std::pmr::polymorphic_allocator<std::byte>(&m_resource);
+    }
+
+    /**
+     * @brief Releases all the memory allocated from the arena. Objects
+     * allocated from it must have been destroyed.
+     */
+    void release() { m_resource.release(); }
+};
+
+#else
+
+class decode_arena;
+
+#endif
+
+namespace detail {
+
+inline decode_arena* get_decode_arena_if(decode_arena& arena, std::true_type) {
+    return &arena;
+}
+
+template <typename T>
+inline decode_arena* get_decode_arena_if(T&, std::false_type) { return nullptr; }
+
+/**
+ * @private
+ * @brief Finds a decode_arena in a serialization context (passed as
+ * std::ref(arena)), returns nullptr if there is none.
+ */
+template <std::size_t I = 0, typename... CtxArg>
+inline typename std::enable_if<I == sizeof...(CtxArg), decode_arena*>::type
+find_decode_arena(std::tuple<CtxArg...>&) {
+    return nullptr;
+}
+
+template <std::size_t I = 0, typename... CtxArg>
+inline typename std::enable_if<(I < sizeof...(CtxArg)), decode_arena*>::type
+find_decode_arena(std::tuple<CtxArg...>& ctx) {
+    using element = typename std::decay<
+        typename std::tuple_element<I, std::tuple<CtxArg...>>::type>::type;
+    decode_arena* arena = get_decode_arena_if(std::get<I>(ctx),
+                                              std::is_same<element, decode_arena>());
+    return arena ? arena : find_decode_arena<I + 1>(ctx);
+}
+
+/**
+ * @private
+ * @brief Storage for a tuple of values to decode. If any of the types
+ * uses a polymorphic allocator, the tuple is constructed with an
+ * allocator of a decode_arena: the one found in the serialization
+ * context or, if own_arena is true, one owned by the storage. Otherwise
+ * it uses the default memory resource.
+ */
+template <typename Tuple, bool = false>
+struct arena_decoded {
+    Tuple value;
+    explicit arena_decoded(decode_arena*, bool own_arena = false) {
+        (void)own_arena;
+    }
+};
+
+#ifdef THALLIUM_HAS_PMR
+template <typename Tuple> struct tuple_uses_pmr;
+
+template <typename... T> struct tuple_uses_pmr<std::tuple<T...>>
+: std::integral_constant<bool,
+    (std::uses_allocator<T, std::pmr::polymorphic_allocator<std::byte>>::value || ... || false)> {};
+
+template <typename Tuple>
+using arena_decoded_t = arena_decoded<Tuple, tuple_uses_pmr<Tuple>::value>;
+
+template <typename Tuple>
+struct arena_decoded<Tuple, true> {
+    std::optional<decode_arena> own;
+    Tuple                       value;
+
+    static std::pmr::memory_resource* pick(decode_arena* arena, bool own_arena,
+                                           std::optional<decode_arena>& own) {
+        if(arena) return arena->resource();
+        if(!own_arena) return std::pmr::get_default_resource();
+        own.emplace();
+        return own->resource();
+    }
+
+    explicit arena_decoded(decode_arena* arena, bool own_arena = false)
+    : value(std::allocator_arg, std::pmr::polymorphic_allocator<std::byte>(
+                                    pick(arena, own_arena, own))) {}
+};
+#else
+template <typename Tuple>
+using arena_decoded_t = arena_decoded<Tuple>;
+#endif
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,556 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_DELTA_SYNC_HPP
+#define __THALLIUM_DELTA_SYNC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/large.hpp>
+#include <thallium/margo_exception.hpp>
+#include <thallium/mutex.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/proc_object.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/request.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+inline std::string delta_sync_rpc_name(const std::string& key) {
+    return "__thallium_delta_sync__:" + key;
+}
+
+/**
+ * @private
+ * @brief Replies of the delta sync RPC.
+ */
+enum delta_sync_status : int {
+    delta_sync_applied  = 0, // the receiver's copy is up to date
+    delta_sync_mismatch = 1, // the receiver's copy is not the base: send it all
+    delta_sync_failed   = 2  // the patched encoding could not be decoded
+};
+
+/**
+ * @private
+ * @brief Hash of an encoding, identifying the version a delta applies to.
+ */
+inline std::uint64_t delta_hash(const char* data, std::size_t size) {
+    std::uint64_t h = 0xcbf29ce484222325ULL ^ size;
+    std::size_t   i = 0;
+    for(; i + 8 <= size; i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    for(; i < size; i++) h = (h ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ULL;
+    return h;
+}
+
+/**
+ * @private
+ * @brief Rolling checksum of a block (Adler-32 style, as used by rsync),
+ * which can be moved by one byte in constant time.
+ */
+class delta_rolling_sum {
+
+    std::uint32_t m_a = 0;
+    std::uint32_t m_b = 0;
+    std::size_t   m_n = 0;
+
+  public:
+
+    delta_rolling_sum(const char* data, std::size_t n)
+    : m_n(n) {
+        for(std::size_t i = 0; i < n; i++) {
+            m_a += static_cast<unsigned char>(data[i]);
+            m_b += static_cast<std::uint32_t>(n - i) * static_cast<unsigned char>(data[i]);
+        }
+    }
+
+    void roll(char out, char in) {
+        m_a += static_cast<unsigned char>(in) - static_cast<std::uint32_t>(static_cast<unsigned char>(out));
+        m_b += m_a - static_cast<std::uint32_t>(m_n) * static_cast<unsigned char>(out);
+    }
+
+    std::uint32_t value() const {
+        return (m_a & 0xffff) | (m_b << 16);
+    }
+};
+
+/**
+ * @private
+ * @brief Operations of a delta: copy count blocks of the base starting
+ * at block first, or append literal bytes.
+ */
+enum : std::uint8_t { delta_op_copy = 0, delta_op_literal = 1 };
+
+inline void delta_put(std::vector<char>& out, std::uint64_t v) {
+    char buf[8];
+    std::memcpy(buf, &v, 8);
+    out.insert(out.end(), buf, buf + 8);
+}
+
+inline bool delta_get(const char*& p, const char* end, std::uint64_t& v) {
+    if(end - p < 8) return false;
+    std::memcpy(&v, p, 8);
+    p += 8;
+    return true;
+}
+
+/**
+ * @private
+ * @brief Computes the operations turning base into target, matching
+ * the blocks of base wherever they appear in target (so that insertions
+ * and removals only cost the bytes that changed).
+ */
+inline std::vector<char> delta_encode(const std::vector<char>& base,
+                                      const std::vector<char>& target,
+                                      std::size_t block_size) {
+    std::vector<char> ops;
+    std::size_t       nblocks = base.size() / block_size;
+    std::unordered_multimap<std::uint32_t, std::size_t> blocks;
+    blocks.reserve(nblocks);
+    for(std::size_t i = 0; i < nblocks; i++)
+        blocks.emplace(delta_rolling_sum(base.data() + i * block_size, block_size).value(), i);
+
+    std::size_t literal_start = 0;
+    std::size_t copy_first = 0, copy_count = 0;
+    auto flush_copy = [&]() {
+        if(copy_count == 0) return;
+        ops.push_back(static_cast<char>(delta_op_copy));
+        delta_put(ops, copy_first);
+        delta_put(ops, copy_count);
+        copy_count = 0;
+    };
+    auto flush_literal = [&](std::size_t end) {
+        if(end == literal_start) return;
+        flush_copy();
+        ops.push_back(static_cast<char>(delta_op_literal));
+        delta_put(ops, end - literal_start);
+        ops.insert(ops.end(), target.data() + literal_start, target.data() + end);
+    };
+    auto matches = [&](std::size_t block, std::size_t pos) {
+        return std::memcmp(base.data() + block * block_size, target.data() + pos, block_size) == 0;
+    };
+
+    std::size_t pos = 0;
+    if(nblocks > 0 && target.size() >= block_size) {
+        delta_rolling_sum sum(target.data(), block_size);
+        while(true) {
+            // prefer the block following the last one copied, so that
+            // unchanged runs become a single operation
+            std::size_t found = nblocks;
+            std::size_t next  = copy_first + copy_count;
+            if(copy_count > 0 && literal_start == pos && next < nblocks
+            && matches(next, pos)) {
+                found = next;
+            } else {
+                auto range = blocks.equal_range(sum.value());
+                for(auto it = range.first; it != range.second; ++it) {
+                    if(matches(it->second, pos)) {
+                        found = it->second;
+                        break;
+                    }
+                }
+            }
+            if(found < nblocks) {
+                flush_literal(pos);
+                if(copy_count > 0 && found == copy_first + copy_count) {
+                    copy_count += 1;
+                } else {
+                    flush_copy();
+                    copy_first = found;
+                    copy_count = 1;
+                }
+                pos += block_size;
+                literal_start = pos;
+                if(target.size() - pos < block_size) break;
+                sum = delta_rolling_sum(target.data() + pos, block_size);
+            } else {
+                if(target.size() - pos == block_size) break;
+                sum.roll(target[pos], target[pos + block_size]);
+                pos += 1;
+            }
+        }
+    }
+    flush_literal(target.size());
+    flush_copy();
+    return ops;
+}
+
+/**
+ * @private
+ * @brief Applies delta operations to base. Returns false if they are
+ * malformed.
+ */
+inline bool delta_apply(const std::vector<char>& base, const std::vector<char>& ops,
+                        std::size_t block_size, std::size_t size, std::vector<char>& out) {
+    out.clear();
+    out.reserve(size);
+    const char* p   = ops.data();
+    const char* end = p + ops.size();
+    while(p < end) {
+        std::uint8_t op = static_cast<std::uint8_t>(*p++);
+        if(op == delta_op_copy) {
+            std::uint64_t first, count;
+            if(!delta_get(p, end, first) || !delta_get(p, end, count)) return false;
+            if(block_size == 0 || first > base.size() / block_size
+            || count > base.size() / block_size - first)
+                return false;
+            out.insert(out.end(), base.data() + first * block_size,
+                       base.data() + (first + count) * block_size);
+        } else if(op == delta_op_literal) {
+            std::uint64_t n;
+            if(!delta_get(p, end, n) || n > static_cast<std::uint64_t>(end - p)) return false;
+            out.insert(out.end(), p, p + n);
+            p += n;
+        } else {
+            return false;
+        }
+        if(out.size() > size) return false;
+    }
+    return out.size() == size;
+}
+
+/**
+ * @private
+ * @brief Encodes value the way it would be sent as an RPC argument.
+ */
+template <typename T>
+std::vector<char> delta_encode_value(margo_instance_id mid, const T& value) {
+    auto              t = std::make_tuple(std::cref(value));
+    std::tuple<>      ctx;
+    std::vector<char> buffer(get_encoded_size(t, mid, ctx));
+    if(buffer.empty()) return buffer;
+    hg_proc_t   proc = HG_PROC_NULL;
+    hg_return_t ret  = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                          HG_ENCODE, HG_NOHASH, &proc);
+    MARGO_ASSERT(ret, hg_proc_create_set);
+    ret = proc_object_encode(proc, t, mid, ctx);
+    hg_proc_free(proc);
+    MARGO_ASSERT(ret, proc_object_encode);
+    return buffer;
+}
+
+/**
+ * @private
+ * @brief Decodes an encoding into an existing value, like
+ * packed_data::unpack_into, so that its storage is reused.
+ */
+template <typename T>
+hg_return_t delta_decode_value(margo_instance_id mid, std::vector<char>& buffer, T& value) {
+    auto         t = std::make_tuple(std::ref(value));
+    std::tuple<> ctx;
+    hg_proc_t    proc = HG_PROC_NULL;
+    hg_return_t  ret  = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                           HG_DECODE, HG_NOHASH, &proc);
+    if(ret != HG_SUCCESS) return ret;
+    ret = proc_object_decode(proc, t, mid, ctx);
+    hg_proc_free(proc);
+    return ret;
+}
+
+} // namespace detail
+
+/**
+ * @brief A delta_receiver holds a replica of a state object of type T
+ * kept up to date by a delta_sender with the same key. It keeps the
+ * encoding it last received, patches it with the deltas it receives
+ * and decodes the result into its copy of the object (reusing its
+ * storage, as packed_data::unpack_into does).
+ *
+ * \code{.cpp}
+ * // on the replicas
+ * tl::delta_receiver<std::map<std::string, record>> table(engine, "table");
+ * table.read([](const auto& t) { lookup(t); });
+ * // on the primary
+ * tl::delta_sender<std::map<std::string, record>> sender(engine, "table");
+ * sender.sync(replicas, table);  // every interval
+ * \endcode
+ *
+ * @tparam T Type of the state, which must be serializable.
+ */
+template <typename T> class delta_receiver {
+
+  public:
+
+    using callback_type = std::function<void(const T&)>;
+
+    /**
+     * @brief Defines the RPC receiving the deltas of the given key.
+     *
+     * @param e Engine.
+     * @param key Name of the state.
+     * @param on_update Function called (with the lock held) after each update.
+     * @param provider_id Provider id of the RPC.
+     * @param p Pool in which the handler runs.
+     */
+    delta_receiver(engine& e, const std::string& key, callback_type on_update = callback_type(),
+                   std::uint16_t provider_id = 0, const pool& p = pool())
+    : m_state(std::make_shared<state>()) {
+        m_state->mid       = e.get_margo_instance();
+        m_state->on_update = std::move(on_update);
+        std::weak_ptr<state> weak = m_state;
+        std::function<void(const request&, std::uint64_t, std::uint64_t, std::uint64_t,
+                           std::uint64_t, bool, const large<std::vector<char>>&)>
+            handler = [weak](const request& req, std::uint64_t base_hash, std::uint64_t hash,
+                             std::uint64_t size, std::uint64_t block_size, bool full,
+                             const large<std::vector<char>>& delta) {
+                auto s = weak.lock();
+                int  status = s ? s->apply(base_hash, hash, size, block_size, full, delta.get())
+                                : static_cast<int>(detail::delta_sync_mismatch);
+                req.respond(status);
+            };
+        e.define(detail::delta_sync_rpc_name(key), std::move(handler), provider_id, p);
+    }
+
+    delta_receiver(const delta_receiver&)            = delete;
+    delta_receiver& operator=(const delta_receiver&) = delete;
+
+    /**
+     * @brief Calls f with the current value, preventing updates while
+     * it runs, and returns its result.
+     */
+    template <typename F> auto read(F&& f) const -> decltype(f(std::declval<const T&>())) {
+        std::lock_guard<thallium::mutex> lock(m_state->mtx);
+        return f(static_cast<const T&>(m_state->value));
+    }
+
+    /**
+     * @brief Returns a copy of the current value.
+     */
+    T get() const {
+        std::lock_guard<thallium::mutex> lock(m_state->mtx);
+        return m_state->value;
+    }
+
+    /**
+     * @brief Number of updates received so far.
+     */
+    std::size_t updates() const {
+        std::lock_guard<thallium::mutex> lock(m_state->mtx);
+        return m_state->updates;
+    }
+
+  private:
+
+    struct state {
+        mutable thallium::mutex mtx;
+        margo_instance_id       mid = MARGO_INSTANCE_NULL;
+        T                       value;
+        std::vector<char>       encoding;
+        std::vector<char>       scratch;
+        std::uint64_t           hash = detail::delta_hash(nullptr, 0);
+        std::size_t             updates = 0;
+        callback_type           on_update;
+
+        int apply(std::uint64_t base_hash, std::uint64_t new_hash, std::uint64_t size,
+                  std::uint64_t block_size, bool full, const std::vector<char>& delta) {
+            std::lock_guard<thallium::mutex> lock(mtx);
+            if(full) {
+                scratch = delta;
+            } else {
+                if(base_hash != hash) return detail::delta_sync_mismatch;
+                if(!detail::delta_apply(encoding, delta, block_size, size, scratch))
+                    return detail::delta_sync_mismatch;
+            }
+            if(scratch.size() != size
+            || detail::delta_hash(scratch.data(), scratch.size()) != new_hash)
+                return detail::delta_sync_mismatch;
+            std::swap(encoding, scratch);
+            hash = new_hash;
+            if(detail::delta_decode_value(mid, encoding, value) != HG_SUCCESS) {
+                // force a full transfer next time
+                encoding.clear();
+                hash = detail::delta_hash(nullptr, 0);
+                return detail::delta_sync_failed;
+            }
+            updates += 1;
+            if(on_update) on_update(value);
+            return detail::delta_sync_applied;
+        }
+    };
+
+    std::shared_ptr<state> m_state;
+};
+
+/**
+ * @brief A delta_sender keeps replicas of a state object (delta_receiver
+ * objects with the same key) up to date by sending them only what
+ * changed since the last synchronization. It encodes the object with
+ * thallium's serialization, remembers the encoding each replica last
+ * acknowledged (replicas that got the same encoding share a copy), and
+ * sends the difference, computed rsync-style: blocks of the previous
+ * encoding are looked up at every position of the new one with a rolling
+ * checksum, so that changed, inserted or removed entries only cost their
+ * own bytes. A replica whose copy does not match (e.g. it restarted)
+ * gets the whole encoding. Deltas are sent as large<std::vector<char>>
+ * arguments, hence by RDMA when they are big.
+ *
+ * Calls to sync are serialized.
+ *
+ * @tparam T Type of the state, which must be serializable.
+ */
+template <typename T> class delta_sender {
+
+  public:
+
+    /**
+     * @brief Parameters of a delta_sender.
+     */
+    struct options {
+        std::size_t block_size = 4096; /*!< granularity at which changes are detected */
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param e Engine.
+     * @param key Name of the state.
+     * @param opts Options.
+     */
+    delta_sender(engine& e, const std::string& key, options opts)
+    : m_mid(e.get_margo_instance())
+    , m_rpc(e.define(detail::delta_sync_rpc_name(key)))
+    , m_opts(opts) {
+        if(m_opts.block_size == 0) m_opts.block_size = 1;
+    }
+
+    /**
+     * @brief Constructor with the default options.
+     */
+    delta_sender(engine& e, const std::string& key)
+    : delta_sender(e, key, options()) {}
+
+    delta_sender(const delta_sender&)            = delete;
+    delta_sender& operator=(const delta_sender&) = delete;
+
+    /**
+     * @brief Brings the replica to the given value.
+     *
+     * @return the number of bytes sent.
+     */
+    std::size_t sync(const provider_handle& replica, const T& value) {
+        return sync(std::vector<provider_handle>{replica}, value);
+    }
+
+    /**
+     * @brief Brings the replicas to the given value, encoding it once.
+     * Throws an exception if a replica could not decode it.
+     *
+     * @return the number of bytes sent.
+     */
+    std::size_t sync(const std::vector<provider_handle>& replicas, const T& value) {
+        std::lock_guard<thallium::mutex> lock(m_mutex);
+        auto encoding = std::make_shared<std::vector<char>>(
+            detail::delta_encode_value(m_mid, value));
+        std::uint64_t hash  = detail::delta_hash(encoding->data(), encoding->size());
+        std::size_t   bytes = 0;
+        // payloads are shared by the replicas with the same base, so that
+        // each is computed and registered for RDMA once
+        std::unique_ptr<payload> full;
+        std::map<const std::vector<char>*, std::unique_ptr<payload>> deltas;
+        for(auto& r : replicas) {
+            auto& peer = m_peers[key_of(r)];
+            if(peer.encoding && peer.hash == hash) continue;
+            if(peer.encoding) {
+                auto& delta = deltas[peer.encoding.get()];
+                if(!delta)
+                    delta.reset(new payload(detail::delta_encode(*peer.encoding, *encoding,
+                                                                 m_opts.block_size)));
+                if(delta->data.size() < encoding->size()) {
+                    int status = send(r, peer.hash, hash, encoding->size(), false, *delta);
+                    bytes += delta->data.size();
+                    if(status == detail::delta_sync_applied) {
+                        peer.encoding = encoding;
+                        peer.hash     = hash;
+                        continue;
+                    }
+                    if(status == detail::delta_sync_failed) {
+                        m_peers.erase(key_of(r));
+                        throw exception("delta_sender: replica failed to decode the state");
+                    }
+                }
+            }
+            if(!full) full.reset(new payload(*encoding));
+            int status = send(r, 0, hash, encoding->size(), true, *full);
+            bytes += encoding->size();
+            if(status != detail::delta_sync_applied) {
+                m_peers.erase(key_of(r));
+                throw exception("delta_sender: replica failed to apply the state");
+            }
+            peer.encoding = encoding;
+            peer.hash     = hash;
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief Forgets what was sent to a replica, so that the next sync
+     * sends it the whole state.
+     */
+    void forget(const provider_handle& replica) {
+        std::lock_guard<thallium::mutex> lock(m_mutex);
+        m_peers.erase(key_of(replica));
+    }
+
+  private:
+
+    struct peer {
+        std::shared_ptr<const std::vector<char>> encoding;
+        std::uint64_t                            hash = 0;
+    };
+
+    struct payload {
+        std::vector<char>        data;
+        large<std::vector<char>> arg;
+
+        explicit payload(std::vector<char> d)
+        : data(std::move(d))
+        , arg(data) {}
+
+        payload(const payload&)            = delete;
+        payload& operator=(const payload&) = delete;
+    };
+
+    margo_instance_id                     m_mid;
+    remote_procedure                      m_rpc;
+    options                               m_opts;
+    thallium::mutex                       m_mutex;
+    std::unordered_map<std::string, peer> m_peers;
+
+    static std::string key_of(const provider_handle& r) {
+        return static_cast<std::string>(r) + "#" + std::to_string(r.provider_id());
+    }
+
+    int send(const provider_handle& r, std::uint64_t base_hash, std::uint64_t hash,
+             std::size_t size, bool full, payload& p) {
+        return m_rpc.on(r)(base_hash, hash, std::uint64_t(size),
+                           std::uint64_t(m_opts.block_size), full, p.arg)
+            .as<int>();
+    }
+};
+
+} // namespace thallium
+
+#endif
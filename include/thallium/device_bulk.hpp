@@ -0,0 +1,231 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_DEVICE_BULK_HPP
+#define __THALLIUM_DEVICE_BULK_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <margo.h>
+#include <thallium/bulk.hpp>
+#include <thallium/bulk_mode.hpp>
+#include <thallium/bulk_pool.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/margo_exception.hpp>
+#include <thallium/remote_bulk.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Copies between device and host memory, provided by the
+ * application (e.g. with cudaMemcpy or hipMemcpy) for device_bulk
+ * objects that stage their transfers through host memory.
+ */
+struct device_copy {
+    std::function<void(void* host, const void* device, std::size_t size)> to_host;
+    std::function<void(void* device, const void* host, std::size_t size)> to_device;
+};
+
+/**
+ * @brief How a device_bulk transfers data.
+ */
+enum class device_transfer {
+    automatic, /*!< directly if the memory can be exposed, staged otherwise */
+    direct,    /*!< directly, failing if the memory cannot be exposed */
+    staged     /*!< through host memory */
+};
+
+/**
+ * @brief A device_bulk is a buffer in device memory (e.g. a CUDA
+ * buffer) that RDMA transfers are made to or from. If the NA plugin
+ * supports device memory, the buffer is exposed and transfers go
+ * directly to or from it (see engine::expose with a memory_type).
+ * Otherwise, they go through slabs of a bulk_pool and the device_copy
+ * functions, chunk by chunk, the RDMA transfer of a chunk overlapping
+ * with the copy of the previous one.
+ *
+ * \code{.cpp}
+ * tl::bulk_pool staging(engine, {{1 << 20, 8}});
+ * tl::device_copy copy{
+ *     [](void* h, const void* d, std::size_t n) { cudaMemcpy(h, d, n, cudaMemcpyDeviceToHost); },
+ *     [](void* d, const void* h, std::size_t n) { cudaMemcpy(d, h, n, cudaMemcpyHostToDevice); }};
+ * tl::device_bulk dst(engine, gpu_ptr, size, tl::bulk_mode::write_only,
+ *                     tl::memory_type::cuda, copy, staging);
+ * dst << remote.on(server);
+ * \endcode
+ *
+ * With device_transfer::automatic, the transfers are direct whenever
+ * Mercury accepts to expose the memory, so engines whose NA plugin
+ * registers device memory without supporting transfers to it should use
+ * device_transfer::staged.
+ */
+class device_bulk {
+
+    // slab of the staging pool holding a chunk being transferred
+    struct staged_chunk {
+        bulk_pool::lease lease;
+        async_bulk_op    op;
+        std::size_t      offset = 0;
+        std::size_t      size   = 0;
+    };
+
+    char*       m_ptr;
+    std::size_t m_size;
+    memory_type m_type;
+    bulk        m_direct;
+    bulk_pool*  m_staging = nullptr;
+    device_copy m_copy;
+
+    std::size_t chunk_size(std::size_t offset, std::size_t total) const {
+        return std::min(m_staging->max_slab_size(), total - offset);
+    }
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param e Engine used to expose the memory.
+     * @param ptr Device memory.
+     * @param size Size of the memory.
+     * @param mode Access mode of the exposed memory.
+     * @param type Type of the device memory.
+     * @param copy Copies between the device and host memory.
+     * @param staging Pool of host memory used when the transfers are staged.
+     * @param device Device the memory belongs to.
+     * @param policy Whether to transfer directly, through host memory,
+     * or directly if possible.
+     */
+    device_bulk(engine& e, void* ptr, std::size_t size, bulk_mode mode, memory_type type,
+                device_copy copy, bulk_pool& staging, std::uint64_t device = 0,
+                device_transfer policy = device_transfer::automatic)
+    : m_ptr(static_cast<char*>(ptr))
+    , m_size(size)
+    , m_type(type)
+    , m_staging(&staging)
+    , m_copy(std::move(copy)) {
+#if (HG_VERSION_MAJOR > 2) || (HG_VERSION_MAJOR == 2 && HG_VERSION_MINOR > 1) \
+    || (HG_VERSION_MAJOR == 2 && HG_VERSION_MINOR == 1                        \
+        && HG_VERSION_PATCH > 0)
+        if(policy != device_transfer::staged) {
+            try {
+                m_direct = e.expose({{ptr, size}}, mode, type, device);
+            } catch(const margo_exception&) {
+                if(policy == device_transfer::direct) throw;
+            }
+        }
+#else
+        (void)e;
+        (void)mode;
+        (void)device;
+        if(policy == device_transfer::direct && type != memory_type::host)
+            throw exception("device_bulk: this version of Mercury cannot expose device memory");
+        if(type == memory_type::host) m_direct = e.expose({{ptr, size}}, mode);
+#endif
+        if(m_direct.is_null() && (!m_copy.to_host || !m_copy.to_device))
+            throw exception("device_bulk: staged transfers need device_copy functions");
+    }
+
+    /**
+     * @brief Returns true if transfers go directly to the device memory.
+     */
+    bool is_direct() const {
+        return !m_direct.is_null();
+    }
+
+    /**
+     * @brief Returns the bulk exposing the device memory, which is null
+     * if the transfers are staged.
+     */
+    const bulk& get_bulk() const {
+        return m_direct;
+    }
+
+    void* data() const {
+        return m_ptr;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    memory_type get_memory_type() const {
+        return m_type;
+    }
+
+    /**
+     * @brief Pulls data from the remote bulk into the device memory.
+     * If the sizes don't match, the smallest size is used.
+     *
+     * @return the size of data transferred.
+     */
+    std::size_t operator<<(const remote_bulk& src) const {
+        if(is_direct()) return m_direct << src;
+        std::size_t size = std::min(m_size, src.size());
+        if(size == 0) return 0;
+        auto start = [&](std::size_t offset, bool wait) {
+            staged_chunk c;
+            c.offset = offset;
+            c.size   = chunk_size(offset, size);
+            c.lease  = wait ? m_staging->acquire(c.size) : m_staging->try_acquire(c.size);
+            if(c.lease) c.op = src.select(offset, c.size).pull_to(c.lease.segment(c.size));
+            return c;
+        };
+        staged_chunk current = start(0, true);
+        while(true) {
+            std::size_t  next_offset = current.offset + current.size;
+            staged_chunk next;
+            // the next chunk is pulled while this one is copied, if a
+            // slab is available without waiting for this one's
+            if(next_offset < size) next = start(next_offset, false);
+            current.op.wait();
+            m_copy.to_device(m_ptr + current.offset, current.lease.data(), current.size);
+            current.lease.release();
+            if(next_offset >= size) break;
+            if(!next.lease) next = start(next_offset, true);
+            current = std::move(next);
+        }
+        return size;
+    }
+
+    /**
+     * @brief Pushes data from the device memory to the remote bulk.
+     * If the sizes don't match, the smallest size is used.
+     *
+     * @return the size of data transferred.
+     */
+    std::size_t operator>>(const remote_bulk& dest) const {
+        if(is_direct()) return m_direct >> dest;
+        std::size_t  size = std::min(m_size, dest.size());
+        staged_chunk previous;
+        for(std::size_t offset = 0; offset < size;) {
+            staged_chunk c;
+            c.offset = offset;
+            c.size   = chunk_size(offset, size);
+            c.lease  = m_staging->try_acquire(c.size);
+            // without a free slab, the previous chunk's is waited for
+            if(!c.lease) {
+                if(previous.lease) previous.op.wait();
+                previous = staged_chunk();
+                c.lease  = m_staging->acquire(c.size);
+            }
+            m_copy.to_host(c.lease.data(), m_ptr + offset, c.size);
+            c.op = dest.select(offset, c.size).push_from(c.lease.segment(c.size));
+            if(previous.lease) previous.op.wait();
+            offset  += c.size;
+            previous = std::move(c);
+        }
+        if(previous.lease) previous.op.wait();
+        return size;
+    }
+};
+
+} // namespace thallium
+
+#endif
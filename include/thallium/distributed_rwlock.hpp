@@ -0,0 +1,186 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_DISTRIBUTED_RWLOCK_HPP
+#define __THALLIUM_DISTRIBUTED_RWLOCK_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thallium/adaptive_mutex.hpp>
+#include <thallium/mutex.hpp>
+
+namespace thallium {
+
+/**
+ * @brief The distributed_rwlock class is a reader-writer lock for data
+ * that is read by many execution streams and rarely written. Readers
+ * only touch a counter private to their execution stream (each on its
+ * own cache line), so that read-side acquisitions from different
+ * execution streams do not contend, whereas an ABT_rwlock makes all of
+ * them update the same cache line. Writers are more expensive: they
+ * exclude each other with a mutex, then wait for the readers of every
+ * execution stream to leave. Pending writers have priority over new
+ * readers.
+ *
+ * Waiting ULTs spin for a short while, then yield, so the lock is
+ * meant for short critical sections.
+ *
+ * lock()/unlock() acquire the lock for writing and lock_shared()/
+ * unlock_shared() for reading, so the class works with std::lock_guard,
+ * std::unique_lock and std::shared_lock. rdlock() and wrlock() are
+ * provided for consistency with the rwlock class.
+ *
+ * \code{.cpp}
+ * tl::distributed_rwlock lock;
+ * {
+ *     std::shared_lock<tl::distributed_rwlock> guard(lock); // read
+ * }
+ * {
+ *     std::lock_guard<tl::distributed_rwlock> guard(lock); // write
+ * }
+ * \endcode
+ */
+class distributed_rwlock {
+
+    // padding keeps each slot on its own cache line
+    struct reader_slot {
+        // signed: a ULT may migrate to another execution stream while
+        // holding the lock and leave from a different slot, so only the
+        // sum over all the slots is meaningful
+        std::atomic<long> m_count{0};
+        char              m_padding[64 - sizeof(std::atomic<long>)];
+    };
+
+    std::size_t                    m_num_slots;
+    std::unique_ptr<reader_slot[]> m_slots;
+    std::atomic<bool>              m_writer{false};
+    adaptive_mutex                 m_writer_mutex;
+
+    reader_slot& my_slot() const noexcept {
+        int rank = 0;
+        if(ABT_self_get_xstream_rank(&rank) != ABT_SUCCESS || rank < 0) rank = 0;
+        return m_slots[static_cast<std::size_t>(rank) % m_num_slots];
+    }
+
+    static void backoff(int& iteration) noexcept {
+        iteration += 1;
+        if(iteration < 64) {
+            detail::cpu_relax();
+            return;
+        }
+        ABT_unit_type type = ABT_UNIT_TYPE_EXT;
+        if(ABT_self_get_type(&type) == ABT_SUCCESS && type == ABT_UNIT_TYPE_THREAD)
+            ABT_thread_yield();
+        else
+            detail::cpu_relax();
+    }
+
+    long readers() const noexcept {
+        long total = 0;
+        for(std::size_t i = 0; i < m_num_slots; i++)
+            total += m_slots[i].m_count.load(std::memory_order_seq_cst);
+        return total;
+    }
+
+  public:
+    /**
+     * @brief Constructor.
+     *
+     * @param num_slots Number of reader slots. Execution streams are
+     * mapped to slots by rank, so this should be at least the number
+     * of execution streams reading the data.
+     */
+    explicit distributed_rwlock(std::size_t num_slots = 64)
+    : m_num_slots(num_slots ? num_slots : 1)
+    , m_slots(new reader_slot[m_num_slots]) {}
+
+    distributed_rwlock(const distributed_rwlock&)            = delete;
+    distributed_rwlock& operator=(const distributed_rwlock&) = delete;
+
+    /**
+     * @brief Lock for reading.
+     */
+    void lock_shared() {
+        int iteration = 0;
+        while(true) {
+            auto& slot = my_slot();
+            slot.m_count.fetch_add(1, std::memory_order_seq_cst);
+            if(!m_writer.load(std::memory_order_seq_cst)) return;
+            // a writer is active or pending, step back and wait for it
+            slot.m_count.fetch_sub(1, std::memory_order_release);
+            while(m_writer.load(std::memory_order_acquire)) backoff(iteration);
+        }
+    }
+
+    /**
+     * @brief Try locking for reading without waiting.
+     *
+     * @return true if the lock was acquired.
+     */
+    bool try_lock_shared() {
+        auto& slot = my_slot();
+        slot.m_count.fetch_add(1, std::memory_order_seq_cst);
+        if(!m_writer.load(std::memory_order_seq_cst)) return true;
+        slot.m_count.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    /**
+     * @brief Unlock after lock_shared().
+     */
+    void unlock_shared() {
+        my_slot().m_count.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Lock for writing.
+     */
+    void lock() {
+        m_writer_mutex.lock();
+        m_writer.store(true, std::memory_order_seq_cst);
+        int iteration = 0;
+        while(readers() != 0) backoff(iteration);
+    }
+
+    /**
+     * @brief Try locking for writing without waiting.
+     *
+     * @return true if the lock was acquired.
+     */
+    bool try_lock() {
+        if(!m_writer_mutex.try_lock()) return false;
+        m_writer.store(true, std::memory_order_seq_cst);
+        if(readers() == 0) return true;
+        m_writer.store(false, std::memory_order_release);
+        m_writer_mutex.unlock();
+        return false;
+    }
+
+    /**
+     * @brief Unlock after lock().
+     */
+    void unlock() {
+        m_writer.store(false, std::memory_order_release);
+        m_writer_mutex.unlock();
+    }
+
+    /**
+     * @brief Lock for reading (same as lock_shared()).
+     */
+    void rdlock() { lock_shared(); }
+
+    /**
+     * @brief Lock for writing (same as lock()).
+     */
+    void wrlock() { lock(); }
+};
+
+} // namespace thallium
+
+#endif /* end of include guard */
@@ -0,0 +1,162 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_DRAIN_HPP
+#define __THALLIUM_DRAIN_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <margo.h>
+#include <thallium/per_instance.hpp>
+#include <thallium/pool.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Requests of an RPC that were admitted (queued or running)
+ * but not completed.
+ */
+struct rpc_in_flight_entry {
+    hg_id_t       id          = 0;
+    std::uint16_t provider_id = 0;
+    std::string   name;
+    std::size_t   in_flight   = 0;
+};
+
+/**
+ * @brief Parameters of engine::finalize_with.
+ */
+struct finalize_options {
+    /**
+     * @brief Maximum time to wait for the requests in flight to
+     * complete before finalizing anyway.
+     */
+    std::chrono::milliseconds drain_timeout = std::chrono::seconds(30);
+
+    /**
+     * @brief Pools in which the finalize callbacks of different owners
+     * run in parallel (default: the engine's handler pool).
+     */
+    std::vector<pool> callback_pools;
+};
+
+/**
+ * @brief Returned by engine::finalize_with.
+ */
+struct finalize_report {
+    bool                             drained    = true; /*!< false if the timeout hit */
+    std::chrono::milliseconds        drain_time = std::chrono::milliseconds(0);
+    std::uint64_t                    rejected   = 0; /*!< requests refused while draining */
+    std::vector<rpc_in_flight_entry> in_flight;      /*!< left when the timeout hit */
+    std::size_t                      parallel_owners = 0; /*!< owners whose finalize
+                                                               callbacks ran in parallel */
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Number of requests of an RPC in flight, referenced by its
+ * rpc_callback_data.
+ */
+struct rpc_in_flight {
+    hg_id_t                  id;
+    std::uint16_t            provider_id;
+    std::string              name;
+    std::atomic<std::size_t> count{0};
+
+    rpc_in_flight(hg_id_t i, std::uint16_t p, std::string n)
+    : id(i)
+    , provider_id(p)
+    , name(std::move(n)) {}
+};
+
+/**
+ * @private
+ * @brief Draining state of a margo instance: the counters of the RPCs
+ * it defined, whether it refuses new requests, and the owners of the
+ * finalize callbacks pushed with engine::push_finalize_callback.
+ */
+class rpc_drain : public per_instance<rpc_drain> {
+
+    std::atomic<bool>          m_draining{false};
+    std::atomic<std::uint64_t> m_rejected{0};
+    std::mutex                 m_mutex;
+    std::vector<std::shared_ptr<rpc_in_flight>> m_rpcs;
+    std::unordered_set<const void*>             m_owners;
+
+  public:
+
+    static std::shared_ptr<rpc_drain> get(margo_instance_id mid) {
+        return per_instance::get(mid, instance_release::at_finalize);
+    }
+
+    /**
+     * @brief Returns the counter of a newly defined RPC.
+     */
+    std::shared_ptr<rpc_in_flight> add_rpc(hg_id_t id, std::uint16_t provider_id,
+                                           const std::string& name) {
+        auto c = std::make_shared<rpc_in_flight>(id, provider_id, name);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rpcs.push_back(c);
+        return c;
+    }
+
+    void add_owner(const void* owner) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_owners.insert(owner);
+    }
+
+    std::vector<const void*> owners() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::vector<const void*>(m_owners.begin(), m_owners.end());
+    }
+
+    bool draining() const { return m_draining.load(std::memory_order_relaxed); }
+
+    void start() { m_draining.store(true, std::memory_order_relaxed); }
+
+    void count_rejected() { m_rejected.fetch_add(1, std::memory_order_relaxed); }
+
+    std::uint64_t rejected() const { return m_rejected.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the RPCs with requests in flight, not counting one
+     * request of the RPC of id exclude (the handler calling finalize).
+     */
+    std::vector<rpc_in_flight_entry> in_flight(hg_id_t exclude) {
+        std::vector<rpc_in_flight_entry> result;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bool excluded = false;
+        for(auto& c : m_rpcs) {
+            std::size_t n = c->count.load(std::memory_order_acquire);
+            if(!excluded && exclude != 0 && c->id == exclude && n > 0) {
+                n -= 1;
+                excluded = true;
+            }
+            if(n == 0) continue;
+            rpc_in_flight_entry e;
+            e.id          = c->id;
+            e.provider_id = c->provider_id;
+            e.name        = c->name;
+            e.in_flight   = n;
+            result.push_back(std::move(e));
+        }
+        return result;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
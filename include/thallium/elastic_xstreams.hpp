@@ -0,0 +1,255 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_ELASTIC_XSTREAMS_HPP
+#define __THALLIUM_ELASTIC_XSTREAMS_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <margo.h>
+#include <thallium/anonymous.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/managed.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/scheduler.hpp>
+#include <thallium/timed_callback.hpp>
+#include <thallium/xstream.hpp>
+
+namespace thallium {
+
+/**
+ * @brief An elastic_xstreams controller adds execution streams to a
+ * pool (by default the handler pool of an engine) when it is loaded,
+ * and removes them when it is idle, between a minimum and a maximum,
+ * so that cores sized for peak load are given back to other jobs
+ * during quiet periods.
+ *
+ * Every interval_ms, the controller samples the number of work units
+ * in the pool per execution stream and the scheduling delay of a probe
+ * ULT it pushes into the pool. It adds an execution stream after
+ * grow_after consecutive samples above grow_depth or latency_ms, and
+ * removes one after shrink_after consecutive samples below shrink_depth
+ * and latency_ms / 2. Different thresholds and sample counts for both
+ * directions prevent oscillation.
+ *
+ * \code{.cpp}
+ * tl::elastic_xstreams::options opts;
+ * opts.min_xstreams = 2;
+ * opts.max_xstreams = 28;
+ * opts.latency_ms   = 0.5;
+ * tl::elastic_xstreams elastic(engine, opts);
+ * \endcode
+ *
+ * The execution streams of the controller run in addition to those the
+ * pool already has. A removed execution stream finishes the work unit
+ * it is running (units it was blocked on go back to the shared pool)
+ * and is joined on a later sample, so the progress loop running the
+ * controller never waits for a handler. The controller stops, and joins
+ * its execution streams, when the engine is finalized or when it is
+ * destroyed, whichever comes first.
+ */
+class elastic_xstreams {
+
+  public:
+
+    /**
+     * @brief Parameters of an elastic_xstreams controller.
+     */
+    struct options {
+        std::size_t       min_xstreams = 0;      /*!< execution streams kept when idle */
+        std::size_t       max_xstreams = 8;      /*!< execution streams added at most */
+        double            interval_ms  = 100.0;  /*!< time between samples */
+        double            grow_depth   = 2.0;    /*!< units per xstream above which to grow */
+        double            shrink_depth = 0.25;   /*!< units per xstream below which to shrink */
+        double            latency_ms   = 1.0;    /*!< scheduling delay above which to grow */
+        unsigned          grow_after   = 2;      /*!< consecutive loaded samples to grow */
+        unsigned          shrink_after = 50;     /*!< consecutive idle samples to shrink */
+        scheduler::predef sched = scheduler::predef::basic_wait; /*!< scheduler of the xstreams */
+    };
+
+    /**
+     * @brief Constructor. Creates min_xstreams execution streams on the
+     * pool and starts sampling.
+     *
+     * @param e Engine whose progress loop runs the controller.
+     * @param p Pool the execution streams are bound to.
+     * @param opts Options.
+     */
+    elastic_xstreams(const engine& e, const pool& p, options opts)
+    : m_mid(e.get_margo_instance())
+    , m_pool(p)
+    , m_opts(opts) {
+        if(m_opts.max_xstreams < m_opts.min_xstreams)
+            m_opts.max_xstreams = m_opts.min_xstreams;
+        if(m_opts.interval_ms <= 0.0)
+            throw exception("elastic_xstreams: interval_ms must be positive");
+        for(std::size_t i = 0; i < m_opts.min_xstreams; i++) grow();
+        m_timer = std::make_unique<timed_callback>(
+            engine(m_mid).create_timed_callback([this]() { tick(); }));
+        m_running = true;
+        m_timer->start(m_opts.interval_ms);
+        margo_provider_push_prefinalize_callback(
+            m_mid, this, &elastic_xstreams::on_finalize, this);
+    }
+
+    /**
+     * @brief Constructor controlling the handler pool of the engine.
+     */
+    elastic_xstreams(const engine& e, options opts)
+    : elastic_xstreams(e, e.get_handler_pool(), opts) {}
+
+    elastic_xstreams(const elastic_xstreams&)            = delete;
+    elastic_xstreams& operator=(const elastic_xstreams&) = delete;
+
+    ~elastic_xstreams() {
+        if(stop()) margo_provider_pop_prefinalize_callback(m_mid, this);
+    }
+
+    /**
+     * @brief Returns the number of execution streams currently added
+     * by the controller.
+     */
+    std::size_t num_xstreams() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_active.size();
+    }
+
+    /**
+     * @brief Returns the scheduling delay measured by the last probe,
+     * in milliseconds.
+     */
+    double last_latency_ms() const {
+        return m_probe->delay_ms.load();
+    }
+
+  private:
+
+    // state of the probe ULT, shared with it so that it can outlive
+    // the controller
+    struct probe {
+        std::atomic<bool>   pending{false};
+        std::atomic<double> delay_ms{0.0};
+        std::chrono::steady_clock::time_point pushed;
+    };
+
+    margo_instance_id                     m_mid;
+    pool                                  m_pool;
+    options                               m_opts;
+    std::unique_ptr<timed_callback>       m_timer;
+    mutable std::mutex                    m_mutex;
+    bool                                  m_running = false;
+    std::vector<managed<xstream>>         m_active;
+    std::vector<managed<xstream>>         m_retiring;
+    std::shared_ptr<probe>                m_probe = std::make_shared<probe>();
+    unsigned                              m_loaded_samples = 0;
+    unsigned                              m_idle_samples   = 0;
+
+    void grow() {
+        m_active.push_back(xstream::create(m_opts.sched, m_pool));
+    }
+
+    void shrink() {
+        // cancellation only takes effect when the scheduler checks its
+        // events, i.e. between two work units
+        m_active.back()->cancel();
+        m_retiring.push_back(std::move(m_active.back()));
+        m_active.pop_back();
+    }
+
+    void reap() {
+        for(auto it = m_retiring.begin(); it != m_retiring.end();) {
+            if((*it)->state() == xstream_state::terminated) it = m_retiring.erase(it);
+            else ++it;
+        }
+    }
+
+    // returns the scheduling delay of the probe pushed by the previous
+    // sample (or the time it has been waiting so far), and pushes a new
+    // one if it ran
+    double sample_latency() {
+        auto now = std::chrono::steady_clock::now();
+        if(m_probe->pending) {
+            std::chrono::duration<double, std::milli> waited = now - m_probe->pushed;
+            return waited.count();
+        }
+        double delay        = m_probe->delay_ms.load();
+        m_probe->pending    = true;
+        m_probe->pushed     = now;
+        std::shared_ptr<probe> p = m_probe;
+        m_pool.make_thread([p]() {
+            std::chrono::duration<double, std::milli> d =
+                std::chrono::steady_clock::now() - p->pushed;
+            p->delay_ms = d.count();
+            p->pending  = false;
+        }, anonymous());
+        return delay;
+    }
+
+    void tick() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_running) return;
+        reap();
+        double latency = sample_latency();
+        double depth   = static_cast<double>(m_pool.total_size())
+                       / static_cast<double>(m_active.size() ? m_active.size() : 1);
+        if(depth > m_opts.grow_depth || latency > m_opts.latency_ms) {
+            m_idle_samples    = 0;
+            m_loaded_samples += 1;
+        } else if(depth < m_opts.shrink_depth && latency < m_opts.latency_ms / 2) {
+            m_loaded_samples = 0;
+            m_idle_samples  += 1;
+        } else {
+            m_loaded_samples = 0;
+            m_idle_samples   = 0;
+        }
+        if(m_loaded_samples >= m_opts.grow_after && m_active.size() < m_opts.max_xstreams) {
+            grow();
+            m_loaded_samples = 0;
+        } else if(m_idle_samples >= m_opts.shrink_after
+               && m_active.size() > m_opts.min_xstreams) {
+            shrink();
+            m_idle_samples = 0;
+        }
+        m_timer->start(m_opts.interval_ms);
+    }
+
+    // stops sampling and joins the execution streams; returns false if
+    // the controller was already stopped
+    bool stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_running) return false;
+            m_running = false;
+        }
+        try {
+            m_timer->cancel();
+        } catch(const exception&) {
+            // the callback was running and won't start the timer again
+        }
+        m_timer.reset();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto& x : m_active) x->cancel();
+        for(auto& x : m_active) x->join();
+        for(auto& x : m_retiring) x->join();
+        m_active.clear();
+        m_retiring.clear();
+        return true;
+    }
+
+    static void on_finalize(void* arg) {
+        static_cast<elastic_xstreams*>(arg)->stop();
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -6,6 +6,7 @@
 #ifndef __THALLIUM_ENDPOINT_HPP
 #define __THALLIUM_ENDPOINT_HPP
 
+#include <atomic>
 #include <memory>
 #include <cstdint>
 #include <margo.h>
@@ -39,6 +40,31 @@ class endpoint {
   private:
     margo_instance_ref m_mid;
     hg_addr_t          m_addr = HG_ADDR_NULL;
+    // reference count shared by the copies of an endpoint, which share
+    // m_addr instead of each holding an address duplicated with
+    // margo_addr_dup (which takes a lock in Mercury)
+    std::atomic<std::size_t>* m_refcount = nullptr;
+
+    /**
+     * @brief Drops this endpoint's reference to the address, freeing
+     * the address if it was the last one.
+     */
+    hg_return_t release() noexcept {
+        hg_return_t ret = HG_SUCCESS;
+        if(m_refcount && m_refcount->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete m_refcount;
+            ret = margo_addr_free(m_mid, m_addr);
+        }
+        m_refcount = nullptr;
+        m_addr     = HG_ADDR_NULL;
+        return ret;
+    }
+
+    void share(const endpoint& other) noexcept {
+        m_addr     = other.m_addr;
+        m_refcount = other.m_refcount;
+        if(m_refcount) m_refcount->fetch_add(1, std::memory_order_relaxed);
+    }
 
   public:
     /**
@@ -52,10 +78,12 @@ class endpoint {
     : m_mid{std::move(mid)}
     , m_addr(addr) {
         MARGO_INSTANCE_MUST_BE_VALID;
-        if(!take_ownership && addr != HG_ADDR_NULL) {
+        if(addr == HG_ADDR_NULL) return;
+        if(!take_ownership) {
             auto ret = margo_addr_dup(m_mid, addr, &m_addr);
             MARGO_ASSERT(ret, margo_addr_dup);
         }
+        m_refcount = new std::atomic<std::size_t>(1);
     }
 
     /**
@@ -65,15 +93,12 @@ class endpoint {
     endpoint() noexcept = default;
 
     /**
-     * @brief Copy constructor.
+     * @brief Copy constructor. The copy shares the address of the
+     * original endpoint.
      */
-    endpoint(const endpoint& other)
-    : m_mid(other.m_mid)
-    , m_addr(HG_ADDR_NULL) {
-        if(other.m_addr == HG_ADDR_NULL) return;
-        MARGO_INSTANCE_MUST_BE_VALID;
-        hg_return_t ret = margo_addr_dup(m_mid, other.m_addr, &m_addr);
-        MARGO_ASSERT(ret, margo_addr_dup);
+    endpoint(const endpoint& other) noexcept
+    : m_mid(other.m_mid) {
+        share(other);
     }
 
     /**
@@ -81,26 +106,19 @@ class endpoint {
      */
     endpoint(endpoint&& other) noexcept
     : m_mid(std::move(other.m_mid))
-    , m_addr(std::exchange(other.m_addr, HG_ADDR_NULL)) {}
+    , m_addr(std::exchange(other.m_addr, HG_ADDR_NULL))
+    , m_refcount(std::exchange(other.m_refcount, nullptr)) {}
 
     /**
      * @brief Copy-assignment operator.
      */
     endpoint& operator=(const endpoint& other) {
-        hg_return_t ret;
-        if(&other == this)
+        if(&other == this || (m_refcount && m_refcount == other.m_refcount))
             return *this;
-        if(m_addr != HG_ADDR_NULL) {
-            ret = margo_addr_free(m_mid, m_addr);
-            MARGO_ASSERT(ret, margo_addr_free);
-        }
+        hg_return_t ret = release();
+        MARGO_ASSERT(ret, margo_addr_free);
         m_mid = other.m_mid;
-        if(other.m_addr != HG_ADDR_NULL) {
-            ret = margo_addr_dup(m_mid, other.m_addr, &m_addr);
-            MARGO_ASSERT(ret, margo_addr_dup);
-        } else {
-            m_addr = HG_ADDR_NULL;
-        }
+        share(other);
         return *this;
     }
 
@@ -110,12 +128,11 @@ class endpoint {
     endpoint& operator=(endpoint&& other) {
         if(&other == this)
             return *this;
-        if(m_addr != HG_ADDR_NULL) {
-            auto ret = margo_addr_free(m_mid, m_addr);
-            MARGO_ASSERT(ret, margo_addr_free);
-        }
-        m_mid  = std::move(other.m_mid);
-        m_addr = std::exchange(other.m_addr, HG_ADDR_NULL);
+        hg_return_t ret = release();
+        MARGO_ASSERT(ret, margo_addr_free);
+        m_mid      = std::move(other.m_mid);
+        m_addr     = std::exchange(other.m_addr, HG_ADDR_NULL);
+        m_refcount = std::exchange(other.m_refcount, nullptr);
         return *this;
     }
 
@@ -123,10 +140,8 @@ class endpoint {
      * @brief Destructor.
      */
     virtual ~endpoint() {
-        if(m_addr != HG_ADDR_NULL) {
-            auto ret = margo_addr_free(m_mid, m_addr);
-            MARGO_ASSERT_TERMINATE(ret, margo_addr_free);
-        }
+        auto ret = release();
+        MARGO_ASSERT_TERMINATE(ret, margo_addr_free);
     }
 
     /**
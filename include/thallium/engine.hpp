@@ -13,17 +13,45 @@
 #include <list>
 #include <margo.h>
 #include <string>
+#include <thallium/address_cache.hpp>
 #include <thallium/bulk_mode.hpp>
+#include <thallium/bulk_cache.hpp>
+#include <thallium/inline_bulk.hpp>
+#include <thallium/provider_info.hpp>
+#include <thallium/expected.hpp>
+#include <thallium/decode_arena.hpp>
 #include <thallium/margo_exception.hpp>
 #include <thallium/tuple_util.hpp>
 #include <thallium/function_util.hpp>
+#include <thallium/handle_cache.hpp>
+#include <thallium/local_dispatch.hpp>
 #include <thallium/logger.hpp>
 #include <thallium/margo_instance_ref.hpp>
+#include <thallium/progress_policy.hpp>
+#include <thallium/request_batch.hpp>
+#include <thallium/rpc_execution.hpp>
+#include <thallium/admission.hpp>
+#include <thallium/rpc_policy.hpp>
+#include <thallium/rpc_priority.hpp>
+#include <thallium/rpc_capture.hpp>
+#include <thallium/rpc_profiler.hpp>
+#include <thallium/rpc_sharding.hpp>
+#include <thallium/rpc_stats.hpp>
+#include <thallium/pool_stats.hpp>
+#include <thallium/tracing.hpp>
+#include <thallium/unit_allocator.hpp>
 #include <unordered_map>
 #include <vector>
 #include <memory>
 #include <cstdint>
 #include <utility>
+#include <chrono>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define THALLIUM_SERVER_MODE MARGO_SERVER_MODE
 #define THALLIUM_CLIENT_MODE MARGO_CLIENT_MODE
@@ -31,11 +59,15 @@
 namespace thallium {
 
 class bulk;
+class bulk_segment;
 class endpoint;
 class remote_bulk;
 class remote_procedure;
+template <typename Signature> class remote_procedure_t;
 class timed_callback;
+class timer_token;
 class pool;
+template <typename T> class eventual;
 template <typename ... CtxArg> class request_with_context;
 using request = request_with_context<>;
 template <typename ... CtxArg> class proc_input_archive;
@@ -43,9 +75,63 @@ template <typename ... CtxArg> class proc_output_archive;
 template <typename T> class provider;
 class xstream;
 class pool;
+struct finalize_options;
+class engine_config;
+struct finalize_report;
 
 DECLARE_MARGO_RPC_HANDLER(thallium_generic_rpc)
 hg_return_t thallium_generic_rpc(hg_handle_t handle);
+hg_return_t thallium_rpc_handler(hg_handle_t handle);
+hg_return_t thallium_dispatch_rpc(margo_instance_id mid, hg_handle_t handle,
+                                  int priority, bool has_priority, std::uint64_t arrival);
+bool thallium_invoke_local_rpc(margo_instance_id mid, hg_id_t id, detail::local_call& call);
+
+namespace detail {
+
+class rpc_drain;
+struct rpc_in_flight;
+
+/**
+ * @private
+ * @brief Name under which the aggregated variant of an RPC defined by
+ * engine::define_aggregated is registered.
+ */
+inline std::string aggregated_rpc_name(const std::string& name) {
+    return name + "#aggregated";
+}
+
+/**
+ * @private
+ * @brief Pulls by RDMA the content of the large<T> arguments of an RPC
+ * (see large.hpp).
+ */
+template <typename... Args>
+void pull_large_args(const request& r, std::tuple<Args...>& args);
+
+} // namespace detail
+
+/**
+ * The single_threaded_client structure is used as a tag in the engine
+ * constructor creating a client engine for processes that send RPCs
+ * from a single ULT (e.g. compute ranks). Such an engine starts no
+ * execution stream: margo's progress loop runs on the caller's
+ * execution stream, where it only gets scheduled while the caller
+ * waits on an RPC or a transfer, and polls the network without
+ * blocking so that responses are seen as soon as they arrive. If
+ * Mercury supports it, its network layer is also initialized in
+ * single-threaded mode, which replaces its internal locks with no-ops.
+ *
+ * \code{.cpp}
+ * tl::engine engine("ofi+cxi", tl::single_threaded_client());
+ * auto sum = engine.define("sum");
+ * int  r   = sum.on(engine.lookup(server_addr))(40, 2);
+ * \endcode
+ *
+ * The engine, and the RPCs, endpoints and bulk handles created from it,
+ * must then only be used from the execution stream that created it, and
+ * no RPC handler can be defined on it.
+ */
+struct single_threaded_client {};
 
 /**
  * @brief The engine class is at the core of Thallium,
@@ -66,8 +152,16 @@ class engine : public margo_instance_ref {
     friend class timed_callback;
 
     friend hg_return_t thallium_generic_rpc(hg_handle_t handle);
+    friend hg_return_t thallium_rpc_handler(hg_handle_t handle);
+    friend hg_return_t thallium_dispatch_rpc(margo_instance_id mid, hg_handle_t handle,
+                                             int priority, bool has_priority,
+                                             std::uint64_t arrival);
+    friend bool thallium_invoke_local_rpc(margo_instance_id mid, hg_id_t id,
+                                          detail::local_call& call);
 
   private:
+    // built once per define, so a std::function: handlers may capture
+    // any amount of state, which inplace_function would reject
     using rpc_t = std::function<void(const request&)>;
     using finalize_callback_t = std::function<void()>;
 
@@ -77,6 +171,29 @@ class engine : public margo_instance_ref {
      */
     struct rpc_callback_data {
         rpc_t m_function;
+        std::shared_ptr<detail::rpc_drain>     m_drain;
+        std::shared_ptr<detail::rpc_in_flight> m_in_flight;
+        std::shared_ptr<detail::local_dispatch> m_local;
+        const void*                             m_local_type = nullptr;
+        // resolved when the RPC is defined, so that requests reach
+        // them without a lookup; RPCs shared by several provider ids
+        // have no policy of their own (see policy())
+        const detail::rpc_policy*                 m_policy = nullptr;
+        std::shared_ptr<detail::progress_monitor> m_monitor;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        std::shared_ptr<detail::rpc_stats_registry> m_stats_registry;
+        std::shared_ptr<detail::rpc_metrics>        m_stats;
+#endif
+
+        /**
+         * @brief Returns the policy of the RPC a request was received
+         * for, or nullptr if none of its settings were set.
+         */
+        const detail::rpc_policy* policy(margo_instance_id mid, hg_handle_t h) const {
+            if(m_policy) return m_policy;
+            const struct hg_info* info = margo_get_info(h);
+            return info ? detail::rpc_policy_table::find(mid, info->id) : nullptr;
+        }
     };
 
     /**
@@ -89,12 +206,104 @@ class engine : public margo_instance_ref {
         delete cb_data;
     }
 
+    /**
+     * @brief Registers an RPC handled by thallium_generic_rpc, through
+     * thallium_rpc_handler.
+     */
+    hg_id_t register_generic_rpc(const std::string& name, uint16_t provider_id,
+                                 const pool& p);
+
+    /**
+     * @brief Attaches a detail::progress_monitor to the margo instance
+     * if the policy has an on_report hook.
+     */
+    void install_progress_monitor(const progress_policy& policy);
+
+    /**
+     * @brief Implementation of define for handlers taking arguments; the
+     * arguments are decoded with the serialization context of the
+     * handler's request type. The handler is stored as is in the RPC's
+     * callback, so a handler type known at compile time (e.g. the one
+     * generated by provider::define for a bound member function) is
+     * called without going through an std::function. The signature is
+     * given by the (null) function pointer.
+     */
+    template <typename F, typename... CtxArg, typename A1, typename... Args>
+    remote_procedure
+    define_impl(const std::string& name, F&& fun,
+                void (*signature)(const request_with_context<CtxArg...>&, A1, Args...),
+                uint16_t provider_id, const pool& p);
+
+    /**
+     * @brief Creates the callback data of an RPC whose handler takes
+     * arguments, decoding them and calling fun.
+     */
+    template <typename F, typename... CtxArg, typename A1, typename... Args>
+    rpc_callback_data*
+    make_rpc_callback(F&& fun,
+                      void (*signature)(const request_with_context<CtxArg...>&, A1, Args...));
+
+    /**
+     * @brief Creates the callback data of an RPC whose handler takes
+     * no argument.
+     */
+    template <typename F>
+    rpc_callback_data* make_rpc_callback(F&& fun, void (*signature)(const request&));
+
+    /**
+     * @brief Creates callback data to be shared by the registrations of
+     * an RPC for several provider ids (see provider::define_shared).
+     * Its requests in flight are counted together, for all the
+     * provider ids. The data is freed with the last reference.
+     */
+    template <typename F, typename Signature>
+    std::shared_ptr<void> make_shared_rpc_callback(const std::string& name, F&& fun,
+                                                   Signature signature) {
+        rpc_callback_data* cb_data = make_rpc_callback(std::forward<F>(fun), signature);
+        track_in_flight(cb_data, 0, name, MARGO_MAX_PROVIDER_ID);
+        return std::shared_ptr<void>(cb_data, &free_rpc_callback_data);
+    }
+
+    /**
+     * @brief Registers an RPC for a provider id with callback data made
+     * by make_shared_rpc_callback. Deregistering it does not free the
+     * data, which must outlive the registration.
+     */
+    remote_procedure register_shared_rpc(const std::string& name,
+                                         const std::shared_ptr<void>& cb_data,
+                                         uint16_t provider_id, const pool& p);
+
+    template <typename... CtxArg>
+    static typename std::enable_if<(sizeof...(CtxArg) > 0), request_with_context<CtxArg...>>::type
+    contextualize(const request& r);
+
+    template <typename... CtxArg>
+    static typename std::enable_if<sizeof...(CtxArg) == 0, const request&>::type
+    contextualize(const request& r) {
+        return r;
+    }
+
     static void finalize_callback_wrapper(void* arg) {
         auto cb = static_cast<finalize_callback_t*>(arg);
         (*cb)();
         delete cb;
     }
 
+    finalize_report finalize_with(hg_id_t caller_id, const finalize_options& opts);
+
+    /**
+     * @brief Attaches the in-flight counter of an RPC, and its metrics
+     * if statistics are compiled in, to its callback data.
+     */
+    void track_in_flight(rpc_callback_data* cb_data, hg_id_t id,
+                         const std::string& name, uint16_t provider_id) const;
+
+    /**
+     * @brief Remembers the owner of a finalize callback, so that
+     * finalize_with can run the callbacks of each owner in parallel.
+     */
+    void add_finalize_owner(const void* owner) const;
+
   public:
 
     /**
@@ -178,6 +387,58 @@ class engine : public margo_instance_ref {
     engine(const std::string& addr, int mode, const pool& progress_pool,
            const pool& default_handler_pool);
 
+    /**
+     * @brief Constructor for a single-threaded client (see
+     * single_threaded_client).
+     *
+     * @param addr address (protocol) of this instance.
+     * @param hg_opt options for initializing Mercury, to which the
+     * single-threaded and non-blocking network settings are added.
+     */
+    engine(const std::string& addr, const single_threaded_client&,
+           const hg_init_info* hg_opt = nullptr);
+
+    /**
+     * @brief Constructor. The pools and execution streams of the engine
+     * are created as described by the engine_config, and the warnings
+     * of check_config() are logged through margo's logger.
+     *
+     * @param addr address of this instance.
+     * @param mode THALLIUM_SERVER_MODE or THALLIUM_CLIENT_MODE.
+     * @param config configuration built with engine_config.
+     * @param hg_opt options for initializing Mercury.
+     */
+    engine(const std::string& addr, int mode, const engine_config& config,
+           const hg_init_info *hg_opt = nullptr);
+
+    /**
+     * @brief Constructor.
+     *
+     * @param addr address of this instance.
+     * @param mode THALLIUM_SERVER_MODE or THALLIUM_CLIENT_MODE.
+     * @param policy how the progress loop trades latency for CPU usage.
+     * @param use_progress_thread whether to use a dedicated ES to drive
+     * progress.
+     * @param rpc_thread_count number of threads to use for servicing RPCs.
+     * Use -1 to indicate that RPCs should be serviced in the progress ES.
+     * @param hg_opt options for initializing Mercury.
+     */
+    engine(const std::string& addr, int mode, const progress_policy& policy,
+           bool use_progress_thread = false, std::int32_t rpc_thread_count = 0,
+           const hg_init_info *hg_opt = nullptr);
+
+    /**
+     * @brief Constructor.
+     *
+     * @param addr address of this instance.
+     * @param mode THALLIUM_SERVER_MODE or THALLIUM_CLIENT_MODE.
+     * @param progress_pool pool in which to run the progress loop.
+     * @param default_handler_pool pool in which to run RPC handlers.
+     * @param policy how the progress loop trades latency for CPU usage.
+     */
+    engine(const std::string& addr, int mode, const pool& progress_pool,
+           const pool& default_handler_pool, const progress_policy& policy);
+
     /**
      * @brief Builds an engine around an existing margo instance.
      *
@@ -251,6 +512,45 @@ class engine : public margo_instance_ref {
         margo_finalize(m_mid);
     }
 
+    /**
+     * @brief Finalizes the engine after draining its RPCs: requests
+     * arriving from now on get a busy response (or are dropped if the
+     * RPC's response is disabled), and the requests already admitted
+     * are given up to opts.drain_timeout to complete. The finalize
+     * callbacks pushed with push_finalize_callback(owner, f) then run
+     * in parallel across owners (each owner's callbacks still run in
+     * reverse order of their registration), in ULTs of
+     * opts.callback_pools, before the other finalize callbacks.
+     *
+     * Handlers still running when the timeout hits are not interrupted;
+     * margo waits for them before releasing the instance. The report
+     * lists them, so that the caller can log what was lost.
+     *
+     * @param opts Drain timeout and pools of the finalize callbacks.
+     *
+     * @return What was drained and what was still in flight.
+     */
+    finalize_report finalize_with(const finalize_options& opts);
+
+    /**
+     * @brief Same as finalize_with(opts) with the default options.
+     */
+    finalize_report finalize_with();
+
+    /**
+     * @brief Same as finalize_with(opts), called from the handler of a
+     * request (e.g. a shutdown RPC), which is not waited for.
+     *
+     * @param caller Request being handled by the caller.
+     * @param opts Drain timeout and pools of the finalize callbacks.
+     */
+    finalize_report finalize_with(const request& caller, const finalize_options& opts);
+
+    /**
+     * @brief Same as finalize_with(caller, opts) with the default options.
+     */
+    finalize_report finalize_with(const request& caller);
+
     /**
      * @brief Makes the calling thread block until someone calls
      * finalize on this engine. This function will not do anything
@@ -294,6 +594,51 @@ class engine : public margo_instance_ref {
     remote_procedure define(const std::string& name);
     remote_procedure define(const char* name);
 
+    /**
+     * @brief Same as define(name) but only registers the RPC with margo
+     * the first time it is used (e.g. by remote_procedure::on), so that
+     * clients knowing many RPCs only pay for those they call.
+     *
+     * @param name Name of the RPC.
+     *
+     * @return a remote_procedure object.
+     */
+    remote_procedure define_lazy(const std::string& name);
+
+    /**
+     * @brief Defines an RPC with a name and a signature, without
+     * providing a handler (used on clients). See remote_procedure_t.
+     *
+     * @tparam Signature Signature of the RPC, e.g. int(int,int).
+     * @param name Name of the RPC.
+     *
+     * @return a remote_procedure_t object.
+     */
+    template <typename Signature>
+    typename std::enable_if<std::is_function<Signature>::value,
+                            remote_procedure_t<Signature>>::type
+    define(const std::string& name);
+
+    /**
+     * @brief Defines an RPC with a name, a signature R(Args...), and a
+     * handler callable as fun(const request&, Args...) and returning
+     * an R, which is sent as response (a void handler is responded to
+     * with an empty response when it returns).
+     *
+     * @tparam Signature Signature of the RPC, e.g. int(int,int).
+     * @param name Name of the RPC.
+     * @param fun Handler.
+     * @param provider_id ID of the provider registering this RPC.
+     * @param pool Argobots pool to use when receiving this type of RPC.
+     *
+     * @return a remote_procedure_t object.
+     */
+    template <typename Signature, typename Func>
+    typename std::enable_if<std::is_function<Signature>::value,
+                            remote_procedure_t<Signature>>::type
+    define(const std::string& name, Func&& fun,
+           uint16_t provider_id = 0, const pool& p = pool());
+
     /**
      * @brief Defines an RPC with a name and an std::function
      * representing the RPC.
@@ -330,6 +675,28 @@ class engine : public margo_instance_ref {
            std::function<void(const request&, A1, Args...)>&& fun,
            uint16_t provider_id = 0);
 
+    /**
+     * @brief Defines an RPC whose handler takes a request_with_context
+     * instead of a request: the arguments are decoded, and responses
+     * encoded, with a default-constructed serialization context of these
+     * types (e.g. tl::varint_encoding).
+     *
+     * @tparam CtxArg Types of the serialization context.
+     * @tparam A1 Type of the first argument.
+     * @tparam Args Types of the other arguments.
+     * @param name Name of the RPC.
+     * @param fun Function to associate with the RPC.
+     * @param provider_id ID of the provider registering this RPC.
+     * @param pool Argobots pool to use when receiving this type of RPC.
+     *
+     * @return a remote_procedure object.
+     */
+    template <typename... CtxArg, typename A1, typename... Args>
+    remote_procedure
+    define(const std::string& name,
+           std::function<void(const request_with_context<CtxArg...>&, A1, Args...)>&& fun,
+           uint16_t provider_id = 0, const pool& p = pool());
+
     template <typename Func, typename ... Extra>
     typename std::enable_if<
         !is_std_function_object<typename std::decay<Func>::type>::value
@@ -369,6 +736,96 @@ class engine : public margo_instance_ref {
                             void (*f)(const request&, Args...),
                             uint16_t provider_id = 0);
 
+    /**
+     * @brief Defines an RPC whose requests are coalesced on the server
+     * side: instead of being called once per request, the handler is
+     * called with a batch of up to max_batch_size requests along with
+     * their decoded arguments. A batch is handed to the handler as soon
+     * as it is full, or max_delay after its first request was received,
+     * whichever happens first. The handler is responsible for calling
+     * respond on each request of the batch.
+     *
+     * The first request of a batch keeps its handler ULT blocked
+     * until the batch is complete, so the pool used for this RPC should
+     * be served by enough execution streams, or allow enough ULTs, to
+     * receive max_batch_size requests concurrently.
+     *
+     * @tparam Args Types of arguments accepted by the RPC.
+     * @param name Name of the RPC.
+     * @param fun Function to call on each batch.
+     * @param max_batch_size Maximum number of requests in a batch.
+     * @param max_delay Maximum time the first request of a batch waits.
+     * @param provider_id ID of the provider registering this RPC.
+     * @param pool Argobots pool to use when receiving this type of RPC.
+     *
+     * @return a remote_procedure object.
+     */
+    template <typename... Args>
+    remote_procedure
+    define_batched(const std::string&                                     name,
+                   const std::function<void(request_batch<Args...>&)>& fun,
+                   std::size_t max_batch_size,
+                   std::chrono::microseconds max_delay,
+                   uint16_t provider_id = 0, const pool& p = pool());
+
+    /**
+     * @brief Defines a fire-and-forget RPC that can also be received in
+     * aggregated form from an rpc_aggregator. Two RPCs are registered:
+     * the RPC itself, and an aggregated variant carrying a vector of
+     * argument tuples, for which the handler is called once per tuple,
+     * in order, with the request of the aggregated RPC. Responses are
+     * disabled for both.
+     *
+     * @tparam Args Types of arguments accepted by the RPC.
+     * @param name Name of the RPC.
+     * @param fun Function to associate with the RPC.
+     * @param provider_id ID of the provider registering this RPC.
+     * @param pool Argobots pool to use when receiving this type of RPC.
+     *
+     * @return the remote_procedure object of the non-aggregated RPC.
+     */
+    template <typename A1, typename... Args>
+    remote_procedure
+    define_aggregated(const std::string&                                      name,
+                      const std::function<void(const request&, A1, Args...)>& fun,
+                      uint16_t provider_id = 0, const pool& p = pool());
+
+    template <typename Func, typename ... Extra>
+    typename std::enable_if<
+        !is_std_function_object<typename std::decay<Func>::type>::value, remote_procedure>::type
+    define_aggregated(const std::string& name, Func&& fun, const Extra&... extra) {
+        using function = typename std::function<typename function_signature<Func>::type>;
+        return define_aggregated(name, function(std::forward<Func>(fun)), extra...);
+    }
+
+    template <typename Func, typename ... Extra>
+    typename std::enable_if<
+        !is_std_function_object<typename std::decay<Func>::type>::value, remote_procedure>::type
+    define_batched(const std::string& name, Func&& fun, const Extra&... extra) {
+        using function = typename std::function<typename function_signature<Func>::type>;
+        return define_batched(name, function(std::forward<Func>(fun)), extra...);
+    }
+
+    /**
+     * @brief Returns the maximum size of the serialized arguments of
+     * an RPC that Mercury can send in its eager buffer. Larger arguments
+     * go through Mercury's overflow path, which costs an extra allocation
+     * and an RDMA transfer.
+     */
+    std::size_t get_input_eager_size() const {
+        MARGO_INSTANCE_MUST_BE_VALID;
+        return HG_Class_get_input_eager_size(margo_get_class(m_mid));
+    }
+
+    /**
+     * @brief Returns the maximum size of the serialized response of
+     * an RPC that Mercury can send in its eager buffer.
+     */
+    std::size_t get_output_eager_size() const {
+        MARGO_INSTANCE_MUST_BE_VALID;
+        return HG_Class_get_output_eager_size(margo_get_class(m_mid));
+    }
+
     /**
      * @brief Lookup an address and returns an endpoint object
      * to communicate with this address.
@@ -379,6 +836,92 @@ class engine : public margo_instance_ref {
      */
     endpoint lookup(const std::string& address) const;
 
+    /**
+     * @brief Same as lookup() but returns an expected holding the
+     * Mercury error code instead of throwing if the address could not
+     * be resolved.
+     *
+     * @param address String representation of the address.
+     *
+     * @return an expected containing the endpoint.
+     */
+    expected<endpoint> try_lookup(const std::string& address) const;
+
+    /**
+     * @brief Resolves a set of addresses without blocking: all the
+     * lookups are issued at once and completed by the progress loop.
+     * The returned eventual is set with the endpoints, in the order of
+     * the addresses, or with a margo_exception if any lookup failed.
+     * Addresses found in the address cache (if enabled) are not looked
+     * up again, and resolved ones are added to it.
+     *
+     * @param addresses String representations of the addresses.
+     *
+     * @return an eventual for the endpoints.
+     */
+    eventual<std::vector<endpoint>> lookup_async(const std::vector<std::string>& addresses) const;
+
+    /**
+     * @brief Same as lookup_async(addresses) for a range of strings.
+     */
+    template <typename Iterator>
+    eventual<std::vector<endpoint>> lookup_async(Iterator begin, Iterator end) const;
+
+    /**
+     * @brief Enables caching of resolved addresses on this engine. When
+     * enabled, lookup() and lookup_async() return endpoints sharing the
+     * address resolved by the first lookup of the same string instead of
+     * calling margo_addr_lookup again. The cache is cleared when the
+     * engine is finalized.
+     */
+    void enable_address_cache();
+
+    /**
+     * @brief Disables the address cache and frees the addresses it holds.
+     */
+    void disable_address_cache();
+
+    /**
+     * @brief Removes an address from the address cache, so that the next
+     * lookup resolves it again (e.g. after the process at this address
+     * restarted).
+     *
+     * @param address String representation of the address.
+     */
+    void invalidate_address(const std::string& address);
+
+    /**
+     * @brief Returns statistics about the address cache. All the counters
+     * are 0 if the cache is not enabled.
+     */
+    address_cache_stats get_address_cache_stats() const;
+
+    /**
+     * @brief Makes this engine answer the handshake of
+     * provider_handle::get_info(), which returns the identity of a
+     * provider (see margo_provider_register_identity) together with the
+     * provider_capability bits of the engine, in one RPC.
+     *
+     * @param capabilities Application-defined bits (from
+     * provider_capability::user upwards) added to the built-in ones.
+     */
+    void enable_provider_handshake(std::uint64_t capabilities = 0);
+
+    /**
+     * @brief Returns the identity and capabilities of a provider. The
+     * first call for a given address and provider id sends a handshake
+     * RPC (or, if the remote engine did not enable the handshake, asks
+     * margo for the identity and reports no capabilities); the result
+     * is cached until the engine is finalized or invalidate_address is
+     * called for the address.
+     *
+     * @param ep Address of the provider.
+     * @param provider_id Provider id.
+     * @param refresh Ignore the cached entry and send the handshake again.
+     */
+    provider_info get_provider_info(const endpoint& ep, std::uint16_t provider_id,
+                                    bool refresh = false) const;
+
     /**
      * @brief Exposes a series of memory segments for bulk operations.
      *
@@ -402,8 +945,54 @@ class engine : public margo_instance_ref {
                 bulk_mode                                    flag,
                 const hg_bulk_attr&                          attr);
 
+    /**
+     * @brief Exposes memory segments of the given memory type, e.g.
+     * CUDA buffers, for bulk operations. Transfers from and to device
+     * memory need an NA plugin supporting it (e.g. ofi+verbs or ofi+cxi
+     * with a libfabric built with FI_HMEM), and an engine initialized
+     * with na_init_info.request_mem_device set in its hg_init_info;
+     * device_bulk falls back to staging through host memory otherwise.
+     *
+     * @param segments vector of <pointer,size> pairs of memory segments.
+     * @param flag indicates whether the bulk is read-write, read-only or
+     * write-only.
+     * @param type Type of memory of the segments.
+     * @param device Device the memory belongs to.
+     *
+     * @return a bulk object representing the memory exposed for RDMA.
+     */
+    bulk expose(const std::vector<std::pair<void*, size_t>>& segments,
+                bulk_mode                                    flag,
+                memory_type                                  type,
+                std::uint64_t                                device = 0);
+
 #endif
 
+    /**
+     * @brief Maps a range of a file into memory and exposes it for bulk
+     * operations, so that the file's pages are transferred from the page
+     * cache without being copied into a buffer first. The mapping lives
+     * as long as the returned bulk object and its copies. With
+     * bulk_mode::read_only the file is opened and mapped for reading;
+     * otherwise it is mapped for reading and writing and the data
+     * written into the bulk reaches the file.
+     *
+     * When the bulk cache is enabled (see enable_bulk_cache), the
+     * mapping and its registration are cached, keyed by the file, the
+     * time of its last modification, the range and the mode, so that
+     * hot files stay mapped and registered.
+     *
+     * @param path Path of the file.
+     * @param offset Offset of the range in the file.
+     * @param length Length of the range (0 for the rest of the file).
+     * @param flag bulk_mode of the exposed range.
+     * @param options Mapping options.
+     *
+     * @return a bulk object representing the range of the file.
+     */
+    bulk expose_file(const std::string& path, std::size_t offset, std::size_t length,
+                     bulk_mode flag, const file_map_options& options = file_map_options());
+
     /**
      * @brief Creates a bulk object from an hg_bulk_t handle. The user
      * is still responsible for calling margo_bulk_free or HG_Bulk_free
@@ -417,6 +1006,254 @@ class engine : public margo_instance_ref {
      */
     bulk wrap(hg_bulk_t blk, bool is_local);
 
+    /**
+     * @brief Enables caching of RPC handles on this engine. When enabled,
+     * remote_procedure::on() reuses idle handles previously created for
+     * the same endpoint and RPC instead of calling margo_create, and
+     * callable_remote_procedure objects put their handle back into the
+     * cache when the last reference to it is destroyed. The cache is
+     * cleared when the engine is finalized.
+     *
+     * @param max_handles Maximum number of idle handles kept in the cache.
+     */
+    void enable_handle_cache(std::size_t max_handles = 64);
+
+    /**
+     * @brief Disables the handle cache and destroys the handles it holds.
+     */
+    void disable_handle_cache();
+
+    /**
+     * @brief Returns statistics about the handle cache (hits, misses,
+     * and number of handles cached). All the counters are 0 if the cache
+     * is not enabled.
+     */
+    handle_cache_stats get_handle_cache_stats() const;
+
+    /**
+     * @brief Enables the local fast path of RPCs this engine sends to
+     * itself (e.g. on engine::self()). The handler of such an RPC gets
+     * the caller's arguments instead of decoding them (moved if the
+     * caller passed them as rvalues, copied otherwise), and the caller
+     * doesn't encode them. The values the handler responds with
+     * are moved into the response, which the caller copies out of it
+     * (encoding and decoding them only if it unpacks them as other
+     * types). This applies to blocking calls of RPCs defined with
+     * engine::define (or provider::define) after this call, without
+     * serialization context, whose arguments all satisfy
+     * is_locally_passable and have the same types on both sides; other
+     * calls are serialized as usual. Unless the RPC has admission limits,
+     * sharding, an execution mode or control information (cancellation,
+     * tracing), or is being captured or drained, its handler runs in the
+     * caller's ULT, without creating a handle or going through Mercury,
+     * and the caller moves the response out instead of copying it.
+     *
+     * This only concerns calls from an engine to its own address, which
+     * Mercury already processes without going through the network. RPCs
+     * sent to other processes on the same node are not affected: they
+     * go through Mercury, and should use the na+sm transport.
+     */
+    void enable_local_dispatch();
+
+    /**
+     * @brief Disables the local fast path enabled by enable_local_dispatch.
+     */
+    void disable_local_dispatch();
+
+    /**
+     * @brief Enables caching of memory registrations on this engine.
+     * When enabled, expose() called with a single segment returns the
+     * cached bulk if the same range was already exposed with a compatible
+     * mode, and expose_cached() can return a segment of any cached bulk
+     * covering the requested range. Registrations are released in LRU
+     * order when the total registered size exceeds max_bytes, and when
+     * the engine is finalized.
+     *
+     * @warning Memory that was exposed while the cache is enabled stays
+     * registered after the returned bulk objects are destroyed. The user
+     * must call invalidate_bulk_cache() before freeing such memory.
+     *
+     * @param max_bytes Maximum number of bytes kept registered by the cache.
+     */
+    void enable_bulk_cache(std::size_t max_bytes = 256*1024*1024);
+
+    /**
+     * @brief Disables the registration cache and releases the
+     * registrations it holds.
+     */
+    void disable_bulk_cache();
+
+    /**
+     * @brief Defers freeing the handles of local bulk objects (those
+     * returned by expose and its variants): instead of deregistering
+     * the memory when the last bulk object referring to it is destroyed,
+     * typically inside a handler just before it responds, the handle is
+     * queued and freed with the others in a batch by a ULT created in
+     * pool p, which runs after the work already queued in that pool.
+     * At most max_pending handles wait in the queue; beyond that, they
+     * are freed immediately. The queue is drained when this is disabled
+     * and when the engine is finalized.
+     *
+     * Combined with the registration cache (enable_bulk_cache), a
+     * destroyed bulk only drops a reference to a cached registration,
+     * which the deferral moves off the handler as well.
+     *
+     * @warning Memory may stay registered for a while after its bulk
+     * objects are destroyed. Freeing it in the meantime is safe, but
+     * memory that must be deregistered before being reused (e.g.
+     * returned to the system and mapped again with other protections)
+     * should be exposed with deferral disabled.
+     *
+     * @param max_pending Maximum number of handles waiting to be freed.
+     * @param p Pool in which handles are freed (null for the pool of
+     * the RPC handlers).
+     */
+    void enable_deferred_bulk_free(std::size_t max_pending = 1024, const pool& p = pool());
+
+    /**
+     * @brief Frees the handles waiting to be freed and stops deferring.
+     */
+    void disable_deferred_bulk_free();
+
+    /**
+     * @brief Enables inlining the data of small bulks in their
+     * serialization. When a local bulk of at most threshold bytes,
+     * exposed from host memory by expose, expose_cached or expose_file
+     * in a mode other than bulk_mode::write_only, is sent as an RPC
+     * argument or response, its data is sent along with
+     * its handle, and the receiver's remote_bulk pulls (operator>> and
+     * pull_to) copy it instead of issuing an RDMA transfer. The handle
+     * is still sent, so that pushes and the other transfers work as
+     * before.
+     *
+     * Engines always understand inlined bulks, whether or not they
+     * enabled it themselves; peers using the C margo API do not, so it
+     * should only be enabled when all the receivers use Thallium.
+     *
+     * @param threshold Size up to which the data of a bulk is inlined.
+     */
+    void enable_inline_bulk(std::size_t threshold = 4096);
+
+    /**
+     * @brief Disables inlining the data of small bulks.
+     */
+    void disable_inline_bulk();
+
+    /**
+     * @brief Removes from the registration cache any registration
+     * overlapping the provided range. Does nothing if the cache is not
+     * enabled.
+     *
+     * @param ptr Start of the range.
+     * @param size Size of the range.
+     */
+    void invalidate_bulk_cache(const void* ptr, std::size_t size);
+
+    /**
+     * @brief Returns statistics about the registration cache. All the
+     * counters are 0 if the cache is not enabled.
+     */
+    bulk_cache_stats get_bulk_cache_stats() const;
+
+    /**
+     * @brief Exposes a single contiguous region, reusing a cached
+     * registration covering it if the registration cache is enabled.
+     *
+     * @param ptr Start of the region.
+     * @param size Size of the region.
+     * @param flag Access mode.
+     *
+     * @return a bulk_segment of a bulk object covering the region.
+     */
+    bulk_segment expose_cached(void* ptr, std::size_t size, bulk_mode flag);
+
+    /**
+     * @brief Starts (or stops) recording latency statistics for the
+     * RPCs defined and sent through this engine. Statistics are only
+     * available if thallium is compiled with THALLIUM_ENABLE_RPC_STATS
+     * defined (e.g. by linking against the thallium_rpc_stats CMake
+     * target); otherwise this function throws an exception when
+     * asked to enable them, and the instrumentation is compiled out.
+     *
+     * @param enable Whether to record statistics.
+     */
+    void enable_rpc_stats(bool enable = true);
+
+    /**
+     * @brief Returns a snapshot of the RPC statistics recorded so far.
+     */
+    rpc_stats get_rpc_stats() const;
+
+    /**
+     * @brief Clears the RPC statistics recorded so far.
+     */
+    void reset_rpc_stats();
+
+    /**
+     * @brief Starts recording the client and server spans of the traced
+     * RPCs (see remote_procedure::enable_tracing) sent and handled
+     * through this engine, keeping up to capacity of them until they are
+     * collected; spans recorded beyond that are dropped. A capacity of 0
+     * stops the recording. Like enable_rpc_stats, this requires
+     * THALLIUM_ENABLE_RPC_STATS and otherwise throws an exception.
+     *
+     * @param capacity Maximum number of spans kept.
+     */
+    void enable_span_collection(std::size_t capacity = 65536);
+
+    /**
+     * @brief Returns the spans recorded since the last call and forgets
+     * them.
+     */
+    std::vector<span_record> collect_spans();
+
+    /**
+     * @brief Starts sampling, every interval_ms from a dedicated thread,
+     * which RPC each execution stream running handlers of this engine
+     * is in, building a flat CPU profile by RPC (see get_rpc_profile).
+     * Handlers only set a marker when they start and when they return,
+     * so this can run continuously in production. Time a stream spends
+     * running other work while a handler is blocked is attributed to
+     * that handler. An interval of 0 stops the sampling.
+     *
+     * @param interval_ms Time between samples.
+     */
+    void enable_rpc_profiling(double interval_ms = 10.0);
+
+    /**
+     * @brief Returns the profile sampled so far.
+     */
+    rpc_profile get_rpc_profile() const;
+
+    /**
+     * @brief Clears the profile sampled so far.
+     */
+    void reset_rpc_profile();
+
+    /**
+     * @brief Starts recording the RPCs received by this engine into a
+     * capture file: for each RPC, its name, provider id, arrival time
+     * and encoded arguments. The file can be read with an
+     * rpc_capture_reader and replayed against another server with
+     * replay_rpc_capture. Recording copies the arguments of each RPC
+     * into a buffer written to the file when full; when no engine is
+     * capturing, it costs handlers a relaxed load. RPCs an engine sends
+     * to itself with local dispatch are not recorded. Calling this again
+     * ends the current capture and starts a new one.
+     *
+     * @param path Capture file, overwritten if it exists.
+     * @param options Capture parameters.
+     */
+    void capture_rpcs(const std::string& path,
+                      const rpc_capture_options& options = rpc_capture_options());
+
+    /**
+     * @brief Ends the capture started by capture_rpcs, writing the
+     * records still buffered. The capture also ends when the engine
+     * is finalized.
+     */
+    void stop_rpc_capture();
+
     /**
      * @brief Pushes a pre-finalization callback into the engine. This callback
      * will be called when margo_finalize is called (e.g. through
@@ -538,6 +1375,7 @@ class engine : public margo_instance_ref {
     template<typename F>
     void push_finalize_callback(const void* owner, F&& f) {
         MARGO_INSTANCE_MUST_BE_VALID;
+        if(owner) add_finalize_owner(owner);
         auto cb = new finalize_callback_t(std::forward<F>(f));
         margo_provider_push_finalize_callback(m_mid,
             owner,
@@ -650,6 +1488,14 @@ class engine : public margo_instance_ref {
      */
     pool get_progress_pool() const;
 
+    /**
+     * @brief Inspects the pools and execution streams of the engine and
+     * returns warnings about layouts known to perform badly (see
+     * engine_config::check). Handlers running in the progress pool are
+     * only reported for an engine that listens for RPCs.
+     */
+    std::vector<std::string> check_config() const;
+
     /**
      * @brief Create a timed_callback object linked to the engine.
      *
@@ -661,6 +1507,36 @@ class engine : public margo_instance_ref {
     template<typename F>
     timed_callback create_timed_callback(F&& cb) const;
 
+    /**
+     * @brief Schedules a callback to run after a delay, on the engine's
+     * timer wheel. Unlike timed_callback, which uses one margo timer
+     * each, all the callbacks scheduled this way share a single margo
+     * timer ticking every millisecond while some are pending, and their
+     * storage is drawn from a slab, so this scales to the hundreds of
+     * thousands of timers needed to e.g. expire one lease per request.
+     *
+     * The delay is rounded up to the next millisecond tick. Callbacks
+     * run in the context of the margo timer (typically the progress
+     * loop), in expiry order, so they should be short and hand longer
+     * work to a ULT. Their captures must fit in 48 bytes. Callbacks
+     * still pending when the engine is finalized are dropped.
+     *
+     * \code{.cpp}
+     * auto token = engine.schedule(std::chrono::seconds(30), [&leases, id]() {
+     *     leases.expire(id);
+     * });
+     * ...
+     * token.cancel(); // lease renewed
+     * \endcode
+     *
+     * @param delay Delay after which to run the callback.
+     * @param fn Callback.
+     *
+     * @return a token with which the callback can be cancelled.
+     */
+    template <typename R, typename P, typename F>
+    timer_token schedule(const std::chrono::duration<R, P>& delay, F&& fn) const;
+
     /**
      * @brief Get the JSON configuration of the internal
      * Margo instance.
@@ -1017,12 +1893,23 @@ class engine : public margo_instance_ref {
 
 #include <thallium/bulk.hpp>
 #include <thallium/request.hpp>
+#include <thallium/large.hpp>
 #include <thallium/proc_object.hpp>
 #include <thallium/pool.hpp>
 #include <thallium/xstream.hpp>
 #include <thallium/remote_procedure.hpp>
+#include <thallium/typed_remote_procedure.hpp>
+#include <thallium/busy.hpp>
+#include <thallium/cancellation.hpp>
+#include <thallium/drain.hpp>
+#include <thallium/engine_config.hpp>
 #include <thallium/timed_callback.hpp>
+#include <thallium/timer_wheel.hpp>
+#include <thallium/eventual.hpp>
 #include <thallium/serialization/proc_input_archive.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/tuple.hpp>
+#include <thallium/serialization/stl/vector.hpp>
 #include <thallium/serialization/proc_output_archive.hpp>
 #include <thallium/serialization/stl/tuple.hpp>
 
@@ -1040,42 +1927,283 @@ inline engine::engine(const std::string& addr, int mode, const pool& progress_po
         MARGO_THROW(margo_init_ext, HG_OTHER_ERROR, "Could not initialize Margo");
 }
 
-template <typename T1, typename... Tn>
+inline engine::engine(const std::string& addr, const single_threaded_client&,
+                      const hg_init_info* hg_opt) {
+    // the progress loop and the caller share the primary execution
+    // stream, so the loop only runs while the caller waits and can poll
+    std::string config = "{ \"use_progress_thread\" : false, \"rpc_thread_count\" : 0, "
+                       + progress_policy::busy_poll().to_json_fields() + " }";
+
+    hg_init_info hg_info;
+    if(hg_opt) hg_info = *hg_opt;
+    else memset(&hg_info, 0, sizeof(hg_info));
+#ifdef NA_THREAD_MODE_SINGLE
+    hg_info.na_init_info.thread_mode = NA_THREAD_MODE_SINGLE;
+#endif
+#ifdef NA_NO_BLOCK
+    hg_info.na_init_info.progress_mode |= NA_NO_BLOCK;
+#endif
+
+    margo_init_info args;
+    memset(&args, 0, sizeof(args));
+    args.json_config  = config.c_str();
+    args.hg_init_info = &hg_info;
+
+    m_mid = margo_init_ext(addr.c_str(), MARGO_CLIENT_MODE, &args);
+    if(!m_mid)
+        MARGO_THROW(margo_init_ext, HG_OTHER_ERROR, "Could not initialize Margo");
+}
+
+inline engine::engine(const std::string& addr, int mode, const engine_config& config,
+                      const hg_init_info *hg_opt)
+: engine(addr, mode, config.to_json(), hg_opt) {
+    for(const auto& warning : check_config())
+        margo_warning(m_mid, "[thallium] %s", warning.c_str());
+}
+
+inline std::vector<std::string> engine::check_config() const {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    detail::config_layout layout;
+    std::vector<ABT_pool> handles;
+    auto all_pools = pools();
+    for(std::size_t i = 0; i < all_pools.size(); i++) {
+        auto p = all_pools[i];
+        layout.pool_names.push_back(p.name());
+        handles.push_back(p.native_handle());
+    }
+    auto index_of = [&handles](ABT_pool h) {
+        return static_cast<std::size_t>(
+            std::find(handles.begin(), handles.end(), h) - handles.begin());
+    };
+    auto all_xstreams = xstreams();
+    for(std::size_t i = 0; i < all_xstreams.size(); i++) {
+        auto es = all_xstreams[i];
+        detail::config_layout::xstream_entry e;
+        e.name = es.name();
+        for(const auto& p : es.get_main_pools()) e.pools.push_back(index_of(p.native_handle()));
+        // an execution stream allowed on every CPU isn't bound to any
+        try {
+            e.cpus = es.get_affinity();
+        } catch(const exception&) {}
+        if(e.cpus.size() >= static_cast<std::size_t>(sysconf(_SC_NPROCESSORS_ONLN)))
+            e.cpus.clear();
+        layout.xstreams.push_back(std::move(e));
+    }
+    layout.progress_pool = index_of(get_progress_pool().native_handle());
+    layout.rpc_pool      = index_of(get_handler_pool().native_handle());
+    layout.listening     = is_listening();
+    return detail::check_layout(layout);
+}
+
+inline engine::engine(const std::string& addr, int mode, const progress_policy& policy,
+                      bool use_progress_thread, std::int32_t rpc_thread_count,
+                      const hg_init_info *hg_opt) {
+    std::string config = "{ \"use_progress_thread\" : ";
+    config += use_progress_thread ? "true" : "false";
+    config += ", \"rpc_thread_count\" : ";
+    config += std::to_string(rpc_thread_count);
+    config += ", " + policy.to_json_fields();
+    config +=  "}";
+
+    margo_init_info args;
+    memset(&args, 0, sizeof(args));
+    args.json_config  = config.c_str();
+    args.hg_init_info = (hg_init_info*)hg_opt;
+
+    m_mid = margo_init_ext(addr.c_str(), mode, &args);
+    if(!m_mid)
+        MARGO_THROW(margo_init_ext, HG_OTHER_ERROR, "Could not initialize Margo");
+    install_progress_monitor(policy);
+}
+
+inline engine::engine(const std::string& addr, int mode, const pool& progress_pool,
+                      const pool& default_handler_pool, const progress_policy& policy) {
+    std::string config = "{ " + policy.to_json_fields() + " }";
+
+    margo_init_info args;
+    memset(&args, 0, sizeof(args));
+    args.json_config    = config.c_str();
+    args.progress_pool  = progress_pool.native_handle();
+    args.rpc_pool       = default_handler_pool.native_handle();
+
+    m_mid = margo_init_ext(addr.c_str(), mode, &args);
+    if(!m_mid)
+        MARGO_THROW(margo_init_ext, HG_OTHER_ERROR, "Could not initialize Margo");
+    install_progress_monitor(policy);
+}
+
+inline void engine::install_progress_monitor(const progress_policy& policy) {
+    if(!policy.on_report) return;
+    auto monitor = detail::progress_monitor::install(
+        m_mid, policy.on_report, policy.report_interval);
+    if(!monitor)
+        throw exception("Could not create the timer of the progress monitor");
+    // the CPU clock is read from a ULT running where the progress loop runs
+    ABT_pool progress_pool = ABT_POOL_NULL;
+    margo_get_progress_pool(m_mid, &progress_pool);
+    ABT_thread ult = ABT_THREAD_NULL;
+    int ret = ABT_thread_create(progress_pool,
+        [](void* arg) { static_cast<detail::progress_monitor*>(arg)->capture_clock(); },
+        monitor.get(), ABT_THREAD_ATTR_NULL, &ult);
+    if(ret == ABT_SUCCESS) ABT_thread_free(&ult);
+}
+
+template <typename... CtxArg>
+typename std::enable_if<(sizeof...(CtxArg) > 0), request_with_context<CtxArg...>>::type
+engine::contextualize(const request& r) {
+    request_with_context<CtxArg...> req(r.m_mid, r.m_handle, r.m_disable_response);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    req.m_stats = r.m_stats;
+#endif
+    return req;
+}
+
+template <typename T1, typename... Tn>
+remote_procedure
+engine::define(const std::string&                               name,
+               std::function<void(const request&, T1, Tn...)>&& fun,
+               uint16_t provider_id, const pool& p) {
+    using signature = void (*)(const request&, T1, Tn...);
+    return define_impl(name, std::move(fun), signature(nullptr), provider_id, p);
+}
+
+template <typename... CtxArg, typename T1, typename... Tn>
+remote_procedure
+engine::define(const std::string& name,
+               std::function<void(const request_with_context<CtxArg...>&, T1, Tn...)>&& fun,
+               uint16_t provider_id, const pool& p) {
+    using signature = void (*)(const request_with_context<CtxArg...>&, T1, Tn...);
+    return define_impl(name, std::move(fun), signature(nullptr), provider_id, p);
+}
+
+template <typename F, typename... CtxArg, typename T1, typename... Tn>
 remote_procedure
-engine::define(const std::string&                               name,
-               std::function<void(const request&, T1, Tn...)>&& fun,
-               uint16_t provider_id, const pool& p) {
+engine::define_impl(const std::string& name, F&& fun,
+                    void (*signature)(const request_with_context<CtxArg...>&, T1, Tn...),
+                    uint16_t provider_id, const pool& p) {
     MARGO_INSTANCE_MUST_BE_VALID;
-    hg_id_t id = MARGO_REGISTER_PROVIDER(
-        m_mid, name.c_str(), meta_serialization, meta_serialization,
-        thallium_generic_rpc, provider_id, p.native_handle());
+    hg_id_t id = register_generic_rpc(name, provider_id, p);
+
+    rpc_callback_data* cb_data = make_rpc_callback(std::forward<F>(fun), signature);
+    if(cb_data->m_local) cb_data->m_local->set_type(id, cb_data->m_local_type);
+    track_in_flight(cb_data, id, name, provider_id);
+
+    auto ret = margo_register_data(m_mid, id, (void*)cb_data, free_rpc_callback_data);
+    MARGO_ASSERT(ret, margo_register_data);
+
+    return remote_procedure(m_mid, id);
+}
+
+template <typename F, typename... CtxArg, typename T1, typename... Tn>
+engine::rpc_callback_data*
+engine::make_rpc_callback(F&& fun,
+                          void (*)(const request_with_context<CtxArg...>&, T1, Tn...)) {
+    using args_type = std::tuple<typename std::decay<T1>::type,
+                                 typename std::decay<Tn>::type...>;
+    // RPCs sent by the engine to itself may hand their arguments by
+    // pointer (see enable_local_dispatch)
+    std::shared_ptr<detail::local_dispatch> local;
+    if(sizeof...(CtxArg) == 0
+    && detail::all_locally_passable<typename std::decay<T1>::type,
+                                    typename std::decay<Tn>::type...>::value)
+        local = detail::local_dispatch::find(m_mid);
 
     rpc_callback_data* cb_data = new rpc_callback_data;
+    cb_data->m_local      = local;
+    cb_data->m_local_type = detail::local_type_id<args_type>();
     cb_data->m_function =
-        [fun=std::move(fun), mid=get_margo_instance()](const request& r) {
-            std::function<void(T1, Tn...)> call_function =
-                [&fun, &r](const T1& a1, const Tn&... args) {
-                    fun(r, a1, args...);
-                };
-                std::tuple<typename std::decay<T1>::type,
-                   typename std::decay<Tn>::type...> iargs;
-            meta_proc_fn mproc = [mid, &iargs](hg_proc_t proc) {
-                auto ctx = std::tuple<>(); // TODO make this context available as argument
-                return proc_object_decode(proc, iargs, mid, ctx);
+        [fun=std::forward<F>(fun), mid=get_margo_instance(), local=local.get(),
+         cb=cb_data](const request& r) {
+            auto&& req = contextualize<CtxArg...>(r);
+            // std::pmr arguments are decoded into an arena released
+            // when the handler returns
+            detail::arena_decoded_t<args_type>
+                  decoded(detail::find_decode_arena(req.m_context), true);
+            auto& iargs = decoded.value;
+            // a local call run in the caller's ULT has no handle
+            bool in_place = r.m_handle == HG_HANDLE_NULL;
+            detail::local_call* local_call =
+                in_place ? r.m_local : local ? local->take(r.m_handle) : nullptr;
+            // the response to a local call is handed by value as well
+            r.m_local = local_call;
+            // an opaque_payload ending the arguments takes the bytes
+            // left after the leading ones
+            // (and before the control information, if the RPC has some)
+            std::size_t control_size = in_place ? 0
+                : detail::rpc_control_registry::trailer_size(cb->policy(mid, r.m_handle));
+            if(!in_place)
+                detail::opaque_payload_access::set_encoded_size(
+                    detail::opaque_payload_access::tail(iargs),
+                    HG_Get_input_payload_size(r.m_handle) - control_size);
+            detail::rpc_control control;
+            meta_proc_fn mproc = [mid, &iargs, &req, &control, control_size,
+                                  local_call](hg_proc_t proc) {
+                hg_return_t ret = HG_SUCCESS;
+                // the arguments of a local call are moved or copied, not decoded
+                if(local_call)
+                    detail::assign_local_args(iargs, *local_call,
+                        std::index_sequence_for<T1, Tn...>());
+                else
+                    ret = proc_object_decode(proc, iargs, mid, req.m_context);
+                if(ret != HG_SUCCESS || control_size == 0) return ret;
+                return detail::proc_rpc_control(proc, control);
             };
-            hg_return_t ret = margo_get_input(r.m_handle, &mproc);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+            detail::rpc_stats_scope decode_scope(r.m_stats, detail::rpc_metric::decode);
+#endif
+            hg_return_t ret = in_place ? mproc(HG_PROC_NULL) : margo_get_input(r.m_handle, &mproc);
             if(ret != HG_SUCCESS)
                 return ret;
-            ret = margo_free_input(r.m_handle, &mproc);
+            ret = in_place ? HG_SUCCESS : margo_free_input(r.m_handle, &mproc);
             if(ret != HG_SUCCESS)
                 return ret;
-            apply_function_to_tuple(call_function, iargs);
+            // dropped if the client cancelled it while it was queued
+            trace_context trace;
+            if(control_size && !detail::rpc_control_registry::begin(mid, r.m_handle, control, trace))
+                return HG_SUCCESS;
+            detail::pull_large_args(r, iargs);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+            decode_scope.finish();
+            detail::rpc_stats_scope handler_scope(r.m_stats, detail::rpc_metric::handler);
+#endif
+            detail::rpc_handler_trace handler_trace(mid, r.m_handle, trace);
+            // decoded arguments are moved into by-value and rvalue-reference
+            // parameters of the user's function instead of being copied
+            apply_function_to_forwarded_tuple<T1, Tn...>(
+                [&fun, &req](auto&&... args) {
+                    fun(req, std::forward<decltype(args)>(args)...);
+                }, iargs);
             return HG_SUCCESS;
         };
+    return cb_data;
+}
 
-    auto ret = margo_register_data(m_mid, id, (void*)cb_data, free_rpc_callback_data);
-    MARGO_ASSERT(ret, margo_register_data);
+template <typename F>
+engine::rpc_callback_data* engine::make_rpc_callback(F&& fun, void (*)(const request&)) {
+    auto* cb_data       = new rpc_callback_data;
+    cb_data->m_function = [fun=std::forward<F>(fun), mid=m_mid, cb=cb_data](const request& r) {
+        trace_context trace;
+        if(!detail::rpc_control_begin_void(cb->policy(mid, r.m_handle), mid, r.m_handle, trace))
+            return;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        detail::rpc_stats_scope handler_scope(r.m_stats, detail::rpc_metric::handler);
+#endif
+        detail::rpc_handler_trace handler_trace(mid, r.m_handle, trace);
+        fun(r);
+    };
+    return cb_data;
+}
 
+inline remote_procedure engine::register_shared_rpc(const std::string&           name,
+                                                    const std::shared_ptr<void>& cb_data,
+                                                    uint16_t provider_id, const pool& p) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    hg_id_t id   = register_generic_rpc(name, provider_id, p);
+    auto*   data = static_cast<rpc_callback_data*>(cb_data.get());
+    if(data->m_local) data->m_local->set_type(id, data->m_local_type);
+    // no free callback: the data is owned by the caller
+    hg_return_t ret = margo_register_data(m_mid, id, cb_data.get(), nullptr);
+    MARGO_ASSERT(ret, margo_register_data);
     return remote_procedure(m_mid, id);
 }
 
@@ -1121,10 +2249,53 @@ remote_procedure engine::define(const std::string& name,
                   provider_id, pool());
 }
 
+template <typename T1, typename... Tn>
+remote_procedure
+engine::define_aggregated(const std::string&                                    name,
+                          const std::function<void(const request&, T1, Tn...)>& fun,
+                          uint16_t provider_id, const pool& p) {
+    using batch_type = std::vector<std::tuple<typename std::decay<T1>::type,
+                                              typename std::decay<Tn>::type...>>;
+    define(detail::aggregated_rpc_name(name),
+        std::function<void(const request&, batch_type&)>(
+            [fun](const request& req, batch_type& batch) {
+                for(auto& args : batch) {
+                    apply_function_to_forwarded_tuple<T1, Tn...>(
+                        [&fun, &req](auto&&... a) {
+                            fun(req, std::forward<decltype(a)>(a)...);
+                        }, args);
+                }
+            }), provider_id, p).disable_response();
+    return define(name, fun, provider_id, p).disable_response();
+}
+
+template <typename... Args>
+remote_procedure
+engine::define_batched(const std::string&                                  name,
+                       const std::function<void(request_batch<Args...>&)>& fun,
+                       std::size_t max_batch_size,
+                       std::chrono::microseconds max_delay,
+                       uint16_t provider_id, const pool& p) {
+    auto state = std::make_shared<detail::request_batch_state<Args...>>(
+        fun, max_batch_size, max_delay);
+    return define(name,
+        std::function<void(const request&, Args...)>(
+            [state](const request& req, Args... args) {
+                state->add(req, std::move(args)...);
+            }), provider_id, p);
+}
+
 inline remote_procedure engine::define(const std::string& name) {
     return define(name.c_str());
 }
 
+inline remote_procedure engine::define_lazy(const std::string& name) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    remote_procedure rpc(m_mid, 0);
+    rpc.m_lazy = std::make_shared<detail::lazy_rpc>(name);
+    return rpc;
+}
+
 inline remote_procedure engine::define(const char* name) {
     MARGO_INSTANCE_MUST_BE_VALID;
     hg_bool_t flag;
@@ -1133,6 +2304,9 @@ inline remote_procedure engine::define(const char* name) {
     if(flag == HG_FALSE) {
         id = MARGO_REGISTER(m_mid, name, meta_serialization, meta_serialization, NULL);
     }
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    detail::rpc_stats_registry::get(m_mid)->add_name(id, name);
+#endif
     return remote_procedure(m_mid, id);
 }
 
@@ -1140,12 +2314,11 @@ inline remote_procedure engine::define(const std::string&
                                        const std::function<void(const request&)>& fun,
                                        uint16_t provider_id, const pool& p) {
     MARGO_INSTANCE_MUST_BE_VALID;
-    hg_id_t id = MARGO_REGISTER_PROVIDER(
-        m_mid, name.c_str(), meta_serialization, meta_serialization,
-        thallium_generic_rpc, provider_id, p.native_handle());
+    hg_id_t id = register_generic_rpc(name, provider_id, p);
 
-    auto* cb_data       = new rpc_callback_data;
-    cb_data->m_function = fun;
+    using signature = void (*)(const request&);
+    auto* cb_data = make_rpc_callback(fun, signature(nullptr));
+    track_in_flight(cb_data, id, name, provider_id);
 
     hg_return_t ret =
         margo_register_data(m_mid, id, (void*)cb_data, free_rpc_callback_data);
@@ -1161,13 +2334,242 @@ inline remote_procedure engine::define(const std::string&
 }
 
 inline endpoint engine::lookup(const std::string& address) const {
+    auto ep = try_lookup(address);
+    MARGO_ASSERT(ep.error(), margo_addr_lookup);
+    return std::move(*ep);
+}
+
+inline expected<endpoint> engine::try_lookup(const std::string& address) const {
     MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::address_cache::find(m_mid);
+    if(cache) {
+        hg_addr_t cached = cache->find(address);
+        if(cached != HG_ADDR_NULL) return endpoint(m_mid, cached);
+    }
     hg_addr_t   addr;
     hg_return_t ret = margo_addr_lookup(m_mid, address.c_str(), &addr);
-    MARGO_ASSERT(ret, margo_addr_lookup);
+    if(ret != HG_SUCCESS) return expected<endpoint>::failure(ret);
+    if(cache) cache->insert(address, addr);
     return endpoint(m_mid, addr);
 }
 
+namespace detail {
+
+/**
+ * @private
+ * @brief State of an engine::lookup_async call. Lookups are posted on
+ * the Mercury context directly since margo has no non-blocking lookup;
+ * their callbacks are triggered by margo's progress loop.
+ */
+struct address_lookup_batch {
+
+    margo_instance_id                                     m_mid;
+    std::shared_ptr<address_cache>                        m_cache;
+    std::vector<std::string>                              m_addresses;
+    std::vector<hg_addr_t>                                m_addrs;
+    std::atomic<std::size_t>                              m_remaining{0};
+    std::atomic<int>                                      m_error{HG_SUCCESS};
+    std::shared_ptr<eventual_state<std::vector<endpoint>>> m_result;
+
+    struct op {
+        std::shared_ptr<address_lookup_batch> m_batch;
+        std::size_t                           m_index;
+    };
+
+    void set_error(hg_return_t ret) {
+        int expected = HG_SUCCESS;
+        m_error.compare_exchange_strong(expected, ret);
+    }
+
+    void complete_one() {
+        if(m_remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        auto ret = static_cast<hg_return_t>(m_error.load());
+        if(ret != HG_SUCCESS) {
+            for(auto a : m_addrs)
+                if(a != HG_ADDR_NULL) margo_addr_free(m_mid, a);
+            m_result->complete([]() {}, std::make_exception_ptr(margo_exception(
+                "HG_Addr_lookup1", __FILE__, __LINE__, ret, translate_margo_error_code(ret))));
+            return;
+        }
+        std::vector<endpoint> endpoints;
+        endpoints.reserve(m_addrs.size());
+        for(std::size_t i = 0; i < m_addrs.size(); i++) {
+            if(m_cache) m_cache->insert(m_addresses[i], m_addrs[i]);
+            endpoints.emplace_back(m_mid, m_addrs[i]);
+        }
+        auto result = m_result.get();
+        result->complete([result, &endpoints]() { result->m_value = std::move(endpoints); });
+    }
+
+    static hg_return_t on_lookup(const struct hg_cb_info* info) {
+        std::unique_ptr<op> o(static_cast<op*>(info->arg));
+        auto& batch = *o->m_batch;
+        if(info->ret == HG_SUCCESS)
+            batch.m_addrs[o->m_index] = info->info.lookup.addr;
+        else
+            batch.set_error(info->ret);
+        batch.complete_one();
+        return HG_SUCCESS;
+    }
+};
+
+} // namespace detail
+
+inline eventual<std::vector<endpoint>>
+engine::lookup_async(const std::vector<std::string>& addresses) const {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    eventual<std::vector<endpoint>> result;
+    auto batch         = std::make_shared<detail::address_lookup_batch>();
+    batch->m_mid       = m_mid;
+    batch->m_cache     = detail::address_cache::find(m_mid);
+    batch->m_addresses = addresses;
+    batch->m_addrs.resize(addresses.size(), HG_ADDR_NULL);
+    batch->m_result    = result.m_state;
+    // one extra count so that completion cannot happen while posting
+    batch->m_remaining = addresses.size() + 1;
+    hg_context_t* context = margo_get_context(m_mid);
+    for(std::size_t i = 0; i < addresses.size(); i++) {
+        if(batch->m_cache) {
+            batch->m_addrs[i] = batch->m_cache->find(addresses[i]);
+            if(batch->m_addrs[i] != HG_ADDR_NULL) {
+                batch->complete_one();
+                continue;
+            }
+        }
+        auto o = new detail::address_lookup_batch::op{batch, i};
+        hg_return_t ret = HG_Addr_lookup1(context, &detail::address_lookup_batch::on_lookup,
+                                          o, addresses[i].c_str(), HG_OP_ID_IGNORE);
+        if(ret != HG_SUCCESS) {
+            delete o;
+            batch->set_error(ret);
+            batch->complete_one();
+        }
+    }
+    batch->complete_one();
+    return result;
+}
+
+template <typename Iterator>
+eventual<std::vector<endpoint>> engine::lookup_async(Iterator begin, Iterator end) const {
+    return lookup_async(std::vector<std::string>(begin, end));
+}
+
+inline void engine::enable_address_cache() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    if(detail::address_cache::find(m_mid))
+        return;
+    auto cache = std::make_shared<detail::address_cache>(m_mid);
+    detail::address_cache::install(m_mid, cache);
+    margo_instance_id mid = m_mid;
+    push_prefinalize_callback(cache.get(), [mid]() {
+        auto c = detail::address_cache::uninstall(mid);
+        if(c) c->clear(true);
+    });
+}
+
+inline void engine::disable_address_cache() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::address_cache::uninstall(m_mid);
+    if(!cache) return;
+    cache->clear(true);
+    pop_prefinalize_callback(cache.get());
+}
+
+inline void engine::invalidate_address(const std::string& address) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::address_cache::find(m_mid);
+    if(cache) cache->invalidate(address);
+    auto infos = detail::provider_info_cache::find(m_mid);
+    if(infos) infos->invalidate(address);
+}
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Returns the provider_info_cache of a margo instance, creating
+ * it (and its removal at finalization) on first use.
+ */
+inline std::shared_ptr<provider_info_cache> provider_info_cache_of(margo_instance_id mid) {
+    return provider_info_cache::get(mid, instance_release::at_prefinalize);
+}
+
+} // namespace detail
+
+inline void engine::enable_provider_handshake(std::uint64_t capabilities) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    capabilities |= provider_capability::varint | provider_capability::batched_rpcs
+                  | provider_capability::inline_bulk;
+    if(compression::available(compression::codec::lz4))
+        capabilities |= provider_capability::compression_lz4;
+    if(compression::available(compression::codec::zstd))
+        capabilities |= provider_capability::compression_zstd;
+    auto cache = detail::provider_info_cache_of(m_mid);
+    cache->set_local_capabilities(capabilities);
+    if(!cache->start_serving()) return;
+    margo_instance_id mid = m_mid;
+    std::function<void(const request&, std::uint16_t)> handler =
+        [mid, cache](const request& req, std::uint16_t provider_id) {
+            provider_info info;
+#if MARGO_VERSION_NUM >= 1500
+            const char* identity = margo_provider_registered_identity(mid, provider_id);
+            if(identity) info.identity = identity;
+#else
+            (void)mid;
+            (void)provider_id;
+            info.identity = "<unknown>";
+#endif
+            info.capabilities = cache->local_capabilities();
+            req.respond(info);
+        };
+    auto rpc = define(detail::provider_handshake_rpc_name(), std::move(handler));
+    cache->set_handshake_id(rpc.id());
+}
+
+inline provider_info engine::get_provider_info(const endpoint& ep, std::uint16_t provider_id,
+                                               bool refresh) const {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto          cache   = detail::provider_info_cache_of(m_mid);
+    std::string   address = static_cast<std::string>(ep);
+    provider_info info;
+    if(!refresh && cache->find(address, provider_id, info)) return info;
+    hg_id_t id = cache->handshake_id();
+    if(id == 0) {
+        id = engine(m_mid).define(detail::provider_handshake_rpc_name()).id();
+        cache->set_handshake_id(id);
+    }
+    auto reply = remote_procedure(m_mid, id).on(ep).try_call(provider_id);
+    if(reply) {
+        info = reply->as<provider_info>();
+    } else {
+        // the remote engine does not answer the handshake
+#if MARGO_VERSION_NUM >= 1500
+        hg_return_t       hret = HG_NOMEM;
+        std::vector<char> buffer(64);
+        while(hret == HG_NOMEM) {
+            buffer.resize(buffer.size() * 2);
+            std::size_t bufsize = buffer.size();
+            hret = margo_provider_get_identity(m_mid, ep.get_addr(), provider_id,
+                                               buffer.data(), &bufsize);
+        }
+        MARGO_ASSERT(hret, margo_provider_get_identity);
+        info.identity = buffer.data();
+#else
+        info.identity = "<unknown>";
+#endif
+        info.capabilities = 0;
+    }
+    cache->insert(address, provider_id, info);
+    return info;
+}
+
+inline address_cache_stats engine::get_address_cache_stats() const {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::address_cache::find(m_mid);
+    if(!cache) return address_cache_stats();
+    return cache->stats();
+}
+
 inline endpoint engine::self() const {
     MARGO_INSTANCE_MUST_BE_VALID;
     hg_addr_t   self_addr;
@@ -1179,6 +2581,14 @@ inline endpoint engine::self() const {
 inline bulk engine::expose(const std::vector<std::pair<void*, size_t>>& segments,
                     bulk_mode                                    flag) {
     MARGO_INSTANCE_MUST_BE_VALID;
+    std::shared_ptr<detail::bulk_cache> cache;
+    if(segments.size() == 1 && (cache = detail::bulk_cache::find(m_mid))) {
+        hg_bulk_t   cached;
+        std::size_t offset;
+        if(cache->find(segments[0].first, segments[0].second, flag, true,
+                       cached, offset))
+            return bulk(m_mid, cached, true, flag != bulk_mode::write_only);
+    }
     hg_bulk_t              handle;
     hg_uint32_t            count = segments.size();
     std::vector<void*>     buf_ptrs(count);
@@ -1191,7 +2601,8 @@ inline bulk engine::expose(const std::vector<std::pair<void*, size_t>>& segments
         m_mid, count, &buf_ptrs[0], &buf_sizes[0],
         static_cast<hg_uint32_t>(flag), &handle);
     MARGO_ASSERT(ret, margo_bulk_create);
-    return bulk(m_mid, handle, true);
+    if(cache) cache->insert(segments[0].first, segments[0].second, flag, handle);
+    return bulk(m_mid, handle, true, flag != bulk_mode::write_only);
 }
 
 #if (HG_VERSION_MAJOR > 2) || (HG_VERSION_MAJOR == 2 && HG_VERSION_MINOR > 1) \
@@ -1217,7 +2628,332 @@ inline bulk engine::expose(const std::vector<std::pair<void*, size_t>>& segments
     return bulk(m_mid, handle, true);
 }
 
+inline bulk engine::expose(const std::vector<std::pair<void*, size_t>>& segments,
+                           bulk_mode                                    flag,
+                           memory_type                                  type,
+                           std::uint64_t                                device) {
+    if(type == memory_type::host) return expose(segments, flag);
+    hg_bulk_attr attr;
+    switch(type) {
+    case memory_type::cuda: attr.mem_type = NA_MEM_TYPE_CUDA; break;
+    case memory_type::rocm: attr.mem_type = NA_MEM_TYPE_ROCM; break;
+    default:                attr.mem_type = NA_MEM_TYPE_ZE;   break;
+    }
+    attr.device = device;
+    return expose(segments, flag, attr);
+}
+
+#endif
+
+inline bulk engine::expose_file(const std::string& path, std::size_t offset,
+                                std::size_t length, bulk_mode flag,
+                                const file_map_options& options) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    bool read_only = flag == bulk_mode::read_only;
+    int  fd        = ::open(path.c_str(), (read_only ? O_RDONLY : O_RDWR) | O_CLOEXEC);
+    if(fd < 0)
+        throw exception("expose_file: cannot open ", path, ": ", std::strerror(errno));
+    struct stat st;
+    if(::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw exception("expose_file: cannot stat ", path, ": ", std::strerror(err));
+    }
+    auto file_size = static_cast<std::size_t>(st.st_size);
+    if(offset > file_size) {
+        ::close(fd);
+        throw exception("expose_file: offset ", offset, " is past the end of ", path);
+    }
+    if(length == 0) length = file_size - offset;
+    // pages past the end of the file cannot be accessed
+    if(length == 0 || length > file_size - offset) {
+        ::close(fd);
+        throw exception("expose_file: invalid range of ", path);
+    }
+    detail::file_range_key key{static_cast<std::uint64_t>(st.st_dev),
+                               static_cast<std::uint64_t>(st.st_ino),
+                               static_cast<std::uint64_t>(st.st_mtim.tv_sec) * 1000000000ull
+                                   + static_cast<std::uint64_t>(st.st_mtim.tv_nsec),
+                               offset, length, flag};
+    auto cache = detail::bulk_cache::find(m_mid);
+    if(cache) {
+        hg_bulk_t             cached;
+        std::shared_ptr<void> storage;
+        if(cache->find_file(key, cached, storage)) {
+            ::close(fd);
+            bulk b(m_mid, cached, true, flag != bulk_mode::write_only);
+            b.m_storage = std::move(storage);
+            return b;
+        }
+    }
+    // mappings start on a page boundary
+    auto        page    = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t delta   = offset % page;
+    std::size_t map_len = length + delta;
+    int         mflags  = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if(options.populate) mflags |= MAP_POPULATE;
+#endif
+    void* addr = ::mmap(nullptr, map_len, read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+                        mflags, fd, static_cast<off_t>(offset - delta));
+    int   err  = errno;
+    ::close(fd);
+    if(addr == MAP_FAILED)
+        throw exception("expose_file: cannot map ", path, ": ", std::strerror(err));
+#ifdef MADV_HUGEPAGE
+    if(options.huge_pages) ::madvise(addr, map_len, MADV_HUGEPAGE);
+#else
+    (void)options;
+#endif
+    std::shared_ptr<void> storage(addr, [map_len](void* p) { ::munmap(p, map_len); });
+    void*       ptr  = static_cast<char*>(addr) + delta;
+    hg_size_t   size = length;
+    hg_bulk_t   handle;
+    hg_return_t ret  = margo_bulk_create(m_mid, 1, &ptr, &size,
+                                         static_cast<hg_uint32_t>(flag), &handle);
+    MARGO_ASSERT(ret, margo_bulk_create);
+    if(cache) cache->insert_file(key, length, handle, storage);
+    bulk b(m_mid, handle, true, flag != bulk_mode::write_only);
+    b.m_storage = std::move(storage);
+    return b;
+}
+
+inline void engine::enable_handle_cache(std::size_t max_handles) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    if(detail::handle_cache::find(m_mid))
+        return;
+    auto cache = std::make_shared<detail::handle_cache>(m_mid, max_handles);
+    detail::handle_cache::install(m_mid, cache);
+    margo_instance_id mid = m_mid;
+    push_prefinalize_callback(cache.get(), [mid]() {
+        auto c = detail::handle_cache::uninstall(mid);
+        if(c) c->clear(true);
+    });
+}
+
+inline void engine::disable_handle_cache() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::handle_cache::uninstall(m_mid);
+    if(!cache) return;
+    cache->clear(true);
+    pop_prefinalize_callback(cache.get());
+}
+
+inline handle_cache_stats engine::get_handle_cache_stats() const {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::handle_cache::find(m_mid);
+    if(!cache) return handle_cache_stats();
+    return cache->stats();
+}
+
+inline void engine::enable_local_dispatch() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    if(detail::local_dispatch::find(m_mid))
+        return;
+    auto d = std::make_shared<detail::local_dispatch>(m_mid, &thallium_invoke_local_rpc);
+    detail::local_dispatch::install(m_mid, d);
+    margo_instance_id mid = m_mid;
+    push_prefinalize_callback(d.get(), [mid]() {
+        auto d = detail::local_dispatch::uninstall(mid);
+        if(d) d->close();
+    });
+}
+
+inline void engine::disable_local_dispatch() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto d = detail::local_dispatch::uninstall(m_mid);
+    if(!d) return;
+    d->close();
+    pop_prefinalize_callback(d.get());
+}
+
+inline void engine::enable_bulk_cache(std::size_t max_bytes) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    if(detail::bulk_cache::find(m_mid))
+        return;
+    auto cache = std::make_shared<detail::bulk_cache>(max_bytes);
+    detail::bulk_cache::install(m_mid, cache);
+    margo_instance_id mid = m_mid;
+    push_prefinalize_callback(cache.get(), [mid]() {
+        auto c = detail::bulk_cache::uninstall(mid);
+        if(c) c->clear(true);
+    });
+}
+
+inline void engine::disable_bulk_cache() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::bulk_cache::uninstall(m_mid);
+    if(!cache) return;
+    cache->clear(true);
+    pop_prefinalize_callback(cache.get());
+}
+
+inline void engine::enable_deferred_bulk_free(std::size_t max_pending, const pool& p) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    disable_deferred_bulk_free();
+    ABT_pool target = p.is_null() ? get_handler_pool().native_handle() : p.native_handle();
+    auto reaper = std::make_shared<detail::bulk_reaper>(target, max_pending);
+    detail::bulk_reaper::install(m_mid, reaper);
+    margo_instance_id mid = m_mid;
+    push_prefinalize_callback(reaper.get(), [mid]() {
+        auto r = detail::bulk_reaper::uninstall(mid);
+        if(r) r->close();
+    });
+}
+
+inline void engine::disable_deferred_bulk_free() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto reaper = detail::bulk_reaper::uninstall(m_mid);
+    if(!reaper) return;
+    reaper->close();
+    pop_prefinalize_callback(reaper.get());
+}
+
+inline void engine::enable_inline_bulk(std::size_t threshold) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    disable_inline_bulk();
+    auto setting = std::make_shared<detail::inline_bulk>(threshold);
+    detail::inline_bulk::install(m_mid, setting);
+    margo_instance_id mid = m_mid;
+    push_prefinalize_callback(setting.get(), [mid]() {
+        detail::inline_bulk::uninstall(mid);
+    });
+}
+
+inline void engine::disable_inline_bulk() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto setting = detail::inline_bulk::uninstall(m_mid);
+    if(!setting) return;
+    pop_prefinalize_callback(setting.get());
+}
+
+inline void engine::invalidate_bulk_cache(const void* ptr, std::size_t size) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::bulk_cache::find(m_mid);
+    if(cache) cache->invalidate(ptr, size);
+}
+
+inline bulk_cache_stats engine::get_bulk_cache_stats() const {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::bulk_cache::find(m_mid);
+    if(!cache) return bulk_cache_stats();
+    return cache->stats();
+}
+
+inline hg_id_t engine::register_generic_rpc(const std::string& name,
+                                            uint16_t provider_id, const pool& p) {
+    hg_id_t id = margo_provider_register_name(
+        m_mid, name.c_str(), hg_proc_meta_serialization, hg_proc_meta_serialization,
+        thallium_rpc_handler, provider_id, p.native_handle());
+    return id;
+}
+
+inline void engine::enable_rpc_stats(bool enable) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    detail::rpc_stats_registry::get(m_mid)->enable(enable);
+#else
+    if(enable)
+        throw exception("RPC statistics require compiling with THALLIUM_ENABLE_RPC_STATS");
+#endif
+}
+
+inline rpc_stats engine::get_rpc_stats() const {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    rpc_stats stats;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    auto reg = detail::rpc_stats_registry::find(m_mid);
+    if(reg) stats = reg->snapshot();
+#endif
+    stats.admission = detail::rpc_admission_registry::snapshot(m_mid);
+    stats.locks     = get_lock_stats();
+    stats.pools     = get_pool_stats();
+    std::size_t num_pools = margo_get_num_pools(m_mid);
+    for(std::size_t i = 0; i < num_pools; i++) {
+        margo_pool_info info;
+        int             id = -1;
+        if(margo_find_pool_by_index(m_mid, static_cast<uint32_t>(i), &info) != HG_SUCCESS
+           || ABT_pool_get_id(info.pool, &id) != ABT_SUCCESS)
+            continue;
+        for(auto& p : stats.pools)
+            if(p.pool_id == id && info.name) p.name = info.name;
+    }
+    return stats;
+}
+
+inline void engine::reset_rpc_stats() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    auto reg = detail::rpc_stats_registry::find(m_mid);
+    if(reg) reg->reset();
+#endif
+}
+
+inline void engine::enable_span_collection(std::size_t capacity) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    detail::span_collector::install(m_mid, capacity);
+#else
+    if(capacity)
+        throw exception("Span collection requires compiling with THALLIUM_ENABLE_RPC_STATS");
 #endif
+}
+
+inline void engine::enable_rpc_profiling(double interval_ms) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    detail::rpc_profiler::install(m_mid, interval_ms);
+}
+
+inline rpc_profile engine::get_rpc_profile() const {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto profiler = detail::rpc_profiler::find(m_mid);
+    if(!profiler) return rpc_profile();
+    return profiler->snapshot();
+}
+
+inline void engine::reset_rpc_profile() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto profiler = detail::rpc_profiler::find(m_mid);
+    if(profiler) profiler->reset();
+}
+
+inline void engine::capture_rpcs(const std::string& path, const rpc_capture_options& options) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    detail::rpc_capture::install(m_mid, path, options);
+}
+
+inline void engine::stop_rpc_capture() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    detail::rpc_capture::uninstall(m_mid);
+}
+
+inline std::vector<span_record> engine::collect_spans() {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto collector = detail::span_collector::find(m_mid);
+    if(!collector) return std::vector<span_record>();
+    return collector->drain();
+}
+
+inline bulk_segment engine::expose_cached(void* ptr, std::size_t size,
+                                          bulk_mode flag) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto cache = detail::bulk_cache::find(m_mid);
+    if(cache) {
+        hg_bulk_t   cached;
+        std::size_t offset;
+        if(cache->find(ptr, size, flag, false, cached, offset))
+            return bulk(m_mid, cached, true, flag != bulk_mode::write_only).select(offset, size);
+    }
+    // a miss registers the region and caches it, without going through
+    // expose(), which would look it up again
+    hg_bulk_t handle;
+    hg_size_t bulk_size = size;
+    hg_return_t ret = margo_bulk_create(m_mid, 1, &ptr, &bulk_size,
+                                        static_cast<hg_uint32_t>(flag), &handle);
+    MARGO_ASSERT(ret, margo_bulk_create);
+    if(cache) cache->insert(ptr, size, flag, handle);
+    return bulk(m_mid, handle, true, flag != bulk_mode::write_only).select(0, size);
+}
 
 inline bulk engine::wrap(hg_bulk_t blk, bool is_local) {
     MARGO_INSTANCE_MUST_BE_VALID;
@@ -1233,6 +2969,104 @@ inline void engine::shutdown_remote_engine(const endpoint& ep) const {
     MARGO_ASSERT(r, margo_shutdown_remote_instance);
 }
 
+inline void engine::track_in_flight(rpc_callback_data* cb_data, hg_id_t id,
+                                    const std::string& name, uint16_t provider_id) const {
+    cb_data->m_drain     = detail::rpc_drain::get(m_mid);
+    cb_data->m_in_flight = cb_data->m_drain->add_rpc(id, provider_id, name);
+    cb_data->m_monitor   = detail::progress_monitor::find(m_mid);
+    if(id != 0) cb_data->m_policy = &detail::rpc_policy_table::of(m_mid, id);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    cb_data->m_stats_registry = detail::rpc_stats_registry::get(m_mid);
+    cb_data->m_stats          = cb_data->m_stats_registry->add_server(id, provider_id, name);
+#endif
+}
+
+inline void engine::add_finalize_owner(const void* owner) const {
+    detail::rpc_drain::get(m_mid)->add_owner(owner);
+}
+
+inline finalize_report engine::finalize_with() {
+    return finalize_with(0, finalize_options());
+}
+
+inline finalize_report engine::finalize_with(const finalize_options& opts) {
+    return finalize_with(0, opts);
+}
+
+inline finalize_report engine::finalize_with(const request& caller) {
+    return finalize_with(caller, finalize_options());
+}
+
+inline finalize_report engine::finalize_with(const request& caller,
+                                            const finalize_options& opts) {
+    const struct hg_info* info = margo_get_info(caller.native_handle());
+    return finalize_with(info ? info->id : 0, opts);
+}
+
+inline finalize_report engine::finalize_with(hg_id_t caller_id,
+                                            const finalize_options& opts) {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto drain = detail::rpc_drain::get(m_mid);
+    finalize_report report;
+
+    drain->start();
+    auto start    = std::chrono::steady_clock::now();
+    auto deadline = start + opts.drain_timeout;
+    for(;;) {
+        report.in_flight = drain->in_flight(caller_id);
+        if(report.in_flight.empty()) break;
+        if(std::chrono::steady_clock::now() >= deadline) {
+            report.drained = false;
+            break;
+        }
+        margo_thread_sleep(m_mid, 1.0);
+    }
+    report.drain_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    report.rejected = drain->rejected();
+
+    // the callbacks of each owner, in the order margo would run them
+    using chain_type = std::vector<finalize_callback_t*>;
+    auto chains = std::make_shared<std::vector<chain_type>>();
+    for(const void* owner : drain->owners()) {
+        chain_type chain;
+        margo_finalize_callback_t cb = nullptr;
+        void* uargs = nullptr;
+        while(margo_provider_top_finalize_callback(m_mid, owner, &cb, &uargs) != 0
+              && cb == &engine::finalize_callback_wrapper) {
+            chain.push_back(static_cast<finalize_callback_t*>(uargs));
+            margo_provider_pop_finalize_callback(m_mid, owner);
+        }
+        if(!chain.empty()) chains->push_back(std::move(chain));
+    }
+    report.parallel_owners = chains->size();
+
+    if(!chains->empty()) {
+        std::vector<pool> pools = opts.callback_pools;
+        if(pools.empty()) pools.push_back(get_handler_pool());
+        margo_provider_push_finalize_callback(m_mid, nullptr, finalize_callback_wrapper,
+            new finalize_callback_t([chains, pools]() {
+                std::vector<managed<thread>> ults;
+                ults.reserve(chains->size());
+                for(std::size_t i = 0; i < chains->size(); i++) {
+                    chain_type* chain = &(*chains)[i];
+                    pool p = pools[i % pools.size()];
+                    ults.push_back(p.make_thread([chain]() {
+                        for(auto cb : *chain) {
+                            (*cb)();
+                            delete cb;
+                        }
+                        chain->clear();
+                    }));
+                }
+                for(auto& ult : ults) ult->join();
+            }));
+    }
+
+    finalize();
+    return report;
+}
+
 inline pool engine::get_handler_pool() const {
     MARGO_INSTANCE_MUST_BE_VALID;
     ABT_pool p = ABT_POOL_NULL;
@@ -1456,6 +3290,36 @@ inline timed_callback engine::create_timed_callback(F&& cb) const {
     return timed_callback(*this, std::forward<F>(cb));
 }
 
+template <typename R, typename P, typename F>
+inline timer_token engine::schedule(const std::chrono::duration<R, P>& delay, F&& fn) const {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    auto wheel = detail::timer_wheel::get(m_mid);
+    std::chrono::duration<double, std::milli> ms = delay;
+    auto entry = wheel->schedule(ms.count(),
+                                 detail::timer_wheel::callback_type(std::forward<F>(fn)));
+    return timer_token(std::move(wheel), entry);
+}
+
+// releases what a request was charged by its admission limit, and
+// dispatches the deferred requests this lets in
+inline void thallium_release_admission(detail::admission_state& admission,
+                                       hg_handle_t handle) {
+    if(!admission.accounted()) {
+        admission.release();
+        return;
+    }
+    std::vector<detail::deferred_rpc> ready;
+    admission.release(handle, ready);
+    for(std::size_t i = 0; i < ready.size(); i++) {
+        auto d = ready[i]; // failures below append to ready
+        if(thallium_dispatch_rpc(d.mid, d.handle, d.priority, d.has_priority, d.arrival)
+           == HG_SUCCESS)
+            continue;
+        admission.release(d.handle, ready);
+        margo_destroy(d.handle);
+    }
+}
+
 inline hg_return_t thallium_generic_rpc(hg_handle_t handle) {
     margo_instance_id mid = margo_hg_handle_get_instance(handle);
     THALLIUM_ASSERT_CONDITION(mid != 0,
@@ -1468,8 +3332,32 @@ inline hg_return_t thallium_generic_rpc(hg_handle_t handle) {
             "margo_registered_data returned null");
     auto    cb_data = static_cast<engine::rpc_callback_data*>(data);
     auto&   rpc = cb_data->m_function;
+    auto    policy = cb_data->policy(mid, handle);
+    if(detail::rpc_capture::active() && cb_data->m_in_flight
+    && !(cb_data->m_local && cb_data->m_local->has_call(handle))) {
+        auto capture = detail::rpc_capture::find(mid);
+        if(capture)
+            capture->record(handle, info->id, cb_data->m_in_flight->name,
+                            cb_data->m_in_flight->provider_id,
+                            detail::rpc_control_registry::trailer_size(policy));
+    }
     request req(mid, handle, false);
-    rpc(req);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    if(cb_data->m_stats && cb_data->m_stats_registry->enabled())
+        req.m_stats = cb_data->m_stats.get();
+#endif
+    auto admission = policy ? policy->admission.load(std::memory_order_acquire) : nullptr;
+    {
+        detail::rpc_profile_scope      profile_scope(mid, info->id);
+        detail::admission_charge_scope charge_scope(admission, handle);
+        rpc(req);
+    }
+    // only requests with control information were begun
+    if(detail::rpc_control_registry::trailer_size(policy))
+        detail::rpc_control_registry::end(mid, handle);
+    if(admission) thallium_release_admission(*admission, handle);
+    if(cb_data->m_in_flight)
+        cb_data->m_in_flight->count.fetch_sub(1, std::memory_order_release);
     margo_destroy(handle);
     return HG_SUCCESS;
 }
@@ -1477,6 +3365,190 @@ inline hg_return_t thallium_generic_rpc(hg_handle_t handle) {
 inline __MARGO_INTERNAL_RPC_WRAPPER(thallium_generic_rpc)
 inline __MARGO_INTERNAL_RPC_HANDLER(thallium_generic_rpc)
 
+// runs the handler of an RPC the engine sends to itself in the caller's
+// ULT, as thallium_generic_rpc does but without a handle, unless the
+// RPC has settings that need one (admission, sharding, execution,
+// control information), has its responses disabled, or is being
+// captured or drained, in which case it returns false and the call goes
+// through Mercury
+inline bool thallium_invoke_local_rpc(margo_instance_id mid, hg_id_t id,
+                                      detail::local_call& call) {
+    auto cb_data = static_cast<engine::rpc_callback_data*>(margo_registered_data(mid, id));
+    if(!cb_data || !cb_data->m_local) return false;
+    int disabled = 0;
+    margo_registered_disabled_response(mid, id, &disabled);
+    if(disabled) return false;
+    if(cb_data->m_drain && cb_data->m_drain->draining()) return false;
+    if(detail::rpc_capture::active()) return false;
+    auto policy = cb_data->m_policy ? cb_data->m_policy : detail::rpc_policy_table::find(mid, id);
+    if(policy && (policy->admission.load(std::memory_order_acquire)
+               || policy->shard.load(std::memory_order_acquire)
+               || policy->execution.load(std::memory_order_acquire)
+               || detail::rpc_control_registry::trailer_size(policy)))
+        return false;
+    request req(mid, HG_HANDLE_NULL, false);
+    req.m_local = &call;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    if(cb_data->m_stats && cb_data->m_stats_registry->enabled())
+        req.m_stats = cb_data->m_stats.get();
+#endif
+    // counted in flight like the requests received from Mercury
+    auto in_flight = cb_data->m_in_flight.get();
+    if(in_flight) in_flight->count.fetch_add(1, std::memory_order_relaxed);
+    struct in_flight_guard {
+        detail::rpc_in_flight* in_flight;
+        ~in_flight_guard() {
+            if(in_flight) in_flight->count.fetch_sub(1, std::memory_order_release);
+        }
+    } guard{in_flight};
+    detail::rpc_profile_scope profile_scope(mid, id);
+    cb_data->m_function(req);
+    return true;
+}
+
+#ifdef THALLIUM_ENABLE_RPC_STATS
+namespace detail {
+
+/**
+ * @private
+ * @brief Argument of the ULT running the handler of a request received
+ * while statistics are recorded: its handle, the time it was received
+ * at, and the metrics of its RPC.
+ */
+struct rpc_arrival {
+    hg_handle_t   handle;
+    std::uint64_t time;
+    rpc_metrics*  metrics;
+};
+
+} // namespace detail
+
+// records the time the request waited for its ULT to run, then runs
+// the handler as margo's wrapper does
+inline void thallium_timed_rpc_wrapper(void* arg) {
+    auto*       arrival = static_cast<detail::rpc_arrival*>(arg);
+    hg_handle_t handle  = arrival->handle;
+    arrival->metrics->record(detail::rpc_metric::queue,
+                             detail::rpc_stats_now() - arrival->time);
+    pooled_unit_allocator<detail::rpc_arrival>().deallocate(arrival, 1);
+    _wrapper_for_thallium_generic_rpc(handle);
+}
+#endif
+
+// creates the ULT (or task) running the handler of an admitted request,
+// as configured by remote_procedure::set_execution or by margo, in the
+// pool selected by remote_procedure::set_sharding if any; arrival is the
+// time the request was received at if statistics are being recorded,
+// 0 otherwise, and is handed to the ULT along with the handle
+inline hg_return_t thallium_dispatch_rpc(margo_instance_id mid, hg_handle_t handle,
+                                         int priority, bool has_priority,
+                                         std::uint64_t arrival) {
+    const struct hg_info* hinfo   = margo_get_info(handle);
+    auto                  cb_data = static_cast<engine::rpc_callback_data*>(
+        margo_registered_data(mid, hinfo->id));
+    auto policy = cb_data ? cb_data->policy(mid, handle) : nullptr;
+    void (*wrapper)(void*) = &_wrapper_for_thallium_generic_rpc;
+    void* arg              = handle;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    detail::rpc_arrival* timed = nullptr;
+    if(arrival && cb_data && cb_data->m_stats) {
+        timed   = pooled_unit_allocator<detail::rpc_arrival>().allocate(1);
+        *timed  = detail::rpc_arrival{handle, arrival, cb_data->m_stats.get()};
+        wrapper = &thallium_timed_rpc_wrapper;
+        arg     = timed;
+    }
+#else
+    (void)arrival;
+#endif
+    auto create_unit = [mid, handle, policy, wrapper, arg]() {
+        auto shard     = policy ? policy->shard.load(std::memory_order_acquire) : nullptr;
+        auto execution = policy ? policy->execution.load(std::memory_order_acquire) : nullptr;
+        // the selector decodes part of the input
+        ABT_pool pool = shard ? detail::rpc_shard_registry::select(*shard, handle) : ABT_POOL_NULL;
+        if(execution)
+            return detail::rpc_execution_registry::dispatch(mid, handle, *execution,
+                                                            wrapper, arg, pool);
+        if(pool == ABT_POOL_NULL && arg == handle)
+            return _handler_for_thallium_generic_rpc(handle);
+        if(pool == ABT_POOL_NULL) pool = margo_hg_handle_get_handler_pool(handle);
+        return detail::rpc_shard_registry::create_ult(mid, pool, wrapper, arg);
+    };
+    auto in_flight = cb_data ? cb_data->m_in_flight.get() : nullptr;
+    if(in_flight) in_flight->count.fetch_add(1, std::memory_order_relaxed);
+    hg_return_t ret;
+    if(has_priority) {
+        priority_scope scope(priority);
+        ret = create_unit();
+    } else {
+        ret = create_unit();
+    }
+    if(ret != HG_SUCCESS) {
+        if(in_flight) in_flight->count.fetch_sub(1, std::memory_order_release);
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        if(timed) pooled_unit_allocator<detail::rpc_arrival>().deallocate(timed, 1);
+#endif
+    }
+    return ret;
+}
+
+// called by the progress loop before the RPC's ULT is created, so that
+// the ULT is created with the RPC's priority and, if statistics are
+// recorded, knows when the request was received
+inline hg_return_t thallium_rpc_handler(hg_handle_t handle) {
+    margo_instance_id     mid     = margo_hg_handle_get_instance(handle);
+    const struct hg_info* hinfo   = margo_get_info(handle);
+    auto                  cb_data = static_cast<engine::rpc_callback_data*>(
+        margo_registered_data(mid, hinfo->id));
+    // cancellation requests, registered without callback data, are
+    // handled here, without a ULT
+    if(!cb_data && detail::rpc_control_registry::handle_cancel_rpc(mid, handle))
+        return HG_SUCCESS;
+    std::uint64_t arrival = 0;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    if(cb_data && cb_data->m_stats && cb_data->m_stats_registry->enabled())
+        arrival = detail::rpc_stats_now();
+#endif
+    // requests arriving while engine::finalize_with drains the RPCs are
+    // refused like those above the admission limit
+    if(cb_data && cb_data->m_drain && cb_data->m_drain->draining()) {
+        int disabled = 0;
+        margo_registered_disabled_response(mid, hinfo->id, &disabled);
+        if(!disabled) detail::respond_busy(handle);
+        cb_data->m_drain->count_rejected();
+        margo_destroy(handle);
+        return HG_SUCCESS;
+    }
+    auto monitor = cb_data ? cb_data->m_monitor.get() : nullptr;
+    auto start   = monitor ? tsc_clock::now() : tsc_clock::time_point{};
+    auto policy  = cb_data ? cb_data->policy(mid, handle) : nullptr;
+    int  priority     = policy ? policy->priority.load(std::memory_order_relaxed) : -1;
+    bool has_priority = priority >= 0;
+    // requests above the RPC's admission limit get a busy response
+    // (or are dropped) instead of a ULT, unless the limit defers them
+    auto admission = policy ? policy->admission.load(std::memory_order_acquire) : nullptr;
+    if(admission) {
+        using verdict = detail::admission_state::verdict;
+        verdict v = admission->accounted()
+                  ? admission->admit(mid, handle, priority, has_priority, arrival)
+                  : admission->try_admit(priority) ? verdict::admitted : verdict::rejected;
+        if(v == verdict::deferred) {
+            if(monitor) monitor->add_work(tsc_clock::now() - start);
+            return HG_SUCCESS;
+        }
+        if(v == verdict::rejected) {
+            int disabled = 0;
+            margo_registered_disabled_response(mid, hinfo->id, &disabled);
+            if(!disabled) detail::respond_busy(handle);
+            margo_destroy(handle);
+            return HG_SUCCESS;
+        }
+    }
+    hg_return_t ret = thallium_dispatch_rpc(mid, handle, priority, has_priority, arrival);
+    if(ret != HG_SUCCESS && admission) thallium_release_admission(*admission, handle);
+    if(monitor) monitor->add_work(tsc_clock::now() - start);
+    return ret;
+}
+
 } // namespace thallium
 
 #endif
@@ -0,0 +1,345 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_ENGINE_CONFIG_HPP
+#define __THALLIUM_ENGINE_CONFIG_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thallium/exception.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/progress_policy.hpp>
+#include <thallium/scheduler.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Pools and execution streams of an engine, as described by an
+ * engine_config or read from a running engine, checked by
+ * check_layout.
+ */
+struct config_layout {
+    struct xstream_entry {
+        std::string              name;
+        std::vector<std::size_t> pools; // indices in pool_names
+        std::vector<int>         cpus;
+    };
+    std::vector<std::string>   pool_names;
+    std::vector<xstream_entry> xstreams;
+    std::size_t                progress_pool = 0;
+    std::size_t                rpc_pool      = 0;
+    bool                       listening     = true;
+};
+
+/**
+ * @private
+ * @brief Returns warnings about the layouts known to perform badly.
+ */
+inline std::vector<std::string> check_layout(const config_layout& layout) {
+    std::vector<std::string> warnings;
+    auto pool_name = [&layout](std::size_t i) {
+        return i < layout.pool_names.size() ? layout.pool_names[i] : std::to_string(i);
+    };
+    auto serves = [](const config_layout::xstream_entry& es, std::size_t p) {
+        return std::find(es.pools.begin(), es.pools.end(), p) != es.pools.end();
+    };
+    if(layout.listening && layout.progress_pool == layout.rpc_pool)
+        warnings.push_back("RPC handlers run in the progress pool \""
+            + pool_name(layout.progress_pool)
+            + "\": long handlers will delay network progress");
+    std::vector<const config_layout::xstream_entry*> progress_es;
+    bool rpc_served = false;
+    for(const auto& es : layout.xstreams) {
+        rpc_served = rpc_served || serves(es, layout.rpc_pool);
+        if(!serves(es, layout.progress_pool)) continue;
+        progress_es.push_back(&es);
+        if(layout.progress_pool != layout.rpc_pool && serves(es, layout.rpc_pool))
+            warnings.push_back("The progress loop shares execution stream \"" + es.name
+                + "\" with the RPC handlers of pool \"" + pool_name(layout.rpc_pool) + "\"");
+    }
+    if(progress_es.empty())
+        warnings.push_back("No execution stream runs the progress pool \""
+            + pool_name(layout.progress_pool) + "\"");
+    if(!rpc_served)
+        warnings.push_back("No execution stream runs the RPC pool \""
+            + pool_name(layout.rpc_pool) + "\"");
+    for(auto pes : progress_es) {
+        for(int cpu : pes->cpus) {
+            for(const auto& es : layout.xstreams) {
+                if(&es == pes || serves(es, layout.progress_pool)) continue;
+                if(std::find(es.cpus.begin(), es.cpus.end(), cpu) == es.cpus.end()) continue;
+                warnings.push_back("The progress execution stream \"" + pes->name
+                    + "\" shares CPU " + std::to_string(cpu)
+                    + " with execution stream \"" + es.name + "\"");
+            }
+        }
+    }
+    return warnings;
+}
+
+} // namespace detail
+
+/**
+ * @brief engine_config builds the JSON configuration of margo (pools,
+ * execution streams and their CPU affinity, pools of the progress loop
+ * and of the RPC handlers) passed to the engine constructor taking an
+ * engine_config, which also logs the warnings of check() for the
+ * resulting engine (see engine::check_config).
+ *
+ * \code{.cpp}
+ * const auto& topo = tl::topology::get();
+ * tl::engine_config cfg;
+ * cfg.add_pool("progress")
+ *    .add_pool("handlers")
+ *    .add_pool("rdma")
+ *    .add_xstream("progress_es", {"progress"}, {0})
+ *    .add_xstreams("handler_es", tl::engine_config::cpu_range(2, 31), {"handlers"})
+ *    .add_xstreams("rdma_es", topo.cpus(1), {"rdma"})
+ *    .set_progress_pool("progress")
+ *    .set_rpc_pool("handlers");
+ * tl::engine engine("ofi+verbs", THALLIUM_SERVER_MODE, cfg);
+ * \endcode
+ *
+ * If no execution stream is named "__primary__", margo creates it
+ * with a pool of the same name, which is also the default progress
+ * and RPC pool.
+ */
+class engine_config {
+
+    struct pool_entry {
+        std::string  name;
+        std::string  kind;
+        pool::access access;
+    };
+
+    struct xstream_entry {
+        std::string              name;
+        std::vector<std::string> pools;
+        std::vector<int>         cpus;
+        scheduler::predef        sched;
+    };
+
+    std::vector<pool_entry>    m_pools;
+    std::vector<xstream_entry> m_xstreams;
+    std::string                m_progress_pool = "__primary__";
+    std::string                m_rpc_pool      = "__primary__";
+    std::string                m_progress_fields;
+
+    static std::string quote(const std::string& s) {
+        std::string r = "\"";
+        for(char c : s) {
+            if(c == '"' || c == '\\') r += '\\';
+            r += c;
+        }
+        return r + "\"";
+    }
+
+    static const char* access_name(pool::access a) {
+        switch(a) {
+        case pool::access::priv: return "private";
+        case pool::access::spsc: return "spsc";
+        case pool::access::mpsc: return "mpsc";
+        case pool::access::spmc: return "spmc";
+        default:                 return "mpmc";
+        }
+    }
+
+    static const char* scheduler_name(scheduler::predef s) {
+        switch(s) {
+        case scheduler::predef::basic:  return "basic";
+        case scheduler::predef::prio:   return "prio";
+        case scheduler::predef::randws: return "randws";
+        case scheduler::predef::deflt:  return "default";
+        default:                        return "basic_wait";
+        }
+    }
+
+    bool has_pool(const std::string& name) const {
+        for(const auto& p : m_pools)
+            if(p.name == name) return true;
+        return false;
+    }
+
+    bool has_xstream(const std::string& name) const {
+        for(const auto& es : m_xstreams)
+            if(es.name == name) return true;
+        return false;
+    }
+
+    /**
+     * @brief Pools and execution streams as margo will create them.
+     */
+    std::vector<pool_entry> all_pools() const {
+        auto pools = m_pools;
+        if(!has_xstream("__primary__") && !has_pool("__primary__"))
+            pools.push_back(pool_entry{"__primary__", "fifo_wait", pool::access::mpmc});
+        return pools;
+    }
+
+    std::vector<xstream_entry> all_xstreams() const {
+        auto xstreams = m_xstreams;
+        if(!has_xstream("__primary__"))
+            xstreams.push_back(xstream_entry{"__primary__", {"__primary__"}, {},
+                                             scheduler::predef::basic_wait});
+        return xstreams;
+    }
+
+  public:
+
+    /**
+     * @brief Returns the CPUs first to last (included).
+     */
+    static std::vector<int> cpu_range(int first, int last) {
+        std::vector<int> cpus;
+        for(int c = first; c <= last; c++) cpus.push_back(c);
+        return cpus;
+    }
+
+    /**
+     * @brief Adds a pool.
+     *
+     * @param name Name of the pool.
+     * @param kind Kind of pool, as named by margo ("fifo", "fifo_wait",
+     * "prio_wait", "earliest_first").
+     * @param access Access type of the pool.
+     */
+    engine_config& add_pool(const std::string& name, const std::string& kind = "fifo_wait",
+                            pool::access access = pool::access::mpmc) {
+        if(has_pool(name))
+            throw exception("engine_config: pool \"" + name + "\" already added");
+        m_pools.push_back(pool_entry{name, kind, access});
+        return *this;
+    }
+
+    /**
+     * @brief Adds an execution stream.
+     *
+     * @param name Name of the execution stream.
+     * @param pools Names of the pools its scheduler runs, in order of priority.
+     * @param cpus CPUs it is bound to (any CPU if empty).
+     * @param sched Predefined scheduler.
+     */
+    engine_config& add_xstream(const std::string& name, const std::vector<std::string>& pools,
+                               const std::vector<int>& cpus = {},
+                               scheduler::predef sched = scheduler::predef::basic_wait) {
+        if(has_xstream(name))
+            throw exception("engine_config: xstream \"" + name + "\" already added");
+        for(const auto& p : pools)
+            if(!has_pool(p) && p != "__primary__")
+                throw exception("engine_config: unknown pool \"" + p + "\"");
+        m_xstreams.push_back(xstream_entry{name, pools, cpus, sched});
+        return *this;
+    }
+
+    /**
+     * @brief Adds one execution stream per CPU, bound to it, named
+     * prefix followed by its index.
+     */
+    engine_config& add_xstreams(const std::string& prefix, const std::vector<int>& cpus,
+                                const std::vector<std::string>& pools,
+                                scheduler::predef sched = scheduler::predef::basic_wait) {
+        for(std::size_t i = 0; i < cpus.size(); i++)
+            add_xstream(prefix + std::to_string(i), pools, {cpus[i]}, sched);
+        return *this;
+    }
+
+    /**
+     * @brief Sets the pool in which the progress loop runs.
+     */
+    engine_config& set_progress_pool(const std::string& name) {
+        m_progress_pool = name;
+        return *this;
+    }
+
+    /**
+     * @brief Sets the pool in which RPC handlers run by default.
+     */
+    engine_config& set_rpc_pool(const std::string& name) {
+        m_rpc_pool = name;
+        return *this;
+    }
+
+    /**
+     * @brief Sets how the progress loop trades latency for CPU usage
+     * (the on_report hook of the policy is not part of the configuration).
+     */
+    engine_config& set_progress_policy(const progress_policy& policy) {
+        m_progress_fields = policy.to_json_fields();
+        return *this;
+    }
+
+    /**
+     * @brief Returns the JSON configuration for margo.
+     */
+    std::string to_json() const {
+        std::string json = "{ \"argobots\" : { \"pools\" : [";
+        for(std::size_t i = 0; i < m_pools.size(); i++) {
+            const auto& p = m_pools[i];
+            json += i ? ", " : " ";
+            json += "{ \"name\" : " + quote(p.name) + ", \"kind\" : " + quote(p.kind)
+                  + ", \"access\" : " + quote(access_name(p.access)) + " }";
+        }
+        json += " ], \"xstreams\" : [";
+        for(std::size_t i = 0; i < m_xstreams.size(); i++) {
+            const auto& es = m_xstreams[i];
+            json += i ? ", " : " ";
+            json += "{ \"name\" : " + quote(es.name);
+            if(es.cpus.size() == 1)
+                json += ", \"cpubind\" : " + std::to_string(es.cpus[0]);
+            if(!es.cpus.empty()) {
+                json += ", \"affinity\" : [";
+                for(std::size_t j = 0; j < es.cpus.size(); j++)
+                    json += (j ? ", " : " ") + std::to_string(es.cpus[j]);
+                json += " ]";
+            }
+            json += ", \"scheduler\" : { \"type\" : " + quote(scheduler_name(es.sched))
+                  + ", \"pools\" : [";
+            for(std::size_t j = 0; j < es.pools.size(); j++)
+                json += (j ? ", " : " ") + quote(es.pools[j]);
+            json += " ] } }";
+        }
+        json += " ] }, \"progress_pool\" : " + quote(m_progress_pool)
+              + ", \"rpc_pool\" : " + quote(m_rpc_pool);
+        if(!m_progress_fields.empty()) json += ", " + m_progress_fields;
+        return json + " }";
+    }
+
+    /**
+     * @brief Returns warnings about the layout of this configuration:
+     * handlers running in the progress pool or in the execution stream
+     * of the progress loop, pools of the progress loop or of the
+     * handlers that no execution stream runs, and CPUs shared by the
+     * progress execution stream and other ones.
+     */
+    std::vector<std::string> check() const {
+        detail::config_layout layout;
+        auto pools = all_pools();
+        for(const auto& p : pools) layout.pool_names.push_back(p.name);
+        auto index_of = [&layout](const std::string& name) {
+            auto it = std::find(layout.pool_names.begin(), layout.pool_names.end(), name);
+            return static_cast<std::size_t>(it - layout.pool_names.begin());
+        };
+        for(const auto& es : all_xstreams()) {
+            detail::config_layout::xstream_entry e;
+            e.name = es.name;
+            e.cpus = es.cpus;
+            for(const auto& p : es.pools) e.pools.push_back(index_of(p));
+            layout.xstreams.push_back(std::move(e));
+        }
+        layout.progress_pool = index_of(m_progress_pool);
+        layout.rpc_pool      = index_of(m_rpc_pool);
+        return detail::check_layout(layout);
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,246 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_ENGINE_GROUP_HPP
+#define __THALLIUM_ENGINE_GROUP_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <thallium/callable_remote_procedure.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/managed.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/xstream.hpp>
+
+namespace thallium {
+
+/**
+ * @brief An engine_group is a set of engines living in the same
+ * process, each listening on its own address (e.g. one per NIC or
+ * port) and driving its own Mercury context from a progress loop
+ * running in a dedicated execution stream, while all of them push the
+ * handlers of the RPCs they receive into the same pool. RPCs are
+ * defined on all the engines at once with engine_group::define.
+ *
+ * Clients are given the addresses() of the group and spread their
+ * calls across them with a group_handle.
+ *
+ * The engines are finalized when the group is destroyed, if they
+ * were not before.
+ */
+class engine_group {
+
+    // declared first so that the progress streams are joined after the
+    // engines were finalized
+    std::vector<managed<pool>>    m_progress_pools;
+    std::vector<managed<xstream>> m_progress_xstreams;
+    managed<pool>                 m_own_handler_pool;
+    std::vector<managed<xstream>> m_handler_xstreams;
+    pool                          m_handler_pool;
+    std::vector<engine>           m_engines;
+    bool                          m_finalized = false;
+
+    void init(const std::vector<std::string>& addresses, int mode) {
+        if(addresses.empty())
+            throw exception("An engine_group needs at least one address");
+        m_engines.reserve(addresses.size());
+        for(const auto& addr : addresses) {
+            m_progress_pools.push_back(pool::create(pool::access::mpmc, pool::kind::fifo_wait));
+            m_progress_xstreams.push_back(
+                xstream::create(scheduler::predef::basic_wait, *m_progress_pools.back()));
+            m_engines.emplace_back(addr, mode, *m_progress_pools.back(), m_handler_pool);
+        }
+    }
+
+  public:
+
+    /**
+     * @brief Creates one engine per address. The handlers of all the
+     * engines run in the provided pool, which must be served by
+     * execution streams managed by the caller.
+     *
+     * @param addresses Addresses (or protocols) of the engines.
+     * @param mode THALLIUM_SERVER_MODE or THALLIUM_CLIENT_MODE.
+     * @param handler_pool Pool shared by the handlers of all the engines.
+     */
+    engine_group(const std::vector<std::string>& addresses, int mode,
+                 const pool& handler_pool)
+    : m_handler_pool(handler_pool) {
+        init(addresses, mode);
+    }
+
+    /**
+     * @brief Creates one engine per address, and a pool shared by the
+     * handlers of all the engines, served by handler_xstreams execution
+     * streams.
+     *
+     * @param addresses Addresses (or protocols) of the engines.
+     * @param mode THALLIUM_SERVER_MODE or THALLIUM_CLIENT_MODE.
+     * @param handler_xstreams Number of execution streams running handlers.
+     */
+    engine_group(const std::vector<std::string>& addresses, int mode,
+                 std::size_t handler_xstreams = 1)
+    : m_own_handler_pool(pool::create(pool::access::mpmc, pool::kind::fifo_wait)) {
+        m_handler_pool = *m_own_handler_pool;
+        for(std::size_t i = 0; i < handler_xstreams; i++)
+            m_handler_xstreams.push_back(
+                xstream::create(scheduler::predef::basic_wait, m_handler_pool));
+        init(addresses, mode);
+    }
+
+    engine_group(const engine_group&)            = delete;
+    engine_group& operator=(const engine_group&) = delete;
+
+    /**
+     * @brief Destructor. Finalizes the engines if finalize was not called.
+     */
+    ~engine_group() {
+        finalize();
+        m_engines.clear();
+        m_handler_xstreams.clear();
+        m_progress_xstreams.clear();
+    }
+
+    /**
+     * @brief Finalizes all the engines of the group.
+     */
+    void finalize() {
+        if(m_finalized) return;
+        m_finalized = true;
+        for(auto& e : m_engines) e.finalize();
+    }
+
+    /**
+     * @brief Blocks until all the engines of the group are finalized.
+     */
+    void wait_for_finalize() {
+        for(auto& e : m_engines) e.wait_for_finalize();
+        m_finalized = true;
+    }
+
+    /**
+     * @brief Number of engines in the group.
+     */
+    std::size_t size() const { return m_engines.size(); }
+
+    engine& operator[](std::size_t i) { return m_engines[i]; }
+
+    const engine& operator[](std::size_t i) const { return m_engines[i]; }
+
+    std::vector<engine>::iterator begin() { return m_engines.begin(); }
+
+    std::vector<engine>::iterator end() { return m_engines.end(); }
+
+    /**
+     * @brief Pool in which the handlers of all the engines run.
+     */
+    const pool& get_handler_pool() const { return m_handler_pool; }
+
+    /**
+     * @brief Returns the addresses of the engines, in order, to be
+     * given to the clients of the group.
+     */
+    std::vector<std::string> addresses() const {
+        std::vector<std::string> result;
+        result.reserve(m_engines.size());
+        for(const auto& e : m_engines) result.push_back(e.self());
+        return result;
+    }
+
+    /**
+     * @brief Defines an RPC on every engine of the group, with the same
+     * handler, running in the group's handler pool. The arguments are
+     * those of engine::define, without the pool.
+     *
+     * @return the remote_procedure of each engine, in order.
+     */
+    template <typename... Args>
+    std::vector<remote_procedure> define(const std::string& name, Args&&... args) {
+        std::vector<remote_procedure> result;
+        result.reserve(m_engines.size());
+        for(auto& e : m_engines)
+            result.push_back(define_on(e, name, args...));
+        return result;
+    }
+
+  private:
+
+    remote_procedure define_on(engine& e, const std::string& name) {
+        return e.define(name);
+    }
+
+    template <typename F>
+    remote_procedure define_on(engine& e, const std::string& name, const F& fun,
+                               std::uint16_t provider_id = 0) {
+        return e.define(name, fun, provider_id, m_handler_pool);
+    }
+};
+
+/**
+ * @brief A group_handle spreads the calls of a client across the
+ * engines of an engine_group (or any set of equivalent servers): each
+ * call made with remote_procedure::on(group_handle) goes to the next
+ * address, in round-robin order.
+ */
+class group_handle {
+
+    std::vector<provider_handle>              m_members;
+    std::shared_ptr<std::atomic<std::size_t>> m_next =
+        std::make_shared<std::atomic<std::size_t>>(0);
+
+  public:
+
+    group_handle() = default;
+
+    /**
+     * @brief Looks up the addresses of the group.
+     *
+     * @param e Engine of the client.
+     * @param addresses Addresses of the group (engine_group::addresses).
+     * @param provider_id Provider id targeted on each engine.
+     */
+    group_handle(const engine& e, const std::vector<std::string>& addresses,
+                 std::uint16_t provider_id = 0) {
+        auto endpoints = e.lookup_async(addresses).wait();
+        m_members.reserve(endpoints.size());
+        for(auto& ep : endpoints) m_members.emplace_back(std::move(ep), provider_id);
+    }
+
+    /**
+     * @brief Builds a group_handle from already resolved members.
+     */
+    explicit group_handle(std::vector<provider_handle> members)
+    : m_members(std::move(members)) {}
+
+    std::size_t size() const { return m_members.size(); }
+
+    const provider_handle& operator[](std::size_t i) const { return m_members[i]; }
+
+    /**
+     * @brief Returns the member the next call should go to.
+     */
+    const provider_handle& next() const {
+        if(m_members.empty())
+            throw exception("Calling an RPC on an empty group_handle");
+        std::size_t i = m_next->fetch_add(1, std::memory_order_relaxed);
+        return m_members[i % m_members.size()];
+    }
+};
+
+inline callable_remote_procedure remote_procedure::on(const group_handle& gh) const {
+    return on(gh.next());
+}
+
+} // namespace thallium
+
+#endif
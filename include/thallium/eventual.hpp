@@ -7,8 +7,16 @@
 #define __THALLIUM_EVENTUAL_HPP
 
 #include <abt.h>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thallium/exception.hpp>
+#include <thallium/non_blocking.hpp>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace thallium {
 
@@ -35,13 +43,219 @@ class eventual_exception : public exception {
         }                                                                      \
     }
 
+namespace detail {
+
+/**
+ * @private
+ * @brief State shared by an eventual and the continuations attached
+ * to it, so that the eventual can be moved while continuations are
+ * pending. Callbacks registered with on_ready run in the context of
+ * the caller of complete(), right after the ABT_eventual is set.
+ */
+class eventual_core {
+
+    ABT_eventual                       m_eventual = ABT_EVENTUAL_NULL;
+    std::mutex                         m_mutex;
+    bool                               m_ready = false;
+    std::exception_ptr                 m_error;
+    std::vector<std::function<void()>> m_callbacks;
+
+  public:
+
+    eventual_core() { TL_EVENTUAL_ASSERT(ABT_eventual_create(0, &m_eventual)); }
+
+    ~eventual_core() { ABT_eventual_free(&m_eventual); }
+
+    eventual_core(const eventual_core&)            = delete;
+    eventual_core& operator=(const eventual_core&) = delete;
+
+    ABT_eventual native_handle() const noexcept { return m_eventual; }
+
+    /**
+     * @brief Calls store (which sets the value) and marks the eventual
+     * as ready, unless it already is. Returns false in this case.
+     */
+    template <typename F>
+    bool try_complete(F&& store, std::exception_ptr error = nullptr) {
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_ready) return false;
+            if(error) m_error = std::move(error);
+            else store();
+            m_ready = true;
+            std::swap(callbacks, m_callbacks);
+        }
+        TL_EVENTUAL_ASSERT(ABT_eventual_set(m_eventual, nullptr, 0));
+        for(auto& cb : callbacks) cb();
+        return true;
+    }
+
+    template <typename F>
+    void complete(F&& store, std::exception_ptr error = nullptr) {
+        if(!try_complete(std::forward<F>(store), std::move(error)))
+            throw eventual_exception("eventual is already set");
+    }
+
+    /**
+     * @brief Calls cb once the eventual is ready (immediately if it
+     * already is).
+     */
+    void on_ready(std::function<void()> cb) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_ready) {
+                m_callbacks.push_back(std::move(cb));
+                return;
+            }
+        }
+        cb();
+    }
+
+    bool has_error() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return static_cast<bool>(m_error);
+    }
+
+    std::exception_ptr error() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_error;
+    }
+
+    void wait() {
+        detail::check_can_block("eventual::wait");
+        TL_EVENTUAL_ASSERT(ABT_eventual_wait(m_eventual, nullptr));
+        std::exception_ptr e = error();
+        if(e) std::rethrow_exception(e);
+    }
+
+    bool test() {
+        int flag;
+        TL_EVENTUAL_ASSERT(ABT_eventual_test(m_eventual, nullptr, &flag));
+        return flag;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_callbacks.empty())
+            throw eventual_exception("Cannot reset an eventual with pending continuations");
+        m_ready = false;
+        m_error = nullptr;
+        TL_EVENTUAL_ASSERT(ABT_eventual_reset(m_eventual));
+    }
+};
+
+template <typename T> struct eventual_state : public eventual_core {
+    T m_value;
+};
+
+template <> struct eventual_state<void> : public eventual_core {};
+
+/**
+ * @private
+ * @brief Submits fn as an anonymous task (or ULT, if fn may block) in
+ * the pool, or runs it in place if it could not be created.
+ */
+template <typename F>
+void eventual_submit(ABT_pool pool, F&& fn, bool as_thread = false) {
+    using fn_type = typename std::decay<F>::type;
+    auto arg   = new fn_type(std::forward<F>(fn));
+    auto entry = [](void* a) {
+        std::unique_ptr<fn_type> f(static_cast<fn_type*>(a));
+        (*f)();
+    };
+    int ret = as_thread
+            ? ABT_thread_create(pool, entry, arg, ABT_THREAD_ATTR_NULL, nullptr)
+            : ABT_task_create(pool, entry, arg, nullptr);
+    if(ret != ABT_SUCCESS) {
+        std::unique_ptr<fn_type> f(arg);
+        (*f)();
+    }
+}
+
+/**
+ * @private
+ * @brief Sets the state of the eventual returned by a continuation
+ * with the result of the continuation (or the exception it threw).
+ */
+template <typename R> struct eventual_fulfill {
+    template <typename F, typename... Args>
+    static void call(eventual_state<R>& s, F& f, Args&... args) {
+        try {
+            R r = f(args...);
+            s.complete([&s, &r]() { s.m_value = std::move(r); });
+        } catch(...) {
+            s.complete([]() {}, std::current_exception());
+        }
+    }
+};
+
+template <> struct eventual_fulfill<void> {
+    template <typename F, typename... Args>
+    static void call(eventual_state<void>& s, F& f, Args&... args) {
+        try {
+            f(args...);
+            s.complete([]() {});
+        } catch(...) {
+            s.complete([]() {}, std::current_exception());
+        }
+    }
+};
+
+template <typename T> struct eventual_awaiter;
+
+} // namespace detail
+
+class pool;
+template <typename T> class channel;
+class task_graph;
+
 /**
  * @brief The eventual class wraps an ABT_eventual object.
  * It is a template class, with the template type T being
  * the object stored by the eventual. T must be default-constructible
  * and assignable.
+ *
+ * Constructing an eventual allocates its state (the ABT_eventual, the
+ * value and the continuations) on the heap, so that continuations keep
+ * it alive; eventuals on hot paths should be reused with reset()
+ * rather than created for each operation. Moving an eventual moves
+ * this state: the moved-from eventual may only be assigned to or
+ * destroyed, and its other functions throw an eventual_exception.
+ *
+ * Any number of ULTs can wait on an eventual. Continuations can also
+ * be attached with then(), which runs a function as a task in a given
+ * pool once the value is set and returns an eventual for its result,
+ * so that asynchronous steps can be chained without a ULT blocking at
+ * each step. when_all and when_any combine several eventuals.
+ *
+ * \code{.cpp}
+ * tl::eventual<int> ev;
+ * auto doubled = ev.then(pool, [](int x) { return 2*x; });
+ * ev.set_value(21);
+ * int x = doubled.wait(); // 42
+ * \endcode
  */
 template <typename T> class eventual {
+
+    template <typename U> friend class eventual;
+
+    template <typename U>
+    friend eventual<void> when_all(std::vector<eventual<U>>& evs);
+
+    template <typename U>
+    friend eventual<std::size_t> when_any(std::vector<eventual<U>>& evs);
+
+    template <typename... Ts>
+    friend eventual<void> when_all(eventual<Ts>&... evs);
+
+    friend class async_response;
+    friend class engine;
+    friend class remote_bulk;
+    friend struct detail::eventual_awaiter<T>;
+
+    template <typename U> friend class channel;
+
   public:
     /**
      * @brief Type of value stored by the eventual.
@@ -54,8 +268,12 @@ template <typename T> class eventual {
     using native_handle_type = ABT_eventual;
 
   private:
-    ABT_eventual m_eventual;
-    value_type   m_value;
+    std::shared_ptr<detail::eventual_state<value_type>> m_state;
+
+    detail::eventual_state<value_type>& state() const {
+        if(!m_state) throw eventual_exception("eventual was moved from");
+        return *m_state;
+    }
 
   public:
     /**
@@ -63,17 +281,15 @@ template <typename T> class eventual {
      *
      * @return The underlying native handle.
      */
-    ABT_eventual native_handle() const noexcept { return m_eventual; }
-
-    /**
-     * @brief Constryctor.
-     */
-    eventual() { TL_EVENTUAL_ASSERT(ABT_eventual_create(0, &m_eventual)); }
+    ABT_eventual native_handle() const noexcept {
+        return m_state ? m_state->native_handle() : ABT_EVENTUAL_NULL;
+    }
 
     /**
-     * @brief Destructor.
+     * @brief Constructor.
      */
-    ~eventual() { ABT_eventual_free(&m_eventual); }
+    eventual()
+    : m_state(std::make_shared<detail::eventual_state<value_type>>()) {}
 
     /**
      * @brief Copy constructor is deleted.
@@ -86,29 +302,16 @@ template <typename T> class eventual {
     eventual& operator=(const eventual& other) = delete;
 
     /**
-     * @brief Move assignment operator. If the left and right
-     * operands are different, this function will assign the
-     * right operand's resource to the left. This invalidates
-     * the right operand.
+     * @brief Move assignment operator. This invalidates
+     * the right operand (see above). Continuations attached
+     * to either eventual remain attached to their original state.
      */
-    eventual& operator=(eventual&& other) {
-        if(this == other.m_eventual)
-            return *this;
-        if(m_eventual != ABT_EVENTUAL_NULL) {
-            TL_EVENTUAL_ASSERT(ABT_eventual_free(&m_eventual));
-        }
-        m_eventual       = other.m_eventual;
-        other.m_eventual = ABT_EVENTUAL_NULL;
-        return *this;
-    }
+    eventual& operator=(eventual&& other) noexcept = default;
 
     /**
-     * @brief Move constructor.
+     * @brief Move constructor. This invalidates the right operand.
      */
-    eventual(eventual&& other)
-    : m_eventual(other.m_eventual) {
-        other.m_eventual = ABT_EVENTUAL_NULL;
-    }
+    eventual(eventual&& other) noexcept = default;
 
     /**
      * @brief Set the eventual's value (by copy).
@@ -116,8 +319,8 @@ template <typename T> class eventual {
      * @param val Value to give the eventual.
      */
     void set_value(const T& val) {
-        m_value = val;
-        TL_EVENTUAL_ASSERT(ABT_eventual_set(m_eventual, nullptr, 0));
+        auto s = &state();
+        s->complete([s, &val]() { s->m_value = val; });
     }
 
     /**
@@ -126,8 +329,18 @@ template <typename T> class eventual {
      * @param val Value to give the eventual.
      */
     void set_value(T&& val) {
-        m_value = std::move(val);
-        TL_EVENTUAL_ASSERT(ABT_eventual_set(m_eventual, nullptr, 0));
+        auto s = &state();
+        s->complete([s, &val]() { s->m_value = std::move(val); });
+    }
+
+    /**
+     * @brief Set the eventual in an error state. Waiting on it
+     * rethrows the exception.
+     *
+     * @param e Exception.
+     */
+    void set_exception(std::exception_ptr e) {
+        state().complete([]() {}, std::move(e));
     }
 
     /**
@@ -136,8 +349,8 @@ template <typename T> class eventual {
      * @return The value stored in the eventual.
      */
     value_type wait() const & {
-        TL_EVENTUAL_ASSERT(ABT_eventual_wait(m_eventual, nullptr));
-        return m_value;
+        state().wait();
+        return m_state->m_value;
     }
 
     /**
@@ -146,32 +359,64 @@ template <typename T> class eventual {
      * @return The value stored in the eventual.
      */
     value_type&& wait() && {
-        TL_EVENTUAL_ASSERT(ABT_eventual_wait(m_eventual, nullptr));
-        return std::move(m_value);
+        state().wait();
+        return std::move(m_state->m_value);
     }
 
     /**
      * @brief Test the eventual.
      */
     bool test() {
-        int flag;
-        TL_EVENTUAL_ASSERT(ABT_eventual_test(m_eventual, nullptr, &flag));
-        return flag;
+        return state().test();
     }
 
     /**
-     * @brief Reset the eventual.
+     * @brief Reset the eventual. This is not allowed while continuations
+     * are pending.
      */
     void reset() {
-        m_value = value_type{};
-        TL_EVENTUAL_ASSERT(ABT_eventual_reset(m_eventual));
+        state().reset();
+        m_state->m_value = value_type{};
     }
+
+    /**
+     * @brief Attaches a continuation to the eventual. Once the value is
+     * set (immediately if it already is), fn is called with it as an
+     * anonymous task in the provided pool and the eventual returned by
+     * then() is set with its result. If the eventual is set with an
+     * exception, fn is not called and the exception is propagated.
+     *
+     * Since fn runs as a task, it must not block.
+     *
+     * @param p Pool in which to run the continuation.
+     * @param fn Function taking a value_type& argument.
+     *
+     * @return an eventual for the result of fn.
+     */
+    template <typename F>
+    auto then(const pool& p, F&& fn)
+    -> eventual<typename std::decay<decltype(fn(std::declval<value_type&>()))>::type>;
 };
 
 /**
  * @brief Specialization of eventual class for T=void
  */
 template <> class eventual<void> {
+
+    template <typename U> friend class eventual;
+
+    template <typename U>
+    friend eventual<void> when_all(std::vector<eventual<U>>& evs);
+
+    template <typename U>
+    friend eventual<std::size_t> when_any(std::vector<eventual<U>>& evs);
+
+    template <typename... Ts>
+    friend eventual<void> when_all(eventual<Ts>&... evs);
+
+    friend struct detail::eventual_awaiter<void>;
+    friend class task_graph;
+
   public:
     /**
      * @brief Native handle type.
@@ -179,7 +424,12 @@ template <> class eventual<void> {
     using native_handle_type = ABT_eventual;
 
   private:
-    ABT_eventual m_eventual;
+    std::shared_ptr<detail::eventual_state<void>> m_state;
+
+    detail::eventual_state<void>& state() const {
+        if(!m_state) throw eventual_exception("eventual was moved from");
+        return *m_state;
+    }
 
   public:
     /**
@@ -187,17 +437,15 @@ template <> class eventual<void> {
      *
      * @return The underlying native handle.
      */
-    ABT_eventual native_handle() const noexcept { return m_eventual; }
+    ABT_eventual native_handle() const noexcept {
+        return m_state ? m_state->native_handle() : ABT_EVENTUAL_NULL;
+    }
 
     /**
      * @brief Constructor.
      */
-    eventual() { TL_EVENTUAL_ASSERT(ABT_eventual_create(0, &m_eventual)); }
-
-    /**
-     * @brief Destructor.
-     */
-    ~eventual() { ABT_eventual_free(&m_eventual); }
+    eventual()
+    : m_state(std::make_shared<detail::eventual_state<void>>()) {}
 
     /**
      * @brief Copy constructor is deleted.
@@ -210,57 +458,177 @@ template <> class eventual<void> {
     eventual& operator=(const eventual& other) = delete;
 
     /**
-     * @brief Move assignment operator. If the left and right
-     * operands are different, this function will assign the
-     * right operand's resource to the left. This invalidates
-     * the right operand.
+     * @brief Move assignment operator. This invalidates
+     * the right operand (see eventual<T>).
      */
-    eventual& operator=(eventual&& other) {
-        if(m_eventual == other.m_eventual)
-            return *this;
-        if(m_eventual != ABT_EVENTUAL_NULL) {
-            TL_EVENTUAL_ASSERT(ABT_eventual_free(&m_eventual));
-        }
-        m_eventual       = other.m_eventual;
-        other.m_eventual = ABT_EVENTUAL_NULL;
-        return *this;
-    }
+    eventual& operator=(eventual&& other) noexcept = default;
 
     /**
-     * @brief Move constructor.
+     * @brief Move constructor. This invalidates the right operand.
      */
-    eventual(eventual&& other) noexcept
-    : m_eventual(other.m_eventual) {
-        other.m_eventual = ABT_EVENTUAL_NULL;
-    }
+    eventual(eventual&& other) noexcept = default;
 
     /**
      * @brief Set the eventual.
      */
     void set_value() {
-        TL_EVENTUAL_ASSERT(ABT_eventual_set(m_eventual, nullptr, 0));
+        state().complete([]() {});
+    }
+
+    /**
+     * @brief Set the eventual in an error state. Waiting on it
+     * rethrows the exception.
+     *
+     * @param e Exception.
+     */
+    void set_exception(std::exception_ptr e) {
+        state().complete([]() {}, std::move(e));
     }
 
     /**
      * @brief Wait on the eventual.
      */
-    void wait() { TL_EVENTUAL_ASSERT(ABT_eventual_wait(m_eventual, nullptr)); }
+    void wait() { state().wait(); }
 
     /**
      * @brief Test the eventual.
      */
-    bool test() {
-        int flag;
-        TL_EVENTUAL_ASSERT(ABT_eventual_test(m_eventual, nullptr, &flag));
-        return flag;
-    }
+    bool test() { return state().test(); }
 
     /**
-     * @brief Reset the eventual.
+     * @brief Reset the eventual. This is not allowed while continuations
+     * are pending.
      */
-    void reset() { TL_EVENTUAL_ASSERT(ABT_eventual_reset(m_eventual)); }
+    void reset() { state().reset(); }
+
+    /**
+     * @brief Attaches a continuation to the eventual, see
+     * eventual<T>::then. fn takes no argument.
+     */
+    template <typename F>
+    auto then(const pool& p, F&& fn)
+    -> eventual<typename std::decay<decltype(fn())>::type>;
 };
 
+namespace detail {
+
+inline eventual<void> when_all_cores(std::vector<std::shared_ptr<eventual_core>> cores,
+                                     eventual<void> result,
+                                     std::shared_ptr<eventual_core> result_core) {
+    if(cores.empty()) {
+        result.set_value();
+        return result;
+    }
+    for(auto& c : cores)
+        if(!c) throw eventual_exception("eventual was moved from");
+    auto remaining = std::make_shared<std::atomic<std::size_t>>(cores.size());
+    for(auto& c : cores) {
+        std::weak_ptr<eventual_core> w = c;
+        c->on_ready([w, remaining, result_core]() {
+            auto c = w.lock();
+            auto e = c ? c->error() : nullptr;
+            if(e) result_core->try_complete([]() {}, e);
+            if(remaining->fetch_sub(1) == 1)
+                result_core->try_complete([]() {});
+        });
+    }
+    return result;
+}
+
+} // namespace detail
+
+/**
+ * @brief Returns an eventual that is set once all the provided eventuals
+ * are set. If any of them is set with an exception, the first such
+ * exception is propagated. The values remain in the provided eventuals.
+ */
+template <typename T>
+eventual<void> when_all(std::vector<eventual<T>>& evs) {
+    std::vector<std::shared_ptr<detail::eventual_core>> cores;
+    for(auto& ev : evs) cores.push_back(ev.m_state);
+    eventual<void> result;
+    auto result_core = std::static_pointer_cast<detail::eventual_core>(result.m_state);
+    return detail::when_all_cores(std::move(cores), std::move(result), std::move(result_core));
+}
+
+/**
+ * @brief Variadic version of when_all.
+ */
+template <typename... Ts>
+eventual<void> when_all(eventual<Ts>&... evs) {
+    std::vector<std::shared_ptr<detail::eventual_core>> cores{evs.m_state...};
+    eventual<void> result;
+    auto result_core = std::static_pointer_cast<detail::eventual_core>(result.m_state);
+    return detail::when_all_cores(std::move(cores), std::move(result), std::move(result_core));
+}
+
+/**
+ * @brief Returns an eventual that is set with the index of the first
+ * of the provided eventuals to be set (which may hold an exception).
+ * The vector must not be empty.
+ */
+template <typename T>
+eventual<std::size_t> when_any(std::vector<eventual<T>>& evs) {
+    if(evs.empty())
+        throw eventual_exception("when_any requires at least one eventual");
+    eventual<std::size_t> result;
+    auto result_state = result.m_state;
+    for(std::size_t i = 0; i < evs.size(); i++) {
+        evs[i].state().on_ready([result_state, i]() {
+            auto s = result_state.get();
+            s->try_complete([s, i]() { s->m_value = i; });
+        });
+    }
+    return result;
+}
+
+} // namespace thallium
+
+#include <thallium/pool.hpp>
+
+namespace thallium {
+
+template <typename T>
+template <typename F>
+auto eventual<T>::then(const pool& p, F&& fn)
+-> eventual<typename std::decay<decltype(fn(std::declval<value_type&>()))>::type> {
+    using R = typename std::decay<decltype(fn(std::declval<value_type&>()))>::type;
+    state(); // throws if moved from
+    eventual<R> result;
+    auto        source = m_state;
+    auto        target = result.m_state;
+    ABT_pool    pool   = p.native_handle();
+    source->on_ready(
+        [source, target, pool, fn = std::forward<F>(fn)]() mutable {
+            detail::eventual_submit(pool, [source, target, fn = std::move(fn)]() mutable {
+                auto e = source->error();
+                if(e) target->complete([]() {}, e);
+                else detail::eventual_fulfill<R>::call(*target, fn, source->m_value);
+            });
+        });
+    return result;
+}
+
+template <typename F>
+auto eventual<void>::then(const pool& p, F&& fn)
+-> eventual<typename std::decay<decltype(fn())>::type> {
+    using R = typename std::decay<decltype(fn())>::type;
+    state(); // throws if moved from
+    eventual<R> result;
+    auto        source = m_state;
+    auto        target = result.m_state;
+    ABT_pool    pool   = p.native_handle();
+    source->on_ready(
+        [source, target, pool, fn = std::forward<F>(fn)]() mutable {
+            detail::eventual_submit(pool, [source, target, fn = std::move(fn)]() mutable {
+                auto e = source->error();
+                if(e) target->complete([]() {}, e);
+                else detail::eventual_fulfill<R>::call(*target, fn);
+            });
+        });
+    return result;
+}
+
 } // namespace thallium
 
 #undef TL_EVENTUAL_EXCEPTION
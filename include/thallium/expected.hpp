@@ -0,0 +1,119 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_EXPECTED_HPP
+#define __THALLIUM_EXPECTED_HPP
+
+#include <utility>
+#include <margo.h>
+#include <thallium/margo_exception.hpp>
+#include <thallium/timeout.hpp>
+
+namespace thallium {
+
+/**
+ * @brief An expected<T> is the result of the non-throwing variants of
+ * the operations that may fail on the network (e.g.
+ * callable_remote_procedure::try_call, async_response::try_wait,
+ * remote_bulk::try_pull_to, engine::try_lookup): either a T or the
+ * Mercury error code (HG_TIMEOUT, HG_BUSY, HG_CANCELED...) the
+ * throwing variant would have turned into an exception.
+ *
+ * \code{.cpp}
+ * auto r = rpc.on(ep).try_timed(std::chrono::milliseconds(100), key);
+ * if(!r) {
+ *     if(r.error() == HG_TIMEOUT) mark_down(ep);
+ *     return;
+ * }
+ * std::string value = r->as<std::string>();
+ * \endcode
+ *
+ * @tparam T Type of the value, default-constructible.
+ */
+template <typename T> class expected {
+
+    T           m_value;
+    hg_return_t m_error = HG_SUCCESS;
+
+  public:
+
+    /**
+     * @brief Constructs a successful result.
+     */
+    expected(T value)
+    : m_value(std::move(value)) {}
+
+    /**
+     * @brief Returns a failed result with the provided error code,
+     * which must not be HG_SUCCESS.
+     */
+    static expected failure(hg_return_t error) {
+        expected r{T()};
+        r.m_error = error;
+        return r;
+    }
+
+    expected(expected&&)            = default;
+    expected& operator=(expected&&) = default;
+
+    /**
+     * @brief Returns true if the operation succeeded.
+     */
+    bool has_value() const noexcept {
+        return m_error == HG_SUCCESS;
+    }
+
+    explicit operator bool() const noexcept {
+        return has_value();
+    }
+
+    /**
+     * @brief Returns the error code, HG_SUCCESS if the operation succeeded.
+     */
+    hg_return_t error() const noexcept {
+        return m_error;
+    }
+
+    /**
+     * @brief Returns the value, or throws tl::timeout (HG_TIMEOUT) or a
+     * margo_exception carrying the error code if the operation failed.
+     */
+    T& value() & {
+        check();
+        return m_value;
+    }
+
+    const T& value() const& {
+        check();
+        return m_value;
+    }
+
+    T&& value() && {
+        check();
+        return std::move(m_value);
+    }
+
+    T* operator->() { return &m_value; }
+
+    const T* operator->() const { return &m_value; }
+
+    T& operator*() & { return m_value; }
+
+    const T& operator*() const& { return m_value; }
+
+    T&& operator*() && { return std::move(m_value); }
+
+  private:
+
+    void check() const {
+        if(m_error == HG_SUCCESS) return;
+        if(m_error == HG_TIMEOUT) throw timeout();
+        MARGO_THROW(expected::value, m_error, translate_margo_error_code(m_error));
+    }
+};
+
+} // namespace thallium
+
+#endif
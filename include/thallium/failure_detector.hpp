@@ -0,0 +1,360 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_FAILURE_DETECTOR_HPP
+#define __THALLIUM_FAILURE_DETECTOR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/async_response.hpp>
+#include <thallium/endpoint.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/peer_monitor.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/request.hpp>
+#include <thallium/timed_callback.hpp>
+
+namespace thallium {
+
+/**
+ * @brief A failure_detector watches a set of peers and declares them
+ * failed when they have been silent for too long, so that failures
+ * are noticed within a bound much shorter than RPC timeouts.
+ *
+ * Any response received from a watched peer (to an RPC sent with
+ * async() or iforward()) counts as a heartbeat, so peers that are busy
+ * serving the application's RPCs are not sent anything else. A peer
+ * heard of less recently than interval_ms is sent a heartbeat RPC; the
+ * heartbeats of all such peers are sent together at each tick, without
+ * waiting for the previous ones. The time between heartbeats is used
+ * as in a phi-accrual detector: a peer is declared failed when the
+ * suspicion level phi = -log10(P(silence >= t)), computed from the
+ * mean and standard deviation of the last inter-arrival times, exceeds
+ * phi_threshold, and in any case once it has been silent for
+ * max_silence_ms.
+ *
+ * When a peer is declared failed, the RPCs in flight to it are
+ * cancelled, and waiting for their async_response throws
+ * tl::peer_failure (as do RPCs sent to it later), its address is
+ * removed from Mercury's peer list (see endpoint::set_remove) and from
+ * the engine's address caches, and the on_failure callbacks are called.
+ *
+ * \code{.cpp}
+ * tl::failure_detector::options opts;
+ * opts.max_silence_ms = 500;
+ * tl::failure_detector detector(engine, opts);
+ * detector.on_failure([](const std::string& address) {
+ *     std::cerr << address << " failed" << std::endl;
+ * });
+ * detector.watch(server);
+ * \endcode
+ *
+ * Watched processes answer heartbeats with their own failure_detector,
+ * which may watch no peer. An engine has at most one failure_detector,
+ * which stops when the engine is finalized or when it is destroyed,
+ * whichever comes first. A peer declared failed stays so until it is
+ * unwatched.
+ */
+class failure_detector {
+
+  public:
+
+    /**
+     * @brief Parameters of a failure_detector.
+     */
+    struct options {
+        double      interval_ms    = 100.0;  /*!< silence after which a peer is sent a heartbeat */
+        double      phi_threshold  = 8.0;    /*!< suspicion level at which a peer is failed */
+        double      max_silence_ms = 1000.0; /*!< silence after which a peer is failed anyway */
+        std::size_t window         = 64;     /*!< inter-arrival times kept per peer */
+    };
+
+    /**
+     * @brief Constructor. Defines the heartbeat RPC and starts
+     * watching (no peer initially).
+     *
+     * @param e Engine whose progress loop runs the detector.
+     * @param opts Options.
+     */
+    failure_detector(const engine& e, options opts)
+    : m_mid(e.get_margo_instance())
+    , m_opts(opts)
+    , m_monitor(std::make_shared<detail::peer_monitor>(m_mid)) {
+        if(m_opts.interval_ms <= 0.0)
+            throw exception("failure_detector: interval_ms must be positive");
+        if(m_opts.max_silence_ms < m_opts.interval_ms)
+            m_opts.max_silence_ms = m_opts.interval_ms;
+        if(m_opts.window < 2) m_opts.window = 2;
+        if(!detail::peer_monitor::try_install(m_mid, m_monitor))
+            throw exception("failure_detector: engine already has a failure_detector");
+        engine eng(m_mid);
+        m_heartbeat = std::make_unique<remote_procedure>(
+            eng.define("__thallium_heartbeat__", [](const request& req) { req.respond(); }));
+        m_timer = std::make_unique<timed_callback>(
+            eng.create_timed_callback([this]() { tick(); }));
+        m_running = true;
+        m_timer->start(tick_ms());
+        margo_provider_push_prefinalize_callback(
+            m_mid, this, &failure_detector::on_finalize, this);
+    }
+
+    /**
+     * @brief Constructor with the default options.
+     */
+    explicit failure_detector(const engine& e)
+    : failure_detector(e, options()) {}
+
+    failure_detector(const failure_detector&)            = delete;
+    failure_detector& operator=(const failure_detector&) = delete;
+
+    ~failure_detector() {
+        if(stop()) margo_provider_pop_prefinalize_callback(m_mid, this);
+    }
+
+    /**
+     * @brief Starts watching a peer. Watching it again has no effect.
+     */
+    void watch(const endpoint& ep) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_running) throw exception("failure_detector: detector is stopped");
+        if(find(ep) != m_peers.end()) return;
+        auto state           = std::make_shared<detail::peer_state>();
+        state->addr          = ep.get_addr(true);
+        state->address       = static_cast<std::string>(ep);
+        state->last_heard_ns = detail::peer_monitor::now_ns();
+        m_peers.push_back(std::make_unique<watched>(ep, state));
+        m_peers.back()->last_heard_ns = state->last_heard_ns;
+        m_monitor->add(std::move(state));
+    }
+
+    /**
+     * @brief Stops watching a peer. RPCs in flight to it are not failed
+     * anymore if it was not declared failed yet.
+     */
+    void unwatch(const endpoint& ep) {
+        std::unique_ptr<watched> w;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = find(ep);
+            if(it == m_peers.end()) return;
+            w = std::move(*it);
+            m_peers.erase(it);
+            m_monitor->remove(w->state);
+        }
+        release(*w);
+    }
+
+    /**
+     * @brief Adds a function called with the address of each peer
+     * declared failed. It is called from the progress loop and should
+     * not block.
+     */
+    void on_failure(std::function<void(const std::string&)> callback) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_callbacks.push_back(std::move(callback));
+    }
+
+    /**
+     * @brief Returns false if the peer was declared failed, true
+     * otherwise (including if it is not watched).
+     */
+    bool is_alive(const endpoint& ep) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = find(ep);
+        return it == m_peers.end() || !(*it)->state->dead;
+    }
+
+    /**
+     * @brief Returns the current suspicion level of a peer (0 if it is
+     * not watched, infinity if it was declared failed).
+     */
+    double phi(const endpoint& ep) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = find(ep);
+        if(it == m_peers.end()) return 0.0;
+        if((*it)->state->dead) return std::numeric_limits<double>::infinity();
+        return phi(**it, detail::peer_monitor::now_ns());
+    }
+
+  private:
+
+    struct watched {
+        endpoint                            ep;
+        std::shared_ptr<detail::peer_state> state;
+        std::int64_t                        last_heard_ns = 0;
+        std::deque<double>                  intervals; // in ms
+        double                              sum   = 0.0;
+        double                              sumsq = 0.0;
+        std::unique_ptr<async_response>     ping;
+
+        watched(endpoint e, std::shared_ptr<detail::peer_state> s)
+        : ep(std::move(e))
+        , state(std::move(s)) {}
+    };
+
+    margo_instance_id                                    m_mid;
+    options                                              m_opts;
+    std::shared_ptr<detail::peer_monitor>                m_monitor;
+    std::unique_ptr<remote_procedure>                    m_heartbeat;
+    std::unique_ptr<timed_callback>                      m_timer;
+    mutable std::mutex                                   m_mutex;
+    bool                                                 m_running = false;
+    std::vector<std::unique_ptr<watched>>                m_peers;
+    std::vector<std::function<void(const std::string&)>> m_callbacks;
+
+    double tick_ms() const {
+        return std::min(m_opts.interval_ms, m_opts.max_silence_ms) / 4.0;
+    }
+
+    std::vector<std::unique_ptr<watched>>::const_iterator find(const endpoint& ep) const {
+        return std::find_if(m_peers.begin(), m_peers.end(), [&ep](const std::unique_ptr<watched>& w) {
+            return margo_addr_cmp(w->ep.get_margo_instance(), w->ep.get_addr(), ep.get_addr());
+        });
+    }
+
+    std::vector<std::unique_ptr<watched>>::iterator find(const endpoint& ep) {
+        return std::find_if(m_peers.begin(), m_peers.end(), [&ep](const std::unique_ptr<watched>& w) {
+            return margo_addr_cmp(w->ep.get_margo_instance(), w->ep.get_addr(), ep.get_addr());
+        });
+    }
+
+    void release(watched& w) {
+        if(w.ping) w.ping->cancel();
+        w.ping.reset();
+        margo_addr_free(m_mid, w.state->addr);
+        w.state->addr = HG_ADDR_NULL;
+    }
+
+    // accounts for the heartbeats received since the last tick
+    void sample(watched& w) {
+        std::int64_t heard = w.state->last_heard_ns;
+        if(heard <= w.last_heard_ns) return;
+        double interval = (heard - w.last_heard_ns) / 1e6;
+        w.last_heard_ns = heard;
+        w.intervals.push_back(interval);
+        w.sum   += interval;
+        w.sumsq += interval * interval;
+        if(w.intervals.size() > m_opts.window) {
+            double oldest = w.intervals.front();
+            w.intervals.pop_front();
+            w.sum   -= oldest;
+            w.sumsq -= oldest * oldest;
+        }
+    }
+
+    // Peers busy with the application's traffic are heard of much more
+    // often than interval_ms, but fall back to heartbeats when that
+    // traffic stops, so the mean and standard deviation are floored to
+    // those of heartbeats to avoid failing a peer that merely went idle.
+    double phi(const watched& w, std::int64_t now) const {
+        double silence = (now - w.last_heard_ns) / 1e6;
+        double mean    = m_opts.interval_ms;
+        double stddev  = m_opts.interval_ms / 4.0;
+        std::size_t n  = w.intervals.size();
+        if(n > 0) {
+            double m = w.sum / n;
+            double v = std::max(w.sumsq / n - m * m, 0.0);
+            mean     = std::max(mean, m);
+            stddev   = std::max(stddev, std::sqrt(v));
+        }
+        double p = 0.5 * std::erfc((silence - mean) / (stddev * std::sqrt(2.0)));
+        if(p <= 0.0) return std::numeric_limits<double>::infinity();
+        return -std::log10(p);
+    }
+
+    void fail(watched& w, std::vector<std::string>& failed) {
+        detail::peer_monitor::fail(*w.state);
+        w.ping.reset();
+        try {
+            w.ep.set_remove();
+        } catch(const margo_exception&) {}
+        engine(m_mid).invalidate_address(w.state->address);
+        failed.push_back(w.state->address);
+    }
+
+    void tick() {
+        std::vector<std::string>                             failed;
+        std::vector<std::function<void(const std::string&)>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_running) return;
+            auto now = detail::peer_monitor::now_ns();
+            for(auto& w : m_peers) {
+                if(w->state->dead) continue;
+                // a completed heartbeat updates last_heard_ns when waited on
+                if(w->ping && w->ping->received()) {
+                    w->ping->try_wait();
+                    w->ping.reset();
+                }
+                sample(*w);
+                double silence = (now - w->last_heard_ns) / 1e6;
+                if(silence >= m_opts.max_silence_ms || phi(*w, now) >= m_opts.phi_threshold) {
+                    fail(*w, failed);
+                    continue;
+                }
+                if(!w->ping && silence >= m_opts.interval_ms) {
+                    try {
+                        w->ping = std::make_unique<async_response>(
+                            m_heartbeat->on(w->ep).timed_async(
+                                std::chrono::duration<double, std::milli>(m_opts.max_silence_ms)));
+                    } catch(const std::exception&) {
+                        // sent again at the next tick
+                    }
+                }
+            }
+            if(!failed.empty()) callbacks = m_callbacks;
+            m_timer->start(tick_ms());
+        }
+        for(auto& address : failed)
+            for(auto& callback : callbacks) callback(address);
+    }
+
+    // stops watching; returns false if the detector was already stopped
+    bool stop() {
+        std::vector<std::unique_ptr<watched>> peers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_running) return false;
+            m_running = false;
+            peers     = std::move(m_peers);
+            m_peers.clear();
+        }
+        try {
+            m_timer->cancel();
+        } catch(const exception&) {
+            // the callback was running and won't start the timer again
+        }
+        m_timer.reset();
+        detail::peer_monitor::uninstall_if(m_mid, m_monitor.get());
+        for(auto& w : peers) {
+            m_monitor->remove(w->state);
+            release(*w);
+        }
+        m_heartbeat->deregister();
+        m_heartbeat.reset();
+        return true;
+    }
+
+    static void on_finalize(void* arg) {
+        static_cast<failure_detector*>(arg)->stop();
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,455 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_FLOW_CONTROL_HPP
+#define __THALLIUM_FLOW_CONTROL_HPP
+
+#include <abt.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <margo.h>
+#include <mercury_proc.h>
+#include <thallium/cancellation.hpp>
+#include <thallium/condition_variable.hpp>
+#include <thallium/margo_exception.hpp>
+#include <thallium/mutex.hpp>
+#include <thallium/proc_object.hpp>
+
+namespace thallium {
+
+/**
+ * @brief A retry_policy tells a callable_remote_procedure (or the
+ * async_response it returns) whether to send an RPC again when it
+ * fails with tl::busy or tl::timeout, and how long to wait before
+ * doing so. The wait is a randomized exponential backoff (between 0
+ * and min(max_backoff_ms, initial_backoff_ms * multiplier^(n-1))
+ * before the n-th retry), so that clients rejected together do not
+ * come back together.
+ *
+ * A busy response means the handler did not run, so it is always
+ * safe to retry. A timeout does not tell whether the handler ran:
+ * timed out RPCs are retried only if the policy is marked idempotent.
+ *
+ * \code{.cpp}
+ * auto policy = tl::retry_policy{}.attempts(5).backoff(1.0, 500.0).idempotent();
+ * auto resp = rpc.on(ep).with_retry(policy).async(key);
+ * \endcode
+ */
+struct retry_policy {
+
+    unsigned max_attempts       = 1;      /*!< total number of sends (1: no retry) */
+    double   initial_backoff_ms = 1.0;    /*!< backoff bound before the first retry */
+    double   max_backoff_ms     = 1000.0; /*!< upper bound of the backoff */
+    double   multiplier         = 2.0;    /*!< growth of the bound at each retry */
+    bool     is_idempotent      = false;  /*!< whether timed out RPCs can be retried */
+    bool     retry_on_busy      = true;   /*!< whether busy responses are retried */
+
+    /**
+     * @brief Sets the total number of sends.
+     */
+    retry_policy& attempts(unsigned n) {
+        max_attempts = n;
+        return *this;
+    }
+
+    /**
+     * @brief Sets the initial and maximum backoff, in milliseconds.
+     */
+    retry_policy& backoff(double initial_ms, double max_ms, double mult = 2.0) {
+        initial_backoff_ms = initial_ms;
+        max_backoff_ms     = max_ms;
+        multiplier         = mult;
+        return *this;
+    }
+
+    /**
+     * @brief Marks the RPC as idempotent, allowing timed out
+     * RPCs to be sent again.
+     */
+    retry_policy& idempotent(bool b = true) {
+        is_idempotent = b;
+        return *this;
+    }
+
+    /**
+     * @brief Returns whether the attempt-th send (starting at 1) of an
+     * RPC that failed with a timeout (or a busy response) can be
+     * followed by another one.
+     */
+    bool should_retry(unsigned attempt, bool timed_out) const {
+        if(attempt >= max_attempts) return false;
+        return timed_out ? is_idempotent : retry_on_busy;
+    }
+
+    /**
+     * @brief Returns the time, in milliseconds, to wait after the
+     * attempt-th send (starting at 1) before sending again.
+     */
+    double backoff_ms(unsigned attempt) const {
+        double bound = initial_backoff_ms * std::pow(multiplier, attempt - 1.0);
+        bound        = std::min(bound, max_backoff_ms);
+        if(bound <= 0.0) return 0.0;
+        static thread_local std::minstd_rand rng(std::random_device{}());
+        return std::uniform_real_distribution<double>(0.0, bound)(rng);
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Outcome of an RPC, as seen by an aimd_window.
+ */
+enum class flow_outcome {
+    success,    /*!< a response was received */
+    overloaded, /*!< busy response or timeout */
+    failed      /*!< any other error, not counted */
+};
+
+/**
+ * @private
+ * @brief Congestion window of an endpoint. Senders wait (yielding
+ * their ULT) while the number of RPCs in flight is at the limit. The
+ * limit grows by one every limit successful RPCs, and is multiplied by
+ * the backoff ratio (at most once per round-trip time) when an RPC
+ * gets a busy response, times out, or takes more than the latency
+ * tolerance times the lowest round-trip time seen so far.
+ */
+class aimd_window {
+
+    mutex              m_mutex;
+    condition_variable m_cv;
+    double             m_limit;
+    double             m_min_limit;
+    double             m_max_limit;
+    double             m_tolerance;
+    double             m_ratio;
+    std::size_t        m_in_flight     = 0;
+    double             m_min_rtt       = 0.0;
+    double             m_last_decrease = 0.0;
+
+    void decrease(double now) {
+        if(now - m_last_decrease < m_min_rtt) return;
+        m_limit         = std::max(m_min_limit, m_limit * m_ratio);
+        m_last_decrease = now;
+    }
+
+  public:
+
+    aimd_window(double initial, double min, double max, double tolerance, double ratio)
+    : m_limit(initial)
+    , m_min_limit(min)
+    , m_max_limit(max)
+    , m_tolerance(tolerance)
+    , m_ratio(ratio) {}
+
+    /**
+     * @brief Waits for a slot and returns the time it was acquired at.
+     */
+    double acquire() {
+        std::unique_lock<mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() {
+            return m_in_flight < static_cast<std::size_t>(m_limit);
+        });
+        ++m_in_flight;
+        return ABT_get_wtime();
+    }
+
+    /**
+     * @brief Releases a slot acquired at the provided time.
+     */
+    void release(double start, flow_outcome outcome) {
+        double now = ABT_get_wtime();
+        double rtt = now - start;
+        {
+            std::lock_guard<mutex> lock(m_mutex);
+            --m_in_flight;
+            if(outcome == flow_outcome::success) {
+                // the baseline slowly drifts up so that it follows
+                // lasting changes of the network
+                if(m_min_rtt == 0.0 || rtt < m_min_rtt) m_min_rtt = rtt;
+                else m_min_rtt += (rtt - m_min_rtt) * 0.01;
+                if(rtt > m_min_rtt * m_tolerance) decrease(now);
+                else m_limit = std::min(m_max_limit, m_limit + 1.0 / m_limit);
+            } else if(outcome == flow_outcome::overloaded) {
+                decrease(now);
+            }
+        }
+        m_cv.notify_all();
+    }
+
+    std::size_t limit() {
+        std::lock_guard<mutex> lock(m_mutex);
+        return static_cast<std::size_t>(m_limit);
+    }
+
+    std::size_t in_flight() {
+        std::lock_guard<mutex> lock(m_mutex);
+        return m_in_flight;
+    }
+};
+
+/**
+ * @private
+ * @brief Windows of a concurrency_limiter, by endpoint address.
+ */
+struct limiter_state {
+
+    double initial_limit;
+    double min_limit;
+    double max_limit;
+    double tolerance;
+    double ratio;
+
+    std::mutex                                                    mtx;
+    std::unordered_map<std::string, std::shared_ptr<aimd_window>> windows;
+
+    std::shared_ptr<aimd_window> window(const std::string& address) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto& w = windows[address];
+        if(!w)
+            w = std::make_shared<aimd_window>(initial_limit, min_limit, max_limit,
+                                              tolerance, ratio);
+        return w;
+    }
+
+    std::shared_ptr<aimd_window> window(margo_instance_id mid, hg_addr_t addr) {
+        hg_size_t size = 0;
+        auto      ret  = margo_addr_to_string(mid, nullptr, &size, addr);
+        MARGO_ASSERT(ret, margo_addr_to_string);
+        std::vector<char> buf(size);
+        ret = margo_addr_to_string(mid, buf.data(), &size, addr);
+        MARGO_ASSERT(ret, margo_addr_to_string);
+        return window(std::string{buf.data()});
+    }
+};
+
+/**
+ * @private
+ * @brief Slot of an aimd_window held by an RPC being sent.
+ */
+class flow_slot {
+
+    std::shared_ptr<aimd_window> m_window;
+    double                       m_start = 0.0;
+
+  public:
+
+    flow_slot() = default;
+
+    explicit flow_slot(std::shared_ptr<aimd_window> w) { acquire(std::move(w)); }
+
+    flow_slot(const flow_slot&) = delete;
+    flow_slot& operator=(const flow_slot&) = delete;
+
+    void acquire(std::shared_ptr<aimd_window> w) {
+        release(flow_outcome::failed);
+        m_window = std::move(w);
+        if(m_window) m_start = m_window->acquire();
+    }
+
+    void release(flow_outcome outcome) {
+        if(!m_window) return;
+        m_window->release(m_start, outcome);
+        m_window.reset();
+    }
+
+    ~flow_slot() { release(flow_outcome::failed); }
+};
+
+/**
+ * @private
+ * @brief Encodes a payload with the provided proc callback into a
+ * buffer that can be sent again with payload_proc.
+ */
+inline std::vector<char> encode_payload(margo_instance_id mid, meta_proc_fn& mproc,
+                                        std::size_t size_hint) {
+    std::vector<char> buf(std::max<std::size_t>(size_hint, 64));
+    while(true) {
+        hg_proc_t   proc = HG_PROC_NULL;
+        hg_return_t ret  = hg_proc_create_set(margo_get_class(mid), buf.data(), buf.size(),
+                                              HG_ENCODE, HG_NOHASH, &proc);
+        MARGO_ASSERT(ret, hg_proc_create_set);
+        ret              = mproc(proc);
+        std::size_t used = hg_proc_get_size_used(proc);
+        hg_proc_free(proc);
+        MARGO_ASSERT(ret, proc_object_encode);
+        if(used <= buf.size()) {
+            buf.resize(used);
+            return buf;
+        }
+        // the hint was too small and the end went to the extra buffer
+        buf.assign(used, 0);
+    }
+}
+
+/**
+ * @private
+ * @brief State of an RPC sent with async() under a concurrency_limiter
+ * or a retry_policy, kept by its async_response. The encoded arguments
+ * are kept when the RPC may be sent again, since the arguments
+ * themselves are gone by the time the response is waited on.
+ */
+struct flow_call {
+
+    margo_instance_id            mid = MARGO_INSTANCE_NULL;
+    std::shared_ptr<aimd_window> window;
+    flow_slot                    slot;
+    retry_policy                 retry;
+    bool                         has_payload = false;
+    std::vector<char>            payload;
+    std::uint16_t                provider_id = 0;
+    double                       timeout_ms  = -1.0;
+    unsigned                     attempt     = 1;
+    // whether the payload ends with a detail::rpc_control
+    bool                         has_control = false;
+
+    hg_return_t forward(hg_handle_t handle, margo_request* req, meta_proc_fn* mproc = nullptr) {
+        meta_proc_fn pproc = [this](hg_proc_t proc) {
+            if(hg_proc_get_op(proc) != HG_ENCODE || payload.empty()) return HG_SUCCESS;
+            return hg_proc_memcpy(proc, payload.data(), payload.size());
+        };
+        if(!mproc) mproc = &pproc;
+        if(timeout_ms > 0.0)
+            return margo_provider_iforward_timed(provider_id, handle, mproc, timeout_ms, req);
+        return margo_provider_iforward(provider_id, handle, mproc, req);
+    }
+
+    /**
+     * @brief Waits for a slot and sends the RPC for the first time,
+     * keeping its encoded arguments if it may be sent again.
+     */
+    hg_return_t send(hg_handle_t handle, margo_request* req, meta_proc_fn& mproc,
+                     std::size_t size_hint) {
+        slot.acquire(window);
+        if(retry.max_attempts > 1) {
+            payload     = encode_payload(mid, mproc, size_hint);
+            has_payload = true;
+            return forward(handle, req);
+        }
+        return forward(handle, req, &mproc);
+    }
+
+    /**
+     * @brief Called when the RPC completed with the provided return
+     * code. Releases its slot and, if the policy allows it, waits for
+     * the backoff and sends the RPC again, in which case req is set to
+     * the new request and true is returned. If the RPC cannot be sent
+     * again, ret is set to the error and false is returned.
+     */
+    bool completed(hg_return_t& ret, bool busy, hg_handle_t handle, margo_request* req) {
+        bool overloaded = ret == HG_TIMEOUT || (ret == HG_SUCCESS && busy);
+        slot.release(overloaded ? flow_outcome::overloaded
+                     : ret == HG_SUCCESS ? flow_outcome::success : flow_outcome::failed);
+        if(!overloaded || !has_payload || !retry.should_retry(attempt, ret == HG_TIMEOUT))
+            return false;
+        double ms = retry.backoff_ms(attempt);
+        if(ms > 0.0) margo_thread_sleep(mid, ms);
+        attempt += 1;
+        slot.acquire(window);
+        // each attempt gets its own deadline
+        if(has_control && payload.size() >= sizeof(rpc_control)) {
+            std::uint64_t deadline = rpc_deadline_after(timeout_ms);
+            std::memcpy(payload.data() + payload.size() - sizeof(rpc_control)
+                        + offsetof(rpc_control, deadline), &deadline, sizeof(deadline));
+        }
+        hg_return_t r = forward(handle, req);
+        if(r == HG_SUCCESS) return true;
+        slot.release(flow_outcome::failed);
+        ret = r;
+        return false;
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief A concurrency_limiter bounds the number of RPCs a client has
+ * in flight to each endpoint, with a window that adapts to the load of
+ * the server: it grows additively while responses come back quickly,
+ * and shrinks multiplicatively when the server answers with a busy
+ * status (see admission_limit), RPCs time out, or the round-trip time
+ * grows beyond latency_tolerance times its lowest value. When the
+ * window is full, sending an RPC (including with async()) blocks the
+ * calling ULT until a response frees a slot.
+ *
+ * Copies of a concurrency_limiter share their windows.
+ *
+ * \code{.cpp}
+ * tl::concurrency_limiter limiter;
+ * tl::provider_handle ph(engine.lookup(addr), 1);
+ * ph.set_concurrency_limiter(limiter);
+ * for(auto& key : keys) responses.push_back(get.on(ph).async(key));
+ * \endcode
+ */
+class concurrency_limiter {
+
+    friend class provider_handle;
+    template<typename ... CtxArg> friend class callable_remote_procedure_with_context;
+
+    std::shared_ptr<detail::limiter_state> m_state;
+
+  public:
+
+    /**
+     * @brief Parameters of the windows.
+     */
+    struct options {
+        double initial_limit     = 16.0;   /*!< initial window */
+        double min_limit         = 1.0;    /*!< smallest window */
+        double max_limit         = 1024.0; /*!< largest window */
+        double latency_tolerance = 2.0;    /*!< RTT increase seen as congestion */
+        double backoff_ratio     = 0.5;    /*!< window decrease factor */
+    };
+
+    /**
+     * @brief Constructor.
+     */
+    concurrency_limiter()
+    : concurrency_limiter(options()) {}
+
+    /**
+     * @brief Constructor.
+     *
+     * @param opt Parameters of the windows.
+     */
+    explicit concurrency_limiter(const options& opt)
+    : m_state(std::make_shared<detail::limiter_state>()) {
+        m_state->initial_limit = std::max(1.0, opt.initial_limit);
+        m_state->min_limit     = std::max(1.0, opt.min_limit);
+        m_state->max_limit     = std::max(m_state->min_limit, opt.max_limit);
+        m_state->tolerance     = opt.latency_tolerance;
+        m_state->ratio         = opt.backoff_ratio;
+    }
+
+    /**
+     * @brief Returns the current window of the endpoint with the
+     * provided address.
+     */
+    std::size_t limit(const std::string& address) const {
+        return m_state->window(address)->limit();
+    }
+
+    /**
+     * @brief Returns the number of RPCs in flight to the endpoint with
+     * the provided address.
+     */
+    std::size_t in_flight(const std::string& address) const {
+        return m_state->window(address)->in_flight();
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_HANDLE_CACHE_HPP
+#define __THALLIUM_HANDLE_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/margo_exception.hpp>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Statistics reported by engine::get_handle_cache_stats().
+ */
+struct handle_cache_stats {
+    std::size_t hits   = 0; /*!< number of handles taken from the cache */
+    std::size_t misses = 0; /*!< number of handles created with margo_create */
+    std::size_t cached = 0; /*!< number of handles currently in the cache */
+
+    /**
+     * @brief Fraction of handle requests that were served by the cache.
+     */
+    double hit_rate() const {
+        auto total = hits + misses;
+        return total ? static_cast<double>(hits) / total : 0.0;
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Cache of idle hg_handle_t, indexed by (address, RPC id),
+ * attached to a margo instance by engine::enable_handle_cache().
+ * A handle is taken out of the cache while a callable_remote_procedure
+ * uses it, and put back when the last reference to it goes away.
+ */
+class handle_cache : public per_instance<handle_cache> {
+
+    struct key_hash {
+        std::size_t operator()(const std::pair<hg_addr_t, hg_id_t>& k) const {
+            return std::hash<void*>()(static_cast<void*>(k.first))
+                ^ (std::hash<hg_id_t>()(k.second) << 1);
+        }
+    };
+
+    using key_type = std::pair<hg_addr_t, hg_id_t>;
+
+    margo_instance_id        m_mid;
+    std::size_t              m_max_handles;
+    std::size_t              m_num_cached = 0;
+    bool                     m_closed     = false;
+    std::atomic<std::size_t> m_hits{0};
+    std::atomic<std::size_t> m_misses{0};
+    mutable std::mutex       m_mutex;
+    std::unordered_map<key_type, std::vector<hg_handle_t>, key_hash> m_handles;
+
+  public:
+
+    handle_cache(margo_instance_id mid, std::size_t max_handles)
+    : m_mid(mid)
+    , m_max_handles(max_handles) {}
+
+    handle_cache(const handle_cache&)            = delete;
+    handle_cache& operator=(const handle_cache&) = delete;
+
+    ~handle_cache() {
+        clear();
+    }
+
+    /**
+     * @brief Returns an idle handle for the given address and RPC id,
+     * creating one if the cache doesn't have any.
+     */
+    hg_handle_t acquire(hg_addr_t addr, hg_id_t id) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_handles.find(key_type{addr, id});
+            if(it != m_handles.end() && !it->second.empty()) {
+                hg_handle_t h = it->second.back();
+                it->second.pop_back();
+                m_num_cached -= 1;
+                m_hits += 1;
+                return h;
+            }
+        }
+        m_misses += 1;
+        hg_handle_t h   = HG_HANDLE_NULL;
+        hg_return_t ret = margo_create(m_mid, addr, id, &h);
+        MARGO_ASSERT(ret, margo_create);
+        return h;
+    }
+
+    /**
+     * @brief Gives a handle back to the cache. The caller must hold
+     * the only reference to the handle. Returns false if the cache is
+     * full, in which case the caller remains responsible for the handle.
+     */
+    bool release(hg_addr_t addr, hg_id_t id, hg_handle_t h) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_closed || m_num_cached >= m_max_handles) return false;
+        m_handles[key_type{addr, id}].push_back(h);
+        m_num_cached += 1;
+        return true;
+    }
+
+    /**
+     * @brief Destroys all the handles held by the cache. If close is true,
+     * the cache will refuse any handle released after this call.
+     */
+    void clear(bool close = false) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = m_closed || close;
+        for(auto& p : m_handles) {
+            for(auto h : p.second) margo_destroy(h);
+        }
+        m_handles.clear();
+        m_num_cached = 0;
+    }
+
+    handle_cache_stats stats() const {
+        handle_cache_stats s;
+        s.hits   = m_hits.load();
+        s.misses = m_misses.load();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        s.cached = m_num_cached;
+        return s;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,189 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_HEDGED_HPP
+#define __THALLIUM_HEDGED_HPP
+
+#include <abt.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <margo.h>
+#include <thallium/async_response.hpp>
+#include <thallium/condition_variable.hpp>
+#include <thallium/eventual.hpp>
+#include <thallium/mutex.hpp>
+#include <thallium/packed_data.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/rpc_stats.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Parameters of remote_procedure::hedged.
+ *
+ * The hedge delay is the given percentile of the round-trip times
+ * recorded for the RPC and its first replica's provider id, when RPC
+ * statistics are enabled (see engine::enable_rpc_stats) and at least
+ * min_samples round trips have been recorded, and delay_ms otherwise.
+ */
+struct hedge_policy {
+    double      percentile   = 95.0; /*!< percentile of the round-trip time to wait for */
+    double      delay_ms     = 10.0; /*!< delay used without enough statistics */
+    double      min_delay_ms = 0.05; /*!< lower bound of the delay */
+    std::size_t min_samples  = 100;  /*!< samples needed to use the statistics */
+    std::size_t max_hedges   = 1;    /*!< number of replicas tried after the first */
+};
+
+namespace detail {
+
+inline std::uint16_t hedge_provider_id(const endpoint&) { return 0; }
+inline std::uint16_t hedge_provider_id(const provider_handle& ph) { return ph.provider_id(); }
+
+/**
+ * @private
+ * @brief Returns the hedge delay of an RPC, in milliseconds.
+ */
+inline double hedge_delay_ms(margo_instance_id mid, hg_id_t id, std::uint16_t provider_id,
+                             const hedge_policy& policy) {
+    auto reg = rpc_stats_registry::any_enabled() ? rpc_stats_registry::find(mid) : nullptr;
+    if(reg && reg->enabled()) {
+        auto h = reg->client(id, provider_id)->snapshot().round_trip;
+        if(h.count >= policy.min_samples && h.count > 0)
+            return std::max(policy.min_delay_ms, h.percentile(policy.percentile) / 1e6);
+    }
+    return std::max(policy.min_delay_ms, policy.delay_ms);
+}
+
+/**
+ * @private
+ * @brief Returns the pool of the calling ULT, or the handler pool of
+ * the margo instance if it cannot be found.
+ */
+inline ABT_pool hedge_pool(margo_instance_id mid) {
+    ABT_thread self = ABT_THREAD_NULL;
+    ABT_pool   pool = ABT_POOL_NULL;
+    if(ABT_self_get_thread(&self) == ABT_SUCCESS
+    && ABT_thread_get_last_pool(self, &pool) == ABT_SUCCESS && pool != ABT_POOL_NULL)
+        return pool;
+    margo_get_handler_pool(mid, &pool);
+    return pool;
+}
+
+/**
+ * @private
+ * @brief State shared by a hedged call and the ULTs waiting for the
+ * responses of its replicas. The first response received wins; the
+ * ULTs waiting for the others keep the state alive until they are done.
+ */
+struct hedge_state {
+
+    mutex                          mtx;
+    condition_variable             cv;
+    std::unique_ptr<packed_data<>> result;
+    std::exception_ptr             error;
+    std::size_t                    failed = 0;
+    // responses still being waited for, cancelled once one arrived
+    std::vector<async_response*>   pending;
+
+    static void wait_for(const std::shared_ptr<hedge_state>& state, ABT_pool pool,
+                         async_response&& response) {
+        eventual_submit(pool, [state, response = std::move(response)]() mutable {
+            {
+                std::lock_guard<mutex> lock(state->mtx);
+                if(state->result) response.cancel();
+                else state->pending.push_back(&response);
+            }
+            std::unique_ptr<packed_data<>> data;
+            std::exception_ptr             err;
+            try {
+                data = std::make_unique<packed_data<>>(response.wait());
+            } catch(...) {
+                err = std::current_exception();
+            }
+            {
+                std::lock_guard<mutex> lock(state->mtx);
+                auto& p = state->pending;
+                p.erase(std::remove(p.begin(), p.end(), &response), p.end());
+                if(err) {
+                    state->failed += 1;
+                    state->error = err;
+                } else if(!state->result) {
+                    state->result = std::move(data);
+                }
+            }
+            state->cv.notify_all();
+        }, true);
+    }
+};
+
+inline struct timespec hedge_deadline(double delay_ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    auto ns  = static_cast<long long>(delay_ms * 1e6) + ts.tv_nsec;
+    ts.tv_sec += static_cast<time_t>(ns / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000LL);
+    return ts;
+}
+
+} // namespace detail
+
+template <typename Target, typename... T>
+packed_data<> remote_procedure::hedged(const std::vector<Target>& replicas,
+                                       const hedge_policy& policy,
+                                       const T&... args) const {
+    if(m_id == 0)
+        throw exception("remote_procedure object isn't initialized");
+    if(replicas.empty())
+        throw exception("remote_procedure::hedged called without replica");
+    if(m_ignore_response)
+        throw exception("remote_procedure::hedged requires a response");
+    auto        state    = std::make_shared<detail::hedge_state>();
+    ABT_pool    pool     = detail::hedge_pool(m_mid);
+    double      delay_ms = detail::hedge_delay_ms(
+        m_mid, m_id, detail::hedge_provider_id(replicas.front()), policy);
+    std::size_t count    = std::min(replicas.size(), policy.max_hedges + 1);
+    std::size_t sent     = 0;
+    struct timespec next_hedge;
+    auto send_next = [&]() {
+        auto response = on(replicas[sent]).async(args...);
+        sent += 1;
+        next_hedge = detail::hedge_deadline(delay_ms);
+        detail::hedge_state::wait_for(state, pool, std::move(response));
+    };
+    send_next();
+    std::unique_lock<mutex> lock(state->mtx);
+    while(!state->result) {
+        if(state->failed == sent) {
+            if(sent == count) std::rethrow_exception(state->error);
+            // every replica tried so far failed: no need to wait
+            lock.unlock();
+            send_next();
+            lock.lock();
+        } else if(sent < count) {
+            if(!state->cv.wait_until(lock, &next_hedge) && !state->result) {
+                lock.unlock();
+                send_next();
+                lock.lock();
+            }
+        } else {
+            state->cv.wait(lock);
+        }
+    }
+    // the other replicas' RPCs are cancelled, their waiting ULTs
+    // drop the responses that still arrive
+    for(auto r : state->pending) r->cancel();
+    return std::move(*state->result);
+}
+
+} // namespace thallium
+
+#endif
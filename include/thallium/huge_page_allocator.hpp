@@ -0,0 +1,277 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_HUGE_PAGE_ALLOCATOR_HPP
+#define __THALLIUM_HUGE_PAGE_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace thallium {
+
+/**
+ * @brief Size of a 2 MiB huge page.
+ */
+constexpr std::size_t huge_page_2mb = std::size_t(2) * 1024 * 1024;
+
+/**
+ * @brief Size of a 1 GiB huge page.
+ */
+constexpr std::size_t huge_page_1gb = std::size_t(1024) * 1024 * 1024;
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Mappings made by huge_page_alloc, by address, with their
+ * length and the size of the pages backing them.
+ */
+class huge_page_regions {
+
+    struct region {
+        std::size_t length;
+        std::size_t page_size;
+    };
+
+    std::mutex                        m_mutex;
+    std::unordered_map<void*, region> m_regions;
+
+  public:
+
+    static huge_page_regions& instance() {
+        static huge_page_regions* r = new huge_page_regions; // never destroyed
+        return *r;
+    }
+
+    void add(void* p, std::size_t length, std::size_t page_size) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_regions[p] = region{length, page_size};
+    }
+
+    bool remove(void* p, std::size_t& length) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_regions.find(p);
+        if(it == m_regions.end()) return false;
+        length = it->second.length;
+        m_regions.erase(it);
+        return true;
+    }
+
+    std::size_t page_size(const void* p) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_regions.find(const_cast<void*>(p));
+        return it == m_regions.end() ? 0 : it->second.page_size;
+    }
+};
+
+inline std::size_t huge_page_round_up(std::size_t size, std::size_t align) {
+    return (size + align - 1) / align * align;
+}
+
+#ifdef __linux__
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+inline void* huge_page_map_hugetlb(std::size_t length, std::size_t page_size) {
+#ifdef MAP_HUGETLB
+    int log2 = 0;
+    while((std::size_t(1) << log2) < page_size) log2++;
+    void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log2 << MAP_HUGE_SHIFT), -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#else
+    (void)length;
+    (void)page_size;
+    return nullptr;
+#endif
+}
+
+inline void* huge_page_map_reserved(std::size_t size, std::size_t page_size) {
+    if(page_size < huge_page_2mb) return nullptr;
+    std::size_t length = huge_page_round_up(size, page_size);
+    void*       p      = huge_page_map_hugetlb(length, page_size);
+    if(p) huge_page_regions::instance().add(p, length, page_size);
+    return p;
+}
+
+// maps a 2 MiB-aligned region and asks for transparent huge pages
+inline void* huge_page_map_transparent(std::size_t length) {
+    std::size_t total = length + huge_page_2mb;
+    void*       p     = mmap(nullptr, total, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED) return nullptr;
+    auto addr    = reinterpret_cast<std::uintptr_t>(p);
+    auto aligned = huge_page_round_up(addr, huge_page_2mb);
+    if(aligned > addr) munmap(p, aligned - addr);
+    std::size_t tail = total - (aligned - addr) - length;
+    if(tail) munmap(reinterpret_cast<void*>(aligned + length), tail);
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void*>(aligned), length, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<void*>(aligned);
+}
+
+#endif
+
+/**
+ * @private
+ * @brief Allocates size bytes backed by huge pages of page_size bytes
+ * (or else 2 MiB ones) if the system has them reserved, or else by
+ * transparent huge pages, or else by regular memory. Small sizes use
+ * operator new.
+ */
+inline void* huge_page_alloc(std::size_t size, std::size_t page_size) {
+#ifdef __linux__
+    if(size >= huge_page_2mb / 2) {
+        if(void* p = huge_page_map_reserved(size, page_size)) return p;
+        if(page_size != huge_page_2mb)
+            if(void* p = huge_page_map_reserved(size, huge_page_2mb)) return p;
+        std::size_t length = huge_page_round_up(size, huge_page_2mb);
+        if(void* p = huge_page_map_transparent(length)) {
+            huge_page_regions::instance().add(p, length, huge_page_2mb);
+            return p;
+        }
+    }
+#else
+    (void)page_size;
+#endif
+    return ::operator new(size);
+}
+
+/**
+ * @private
+ * @brief Asks for the pages of [p, p+length) to be placed on a NUMA
+ * node when they are first touched (mbind with MPOL_PREFERRED, so that
+ * they go elsewhere if the node is full). p and length must be aligned
+ * on the size of the pages backing the range, which must not have been
+ * touched yet. Calls mbind directly rather than through libnuma.
+ *
+ * @return false if the policy could not be set.
+ */
+inline bool numa_bind(void* p, std::size_t length, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    constexpr int         mpol_preferred = 1;
+    constexpr std::size_t bits           = 8 * sizeof(unsigned long);
+    if(node < 0 || node >= 1024) return false;
+    std::vector<unsigned long> mask(1024 / bits, 0);
+    mask[node / bits] |= 1UL << (node % bits);
+    return syscall(SYS_mbind, p, length, mpol_preferred, mask.data(),
+                   mask.size() * bits + 1, 0) == 0;
+#else
+    (void)p;
+    (void)length;
+    (void)node;
+    return false;
+#endif
+}
+
+/**
+ * @private
+ * @brief Frees memory allocated by huge_page_alloc.
+ */
+inline void huge_page_free(void* p) noexcept {
+    if(!p) return;
+#ifdef __linux__
+    std::size_t length = 0;
+    if(huge_page_regions::instance().remove(p, length)) {
+        munmap(p, length);
+        return;
+    }
+#endif
+    ::operator delete(p);
+}
+
+} // namespace detail
+
+/**
+ * @brief Returns the size of the pages backing memory returned by a
+ * huge_page_allocator: PageSize or 2 MiB if the allocation was served
+ * by reserved huge pages (hugetlbfs) or transparent huge pages, 0 if
+ * it fell back to regular memory.
+ */
+inline std::size_t huge_page_size_of(const void* p) {
+    return detail::huge_page_regions::instance().page_size(p);
+}
+
+/**
+ * @brief Allocator backing large buffers with huge pages, to be used
+ * for memory exposed with engine::expose: registering memory costs
+ * per page, and the NIC's translation cache covers more memory with
+ * fewer entries, so large buffers on huge pages register faster and
+ * transfer with fewer translation misses.
+ *
+ * Allocations of at least 1 MiB are served, in order of preference, by
+ * reserved huge pages of PageSize bytes (e.g. huge_page_1gb, on Linux,
+ * see /proc/sys/vm/nr_hugepages), then by reserved 2 MiB pages, then
+ * by 2 MiB-aligned memory advised to use transparent huge pages, and
+ * smaller ones by operator new; the fallback is transparent.
+ * Allocations are rounded up to the page size, so this allocator is
+ * meant for few large buffers, e.g. a std::vector reserved upfront
+ * (see huge_page_vector); bulk_pool uses it for its region.
+ *
+ * \code{.cpp}
+ * tl::huge_page_vector<char> buffer(1ULL << 30);
+ * auto b = engine.expose({{buffer.data(), buffer.size()}}, tl::bulk_mode::read_write);
+ * \endcode
+ *
+ * @tparam T Type of the elements.
+ * @tparam PageSize Preferred page size.
+ */
+template <typename T, std::size_t PageSize = huge_page_2mb> class huge_page_allocator {
+
+  public:
+
+    using value_type = T;
+
+    template <typename U> struct rebind {
+        using other = huge_page_allocator<U, PageSize>;
+    };
+
+    huge_page_allocator() noexcept = default;
+
+    template <typename U>
+    huge_page_allocator(const huge_page_allocator<U, PageSize>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if(n > std::numeric_limits<std::size_t>::max() / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T*>(detail::huge_page_alloc(n * sizeof(T), PageSize));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept {
+        detail::huge_page_free(p);
+    }
+
+    template <typename U>
+    bool operator==(const huge_page_allocator<U, PageSize>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const huge_page_allocator<U, PageSize>&) const noexcept {
+        return false;
+    }
+};
+
+/**
+ * @brief std::vector allocated with a huge_page_allocator.
+ */
+template <typename T, std::size_t PageSize = huge_page_2mb>
+using huge_page_vector = std::vector<T, huge_page_allocator<T, PageSize>>;
+
+} // namespace thallium
+
+#endif
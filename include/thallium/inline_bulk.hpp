@@ -0,0 +1,62 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_INLINE_BULK_HPP
+#define __THALLIUM_INLINE_BULK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <margo.h>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Setting of engine::enable_inline_bulk attached to a margo
+ * instance: local bulks of at most m_threshold bytes that it serializes
+ * carry a copy of their data.
+ *
+ * Such a bulk is serialized as a 64-bit size with inline_bulk::tag set,
+ * the data, then the handle as serialized by hg_proc_hg_bulk_t. The
+ * size of a serialized handle never has this bit set, so receivers
+ * tell the two formats apart by peeking at the first 64 bits.
+ */
+class inline_bulk : public per_instance<inline_bulk> {
+
+    std::size_t m_threshold;
+
+  public:
+
+    static constexpr std::uint64_t tag = std::uint64_t(1) << 63;
+
+    explicit inline_bulk(std::size_t threshold)
+    : m_threshold(threshold) {}
+
+    std::size_t threshold() const {
+        return m_threshold;
+    }
+
+    /**
+     * @brief Returns the inlining threshold of a margo instance, 0 if
+     * inlining is disabled.
+     */
+    static std::size_t threshold(margo_instance_id mid) {
+        auto b = find(mid);
+        return b ? b->m_threshold : 0;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_INPLACE_FUNCTION_HPP
+#define __THALLIUM_INPLACE_FUNCTION_HPP
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace thallium {
+
+template <typename Signature, std::size_t Capacity = 4*sizeof(void*)>
+class inplace_function;
+
+/**
+ * @brief inplace_function is a type-erased callable similar to
+ * std::function, except that the callable is always stored inside the
+ * object itself, in a buffer of Capacity bytes. It never allocates memory;
+ * trying to store a callable that does not fit in the buffer fails
+ * at compile time.
+ *
+ * @tparam R Return type.
+ * @tparam Args Argument types.
+ * @tparam Capacity Size of the internal buffer, in bytes.
+ */
+template <typename R, typename... Args, std::size_t Capacity>
+class inplace_function<R(Args...), Capacity> {
+
+    struct vtable {
+        R (*invoke)(void*, Args&&...);
+        void (*copy)(void*, const void*);
+        void (*move)(void*, void*);
+        void (*destroy)(void*);
+    };
+
+    template <typename F> struct vtable_for {
+
+        static R invoke(void* f, Args&&... args) {
+            return static_cast<R>((*static_cast<F*>(f))(std::forward<Args>(args)...));
+        }
+
+        static void copy(void* dst, const void* src) {
+            new(dst) F(*static_cast<const F*>(src));
+        }
+
+        static void move(void* dst, void* src) {
+            new(dst) F(std::move(*static_cast<F*>(src)));
+            static_cast<F*>(src)->~F();
+        }
+
+        static void destroy(void* f) {
+            static_cast<F*>(f)->~F();
+        }
+
+        static const vtable* get() {
+            static const vtable vt = { &invoke, &copy, &move, &destroy };
+            return &vt;
+        }
+    };
+
+    using storage_t = typename std::aligned_storage<
+        Capacity, alignof(std::max_align_t)>::type;
+
+    const vtable*     m_vtable = nullptr;
+    mutable storage_t m_storage;
+
+  public:
+
+    /**
+     * @brief Creates an empty inplace_function.
+     */
+    inplace_function() noexcept = default;
+
+    inplace_function(std::nullptr_t) noexcept {}
+
+    /**
+     * @brief Creates an inplace_function from a callable object.
+     *
+     * @tparam F Type of the callable.
+     * @param f Callable.
+     */
+    template <typename F, typename D = typename std::decay<F>::type,
+              typename = typename std::enable_if<
+                  !std::is_same<D, inplace_function>::value>::type>
+    inplace_function(F&& f) {
+        static_assert(sizeof(D) <= Capacity,
+            "Callable too large to be stored in this inplace_function");
+        static_assert(alignof(D) <= alignof(storage_t),
+            "Callable alignment not supported by this inplace_function");
+        new(&m_storage) D(std::forward<F>(f));
+        m_vtable = vtable_for<D>::get();
+    }
+
+    /**
+     * @brief Copy constructor.
+     */
+    inplace_function(const inplace_function& other)
+    : m_vtable(other.m_vtable) {
+        if(m_vtable) m_vtable->copy(&m_storage, &other.m_storage);
+    }
+
+    /**
+     * @brief Move constructor.
+     */
+    inplace_function(inplace_function&& other)
+    : m_vtable(other.m_vtable) {
+        if(m_vtable) m_vtable->move(&m_storage, &other.m_storage);
+        other.m_vtable = nullptr;
+    }
+
+    /**
+     * @brief Copy-assignment operator.
+     */
+    inplace_function& operator=(const inplace_function& other) {
+        if(&other == this) return *this;
+        clear();
+        if(other.m_vtable) other.m_vtable->copy(&m_storage, &other.m_storage);
+        m_vtable = other.m_vtable;
+        return *this;
+    }
+
+    /**
+     * @brief Move-assignment operator.
+     */
+    inplace_function& operator=(inplace_function&& other) {
+        if(&other == this) return *this;
+        clear();
+        if(other.m_vtable) other.m_vtable->move(&m_storage, &other.m_storage);
+        m_vtable       = other.m_vtable;
+        other.m_vtable = nullptr;
+        return *this;
+    }
+
+    inplace_function& operator=(std::nullptr_t) noexcept {
+        clear();
+        return *this;
+    }
+
+    /**
+     * @brief Destructor.
+     */
+    ~inplace_function() {
+        clear();
+    }
+
+    /**
+     * @brief Calls the stored callable. Throws std::bad_function_call
+     * if the inplace_function is empty.
+     */
+    R operator()(Args... args) const {
+        if(!m_vtable) throw std::bad_function_call();
+        return m_vtable->invoke(&m_storage, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Checks whether the inplace_function holds a callable.
+     */
+    explicit operator bool() const noexcept {
+        return m_vtable != nullptr;
+    }
+
+  private:
+
+    void clear() noexcept {
+        if(m_vtable) m_vtable->destroy(&m_storage);
+        m_vtable = nullptr;
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,420 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_LARGE_HPP
+#define __THALLIUM_LARGE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cereal/cereal.hpp>
+#include <thallium/bulk.hpp>
+#include <thallium/bulk_mode.hpp>
+#include <thallium/endpoint.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/serialization/compression.hpp>
+
+namespace thallium {
+
+template <typename ... CtxArg> class size_archive;
+
+namespace detail {
+
+inline std::atomic<std::size_t>& large_threshold() {
+    static std::atomic<std::size_t> threshold{64*1024};
+    return threshold;
+}
+
+} // namespace detail
+
+/**
+ * @brief Sets the default size (in bytes) above which the content of
+ * a large<T> argument is sent by RDMA instead of being copied into
+ * the RPC's buffer. The default is 64 KiB.
+ */
+inline void set_large_threshold(std::size_t bytes) {
+    detail::large_threshold() = bytes;
+}
+
+/**
+ * @brief Returns the default threshold used by large<T>.
+ */
+inline std::size_t get_large_threshold() {
+    return detail::large_threshold();
+}
+
+/**
+ * @brief large<T> wraps a contiguous container (std::vector or
+ * std::basic_string of trivially copyable elements) passed as an RPC
+ * argument. If its content is smaller than a threshold, it is serialized
+ * into the RPC's buffer like the container would be. Otherwise the
+ * sender exposes the content with engine::expose and only a bulk
+ * handle is sent; the receiver then pulls the data by RDMA straight
+ * into the destination container before the RPC handler is called.
+ *
+ * On the client side, a large<T> can reference an existing container
+ * (no copy is made) or own one. The exposed memory stays registered
+ * until the large<T> object is destroyed, so the same object can be
+ * sent several times without registering it again. by_reference
+ * creates a large<T> that always uses RDMA.
+ *
+ * When a compression object is set with set_compression, offloaded
+ * content of at least the compression threshold is compressed into a
+ * staging buffer, which is exposed instead of the container; the
+ * receiver pulls it into its own staging buffer and decompresses it
+ * into the destination container. Compression trades CPU time for
+ * network bandwidth and is only worth it on slow links or for very
+ * compressible data. The content is compressed and exposed once per
+ * send: when the arguments are sized before being encoded, the size
+ * pass prepares them and the encoding reuses them, so the content must
+ * not change in between (e.g. between fits_eager and the call).
+ *
+ * Sending keeps the registration and the staging buffer in the large<T>
+ * object, so an object must not be sent by several RPCs at the same
+ * time, nor modified while an RPC sending it is in flight: concurrent
+ * RPCs each need their own large<T> (which may reference the same
+ * container when it is not compressed).
+ *
+ * The RDMA path is only available for top-level arguments of RPCs
+ * defined with engine::define (or provider::define); large<T> must not
+ * be used in responses or nested in other types.
+ *
+ * @tparam T Container type.
+ */
+template <typename T> class large {
+
+    using value_type = typename T::value_type;
+
+    static_assert(std::is_trivially_copyable<value_type>::value,
+                  "large<T> requires a container of trivially copyable elements");
+
+    T                 m_value;
+    T*                m_ptr       = &m_value;
+    std::size_t       m_threshold = get_large_threshold();
+    // sender side: registration of the content, reused while unchanged
+    mutable bulk      m_local;
+    mutable const void* m_local_ptr  = nullptr;
+    mutable std::size_t m_local_size = 0;
+    compression       m_compression;
+    mutable std::vector<char> m_staging;
+    // codec of the exposed data, and whether a size pass prepared it
+    mutable compression::codec m_local_codec = compression::codec::none;
+    mutable bool      m_prepared = false;
+    // receiver side: handle to pull from, when the content was offloaded
+    bulk              m_remote;
+    margo_instance_id m_mid     = MARGO_INSTANCE_NULL;
+    bool              m_pending = false;
+    compression::codec m_codec  = compression::codec::none;
+    std::size_t       m_packed_size = 0;
+
+  public:
+
+    /**
+     * @brief Creates an empty large<T> owning its container.
+     * This constructor is used when deserializing.
+     */
+    large() = default;
+
+    /**
+     * @brief Creates a large<T> referencing an existing container.
+     * The container must outlive the large<T> object.
+     *
+     * @param value Container.
+     * @param threshold Size in bytes above which RDMA is used.
+     */
+    explicit large(T& value, std::size_t threshold = get_large_threshold())
+    : m_ptr(&value)
+    , m_threshold(threshold) {}
+
+    /**
+     * @brief Creates a large<T> owning the provided container.
+     *
+     * @param value Container.
+     * @param threshold Size in bytes above which RDMA is used.
+     */
+    explicit large(T&& value, std::size_t threshold = get_large_threshold())
+    : m_value(std::move(value))
+    , m_threshold(threshold) {}
+
+    large(const large&)            = delete;
+    large& operator=(const large&) = delete;
+
+    large(large&& other)
+    : m_value(std::move(other.m_value))
+    , m_ptr(other.m_ptr == &other.m_value ? &m_value : other.m_ptr)
+    , m_threshold(other.m_threshold)
+    , m_local(std::move(other.m_local))
+    , m_local_ptr(other.m_local_ptr)
+    , m_local_size(other.m_local_size)
+    , m_compression(other.m_compression)
+    , m_staging(std::move(other.m_staging))
+    , m_local_codec(other.m_local_codec)
+    , m_prepared(other.m_prepared)
+    , m_remote(std::move(other.m_remote))
+    , m_mid(other.m_mid)
+    , m_pending(other.m_pending)
+    , m_codec(other.m_codec)
+    , m_packed_size(other.m_packed_size) {
+        other.m_ptr     = &other.m_value;
+        other.m_pending = false;
+    }
+
+    large& operator=(large&& other) {
+        if(&other == this) return *this;
+        m_value      = std::move(other.m_value);
+        m_ptr        = other.m_ptr == &other.m_value ? &m_value : other.m_ptr;
+        m_threshold  = other.m_threshold;
+        m_local      = std::move(other.m_local);
+        m_local_ptr  = other.m_local_ptr;
+        m_local_size = other.m_local_size;
+        m_compression = other.m_compression;
+        m_staging    = std::move(other.m_staging);
+        m_local_codec = other.m_local_codec;
+        m_prepared   = other.m_prepared;
+        m_remote     = std::move(other.m_remote);
+        m_mid        = other.m_mid;
+        m_pending    = other.m_pending;
+        m_codec      = other.m_codec;
+        m_packed_size = other.m_packed_size;
+        other.m_ptr     = &other.m_value;
+        other.m_pending = false;
+        return *this;
+    }
+
+    /**
+     * @brief Returns a reference to the container.
+     */
+    T& get() {
+        if(m_pending)
+            throw exception("large<T> content was offloaded but never pulled");
+        return *m_ptr;
+    }
+
+    const T& get() const {
+        if(m_pending)
+            throw exception("large<T> content was offloaded but never pulled");
+        return *m_ptr;
+    }
+
+    T& operator*() { return get(); }
+    const T& operator*() const { return get(); }
+    T* operator->() { return &get(); }
+    const T* operator->() const { return &get(); }
+
+    /**
+     * @brief Sets the compression applied to the content when it is
+     * sent by RDMA.
+     */
+    void set_compression(const compression& c) {
+        m_compression = c;
+    }
+
+    /**
+     * @brief Returns true if the content was received by RDMA.
+     */
+    bool offloaded() const {
+        return m_remote.size() != 0;
+    }
+
+    template <typename A> void save(A& ar) const {
+        save_impl(ar, m_prepared);
+        // the next send compresses the content again
+        m_prepared = false;
+    }
+
+    /**
+     * @brief Sizes the argument. The content is compressed and exposed
+     * here, and the encoding that follows reuses them.
+     *
+     * @param ar size_archive.
+     */
+    template <typename ... CtxArg> void save(size_archive<CtxArg...>& ar) const {
+        m_prepared = save_impl(ar, false);
+    }
+
+    template <typename A> void load(A& ar) {
+        m_ptr = &m_value;
+        bool offload;
+        ar(offload);
+        if(!offload) {
+            ar(m_value);
+            return;
+        }
+        cereal::size_type size;
+        ar(cereal::make_size_tag(size));
+        std::uint8_t codec;
+        ar(codec);
+        m_codec = static_cast<compression::codec>(codec);
+        if(m_codec != compression::codec::none) {
+            std::uint64_t packed_size;
+            ar(packed_size);
+            m_packed_size = static_cast<std::size_t>(packed_size);
+        }
+        ar(m_remote);
+        // check the sizes sent against the memory exposed by the sender
+        // before allocating anything
+        if(size > std::numeric_limits<std::size_t>::max()/sizeof(value_type))
+            throw exception("large<T> received an invalid size (", size, " elements)");
+        std::size_t bytes = static_cast<std::size_t>(size)*sizeof(value_type);
+        std::size_t expected = m_codec == compression::codec::none ? bytes : m_packed_size;
+        if(m_codec != compression::codec::none) {
+            std::size_t ratio = compression::max_expansion(m_codec);
+            if(ratio == 0)
+                throw exception("large<T> received content compressed with unknown codec ",
+                                static_cast<int>(codec));
+            if(bytes/ratio > m_packed_size)
+                throw exception("large<T> received ", m_packed_size,
+                                " compressed bytes that cannot expand to ", bytes);
+        }
+        if(m_remote.size() != expected)
+            throw exception("large<T> expected ", expected,
+                            " bytes to pull but the sender exposed ", m_remote.size());
+        m_value.resize(static_cast<std::size_t>(size));
+        m_mid     = ar.get_engine().get_margo_instance();
+        m_pending = true;
+    }
+
+    /**
+     * @brief Pulls the offloaded content from the sender. Called by
+     * the engine before invoking the RPC handler.
+     *
+     * @param ep Endpoint of the sender.
+     */
+    void pull(const endpoint& ep);
+
+  private:
+
+    // returns whether the content was offloaded
+    template <typename A> bool save_impl(A& ar, bool prepared) const {
+        std::size_t bytes   = m_ptr->size()*sizeof(value_type);
+        bool        offload = bytes != 0 && bytes >= m_threshold;
+        ar(offload);
+        if(!offload) {
+            ar(*m_ptr);
+            return false;
+        }
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(m_ptr->size())));
+        if(!prepared) prepare(ar, bytes);
+        std::uint8_t codec = static_cast<std::uint8_t>(m_local_codec);
+        ar(codec);
+        if(m_local_codec != compression::codec::none)
+            ar(static_cast<std::uint64_t>(m_local_size));
+        ar(m_local);
+        return true;
+    }
+
+    // compresses the content if needed and exposes it, unless the
+    // exposed memory is unchanged
+    template <typename A> void prepare(A& ar, std::size_t bytes) const {
+        const void* data = m_ptr->data();
+        bool compressed = m_compression.algorithm != compression::codec::none
+                       && bytes >= m_compression.threshold
+                       && m_compression.compress(data, bytes, m_staging);
+        m_local_codec = compressed ? m_compression.algorithm : compression::codec::none;
+        if(compressed) {
+            data  = m_staging.data();
+            bytes = m_staging.size();
+        }
+        if(m_local_ptr != data || m_local_size != bytes) {
+            std::vector<std::pair<void*, std::size_t>> segments{
+                {const_cast<void*>(data), bytes}};
+            m_local      = ar.get_engine().expose(segments, bulk_mode::read_only);
+            m_local_ptr  = data;
+            m_local_size = bytes;
+        }
+    }
+};
+
+/**
+ * @brief Wraps a container passed as an RPC argument so that its content
+ * is always sent by RDMA, whatever its size: the container is exposed in
+ * place and only a bulk handle and the size are copied into the RPC's
+ * buffer, and the receiver pulls the content before calling the handler.
+ * This avoids copying arguments of a few MiB into Mercury's buffer when
+ * they are below the large<T> threshold (or the eager limit) but large
+ * enough for the copy to cost as much as the transfer. The receiver
+ * declares the argument as large<T>.
+ *
+ * \code{.cpp}
+ * std::vector<char> data(2*1024*1024);
+ * put.on(server)(key, tl::by_reference(data));
+ * // server: engine.define("put", [](const tl::request& req, const std::string& key,
+ * //                                 tl::large<std::vector<char>>& data) { ... });
+ * \endcode
+ *
+ * The container is only read, and must neither be modified nor destroyed
+ * until the RPC has completed. The memory is registered until the
+ * returned object is destroyed, so an object kept alive (e.g. for an
+ * asynchronous RPC, or to send the same container several times) is only
+ * registered once.
+ *
+ * @param value Container to send.
+ *
+ * @return a large<T> referencing value.
+ */
+template <typename T> inline large<T> by_reference(const T& value) {
+    // save() only reads the container and exposes it read_only
+    return large<T>(const_cast<T&>(value), 0);
+}
+
+} // namespace thallium
+
+#include <thallium/engine.hpp>
+#include <thallium/request.hpp>
+
+namespace thallium {
+
+template <typename T>
+inline void large<T>::pull(const endpoint& ep) {
+    if(!m_pending) return;
+    std::size_t bytes = m_value.size()*sizeof(value_type);
+    void*       data  = static_cast<void*>(&m_value[0]);
+    if(m_codec != compression::codec::none) {
+        m_staging.resize(m_packed_size);
+        std::vector<std::pair<void*, std::size_t>> segments{
+            {static_cast<void*>(m_staging.data()), m_packed_size}};
+        bulk local = engine(m_mid).expose(segments, bulk_mode::write_only);
+        local << m_remote.on(ep);
+        compression::decompress(m_codec, m_staging.data(), m_packed_size, data, bytes);
+        std::vector<char>().swap(m_staging);
+        m_pending = false;
+        return;
+    }
+    std::vector<std::pair<void*, std::size_t>> segments{{data, bytes}};
+    bulk local = engine(m_mid).expose(segments, bulk_mode::write_only);
+    local << m_remote.on(ep);
+    m_pending = false;
+}
+
+namespace detail {
+
+template <typename T> inline void pull_large_arg(const request&, T&) {}
+
+template <typename T> inline void pull_large_arg(const request& r, large<T>& arg) {
+    arg.pull(r.get_endpoint());
+}
+
+template <typename Tuple, std::size_t... I>
+inline void pull_large_args_impl(const request& r, Tuple& args,
+                                 std::index_sequence<I...>) {
+    int x[] = {0, (pull_large_arg(r, std::get<I>(args)), 0)...};
+    (void)x;
+}
+
+template <typename... Args>
+inline void pull_large_args(const request& r, std::tuple<Args...>& args) {
+    pull_large_args_impl(r, args, std::index_sequence_for<Args...>());
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_LATCH_FUTURE_HPP
+#define __THALLIUM_LATCH_FUTURE_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thallium/abt_errors.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/inplace_function.hpp>
+
+namespace thallium {
+
+/**
+ * Exception class thrown by the latch_future class.
+ */
+class latch_future_exception : public exception {
+  public:
+    template <typename... Args>
+    latch_future_exception(Args&&... args)
+    : exception(std::forward<Args>(args)...) {}
+};
+
+#define TL_LATCH_FUTURE_EXCEPTION(__fun, __ret)                                  \
+    latch_future_exception(#__fun, " returned ", abt_error_get_name(__ret), " (", \
+                           abt_error_get_description(__ret), ") in ", __FILE__,  \
+                           ":", __LINE__);
+
+#define TL_LATCH_FUTURE_ASSERT(__call)                                         \
+    {                                                                          \
+        int __ret = __call;                                                    \
+        if(__ret != ABT_SUCCESS) {                                             \
+            throw TL_LATCH_FUTURE_EXCEPTION(__call, __ret);                    \
+        }                                                                      \
+    }
+
+/**
+ * @brief Non-owning view over the values of a latch_future.
+ */
+template <typename T> class latch_values {
+
+    T* const*   m_data = nullptr;
+    std::size_t m_size = 0;
+
+  public:
+
+    latch_values() = default;
+
+    latch_values(T* const* data, std::size_t size)
+    : m_data(data)
+    , m_size(size) {}
+
+    T* const*   data() const noexcept { return m_data; }
+    std::size_t size() const noexcept { return m_size; }
+    bool        empty() const noexcept { return m_size == 0; }
+    T* const*   begin() const noexcept { return m_data; }
+    T* const*   end() const noexcept { return m_data + m_size; }
+    T*          operator[](std::size_t i) const noexcept { return m_data[i]; }
+};
+
+/**
+ * @brief A latch_future is a fan-in counter for the "N results, then
+ * continue" pattern. Like future, it holds pointers to N objects of type
+ * T (which it does not own) and becomes ready once all of them have been
+ * set, calling an optional callback; unlike future, it never allocates
+ * after construction: the pointers are kept in a contiguous array
+ * allocated once, the callback is stored inline (in an inplace_function
+ * of CallbackCapacity bytes) and receives a latch_values view over the
+ * array, and setting a value costs two atomic increments.
+ *
+ * \code{.cpp}
+ * std::vector<result> results(n);
+ * tl::latch_future<result> done(n, [](tl::latch_values<result> v) {
+ *     merge(v.begin(), v.end());
+ * });
+ * for(uint32_t i = 0; i < n; i++)
+ *     pool.make_thread([&, i]() { results[i] = rpc.on(ep[i])(); done.set(i, &results[i]); },
+ *                      tl::anonymous());
+ * done.wait();
+ * \endcode
+ *
+ * Values are stored either in the order in which they are set (set(value))
+ * or at a given index (set(index, value)); the two must not be mixed
+ * between two resets. The callback is called by the ULT setting the last
+ * value, before wait() returns in the waiting ULTs; if it throws, the
+ * exception propagates from that set() call and the latch_future still
+ * becomes ready. A latch_future can be re-armed with reset() once ready,
+ * without allocating.
+ *
+ * @tparam T Type of the objects pointed to.
+ * @tparam CallbackCapacity Size of the inline callback storage.
+ */
+template <typename T, std::size_t CallbackCapacity = 4 * sizeof(void*)>
+class latch_future {
+
+  public:
+
+    /**
+     * @brief Type of the callback.
+     */
+    using callback_type = inplace_function<void(latch_values<T>), CallbackCapacity>;
+
+    /**
+     * @brief Type of the underlying native handle.
+     */
+    typedef ABT_eventual native_handle_type;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param compartments Number of values expected before the
+     * latch_future is ready.
+     */
+    explicit latch_future(std::uint32_t compartments)
+    : latch_future(compartments, callback_type()) {}
+
+    /**
+     * @brief Constructor.
+     *
+     * @param compartments Number of values expected before the
+     * latch_future is ready.
+     * @param cb Function to call when the latch_future becomes ready.
+     */
+    latch_future(std::uint32_t compartments, callback_type cb)
+    : m_size(compartments)
+    , m_values(new T*[compartments > 0 ? compartments : 1]())
+    , m_callback(std::move(cb)) {
+        TL_LATCH_FUTURE_ASSERT(ABT_eventual_create(0, &m_eventual));
+        if(m_size == 0) complete();
+    }
+
+    latch_future(const latch_future&)            = delete;
+    latch_future& operator=(const latch_future&) = delete;
+
+    /**
+     * @brief Destructor.
+     */
+    ~latch_future() {
+        if(m_eventual != ABT_EVENTUAL_NULL) ABT_eventual_free(&m_eventual);
+    }
+
+    /**
+     * @brief Sets the next value.
+     */
+    void set(T* value) {
+        std::uint32_t slot = m_next.fetch_add(1, std::memory_order_relaxed);
+        if(slot >= m_size)
+            throw latch_future_exception("latch_future: more than ", m_size, " values set");
+        m_values[slot] = value;
+        arrive();
+    }
+
+    /**
+     * @brief Sets the value at the given index.
+     */
+    void set(std::uint32_t index, T* value) {
+        if(index >= m_size)
+            throw latch_future_exception("latch_future: index ", index,
+                                         " out of range (", m_size, " compartments)");
+        m_values[index] = value;
+        arrive();
+    }
+
+    /**
+     * @brief Waits for the latch_future to be ready.
+     */
+    void wait() { TL_LATCH_FUTURE_ASSERT(ABT_eventual_wait(m_eventual, nullptr)); }
+
+    /**
+     * @brief Tests if the latch_future is ready.
+     */
+    bool test() const noexcept {
+        return m_arrived.load(std::memory_order_acquire) >= m_size;
+    }
+
+    /**
+     * @see latch_future::test
+     */
+    operator bool() const noexcept { return test(); }
+
+    /**
+     * @brief Returns the values (meaningful once the latch_future is
+     * ready).
+     */
+    latch_values<T> values() const noexcept {
+        return latch_values<T>(m_values.get(), m_size);
+    }
+
+    /**
+     * @brief Number of values expected.
+     */
+    std::uint32_t size() const noexcept { return m_size; }
+
+    /**
+     * @brief Re-arms a ready latch_future, keeping its callback. No
+     * ULT may be waiting on it or setting values concurrently.
+     */
+    void reset() {
+        if(!test())
+            throw latch_future_exception("latch_future: cannot reset before it is ready");
+        if(m_size == 0) return;
+        TL_LATCH_FUTURE_ASSERT(ABT_eventual_reset(m_eventual));
+        m_next.store(0, std::memory_order_relaxed);
+        m_arrived.store(0, std::memory_order_release);
+    }
+
+    /**
+     * @brief Get the underlying native handle.
+     */
+    native_handle_type native_handle() const noexcept { return m_eventual; }
+
+  private:
+
+    std::uint32_t              m_size;
+    std::unique_ptr<T*[]>      m_values;
+    callback_type              m_callback;
+    ABT_eventual               m_eventual = ABT_EVENTUAL_NULL;
+    std::atomic<std::uint32_t> m_next{0};
+    std::atomic<std::uint32_t> m_arrived{0};
+
+    void arrive() {
+        // acq_rel so that the last ULT sees all the values
+        if(m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_size)
+            complete();
+    }
+
+    void complete() {
+        if(m_callback) {
+            try {
+                m_callback(values());
+            } catch(...) {
+                ABT_eventual_set(m_eventual, nullptr, 0);
+                throw;
+            }
+        }
+        TL_LATCH_FUTURE_ASSERT(ABT_eventual_set(m_eventual, nullptr, 0));
+    }
+};
+
+} // namespace thallium
+
+#undef TL_LATCH_FUTURE_EXCEPTION
+#undef TL_LATCH_FUTURE_ASSERT
+
+#endif /* end of include guard */
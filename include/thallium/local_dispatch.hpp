@@ -0,0 +1,444 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_LOCAL_DISPATCH_HPP
+#define __THALLIUM_LOCAL_DISPATCH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/eventual.hpp>
+#include <thallium/opaque_payload.hpp>
+#include <thallium/per_instance.hpp>
+#include <thallium/proc_object.hpp>
+#include <thallium/unit_allocator.hpp>
+
+namespace thallium {
+
+template <typename T> class large;
+
+/**
+ * @brief Whether an argument of type T can be handed by pointer from
+ * the caller to the handler of an RPC sent by an engine to itself
+ * (see engine::enable_local_dispatch), the handler getting a copy of
+ * the caller's object instead of a decoded one, and the same for the
+ * values of its response. This is the case of copyable types, except
+ * opaque_payload and large<T>, which depend on their encoding.
+ * Specialize this trait as std::false_type for types whose
+ * serialization does more than copying their value.
+ */
+template <typename T>
+struct is_locally_passable
+: std::integral_constant<bool, std::is_copy_constructible<T>::value
+                               && std::is_copy_assignable<T>::value> {};
+
+template <> struct is_locally_passable<opaque_payload> : std::false_type {};
+
+template <typename T> struct is_locally_passable<large<T>> : std::false_type {};
+
+namespace detail {
+
+template <typename T> struct unwrap_local_arg { using type = T; };
+
+template <typename T> struct unwrap_local_arg<std::reference_wrapper<T>> {
+    using type = typename std::decay<T>::type;
+};
+
+/**
+ * @private
+ * @brief Type of the arguments handed to a handler, with
+ * std::reference_wrapper (as created by std::cref) removed.
+ */
+template <typename T>
+using local_arg_t = typename unwrap_local_arg<typename std::decay<T>::type>::type;
+
+template <typename... T> struct all_locally_passable;
+
+template <> struct all_locally_passable<> : std::true_type {};
+
+template <typename T1, typename... Tn>
+struct all_locally_passable<T1, Tn...>
+: std::integral_constant<bool, is_locally_passable<T1>::value
+                               && all_locally_passable<Tn...>::value> {};
+
+/**
+ * @private
+ * @brief Address identifying the type Tuple within the process.
+ */
+template <typename Tuple> const void* local_type_id() {
+    static const char id = 0;
+    return &id;
+}
+
+/**
+ * @private
+ * @brief Values of the response to an RPC sent by an engine to itself,
+ * as handed by the handler to the caller: a tuple, its type, and the
+ * function encoding it, for a caller that unpacks it as other types.
+ */
+struct local_response {
+    const void*           type = nullptr;
+    std::shared_ptr<void> values;
+    hg_return_t (*encode)(const void* values, margo_instance_id mid,
+                          std::vector<char>& buffer) = nullptr;
+};
+
+/**
+ * @private
+ * @brief Arguments of an RPC sent by an engine to itself: the type of
+ * their tuple and a std::tuple<const T*...> pointing to them, as well
+ * as the response, if the handler hands it by value. Bit I of movable
+ * is set if the caller passed argument I as an rvalue, in which case
+ * the handler moves it instead of copying it. When the handler runs in
+ * the caller's ULT (see local_dispatch::invoke), responded is set once
+ * it has responded, which it may do after returning.
+ */
+struct local_call {
+    const void*                     type;
+    const void*                     args;
+    std::shared_ptr<local_response> response;
+    std::uint64_t                   movable   = 0;
+    eventual<void>*                 responded = nullptr;
+};
+
+/**
+ * @private
+ * @brief Id with which margo receives an RPC of id id forwarded with
+ * margo_provider_forward to provider_id: the provider id replaces the
+ * low-order bits of the id.
+ */
+inline hg_id_t local_rpc_id(hg_id_t id, std::uint16_t provider_id) {
+    constexpr unsigned bits = __MARGO_PROVIDER_ID_SIZE * 8;
+    return ((id >> bits) << bits) | provider_id;
+}
+
+/**
+ * @private
+ * @brief Mask of the arguments of types T... (as deduced for forwarding
+ * references) that are non-const rvalues, see local_call::movable.
+ */
+template <typename... T> std::uint64_t local_movable_mask() {
+    const bool movable[] = {false, (!std::is_lvalue_reference<T>::value
+        && !std::is_const<typename std::remove_reference<T>::type>::value)...};
+    std::uint64_t mask = 0;
+    for(std::size_t i = 0; i < sizeof...(T) && i < 64; i++)
+        if(movable[i + 1]) mask |= std::uint64_t(1) << i;
+    return mask;
+}
+
+template <typename Tuple>
+hg_return_t encode_local_response(const void* values, margo_instance_id mid,
+                                  std::vector<char>& buffer) {
+    auto&        t   = *static_cast<Tuple*>(const_cast<void*>(values));
+    std::tuple<> ctx;
+    buffer.resize(get_encoded_size(t, mid, ctx));
+    hg_proc_t   proc = HG_PROC_NULL;
+    hg_return_t ret  = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                          HG_ENCODE, HG_NOHASH, &proc);
+    if(ret != HG_SUCCESS) return ret;
+    ret = proc_object_encode(proc, t, mid, ctx);
+    hg_proc_free(proc);
+    return ret;
+}
+
+template <typename... T>
+bool hand_local_response_if(std::true_type, local_call& call, T&&... t) {
+    using tuple_type   = std::tuple<typename std::decay<T>::type...>;
+    auto response      = std::make_shared<local_response>();
+    response->type     = local_type_id<tuple_type>();
+    response->values   = std::make_shared<tuple_type>(std::forward<T>(t)...);
+    response->encode   = &encode_local_response<tuple_type>;
+    call.response      = std::move(response);
+    return true;
+}
+
+template <typename... T>
+bool hand_local_response_if(std::false_type, local_call&, T&&...) {
+    return false;
+}
+
+inline hg_return_t copy_encoded_response(const void* values, margo_instance_id,
+                                         std::vector<char>& buffer) {
+    buffer = *static_cast<const std::vector<char>*>(values);
+    return HG_SUCCESS;
+}
+
+/**
+ * @private
+ * @brief Hands the response of a local call whose handler ran in the
+ * caller's ULT to the caller in encoded form, for values that cannot be
+ * handed as they are or that are encoded with a serialization context.
+ */
+template <typename Tuple, typename... CtxArg>
+hg_return_t hand_encoded_response(local_call& call, Tuple& t, margo_instance_id mid,
+                                  std::tuple<CtxArg...>& ctx) {
+    auto        buffer = std::make_shared<std::vector<char>>(get_encoded_size(t, mid, ctx));
+    hg_proc_t   proc   = HG_PROC_NULL;
+    hg_return_t ret    = hg_proc_create_set(margo_get_class(mid), buffer->data(), buffer->size(),
+                                            HG_ENCODE, HG_NOHASH, &proc);
+    if(ret != HG_SUCCESS) return ret;
+    ret = proc_object_encode(proc, t, mid, ctx);
+    hg_proc_free(proc);
+    if(ret != HG_SUCCESS) return ret;
+    // no type: callers always decode it
+    auto response    = std::make_shared<local_response>();
+    response->values = std::move(buffer);
+    response->encode = &copy_encoded_response;
+    call.response    = std::move(response);
+    return HG_SUCCESS;
+}
+
+/**
+ * @private
+ * @brief Hands the values of a response to the caller of a local call,
+ * moving rvalues. Returns false if some of them are not locally
+ * passable, in which case the response must be serialized.
+ */
+template <typename... T>
+bool hand_local_response(local_call& call, T&&... t) {
+    return hand_local_response_if(
+        all_locally_passable<typename std::decay<T>::type...>(), call, std::forward<T>(t)...);
+}
+
+template <typename... T, typename Src, std::size_t... I>
+void assign_local_response(std::tuple<T...>& dst, Src&& src, std::index_sequence<I...>) {
+    (void)std::initializer_list<int>{
+        ((static_cast<local_arg_t<T>&>(std::get<I>(dst)) = std::get<I>(std::forward<Src>(src))),
+         0)...};
+}
+
+/**
+ * @private
+ * @brief Unpacks the values of a local response into t (a tuple of
+ * values or of std::reference_wrapper), moving them if they have the
+ * types of t and move is true (the caller is their last user), copying
+ * them if they have the types of t, or else encoding and decoding them.
+ */
+template <typename... T, typename... CtxArg>
+hg_return_t unpack_local_response(const local_response& response, std::tuple<T...>& t,
+                                  margo_instance_id mid, std::tuple<CtxArg...>& ctx,
+                                  bool move = false) {
+    using tuple_type = std::tuple<local_arg_t<T>...>;
+    if(response.type == local_type_id<tuple_type>()) {
+        auto& values = *static_cast<tuple_type*>(response.values.get());
+        if(move)
+            assign_local_response(t, std::move(values), std::index_sequence_for<T...>());
+        else
+            assign_local_response(t, static_cast<const tuple_type&>(values),
+                                  std::index_sequence_for<T...>());
+        return HG_SUCCESS;
+    }
+    std::vector<char> buffer;
+    hg_return_t       ret = response.encode(response.values.get(), mid, buffer);
+    if(ret != HG_SUCCESS) return ret;
+    hg_proc_t proc = HG_PROC_NULL;
+    ret = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                             HG_DECODE, HG_NOHASH, &proc);
+    if(ret != HG_SUCCESS) return ret;
+    ret = proc_object_decode(proc, t, mid, ctx);
+    hg_proc_free(proc);
+    return ret;
+}
+
+template <typename... T, std::size_t... I>
+std::tuple<const local_arg_t<T>*...>
+local_arg_pointers(const std::tuple<T...>& args, std::index_sequence<I...>) {
+    return std::tuple<const local_arg_t<T>*...>(
+        &static_cast<const local_arg_t<T>&>(std::get<I>(args))...);
+}
+
+template <typename T> void assign_local_arg(T& dst, const T* src, bool move) {
+    // the caller passed a non-const rvalue, which it no longer uses
+    if(move) dst = std::move(*const_cast<T*>(src));
+    else     dst = *src;
+}
+
+/**
+ * @private
+ * @brief Moves or copies the arguments of a local_call into the tuple
+ * the handler's arguments would have been decoded into. The
+ * local_call's type must be that of the tuple.
+ */
+template <typename... T, std::size_t... I>
+void assign_local_args(std::tuple<T...>& dst, const local_call& call,
+                       std::index_sequence<I...>) {
+    auto& src = *static_cast<const std::tuple<const T*...>*>(call.args);
+    (void)src;
+    (void)std::initializer_list<int>{(assign_local_arg(std::get<I>(dst), std::get<I>(src),
+        I < 64 && ((call.movable >> (I % 64)) & 1)), 0)...};
+}
+
+/**
+ * @private
+ * @brief Function running the handler of an RPC for a local_call in
+ * the calling ULT, returning false if the RPC must go through Mercury
+ * (defined by the engine, see thallium_invoke_local_rpc).
+ */
+using local_invoke_fn = bool (*)(margo_instance_id mid, hg_id_t id, local_call& call);
+
+/**
+ * @private
+ * @brief State of engine::enable_local_dispatch attached to a margo
+ * instance: the instance's own address, the argument types of the RPCs
+ * it defined, and the local_call of each handle being forwarded to
+ * itself. Mercury runs an RPC sent to its own address on the handle it
+ * was forwarded with, so the handler finds its local_call from its
+ * handle. Only RPCs an engine sends to itself go through here; RPCs to
+ * other processes, on the same node or not, go through Mercury.
+ *
+ * When the RPC's settings allow it, invoke() runs the handler directly
+ * in the caller's ULT instead, so that the call neither creates a
+ * handle nor goes through Mercury.
+ *
+ * Each call posts, takes and looks up its entries once on the caller's
+ * and once on the handler's execution stream, so the maps are split in
+ * shards, selected by handle (or RPC id), each with its own mutex.
+ */
+class local_dispatch : public per_instance<local_dispatch> {
+
+    static constexpr std::size_t num_shards = 16;
+
+    struct shard {
+        std::mutex                                     mutex;
+        std::unordered_map<hg_id_t, const void*>       types;
+        pooled_unordered_map<hg_handle_t, local_call*> calls;
+    };
+
+    margo_instance_id  m_mid;
+    local_invoke_fn    m_invoke;
+    hg_addr_t          m_self = HG_ADDR_NULL;
+    std::mutex         m_self_mutex;
+    shard              m_shards[num_shards];
+
+    shard& shard_of(hg_handle_t h) {
+        // handles are heap-allocated: ignore the bits of the alignment
+        return m_shards[(reinterpret_cast<std::uintptr_t>(h) >> 4) % num_shards];
+    }
+
+    shard& shard_of(hg_id_t id) {
+        return m_shards[id % num_shards];
+    }
+
+  public:
+
+    local_dispatch(margo_instance_id mid, local_invoke_fn invoke)
+    : m_mid(mid)
+    , m_invoke(invoke) {
+        margo_addr_self(m_mid, &m_self);
+    }
+
+    local_dispatch(const local_dispatch&)            = delete;
+    local_dispatch& operator=(const local_dispatch&) = delete;
+
+    /**
+     * @brief Frees the instance's own address. Called when the engine
+     * is finalized, after which is_self always returns false.
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(m_self_mutex);
+        if(m_self != HG_ADDR_NULL) margo_addr_free(m_mid, m_self);
+        m_self = HG_ADDR_NULL;
+    }
+
+    /**
+     * @brief Whether addr is the address of the margo instance itself.
+     */
+    bool is_self(hg_addr_t addr) const {
+        return m_self != HG_ADDR_NULL && addr != HG_ADDR_NULL
+            && margo_addr_cmp(m_mid, m_self, addr);
+    }
+
+    /**
+     * @brief Returns the instance's own address, owned by this object.
+     */
+    hg_addr_t self() const {
+        return m_self;
+    }
+
+    /**
+     * @brief Runs the handler of the RPC of id id (as received) for call
+     * in the calling ULT, if the handler takes the call's argument types
+     * and the RPC's settings allow it, and returns whether it did. The
+     * handler may respond after this returns: the caller then waits on
+     * call.responded.
+     */
+    bool invoke(hg_id_t id, local_call& call) {
+        return m_invoke && type(id) == call.type && m_invoke(m_mid, id, call);
+    }
+
+    /**
+     * @brief Records the type of the arguments of the handler of an RPC
+     * (nullptr if they can't be handed by pointer).
+     */
+    void set_type(hg_id_t id, const void* type) {
+        auto& s = shard_of(id);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if(type) s.types[id] = type;
+        else     s.types.erase(id);
+    }
+
+    const void* type(hg_id_t id) {
+        auto& s = shard_of(id);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.types.find(id);
+        return it == s.types.end() ? nullptr : it->second;
+    }
+
+    /**
+     * @brief Makes call available to the handler of the RPC forwarded
+     * with handle h, until it takes it or withdraw(h) is called.
+     */
+    void post(hg_handle_t h, local_call* call) {
+        auto& s = shard_of(h);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.calls[h] = call;
+    }
+
+    void withdraw(hg_handle_t h) {
+        auto& s = shard_of(h);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.calls.erase(h);
+    }
+
+    /**
+     * @brief Returns the local_call posted for the handle, if any, and
+     * forgets it.
+     */
+    local_call* take(hg_handle_t h) {
+        auto& s = shard_of(h);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.calls.find(h);
+        if(it == s.calls.end()) return nullptr;
+        auto call = it->second;
+        s.calls.erase(it);
+        return call;
+    }
+
+    /**
+     * @brief Whether a local_call is posted for the handle, i.e. the
+     * RPC's arguments are handed by pointer rather than encoded.
+     */
+    bool has_call(hg_handle_t h) {
+        auto& s = shard_of(h);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.calls.find(h) != s.calls.end();
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,204 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_LOCK_STATS_HPP
+#define __THALLIUM_LOCK_STATS_HPP
+
+#include <abt.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <thallium/tsc_clock.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Contention statistics of the locks created at one site (see
+ * get_lock_stats). For mutexes, an acquisition is contended if the
+ * mutex was held when it was requested; for rwlocks, which cannot be
+ * tried, if it took more than a microsecond; for condition variables,
+ * acquisitions count the waits, all of which are contended, and the
+ * wait time is the time spent waiting to be notified.
+ */
+struct lock_stats_entry {
+    std::string   site;             /*!< name, or file:line where the locks were created */
+    std::string   kind;             /*!< "mutex", "rwlock" or "condition_variable" */
+    std::uint64_t acquisitions = 0; /*!< number of acquisitions */
+    std::uint64_t contended    = 0; /*!< acquisitions that had to wait */
+    std::uint64_t wait_ns      = 0; /*!< total time spent waiting */
+    std::uint64_t max_wait_ns  = 0; /*!< longest wait */
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Counters of a lock site, one set per execution stream (by
+ * rank), so that recording only involves uncontended relaxed loads
+ * and stores. Sites are never freed.
+ */
+class lock_site {
+
+    static constexpr std::size_t max_slots = 16;
+
+    struct slot {
+        std::atomic<std::uint64_t> acquisitions{0};
+        std::atomic<std::uint64_t> contended{0};
+        std::atomic<std::uint64_t> wait_ns{0};
+        std::atomic<std::uint64_t> max_wait_ns{0};
+    };
+
+    std::array<slot, max_slots> m_slots;
+
+    static void add(std::atomic<std::uint64_t>& c, std::uint64_t v) {
+        c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    using registry_type = std::map<std::string, std::unique_ptr<lock_site>>;
+
+    static std::mutex& registry_mutex() {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    static registry_type& registry() {
+        static registry_type r;
+        return r;
+    }
+
+  public:
+
+    const std::string site;
+    const char* const kind;
+
+    lock_site(std::string s, const char* k)
+    : site(std::move(s))
+    , kind(k) {}
+
+    /**
+     * @brief Records an acquisition that waited wait_ns nanoseconds.
+     */
+    void record(std::uint64_t wait_ns, bool contended) {
+        int rank = 0;
+        if(ABT_xstream_self_rank(&rank) != ABT_SUCCESS || rank < 0) rank = 0;
+        auto& s = m_slots[static_cast<std::size_t>(rank) % max_slots];
+        add(s.acquisitions, 1);
+        if(!contended) return;
+        add(s.contended, 1);
+        add(s.wait_ns, wait_ns);
+        if(wait_ns > s.max_wait_ns.load(std::memory_order_relaxed))
+            s.max_wait_ns.store(wait_ns, std::memory_order_relaxed);
+    }
+
+    lock_stats_entry snapshot() const {
+        lock_stats_entry e;
+        e.site = site;
+        e.kind = kind;
+        for(auto& s : m_slots) {
+            e.acquisitions += s.acquisitions.load(std::memory_order_relaxed);
+            e.contended    += s.contended.load(std::memory_order_relaxed);
+            e.wait_ns      += s.wait_ns.load(std::memory_order_relaxed);
+            e.max_wait_ns   = std::max(e.max_wait_ns, s.max_wait_ns.load(std::memory_order_relaxed));
+        }
+        return e;
+    }
+
+    void reset() {
+        for(auto& s : m_slots) {
+            s.acquisitions.store(0, std::memory_order_relaxed);
+            s.contended.store(0, std::memory_order_relaxed);
+            s.wait_ns.store(0, std::memory_order_relaxed);
+            s.max_wait_ns.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Returns the site of the given name and kind, creating it
+     * if needed.
+     */
+    static lock_site* get(const std::string& name, const char* kind) {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        auto& s = registry()[std::string(kind) + "\n" + name];
+        if(!s) s.reset(new lock_site(name, kind));
+        return s.get();
+    }
+
+    static lock_site* get(const char* file, int line, const char* kind) {
+        return get(std::string(file) + ":" + std::to_string(line), kind);
+    }
+
+    static std::vector<lock_stats_entry> snapshot_all() {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        std::vector<lock_stats_entry> result;
+        result.reserve(registry().size());
+        for(auto& p : registry()) result.push_back(p.second->snapshot());
+        return result;
+    }
+
+    static void reset_all() {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        for(auto& p : registry()) p.second->reset();
+    }
+
+    static std::uint64_t now() {
+        return tsc_clock::now_ns();
+    }
+};
+
+/**
+ * @private
+ * @brief Waits longer than this count as contended for locks that
+ * cannot be tried.
+ */
+constexpr std::uint64_t lock_contention_ns = 1000;
+
+} // namespace detail
+
+/**
+ * @brief Returns the contention statistics of the mutexes, rwlocks and
+ * condition variables of the process, by site. Locks are only
+ * instrumented if thallium is compiled with THALLIUM_ENABLE_LOCK_STATS
+ * defined (e.g. by linking against the thallium_lock_stats CMake
+ * target); otherwise the instrumentation is compiled out and this
+ * function returns an empty vector. The site of a lock is the name
+ * given to its constructor, or else the file and line where it was
+ * constructed (with GCC and Clang). The statistics are also part of
+ * engine::get_rpc_stats().
+ */
+inline std::vector<lock_stats_entry> get_lock_stats() {
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    return detail::lock_site::snapshot_all();
+#else
+    return {};
+#endif
+}
+
+/**
+ * @brief Clears the lock statistics recorded so far.
+ */
+inline void reset_lock_stats() {
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    detail::lock_site::reset_all();
+#endif
+}
+
+} // namespace thallium
+
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+#if defined(__GNUC__) || defined(__clang__)
+#define THALLIUM_LOCK_SITE_FILE __builtin_FILE()
+#define THALLIUM_LOCK_SITE_LINE __builtin_LINE()
+#else
+#define THALLIUM_LOCK_SITE_FILE "unknown"
+#define THALLIUM_LOCK_SITE_LINE 0
+#endif
+#endif
+
+#endif
@@ -0,0 +1,353 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_METRICS_EXPORTER_HPP
+#define __THALLIUM_METRICS_EXPORTER_HPP
+
+#include <abt.h>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <margo.h>
+#include <thallium/bulk_cache.hpp>
+#include <thallium/bulk_traffic.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/endpoint.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/request.hpp>
+#include <thallium/rpc_stats.hpp>
+#include <thallium/timed_callback.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Publishes the statistics of an engine in the OpenMetrics text
+ * format (which Prometheus scrapes): RPC latencies (if
+ * THALLIUM_ENABLE_RPC_STATS is defined and engine::enable_rpc_stats was
+ * called), admission gauges, pool sizes, work unit wait and run times
+ * per pool (if enable_pool_stats was called), the number of execution
+ * streams, bulk bytes moved and the bulk registration cache counters.
+ *
+ * The metrics can be written periodically to a file (replaced
+ * atomically, e.g. for node_exporter's textfile collector) or handed to
+ * a sink, and served by an RPC that another process can call with
+ * metrics_exporter::fetch (e.g. from a scraping gateway). Formatting
+ * only reads counters and copies histograms, without blocking the RPCs
+ * being recorded, so it can run every second on production servers.
+ *
+ * \code{.cpp}
+ * tl::metrics_exporter::options opts;
+ * opts.path = "/var/lib/node_exporter/myservice.prom";
+ * tl::metrics_exporter exporter(engine, opts);
+ * \endcode
+ *
+ * The exporter stops when the engine is finalized or when it is
+ * destroyed, whichever comes first.
+ */
+class metrics_exporter {
+
+  public:
+
+    /**
+     * @brief Parameters of a metrics_exporter.
+     */
+    struct options {
+        double      interval_ms = 1000.0; /*!< period of the dumps (0 for none) */
+        std::string path;     /*!< file the metrics are written to (if not empty) */
+        std::function<void(const std::string&)> sink; /*!< called with the metrics */
+        std::string rpc_name; /*!< RPC serving the metrics (if not empty) */
+        std::uint16_t provider_id = 0; /*!< provider id of that RPC */
+    };
+
+    /**
+     * @brief Constructor. Starts counting bulk transfers and, if a path
+     * or a sink is given, the periodic dumps.
+     *
+     * @param e Engine whose statistics are published.
+     * @param opts Options.
+     */
+    metrics_exporter(const engine& e, options opts)
+    : m_mid(e.get_margo_instance())
+    , m_interval_ms(opts.interval_ms)
+    , m_path(std::move(opts.path))
+    , m_sink(std::move(opts.sink)) {
+        detail::bulk_traffic::enable(m_mid);
+        if(!opts.rpc_name.empty()) {
+            margo_instance_id mid = m_mid;
+            engine(m_mid).define(opts.rpc_name, [mid](const request& req) {
+                req.respond(format(mid));
+            }, opts.provider_id);
+        }
+        if(m_interval_ms > 0.0 && (!m_path.empty() || m_sink)) {
+            m_timer = std::make_unique<timed_callback>(
+                engine(m_mid).create_timed_callback([this]() { tick(); }));
+            m_running = true;
+            m_timer->start(m_interval_ms);
+            margo_provider_push_prefinalize_callback(
+                m_mid, this, &metrics_exporter::on_finalize, this);
+        }
+    }
+
+    /**
+     * @brief Constructor with the default options (counting bulk
+     * transfers, without dumps or RPC).
+     */
+    explicit metrics_exporter(const engine& e)
+    : metrics_exporter(e, options()) {}
+
+    metrics_exporter(const metrics_exporter&)            = delete;
+    metrics_exporter& operator=(const metrics_exporter&) = delete;
+
+    ~metrics_exporter() {
+        if(stop()) margo_provider_pop_prefinalize_callback(m_mid, this);
+    }
+
+    /**
+     * @brief Returns the current metrics.
+     */
+    std::string text() const { return format(m_mid); }
+
+    /**
+     * @brief Returns the metrics of a remote process, served by the RPC
+     * named in the options of its exporter.
+     *
+     * @param e Engine sending the RPC.
+     * @param ep Address of the remote process.
+     * @param rpc_name Name of the RPC.
+     * @param provider_id Provider id of the RPC.
+     */
+    static std::string fetch(const engine& e, const endpoint& ep,
+                             const std::string& rpc_name,
+                             std::uint16_t provider_id = 0) {
+        engine      client = e;
+        std::string text   = client.define(rpc_name.c_str()).on(provider_handle(ep, provider_id))();
+        return text;
+    }
+
+    /**
+     * @brief Formats the metrics of a margo instance.
+     */
+    static std::string format(margo_instance_id mid) {
+        engine      e(mid);
+        std::string out;
+        out.reserve(4096);
+
+        rpc_stats stats = e.get_rpc_stats();
+        if(!stats.rpcs.empty()) {
+            out += "# TYPE thallium_rpc_latency_seconds summary\n"
+                   "# UNIT thallium_rpc_latency_seconds seconds\n"
+                   "# HELP thallium_rpc_latency_seconds Latency of RPC stages.\n";
+            for(auto& r : stats.rpcs) {
+                std::string labels = "rpc=\"" + escape(r.name) + "\",id=\""
+                                   + std::to_string(r.id) + "\",provider=\""
+                                   + std::to_string(r.provider_id) + "\",side=\""
+                                   + (r.server ? "server" : "client") + "\"";
+                if(r.server) {
+                    summary(out, labels, "queue", r.queue);
+                    summary(out, labels, "decode", r.decode);
+                    summary(out, labels, "handler", r.handler);
+                    summary(out, labels, "respond", r.respond);
+                } else {
+                    summary(out, labels, "round_trip", r.round_trip);
+                }
+            }
+        }
+        if(!stats.admission.empty()) {
+            out += "# TYPE thallium_rpc_in_flight gauge\n";
+            for(auto& a : stats.admission)
+                sample(out, "thallium_rpc_in_flight", "id=\"" + std::to_string(a.id) + "\"",
+                       static_cast<double>(a.in_flight));
+            out += "# TYPE thallium_rpc_rejected counter\n";
+            for(auto& a : stats.admission)
+                sample(out, "thallium_rpc_rejected_total", "id=\"" + std::to_string(a.id) + "\"",
+                       static_cast<double>(a.rejected));
+            out += "# TYPE thallium_rpc_deferred counter\n";
+            for(auto& a : stats.admission)
+                sample(out, "thallium_rpc_deferred_total", "id=\"" + std::to_string(a.id) + "\"",
+                       static_cast<double>(a.deferred));
+            out += "# TYPE thallium_rpc_bytes_in_flight gauge\n"
+                   "# UNIT thallium_rpc_bytes_in_flight bytes\n";
+            for(auto& a : stats.admission)
+                sample(out, "thallium_rpc_bytes_in_flight", "id=\"" + std::to_string(a.id) + "\"",
+                       static_cast<double>(a.bytes_in_flight));
+        }
+
+        if(!stats.pools.empty()) {
+            out += "# TYPE thallium_pool_latency_seconds summary\n"
+                   "# UNIT thallium_pool_latency_seconds seconds\n"
+                   "# HELP thallium_pool_latency_seconds Time work units wait in a pool and run.\n";
+            for(auto& p : stats.pools) {
+                std::string labels = pool_labels(p);
+                quantiles(out, "thallium_pool_latency_seconds", labels + ",stage=\"wait\"", p.wait);
+                quantiles(out, "thallium_pool_latency_seconds", labels + ",stage=\"run\"", p.run);
+            }
+            out += "# TYPE thallium_units_created counter\n";
+            for(auto& p : stats.pools)
+                sample(out, "thallium_units_created_total", pool_labels(p), static_cast<double>(p.created));
+            out += "# TYPE thallium_units_yields counter\n";
+            for(auto& p : stats.pools)
+                sample(out, "thallium_units_yields_total", pool_labels(p), static_cast<double>(p.yields));
+            out += "# TYPE thallium_units_finished counter\n";
+            for(auto& p : stats.pools)
+                sample(out, "thallium_units_finished_total", pool_labels(p), static_cast<double>(p.finished));
+        }
+
+        std::size_t num_pools = margo_get_num_pools(mid);
+        out += "# TYPE thallium_pool_size gauge\n"
+               "# HELP thallium_pool_size Work units ready to run in a pool.\n";
+        std::string total;
+        for(std::size_t i = 0; i < num_pools; i++) {
+            margo_pool_info info;
+            if(margo_find_pool_by_index(mid, static_cast<uint32_t>(i), &info) != HG_SUCCESS)
+                continue;
+            std::size_t size = 0, total_size = 0;
+            ABT_pool_get_size(info.pool, &size);
+            ABT_pool_get_total_size(info.pool, &total_size);
+            std::string labels = "pool=\"" + escape(info.name ? info.name : "") + "\"";
+            sample(out, "thallium_pool_size", labels, static_cast<double>(size));
+            sample(total, "thallium_pool_total_size", labels, static_cast<double>(total_size));
+        }
+        out += "# TYPE thallium_pool_total_size gauge\n"
+               "# HELP thallium_pool_total_size Work units in a pool, including blocked ones.\n";
+        out += total;
+        out += "# TYPE thallium_xstreams gauge\n";
+        sample(out, "thallium_xstreams", "", static_cast<double>(margo_get_num_xstreams(mid)));
+
+        bulk_traffic_stats traffic = detail::bulk_traffic::snapshot(mid);
+        out += "# TYPE thallium_bulk_operations counter\n";
+        sample(out, "thallium_bulk_operations_total", "op=\"pull\"", static_cast<double>(traffic.pulls));
+        sample(out, "thallium_bulk_operations_total", "op=\"push\"", static_cast<double>(traffic.pushes));
+        out += "# TYPE thallium_bulk_bytes counter\n"
+               "# UNIT thallium_bulk_bytes bytes\n";
+        sample(out, "thallium_bulk_bytes_total", "op=\"pull\"", static_cast<double>(traffic.pulled_bytes));
+        sample(out, "thallium_bulk_bytes_total", "op=\"push\"", static_cast<double>(traffic.pushed_bytes));
+
+        bulk_cache_stats cache = e.get_bulk_cache_stats();
+        out += "# TYPE thallium_bulk_cache_hits counter\n";
+        sample(out, "thallium_bulk_cache_hits_total", "", static_cast<double>(cache.hits));
+        out += "# TYPE thallium_bulk_cache_misses counter\n";
+        sample(out, "thallium_bulk_cache_misses_total", "", static_cast<double>(cache.misses));
+        out += "# TYPE thallium_bulk_cache_evictions counter\n";
+        sample(out, "thallium_bulk_cache_evictions_total", "", static_cast<double>(cache.evictions));
+        out += "# TYPE thallium_bulk_cache_registered_bytes gauge\n";
+        sample(out, "thallium_bulk_cache_registered_bytes", "", static_cast<double>(cache.cached_bytes));
+
+        out += "# EOF\n";
+        return out;
+    }
+
+  private:
+
+    margo_instance_id                       m_mid;
+    double                                  m_interval_ms;
+    std::string                             m_path;
+    std::function<void(const std::string&)> m_sink;
+    std::unique_ptr<timed_callback>         m_timer;
+    std::mutex                              m_mutex;
+    bool                                    m_running = false;
+
+    static std::string escape(const std::string& s) {
+        std::string r;
+        for(char c : s) {
+            if(c == '"' || c == '\\') {
+                r += '\\';
+                r += c;
+            } else if(c == '\n') {
+                r += "\\n";
+            } else {
+                r += c;
+            }
+        }
+        return r;
+    }
+
+    static void sample(std::string& out, const char* name, const std::string& labels,
+                       double value) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), " %.17g\n", value);
+        out += name;
+        if(!labels.empty()) {
+            out += '{';
+            out += labels;
+            out += '}';
+        }
+        out += buf;
+    }
+
+    static void summary(std::string& out, const std::string& labels, const char* stage,
+                        const histogram_snapshot& h) {
+        quantiles(out, "thallium_rpc_latency_seconds",
+                  labels + ",stage=\"" + stage + "\"", h);
+    }
+
+    static void quantiles(std::string& out, const std::string& name, const std::string& l,
+                          const histogram_snapshot& h) {
+        static const double quantiles[] = {50, 90, 99, 99.9};
+        for(double q : quantiles) {
+            char ql[32];
+            std::snprintf(ql, sizeof(ql), ",quantile=\"%g\"", q / 100.0);
+            sample(out, name.c_str(), l + ql, h.percentile(q) * 1e-9);
+        }
+        sample(out, (name + "_sum").c_str(), l, static_cast<double>(h.sum) * 1e-9);
+        sample(out, (name + "_count").c_str(), l, static_cast<double>(h.count));
+    }
+
+    static std::string pool_labels(const pool_stats_entry& p) {
+        return "pool=\"" + escape(p.name.empty() ? std::to_string(p.pool_id) : p.name) + "\"";
+    }
+
+    void publish(const std::string& text) const {
+        if(m_sink) m_sink(text);
+        if(m_path.empty()) return;
+        // written next to the target and renamed over it, so that
+        // readers never see a partial file
+        std::string tmp = m_path + ".tmp";
+        FILE*       f   = std::fopen(tmp.c_str(), "w");
+        if(!f) return;
+        bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+        ok = (std::fclose(f) == 0) && ok;
+        if(ok) std::rename(tmp.c_str(), m_path.c_str());
+        else std::remove(tmp.c_str());
+    }
+
+    void tick() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_running) return;
+        }
+        publish(format(m_mid));
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_running) m_timer->start(m_interval_ms);
+    }
+
+    // stops the periodic dumps; returns false if they weren't running
+    bool stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_running) return false;
+            m_running = false;
+        }
+        try {
+            m_timer->cancel();
+        } catch(const exception&) {
+            // the callback was running and won't start the timer again
+        }
+        m_timer.reset();
+        return true;
+    }
+
+    static void on_finalize(void* arg) {
+        static_cast<metrics_exporter*>(arg)->stop();
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,402 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_MULTI_RAIL_HPP
+#define __THALLIUM_MULTI_RAIL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <thallium/async_response.hpp>
+#include <thallium/bulk.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/engine_group.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/packed_data.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_bulk.hpp>
+#include <thallium/remote_procedure.hpp>
+
+namespace thallium {
+
+class multi_rail_endpoint;
+
+/**
+ * @brief Response of an RPC sent with multi_rail_endpoint::async. The
+ * RPC counts as outstanding on its rail until it is waited on or the
+ * multi_rail_response is destroyed.
+ */
+class multi_rail_response {
+
+    friend class multi_rail_endpoint;
+
+    async_response                            m_response;
+    std::shared_ptr<std::atomic<std::size_t>> m_outstanding;
+    std::size_t                               m_rail = 0;
+
+    multi_rail_response(async_response&& response,
+                        std::shared_ptr<std::atomic<std::size_t>> outstanding,
+                        std::size_t rail)
+    : m_response(std::move(response))
+    , m_outstanding(std::move(outstanding))
+    , m_rail(rail) {}
+
+    void release() {
+        if(m_outstanding) m_outstanding->fetch_sub(1, std::memory_order_relaxed);
+        m_outstanding.reset();
+    }
+
+  public:
+
+    multi_rail_response(multi_rail_response&&)            = default;
+    multi_rail_response& operator=(multi_rail_response&& other) {
+        if(&other == this) return *this;
+        release();
+        m_response    = std::move(other.m_response);
+        m_outstanding = std::move(other.m_outstanding);
+        m_rail        = other.m_rail;
+        return *this;
+    }
+
+    ~multi_rail_response() {
+        release();
+    }
+
+    /**
+     * @brief Waits for the response (see async_response::wait).
+     */
+    packed_data<> wait() {
+        try {
+            packed_data<> result = m_response.wait();
+            release();
+            return result;
+        } catch(...) {
+            release();
+            throw;
+        }
+    }
+
+    /**
+     * @brief Returns true if the response has arrived.
+     */
+    bool received() const {
+        return m_response.received();
+    }
+
+    /**
+     * @brief Index of the rail the RPC was sent on.
+     */
+    std::size_t rail() const {
+        return m_rail;
+    }
+};
+
+/**
+ * @brief A multi_rail_endpoint is one logical peer reachable through
+ * several addresses (rails), typically a server listening on each of
+ * its NICs with an engine_group. RPCs are spread across the rails,
+ * either in round-robin order or by sending each one on the rail with
+ * the fewest RPCs in flight, and large bulk transfers are split into
+ * stripes transferred concurrently on different rails.
+ *
+ * The rails may be looked up by a single engine, or by the engines of
+ * a local engine_group (rail i by engine i modulo the group's size),
+ * so that each NIC of the client is used as well. In the latter case,
+ * RPCs are called with the remote_procedures returned by
+ * engine_group::define, the one of the rail's engine being used.
+ *
+ * \code{.cpp}
+ * tl::engine_group engines({"ofi+verbs://mlx5_0", "ofi+verbs://mlx5_1"},
+ *                          THALLIUM_CLIENT_MODE);
+ * auto put = engines.define("put");
+ * tl::multi_rail_endpoint server(engines, server_addresses, 1,
+ *     tl::multi_rail_endpoint::policy::least_outstanding);
+ * server.call(put, key, value);
+ * \endcode
+ *
+ * Unlike group_handle, whose members are equivalent servers, the
+ * rails of a multi_rail_endpoint lead to the same process, which is
+ * what allows striping a transfer of one buffer across them.
+ */
+class multi_rail_endpoint {
+
+  public:
+
+    /**
+     * @brief How RPCs are spread across rails.
+     */
+    enum class policy {
+        round_robin,      /*!< each RPC goes to the next rail */
+        least_outstanding /*!< each RPC goes to the rail with the fewest RPCs in flight */
+    };
+
+    /**
+     * @brief A rail: the peer's address and provider id on it, and the
+     * index of the local engine (in an engine_group) that reaches it.
+     */
+    struct rail {
+        provider_handle handle;
+        std::size_t     engine_index = 0;
+    };
+
+  private:
+
+    std::vector<rail>                                      m_rails;
+    std::vector<std::shared_ptr<std::atomic<std::size_t>>> m_outstanding;
+    std::shared_ptr<std::atomic<std::size_t>>              m_next =
+        std::make_shared<std::atomic<std::size_t>>(0);
+    policy                                                 m_policy = policy::round_robin;
+
+    void init() {
+        m_outstanding.reserve(m_rails.size());
+        for(std::size_t i = 0; i < m_rails.size(); i++)
+            m_outstanding.push_back(std::make_shared<std::atomic<std::size_t>>(0));
+    }
+
+    const remote_procedure& rpc_for(const std::vector<remote_procedure>& rpcs,
+                                    std::size_t i) const {
+        std::size_t e = m_rails[i].engine_index;
+        if(e >= rpcs.size())
+            throw exception("multi_rail_endpoint: no remote_procedure for the engine of rail ", i);
+        return rpcs[e];
+    }
+
+    // RAII counting of an RPC in flight on a rail
+    class in_flight {
+        std::atomic<std::size_t>& m_count;
+
+      public:
+        explicit in_flight(std::atomic<std::size_t>& count)
+        : m_count(count) {
+            m_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        ~in_flight() {
+            m_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    striped_bulk_op stripe(hg_bulk_op_t op, const std::vector<bulk>& remote,
+                           const std::vector<bulk>& local, std::size_t min_stripe_size) const;
+
+  public:
+
+    multi_rail_endpoint() = default;
+
+    /**
+     * @brief Looks up the rails with a single engine.
+     *
+     * @param e Engine of the client.
+     * @param addresses Addresses of the peer, one per rail.
+     * @param provider_id Provider id targeted on each rail.
+     * @param p How RPCs are spread across rails.
+     */
+    multi_rail_endpoint(const engine& e, const std::vector<std::string>& addresses,
+                        std::uint16_t provider_id = 0, policy p = policy::round_robin)
+    : m_policy(p) {
+        auto endpoints = e.lookup_async(addresses).wait();
+        m_rails.reserve(endpoints.size());
+        for(auto& ep : endpoints) m_rails.push_back(rail{provider_handle(std::move(ep), provider_id), 0});
+        init();
+    }
+
+    /**
+     * @brief Looks up rail i with engine i modulo the size of a local
+     * engine_group.
+     *
+     * @param engines Engines of the client.
+     * @param addresses Addresses of the peer, one per rail.
+     * @param provider_id Provider id targeted on each rail.
+     * @param p How RPCs are spread across rails.
+     */
+    multi_rail_endpoint(engine_group& engines, const std::vector<std::string>& addresses,
+                        std::uint16_t provider_id = 0, policy p = policy::round_robin)
+    : m_policy(p) {
+        m_rails.reserve(addresses.size());
+        for(std::size_t i = 0; i < addresses.size(); i++) {
+            std::size_t e = i % engines.size();
+            m_rails.push_back(rail{provider_handle(engines[e].lookup(addresses[i]), provider_id), e});
+        }
+        init();
+    }
+
+    /**
+     * @brief Builds a multi_rail_endpoint from already resolved rails.
+     */
+    explicit multi_rail_endpoint(std::vector<rail> rails, policy p = policy::round_robin)
+    : m_rails(std::move(rails))
+    , m_policy(p) {
+        init();
+    }
+
+    /**
+     * @brief Number of rails.
+     */
+    std::size_t size() const { return m_rails.size(); }
+
+    const rail& operator[](std::size_t i) const { return m_rails[i]; }
+
+    /**
+     * @brief Number of RPCs in flight on rail i.
+     */
+    std::size_t outstanding(std::size_t i) const {
+        return m_outstanding[i]->load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the index of the rail the next RPC should go to.
+     */
+    std::size_t pick() const {
+        if(m_rails.empty())
+            throw exception("Calling an RPC on an empty multi_rail_endpoint");
+        std::size_t start = m_next->fetch_add(1, std::memory_order_relaxed) % m_rails.size();
+        if(m_policy == policy::round_robin) return start;
+        // starting from the round-robin choice spreads ties across rails
+        std::size_t best = start;
+        for(std::size_t k = 1; k < m_rails.size(); k++) {
+            std::size_t i = (start + k) % m_rails.size();
+            if(outstanding(i) < outstanding(best)) best = i;
+        }
+        return best;
+    }
+
+    /**
+     * @brief Sends an RPC on the rail chosen by pick() and waits for
+     * its response. The rails must have been looked up with the engine
+     * that defined rpc.
+     */
+    template <typename... T>
+    packed_data<> call(const remote_procedure& rpc, const T&... args) const {
+        std::size_t i = pick();
+        in_flight   guard(*m_outstanding[i]);
+        return rpc.on(m_rails[i].handle)(args...);
+    }
+
+    /**
+     * @brief Same as call(rpc, args...) with the remote_procedures
+     * returned by engine_group::define, the one of the engine of the
+     * chosen rail being used.
+     */
+    template <typename... T>
+    packed_data<> call(const std::vector<remote_procedure>& rpcs, const T&... args) const {
+        std::size_t i = pick();
+        in_flight   guard(*m_outstanding[i]);
+        return rpc_for(rpcs, i).on(m_rails[i].handle)(args...);
+    }
+
+    /**
+     * @brief Sends an RPC on the rail chosen by pick() without waiting
+     * for its response.
+     */
+    template <typename... T>
+    multi_rail_response async(const remote_procedure& rpc, const T&... args) const {
+        std::size_t i = pick();
+        m_outstanding[i]->fetch_add(1, std::memory_order_relaxed);
+        try {
+            return multi_rail_response(rpc.on(m_rails[i].handle).async(args...),
+                                       m_outstanding[i], i);
+        } catch(...) {
+            m_outstanding[i]->fetch_sub(1, std::memory_order_relaxed);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Same as async(rpc, args...) with the remote_procedures
+     * returned by engine_group::define.
+     */
+    template <typename... T>
+    multi_rail_response async(const std::vector<remote_procedure>& rpcs, const T&... args) const {
+        std::size_t i = pick();
+        m_outstanding[i]->fetch_add(1, std::memory_order_relaxed);
+        try {
+            return multi_rail_response(rpc_for(rpcs, i).on(m_rails[i].handle).async(args...),
+                                       m_outstanding[i], i);
+        } catch(...) {
+            m_outstanding[i]->fetch_sub(1, std::memory_order_relaxed);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Pulls a remote buffer into a local one, split into
+     * stripes of (almost) equal sizes transferred concurrently, each on
+     * its own rail. Memory registrations are specific to a network
+     * interface, so the peer exposes its buffer on each of its engines
+     * and sends all the handles: remote[i] is the buffer exposed on the
+     * engine of rail i. Likewise local[j] is the local buffer exposed
+     * by the engine of index j in the local engine_group, or local[0]
+     * for all the rails if it has a single element.
+     *
+     * A transfer is split into as many stripes as there are rails, but
+     * no stripe is smaller than min_stripe_size, so small transfers
+     * use a single rail, chosen by pick().
+     *
+     * @param remote Handles of the remote buffer, one per rail.
+     * @param local Handles of the local buffer.
+     * @param min_stripe_size Smallest size of a stripe.
+     *
+     * @return a striped_bulk_op whose wait() returns the size transferred.
+     */
+    striped_bulk_op pull_to(const std::vector<bulk>& remote, const std::vector<bulk>& local,
+                            std::size_t min_stripe_size = 1024 * 1024) const {
+        return stripe(HG_BULK_PULL, remote, local, min_stripe_size);
+    }
+
+    /**
+     * @brief Same as pull_to, pushing the local buffer to the remote one.
+     */
+    striped_bulk_op push_from(const std::vector<bulk>& remote, const std::vector<bulk>& local,
+                              std::size_t min_stripe_size = 1024 * 1024) const {
+        return stripe(HG_BULK_PUSH, remote, local, min_stripe_size);
+    }
+};
+
+inline striped_bulk_op multi_rail_endpoint::stripe(hg_bulk_op_t op,
+        const std::vector<bulk>& remote, const std::vector<bulk>& local,
+        std::size_t min_stripe_size) const {
+    if(m_rails.empty())
+        throw exception("Transferring data with an empty multi_rail_endpoint");
+    if(remote.size() != m_rails.size())
+        throw exception("multi_rail_endpoint: expected one remote bulk per rail, got ",
+                        remote.size());
+    if(local.empty())
+        throw exception("multi_rail_endpoint: no local bulk");
+    auto local_for = [&local, this](std::size_t i) -> const bulk& {
+        if(local.size() == 1) return local[0];
+        std::size_t e = m_rails[i].engine_index;
+        if(e >= local.size())
+            throw exception("multi_rail_endpoint: no local bulk for the engine of rail ", i);
+        return local[e];
+    };
+    std::size_t size      = std::min(remote[0].size(), local[0].size());
+    std::size_t n_stripes = std::max<std::size_t>(1, size / std::max<std::size_t>(min_stripe_size, 1));
+    n_stripes             = std::min(n_stripes, m_rails.size());
+    std::size_t first     = pick();
+    striped_bulk_op result;
+    result.m_ops.reserve(n_stripes);
+    std::size_t offset = 0;
+    for(std::size_t k = 0; k < n_stripes; k++) {
+        std::size_t i      = (first + k) % m_rails.size();
+        std::size_t length = size / n_stripes + (k < size % n_stripes ? 1 : 0);
+        auto        rb     = remote[i].on(m_rails[i].handle).select(offset, length);
+        auto        lb     = local_for(i).select(offset, length);
+        if(op == HG_BULK_PULL)
+            result.m_ops.push_back(rb.pull_to(lb));
+        else
+            result.m_ops.push_back(rb.push_from(lb));
+        offset += length;
+    }
+    return result;
+}
+
+} // namespace thallium
+
+#endif
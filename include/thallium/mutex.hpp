@@ -10,6 +10,10 @@
 #include <abt.h>
 #include <thallium/abt_errors.hpp>
 #include <thallium/exception.hpp>
+#include <thallium/non_blocking.hpp>
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+#include <thallium/lock_stats.hpp>
+#endif
 
 namespace thallium {
 
@@ -42,6 +46,9 @@ class mutex_exception : public exception {
  */
 class mutex {
     ABT_mutex m_mutex;
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    detail::lock_site* m_site = nullptr;
+#endif
 
   public:
     /**
@@ -54,7 +61,14 @@ class mutex {
      *
      * @param recursive whether the mutex is recursive or not.
      */
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    explicit mutex(bool recursive = false,
+                   const char* file = THALLIUM_LOCK_SITE_FILE,
+                   int line = THALLIUM_LOCK_SITE_LINE)
+    : m_site(detail::lock_site::get(file, line, "mutex")) {
+#else
     explicit mutex(bool recursive = false) {
+#endif
         ABT_mutex_attr attr;
         TL_MUTEX_ASSERT(ABT_mutex_attr_create(&attr));
         if(recursive) {
@@ -83,6 +97,9 @@ class mutex {
         }
         m_mutex       = other.m_mutex;
         other.m_mutex = ABT_MUTEX_NULL;
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        m_site        = other.m_site;
+#endif
         return *this;
     }
 
@@ -92,6 +109,9 @@ class mutex {
     mutex(mutex&& other) noexcept {
         m_mutex       = other.m_mutex;
         other.m_mutex = ABT_MUTEX_NULL;
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        m_site        = other.m_site;
+#endif
     }
 
     /**
@@ -105,7 +125,19 @@ class mutex {
     /**
      * @brief Lock the mutex.
      */
-    void lock() { TL_MUTEX_ASSERT(ABT_mutex_lock(m_mutex)); }
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    void lock() {
+        if(ABT_mutex_trylock(m_mutex) == ABT_SUCCESS) {
+            record_lock(0, false);
+            return;
+        }
+        auto start = detail::lock_site::now();
+        lock_native();
+        record_lock(detail::lock_site::now() - start, true);
+    }
+#else
+    void lock() { lock_native(); }
+#endif
 
     /**
      * @brief Lock the mutex in low priority.
@@ -150,6 +182,29 @@ class mutex {
      * @return the underlying native handle.
      */
     ABT_mutex native_handle() const noexcept { return m_mutex; }
+
+  protected:
+    /**
+     * @brief Lock the mutex, without recording the acquisition in the
+     * lock statistics.
+     */
+    void lock_native() {
+#ifndef NDEBUG
+        // handlers running inline may take a mutex that is free
+        if(detail::running_inline() && ABT_mutex_trylock(m_mutex) == ABT_SUCCESS) return;
+#endif
+        detail::check_can_block("mutex::lock");
+        TL_MUTEX_ASSERT(ABT_mutex_lock(m_mutex));
+    }
+
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    /**
+     * @brief Record an acquisition in the lock statistics.
+     */
+    void record_lock(std::uint64_t wait_ns, bool contended) {
+        if(m_site) m_site->record(wait_ns, contended);
+    }
+#endif
 };
 
 /**
@@ -160,8 +215,14 @@ class recursive_mutex : public mutex {
     /**
      * @brief Constructor.
      */
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    recursive_mutex(const char* file = THALLIUM_LOCK_SITE_FILE,
+                    int line = THALLIUM_LOCK_SITE_LINE)
+    : mutex(true, file, line) {}
+#else
     recursive_mutex()
     : mutex(true) {}
+#endif
 
     /**
      * @brief Copy constructor is deleted.
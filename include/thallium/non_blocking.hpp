@@ -0,0 +1,74 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_NON_BLOCKING_HPP
+#define __THALLIUM_NON_BLOCKING_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Whether the calling execution stream is running an RPC handler
+ * inline in the progress loop (see rpc_execution::run_inline).
+ */
+inline bool& running_inline() {
+    static thread_local bool flag = false;
+    return flag;
+}
+
+/**
+ * @private
+ * @brief Marks the calling execution stream as running a handler inline
+ * for the lifetime of the object.
+ */
+class running_inline_scope {
+
+    bool m_previous;
+
+  public:
+
+    running_inline_scope()
+    : m_previous(running_inline()) {
+        running_inline() = true;
+    }
+
+    ~running_inline_scope() {
+        running_inline() = m_previous;
+    }
+
+    running_inline_scope(const running_inline_scope&)            = delete;
+    running_inline_scope& operator=(const running_inline_scope&) = delete;
+};
+
+/**
+ * @private
+ * @brief Aborts, unless NDEBUG is defined, if the caller is a handler
+ * running inline in the progress loop, where blocking would stall (or
+ * deadlock) the progress of every RPC.
+ */
+inline void check_can_block(const char* what) {
+#ifndef NDEBUG
+    if(running_inline()) {
+        std::fprintf(stderr,
+                     "FATAL: %s may block and was called from an RPC handler running "
+                     "inline in the progress loop (see rpc_execution::run_inline)\n",
+                     what);
+        std::abort();
+    }
+#else
+    (void)what;
+#endif
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,272 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_OPAQUE_PAYLOAD_HPP
+#define __THALLIUM_OPAQUE_PAYLOAD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <margo.h>
+#include <mercury_proc.h>
+#include <thallium/exception.hpp>
+#include <thallium/margo_exception.hpp>
+#include <thallium/serialization/cereal/archives.hpp>
+#include <thallium/serialization/stl/tuple.hpp>
+
+namespace thallium {
+
+class opaque_payload;
+template <typename ... CtxArg> class size_archive;
+
+namespace detail {
+struct opaque_payload_access;
+}
+
+/**
+ * @brief An opaque_payload, used as the last parameter of an RPC
+ * handler, receives the encoded bytes of all the arguments that follow
+ * the ones before it, without decoding them. This lets a handler make
+ * a decision based on the leading arguments only (e.g. a router looking
+ * at a shard key) and either decode the rest later with as<T...>(), or
+ * pass the opaque_payload as the last argument of another RPC, in which
+ * case its bytes are copied as-is into the new request instead of being
+ * decoded and re-encoded.
+ *
+ * \code{.cpp}
+ * // clients call put(key, value)
+ * engine.define("put", [&](const tl::request& req, uint64_t key,
+ *                          const tl::opaque_payload& value) {
+ *     if(!is_local(key)) {
+ *         req.respond(put.on(owner(key))(key, value).as<int>());
+ *         return;
+ *     }
+ *     auto v = value.as<std::vector<char>>();
+ *     ...
+ * });
+ * \endcode
+ *
+ * On the server side, the payload points into the RPC's input buffer
+ * and can only be used until the handler returns. It must be decoded
+ * and forwarded with the same serialization context as the original
+ * RPC. When forwarded, the leading arguments must be given the same
+ * types as they were sent with, so that the new request is identical
+ * to the one the client would have sent.
+ */
+class opaque_payload {
+
+    friend struct detail::opaque_payload_access;
+
+    const char*       m_data = nullptr;
+    std::size_t       m_size = 0;
+    std::vector<char> m_owned;
+    margo_instance_id m_mid  = MARGO_INSTANCE_NULL;
+    // total size of the encoded payload this one is the tail of,
+    // set before decoding
+    std::size_t       m_encoded_size = 0;
+    // type signature of the original payload, re-emitted when forwarding
+    std::uint64_t     m_signature    = 0;
+#ifdef THALLIUM_DEBUG_RPC_TYPES
+    std::string       m_type_name;
+#endif
+
+  public:
+
+    opaque_payload() = default;
+
+    opaque_payload(const opaque_payload& other)
+    : m_data(other.m_data)
+    , m_size(other.m_size)
+    , m_owned(other.m_owned)
+    , m_mid(other.m_mid)
+    , m_encoded_size(other.m_encoded_size)
+    , m_signature(other.m_signature)
+#ifdef THALLIUM_DEBUG_RPC_TYPES
+    , m_type_name(other.m_type_name)
+#endif
+    {
+        if(!m_owned.empty()) m_data = m_owned.data();
+    }
+
+    opaque_payload(opaque_payload&& other) = default;
+
+    opaque_payload& operator=(const opaque_payload& other) {
+        if(&other == this) return *this;
+        opaque_payload tmp(other);
+        *this = std::move(tmp);
+        return *this;
+    }
+
+    opaque_payload& operator=(opaque_payload&& other) = default;
+
+    /**
+     * @brief Returns a pointer to the encoded bytes.
+     */
+    const char* data() const { return m_data; }
+
+    /**
+     * @brief Returns the number of encoded bytes.
+     */
+    std::size_t size() const { return m_size; }
+
+    /**
+     * @brief Returns true if the payload has no bytes.
+     */
+    bool empty() const { return m_size == 0; }
+
+    /**
+     * @brief Copies the bytes into memory owned by the opaque_payload,
+     * so that it can outlive the request it was received with.
+     */
+    void detach() {
+        if(m_size == 0 || (!m_owned.empty() && m_data == m_owned.data())) return;
+        m_owned.assign(m_data, m_data + m_size);
+        m_data = m_owned.data();
+    }
+
+    /**
+     * @brief Decodes the payload as a T.
+     */
+    template <typename T> T as() const {
+        std::tuple<T> t;
+        unpack(t);
+        return std::move(std::get<0>(t));
+    }
+
+    /**
+     * @brief Decodes the payload as a tuple of values.
+     */
+    template <typename T1, typename T2, typename... Tn>
+    std::tuple<T1, T2, Tn...> as() const {
+        std::tuple<T1, T2, Tn...> t;
+        unpack(t);
+        return t;
+    }
+
+    template <typename A> void save(A& ar) const {
+        if(m_size == 0) return;
+        void* buf = ar.save_ptr(m_size);
+        std::memcpy(buf, m_data, m_size);
+        ar.restore_ptr(buf, m_size);
+    }
+
+    /**
+     * @brief Counts the bytes save() writes, without copying them.
+     *
+     * @param ar size_archive.
+     */
+    template <typename ... CtxArg> void save(size_archive<CtxArg...>& ar) const {
+        ar.add(m_size);
+    }
+
+    template <typename A> void load(A& ar) {
+        std::size_t used = hg_proc_get_size_used(ar.get_proc());
+        if(m_encoded_size < used)
+            throw exception("opaque_payload can only be received as the last argument of an RPC handler");
+        m_owned.clear();
+        m_mid  = ar.get_engine().get_margo_instance();
+        m_size = m_encoded_size - used;
+        m_data = nullptr;
+        if(m_size == 0) return;
+        void* buf = ar.save_ptr(m_size);
+        m_data    = static_cast<const char*>(buf);
+        ar.restore_ptr(buf, m_size);
+    }
+
+  private:
+
+    template <typename Tuple> void unpack(Tuple& t) const;
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Access to the opaque_payload ending a tuple of arguments, if
+ * any, used by proc_object_encode/decode.
+ */
+struct opaque_payload_access {
+
+    static opaque_payload* get(opaque_payload& p) { return &p; }
+    static const opaque_payload* get(const std::reference_wrapper<const opaque_payload>& p) {
+        return &p.get();
+    }
+    static const opaque_payload* get(const std::reference_wrapper<opaque_payload>& p) {
+        return &p.get();
+    }
+    template <typename T> static std::nullptr_t get(const T&) { return nullptr; }
+
+    template <typename T> static std::nullptr_t tail(T&) { return nullptr; }
+
+    static std::nullptr_t tail(std::tuple<>&) { return nullptr; }
+
+    template <typename... T> static auto tail(std::tuple<T...>& t)
+        -> decltype(get(std::get<sizeof...(T) - 1>(t))) {
+        return get(std::get<sizeof...(T) - 1>(t));
+    }
+
+    static void set_encoded_size(std::nullptr_t, std::size_t) {}
+    static void set_encoded_size(opaque_payload* p, std::size_t n) { p->m_encoded_size = n; }
+
+    static void set_signature(std::nullptr_t, std::uint64_t) {}
+    static void set_signature(opaque_payload* p, std::uint64_t s) { p->m_signature = s; }
+
+    static std::uint64_t signature(std::nullptr_t, std::uint64_t def) { return def; }
+    static std::uint64_t signature(const opaque_payload* p, std::uint64_t def) {
+        return p->m_signature ? p->m_signature : def;
+    }
+
+    static void detach(std::nullptr_t) {}
+    static void detach(opaque_payload* p) { p->detach(); }
+
+#ifdef THALLIUM_DEBUG_RPC_TYPES
+    static void set_type_name(std::nullptr_t, const std::string&) {}
+    static void set_type_name(opaque_payload* p, const std::string& n) { p->m_type_name = n; }
+
+    static std::string type_name(std::nullptr_t, std::string def) { return def; }
+    static std::string type_name(const opaque_payload* p, std::string def) {
+        return p->m_type_name.empty() ? def : p->m_type_name;
+    }
+#endif
+};
+
+/**
+ * @private
+ * @brief Whether a tuple of arguments to decode ends with an opaque_payload.
+ */
+template <typename T>
+struct ends_with_opaque_payload
+: std::integral_constant<bool,
+    !std::is_same<decltype(opaque_payload_access::tail(std::declval<T&>())),
+                  std::nullptr_t>::value> {};
+
+} // namespace detail
+
+template <typename Tuple> void opaque_payload::unpack(Tuple& t) const {
+    if(m_mid == MARGO_INSTANCE_NULL)
+        throw exception("Cannot decode an opaque_payload that was not received");
+    hg_proc_t   proc = HG_PROC_NULL;
+    hg_return_t ret  = hg_proc_create_set(margo_get_class(m_mid), const_cast<char*>(m_data),
+                                          m_size, HG_DECODE, HG_NOHASH, &proc);
+    MARGO_ASSERT(ret, hg_proc_create_set);
+    try {
+        std::tuple<> ctx;
+        proc_input_archive<> ar(proc, ctx, m_mid);
+        ar(t);
+    } catch(...) {
+        hg_proc_free(proc);
+        throw;
+    }
+    hg_proc_free(proc);
+}
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,295 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_ORDERED_SESSION_HPP
+#define __THALLIUM_ORDERED_SESSION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <thallium/async_response.hpp>
+#include <thallium/function_util.hpp>
+#include <thallium/mutex.hpp>
+#include <thallium/packed_data.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/tuple_util.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Identifies an RPC sent through an ordered_session: the
+ * session it belongs to and its rank in the session. It is sent as the
+ * first argument of the RPC.
+ */
+struct session_stamp {
+    std::uint64_t session = 0;
+    std::uint64_t seq     = 0;
+
+    template <typename A> void serialize(A& ar) {
+        ar(session, seq);
+    }
+};
+
+/**
+ * @brief An ordered_session sends RPCs to a provider that must be
+ * processed in the order they were issued (e.g. appends to a log),
+ * without waiting for the response to one before sending the next:
+ * each RPC is stamped with a sequence number, and the handler, defined
+ * with in_session_order, runs them in that order whatever the order in
+ * which they arrive and are scheduled. Ordering thus costs one round
+ * trip for a whole window of calls rather than one per call.
+ *
+ * \code{.cpp}
+ * // server
+ * engine.define("append", tl::in_session_order(
+ *     [&log](const tl::request& req, const std::string& entry) {
+ *         req.respond(log.append(entry));
+ *     }), provider_id);
+ * // client
+ * tl::ordered_session session(tl::provider_handle(engine.lookup(addr), provider_id));
+ * std::vector<tl::async_response> pending;
+ * for(auto& entry : entries) pending.push_back(session.async(append, entry));
+ * for(auto& r : pending) offsets.push_back(r.wait());
+ * \endcode
+ *
+ * Calls are ordered within a session, not across sessions. A call that
+ * fails to be sent does not take a sequence number, but a call that is
+ * sent and lost (e.g. dropped by a timeout on the server side) leaves a
+ * gap that holds up the following calls of the session; such a session
+ * should be replaced by a new one. The server forgets sessions idle for
+ * longer than the idle timeout of in_session_order, so a session left
+ * idle for longer than its own idle timeout (which must be shorter)
+ * starts over under a new identifier.
+ */
+class ordered_session {
+
+    provider_handle                       m_handle;
+    std::chrono::steady_clock::duration   m_idle_timeout;
+    std::uint64_t                         m_id;
+    std::uint64_t                         m_next = 0;
+    std::chrono::steady_clock::time_point m_last_sent;
+    mutex                                 m_mutex;
+
+    static std::uint64_t make_id() {
+        static std::atomic<std::uint64_t> counter{0};
+        std::random_device rd;
+        std::uint64_t id = (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+        id ^= static_cast<std::uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+        return id ^ (counter.fetch_add(1) * 0x9E3779B97F4A7C15ULL);
+    }
+
+  public:
+
+    /**
+     * @brief Creates a session sending RPCs to the provided provider.
+     *
+     * @param ph Provider handle.
+     * @param idle_timeout Time without calls after which the session
+     * starts over under a new identifier.
+     */
+    explicit ordered_session(const provider_handle& ph,
+                             std::chrono::steady_clock::duration idle_timeout
+                                = std::chrono::minutes(5))
+    : m_handle(ph)
+    , m_idle_timeout(idle_timeout)
+    , m_id(make_id())
+    , m_last_sent(std::chrono::steady_clock::now()) {}
+
+    ordered_session(const ordered_session&)            = delete;
+    ordered_session& operator=(const ordered_session&) = delete;
+
+    /**
+     * @brief Sends an RPC of the session without waiting for its
+     * response. The RPC must be defined with in_session_order on the
+     * server.
+     *
+     * @param rpc Remote procedure.
+     * @param args Arguments.
+     *
+     * @return an async_response to wait on.
+     */
+    template <typename... T>
+    async_response async(const remote_procedure& rpc, const T&... args) {
+        // the sequence number is only taken once the call is sent
+        std::lock_guard<mutex> lock(m_mutex);
+        auto now = std::chrono::steady_clock::now();
+        if(m_next != 0 && now - m_last_sent > m_idle_timeout) {
+            m_id   = make_id();
+            m_next = 0;
+        }
+        async_response r = rpc.on(m_handle).async(session_stamp{m_id, m_next}, args...);
+        m_next     += 1;
+        m_last_sent = now;
+        return r;
+    }
+
+    /**
+     * @brief Sends an RPC of the session and waits for its response.
+     */
+    template <typename... T>
+    packed_data<> call(const remote_procedure& rpc, const T&... args) {
+        return async(rpc, args...).wait();
+    }
+
+    /**
+     * @brief Returns the identifier of the session.
+     */
+    std::uint64_t id() {
+        std::lock_guard<mutex> lock(m_mutex);
+        return m_id;
+    }
+
+    /**
+     * @brief Returns the provider handle of the session.
+     */
+    const provider_handle& get_provider_handle() const {
+        return m_handle;
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Reorder buffers of the sessions calling a handler defined with
+ * in_session_order. The calls of a session that arrive before their
+ * turn are parked in its buffer; the handler ULT running the next
+ * expected call then also runs the parked calls that follow it.
+ */
+class session_reorder_buffers {
+
+    struct session {
+        std::uint64_t                                   next     = 0;
+        bool                                            draining = false;
+        std::map<std::uint64_t, std::function<void()>> parked;
+        std::chrono::steady_clock::time_point           last_used;
+    };
+
+    std::mutex                                   m_mutex;
+    std::unordered_map<std::uint64_t, session>   m_sessions;
+    std::chrono::steady_clock::duration          m_idle_timeout;
+    std::chrono::steady_clock::time_point        m_last_sweep;
+
+    // removes sessions without parked calls that have been idle for too long
+    void sweep(std::chrono::steady_clock::time_point now) {
+        if(now - m_last_sweep < m_idle_timeout) return;
+        m_last_sweep = now;
+        for(auto it = m_sessions.begin(); it != m_sessions.end();) {
+            const session& s = it->second;
+            if(!s.draining && s.parked.empty() && now - s.last_used > m_idle_timeout)
+                it = m_sessions.erase(it);
+            else
+                ++it;
+        }
+    }
+
+  public:
+
+    explicit session_reorder_buffers(std::chrono::steady_clock::duration idle_timeout)
+    : m_idle_timeout(idle_timeout)
+    , m_last_sweep(std::chrono::steady_clock::now()) {}
+
+    void submit(const session_stamp& stamp, std::function<void()> call) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto now = std::chrono::steady_clock::now();
+        sweep(now);
+        session& s  = m_sessions[stamp.session];
+        s.last_used = now;
+        if(stamp.seq < s.next) {
+            // a call resent after its turn: there is nothing left to order it with
+            lock.unlock();
+            call();
+            return;
+        }
+        s.parked[stamp.seq] = std::move(call);
+        if(s.draining) return;
+        s.draining = true;
+        std::exception_ptr error;
+        while(!s.parked.empty() && s.parked.begin()->first == s.next) {
+            std::function<void()> f = std::move(s.parked.begin()->second);
+            s.parked.erase(s.parked.begin());
+            lock.unlock();
+            try {
+                f();
+            } catch(...) {
+                if(!error) error = std::current_exception();
+            }
+            lock.lock();
+            s.next += 1;
+        }
+        s.draining  = false;
+        s.last_used = std::chrono::steady_clock::now();
+        lock.unlock();
+        if(error) std::rethrow_exception(error);
+    }
+};
+
+template <typename Signature> struct in_session_order_handler;
+
+template <typename Req, typename... A>
+struct in_session_order_handler<void(Req, A...)> {
+
+    using request_type  = typename std::decay<Req>::type;
+    using function_type =
+        std::function<void(const request_type&, session_stamp, typename std::decay<A>::type...)>;
+
+    template <typename F>
+    static function_type make(F&& f, std::chrono::steady_clock::duration idle_timeout) {
+        auto buffers = std::make_shared<session_reorder_buffers>(idle_timeout);
+        auto fun     = std::make_shared<typename std::decay<F>::type>(std::forward<F>(f));
+        return [buffers, fun](const request_type& req, session_stamp stamp,
+                              typename std::decay<A>::type... args) {
+            // the call may run in the ULT of another request of the
+            // session, after this one returned, so it owns its arguments
+            auto call = [fun, req, t = std::make_tuple(std::move(args)...)]() mutable {
+                apply_function_to_forwarded_tuple<A...>(
+                    [&fun, &req](auto&&... a) {
+                        (*fun)(req, std::forward<decltype(a)>(a)...);
+                    }, t);
+            };
+            buffers->submit(stamp, std::move(call));
+        };
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Wraps an RPC handler so that the calls of each ordered_session
+ * run in the order they were issued: the returned function, to pass to
+ * engine::define or provider::define, takes a session_stamp before the
+ * arguments of f. A call arriving before its predecessors is parked
+ * (which does not occupy its handler ULT) and run, after them, by the
+ * handler ULT of the call preceding it.
+ *
+ * @param f Handler taking a request followed by the arguments of the RPC.
+ * @param idle_timeout Time after which the state of a session without
+ * pending calls is forgotten. It must be longer than the idle timeout
+ * of the clients' ordered_session.
+ *
+ * @return a handler for engine::define.
+ */
+template <typename F>
+typename detail::in_session_order_handler<typename function_signature<F>::type>::function_type
+in_session_order(F&& f, std::chrono::steady_clock::duration idle_timeout = std::chrono::minutes(10)) {
+    return detail::in_session_order_handler<typename function_signature<F>::type>::make(
+        std::forward<F>(f), idle_timeout);
+}
+
+} // namespace thallium
+
+#endif
@@ -6,6 +6,8 @@
 #ifndef __THALLIUM_PACKED_RESPONSE_HPP
 #define __THALLIUM_PACKED_RESPONSE_HPP
 
+#include <thallium/decode_arena.hpp>
+#include <thallium/local_dispatch.hpp>
 #include <thallium/margo_exception.hpp>
 #include <thallium/proc_object.hpp>
 #include <thallium/serialization/proc_input_archive.hpp>
@@ -17,6 +19,7 @@ namespace thallium {
 
 template<typename ... CtxArg> class callable_remote_procedure_with_context;
 class async_response;
+class cached_procedure;
 template<typename ... CtxArg> class request_with_context;
 using request = request_with_context<>;
 
@@ -27,6 +30,7 @@ using request = request_with_context<>;
 template<typename ... CtxArg>
 class packed_data {
     friend class async_response;
+    friend class cached_procedure;
     template<typename ... CtxArg2> friend class callable_remote_procedure_with_context;
     template<typename ... CtxArg2> friend class request_with_context;
     template<typename ... CtxArg2> friend class packed_data;;
@@ -37,6 +41,31 @@ class packed_data {
     hg_return_t (*m_unpack_fn)(hg_handle_t,void*) = nullptr;
     hg_return_t (*m_free_fn)(hg_handle_t,void*) = nullptr;
     mutable std::tuple<CtxArg...> m_context;
+    // response handed by value by the handler of an RPC sent by the
+    // engine to itself, instead of being serialized into the handle
+    std::shared_ptr<detail::local_response> m_local;
+
+    /**
+     * @brief Unpacks the content into t, from the handle or from the
+     * local response if there is one, moving the values out of the
+     * latter if move is true and no other packed_data shares it.
+     */
+    template <typename Tuple>
+    void decode_into(Tuple& t, bool move = false) const {
+        if(m_local) {
+            hg_return_t ret = detail::unpack_local_response(
+                *m_local, t, m_mid, m_context, move && m_local.use_count() == 1);
+            MARGO_ASSERT(ret, unpack_local_response);
+            return;
+        }
+        meta_proc_fn mproc = [this, &t](hg_proc_t proc) {
+            return proc_object_decode(proc, t, m_mid, m_context);
+        };
+        hg_return_t ret = m_unpack_fn(m_handle, &mproc);
+        MARGO_ASSERT(ret, m_unpack_fn);
+        ret = m_free_fn(m_handle, &mproc);
+        MARGO_ASSERT(ret, m_free_fn);
+    }
 
     /**
      * @brief Constructor. Made private since packed_data
@@ -52,10 +81,41 @@ class packed_data {
     , m_unpack_fn(unpack_fn)
     , m_free_fn(free_fn)
     , m_context(std::move(ctx)) {
+        // local calls run in the caller's ULT have no handle
+        if(h == HG_HANDLE_NULL) return;
         hg_return_t ret = margo_ref_incr(h);
         MARGO_ASSERT(ret, margo_ref_incr);
     }
 
+    template <typename T> T as_impl(bool move) const {
+        if(m_handle == HG_HANDLE_NULL && !m_local) {
+            throw exception(
+                "Cannot unpack data from handle. Are you trying to "
+                "unpack data from an RPC that does not return any?");
+        }
+        // std::pmr values are decoded into the decode_arena passed as
+        // serialization context, if any
+        detail::arena_decoded_t<std::tuple<T>> decoded(detail::find_decode_arena(m_context));
+        auto& t = decoded.value;
+        decode_into(t, move);
+        return std::get<0>(std::move(t));
+    }
+
+    template <typename T1, typename T2, typename... Tn> auto as_impl(bool move) const {
+        if(m_handle == HG_HANDLE_NULL && !m_local) {
+            throw exception(
+                "Cannot unpack data from handle. Are you trying to "
+                "unpack data from an RPC that does not return any?");
+        }
+        detail::arena_decoded_t<
+            std::tuple<typename std::decay<T1>::type, typename std::decay<T2>::type,
+                       typename std::decay<Tn>::type...>>
+                     decoded(detail::find_decode_arena(m_context));
+        auto& t = decoded.value;
+        decode_into(t, move);
+        return std::move(t);
+    }
+
   public:
     packed_data() = default;
     packed_data(const packed_data&)            = delete;
@@ -66,7 +126,8 @@ class packed_data {
     , m_handle(std::exchange(other.m_handle, HG_HANDLE_NULL))
     , m_unpack_fn(std::exchange(other.m_unpack_fn, nullptr))
     , m_free_fn(std::exchange(other.m_free_fn, nullptr))
-    , m_context(std::move(other.m_context)) {}
+    , m_context(std::move(other.m_context))
+    , m_local(std::move(other.m_local)) {}
 
     packed_data& operator=(packed_data&& rhs) {
         if(&rhs == this) return *this;
@@ -80,6 +141,8 @@ class packed_data {
         m_handle    = std::exchange(rhs.m_handle, HG_HANDLE_NULL);
         m_unpack_fn = std::exchange(rhs.m_unpack_fn, nullptr);
         m_free_fn   = std::exchange(rhs.m_free_fn, nullptr);
+        m_local     = std::move(rhs.m_local);
+        return *this;
     }
 
     ~packed_data() {
@@ -102,9 +165,11 @@ class packed_data {
      */
     template<typename ... NewCtxArg>
     auto with_serialization_context(NewCtxArg&&... args) {
-        return packed_data<unwrap_decay_t<NewCtxArg>...>(
+        auto result = packed_data<unwrap_decay_t<NewCtxArg>...>(
             m_unpack_fn, m_free_fn, m_handle, m_mid,
             std::make_tuple<NewCtxArg...>(std::forward<NewCtxArg>(args)...));
+        result.m_local = m_local;
+        return result;
     }
 
     /**
@@ -114,22 +179,14 @@ class packed_data {
      *
      * @return Buffer converted into the desired type.
      */
-    template <typename T> T as() const {
-        if(m_handle == HG_HANDLE_NULL) {
-            throw exception(
-                "Cannot unpack data from handle. Are you trying to "
-                "unpack data from an RPC that does not return any?");
-        }
-        std::tuple<T> t;
-        meta_proc_fn  mproc = [this, &t](hg_proc_t proc) {
-            return proc_object_decode(proc, t, m_mid, m_context);
-        };
-        hg_return_t ret = m_unpack_fn(m_handle, &mproc);
-        MARGO_ASSERT(ret, m_unpack_fn);
-        ret = margo_free_output(m_handle, &mproc);
-        MARGO_ASSERT(ret, m_free_fn);
-        return std::get<0>(std::move(t));
-    }
+    template <typename T> T as() const& { return as_impl<T>(false); }
+
+    /**
+     * @brief Same as above, but the values a handler of an RPC the
+     * engine sent to itself responded with are moved out of the
+     * packed_data instead of being copied.
+     */
+    template <typename T> T as() && { return as_impl<T>(true); }
 
     /**
      * @brief Converts the content of the buffer into a std::tuple
@@ -146,23 +203,16 @@ class packed_data {
      *
      * @return buffer content converted into the desired std::tuple.
      */
-    template <typename T1, typename T2, typename... Tn> auto as() const {
-        if(m_handle == HG_HANDLE_NULL) {
-            throw exception(
-                "Cannot unpack data from handle. Are you trying to "
-                "unpack data from an RPC that does not return any?");
-        }
-        std::tuple<typename std::decay<T1>::type, typename std::decay<T2>::type,
-                   typename std::decay<Tn>::type...>
-                     t;
-        meta_proc_fn mproc = [this, &t](hg_proc_t proc) {
-            return proc_object_decode(proc, t, m_mid, m_context);
-        };
-        hg_return_t ret = m_unpack_fn(m_handle, &mproc);
-        MARGO_ASSERT(ret, m_unpack_fn);
-        ret = m_free_fn(m_handle, &mproc);
-        MARGO_ASSERT(ret, m_free_fn);
-        return t;
+    template <typename T1, typename T2, typename... Tn> auto as() const& {
+        return as_impl<T1, T2, Tn...>(false);
+    }
+
+    /**
+     * @brief Same as above, moving the values out of the response to an
+     * RPC the engine sent to itself.
+     */
+    template <typename T1, typename T2, typename... Tn> auto as() && {
+        return as_impl<T1, T2, Tn...>(true);
     }
 
     /**
@@ -174,32 +224,57 @@ class packed_data {
      *
      * @return An object of the desired type.
      */
-    template <typename T> operator T() const { return as<T>(); }
+    template <typename T> operator T() const& { return as_impl<T>(false); }
 
     /**
-     * @brief Unpack the data into a provided set of arguments.
-     * This function is preferable to as<T> or to casting into
-     * the resulting type in cases where the resulting type
-     * cannot be easily moved, or the caller already has an instance
-     * of it that needs to be set.
+     * @brief Same as above, moving the values out of the response to an
+     * RPC the engine sent to itself, as when the result of a call is
+     * assigned directly.
+     */
+    template <typename T> operator T() && { return as_impl<T>(true); }
+
+    /**
+     * @brief Decodes the data into existing objects, reusing their
+     * storage: vectors and strings are resized rather than rebuilt, the
+     * elements already in a vector are decoded in place (only those past
+     * its previous size are constructed), and vectors of types for which
+     * is_trivially_serializable holds are filled with a single copy.
+     * A client decoding a response of the same shape on every call thus
+     * stops allocating once its objects have reached their largest size.
+     *
+     * \code{.cpp}
+     * std::vector<record> records;
+     * while(polling) {
+     *     poll.on(server)().unpack_into(records);
+     *     process(records);
+     * }
+     * \endcode
      *
      * @tparam T Types into which to unpack.
      * @param x Objects into which to unpack.
      */
-    template <typename... T> void unpack(T&... x) const {
-        if(m_handle == HG_HANDLE_NULL) {
+    template <typename... T> void unpack_into(T&... x) const {
+        if(m_handle == HG_HANDLE_NULL && !m_local) {
             throw exception(
                 "Cannot unpack data from handle. Are you trying to "
                 "unpack data from an RPC that does not return any?");
         }
         auto t = std::make_tuple(std::ref(x)...);
-        meta_proc_fn mproc = [this, &t](hg_proc_t proc) {
-            return proc_object_decode(proc, t, m_mid, m_context);
-        };
-        hg_return_t ret = m_unpack_fn(m_handle, &mproc);
-        MARGO_ASSERT(ret, m_unpack_fn);
-        ret = m_free_fn(m_handle, &mproc);
-        MARGO_ASSERT(ret, m_free_fn);
+        decode_into(t);
+    }
+
+    /**
+     * @brief Unpack the data into a provided set of arguments.
+     * This function is preferable to as<T> or to casting into
+     * the resulting type in cases where the resulting type
+     * cannot be easily moved, or the caller already has an instance
+     * of it that needs to be set (see unpack_into).
+     *
+     * @tparam T Types into which to unpack.
+     * @param x Objects into which to unpack.
+     */
+    template <typename... T> void unpack(T&... x) const {
+        unpack_into(x...);
     }
 };
 
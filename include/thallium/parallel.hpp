@@ -0,0 +1,218 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_PARALLEL_HPP
+#define __THALLIUM_PARALLEL_HPP
+
+#include <abt.h>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <thallium/abt_errors.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/pool.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief State shared by all the ULTs of a parallel_for/parallel_reduce.
+ * It lives on the stack of the calling ULT, which returns only once
+ * all the ULTs have completed.
+ */
+template <typename T, typename Leaf, typename Combine>
+struct parallel_job {
+    const std::vector<pool>& pools;
+    std::size_t              grain;
+    std::size_t              max_queued;
+    const T&                 identity;
+    Leaf&                    leaf;
+    Combine&                 combine;
+    std::mutex               error_mutex;
+    std::exception_ptr       error;
+
+    parallel_job(const std::vector<pool>& p, std::size_t g, std::size_t q,
+                 const T& id, Leaf& l, Combine& c)
+    : pools(p), grain(g), max_queued(q), identity(id), leaf(l), combine(c) {}
+
+    void set_error() {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if(!error) error = std::current_exception();
+    }
+
+    T run(std::size_t begin, std::size_t end,
+          std::size_t pool_begin, std::size_t pool_end);
+};
+
+template <typename T, typename Leaf, typename Combine>
+struct parallel_range {
+    parallel_job<T, Leaf, Combine>* job;
+    std::size_t                     begin, end, pool_begin, pool_end;
+    T                               result;
+    ABT_eventual                    done;
+
+    static void entry(void* arg) {
+        auto r    = static_cast<parallel_range*>(arg);
+        r->result = r->job->run(r->begin, r->end, r->pool_begin, r->pool_end);
+        ABT_eventual_set(r->done, nullptr, 0);
+    }
+};
+
+// Splits [begin, end) in two until it is no larger than the grain. The
+// right half is handed to a new ULT in the first pool of the right half
+// of [pool_begin, pool_end) (or in the only pool of the range), while
+// the calling ULT recurses on the left half and then waits for the
+// right one. A half is run inline instead when its target pool already
+// holds max_queued units, so that splitting adapts to how busy the
+// pools are.
+template <typename T, typename Leaf, typename Combine>
+T parallel_job<T, Leaf, Combine>::run(std::size_t begin, std::size_t end,
+                                      std::size_t pool_begin, std::size_t pool_end) {
+    if(end - begin <= grain) {
+        try {
+            return leaf(begin, end);
+        } catch(...) {
+            set_error();
+            return identity;
+        }
+    }
+    std::size_t mid        = begin + (end - begin)/2;
+    std::size_t pool_mid   = pool_end - pool_begin > 1 ? (pool_begin + pool_end)/2 : pool_begin;
+    std::size_t left_end   = pool_end - pool_begin > 1 ? pool_mid : pool_end;
+    const pool& target     = pools[pool_mid];
+    using range_type       = parallel_range<T, Leaf, Combine>;
+    range_type right{this, mid, end, pool_mid, pool_end, identity, ABT_EVENTUAL_NULL};
+    bool spawned = false;
+    std::size_t queued = 0;
+    if(ABT_pool_get_size(target.native_handle(), &queued) == ABT_SUCCESS
+    && queued < max_queued
+    && ABT_eventual_create(0, &right.done) == ABT_SUCCESS) {
+        spawned = ABT_thread_create(target.native_handle(), &range_type::entry,
+                                    &right, ABT_THREAD_ATTR_NULL, nullptr) == ABT_SUCCESS;
+        if(!spawned) ABT_eventual_free(&right.done);
+    }
+    T left = run(begin, mid, pool_begin, left_end);
+    if(spawned) {
+        ABT_eventual_wait(right.done, nullptr);
+        ABT_eventual_free(&right.done);
+    } else {
+        right.result = run(mid, end, pool_mid, pool_end);
+    }
+    try {
+        return combine(std::move(left), std::move(right.result));
+    } catch(...) {
+        set_error();
+        return identity;
+    }
+}
+
+struct parallel_nothing {};
+
+template <typename T, typename Leaf, typename Combine>
+T parallel_execute(const std::vector<pool>& pools, std::size_t begin, std::size_t end,
+                   std::size_t grain, const T& identity, Leaf& leaf, Combine& combine) {
+    if(pools.empty())
+        throw exception("parallel algorithms require at least one pool");
+    if(end <= begin) return identity;
+    if(grain == 0) {
+        // a few ranges per pool so that imbalance can be absorbed
+        grain = (end - begin + 4*pools.size() - 1) / (4*pools.size());
+        if(grain == 0) grain = 1;
+    }
+    parallel_job<T, Leaf, Combine> job(pools, grain, 4*pools.size(), identity, leaf, combine);
+    T result = job.run(begin, end, 0, pools.size());
+    if(job.error) std::rethrow_exception(job.error);
+    return result;
+}
+
+} // namespace detail
+
+/**
+ * @brief Calls fn(i) for each i in [begin, end), in parallel over a set
+ * of pools. The range is split recursively, the halves being handed to
+ * new ULTs in different pools, until ranges are no larger than grain
+ * indices; a grain of 0 picks one that yields a few ranges per pool.
+ * Splitting stops early when the target pools are busy.
+ *
+ * This function must be called from a ULT, which blocks until all the
+ * calls have completed. If any call throws, the first exception is
+ * rethrown once all the ULTs have completed.
+ *
+ * @param pools Pools in which to create ULTs.
+ * @param begin Beginning of the range.
+ * @param end End of the range.
+ * @param grain Maximum number of indices handled sequentially.
+ * @param fn Function taking an std::size_t.
+ */
+template <typename F>
+void parallel_for(const std::vector<pool>& pools, std::size_t begin, std::size_t end,
+                  std::size_t grain, F&& fn) {
+    auto leaf = [&fn](std::size_t b, std::size_t e) {
+        for(std::size_t i = b; i < e; i++) fn(i);
+        return detail::parallel_nothing{};
+    };
+    auto combine = [](detail::parallel_nothing, detail::parallel_nothing) {
+        return detail::parallel_nothing{};
+    };
+    detail::parallel_execute(pools, begin, end, grain, detail::parallel_nothing{},
+                             leaf, combine);
+}
+
+/**
+ * @brief Same as parallel_for(pools, begin, end, grain, fn) using a
+ * single pool.
+ */
+template <typename F>
+void parallel_for(const pool& p, std::size_t begin, std::size_t end,
+                  std::size_t grain, F&& fn) {
+    parallel_for(std::vector<pool>{p}, begin, end, grain, std::forward<F>(fn));
+}
+
+/**
+ * @brief Computes combine(...combine(combine(identity, fn(begin)),
+ * fn(begin+1))..., fn(end-1)) in parallel over a set of pools, splitting
+ * the range in the same way as parallel_for. combine must be associative
+ * and identity must be its neutral element.
+ *
+ * @param pools Pools in which to create ULTs.
+ * @param begin Beginning of the range.
+ * @param end End of the range.
+ * @param grain Maximum number of indices handled sequentially.
+ * @param identity Neutral element of combine.
+ * @param fn Function taking an std::size_t and returning a T.
+ * @param combine Function taking two T and returning a T.
+ *
+ * @return the result of the reduction.
+ */
+template <typename T, typename F, typename C>
+T parallel_reduce(const std::vector<pool>& pools, std::size_t begin, std::size_t end,
+                  std::size_t grain, const T& identity, F&& fn, C&& combine) {
+    auto leaf = [&fn, &combine, &identity](std::size_t b, std::size_t e) {
+        T acc = identity;
+        for(std::size_t i = b; i < e; i++) acc = combine(std::move(acc), fn(i));
+        return acc;
+    };
+    return detail::parallel_execute(pools, begin, end, grain, identity, leaf, combine);
+}
+
+/**
+ * @brief Same as parallel_reduce(pools, begin, end, grain, identity, fn,
+ * combine) using a single pool.
+ */
+template <typename T, typename F, typename C>
+T parallel_reduce(const pool& p, std::size_t begin, std::size_t end,
+                  std::size_t grain, const T& identity, F&& fn, C&& combine) {
+    return parallel_reduce(std::vector<pool>{p}, begin, end, grain, identity,
+                           std::forward<F>(fn), std::forward<C>(combine));
+}
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_PEER_MONITOR_HPP
+#define __THALLIUM_PEER_MONITOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <margo.h>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+/**
+ * @brief This exception is thrown when waiting for the response of an
+ * RPC sent to a peer that a failure_detector declared failed, either
+ * while the RPC was in flight or before it was sent.
+ */
+class peer_failure : public std::exception {
+  public:
+    virtual const char* what() const throw() { return "Peer was declared failed"; }
+};
+
+namespace detail {
+
+struct peer_state;
+
+/**
+ * @private
+ * @brief RPC in flight to a peer watched by a failure_detector.
+ */
+struct peer_call {
+    hg_handle_t                 handle = HG_HANDLE_NULL;
+    std::atomic<bool>           failed{false};
+    std::shared_ptr<peer_state> peer;
+};
+
+/**
+ * @private
+ * @brief A peer watched by a failure_detector: its address, the time
+ * it was last heard of (a response to any RPC counts), and the RPCs in
+ * flight to it.
+ */
+struct peer_state {
+    hg_addr_t                     addr = HG_ADDR_NULL;
+    std::string                   address;
+    std::atomic<std::int64_t>     last_heard_ns{0};
+    std::atomic<bool>             dead{false};
+    std::mutex                    mutex;
+    std::unordered_set<peer_call*> calls;
+};
+
+/**
+ * @private
+ * @brief Peers watched by the failure_detector of a margo instance.
+ * async_response registers the RPCs it sends to them, so that the
+ * detector can fail them as soon as their peer is declared failed, and
+ * so that their responses count as heartbeats.
+ */
+class peer_monitor : public per_instance<peer_monitor> {
+
+    margo_instance_id                        m_mid;
+    std::mutex                               m_mutex;
+    std::vector<std::shared_ptr<peer_state>> m_peers;
+
+    std::shared_ptr<peer_state> peer_of(hg_addr_t addr) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto& p : m_peers)
+            if(margo_addr_cmp(m_mid, p->addr, addr)) return p;
+        return nullptr;
+    }
+
+  public:
+
+    explicit peer_monitor(margo_instance_id mid)
+    : m_mid(mid) {}
+
+    peer_monitor(const peer_monitor&)            = delete;
+    peer_monitor& operator=(const peer_monitor&) = delete;
+
+    static std::int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void add(std::shared_ptr<peer_state> p) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_peers.push_back(std::move(p));
+    }
+
+    void remove(const std::shared_ptr<peer_state>& p) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_peers.erase(std::remove(m_peers.begin(), m_peers.end(), p), m_peers.end());
+    }
+
+    /**
+     * @brief Registers the RPC forwarded with handle h if it was sent
+     * to a watched peer, and returns it (nullptr otherwise). If the
+     * peer has already been declared failed, the RPC is cancelled.
+     */
+    static std::shared_ptr<peer_call> track(margo_instance_id mid, hg_handle_t h) {
+        auto monitor = find(mid);
+        if(!monitor) return nullptr;
+        const struct hg_info* info = margo_get_info(h);
+        if(!info || info->addr == HG_ADDR_NULL) return nullptr;
+        auto peer = monitor->peer_of(info->addr);
+        if(!peer) return nullptr;
+        auto call    = std::make_shared<peer_call>();
+        call->handle = h;
+        call->peer   = peer;
+        std::lock_guard<std::mutex> lock(peer->mutex);
+        if(peer->dead) {
+            call->failed = true;
+            HG_Cancel(h);
+        } else {
+            peer->calls.insert(call.get());
+        }
+        return call;
+    }
+
+    /**
+     * @brief Unregisters a completed RPC. A successful response counts
+     * as a heartbeat of the peer; an RPC cancelled because the peer
+     * failed gets HG_HOSTUNREACH as status.
+     */
+    static void release(std::shared_ptr<peer_call>& call, hg_return_t& ret) {
+        if(!call) return;
+        {
+            std::lock_guard<std::mutex> lock(call->peer->mutex);
+            call->peer->calls.erase(call.get());
+        }
+        if(ret == HG_SUCCESS)
+            call->peer->last_heard_ns = now_ns();
+        else if(ret == HG_CANCELED && call->failed)
+            ret = HG_HOSTUNREACH;
+        call.reset();
+    }
+
+    /**
+     * @brief Whether the RPC was failed because its peer was declared
+     * failed.
+     */
+    static bool failed(const std::shared_ptr<peer_call>& call) {
+        return call && call->failed;
+    }
+
+    /**
+     * @brief Declares a peer failed and cancels the RPCs in flight to it.
+     */
+    static void fail(peer_state& peer) {
+        std::lock_guard<std::mutex> lock(peer.mutex);
+        peer.dead = true;
+        for(auto call : peer.calls) {
+            call->failed = true;
+            HG_Cancel(call->handle);
+        }
+        peer.calls.clear();
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_PER_INSTANCE_HPP
+#define __THALLIUM_PER_INSTANCE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <margo.h>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief When the object a per_instance<T>::get call creates is removed
+ * from its margo instance.
+ */
+enum class instance_release { at_prefinalize, at_finalize };
+
+/**
+ * @private
+ * @brief Attaches at most one object of type T to each margo instance
+ * (a cache, the settings of its RPCs, ...). Classes derive from it to
+ * get the static find, install and uninstall functions of their objects:
+ *
+ * \code{.cpp}
+ * class handle_cache : public per_instance<handle_cache> { ... };
+ * auto cache = handle_cache::find(mid);
+ * \endcode
+ *
+ * Objects are held by shared_ptr, so a caller keeps using the one it
+ * found after it is uninstalled. find returns without locking while no
+ * margo instance has an object, which is the common case for optional
+ * features; otherwise it takes a mutex shared by all the instances.
+ *
+ * @tparam T Type of the objects.
+ */
+template <typename T> class per_instance {
+
+    using map_type = std::unordered_map<margo_instance_id, std::shared_ptr<T>>;
+
+    static std::mutex& instances_mutex() {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    static map_type& instances() {
+        static map_type m;
+        return m;
+    }
+
+    static std::atomic<std::size_t>& instances_size() {
+        static std::atomic<std::size_t> s{0};
+        return s;
+    }
+
+    // called with instances_mutex() held
+    static void update_size() {
+        instances_size().store(instances().size(), std::memory_order_relaxed);
+    }
+
+  public:
+
+    /**
+     * @brief Returns true if no margo instance has an object.
+     */
+    static bool empty() {
+        return instances_size().load(std::memory_order_relaxed) == 0;
+    }
+
+    /**
+     * @brief Returns the object of a margo instance, or nullptr.
+     */
+    static std::shared_ptr<T> find(margo_instance_id mid) {
+        if(empty()) return nullptr;
+        std::lock_guard<std::mutex> lock(instances_mutex());
+        auto it = instances().find(mid);
+        return it == instances().end() ? nullptr : it->second;
+    }
+
+    /**
+     * @brief Attaches an object to a margo instance, replacing (and
+     * returning) its previous one.
+     */
+    static std::shared_ptr<T> install(margo_instance_id mid, std::shared_ptr<T> obj) {
+        std::lock_guard<std::mutex> lock(instances_mutex());
+        auto& slot = instances()[mid];
+        std::swap(slot, obj);
+        update_size();
+        return obj;
+    }
+
+    /**
+     * @brief Attaches an object to a margo instance unless it already
+     * has one. Returns false if it had.
+     */
+    static bool try_install(margo_instance_id mid, std::shared_ptr<T> obj) {
+        std::lock_guard<std::mutex> lock(instances_mutex());
+        if(!instances().emplace(mid, std::move(obj)).second) return false;
+        update_size();
+        return true;
+    }
+
+    /**
+     * @brief Returns the object of a margo instance, attaching the one
+     * returned by make() (called with the lock held) if it has none.
+     * created tells which case happened. If make() throws, the instance
+     * is left without object.
+     */
+    template <typename Make>
+    static std::shared_ptr<T> find_or_install(margo_instance_id mid, Make&& make,
+                                              bool& created) {
+        std::lock_guard<std::mutex> lock(instances_mutex());
+        auto it = instances().find(mid);
+        created = it == instances().end();
+        if(!created) return it->second;
+        auto obj = std::forward<Make>(make)();
+        instances().emplace(mid, obj);
+        update_size();
+        return obj;
+    }
+
+    /**
+     * @brief Same as find_or_install, but the object created is
+     * uninstalled by a (pre)finalize callback of the margo instance.
+     */
+    template <typename Make>
+    static std::shared_ptr<T> get(margo_instance_id mid, instance_release when,
+                                  Make&& make) {
+        bool created = false;
+        auto obj     = find_or_install(mid, std::forward<Make>(make), created);
+        if(created) {
+            if(when == instance_release::at_prefinalize)
+                margo_provider_push_prefinalize_callback(mid, obj.get(), &release, mid);
+            else
+                margo_provider_push_finalize_callback(mid, obj.get(), &release, mid);
+        }
+        return obj;
+    }
+
+    /**
+     * @brief Same as above, creating a default-constructed object.
+     */
+    static std::shared_ptr<T> get(margo_instance_id mid, instance_release when) {
+        return get(mid, when, []() { return std::make_shared<T>(); });
+    }
+
+    /**
+     * @brief Detaches the object of a margo instance and returns it
+     * (nullptr if it had none).
+     */
+    static std::shared_ptr<T> uninstall(margo_instance_id mid) {
+        std::lock_guard<std::mutex> lock(instances_mutex());
+        auto it = instances().find(mid);
+        if(it == instances().end()) return nullptr;
+        auto obj = std::move(it->second);
+        instances().erase(it);
+        update_size();
+        return obj;
+    }
+
+    /**
+     * @brief Detaches the object of a margo instance only if it is the
+     * provided one. Returns true if it was.
+     */
+    static bool uninstall_if(margo_instance_id mid, const T* expected) {
+        std::shared_ptr<T> obj; // destroyed outside of the lock
+        std::lock_guard<std::mutex> lock(instances_mutex());
+        auto it = instances().find(mid);
+        if(it == instances().end() || it->second.get() != expected) return false;
+        obj = std::move(it->second);
+        instances().erase(it);
+        update_size();
+        return true;
+    }
+
+    /**
+     * @brief Owner identifying the (pre)finalize callbacks pushed for
+     * objects that are replaced while their margo instance runs, which
+     * cannot identify them.
+     */
+    static const void* callback_owner() {
+        return &instances();
+    }
+
+    /**
+     * @brief (Pre)finalize callback uninstalling the object of the
+     * margo instance passed as argument.
+     */
+    static void release(void* mid) {
+        uninstall(static_cast<margo_instance_id>(mid));
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -8,12 +8,14 @@
 #define __THALLIUM_POOL_HPP
 
 #include <abt.h>
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <thallium/abt_errors.hpp>
 #include <thallium/anonymous.hpp>
 #include <thallium/exception.hpp>
 #include <thallium/managed.hpp>
+#include <thallium/unit_allocator.hpp>
 #include <thallium/unit_type.hpp>
 
 namespace thallium {
@@ -21,6 +23,7 @@ namespace thallium {
 class xstream;
 class scheduler;
 class task;
+class task_batch;
 class thread;
 
 /**
@@ -74,7 +77,9 @@ class pool {
      */
     enum class kind : std::int32_t {
         fifo      = ABT_POOL_FIFO,     /* FIFO pool */
-        fifo_wait = ABT_POOL_FIFO_WAIT /* FIFO pool with ability to wait for units */
+        fifo_wait = ABT_POOL_FIFO_WAIT, /* FIFO pool with ability to wait for units */
+        work_stealing = -1, /* thallium's work_stealing_pool */
+        priority = -2 /* thallium's priority_pool */
     };
 
   private:
@@ -224,6 +229,8 @@ class pool {
      * @tparam U Custom unit type
      * @tparam Palloc Special allocator to allocate a pool
      * @tparam Ualloc Special allocator to allocate a unit
+     * (std::allocator by default; pooled_unit_allocator, see
+     * unit_allocator.hpp, avoids a malloc/free pair per unit)
      *
      * @return a managed<pool> object.
      *
@@ -303,10 +310,12 @@ class pool {
     }
 
     /**
-     * @brief Builds a pool using a default implementation from Argobots.
+     * @brief Builds a pool using a default implementation from Argobots,
+     * or a work_stealing_pool or priority_pool if k is kind::work_stealing
+     * or kind::priority (in which case the access type is always mpmc).
      *
      * @param access Access type enabled by the pool.
-     * @param kind Kind of pool (fifo or fifo_wait).
+     * @param kind Kind of pool (fifo, fifo_wait, work_stealing, or priority).
      *
      * IMPORTANT: The destructor of a managed<pool> will try
      * to destroy the pool. If the pool is still attached to
@@ -314,12 +323,7 @@ class pool {
      * Make sure all the schedulers that use this pool have
      * been destroyed before the pool goes out of scope.
      */
-    static managed<pool> create(access a, kind k = kind::fifo) {
-        ABT_pool p;
-        TL_POOL_ASSERT(ABT_pool_create_basic((ABT_pool_kind)k, (ABT_pool_access)a,
-                                             ABT_FALSE, &p));
-        return make_managed<pool>(p);
-    }
+    static managed<pool> create(access a, kind k = kind::fifo);
 
     /**
      * @brief Copy constructor.
@@ -505,6 +509,29 @@ class pool {
 
     template <typename F> void make_task(F&& f, const anonymous& a);
 
+    /**
+     * @brief Creates count/grain (rounded up) tasks calling f(i) for each
+     * i in [0, count), each task handling grain consecutive indices, and
+     * pushes them into the pool. The function and the tasks' arguments
+     * are allocated once for the whole batch.
+     *
+     * @tparam F type of function, taking an std::size_t.
+     * @param count Number of indices.
+     * @param f Function to call on each index.
+     * @param grain Number of indices handled by each task.
+     *
+     * @return a task_batch that can be used to wait for all the tasks.
+     */
+    template <typename F>
+    task_batch make_tasks(std::size_t count, F&& f, std::size_t grain = 1);
+
+    /**
+     * @brief Same as make_tasks(count, f, grain) but calls f on each
+     * element of the range [begin, end), given by random-access iterators.
+     */
+    template <typename I, typename F>
+    task_batch make_tasks(I begin, I end, F&& f, std::size_t grain = 1);
+
     /**
      * @brief Create a thread running the specified function and push it
      * into the pool.
@@ -567,11 +594,28 @@ Ualloc pool::pool_def<P, U, Palloc, Ualloc>::unit_allocator;
 } // namespace thallium
 
 #include <thallium/task.hpp>
+#include <thallium/task_batch.hpp>
 #include <thallium/thread.hpp>
 #include <thallium/scheduler.hpp>
 
 namespace thallium {
 
+namespace detail {
+inline managed<pool> create_work_stealing_pool();
+inline managed<pool> create_priority_pool();
+}
+
+inline managed<pool> pool::create(access a, kind k) {
+    if(k == kind::work_stealing)
+        return detail::create_work_stealing_pool();
+    if(k == kind::priority)
+        return detail::create_priority_pool();
+    ABT_pool p;
+    TL_POOL_ASSERT(ABT_pool_create_basic((ABT_pool_kind)k, (ABT_pool_access)a,
+                                         ABT_FALSE, &p));
+    return make_managed<pool>(p);
+}
+
 inline void pool::add_sched(const scheduler& sched) {
     int ret = ABT_pool_add_sched(m_pool, sched.native_handle());
     if(ret != ABT_SUCCESS) {
@@ -596,6 +640,41 @@ void pool::make_task(F&& f, const anonymous& a) {
             reinterpret_cast<void*>(fp), a);
 }
     
+template <typename F>
+task_batch pool::make_tasks(std::size_t count, F&& f, std::size_t grain) {
+    if(grain == 0) grain = 1;
+    task_batch batch;
+    batch.m_state.reset(new task_batch::state);
+    auto s = batch.m_state.get();
+    s->m_body       = std::forward<F>(f);
+    s->m_num_pieces = (count + grain - 1) / grain;
+    s->m_pieces.reset(new task_batch::piece[s->m_num_pieces]);
+    s->m_remaining  = s->m_num_pieces + 1;
+    std::size_t i = 0;
+    try {
+        for(; i < s->m_num_pieces; i++) {
+            s->m_pieces[i] = task_batch::piece{s, i*grain, std::min(count, (i+1)*grain)};
+            task::create_on_pool(m_pool, task_batch::run_piece,
+                    reinterpret_cast<void*>(&s->m_pieces[i]), anonymous());
+        }
+    } catch(...) {
+        s->complete(s->m_num_pieces - i + 1);
+        throw;
+    }
+    // the extra count keeps the eventual from being set before all the
+    // pieces have been submitted
+    s->complete(1);
+    return batch;
+}
+
+template <typename I, typename F>
+task_batch pool::make_tasks(I begin, I end, F&& f, std::size_t grain) {
+    auto count = static_cast<std::size_t>(end - begin);
+    return make_tasks(count,
+        [begin, f=std::forward<F>(f)](std::size_t i) mutable { f(*(begin + i)); },
+        grain);
+}
+
 template <typename F>
 managed<thread> pool::make_thread(F&& f) {
     auto fp = new std::function<void(void)>(std::forward<F>(f));
@@ -661,4 +740,8 @@ ABT_unit pool::pool_def<P,U,Palloc,Ualloc>::u_create_from_task(ABT_task t) {
 #undef TL_POOL_EXCEPTION
 #undef TL_POOL_ASSERT
 
+// pools implemented by thallium, which pool::create(access, kind) can create
+#include <thallium/work_stealing_pool.hpp>
+#include <thallium/priority_pool.hpp>
+
 #endif /* end of include guard */
@@ -0,0 +1,185 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_POOL_BALANCER_HPP
+#define __THALLIUM_POOL_BALANCER_HPP
+
+#include <abt.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/timed_callback.hpp>
+
+namespace thallium {
+
+/**
+ * @brief A pool_balancer evens out the queues of a set of pools (e.g.
+ * the pools of shard-affine handlers, see remote_procedure::set_sharding)
+ * by moving work units that are waiting to run from the longest queues
+ * to the shortest ones. Running and blocked units are never moved.
+ *
+ * Every interval_ms, the balancer samples the number of runnable units
+ * of each pool, pairs the most loaded pools with the least loaded ones,
+ * and moves half the difference (at most max_moves units per pair) when
+ * it is at least min_imbalance. Non-migratable ULTs are pushed back to
+ * their pool.
+ *
+ * \code{.cpp}
+ * tl::pool_balancer::options opts;
+ * opts.interval_ms = 0.5;
+ * tl::pool_balancer balancer(engine, shard_pools, opts);
+ * \endcode
+ *
+ * Moving a unit changes the execution stream that runs it, so affinity
+ * to a pool is a preference rather than a guarantee once a balancer is
+ * used; handlers needing a specific pool should call
+ * thread::migrate_self_to. The balancer stops when the engine is
+ * finalized or when it is destroyed, whichever comes first.
+ */
+class pool_balancer {
+
+  public:
+
+    /**
+     * @brief Parameters of a pool_balancer.
+     */
+    struct options {
+        double      interval_ms   = 1.0; /*!< time between samples */
+        std::size_t min_imbalance = 4;   /*!< difference of queue lengths to act on */
+        std::size_t max_moves     = 32;  /*!< units moved at most per pair and sample */
+    };
+
+    /**
+     * @brief Constructor. Starts balancing.
+     *
+     * @param e Engine whose progress loop runs the balancer.
+     * @param pools Pools to balance.
+     * @param opts Options.
+     */
+    pool_balancer(const engine& e, std::vector<pool> pools, options opts)
+    : m_mid(e.get_margo_instance())
+    , m_pools(std::move(pools))
+    , m_opts(opts) {
+        if(m_opts.interval_ms <= 0.0)
+            throw exception("pool_balancer: interval_ms must be positive");
+        if(m_opts.min_imbalance < 2) m_opts.min_imbalance = 2;
+        m_timer = std::make_unique<timed_callback>(
+            engine(m_mid).create_timed_callback([this]() { tick(); }));
+        m_running = true;
+        m_timer->start(m_opts.interval_ms);
+        margo_provider_push_prefinalize_callback(
+            m_mid, this, &pool_balancer::on_finalize, this);
+    }
+
+    /**
+     * @brief Constructor with the default options.
+     */
+    pool_balancer(const engine& e, std::vector<pool> pools)
+    : pool_balancer(e, std::move(pools), options()) {}
+
+    pool_balancer(const pool_balancer&)            = delete;
+    pool_balancer& operator=(const pool_balancer&) = delete;
+
+    ~pool_balancer() {
+        if(stop()) margo_provider_pop_prefinalize_callback(m_mid, this);
+    }
+
+    /**
+     * @brief Returns the number of units moved so far.
+     */
+    std::size_t moved() const {
+        return m_moved.load();
+    }
+
+    /**
+     * @brief Moves up to count runnable units from one pool to another,
+     * and returns the number of units moved.
+     *
+     * @param from Pool to take the units from.
+     * @param to Pool to push them into.
+     * @param count Maximum number of units to move.
+     */
+    static std::size_t move_units(const pool& from, const pool& to, std::size_t count) {
+        std::size_t moved = 0;
+        for(; moved < count; moved++) {
+            ABT_thread unit = ABT_THREAD_NULL;
+            if(ABT_pool_pop_thread(from.native_handle(), &unit) != ABT_SUCCESS
+            || unit == ABT_THREAD_NULL)
+                break;
+            ABT_bool migratable = ABT_TRUE;
+            ABT_thread_is_migratable(unit, &migratable);
+            if(!migratable || ABT_pool_push_thread(to.native_handle(), unit) != ABT_SUCCESS) {
+                ABT_pool_push_thread(from.native_handle(), unit);
+                break;
+            }
+        }
+        return moved;
+    }
+
+  private:
+
+    margo_instance_id               m_mid;
+    std::vector<pool>               m_pools;
+    options                         m_opts;
+    std::unique_ptr<timed_callback> m_timer;
+    std::mutex                      m_mutex;
+    bool                            m_running = false;
+    std::atomic<std::size_t>        m_moved{0};
+
+    void balance() {
+        std::vector<std::pair<std::size_t, std::size_t>> sizes; // (queue length, index)
+        sizes.reserve(m_pools.size());
+        for(std::size_t i = 0; i < m_pools.size(); i++)
+            sizes.emplace_back(m_pools[i].size(), i);
+        std::sort(sizes.begin(), sizes.end());
+        for(std::size_t lo = 0, hi = sizes.size(); lo + 1 < hi; lo++) {
+            hi -= 1;
+            std::size_t diff = sizes[hi].first - sizes[lo].first;
+            if(diff < m_opts.min_imbalance) break;
+            std::size_t count = std::min(diff / 2, m_opts.max_moves);
+            m_moved += move_units(m_pools[sizes[hi].second], m_pools[sizes[lo].second], count);
+        }
+    }
+
+    void tick() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_running) return;
+        balance();
+        m_timer->start(m_opts.interval_ms);
+    }
+
+    // stops balancing; returns false if the balancer was already stopped
+    bool stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_running) return false;
+            m_running = false;
+        }
+        try {
+            m_timer->cancel();
+        } catch(const exception&) {
+            // the callback was running and won't start the timer again
+        }
+        m_timer.reset();
+        return true;
+    }
+
+    static void on_finalize(void* arg) {
+        static_cast<pool_balancer*>(arg)->stop();
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_POOL_STATS_HPP
+#define __THALLIUM_POOL_STATS_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <thallium/rpc_stats.hpp>
+#include <thallium/tsc_clock.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Collects work unit statistics per pool from the events of
+ * Argobots' tool interface. Each OS thread (execution stream) records
+ * into its own counters, found in a thread_local map by pool id, so the
+ * callbacks only take the registry lock the first time an execution
+ * stream sees a pool. The time at which a unit became ready and the
+ * time at which it started running are kept in two ABT_keys of the
+ * unit. Counters are never freed.
+ */
+class pool_stats_collector {
+
+    struct counters {
+        int                        pool_id;
+        std::atomic<std::uint64_t> created{0};
+        std::atomic<std::uint64_t> runs{0};
+        std::atomic<std::uint64_t> yields{0};
+        std::atomic<std::uint64_t> suspends{0};
+        std::atomic<std::uint64_t> finished{0};
+        latency_histogram          wait;
+        latency_histogram          run;
+
+        explicit counters(int id)
+        : pool_id(id) {}
+
+        static void incr(std::atomic<std::uint64_t>& c) {
+            c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    };
+
+    std::mutex                             m_mutex;
+    std::vector<std::unique_ptr<counters>> m_counters;
+    std::atomic<std::uint64_t>             m_since{0};
+    ABT_key                                m_ready_key = ABT_KEY_NULL;
+    ABT_key                                m_run_key   = ABT_KEY_NULL;
+
+    counters& local(int pool_id) {
+        static thread_local std::unordered_map<int, counters*> cache;
+        auto it = cache.find(pool_id);
+        if(it != cache.end()) return *it->second;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_counters.emplace_back(new counters(pool_id));
+        counters* c = m_counters.back().get();
+        cache.emplace(pool_id, c);
+        return *c;
+    }
+
+    static void set_time(ABT_thread t, ABT_key key, std::uint64_t ns) {
+        ABT_thread_set_specific(t, key, reinterpret_cast<void*>(static_cast<std::uintptr_t>(ns)));
+    }
+
+    static std::uint64_t take_time(ABT_thread t, ABT_key key) {
+        void* p = nullptr;
+        if(ABT_thread_get_specific(t, key, &p) != ABT_SUCCESS || !p) return 0;
+        ABT_thread_set_specific(t, key, nullptr);
+        return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p));
+    }
+
+    void stopped_running(counters& c, ABT_thread t, std::uint64_t now) {
+        std::uint64_t start = take_time(t, m_run_key);
+        if(start) c.run.record(now - start);
+    }
+
+    static void callback(ABT_thread t, ABT_xstream, uint64_t event, ABT_tool_context,
+                         void* arg) {
+        auto&         self    = *static_cast<pool_stats_collector*>(arg);
+        std::uint64_t now     = tsc_clock::now_ns();
+        int           pool_id = -1;
+        ABT_thread_get_last_pool_id(t, &pool_id);
+        counters& c = self.local(pool_id);
+        switch(event) {
+        case ABT_TOOL_EVENT_THREAD_CREATE:
+            counters::incr(c.created);
+            set_time(t, self.m_ready_key, now);
+            break;
+        case ABT_TOOL_EVENT_THREAD_RESUME:
+            set_time(t, self.m_ready_key, now);
+            break;
+        case ABT_TOOL_EVENT_THREAD_RUN: {
+            counters::incr(c.runs);
+            std::uint64_t ready = take_time(t, self.m_ready_key);
+            if(ready) c.wait.record(now - ready);
+            set_time(t, self.m_run_key, now);
+            break;
+        }
+        case ABT_TOOL_EVENT_THREAD_YIELD:
+            counters::incr(c.yields);
+            self.stopped_running(c, t, now);
+            set_time(t, self.m_ready_key, now);
+            break;
+        case ABT_TOOL_EVENT_THREAD_SUSPEND:
+            counters::incr(c.suspends);
+            self.stopped_running(c, t, now);
+            break;
+        case ABT_TOOL_EVENT_THREAD_FINISH:
+            counters::incr(c.finished);
+            self.stopped_running(c, t, now);
+            break;
+        default:
+            break;
+        }
+    }
+
+  public:
+
+    static pool_stats_collector& instance() {
+        static pool_stats_collector* c = new pool_stats_collector; // never destroyed
+        return *c;
+    }
+
+    bool enable() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_ready_key == ABT_KEY_NULL && ABT_key_create(nullptr, &m_ready_key) != ABT_SUCCESS)
+                return false;
+            if(m_run_key == ABT_KEY_NULL && ABT_key_create(nullptr, &m_run_key) != ABT_SUCCESS)
+                return false;
+        }
+        if(m_since.load(std::memory_order_relaxed) == 0)
+            m_since.store(tsc_clock::now_ns(), std::memory_order_relaxed);
+        uint64_t mask = ABT_TOOL_EVENT_THREAD_CREATE | ABT_TOOL_EVENT_THREAD_RUN
+                      | ABT_TOOL_EVENT_THREAD_YIELD | ABT_TOOL_EVENT_THREAD_SUSPEND
+                      | ABT_TOOL_EVENT_THREAD_RESUME | ABT_TOOL_EVENT_THREAD_FINISH;
+        return ABT_tool_register_thread_callback(&callback, mask, this) == ABT_SUCCESS;
+    }
+
+    void disable() {
+        ABT_tool_register_thread_callback(nullptr, ABT_TOOL_EVENT_THREAD_NONE, nullptr);
+    }
+
+    std::vector<pool_stats_entry> snapshot() {
+        std::uint64_t since   = m_since.load(std::memory_order_relaxed);
+        std::uint64_t elapsed = since ? tsc_clock::now_ns() - since : 0;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<pool_stats_entry> result;
+        std::unordered_map<int, std::size_t> index;
+        for(auto& c : m_counters) {
+            auto it = index.find(c->pool_id);
+            if(it == index.end()) {
+                it = index.emplace(c->pool_id, result.size()).first;
+                result.emplace_back();
+                result.back().pool_id    = c->pool_id;
+                result.back().elapsed_ns = elapsed;
+            }
+            auto& e = result[it->second];
+            e.created  += c->created.load(std::memory_order_relaxed);
+            e.runs     += c->runs.load(std::memory_order_relaxed);
+            e.yields   += c->yields.load(std::memory_order_relaxed);
+            e.suspends += c->suspends.load(std::memory_order_relaxed);
+            e.finished += c->finished.load(std::memory_order_relaxed);
+            c->wait.merge_into(e.wait);
+            c->run.merge_into(e.run);
+        }
+        return result;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto& c : m_counters) {
+            c->created.store(0, std::memory_order_relaxed);
+            c->runs.store(0, std::memory_order_relaxed);
+            c->yields.store(0, std::memory_order_relaxed);
+            c->suspends.store(0, std::memory_order_relaxed);
+            c->finished.store(0, std::memory_order_relaxed);
+            c->wait.reset();
+            c->run.reset();
+        }
+        m_since.store(tsc_clock::now_ns(), std::memory_order_relaxed);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Starts collecting work unit statistics per pool (see
+ * pool_stats_entry) through Argobots' tool interface, for all the pools
+ * of the process. Argobots must have been configured with --enable-tool;
+ * otherwise this function returns false and no statistics are collected.
+ * Collecting adds a callback (a few tens of nanoseconds) to every
+ * creation, scheduling, yield, suspension and completion of a work
+ * unit. The statistics are also part of engine::get_rpc_stats() and of
+ * the metrics exported by metrics_exporter.
+ *
+ * \code{.cpp}
+ * tl::enable_pool_stats();
+ * ...
+ * for(auto& p : tl::get_pool_stats())
+ *     std::cout << p.pool_id << ": " << p.wait.percentile(99) << "ns p99 wait\n";
+ * \endcode
+ *
+ * @return true if the statistics are being collected.
+ */
+inline bool enable_pool_stats() {
+    return detail::pool_stats_collector::instance().enable();
+}
+
+/**
+ * @brief Stops collecting pool statistics. The statistics collected so
+ * far are kept.
+ */
+inline void disable_pool_stats() {
+    detail::pool_stats_collector::instance().disable();
+}
+
+/**
+ * @brief Returns the statistics collected since enable_pool_stats (or
+ * the last reset_pool_stats), by pool. The names are left empty; they
+ * are filled by engine::get_rpc_stats for the pools of its margo instance.
+ */
+inline std::vector<pool_stats_entry> get_pool_stats() {
+    return detail::pool_stats_collector::instance().snapshot();
+}
+
+/**
+ * @brief Clears the pool statistics collected so far.
+ */
+inline void reset_pool_stats() {
+    detail::pool_stats_collector::instance().reset();
+}
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,262 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_PRIORITY_POOL_HPP
+#define __THALLIUM_PRIORITY_POOL_HPP
+
+#include <abt.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thallium/managed.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/rpc_priority.hpp>
+#include <thallium/self.hpp>
+#include <thallium/task.hpp>
+#include <thallium/thread.hpp>
+#include <thallium/unit_type.hpp>
+
+namespace thallium {
+
+class priority_pool;
+
+/**
+ * @brief Unit type of a priority_pool. A unit takes its priority from
+ * the context in which its ULT or task is created (see priority_scope
+ * and remote_procedure::set_priority) and keeps it when re-pushed
+ * after yielding.
+ */
+class priority_unit {
+
+    friend class priority_pool;
+
+    thread                                m_thread;
+    task                                  m_task;
+    unit_type                             m_type;
+    int                                   m_priority;
+    bool                                  m_in_pool = false;
+    std::chrono::steady_clock::time_point m_pushed;
+
+    static int initial_priority();
+
+  public:
+
+    priority_unit(const thread& t)
+    : m_thread(t)
+    , m_type(unit_type::thread)
+    , m_priority(initial_priority()) {}
+
+    priority_unit(const task& t)
+    : m_task(t)
+    , m_type(unit_type::task)
+    , m_priority(initial_priority()) {}
+
+    unit_type get_type() const {
+        return m_type;
+    }
+
+    const thread& get_thread() const {
+        return m_thread;
+    }
+
+    const task& get_task() const {
+        return m_task;
+    }
+
+    bool is_in_pool() const {
+        return m_in_pool;
+    }
+
+    /**
+     * @brief Priority of the unit (0 is the highest).
+     */
+    int priority() const {
+        return m_priority;
+    }
+};
+
+/**
+ * @brief priority_pool is a pool with num_priorities FIFO levels,
+ * level 0 being served first. Work units created without a priority
+ * go to default_priority.
+ *
+ * To prevent starvation, units age: a unit of priority p that has
+ * waited for k aging intervals competes as if it had priority p-k,
+ * so that lower-priority work keeps progressing under a steady stream
+ * of higher-priority units.
+ *
+ * Used as the handler pool of RPCs whose priority was set with
+ * remote_procedure::set_priority, it lets latency-sensitive RPCs
+ * bypass RPCs queued before them:
+ *
+ * \code{.cpp}
+ * auto p = tl::pool::create(tl::pool::access::mpmc, tl::pool::kind::priority);
+ * engine.define("get_metadata", get_metadata, 0, *p).set_priority(0);
+ * engine.define("read_data", read_data, 0, *p).set_priority(3);
+ * \endcode
+ *
+ * With set_demote_long_runners, ULTs yielding from self::maybe_yield
+ * after exhausting their time slice are moved to the lowest priority,
+ * so that long computations run behind short requests instead of
+ * competing with them.
+ */
+class priority_pool {
+
+  public:
+
+    static constexpr int num_priorities   = 4;
+    static constexpr int default_priority = 1;
+
+    static const pool::access access_type = pool::access::mpmc;
+
+  private:
+
+    mutable std::mutex                                   m_mutex;
+    std::array<std::deque<priority_unit*>, num_priorities> m_levels;
+    std::atomic<std::size_t>                             m_size{0};
+    std::atomic<std::int64_t>                            m_aging_us{10000};
+    std::atomic<bool>                                    m_demote_long_runners{false};
+
+  public:
+
+    priority_pool() = default;
+
+    priority_pool(const priority_pool&)            = delete;
+    priority_pool& operator=(const priority_pool&) = delete;
+
+    /**
+     * @brief Returns the priority_pool implementing the provided pool,
+     * which must have been created as a priority pool.
+     */
+    static priority_pool* from(const pool& p) {
+        void* data = nullptr;
+        if(ABT_pool_get_data(p.native_handle(), &data) != ABT_SUCCESS)
+            return nullptr;
+        return static_cast<priority_pool*>(data);
+    }
+
+    /**
+     * @brief Sets the aging interval (10ms by default). A zero interval
+     * disables aging, making priorities strict.
+     */
+    void set_aging_interval(std::chrono::microseconds interval) {
+        m_aging_us.store(interval.count(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the aging interval.
+     */
+    std::chrono::microseconds get_aging_interval() const {
+        return std::chrono::microseconds(m_aging_us.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Sets whether ULTs that yield from self::maybe_yield are put
+     * back at the end of the lowest priority level, where they stay
+     * (aging still lets them progress). Disabled by default.
+     */
+    void set_demote_long_runners(bool enable) {
+        m_demote_long_runners.store(enable, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns whether long-running ULTs are demoted.
+     */
+    bool get_demote_long_runners() const {
+        return m_demote_long_runners.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the number of units waiting at a given priority.
+     */
+    std::size_t get_size(int priority) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_levels[priority].size();
+    }
+
+    size_t get_size() const {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    void push(priority_unit* u) {
+        u->m_pushed = std::chrono::steady_clock::now();
+        // a ULT yielding from maybe_yield is pushed back by the scheduler
+        // of the execution stream it ran on, i.e. the calling one
+        auto& slice = detail::time_slice();
+        if(slice.long_runner != ABT_THREAD_NULL && u->m_type == unit_type::thread
+           && u->m_thread.native_handle() == slice.long_runner) {
+            slice.long_runner = ABT_THREAD_NULL;
+            if(m_demote_long_runners.load(std::memory_order_relaxed))
+                u->m_priority = num_priorities - 1;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        u->m_in_pool = true;
+        m_levels[u->m_priority].push_back(u);
+        m_size.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    priority_unit* pop() {
+        if(m_size.load(std::memory_order_relaxed) == 0) return nullptr;
+        auto now   = std::chrono::steady_clock::now();
+        auto aging = m_aging_us.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int          best = -1;
+        std::int64_t best_priority = 0;
+        // the front of each level is its oldest unit, so only fronts
+        // need to be compared
+        for(int l = 0; l < num_priorities; l++) {
+            if(m_levels[l].empty()) continue;
+            std::int64_t p = l;
+            if(aging > 0 && l > 0) {
+                auto waited = std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - m_levels[l].front()->m_pushed).count();
+                p -= waited / aging;
+            }
+            if(best < 0 || p < best_priority) {
+                best          = l;
+                best_priority = p;
+            }
+        }
+        if(best < 0) return nullptr;
+        priority_unit* u = m_levels[best].front();
+        m_levels[best].pop_front();
+        u->m_in_pool = false;
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        return u;
+    }
+
+    void remove(priority_unit* u) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& level = m_levels[u->m_priority];
+        auto  it    = std::find(level.begin(), level.end(), u);
+        if(it != level.end()) {
+            level.erase(it);
+            u->m_in_pool = false;
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+inline int priority_unit::initial_priority() {
+    int p = detail::current_unit_priority();
+    if(p < 0) return priority_pool::default_priority;
+    return std::min(p, priority_pool::num_priorities - 1);
+}
+
+namespace detail {
+
+inline managed<pool> create_priority_pool() {
+    return pool::create<priority_pool, priority_unit>();
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -7,22 +7,38 @@
 #define __THALLIUM_PROC_OBJECT_HPP
 
 #ifdef THALLIUM_DEBUG_RPC_TYPES
+#include <thallium/serialization/stl/string.hpp>
+#endif
+#if defined(THALLIUM_DEBUG_RPC_TYPES) || defined(THALLIUM_CHECK_RPC_SIGNATURES)
+#include <cstdlib>
+#include <cstring>
 #include <cxxabi.h>
 #include <iostream>
-#include <thallium/serialization/stl/string.hpp>
 #include <typeinfo>
 #endif
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <margo.h>
 #include <mercury_proc.h>
+#include <thallium/inplace_function.hpp>
+#include <thallium/opaque_payload.hpp>
+#include <thallium/serialization/compression.hpp>
 #include <thallium/serialization/proc_input_archive.hpp>
 #include <thallium/serialization/proc_output_archive.hpp>
+#include <thallium/serialization/signature_hash.hpp>
+#include <thallium/serialization/size_archive.hpp>
+#include <thallium/serialization/varint.hpp>
 #include <tuple>
 #include <vector>
 #include <memory>
 
 namespace thallium {
 
-#ifdef THALLIUM_DEBUG_RPC_TYPES
+#if defined(THALLIUM_DEBUG_RPC_TYPES) || defined(THALLIUM_CHECK_RPC_SIGNATURES)
 template <typename T> std::string get_type_name() {
     int         status;
     const char* mangled_type_name = typeid(T).name();
@@ -45,26 +61,337 @@ class engine;
 template<typename ... CtxArg> class request_with_context;
 using request = request_with_context<>;
 
-typedef std::function<hg_return_t(hg_proc_t)> meta_proc_fn;
+/**
+ * @brief Type of the callable passed through Mercury's proc callbacks
+ * as the "data" argument. It is built on every forward, respond, and
+ * input/output decoding, so it is an inplace_function (which never
+ * allocates) rather than an std::function.
+ */
+typedef inplace_function<hg_return_t(hg_proc_t), 8*sizeof(void*)> meta_proc_fn;
 
 inline hg_return_t hg_proc_meta_serialization(hg_proc_t proc, void* data) {
     auto fun = reinterpret_cast<meta_proc_fn*>(data);
     return (*fun)(proc);
 }
 
+namespace detail {
+
+/**
+ * @private
+ * @brief Largest payload encoded as a fixed-layout block.
+ */
+constexpr std::size_t max_pod_payload_size = 256;
+
+template <typename... T> struct pod_payload_size;
+
+template <> struct pod_payload_size<> : std::integral_constant<std::size_t, 0> {};
+
+template <typename T1, typename... Tn>
+struct pod_payload_size<T1, Tn...>
+: std::integral_constant<std::size_t, sizeof(typename signature_element<T1>::type)
+                                      + pod_payload_size<Tn...>::value> {};
+
+template <typename... T> struct all_pod_elements;
+
+template <> struct all_pod_elements<> : std::true_type {};
+
+template <typename T>
+struct is_pod_element
+: std::integral_constant<bool, (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value)
+                               || std::is_enum<T>::value> {};
+
+template <typename T1, typename... Tn>
+struct all_pod_elements<T1, Tn...>
+: std::integral_constant<bool, is_pod_element<typename signature_element<T1>::type>::value
+                               && all_pod_elements<Tn...>::value> {};
+
+/**
+ * @private
+ * @brief Whether a payload of type T (a tuple of values or of
+ * std::reference_wrapper) is encoded as a fixed-layout block: the
+ * values of its elements, which are all numbers (other than bool) or
+ * enums, one after the other without padding, copied with a single
+ * hg_proc_memcpy instead of going through the archives. This is the
+ * layout the archives produce for such values, so payloads can still
+ * be decoded either way and only the cost of encoding changes.
+ * Payloads encoded with a context (which may change the encoding of
+ * integers) or with THALLIUM_DEBUG_RPC_TYPES use the archives.
+ */
+template <typename T, typename... CtxArg> struct uses_pod_payload : std::false_type {};
+
+#ifndef THALLIUM_DEBUG_RPC_TYPES
+template <typename... T>
+struct uses_pod_payload<std::tuple<T...>>
+: std::integral_constant<bool, (sizeof...(T) > 0) && all_pod_elements<T...>::value
+                               && pod_payload_size<T...>::value <= max_pod_payload_size> {};
+#endif
+
+template <typename... T, std::size_t... I>
+hg_return_t encode_pod_payload(hg_proc_t proc, const std::tuple<T...>& data,
+                               std::index_sequence<I...>) {
+    char  block[pod_payload_size<T...>::value];
+    char* p = block;
+    (void)std::initializer_list<int>{(
+        std::memcpy(p, &static_cast<const typename signature_element<T>::type&>(std::get<I>(data)),
+                    sizeof(typename signature_element<T>::type)),
+        p += sizeof(typename signature_element<T>::type), 0)...};
+    return hg_proc_memcpy(proc, block, sizeof(block));
+}
+
+template <typename... T, std::size_t... I>
+hg_return_t decode_pod_payload(hg_proc_t proc, std::tuple<T...>& data,
+                               std::index_sequence<I...>) {
+    char        block[pod_payload_size<T...>::value];
+    hg_return_t ret = hg_proc_memcpy(proc, block, sizeof(block));
+    if(ret != HG_SUCCESS) return ret;
+    const char* p = block;
+    (void)std::initializer_list<int>{(
+        std::memcpy(&static_cast<typename signature_element<T>::type&>(std::get<I>(data)), p,
+                    sizeof(typename signature_element<T>::type)),
+        p += sizeof(typename signature_element<T>::type), 0)...};
+    return HG_SUCCESS;
+}
+
+template <typename T, typename ... CtxArg>
+std::size_t archive_size(const T& data, margo_instance_id mid,
+                         std::tuple<CtxArg...>& ctx, std::false_type) {
+    size_archive<CtxArg...> ar(ctx, mid);
+#ifdef THALLIUM_DEBUG_RPC_TYPES
+    std::string type_name = get_type_name<T>();
+    ar << type_name;
+#endif
+    ar << data;
+    return ar.size();
+}
+
+template <typename... T, typename ... CtxArg>
+std::size_t archive_size(const std::tuple<T...>&, margo_instance_id,
+                         std::tuple<CtxArg...>&, std::true_type) {
+    return pod_payload_size<T...>::value;
+}
+
+} // namespace detail
+
+/**
+ * @brief Returns the number of bytes that proc_object_encode would
+ * write into a Mercury buffer for the provided data.
+ */
+template <typename T, typename ... CtxArg>
+std::size_t get_encoded_size(const T& data, margo_instance_id mid,
+                             std::tuple<CtxArg...>& ctx) {
+    std::size_t size = detail::archive_size(data, mid, ctx,
+                                            detail::uses_pod_payload<T, CtxArg...>());
+#ifdef THALLIUM_CHECK_RPC_SIGNATURES
+    return size + sizeof(std::uint64_t);
+#else
+    return size;
+#endif
+}
+
+namespace detail {
+
+template <typename T, typename ... CtxArg>
+hg_return_t proc_object_encode_archive(hg_proc_t proc, T& data, margo_instance_id mid,
+                                       std::tuple<CtxArg...>& ctx, std::false_type) {
+    auto tail = opaque_payload_access::tail(data);
+    (void)tail;
+    proc_output_archive<CtxArg...> ar(proc, ctx, mid);
+#ifdef THALLIUM_DEBUG_RPC_TYPES
+    std::string type_name = opaque_payload_access::type_name(tail, get_type_name<T>());
+    ar << type_name;
+#endif
+    ar << data;
+    return HG_SUCCESS;
+}
+
+template <typename... T, typename ... CtxArg>
+hg_return_t proc_object_encode_archive(hg_proc_t proc, std::tuple<T...>& data,
+                                       margo_instance_id, std::tuple<CtxArg...>&,
+                                       std::true_type) {
+    return encode_pod_payload(proc, data, std::index_sequence_for<T...>());
+}
+
+template <typename T, typename ... CtxArg>
+hg_return_t proc_object_decode_archive(hg_proc_t proc, T& data, margo_instance_id mid,
+                                       std::tuple<CtxArg...>& ctx, std::false_type) {
+    auto tail = opaque_payload_access::tail(data);
+    (void)tail;
+    proc_input_archive<CtxArg...> ar(proc, ctx, mid);
+#ifdef THALLIUM_DEBUG_RPC_TYPES
+    std::string requested_type_name = get_type_name<T>();
+    std::string received_type_name;
+    ar >> received_type_name;
+    opaque_payload_access::set_type_name(tail, received_type_name);
+    if(!ends_with_opaque_payload<T>::value && requested_type_name != received_type_name) {
+        std::cerr << "[thallium] RPC type error: invalid decoding from "
+                  << "(" << received_type_name << ") to ("
+                  << requested_type_name << ")" << std::endl;
+        return HG_INVALID_PARAM;
+    }
+#endif
+    ar >> data;
+    return HG_SUCCESS;
+}
+
+template <typename... T, typename ... CtxArg>
+hg_return_t proc_object_decode_archive(hg_proc_t proc, std::tuple<T...>& data,
+                                       margo_instance_id, std::tuple<CtxArg...>&,
+                                       std::true_type) {
+    return decode_pod_payload(proc, data, std::index_sequence_for<T...>());
+}
+
+template <typename T, typename ... CtxArg>
+hg_return_t proc_object_encode_plain(hg_proc_t proc, T& data,
+                                     margo_instance_id mid,
+                                     std::tuple<CtxArg...>& ctx) {
+    // a forwarded opaque_payload carries the type of the original payload
+    auto tail = opaque_payload_access::tail(data);
+    (void)tail;
+#ifdef THALLIUM_CHECK_RPC_SIGNATURES
+    std::uint64_t signature = opaque_payload_access::signature(tail, signature_hash<T>());
+    hg_return_t   ret       = hg_proc_memcpy(proc, &signature, sizeof(signature));
+    if(ret != HG_SUCCESS) return ret;
+#endif
+    return proc_object_encode_archive(proc, data, mid, ctx, uses_pod_payload<T, CtxArg...>());
+}
+
+template <typename T, typename ... CtxArg>
+hg_return_t proc_object_decode_plain(hg_proc_t proc, T& data,
+                                     margo_instance_id mid,
+                                     std::tuple<CtxArg...>& ctx) {
+    // only the leading arguments are checked when the rest is
+    // received as an opaque_payload, which keeps the type of the
+    // payload for when it is forwarded
+    auto tail = opaque_payload_access::tail(data);
+    (void)tail;
+#ifdef THALLIUM_CHECK_RPC_SIGNATURES
+    std::uint64_t signature = 0;
+    hg_return_t   ret       = hg_proc_memcpy(proc, &signature, sizeof(signature));
+    if(ret != HG_SUCCESS) return ret;
+    opaque_payload_access::set_signature(tail, signature);
+    if(!ends_with_opaque_payload<T>::value && signature != signature_hash<T>()) {
+        std::cerr << "[thallium] RPC type error: payload of signature 0x" << std::hex
+                  << signature << " cannot be decoded as (" << get_type_name<T>()
+                  << "), of signature 0x" << signature_hash<T>() << std::dec << std::endl;
+        return HG_INVALID_PARAM;
+    }
+#endif
+    return proc_object_decode_archive(proc, data, mid, ctx, uses_pod_payload<T, CtxArg...>());
+}
+
+template <typename T, typename ... CtxArg>
+hg_return_t proc_object_encode_impl(hg_proc_t proc, T& data,
+                                    margo_instance_id mid,
+                                    std::tuple<CtxArg...>& ctx, std::false_type) {
+    return proc_object_encode_plain(proc, data, mid, ctx);
+}
+
+template <typename T, typename ... CtxArg>
+hg_return_t proc_object_decode_impl(hg_proc_t proc, T& data,
+                                    margo_instance_id mid,
+                                    std::tuple<CtxArg...>& ctx, std::false_type) {
+    return proc_object_decode_plain(proc, data, mid, ctx);
+}
+
+/**
+ * @private
+ * With a compression object in the context, the payload starts with a
+ * byte holding the codec (0 for none). Compressed payloads follow with
+ * the uncompressed and compressed sizes (as 8-byte integers) and the
+ * compressed bytes. The payload is first encoded into a temporary
+ * buffer sized with a size_archive, and sent as-is if it does not
+ * shrink.
+ */
+template <typename T, typename ... CtxArg>
+hg_return_t proc_object_encode_impl(hg_proc_t proc, T& data,
+                                    margo_instance_id mid,
+                                    std::tuple<CtxArg...>& ctx, std::true_type) {
+    const compression* c    = find_compression(ctx);
+    std::uint8_t       flag = 0;
+    std::size_t        size = 0;
+    if(mid != MARGO_INSTANCE_NULL && compression::available(c->algorithm)
+    && c->algorithm != compression::codec::none)
+        size = get_encoded_size(data, mid, ctx);
+    if(size == 0 || size < c->threshold) {
+        hg_return_t ret = hg_proc_memcpy(proc, &flag, sizeof(flag));
+        if(ret != HG_SUCCESS) return ret;
+        return proc_object_encode_plain(proc, data, mid, ctx);
+    }
+    std::vector<char> raw(size);
+    hg_proc_t         tmp = HG_PROC_NULL;
+    hg_return_t       ret = hg_proc_create_set(margo_get_class(mid), raw.data(), raw.size(),
+                                               HG_ENCODE, HG_NOHASH, &tmp);
+    if(ret != HG_SUCCESS) return ret;
+    ret = proc_object_encode_plain(tmp, data, mid, ctx);
+    std::size_t used = hg_proc_get_size_used(tmp);
+    hg_proc_free(tmp);
+    if(ret != HG_SUCCESS) return ret;
+    std::vector<char> packed;
+    if(used > raw.size() || !c->compress(raw.data(), used, packed)) {
+        // not worth it (or the size was underestimated): send uncompressed
+        ret = hg_proc_memcpy(proc, &flag, sizeof(flag));
+        if(ret != HG_SUCCESS) return ret;
+        if(used > raw.size()) return proc_object_encode_plain(proc, data, mid, ctx);
+        return hg_proc_memcpy(proc, raw.data(), used);
+    }
+    flag = static_cast<std::uint8_t>(c->algorithm);
+    std::uint64_t sizes[2] = {used, packed.size()};
+    ret = hg_proc_memcpy(proc, &flag, sizeof(flag));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_memcpy(proc, sizes, sizeof(sizes));
+    if(ret != HG_SUCCESS) return ret;
+    return hg_proc_memcpy(proc, packed.data(), packed.size());
+}
+
+template <typename T, typename ... CtxArg>
+hg_return_t proc_object_decode_impl(hg_proc_t proc, T& data,
+                                    margo_instance_id mid,
+                                    std::tuple<CtxArg...>& ctx, std::true_type) {
+    std::uint8_t flag = 0;
+    hg_return_t  ret  = hg_proc_memcpy(proc, &flag, sizeof(flag));
+    if(ret != HG_SUCCESS) return ret;
+    if(flag == 0) return proc_object_decode_plain(proc, data, mid, ctx);
+    std::uint64_t sizes[2] = {0, 0};
+    ret = hg_proc_memcpy(proc, sizes, sizeof(sizes));
+    if(ret != HG_SUCCESS) return ret;
+    // the sizes come from the sender: a compressed payload cannot
+    // expand more than its codec allows
+    auto codec = static_cast<compression::codec>(flag);
+    if(sizes[1] > hg_proc_get_size_left(proc) || mid == MARGO_INSTANCE_NULL
+    || sizes[0] > sizes[1]*compression::max_expansion(codec))
+        return HG_PROTOCOL_ERROR;
+    std::vector<char> raw(sizes[0]);
+    void* packed = hg_proc_save_ptr(proc, sizes[1]);
+    try {
+        compression::decompress(codec, packed, sizes[1], raw.data(), raw.size());
+    } catch(const exception& ex) {
+        hg_proc_restore_ptr(proc, packed, sizes[1]);
+        std::cerr << "[thallium] " << ex.what() << std::endl;
+        return HG_PROTOCOL_ERROR;
+    }
+    hg_proc_restore_ptr(proc, packed, sizes[1]);
+    hg_proc_t tmp = HG_PROC_NULL;
+    ret = hg_proc_create_set(margo_get_class(mid), raw.data(), raw.size(),
+                             HG_DECODE, HG_NOHASH, &tmp);
+    if(ret != HG_SUCCESS) return ret;
+    opaque_payload_access::set_encoded_size(opaque_payload_access::tail(data), raw.size());
+    ret = proc_object_decode_plain(tmp, data, mid, ctx);
+    hg_proc_free(tmp);
+    // the temporary buffer is about to be released
+    opaque_payload_access::detach(opaque_payload_access::tail(data));
+    return ret;
+}
+
+} // namespace detail
+
 template <typename T, typename ... CtxArg>
 hg_return_t proc_object_encode(hg_proc_t proc, T& data,
                                margo_instance_id mid,
                                std::tuple<CtxArg...>& ctx) {
     switch(hg_proc_get_op(proc)) {
-    case HG_ENCODE: {
-        proc_output_archive<CtxArg...> ar(proc, ctx, mid);
-#ifdef THALLIUM_DEBUG_RPC_TYPES
-        std::string type_name = get_type_name<T>();
-        ar << type_name;
-#endif
-        ar << data;
-    } break;
+    case HG_ENCODE:
+        return detail::proc_object_encode_impl(proc, data, mid, ctx,
+            detail::context_has<compression, CtxArg...>());
     case HG_DECODE:
         return HG_INVALID_ARG; // not supposed to happen
     case HG_FREE:
@@ -81,21 +408,9 @@ hg_return_t proc_object_decode(hg_proc_t proc, T& data,
     switch(hg_proc_get_op(proc)) {
     case HG_ENCODE:
         return HG_INVALID_ARG; // not supposed to happen
-    case HG_DECODE: {
-        proc_input_archive<CtxArg...> ar(proc, ctx, mid);
-#ifdef THALLIUM_DEBUG_RPC_TYPES
-        std::string requested_type_name = get_type_name<T>();
-        std::string received_type_name;
-        ar >> received_type_name;
-        if(requested_type_name != received_type_name) {
-            std::cerr << "[thallium] RPC type error: invalid decoding from "
-                      << "(" << received_type_name << ") to ("
-                      << requested_type_name << ")" << std::endl;
-            return HG_INVALID_PARAM;
-        }
-#endif
-        ar >> data;
-    } break;
+    case HG_DECODE:
+        return detail::proc_object_decode_impl(proc, data, mid, ctx,
+            detail::context_has<compression, CtxArg...>());
     case HG_FREE: {
     }
     default:
@@ -108,6 +423,11 @@ template <typename ... CtxArg>
 inline hg_return_t proc_void_object(hg_proc_t proc, std::tuple<CtxArg...>& ctx) {
     switch(hg_proc_get_op(proc)) {
     case HG_ENCODE: {
+#ifdef THALLIUM_CHECK_RPC_SIGNATURES
+        std::uint64_t signature = detail::void_signature_hash();
+        hg_return_t   ret       = hg_proc_memcpy(proc, &signature, sizeof(signature));
+        if(ret != HG_SUCCESS) return ret;
+#endif
 #ifdef THALLIUM_DEBUG_RPC_TYPES
         proc_output_archive<CtxArg...> ar(proc, ctx);
         std::string         type_name = "void";
@@ -115,6 +435,16 @@ inline hg_return_t proc_void_object(hg_proc_t proc, std::tuple<CtxArg...>& ctx)
 #endif
     } break;
     case HG_DECODE: {
+#ifdef THALLIUM_CHECK_RPC_SIGNATURES
+        std::uint64_t signature = 0;
+        hg_return_t   ret       = hg_proc_memcpy(proc, &signature, sizeof(signature));
+        if(ret != HG_SUCCESS) return ret;
+        if(signature != detail::void_signature_hash()) {
+            std::cerr << "[thallium] RPC type error: payload of signature 0x" << std::hex
+                      << signature << " cannot be decoded as (void)" << std::dec << std::endl;
+            return HG_INVALID_PARAM;
+        }
+#endif
 #ifdef THALLIUM_DEBUG_RPC_TYPES
         proc_input_archive<CtxArg...> ar(proc, ctx);
         std::string        requested_type_name = "void";
@@ -0,0 +1,148 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_PROC_SIZE_HINTS_HPP
+#define __THALLIUM_PROC_SIZE_HINTS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <margo.h>
+#include <mercury_proc.h>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Table of the recently encoded sizes of the arguments (input)
+ * and responses (output) of each RPC id, shared by all the engines of
+ * the process. Each entry is a high-water mark that moves up to any
+ * larger size at once and halves its gap to smaller ones, so that a
+ * payload of stable size is predicted exactly and a single outlier is
+ * forgotten within a few calls. Hints are capped at max_hint, since
+ * presizing above the actual payload makes Mercury transfer the extra
+ * bytes too. Entries are never removed; once the table is full, new ids
+ * get no hint.
+ */
+class proc_size_hints {
+
+    static constexpr std::size_t num_slots = 512;
+
+  public:
+
+    // largest buffer presized from a hint
+    static constexpr std::size_t max_hint = 4 * 1024 * 1024;
+
+  private:
+
+    struct slot {
+        std::atomic<std::uint64_t> key{0};
+        std::atomic<std::size_t>   size{0};
+    };
+
+    slot m_slots[num_slots];
+
+    static std::uint64_t make_key(hg_id_t id, bool output) noexcept {
+        // the low bit tells input from output, and 0 means empty
+        return ((static_cast<std::uint64_t>(id) << 1) | (output ? 1 : 0)) + 2;
+    }
+
+    slot* find(std::uint64_t key, bool insert) noexcept {
+        std::size_t start = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> 55);
+        for(std::size_t i = 0; i < num_slots; i++) {
+            slot&         s   = m_slots[(start + i) % num_slots];
+            std::uint64_t cur = s.key.load(std::memory_order_acquire);
+            if(cur == key) return &s;
+            if(cur != 0) continue;
+            if(!insert) return nullptr;
+            if(s.key.compare_exchange_strong(cur, key, std::memory_order_acq_rel)
+            || cur == key)
+                return &s;
+        }
+        return nullptr;
+    }
+
+  public:
+
+    static proc_size_hints& instance() {
+        static proc_size_hints hints;
+        return hints;
+    }
+
+    static std::atomic<bool>& enabled() {
+        static std::atomic<bool> flag{true};
+        return flag;
+    }
+
+    /**
+     * @brief Returns the expected encoded size of the input or output
+     * of the RPC id, or 0 if unknown.
+     */
+    std::size_t get(hg_id_t id, bool output) noexcept {
+        slot* s = find(make_key(id, output), false);
+        return s ? s->size.load(std::memory_order_relaxed) : 0;
+    }
+
+    /**
+     * @brief Records the encoded size of an input or output of the RPC id.
+     */
+    void record(hg_id_t id, bool output, std::size_t size) noexcept {
+        slot* s = find(make_key(id, output), true);
+        if(!s) return;
+        if(size > max_hint) size = max_hint;
+        std::size_t cur  = s->size.load(std::memory_order_relaxed);
+        std::size_t next = size >= cur ? size : size + (cur - size) / 2;
+        s->size.store(next, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @private
+ * @brief Calls encode(proc) to serialize the input (or output) of the
+ * RPC of the provided handle. If the payload of this RPC is expected
+ * not to fit in what remains of the proc's buffer, the buffer is first
+ * grown to the expected size in one step: otherwise Mercury extends it
+ * (and copies it) by a page or so each time the next field does not
+ * fit, which for payloads of a few hundred kilobytes means tens of
+ * reallocations per RPC.
+ */
+template <typename F>
+hg_return_t encode_with_size_hint(hg_proc_t proc, hg_handle_t handle, bool output,
+                                  F&& encode) {
+    if(handle == HG_HANDLE_NULL || !proc_size_hints::enabled().load(std::memory_order_relaxed))
+        return encode(proc);
+    const struct hg_info* info = margo_get_info(handle);
+    if(!info) return encode(proc);
+    auto&       hints = proc_size_hints::instance();
+    std::size_t start = hg_proc_get_size_used(proc);
+    std::size_t hint  = hints.get(info->id, output);
+    if(hint > hg_proc_get_size_left(proc))
+        hg_proc_set_size(proc, start + hint); // just a hint if it fails
+    hg_return_t ret = encode(proc);
+    if(ret == HG_SUCCESS) hints.record(info->id, output, hg_proc_get_size_used(proc) - start);
+    return ret;
+}
+
+} // namespace detail
+
+/**
+ * @brief Enables or disables (for all the engines of the process) the
+ * presizing of Mercury's serialization buffers from the sizes recently
+ * encoded for the same RPC, which saves the successive reallocations of
+ * payloads larger than the eager buffer. It is enabled by default. The
+ * buffer may be sized a little above the actual payload after a larger
+ * one was sent, and such a buffer is transferred in full; hints are
+ * capped at 4 MiB, and the gap left by a larger payload halves with
+ * each call.
+ */
+inline void enable_proc_size_hints(bool enable = true) {
+    detail::proc_size_hints::enabled() = enable;
+}
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,224 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_PROGRESS_POLICY_HPP
+#define __THALLIUM_PROGRESS_POLICY_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <unordered_map>
+#include <margo.h>
+#include <margo-timer.h>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Breakdown of the time spent by the progress loop over an
+ * interval, passed to progress_policy::on_report.
+ *
+ * busy is the CPU time consumed by the execution stream running the
+ * progress loop, so it is only meaningful when that execution stream
+ * does nothing else (i.e. with a dedicated progress thread).
+ */
+struct progress_report {
+    std::chrono::nanoseconds interval{0}; /*!< wall-clock time covered by the report */
+    std::chrono::nanoseconds busy{0};     /*!< CPU time of the progress execution stream */
+    std::chrono::nanoseconds work{0};     /*!< time spent dispatching incoming RPCs */
+    std::size_t              rpcs = 0;    /*!< number of RPCs dispatched */
+
+    /**
+     * @brief Time spent polling the network without doing work.
+     */
+    std::chrono::nanoseconds polling() const {
+        return busy > work ? busy - work : std::chrono::nanoseconds(0);
+    }
+
+    /**
+     * @brief Time spent blocked, waiting for network events.
+     */
+    std::chrono::nanoseconds blocked() const {
+        return interval > busy ? interval - busy : std::chrono::nanoseconds(0);
+    }
+};
+
+/**
+ * @brief A progress_policy tells the engine how its progress loop should
+ * trade latency for CPU usage. After any network activity the loop keeps
+ * polling without blocking for spin_duration, so that a burst of RPCs is
+ * served with polling latency; once idle for longer, it blocks in
+ * Mercury for up to max_block at a time (waking up earlier on network
+ * events or timers), so that idle cores don't burn.
+ *
+ * \code{.cpp}
+ * tl::progress_policy policy;
+ * policy.spin_duration   = std::chrono::milliseconds(50);
+ * policy.max_block       = std::chrono::milliseconds(100);
+ * policy.on_report       = [](const tl::progress_report& r) { ... };
+ * tl::engine engine("ofi+tcp", THALLIUM_SERVER_MODE, policy, true);
+ * \endcode
+ */
+struct progress_policy {
+    std::chrono::milliseconds spin_duration{10};     /*!< polling window after activity */
+    std::chrono::milliseconds max_block{100};        /*!< maximum blocking time when idle */
+    std::chrono::milliseconds report_interval{1000}; /*!< interval between reports */
+    std::function<void(const progress_report&)> on_report; /*!< optional reporting hook */
+
+    /**
+     * @brief Returns a policy that never blocks.
+     */
+    static progress_policy busy_poll() {
+        progress_policy p;
+        p.spin_duration = std::chrono::milliseconds(24*3600*1000);
+        return p;
+    }
+
+    /**
+     * @brief Returns a policy that blocks as soon as there is nothing to do.
+     */
+    static progress_policy blocking() {
+        progress_policy p;
+        p.spin_duration = std::chrono::milliseconds(0);
+        return p;
+    }
+
+    /**
+     * @brief Returns the JSON fields of margo's configuration that
+     * implement this policy (without enclosing braces).
+     */
+    std::string to_json_fields() const {
+        return "\"progress_spindown_msec\" : " + std::to_string(spin_duration.count())
+             + ", \"progress_timeout_ub_msec\" : " + std::to_string(max_block.count());
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Produces the progress_reports of a margo instance, attached to
+ * it by engine constructors taking a progress_policy with an on_report
+ * hook. Work is accounted in thallium_rpc_handler, which runs in the
+ * progress loop, and reports are produced by a margo timer.
+ */
+class progress_monitor : public per_instance<progress_monitor> {
+
+    margo_instance_id        m_mid;
+    std::function<void(const progress_report&)> m_callback;
+    double                   m_interval_ms;
+    margo_timer_t            m_timer = MARGO_TIMER_NULL;
+    std::atomic<bool>        m_stopped{false};
+    std::atomic<bool>        m_has_clock{false};
+    clockid_t                m_clock;
+    std::atomic<std::int64_t> m_work_ns{0};
+    std::atomic<std::size_t> m_rpcs{0};
+    // values at the previous report
+    std::chrono::steady_clock::time_point m_last_wall;
+    std::int64_t                          m_last_cpu_ns  = 0;
+    std::int64_t                          m_last_work_ns = 0;
+    std::size_t                           m_last_rpcs    = 0;
+
+    std::int64_t cpu_ns() const {
+        if(!m_has_clock.load(std::memory_order_acquire)) return 0;
+        struct timespec ts;
+        if(clock_gettime(m_clock, &ts) != 0) return 0;
+        return static_cast<std::int64_t>(ts.tv_sec)*1000000000 + ts.tv_nsec;
+    }
+
+    static void on_timer(void* arg) {
+        auto self = static_cast<progress_monitor*>(arg);
+        if(self->m_stopped.load()) return;
+        self->report();
+        if(!self->m_stopped.load())
+            margo_timer_start(self->m_timer, self->m_interval_ms);
+    }
+
+    void report() {
+        auto         wall = std::chrono::steady_clock::now();
+        std::int64_t cpu  = cpu_ns();
+        std::int64_t work = m_work_ns.load(std::memory_order_relaxed);
+        std::size_t  rpcs = m_rpcs.load(std::memory_order_relaxed);
+        progress_report r;
+        r.interval = std::chrono::duration_cast<std::chrono::nanoseconds>(wall - m_last_wall);
+        r.busy     = std::chrono::nanoseconds(cpu - m_last_cpu_ns);
+        r.work     = std::chrono::nanoseconds(work - m_last_work_ns);
+        r.rpcs     = rpcs - m_last_rpcs;
+        m_last_wall    = wall;
+        m_last_cpu_ns  = cpu;
+        m_last_work_ns = work;
+        m_last_rpcs    = rpcs;
+        try {
+            m_callback(r);
+        } catch(...) {}
+    }
+
+    // prefinalize: stop reporting while the progress loop still runs
+    static void stop(void* arg) {
+        auto self = static_cast<progress_monitor*>(arg);
+        self->m_stopped = true;
+        margo_timer_cancel(self->m_timer);
+    }
+
+    // finalize: the progress loop has stopped, no callback can be running
+    static void destroy(void* arg) {
+        auto self = uninstall(static_cast<margo_instance_id>(arg));
+        if(self) margo_timer_destroy(self->m_timer);
+    }
+
+    progress_monitor(margo_instance_id mid, std::function<void(const progress_report&)> cb,
+                     std::chrono::milliseconds interval)
+    : m_mid(mid)
+    , m_callback(std::move(cb))
+    , m_interval_ms(static_cast<double>(interval.count()))
+    , m_last_wall(std::chrono::steady_clock::now()) {}
+
+  public:
+
+    /**
+     * @brief Creates the monitor of a margo instance and starts reporting.
+     */
+    static std::shared_ptr<progress_monitor>
+    install(margo_instance_id mid, std::function<void(const progress_report&)> cb,
+            std::chrono::milliseconds interval) {
+        std::shared_ptr<progress_monitor> self(
+            new progress_monitor(mid, std::move(cb), interval));
+        if(margo_timer_create(mid, &progress_monitor::on_timer, self.get(), &self->m_timer) != 0)
+            return nullptr;
+        per_instance::install(mid, self);
+        margo_provider_push_prefinalize_callback(mid, self.get(), &progress_monitor::stop,
+                                                 self.get());
+        margo_provider_push_finalize_callback(mid, self.get(), &progress_monitor::destroy, mid);
+        margo_timer_start(self->m_timer, self->m_interval_ms);
+        return self;
+    }
+
+    /**
+     * @brief Records the CPU clock of the calling OS thread, which must
+     * be the one running the progress loop.
+     */
+    void capture_clock() {
+        if(pthread_getcpuclockid(pthread_self(), &m_clock) != 0) return;
+        m_has_clock.store(true, std::memory_order_release);
+        m_last_cpu_ns = cpu_ns();
+    }
+
+    void add_work(std::chrono::nanoseconds t) {
+        m_work_ns.fetch_add(t.count(), std::memory_order_relaxed);
+        m_rpcs.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
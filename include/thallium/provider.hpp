@@ -6,22 +6,257 @@
 #ifndef __THALLIUM_PROVIDER_HPP
 #define __THALLIUM_PROVIDER_HPP
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <margo.h>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <thallium/busy.hpp>
 #include <thallium/engine.hpp>
 #include <thallium/exception.hpp>
 #include <thallium/margo_exception.hpp>
 #include <thallium/margo_instance_ref.hpp>
+#include <thallium/per_instance.hpp>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace thallium {
 
 typedef std::integral_constant<bool, true> ignore_return_value;
 
+namespace detail {
+
+/**
+ * @private
+ * @brief Handler generated by provider::define for a member function
+ * given as a template argument: the call to the member function is
+ * resolved at compile time and inlined in the RPC's callback.
+ * WithRequest tells whether the member function takes the request as
+ * first argument, in which case its return value is ignored; otherwise
+ * a non-void return value is sent as response.
+ */
+template <typename T, typename M, M Method, typename R, bool WithRequest>
+struct bound_member_handler {
+    T* self;
+
+    template <typename... A> void operator()(const request& req, A&&... args) const {
+        call(std::integral_constant<bool, WithRequest>(), std::is_void<R>(),
+             req, std::forward<A>(args)...);
+    }
+
+  private:
+    template <typename V, typename... A>
+    void call(std::true_type, V, const request& req, A&&... args) const {
+        (self->*Method)(req, std::forward<A>(args)...);
+    }
+
+    template <typename... A>
+    void call(std::false_type, std::true_type, const request&, A&&... args) const {
+        (self->*Method)(std::forward<A>(args)...);
+    }
+
+    template <typename... A>
+    void call(std::false_type, std::false_type, const request& req, A&&... args) const {
+        R r = (self->*Method)(std::forward<A>(args)...);
+        req.respond(r);
+    }
+};
+
+/**
+ * @private
+ * @brief Signature of the RPC defined by a member function of type M,
+ * as a function pointer taking the request followed by the arguments
+ * (the request, if the member function takes it, is not repeated).
+ */
+template <typename R, typename... Args> struct bound_member_signature {
+    using return_type = R;
+    static constexpr bool with_request = false;
+    using type = void (*)(const request&, Args...);
+};
+
+template <typename R, typename... Args>
+struct bound_member_signature<R, const request&, Args...> {
+    using return_type = R;
+    static constexpr bool with_request = true;
+    using type = void (*)(const request&, Args...);
+};
+
+template <typename M> struct bound_member_traits;
+
+template <typename C, typename R, typename... Args>
+struct bound_member_traits<R (C::*)(Args...)>
+: bound_member_signature<R, Args...> {};
+
+template <typename C, typename R, typename... Args>
+struct bound_member_traits<R (C::*)(Args...) const>
+: bound_member_signature<R, Args...> {};
+
+/**
+ * @private
+ * @brief Instances of a provider class by provider id, shared by the
+ * RPCs the class defines with provider::define_shared. Slots are in
+ * pages of 256 allocated on first use, so finding the instance a
+ * request targets takes two array lookups. Each slot also counts the
+ * handlers running on its instance, so that clearing it can wait for
+ * them.
+ */
+template <typename T> class tenant_table {
+
+    static constexpr std::size_t page_size = 256;
+    static constexpr std::size_t num_pages =
+        (std::size_t(std::numeric_limits<uint16_t>::max()) + 1) / page_size;
+
+    struct slot {
+        std::atomic<T*>            instance{nullptr};
+        std::atomic<std::uint32_t> active{0};
+    };
+
+    std::mutex                           m_mutex;
+    std::atomic<slot*>                   m_pages[num_pages];
+    std::vector<std::unique_ptr<slot[]>> m_owned;
+
+    slot* find(uint16_t provider_id) const {
+        slot* page = m_pages[provider_id / page_size].load(std::memory_order_acquire);
+        return page ? &page[provider_id % page_size] : nullptr;
+    }
+
+  public:
+
+    tenant_table() {
+        for(auto& p : m_pages) p.store(nullptr, std::memory_order_relaxed);
+    }
+
+    void set(uint16_t provider_id, T* instance) {
+        slot* page = m_pages[provider_id / page_size].load(std::memory_order_acquire);
+        if(!page) {
+            if(!instance) return;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            page = m_pages[provider_id / page_size].load(std::memory_order_relaxed);
+            if(!page) {
+                m_owned.emplace_back(new slot[page_size]);
+                page = m_owned.back().get();
+                m_pages[provider_id / page_size].store(page, std::memory_order_release);
+            }
+        }
+        page[provider_id % page_size].instance.store(instance);
+    }
+
+    /**
+     * @brief Clears the slot of provider_id and waits for the handlers
+     * running on its instance to return.
+     */
+    void clear(uint16_t provider_id) {
+        slot* s = find(provider_id);
+        if(!s) return;
+        // sequentially consistent with enter(): a handler either sees
+        // the cleared slot or is counted here
+        s->instance.store(nullptr);
+        while(s->active.load() != 0) ABT_thread_yield();
+    }
+
+    /**
+     * @brief Returns the instance of provider_id, counting the caller
+     * as running on it until leave(provider_id), or nullptr.
+     */
+    T* enter(uint16_t provider_id) {
+        slot* s = find(provider_id);
+        if(!s) return nullptr;
+        s->active.fetch_add(1);
+        T* instance = s->instance.load();
+        if(!instance) leave(provider_id);
+        return instance;
+    }
+
+    void leave(uint16_t provider_id) {
+        find(provider_id)->active.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+/**
+ * @private
+ * @brief Handler of an RPC defined with provider::define_shared: calls
+ * the member function on the instance registered for the provider id
+ * the request was sent to, which margo keeps in the low bits of the
+ * RPC id. Requests for a provider id whose instance is gone get a busy
+ * response; the instance is not destroyed while the call runs (see
+ * provider::leave_shared_rpcs).
+ */
+template <typename T, typename M, M Method, typename R, bool WithRequest>
+struct tenant_member_handler {
+    std::shared_ptr<tenant_table<T>> tenants;
+
+    template <typename... A> void operator()(const request& req, A&&... args) const {
+        hg_handle_t           h    = req.native_handle();
+        const struct hg_info* info = margo_get_info(h);
+        uint16_t provider_id = info ? static_cast<uint16_t>(info->id & MARGO_MAX_PROVIDER_ID) : 0;
+        T*       self        = info ? tenants->enter(provider_id) : nullptr;
+        if(!self) {
+            int disabled = 0;
+            if(info)
+                margo_registered_disabled_response(margo_hg_handle_get_instance(h), info->id,
+                                                   &disabled);
+            if(!disabled) respond_busy(h);
+            return;
+        }
+        struct leave_guard {
+            tenant_table<T>& tenants;
+            uint16_t         provider_id;
+            ~leave_guard() { tenants.leave(provider_id); }
+        } guard{*tenants, provider_id};
+        bound_member_handler<T, M, Method, R, WithRequest>{self}(req, std::forward<A>(args)...);
+    }
+};
+
+/**
+ * @private
+ * @brief Tenant tables and shared RPC callbacks of the provider classes
+ * using provider::define_shared, for each margo instance. They are
+ * released when the margo instance is finalized.
+ */
+class tenant_registry : public per_instance<tenant_registry> {
+
+    std::mutex                                              m_mutex;
+    std::unordered_map<std::type_index, std::shared_ptr<void>> m_tables;
+    std::unordered_map<std::string, std::shared_ptr<void>>     m_callbacks;
+
+  public:
+
+    static std::shared_ptr<tenant_registry> get(margo_instance_id mid) {
+        return per_instance::get(mid, instance_release::at_finalize);
+    }
+
+    template <typename T> std::shared_ptr<tenant_table<T>> table() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& t = m_tables[std::type_index(typeid(T))];
+        if(!t) t = std::make_shared<tenant_table<T>>();
+        return std::static_pointer_cast<tenant_table<T>>(t);
+    }
+
+    /**
+     * @brief Returns the callback of the RPC name of class T, creating
+     * it with make() the first time.
+     */
+    template <typename T, typename F>
+    std::shared_ptr<void> callback(const std::string& name, F&& make) {
+        std::string key = std::string(typeid(T).name()) + '/' + name;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& c = m_callbacks[key];
+        if(!c) c = make();
+        return c;
+    }
+};
+
+} // namespace detail
+
 /**
  * @brief The provider class represents an object that
  * exposes its member functions as RPCs. It is a template
@@ -36,6 +271,7 @@ template <typename T> class provider {
     margo_instance_ref m_mid;
     uint16_t           m_provider_id;
     bool               m_has_identity;
+    std::shared_ptr<detail::tenant_table<T>> m_tenants;
 
   public:
     provider(const engine& e, uint16_t provider_id, const char* identity = nullptr)
@@ -61,6 +297,7 @@ template <typename T> class provider {
     }
 
     virtual ~provider() {
+        leave_shared_rpcs();
 #if MARGO_VERSION_NUM >= 1500
         if(m_has_identity)
             margo_provider_deregister_identity(m_mid, m_provider_id);
@@ -87,6 +324,19 @@ template <typename T> class provider {
      */
     provider& operator=(const provider& other) = delete;
 
+    /**
+     * @brief Stops the RPCs defined with define_shared from reaching
+     * this instance (they get a busy response instead) and waits for
+     * their handlers running on it to return. ~provider() calls it, but
+     * only once the derived class is destroyed: a class defining shared
+     * RPCs should call it first in its own destructor, so that no
+     * handler runs on a partially destroyed instance. It must not be
+     * called from one of these handlers.
+     */
+    void leave_shared_rpcs() {
+        if(m_tenants) m_tenants->clear(m_provider_id);
+    }
+
     /**
      * @brief Returns the identity of the provider.
      */
@@ -113,7 +363,7 @@ template <typename T> class provider {
         T* self = static_cast<T*>(this);
         std::function<void(const request&, Args...)> fun =
             [self, func](const request& req, Args... args) {
-                (self->*func)(req, args...);
+                (self->*func)(req, std::forward<Args>(args)...);
             };
         return get_engine().define(std::forward<S>(name), fun, m_provider_id, p);
     }
@@ -132,7 +382,7 @@ template <typename T> class provider {
         T* self = static_cast<T*>(this);
         std::function<void(const request&, Args...)> fun =
             [self, func](const request& req, Args... args) {
-                R r = (self->*func)(args...);
+                R r = (self->*func)(std::forward<Args>(args)...);
                 req.respond(r);
             };
         return get_engine().define(std::forward<S>(name), fun, m_provider_id, p);
@@ -152,7 +402,7 @@ template <typename T> class provider {
         T* self = static_cast<T*>(this);
         std::function<void(const request&, Args...)> fun =
             [self, func](const request& req, Args... args) {
-                (self->*func)(req, args...);
+                (self->*func)(req, std::forward<Args>(args)...);
             };
         return get_engine().define(std::forward<S>(name), fun, m_provider_id, p);
     }
@@ -171,7 +421,7 @@ template <typename T> class provider {
         std::function<void(const request&, Args...)> fun =
             [self, func](const request& req, Args... args) {
                 (void)req;
-                (self->*func)(args...);
+                (self->*func)(std::forward<Args>(args)...);
             };
         return get_engine().define(std::forward<S>(name), fun, m_provider_id, p)
             .disable_response();
@@ -195,7 +445,7 @@ template <typename T> class provider {
         T* self = static_cast<T*>(this);
         std::function<void(const request&, Args...)> fun =
             [self, func](const request& req, Args... args) {
-                (self->*func)(req, args...);
+                (self->*func)(req, std::forward<Args>(args)...);
             };
         return get_engine().define(std::forward<S>(name), fun, m_provider_id, p);
     }
@@ -214,7 +464,7 @@ template <typename T> class provider {
         T* self = static_cast<T*>(this);
         std::function<void(const request&, Args...)> fun =
             [self, func](const request& req, Args... args) {
-                R r = (self->*func)(args...);
+                R r = (self->*func)(std::forward<Args>(args)...);
                 req.respond(r);
             };
         return get_engine().define(std::forward<S>(name), fun, m_provider_id, p);
@@ -234,7 +484,7 @@ template <typename T> class provider {
         T* self = static_cast<T*>(this);
         std::function<void(const request&, Args...)> fun =
             [self, func](const request& req, Args... args) {
-                (self->*func)(req, args...);
+                (self->*func)(req, std::forward<Args>(args)...);
             };
         return get_engine().define(std::forward<S>(name), fun, m_provider_id, p);
     }
@@ -253,12 +503,32 @@ template <typename T> class provider {
         std::function<void(const request&, Args...)> fun =
             [self, func](const request& req, Args... args) {
                 (void)req;
-                (self->*func)(args...);
+                (self->*func)(std::forward<Args>(args)...);
             };
         return get_engine().define(std::forward<S>(name), fun, m_provider_id, p)
             .disable_response();
     }
 
+    // define with a member function known at compile time, for the
+    // case the RPC takes arguments
+    template <typename S, typename H, typename A1, typename... Args>
+    remote_procedure define_bound(S&& name, H&& handler,
+                                  void (*signature)(const request&, A1, Args...),
+                                  const pool& p) {
+        return get_engine().define_impl(std::forward<S>(name), std::forward<H>(handler),
+                                        signature, m_provider_id, p);
+    }
+
+    // define with a member function known at compile time, for the
+    // case the RPC takes no argument
+    template <typename S, typename H>
+    remote_procedure define_bound(S&& name, H&& handler,
+                                  void (*)(const request&), const pool& p) {
+        return get_engine().define(std::forward<S>(name),
+                                   std::function<void(const request&)>(std::forward<H>(handler)),
+                                   m_provider_id, p);
+    }
+
   protected:
     /**
      * @brief Defines an RPC using a member function of the child class.
@@ -357,6 +627,158 @@ template <typename T> class provider {
                              first_arg_is_request, pool());
     }
 
+    /**
+     * @brief Defines an RPC using a member function of the child class
+     * given as a template argument. Unlike define(name, &T::func), which
+     * stores the member function pointer in an std::function called by
+     * the RPC's callback, the call is resolved at compile time and the
+     * decoding of the arguments and the call are generated as a single
+     * callback, saving an indirect call per request. The member function
+     * follows the same conventions as with define(name, &T::func).
+     *
+     * \code{.cpp}
+     * my_provider(tl::engine& e, uint16_t id)
+     * : tl::provider<my_provider>(e, id) {
+     *     define<decltype(&my_provider::put), &my_provider::put>("put");
+     *     // C++17: define<&my_provider::put>("put");
+     * }
+     * \endcode
+     *
+     * @tparam M type of the member function
+     * @tparam Method member function
+     * @tparam S type of the name (e.g. C-like string or std::string)
+     * @param name name of the RPC
+     * @param p Argobots pool
+     */
+    template <typename M, M Method, typename S>
+    inline remote_procedure define(S&& name, const pool& p = pool()) {
+        using traits = detail::bound_member_traits<M>;
+        using handler_type =
+            detail::bound_member_handler<T, M, Method, typename traits::return_type,
+                                         traits::with_request>;
+        auto rpc = define_bound(std::forward<S>(name), handler_type{static_cast<T*>(this)},
+                                typename traits::type(nullptr), p);
+        if(!traits::with_request && std::is_void<typename traits::return_type>::value)
+            rpc.disable_response();
+        return rpc;
+    }
+
+#if __cplusplus >= 201703L
+    template <auto Method, typename S>
+    inline remote_procedure define(S&& name, const pool& p = pool()) {
+        return define<decltype(Method), Method>(std::forward<S>(name), p);
+    }
+#endif
+
+    /**
+     * @brief Same as define<M, Method>(name), but the RPC's callback is
+     * shared by all the instances of T that define it with
+     * define_shared on the same engine, rather than created for each of
+     * them: the instance targeted by a request is found by its provider
+     * id in a table. This makes creating an instance cheap when a
+     * server hosts many instances (tenants) of the same provider class.
+     * The destructor of T should start with leave_shared_rpcs().
+     * Margo still registers the RPC for each provider id, since
+     * Mercury dispatches requests on the full RPC id. The requests in
+     * flight of a shared RPC are counted together in finalize_with's
+     * report.
+     *
+     * \code{.cpp}
+     * // one callback for "put", whatever the number of tenants
+     * define_shared<decltype(&tenant::put), &tenant::put>("put");
+     * \endcode
+     *
+     * @tparam M type of the member function
+     * @tparam Method member function
+     * @tparam S type of the name (e.g. C-like string or std::string)
+     * @param name name of the RPC
+     * @param p Argobots pool
+     */
+    template <typename M, M Method, typename S>
+    inline remote_procedure define_shared(S&& name, const pool& p = pool()) {
+        using traits = detail::bound_member_traits<M>;
+        using handler_type =
+            detail::tenant_member_handler<T, M, Method, typename traits::return_type,
+                                          traits::with_request>;
+        std::string rpc_name(std::forward<S>(name));
+        auto        reg = detail::tenant_registry::get(m_mid);
+        if(!m_tenants) m_tenants = reg->template table<T>();
+        m_tenants->set(m_provider_id, static_cast<T*>(this));
+        auto tenants = m_tenants;
+        engine e = get_engine();
+        auto cb_data = reg->template callback<T>(rpc_name, [&e, &rpc_name, &tenants]() {
+            return e.make_shared_rpc_callback(rpc_name, handler_type{tenants},
+                                              typename traits::type(nullptr));
+        });
+        auto rpc = e.register_shared_rpc(rpc_name, cb_data, m_provider_id, p);
+        if(!traits::with_request && std::is_void<typename traits::return_type>::value)
+            rpc.disable_response();
+        return rpc;
+    }
+
+#if __cplusplus >= 201703L
+    template <auto Method, typename S>
+    inline remote_procedure define_shared(S&& name, const pool& p = pool()) {
+        return define_shared<decltype(Method), Method>(std::forward<S>(name), p);
+    }
+#endif
+
+    /**
+     * @brief Defines RPCs from a table of (name, member function) pairs,
+     * all handled in the same pool.
+     *
+     * \code{.cpp}
+     * auto rpcs = define_all(pool,
+     *     std::make_pair("put", &my_provider::put),
+     *     std::make_pair("get", &my_provider::get));
+     * \endcode
+     *
+     * @param p Argobots pool
+     * @param entries pairs of a name and a member function
+     *
+     * @return the remote_procedure objects, in the order of the entries.
+     */
+    template <typename... F>
+    std::array<remote_procedure, sizeof...(F)>
+    define_all(const pool& p, const std::pair<const char*, F>&... entries) {
+        // braced initializers are evaluated in order
+        return {{define(entries.first, entries.second, p)...}};
+    }
+
+    template <typename... F>
+    std::array<remote_procedure, sizeof...(F)>
+    define_all(const std::pair<const char*, F>&... entries) {
+        return define_all(pool(), entries...);
+    }
+
+    /**
+     * @brief Defines an RPC whose requests are coalesced into batches
+     * handed to a member function of the child class.
+     * See engine::define_batched.
+     *
+     * @tparam S type of the name (e.g. C-like string or std::string)
+     * @tparam Args types of the arguments of the RPC
+     * @param name name of the RPC
+     * @param T::*func member function
+     * @param max_batch_size maximum number of requests in a batch
+     * @param max_delay maximum time the first request of a batch waits
+     * @param p Argobots pool
+     */
+    template <typename S, typename... Args>
+    inline remote_procedure define_batched(
+        S&& name, void (T::*func)(request_batch<Args...>&),
+        std::size_t max_batch_size, std::chrono::microseconds max_delay,
+        const pool& p = pool()) {
+        T* self = static_cast<T*>(this);
+        std::function<void(request_batch<Args...>&)> fun =
+            [self, func](request_batch<Args...>& batch) {
+                (self->*func)(batch);
+            };
+        return get_engine().define_batched(std::forward<S>(name), fun,
+                                           max_batch_size, max_delay,
+                                           m_provider_id, p);
+    }
+
   public:
     /**
      * @brief Get the engine associated with this provider.
@@ -0,0 +1,221 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_PROVIDER_GROUP_HPP
+#define __THALLIUM_PROVIDER_GROUP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/provider_handle.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief 64-bit FNV-1a hash of a range of bytes, followed by the
+ * splitmix64 finalizer so that close inputs land far apart on the ring.
+ * Unlike std::hash, it is the same in every process, which is what
+ * lets all the clients of a provider_group route a key identically.
+ */
+inline std::uint64_t ring_hash(const void* data, std::size_t size,
+                               std::uint64_t seed = 0) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    std::uint64_t        h = 14695981039346656037ull ^ seed;
+    for(std::size_t i = 0; i < size; i++) h = (h ^ p[i]) * 1099511628211ull;
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+} // namespace detail
+
+/**
+ * @brief A provider_group spreads keys over a set of providers with
+ * consistent hashing: each member is placed at virtual_nodes points of
+ * a 64-bit ring, and a key goes to the member owning the first point
+ * at or after its hash. Looking a key up is a binary search, and when
+ * a member is added or removed only the keys of the arcs it gains or
+ * loses (about 1/N of them) change member.
+ *
+ * \code{.cpp}
+ * tl::provider_group group(engine);
+ * for(auto& addr : servers) group.add(addr, provider_id);
+ * std::string value = get.on(group.pick(key))(key);
+ * \endcode
+ *
+ * Members are identified by their address and provider id, and their
+ * positions only depend on these, so clients with the same members
+ * route keys the same way, whatever the order in which they added them.
+ * Addresses are resolved once, when the member is added, through the
+ * engine's address cache (enabled by the constructor). pick() may be
+ * called concurrently with add() and remove().
+ */
+class provider_group {
+
+    struct member {
+        std::string     address;
+        provider_handle handle;
+    };
+
+    // immutable snapshot of the membership, replaced on every change
+    struct ring {
+        std::vector<member>                                 members;
+        std::vector<std::pair<std::uint64_t, std::size_t>> points;
+    };
+
+    engine                      m_engine;
+    std::size_t                 m_virtual_nodes;
+    mutable std::mutex          m_mutex;
+    std::shared_ptr<const ring> m_ring = std::make_shared<ring>();
+
+    std::shared_ptr<const ring> snapshot() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_ring;
+    }
+
+    void rebuild(std::vector<member> members) {
+        auto r = std::make_shared<ring>();
+        r->points.reserve(members.size() * m_virtual_nodes);
+        for(std::size_t m = 0; m < members.size(); m++) {
+            std::string   id = members[m].address + '#'
+                             + std::to_string(members[m].handle.provider_id());
+            std::uint64_t h  = detail::ring_hash(id.data(), id.size());
+            for(std::uint64_t v = 0; v < m_virtual_nodes; v++)
+                r->points.emplace_back(detail::ring_hash(&v, sizeof(v), h), m);
+        }
+        r->members = std::move(members);
+        // ties (vanishingly rare) are broken by member identity rather
+        // than insertion order, so that all the clients agree
+        std::sort(r->points.begin(), r->points.end(),
+                  [&r](const std::pair<std::uint64_t, std::size_t>& a,
+                       const std::pair<std::uint64_t, std::size_t>& b) {
+                      if(a.first != b.first) return a.first < b.first;
+                      const member& ma = r->members[a.second];
+                      const member& mb = r->members[b.second];
+                      if(ma.address != mb.address) return ma.address < mb.address;
+                      return ma.handle.provider_id() < mb.handle.provider_id();
+                  });
+        m_ring = std::move(r);
+    }
+
+    static std::vector<member>::const_iterator find(const std::vector<member>& members,
+                                                    const std::string& address,
+                                                    std::uint16_t provider_id) {
+        return std::find_if(members.begin(), members.end(), [&](const member& m) {
+            return m.address == address && m.handle.provider_id() == provider_id;
+        });
+    }
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param e Engine used to resolve the addresses of the members.
+     * @param virtual_nodes Number of points of each member on the ring.
+     * More points spread the keys more evenly, at the cost of memory
+     * and of a slightly longer lookup.
+     */
+    explicit provider_group(const engine& e, std::size_t virtual_nodes = 128)
+    : m_engine(e)
+    , m_virtual_nodes(virtual_nodes ? virtual_nodes : 1) {
+        m_engine.enable_address_cache();
+    }
+
+    provider_group(const provider_group&)            = delete;
+    provider_group& operator=(const provider_group&) = delete;
+
+    /**
+     * @brief Adds a member to the group, if not already present.
+     *
+     * @param address Address of the member.
+     * @param provider_id Provider id of the member.
+     */
+    void add(const std::string& address, std::uint16_t provider_id = 0) {
+        endpoint                    ep = m_engine.lookup(address);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(find(m_ring->members, address, provider_id) != m_ring->members.end()) return;
+        std::vector<member> members = m_ring->members;
+        members.push_back(member{address, provider_handle(std::move(ep), provider_id)});
+        rebuild(std::move(members));
+    }
+
+    /**
+     * @brief Removes a member from the group.
+     *
+     * @return false if the member was not in the group.
+     */
+    bool remove(const std::string& address, std::uint16_t provider_id = 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = find(m_ring->members, address, provider_id);
+        if(it == m_ring->members.end()) return false;
+        std::vector<member> members = m_ring->members;
+        members.erase(members.begin() + (it - m_ring->members.begin()));
+        rebuild(std::move(members));
+        return true;
+    }
+
+    /**
+     * @brief Number of members in the group.
+     */
+    std::size_t size() const {
+        return snapshot()->members.size();
+    }
+
+    /**
+     * @brief Returns the provider_handle of each member.
+     */
+    std::vector<provider_handle> members() const {
+        auto                         r = snapshot();
+        std::vector<provider_handle> result;
+        result.reserve(r->members.size());
+        for(const auto& m : r->members) result.push_back(m.handle);
+        return result;
+    }
+
+    /**
+     * @brief Returns the member a key is routed to.
+     *
+     * @param key Key (any sequence of bytes).
+     */
+    provider_handle pick(const std::string& key) const {
+        return pick_hash(detail::ring_hash(key.data(), key.size()));
+    }
+
+    /**
+     * @brief Returns the member a hashed key is routed to, for keys the
+     * caller already hashed (the hash must be well distributed over the
+     * 64 bits and the same in all the clients).
+     *
+     * @param hash Hash of the key.
+     */
+    provider_handle pick_hash(std::uint64_t hash) const {
+        auto r = snapshot();
+        if(r->points.empty())
+            throw exception("Calling pick on an empty provider_group");
+        auto it = std::lower_bound(r->points.begin(), r->points.end(), hash,
+                                   [](const std::pair<std::uint64_t, std::size_t>& p,
+                                      std::uint64_t h) { return p.first < h; });
+        if(it == r->points.end()) it = r->points.begin();
+        return r->members[it->second].handle;
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -10,7 +10,9 @@
 #include <margo.h>
 #include <string>
 #include <thallium/endpoint.hpp>
+#include <thallium/flow_control.hpp>
 #include <thallium/margo_exception.hpp>
+#include <thallium/provider_info.hpp>
 
 namespace thallium {
 
@@ -21,8 +23,14 @@ namespace thallium {
  * so it can be used wherever endpoint is needed.
  */
 class provider_handle : public endpoint {
+
+    friend class remote_procedure;
+
   private:
     uint16_t m_provider_id;
+    // congestion window and retry policy applied by remote_procedure::on
+    std::shared_ptr<detail::aimd_window> m_window;
+    retry_policy                         m_retry;
 
   public:
     /**
@@ -87,28 +95,62 @@ class provider_handle : public endpoint {
     uint16_t provider_id() const { return m_provider_id; }
 
     /**
-     * @brief Send an RPC to get the identity of the remote provider.
+     * @brief Makes the RPCs sent to this provider_handle (and its
+     * copies made afterwards) wait for a slot of the concurrency_limiter's
+     * window for its address. Several provider_handles to the same
+     * address share the window if they use the same concurrency_limiter.
+     *
+     * @param limiter concurrency_limiter to use.
+     */
+    provider_handle& set_concurrency_limiter(const concurrency_limiter& limiter) {
+        m_window = limiter.m_state->window(static_cast<std::string>(*this));
+        return *this;
+    }
+
+    /**
+     * @brief Sets the retry_policy of the RPCs sent to this provider_handle
+     * (and its copies made afterwards).
+     *
+     * @param policy retry_policy to use.
+     */
+    provider_handle& set_retry_policy(const retry_policy& policy) {
+        m_retry = policy;
+        return *this;
+    }
+
+    /**
+     * @brief Returns the retry_policy of the RPCs sent to this
+     * provider_handle.
+     */
+    const retry_policy& get_retry_policy() const { return m_retry; }
+
+    /**
+     * @brief Returns the identity and capabilities of the remote
+     * provider. They are fetched by a handshake RPC the first time they
+     * are requested for this address and provider id, then cached in
+     * the engine (see engine::get_provider_info).
+     *
+     * @param refresh Send the handshake again instead of using the cache.
+     */
+    provider_info get_info(bool refresh = false) const {
+        return get_engine().get_provider_info(*this, m_provider_id, refresh);
+    }
+
+    /**
+     * @brief Returns true if the remote provider advertised all the
+     * provider_capability bits of capability in its handshake.
+     */
+    bool supports(std::uint64_t capability) const {
+        return get_info().supports(capability);
+    }
+
+    /**
+     * @brief Get the identity of the remote provider (cached, see get_info).
      *
      * @return The identity as a string.
      */
     std::string get_identity() const {
-#if MARGO_VERSION_NUM >= 1500
-        hg_return_t hret = HG_NOMEM;
-        std::vector<char> buffer{64, '\0'};
-        while(hret == HG_NOMEM) {
-            buffer.resize(buffer.size()*2);
-            size_t bufsize = buffer.size();
-            auto mid = get_engine().get_margo_instance();
-            auto addr = get_addr();
-            hret = margo_provider_get_identity(mid, addr, m_provider_id, buffer.data(), &bufsize);
-        }
-        if(hret != HG_SUCCESS) {
-            MARGO_ASSERT(hret, margo_provider_get_identity);
-        }
-        return std::string{buffer.data()};
-#else
-        return std::string{"<unknown>"};
-#endif
+        return get_info().identity;
     }
 };
 
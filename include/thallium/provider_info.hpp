@@ -0,0 +1,138 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_PROVIDER_INFO_HPP
+#define __THALLIUM_PROVIDER_INFO_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <margo.h>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Bits of provider_info::capabilities, telling which optional
+ * features the engine of a provider supports. Bits from user upwards
+ * are left to the applications (see engine::enable_provider_handshake).
+ */
+namespace provider_capability {
+
+constexpr std::uint64_t varint           = std::uint64_t(1) << 0; /*!< decodes varint_encoding contexts */
+constexpr std::uint64_t compression_lz4  = std::uint64_t(1) << 1; /*!< decodes lz4-compressed payloads */
+constexpr std::uint64_t compression_zstd = std::uint64_t(1) << 2; /*!< decodes zstd-compressed payloads */
+constexpr std::uint64_t batched_rpcs     = std::uint64_t(1) << 3; /*!< decodes rpc_aggregator batches */
+constexpr std::uint64_t inline_bulk      = std::uint64_t(1) << 4; /*!< decodes bulks with inlined data */
+constexpr std::uint64_t user             = std::uint64_t(1) << 32; /*!< first application bit */
+
+} // namespace provider_capability
+
+/**
+ * @brief Identity and capabilities of a provider, returned by the
+ * handshake of provider_handle::get_info().
+ */
+struct provider_info {
+    std::string   identity;         /*!< identity registered by the provider */
+    std::uint64_t capabilities = 0; /*!< provider_capability bits */
+
+    bool supports(std::uint64_t capability) const {
+        return (capabilities & capability) == capability;
+    }
+
+    template <typename A> void serialize(A& ar) {
+        ar & identity;
+        ar & capabilities;
+    }
+};
+
+namespace detail {
+
+inline const char* provider_handshake_rpc_name() {
+    return "__thallium_provider_handshake__";
+}
+
+/**
+ * @private
+ * @brief Cache of the provider_info of remote providers, indexed by
+ * address and provider id, attached to a margo instance the first time
+ * engine::get_provider_info is called. It also holds the id of the
+ * handshake RPC on the client side and the capabilities advertised by
+ * engine::enable_provider_handshake on the server side.
+ */
+class provider_info_cache : public per_instance<provider_info_cache> {
+
+    mutable std::mutex                             m_mutex;
+    std::unordered_map<std::string, provider_info> m_infos;
+    std::atomic<hg_id_t>                           m_handshake_id{0};
+    std::atomic<std::uint64_t>                     m_local_capabilities{0};
+    std::atomic<bool>                              m_serving{false};
+
+    static std::string key(const std::string& address, std::uint16_t provider_id) {
+        return address + '#' + std::to_string(provider_id);
+    }
+
+  public:
+
+    bool find(const std::string& address, std::uint16_t provider_id,
+              provider_info& info) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_infos.find(key(address, provider_id));
+        if(it == m_infos.end()) return false;
+        info = it->second;
+        return true;
+    }
+
+    void insert(const std::string& address, std::uint16_t provider_id,
+                const provider_info& info) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_infos[key(address, provider_id)] = info;
+    }
+
+    /**
+     * @brief Removes the entries of all the providers at an address.
+     */
+    void invalidate(const std::string& address) {
+        std::string                 prefix = address + '#';
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto it = m_infos.begin(); it != m_infos.end();) {
+            if(it->first.compare(0, prefix.size(), prefix) == 0) it = m_infos.erase(it);
+            else ++it;
+        }
+    }
+
+    hg_id_t handshake_id() const {
+        return m_handshake_id.load();
+    }
+
+    void set_handshake_id(hg_id_t id) {
+        m_handshake_id = id;
+    }
+
+    std::uint64_t local_capabilities() const {
+        return m_local_capabilities.load();
+    }
+
+    void set_local_capabilities(std::uint64_t capabilities) {
+        m_local_capabilities = capabilities;
+    }
+
+    /**
+     * @brief Returns true the first time it is called, when the
+     * handshake RPC must be defined.
+     */
+    bool start_serving() {
+        return !m_serving.exchange(true);
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,280 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RCU_PTR_HPP
+#define __THALLIUM_RCU_PTR_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <thallium/spin_barrier.hpp>
+#include <thallium/xstream_local.hpp>
+
+namespace thallium {
+
+/**
+ * @brief An rcu_ptr<T> holds a read-mostly object (routing table,
+ * configuration...) that readers access without locking, and that
+ * writers replace with a new version instead of modifying it in place.
+ * Versions that are replaced are deleted once no reader can still be
+ * using them.
+ *
+ * \code{.cpp}
+ * tl::rcu_ptr<routing_table> routes(std::make_unique<routing_table>(...));
+ * ... in a handler:
+ * {
+ *     auto table = routes.read();
+ *     auto target = table->lookup(key);
+ * }
+ * ... when the table changes:
+ * routes.update([&](routing_table& t) { t.add(key, target); });
+ * \endcode
+ *
+ * Readers count themselves in a counter of their execution stream (an
+ * xstream_local slot), selected by the parity of a global epoch: entering
+ * and leaving a read section are a load and a store to a cache line only
+ * written by that execution stream, plus one fence. A writer publishes
+ * the new version with an atomic exchange and retires the old one. A
+ * retired version is deleted after the epoch has advanced past it and
+ * the readers counted under the previous parity have all left, which is
+ * checked (without blocking) by every store, update and reclaim;
+ * synchronize waits for it. Writers are serialized by a mutex.
+ *
+ * A read section may yield and migrate: leaving it decrements the
+ * counter of the execution stream where it ends, and only the sum of the
+ * counters matters. Callers that do not run in an execution stream, or
+ * whose rank is at least max_xstreams, use a shared counter with atomic
+ * increments instead. Read sections should be short, since they hold
+ * back the deletion of every version retired meanwhile.
+ *
+ * @tparam T Type of the object.
+ */
+template <typename T> class rcu_ptr {
+
+    struct counters {
+        std::atomic<std::uint64_t> readers[2];
+
+        counters() {
+            readers[0].store(0, std::memory_order_relaxed);
+            readers[1].store(0, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<T*>                 m_ptr;
+    std::atomic<std::uint64_t>      m_epoch{0};
+    mutable xstream_local<counters> m_local;
+    mutable counters                m_shared;
+    std::mutex                      m_mutex;
+    // retired before the last epoch change: deleted once the readers of
+    // the previous parity have left
+    std::vector<std::unique_ptr<T>> m_waiting;
+    // retired since the last epoch change
+    std::vector<std::unique_ptr<T>> m_next;
+
+    unsigned enter() const {
+        for(;;) {
+            std::uint64_t epoch  = m_epoch.load(std::memory_order_acquire);
+            unsigned      parity = static_cast<unsigned>(epoch & 1);
+            arrive(parity, 1);
+            // orders the increment before the load of the pointer
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // the increment must have happened in the epoch it counts for
+            if(m_epoch.load(std::memory_order_relaxed) == epoch) return parity;
+            arrive(parity, static_cast<std::uint64_t>(-1));
+        }
+    }
+
+    void leave(unsigned parity) const {
+        arrive(parity, static_cast<std::uint64_t>(-1));
+    }
+
+    void arrive(unsigned parity, std::uint64_t delta) const {
+        counters* c = m_local.local_if();
+        if(!c) {
+            m_shared.readers[parity].fetch_add(delta, std::memory_order_acq_rel);
+            return;
+        }
+        // only this execution stream writes its slot
+        auto& n = c->readers[parity];
+        n.store(n.load(std::memory_order_relaxed) + delta, std::memory_order_release);
+    }
+
+    std::uint64_t readers(unsigned parity) const {
+        // counters wrap when a read section ends on another execution
+        // stream, their sum does not
+        std::uint64_t total = m_shared.readers[parity].load(std::memory_order_acquire);
+        m_local.for_each([&](const counters& c) {
+            total += c.readers[parity].load(std::memory_order_acquire);
+        });
+        return total;
+    }
+
+    // called with m_mutex held
+    void advance() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for(;;) {
+            unsigned previous = static_cast<unsigned>((m_epoch.load(std::memory_order_relaxed) + 1) & 1);
+            if(readers(previous) != 0) return;
+            m_waiting.clear();
+            if(m_next.empty()) return;
+            m_epoch.fetch_add(1, std::memory_order_seq_cst);
+            m_waiting.swap(m_next);
+        }
+    }
+
+    // called with m_mutex held
+    void publish(std::unique_ptr<T> value) {
+        std::unique_ptr<T> old(m_ptr.exchange(value.release(), std::memory_order_seq_cst));
+        if(old) m_next.push_back(std::move(old));
+        advance();
+    }
+
+  public:
+
+    /**
+     * @brief A read_guard keeps the version it points to alive until it
+     * is destroyed. It must be destroyed by the ULT that created it.
+     */
+    class read_guard {
+
+        friend class rcu_ptr;
+
+        const rcu_ptr* m_owner  = nullptr;
+        const T*       m_ptr    = nullptr;
+        unsigned       m_parity = 0;
+
+        read_guard(const rcu_ptr* owner, unsigned parity)
+        : m_owner(owner)
+        , m_ptr(owner->m_ptr.load(std::memory_order_acquire))
+        , m_parity(parity) {}
+
+      public:
+
+        read_guard(const read_guard&)            = delete;
+        read_guard& operator=(const read_guard&) = delete;
+
+        read_guard(read_guard&& other)
+        : m_owner(other.m_owner)
+        , m_ptr(other.m_ptr)
+        , m_parity(other.m_parity) {
+            other.m_owner = nullptr;
+            other.m_ptr   = nullptr;
+        }
+
+        read_guard& operator=(read_guard&& other) {
+            if(&other == this) return *this;
+            if(m_owner) m_owner->leave(m_parity);
+            m_owner       = other.m_owner;
+            m_ptr         = other.m_ptr;
+            m_parity      = other.m_parity;
+            other.m_owner = nullptr;
+            other.m_ptr   = nullptr;
+            return *this;
+        }
+
+        ~read_guard() {
+            if(m_owner) m_owner->leave(m_parity);
+        }
+
+        /**
+         * @brief Returns the version read (nullptr if none was stored).
+         */
+        const T* get() const { return m_ptr; }
+
+        const T& operator*() const { return *m_ptr; }
+
+        const T* operator->() const { return m_ptr; }
+
+        explicit operator bool() const { return m_ptr != nullptr; }
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param value Initial version (may be null).
+     * @param max_xstreams Number of per-execution stream counters (see
+     * xstream_local).
+     */
+    explicit rcu_ptr(std::unique_ptr<T> value = nullptr, std::size_t max_xstreams = 64)
+    : m_ptr(value.release())
+    , m_local(max_xstreams) {}
+
+    rcu_ptr(const rcu_ptr&)            = delete;
+    rcu_ptr& operator=(const rcu_ptr&) = delete;
+
+    /**
+     * @brief Destructor. Deletes the current version and the retired
+     * ones; no reader may remain.
+     */
+    ~rcu_ptr() {
+        delete m_ptr.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Enters a read section and returns the current version.
+     */
+    read_guard read() const {
+        return read_guard(this, enter());
+    }
+
+    /**
+     * @brief Replaces the current version, which is retired.
+     */
+    void store(std::unique_ptr<T> value) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        publish(std::move(value));
+    }
+
+    /**
+     * @brief Copies the current version (which must not be null), calls
+     * f on the copy and stores it. Concurrent updates are serialized, so
+     * none of them is lost.
+     */
+    template <typename F> void update(F&& f) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unique_ptr<T> copy(new T(*m_ptr.load(std::memory_order_relaxed)));
+        std::forward<F>(f)(*copy);
+        publish(std::move(copy));
+    }
+
+    /**
+     * @brief Deletes the retired versions that readers can no longer
+     * use, without waiting.
+     *
+     * @return true if no retired version remains.
+     */
+    bool reclaim() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        advance();
+        return m_waiting.empty() && m_next.empty();
+    }
+
+    /**
+     * @brief Waits until every version retired so far is deleted,
+     * yielding if the caller is a ULT. Must not be called from a read
+     * section.
+     */
+    void synchronize() {
+        int iteration = 0;
+        while(!reclaim()) detail::barrier_backoff(iteration);
+    }
+
+    /**
+     * @brief Number of retired versions not deleted yet.
+     */
+    std::size_t pending() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_waiting.size() + m_next.size();
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -6,15 +6,24 @@
 #ifndef __THALLIUM_REMOTE_BULK_HPP
 #define __THALLIUM_REMOTE_BULK_HPP
 
+#include <algorithm>
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <margo.h>
 #include <string>
 #include <thallium/bulk.hpp>
+#include <thallium/bulk_selection.hpp>
+#include <thallium/bulk_traffic.hpp>
+#include <thallium/expected.hpp>
 #include <thallium/margo_instance_ref.hpp>
 #include <vector>
 
 namespace thallium {
 
+class pool;
+template <typename T> class eventual;
+
 /**
  * @brief A remote_bulk object represents a bulk_segment object
  * that has been associated with an endpoint and is ready for
@@ -23,6 +32,7 @@ namespace thallium {
 class remote_bulk {
     friend class bulk;
     friend class bulk_segment;
+    friend class bulk_forwarder;
 
   private:
     bulk_segment m_segment;
@@ -86,6 +96,56 @@ class remote_bulk {
      */
     async_bulk_op pull_to(const bulk_segment& dest) const;
 
+    /**
+     * @brief Same as pull_to(dest) but returns an expected holding the
+     * Mercury error code instead of throwing if the transfer could not
+     * be started.
+     */
+    expected<async_bulk_op> try_pull_to(const bulk_segment& dest) const;
+
+    /**
+     * @brief Same as pull_to(dest), but splits the transfer into
+     * num_stripes operations of (almost) equal sizes issued
+     * concurrently, which lets Mercury keep several RDMA operations
+     * in flight for a single large transfer.
+     *
+     * @param dest bulk_segment object towards which to pull data.
+     * @param num_stripes Number of concurrent operations.
+     *
+     * @return a striped_bulk_op object whose wait() returns the total
+     * size transfered.
+     */
+    striped_bulk_op pull_to(const bulk_segment& dest, std::size_t num_stripes) const;
+
+    /**
+     * @brief Pulls data from the remote_bulk to the local bulk_segment
+     * without blocking and without any ULT waiting on the operation:
+     * when the transfer completes, the callback is called with the
+     * bulk_op_result in a new ULT pushed to pool p, or directly from
+     * the progress loop if p is a null pool (in which case the callback
+     * must not block). The bulk handles involved are kept alive until
+     * the callback has run. The callback must not throw.
+     *
+     * @param dest bulk_segment object towards which to pull data.
+     * @param callback Function to call on completion.
+     * @param p Pool in which to run the callback.
+     */
+    void pull_to(const bulk_segment& dest, bulk_callback callback, const pool& p) const;
+
+    /**
+     * @brief Pulls the blocks described by a bulk_selection from the
+     * remote_bulk to a local bulk, issuing all the RDMA operations at
+     * once. Offsets in the selection are relative to the start of the
+     * remote_bulk and of the local bulk respectively. Throws an exception
+     * if the selection extends beyond either of them.
+     *
+     * @param dest Local bulk towards which to pull data.
+     * @param selection Blocks to transfer.
+     *
+     * @return a striped_bulk_op object tracking the operations.
+     */
+    striped_bulk_op pull_to(const bulk& dest, const bulk_selection& selection) const;
+
     /**
      * @brief Performs a push operation from the source bulk
      * (right operand) to the remote_bulk (left operand).
@@ -111,6 +171,156 @@ class remote_bulk {
      */
     async_bulk_op push_from(const bulk_segment& src) const;
 
+    /**
+     * @brief Same as push_from(src), but splits the transfer into
+     * num_stripes concurrent operations. See pull_to.
+     *
+     * @param src Local bulk segment from which to push data.
+     * @param num_stripes Number of concurrent operations.
+     *
+     * @return a striped_bulk_op object.
+     */
+    striped_bulk_op push_from(const bulk_segment& src, std::size_t num_stripes) const;
+
+    /**
+     * @brief Pushes data from the local bulk_segment to the remote_bulk
+     * and calls the callback on completion. See pull_to.
+     *
+     * @param src Local bulk segment from which to push data.
+     * @param callback Function to call on completion.
+     * @param p Pool in which to run the callback.
+     */
+    void push_from(const bulk_segment& src, bulk_callback callback, const pool& p) const;
+
+    /**
+     * @brief Pulls data from the remote_bulk to the local bulk_segment
+     * and returns an eventual set, from the progress loop, with the size
+     * transfered (or with a margo_exception if the transfer failed).
+     * Continuations attached with eventual::then allow chaining further
+     * steps without any ULT waiting on the transfer.
+     *
+     * @param dest bulk_segment object towards which to pull data.
+     *
+     * @return an eventual for the size transfered.
+     */
+    eventual<std::size_t> async_pull_to(const bulk_segment& dest) const;
+
+    /**
+     * @brief Pushes data from the local bulk_segment to the remote_bulk
+     * and returns an eventual for the size transfered. See async_pull_to.
+     *
+     * @param src Local bulk segment from which to push data.
+     *
+     * @return an eventual for the size transfered.
+     */
+    eventual<std::size_t> async_push_from(const bulk_segment& src) const;
+
+    /**
+     * @brief Pushes the blocks described by a bulk_selection from
+     * a local bulk to the remote_bulk. See pull_to.
+     *
+     * @param src Local bulk from which to push data.
+     * @param selection Blocks to transfer.
+     *
+     * @return a striped_bulk_op object tracking the operations.
+     */
+    striped_bulk_op push_from(const bulk& src, const bulk_selection& selection) const;
+
+    /**
+     * @brief Pulls data from the remote_bulk to the local bulk_segment
+     * in chunks of chunk_size bytes, keeping up to window transfers in
+     * flight. Each time a chunk has arrived, on_chunk(offset, size) is
+     * called, offset being relative to the start of the transfer, so
+     * that the caller can start processing the data while the rest of
+     * it is still being transferred. Chunks are handed to on_chunk in
+     * increasing offset order.
+     *
+     * If p is a valid pool, each call to on_chunk runs in its own ULT
+     * in this pool, and the function returns once they have all
+     * completed. Otherwise on_chunk is called by the calling ULT. In
+     * both cases on_chunk must not throw.
+     *
+     * @param dest Local bulk segment on which to pull the data.
+     * @param chunk_size Size of each chunk (0 means a single chunk).
+     * @param window Maximum number of chunks in flight.
+     * @param on_chunk Callback invoked for each chunk received.
+     * @param p Pool in which to run the callbacks.
+     *
+     * @return the size of data transfered.
+     */
+    template <typename F>
+    std::size_t pull_pipelined(const bulk_segment& dest, std::size_t chunk_size,
+                               std::size_t window, F&& on_chunk,
+                               const pool& p = pool()) const;
+
+    /**
+     * @brief Same as pull_pipelined, without a callback.
+     */
+    std::size_t pull_pipelined(const bulk_segment& dest, std::size_t chunk_size,
+                               std::size_t window) const;
+
+    /**
+     * @brief Pushes data from the local bulk_segment to the remote_bulk
+     * in chunks of chunk_size bytes, keeping up to window transfers in
+     * flight. on_chunk(offset, size) is called when a chunk has been
+     * pushed, so the caller can for instance reuse that part of the
+     * source buffer. See pull_pipelined for the semantics of the
+     * arguments.
+     *
+     * @return the size of data transfered.
+     */
+    template <typename F>
+    std::size_t push_pipelined(const bulk_segment& src, std::size_t chunk_size,
+                               std::size_t window, F&& on_chunk,
+                               const pool& p = pool()) const;
+
+    /**
+     * @brief Same as push_pipelined, without a callback.
+     */
+    std::size_t push_pipelined(const bulk_segment& src, std::size_t chunk_size,
+                               std::size_t window) const;
+
+    /**
+     * @brief Same as pull_pipelined, but also computes the CRC32C of the
+     * data as it arrives (each chunk is checksummed while the next ones
+     * are in flight) and throws a checksum_exception if it differs from
+     * expected, the checksum of the source that the sender computed with
+     * bulk_segment::checksum and sent along with the bulk handle.
+     *
+     * @param dest Local bulk segment on which to pull the data.
+     * @param expected Checksum provided by the sender.
+     * @param chunk_size Size of each chunk (0 means a single chunk).
+     * @param window Maximum number of chunks in flight.
+     *
+     * @return the size of data transfered.
+     */
+    std::size_t pull_verified(const bulk_segment& dest, std::uint32_t expected,
+                              std::size_t chunk_size = 4*1024*1024,
+                              std::size_t window = 4) const;
+
+    /**
+     * @brief Same as push_pipelined, but also computes the CRC32C of the
+     * pushed data, chunk by chunk while the next ones are in flight, and
+     * returns it so that it can be sent to the receiver, which compares
+     * it to the checksum of the data it got (bulk_segment::checksum).
+     *
+     * @param src Local bulk segment from which to push the data.
+     * @param chunk_size Size of each chunk (0 means a single chunk).
+     * @param window Maximum number of chunks in flight.
+     *
+     * @return the checksum of the data transfered.
+     */
+    std::uint32_t push_checksummed(const bulk_segment& src,
+                                   std::size_t chunk_size = 4*1024*1024,
+                                   std::size_t window = 4) const;
+
+    /**
+     * @brief Returns the size of the remote segment.
+     */
+    std::size_t size() const noexcept {
+        return m_segment.m_size;
+    }
+
     /**
      * @brief Creates a bulk_segment object by selecting a given portion
      * of the bulk object given an offset and a size.
@@ -130,11 +340,35 @@ class remote_bulk {
     inline remote_bulk operator()(std::size_t offset, std::size_t size) const {
         return select(offset, size);
     }
+
+  private:
+
+    struct completion_context;
+
+    void transfer_with_callback(hg_bulk_op_t op, const bulk_segment& local,
+                                bulk_callback callback, const pool& p) const;
+
+    eventual<std::size_t> transfer_eventual(hg_bulk_op_t op, const bulk_segment& local) const;
+
+    striped_bulk_op transfer_striped(hg_bulk_op_t op, const bulk_segment& local,
+                                     std::size_t num_stripes) const;
+
+    striped_bulk_op transfer_selection(hg_bulk_op_t op, const bulk& local,
+                                       const bulk_selection& selection) const;
+
+    template <typename F>
+    std::size_t transfer_pipelined(hg_bulk_op_t op, const bulk_segment& local,
+                                   std::size_t chunk_size, std::size_t window,
+                                   F& on_chunk, const pool& p) const;
 };
 
 } // namespace thallium
 
+#include <thallium/anonymous.hpp>
 #include <thallium/engine.hpp>
+#include <thallium/eventual.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/thread.hpp>
 
 namespace thallium {
 
@@ -152,15 +386,33 @@ inline std::size_t remote_bulk::operator>>(const bulk_segment& dest) const {
     if(size > m_segment.m_size)
         size = m_segment.m_size;
 
+    // data inlined by the sender is copied instead of pulled
+    if(m_segment.m_bulk.m_inline) {
+        m_segment.m_bulk.copy_inline(origin_offset, dest.m_bulk, local_offset, size);
+        return size;
+    }
+
     hg_return_t ret =
         margo_bulk_transfer(mid, op, origin_addr, origin_handle, origin_offset,
                             local_handle, local_offset, size);
     MARGO_ASSERT(ret, margo_bulk_transfer);
+    detail::bulk_traffic::record(mid, op, size);
 
     return size;
 }
 
+inline async_bulk_op& async_bulk_op::resume_in(const pool& p) {
+    m_resume_pool = p.native_handle();
+    return *this;
+}
+
 inline async_bulk_op remote_bulk::pull_to(const bulk_segment& dest) const {
+    auto op = try_pull_to(dest);
+    MARGO_ASSERT(op.error(), margo_bulk_itransfer);
+    return std::move(*op);
+}
+
+inline expected<async_bulk_op> remote_bulk::try_pull_to(const bulk_segment& dest) const {
 
     margo_instance_id mid           = m_endpoint.m_mid;
     hg_bulk_op_t      op            = HG_BULK_PULL;
@@ -175,10 +427,16 @@ inline async_bulk_op remote_bulk::pull_to(const bulk_segment& dest) const {
     if(size > m_segment.m_size)
         size = m_segment.m_size;
 
+    if(m_segment.m_bulk.m_inline) {
+        m_segment.m_bulk.copy_inline(origin_offset, dest.m_bulk, local_offset, size);
+        return async_bulk_op::completed(size);
+    }
+
     hg_return_t ret =
         margo_bulk_itransfer(mid, op, origin_addr, origin_handle, origin_offset,
                              local_handle, local_offset, size, &req);
-    MARGO_ASSERT(ret, margo_bulk_itransfer);
+    if(ret != HG_SUCCESS) return expected<async_bulk_op>::failure(ret);
+    detail::bulk_traffic::record(mid, op, size);
 
     return async_bulk_op{size, req};
 }
@@ -201,6 +459,7 @@ inline std::size_t remote_bulk::operator<<(const bulk_segment& src) const {
         margo_bulk_transfer(mid, op, origin_addr, origin_handle, origin_offset,
                             local_handle, local_offset, size);
     MARGO_ASSERT(ret, margo_bulk_transfer);
+    detail::bulk_traffic::record(mid, op, size);
 
     return size;
 }
@@ -224,10 +483,302 @@ inline async_bulk_op remote_bulk::push_from(const bulk_segment& src) const {
         margo_bulk_itransfer(mid, op, origin_addr, origin_handle, origin_offset,
                              local_handle, local_offset, size, &req);
     MARGO_ASSERT(ret, margo_bulk_itransfer);
+    detail::bulk_traffic::record(mid, op, size);
 
     return async_bulk_op{size, req};
 }
 
+struct remote_bulk::completion_context {
+    // copies of the bulk objects keep the handles and address alive
+    remote_bulk   m_remote;
+    bulk_segment  m_local;
+    std::size_t   m_size;
+    bulk_callback m_callback;
+    pool          m_pool;
+
+    static void run(completion_context* ctx, const bulk_op_result& result) {
+        std::unique_ptr<completion_context> owner(ctx);
+        ctx->m_callback(result);
+    }
+
+    static hg_return_t on_complete(const struct hg_cb_info* info) {
+        auto ctx = static_cast<completion_context*>(info->arg);
+        bulk_op_result result{info->ret == HG_SUCCESS ? ctx->m_size : 0, info->ret};
+        if(!ctx->m_pool.is_null()) {
+            try {
+                ctx->m_pool.make_thread([ctx, result]() { run(ctx, result); },
+                                        anonymous());
+                return HG_SUCCESS;
+            } catch(const exception&) {
+                // could not create the ULT, run the callback here instead
+            }
+        }
+        run(ctx, result);
+        return HG_SUCCESS;
+    }
+};
+
+inline void remote_bulk::transfer_with_callback(hg_bulk_op_t op,
+        const bulk_segment& local, bulk_callback callback, const pool& p) const {
+
+    size_t size = std::min(local.m_size, m_segment.m_size);
+
+    std::unique_ptr<completion_context> ctx(
+        new completion_context{*this, local, size, std::move(callback), p});
+
+    // margo has no completion callback for bulk transfers, so the
+    // operation is posted directly on the Mercury context; its callback
+    // is triggered by margo's progress loop
+    hg_return_t ret = HG_Bulk_transfer(
+        margo_get_context(m_endpoint.m_mid), completion_context::on_complete,
+        ctx.get(), op, m_endpoint.m_addr, m_segment.m_bulk.m_bulk,
+        m_segment.m_offset, local.m_bulk.m_bulk, local.m_offset, size,
+        HG_OP_ID_IGNORE);
+    MARGO_ASSERT(ret, HG_Bulk_transfer);
+    ctx.release();
+    detail::bulk_traffic::record(m_endpoint.m_mid, op, size);
+}
+
+inline void remote_bulk::pull_to(const bulk_segment& dest, bulk_callback callback,
+                                 const pool& p) const {
+    transfer_with_callback(HG_BULK_PULL, dest, std::move(callback), p);
+}
+
+inline void remote_bulk::push_from(const bulk_segment& src, bulk_callback callback,
+                                   const pool& p) const {
+    transfer_with_callback(HG_BULK_PUSH, src, std::move(callback), p);
+}
+
+inline eventual<std::size_t> remote_bulk::transfer_eventual(hg_bulk_op_t op,
+        const bulk_segment& local) const {
+    eventual<std::size_t> result;
+    auto state = result.m_state;
+    transfer_with_callback(op, local,
+        [state](const bulk_op_result& r) {
+            if(r.ok()) {
+                state->complete([&state, &r]() { state->m_value = r.size; });
+            } else {
+                state->complete([]() {}, std::make_exception_ptr(margo_exception(
+                    "HG_Bulk_transfer", __FILE__, __LINE__, r.error,
+                    translate_margo_error_code(r.error))));
+            }
+        }, pool());
+    return result;
+}
+
+inline eventual<std::size_t> remote_bulk::async_pull_to(const bulk_segment& dest) const {
+    return transfer_eventual(HG_BULK_PULL, dest);
+}
+
+inline eventual<std::size_t> remote_bulk::async_push_from(const bulk_segment& src) const {
+    return transfer_eventual(HG_BULK_PUSH, src);
+}
+
+inline striped_bulk_op remote_bulk::transfer_striped(hg_bulk_op_t op,
+        const bulk_segment& local, std::size_t num_stripes) const {
+
+    margo_instance_id mid           = m_endpoint.m_mid;
+    hg_addr_t         origin_addr   = m_endpoint.m_addr;
+    hg_bulk_t         origin_handle = m_segment.m_bulk.m_bulk;
+    size_t            origin_offset = m_segment.m_offset;
+    hg_bulk_t         local_handle  = local.m_bulk.m_bulk;
+    size_t            local_offset  = local.m_offset;
+    size_t            size          = std::min(local.m_size, m_segment.m_size);
+
+    if(num_stripes == 0) num_stripes = 1;
+    if(num_stripes > size) num_stripes = size ? size : 1;
+    std::size_t stripe_size = (size + num_stripes - 1) / num_stripes;
+
+    striped_bulk_op result;
+    result.m_ops.reserve(num_stripes);
+    std::size_t offset = 0;
+    do {
+        std::size_t   n   = std::min(stripe_size, size - offset);
+        margo_request req = MARGO_REQUEST_NULL;
+        // operations already issued are waited on by result's destructor
+        hg_return_t ret =
+            margo_bulk_itransfer(mid, op, origin_addr, origin_handle,
+                                 origin_offset + offset, local_handle,
+                                 local_offset + offset, n, &req);
+        MARGO_ASSERT(ret, margo_bulk_itransfer);
+        result.m_ops.push_back(async_bulk_op{n, req});
+        offset += n;
+    } while(offset < size);
+    detail::bulk_traffic::record(mid, op, size);
+
+    return result;
+}
+
+inline striped_bulk_op remote_bulk::transfer_selection(hg_bulk_op_t op,
+        const bulk& local, const bulk_selection& selection) const {
+
+    margo_instance_id mid           = m_endpoint.m_mid;
+    hg_addr_t         origin_addr   = m_endpoint.m_addr;
+    hg_bulk_t         origin_handle = m_segment.m_bulk.m_bulk;
+    size_t            origin_offset = m_segment.m_offset;
+    hg_bulk_t         local_handle  = local.m_bulk;
+
+    if(selection.remote_extent() > m_segment.m_size
+    || selection.local_extent() > local.size())
+        throw exception("bulk_selection extends beyond the bulk it is applied to");
+
+    striped_bulk_op result;
+    result.m_ops.reserve(selection.num_blocks());
+    std::size_t total = 0;
+    for(auto& p : selection.patterns()) {
+        for(std::size_t i = 0; i < p.count; i++) {
+            margo_request req = MARGO_REQUEST_NULL;
+            hg_return_t ret =
+                margo_bulk_itransfer(mid, op, origin_addr, origin_handle,
+                                     origin_offset + p.remote_offset + i*p.remote_stride,
+                                     local_handle, p.local_offset + i*p.local_stride,
+                                     p.blocklen, &req);
+            MARGO_ASSERT(ret, margo_bulk_itransfer);
+            result.m_ops.push_back(async_bulk_op{p.blocklen, req});
+            total += p.blocklen;
+        }
+    }
+    detail::bulk_traffic::record(mid, op, total);
+    return result;
+}
+
+inline striped_bulk_op remote_bulk::pull_to(const bulk& dest,
+                                            const bulk_selection& selection) const {
+    return transfer_selection(HG_BULK_PULL, dest, selection);
+}
+
+inline striped_bulk_op remote_bulk::push_from(const bulk& src,
+                                              const bulk_selection& selection) const {
+    return transfer_selection(HG_BULK_PUSH, src, selection);
+}
+
+inline striped_bulk_op remote_bulk::pull_to(const bulk_segment& dest,
+                                            std::size_t num_stripes) const {
+    return transfer_striped(HG_BULK_PULL, dest, num_stripes);
+}
+
+inline striped_bulk_op remote_bulk::push_from(const bulk_segment& src,
+                                              std::size_t num_stripes) const {
+    return transfer_striped(HG_BULK_PUSH, src, num_stripes);
+}
+
+template <typename F>
+inline std::size_t remote_bulk::transfer_pipelined(hg_bulk_op_t op,
+        const bulk_segment& local, std::size_t chunk_size,
+        std::size_t window, F& on_chunk, const pool& p) const {
+
+    struct chunk {
+        std::size_t   offset;
+        std::size_t   size;
+        margo_request req;
+    };
+
+    margo_instance_id mid           = m_endpoint.m_mid;
+    hg_addr_t         origin_addr   = m_endpoint.m_addr;
+    hg_bulk_t         origin_handle = m_segment.m_bulk.m_bulk;
+    size_t            origin_offset = m_segment.m_offset;
+    hg_bulk_t         local_handle  = local.m_bulk.m_bulk;
+    size_t            local_offset  = local.m_offset;
+    size_t            size          = std::min(local.m_size, m_segment.m_size);
+
+    if(chunk_size == 0) chunk_size = size;
+    if(window == 0) window = 1;
+
+    std::deque<chunk>            in_flight;
+    std::vector<managed<thread>> callbacks;
+    pool                         target = p;
+    std::size_t                  issued = 0;
+    hg_return_t                  ret    = HG_SUCCESS;
+
+    auto issue = [&]() {
+        chunk c{issued, std::min(chunk_size, size - issued), MARGO_REQUEST_NULL};
+        ret = margo_bulk_itransfer(mid, op, origin_addr, origin_handle,
+                                   origin_offset + c.offset, local_handle,
+                                   local_offset + c.offset, c.size, &c.req);
+        if(ret != HG_SUCCESS) return;
+        in_flight.push_back(c);
+        issued += c.size;
+    };
+
+    while(ret == HG_SUCCESS && issued < size && in_flight.size() < window)
+        issue();
+
+    // chunks are waited on in the order they were issued, so callbacks
+    // see increasing offsets; each completion issues the next chunk
+    while(!in_flight.empty()) {
+        chunk c = in_flight.front();
+        in_flight.pop_front();
+        hg_return_t r = margo_wait(c.req);
+        if(ret != HG_SUCCESS) continue; // draining after an error
+        if(r != HG_SUCCESS) {
+            ret = r;
+            continue;
+        }
+        if(issued < size) issue();
+        if(target.is_null()) {
+            on_chunk(c.offset, c.size);
+        } else {
+            callbacks.push_back(target.make_thread(
+                [&on_chunk, c]() { on_chunk(c.offset, c.size); }));
+        }
+    }
+    for(auto& t : callbacks) t->join();
+
+    MARGO_ASSERT(ret, margo_bulk_itransfer);
+    detail::bulk_traffic::record(mid, op, size);
+    return size;
+}
+
+inline std::size_t remote_bulk::pull_pipelined(const bulk_segment& dest,
+        std::size_t chunk_size, std::size_t window) const {
+    return pull_pipelined(dest, chunk_size, window,
+                          [](std::size_t, std::size_t) {});
+}
+
+template <typename F>
+inline std::size_t remote_bulk::pull_pipelined(const bulk_segment& dest,
+        std::size_t chunk_size, std::size_t window, F&& on_chunk,
+        const pool& p) const {
+    return transfer_pipelined(HG_BULK_PULL, dest, chunk_size, window, on_chunk, p);
+}
+
+inline std::size_t remote_bulk::push_pipelined(const bulk_segment& src,
+        std::size_t chunk_size, std::size_t window) const {
+    return push_pipelined(src, chunk_size, window,
+                          [](std::size_t, std::size_t) {});
+}
+
+template <typename F>
+inline std::size_t remote_bulk::push_pipelined(const bulk_segment& src,
+        std::size_t chunk_size, std::size_t window, F&& on_chunk,
+        const pool& p) const {
+    return transfer_pipelined(HG_BULK_PUSH, src, chunk_size, window, on_chunk, p);
+}
+
+inline std::size_t remote_bulk::pull_verified(const bulk_segment& dest,
+        std::uint32_t expected, std::size_t chunk_size, std::size_t window) const {
+    std::uint32_t crc = 0;
+    // chunks come in increasing offset order, so the checksum is continued
+    std::size_t size = pull_pipelined(dest, chunk_size, window,
+        [&dest, &crc](std::size_t offset, std::size_t n) {
+            crc = dest.select(offset, n).checksum(crc);
+        });
+    if(crc != expected)
+        throw checksum_exception("Checksum mismatch after pulling ", size,
+                                 " bytes: expected ", expected, ", got ", crc);
+    return size;
+}
+
+inline std::uint32_t remote_bulk::push_checksummed(const bulk_segment& src,
+        std::size_t chunk_size, std::size_t window) const {
+    std::uint32_t crc = 0;
+    push_pipelined(src, chunk_size, window,
+        [&src, &crc](std::size_t offset, std::size_t n) {
+            crc = src.select(offset, n).checksum(crc);
+        });
+    return crc;
+}
+
 } // namespace thallium
 
 #endif
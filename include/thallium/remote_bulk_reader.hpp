@@ -0,0 +1,311 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_REMOTE_BULK_READER_HPP
+#define __THALLIUM_REMOTE_BULK_READER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <thallium/bulk.hpp>
+#include <thallium/bulk_mode.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/huge_page_allocator.hpp>
+#include <thallium/remote_bulk.hpp>
+#include <thallium/tsc_clock.hpp>
+
+namespace thallium {
+
+/**
+ * @brief A remote_bulk_reader reads a remote region sequentially (or at
+ * random offsets) through a local ring of chunk buffers exposed once.
+ * When it detects sequential access, it keeps the next chunks of the
+ * region in flight with asynchronous pulls, so that most reads complete
+ * from local memory instead of waiting for a round trip each.
+ *
+ * \code{.cpp}
+ * tl::remote_bulk_reader reader(engine, dataset.on(server));
+ * std::vector<char> record(256);
+ * while(reader.read(record.data(), record.size()) == record.size())
+ *     process(record);
+ * \endcode
+ *
+ * The read-ahead depth (number of chunks prefetched beyond the one being
+ * read) adapts to the transfer latency measured whenever a read waits for
+ * a chunk, and to the rate at which chunks are consumed: it is set to the
+ * number of chunks consumed during one transfer, plus one, within
+ * [min_depth, max_depth]. A read at an offset other than the end of the
+ * previous one stops the read-ahead until sequential_reads sequential
+ * reads are seen again. A remote_bulk_reader must not be used by several
+ * ULTs concurrently.
+ */
+class remote_bulk_reader {
+
+  public:
+
+    /**
+     * @brief Parameters of a remote_bulk_reader.
+     */
+    struct options {
+        std::size_t chunk_size       = 1024 * 1024; /*!< size of the chunks pulled */
+        std::size_t min_depth        = 1;           /*!< minimum read-ahead depth, in chunks */
+        std::size_t max_depth        = 16;          /*!< maximum read-ahead depth, in chunks */
+        std::size_t sequential_reads = 2;           /*!< sequential reads before reading ahead */
+    };
+
+    /**
+     * @brief Constructor. Allocates and exposes max_depth+1 chunks.
+     *
+     * @param e Engine used to expose the ring.
+     * @param source Remote region to read.
+     * @param opts Options.
+     */
+    remote_bulk_reader(engine& e, remote_bulk source, options opts)
+    : m_source(std::move(source))
+    , m_opts(opts) {
+        if(m_opts.chunk_size == 0) m_opts.chunk_size = 1;
+        if(m_opts.max_depth == 0) m_opts.max_depth = 1;
+        m_opts.min_depth = std::min(std::max<std::size_t>(m_opts.min_depth, 1), m_opts.max_depth);
+        m_depth = m_opts.min_depth;
+        m_slots.resize(m_opts.max_depth + 1);
+        m_ring.resize(m_slots.size() * m_opts.chunk_size);
+        std::vector<std::pair<void*, std::size_t>> segments{{m_ring.data(), m_ring.size()}};
+        m_ring_bulk = e.expose(segments, bulk_mode::write_only);
+    }
+
+    /**
+     * @brief Constructor with the default options.
+     */
+    remote_bulk_reader(engine& e, remote_bulk source)
+    : remote_bulk_reader(e, std::move(source), options()) {}
+
+    remote_bulk_reader(const remote_bulk_reader&)            = delete;
+    remote_bulk_reader& operator=(const remote_bulk_reader&) = delete;
+
+    /**
+     * @brief Destructor. Waits for the pulls in flight.
+     */
+    ~remote_bulk_reader() {
+        for(auto& s : m_slots) {
+            if(!s.pending) continue;
+            try {
+                s.op.wait();
+            } catch(...) {}
+        }
+    }
+
+    /**
+     * @brief Reads up to size bytes at the current position, and
+     * advances it.
+     *
+     * @return the number of bytes read, less than size only at the end
+     * of the region.
+     */
+    std::size_t read(void* data, std::size_t size) {
+        std::size_t n = read_at(m_position, data, size);
+        m_position += n;
+        return n;
+    }
+
+    /**
+     * @brief Reads up to size bytes at the given offset of the region.
+     *
+     * @return the number of bytes read.
+     */
+    std::size_t read_at(std::size_t offset, void* data, std::size_t size) {
+        if(offset >= m_source.size()) return 0;
+        size = std::min(size, m_source.size() - offset);
+        if(offset == m_next_offset) m_run += 1;
+        else m_run = 0;
+        m_next_offset = offset + size;
+        char* out  = static_cast<char*>(data);
+        std::size_t done = 0;
+        while(done < size) {
+            std::size_t pos    = offset + done;
+            std::size_t chunk  = pos / m_opts.chunk_size;
+            std::size_t within = pos % m_opts.chunk_size;
+            slot&       s      = fetch(chunk);
+            std::size_t n      = std::min(size - done, s.size - within);
+            std::memcpy(out + done, m_ring.data() + index_of(chunk) * m_opts.chunk_size + within, n);
+            done += n;
+            if(chunk != m_last_chunk) {
+                consumed();
+                m_last_chunk = chunk;
+            }
+            if(m_run >= m_opts.sequential_reads) prefetch(chunk);
+        }
+        return size;
+    }
+
+    /**
+     * @brief Sets the position of the next read().
+     */
+    void seek(std::size_t offset) {
+        m_position = offset;
+    }
+
+    /**
+     * @brief Returns the position of the next read().
+     */
+    std::size_t tell() const {
+        return m_position;
+    }
+
+    /**
+     * @brief Size of the remote region.
+     */
+    std::size_t size() const {
+        return m_source.size();
+    }
+
+    /**
+     * @brief Current read-ahead depth, in chunks.
+     */
+    std::size_t depth() const {
+        return m_depth;
+    }
+
+    /**
+     * @brief Number of chunks found in the ring (already received or
+     * in flight) when needed.
+     */
+    std::size_t hits() const {
+        return m_hits;
+    }
+
+    /**
+     * @brief Number of chunks pulled on demand.
+     */
+    std::size_t misses() const {
+        return m_misses;
+    }
+
+    /**
+     * @brief Number of times a read waited for a chunk in flight.
+     */
+    std::size_t stalls() const {
+        return m_stalls;
+    }
+
+  private:
+
+    static constexpr std::size_t no_chunk = std::numeric_limits<std::size_t>::max();
+
+    struct slot {
+        std::size_t   chunk   = no_chunk;
+        std::size_t   size    = 0;
+        bool          pending = false;
+        std::uint64_t issued  = 0;
+        async_bulk_op op;
+    };
+
+    remote_bulk            m_source;
+    options                m_opts;
+    huge_page_vector<char> m_ring;
+    bulk                   m_ring_bulk;
+    std::vector<slot>      m_slots;
+    std::size_t            m_position    = 0;
+    std::size_t            m_next_offset = 0;
+    std::size_t            m_run         = 0;
+    std::size_t            m_last_chunk  = no_chunk;
+    std::size_t            m_depth;
+    // moving averages of the transfer latency and of the time between
+    // two chunks consumed, in nanoseconds
+    double                 m_latency      = 0;
+    double                 m_interval     = 0;
+    std::uint64_t          m_last_consume = 0;
+    std::size_t            m_hits   = 0;
+    std::size_t            m_misses = 0;
+    std::size_t            m_stalls = 0;
+
+    std::size_t index_of(std::size_t chunk) const {
+        return chunk % m_slots.size();
+    }
+
+    void issue(std::size_t chunk) {
+        slot& s = m_slots[index_of(chunk)];
+        if(s.pending) {
+            // the chunk it was reading is no longer needed
+            try {
+                s.op.wait();
+            } catch(...) {}
+        }
+        s.pending = false;
+        s.chunk   = no_chunk;
+        std::size_t offset = chunk * m_opts.chunk_size;
+        s.size   = std::min(m_opts.chunk_size, m_source.size() - offset);
+        s.op     = m_source.select(offset, s.size)
+                   .pull_to(m_ring_bulk.select(index_of(chunk) * m_opts.chunk_size, s.size));
+        s.chunk   = chunk;
+        s.pending = true;
+        s.issued  = tsc_clock::now_ns();
+    }
+
+    slot& fetch(std::size_t chunk) {
+        slot& s   = m_slots[index_of(chunk)];
+        bool  hit = s.chunk == chunk;
+        if(hit) m_hits += 1;
+        else {
+            m_misses += 1;
+            issue(chunk);
+        }
+        if(s.pending) {
+            bool ready = s.op.test();
+            s.pending  = false;
+            try {
+                s.op.wait();
+            } catch(...) {
+                s.chunk = no_chunk;
+                throw;
+            }
+            // only a wait tells when the transfer completed
+            if(!ready) {
+                if(hit) m_stalls += 1;
+                measured(tsc_clock::now_ns() - s.issued);
+            }
+        }
+        return s;
+    }
+
+    void prefetch(std::size_t chunk) {
+        std::size_t last = (m_source.size() - 1) / m_opts.chunk_size;
+        for(std::size_t k = chunk + 1; k <= chunk + m_depth && k <= last; k++) {
+            if(m_slots[index_of(k)].chunk != k) issue(k);
+        }
+    }
+
+    // a wait ended, roughly when the transfer completed
+    void measured(std::uint64_t latency) {
+        m_latency = m_latency == 0 ? latency : 0.875 * m_latency + 0.125 * latency;
+        adapt();
+    }
+
+    void consumed() {
+        std::uint64_t now = tsc_clock::now_ns();
+        if(m_last_consume != 0) {
+            double interval = static_cast<double>(now - m_last_consume);
+            m_interval = m_interval == 0 ? interval : 0.875 * m_interval + 0.125 * interval;
+            adapt();
+        }
+        m_last_consume = now;
+    }
+
+    void adapt() {
+        if(m_interval <= 0 || m_latency <= 0) return;
+        double wanted = std::ceil(m_latency / m_interval) + 1;
+        if(wanted > static_cast<double>(m_opts.max_depth)) wanted = static_cast<double>(m_opts.max_depth);
+        m_depth = std::max(m_opts.min_depth, static_cast<std::size_t>(wanted));
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -6,17 +6,53 @@
 #ifndef __THALLIUM_REMOTE_PROCEDURE_HPP
 #define __THALLIUM_REMOTE_PROCEDURE_HPP
 
+#include <cstddef>
+#include <functional>
+#include <iterator>
 #include <margo.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <thallium/admission.hpp>
+#include <thallium/async_batch.hpp>
+#include <thallium/cancellation.hpp>
 #include <thallium/margo_instance_ref.hpp>
+#include <thallium/rpc_execution.hpp>
+#include <thallium/rpc_policy.hpp>
+#include <thallium/rpc_sharding.hpp>
 
 namespace thallium {
 
 class engine;
 class endpoint;
 class provider_handle;
+class group_handle;
+class pool;
 template<typename ... CtxArg> class callable_remote_procedure_with_context;
 using callable_remote_procedure = callable_remote_procedure_with_context<>;
+struct hedge_policy;
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Name of an RPC defined with engine::define_lazy, registered
+ * the first time its id is needed.
+ */
+struct lazy_rpc {
+    std::string          name;
+    std::atomic<hg_id_t> id{0};
+    std::mutex           mutex;
+
+    explicit lazy_rpc(std::string n)
+    : name(std::move(n)) {}
+};
+
+} // namespace detail
 
 /**
  * @brief remote_procedure objects are produced by
@@ -33,6 +69,8 @@ class remote_procedure {
     margo_instance_ref m_mid;
     hg_id_t            m_id = 0;
     bool               m_ignore_response;
+    // set if defined with engine::define_lazy
+    std::shared_ptr<detail::lazy_rpc> m_lazy;
 
     /**
      * @brief Constructor. Made private because remote_procedure
@@ -46,6 +84,18 @@ class remote_procedure {
     , m_id(id)
     , m_ignore_response(false) {}
 
+    /**
+     * @brief Returns the RPC's id, registering it first if it was
+     * defined with engine::define_lazy.
+     */
+    hg_id_t registered_id() const {
+        if(m_id != 0 || !m_lazy) return m_id;
+        hg_id_t id = m_lazy->id.load(std::memory_order_acquire);
+        return id ? id : register_lazy();
+    }
+
+    hg_id_t register_lazy() const;
+
   public:
 
     remote_procedure() = default;
@@ -95,6 +145,61 @@ class remote_procedure {
      */
     callable_remote_procedure on(const provider_handle& ph) const;
 
+    /**
+     * @brief Creates a callable_remote_procedure targeting the next
+     * member of a group_handle (round-robin across the engines of an
+     * engine_group). Defined in thallium/engine_group.hpp.
+     *
+     * @param gh group_handle of the engines to spread the call across.
+     *
+     * @return a callable_remote_procedure.
+     */
+    callable_remote_procedure on(const group_handle& gh) const;
+
+    /**
+     * @brief Issues this RPC, in a non-blocking manner, to each of the
+     * targets of a range of (target, arguments) elements, and returns
+     * an async_batch that can be used to wait for the responses.
+     *
+     * Each element of the range is accessed using std::get<0> (the target,
+     * an endpoint or a provider_handle) and std::get<1> (the arguments).
+     * If the arguments are an std::tuple, its elements are passed as
+     * separate arguments to the RPC, otherwise the value is passed as
+     * the RPC's single argument. For example, a std::vector of
+     * std::pair<provider_handle, std::string> can be used.
+     *
+     * @tparam Iterator Iterator type.
+     * @param begin Beginning of the range.
+     * @param end End of the range.
+     *
+     * @return an async_batch holding one async_response per element.
+     */
+    template <typename Iterator>
+    async_batch forward_batch(Iterator begin, Iterator end) const;
+
+    /**
+     * @brief Sends this RPC to the first of a list of replicas (endpoints
+     * or provider_handles) and, if no response arrived after a hedge
+     * delay derived from the RPC's round-trip time statistics (see
+     * hedge_policy), to the next one, up to policy.max_hedges times.
+     * A replica is also tried right away if all the previous ones
+     * failed. The first response received is returned; the others
+     * are cancelled (see async_response::cancel). Defined in
+     * thallium/hedged.hpp.
+     *
+     * This is only meant for RPCs that can safely be executed by more
+     * than one replica (e.g. reads).
+     *
+     * @param replicas Replicas to send the RPC to, in order of preference.
+     * @param policy Hedging parameters.
+     * @param args Parameters of the RPC.
+     *
+     * @return a packed_data containing the first response.
+     */
+    template <typename Target, typename... T>
+    packed_data<> hedged(const std::vector<Target>& replicas,
+                         const hedge_policy& policy, const T&... args) const;
+
     /**
      * @brief Tell the remote_procedure that it should not expect responses.
      *
@@ -103,6 +208,136 @@ class remote_procedure {
     remote_procedure& disable_response() &;
     remote_procedure&& disable_response() &&;
 
+    /**
+     * @brief Sets the priority (0 is the highest) with which the ULTs
+     * handling this RPC are pushed into its handler pool. Only pools
+     * created with pool::kind::priority take it into account.
+     *
+     * @param priority Priority.
+     *
+     * @return *this
+     */
+    remote_procedure& set_priority(int priority) &;
+    remote_procedure&& set_priority(int priority) &&;
+
+    /**
+     * @brief Sets how the ULT (or tasklet) running the handler of this
+     * RPC is created on this process, e.g. with a custom stack size.
+     * See rpc_execution.
+     *
+     * @param execution Execution settings.
+     *
+     * @return this remote_procedure, to allow chaining after define.
+     */
+    remote_procedure& set_execution(const rpc_execution& execution) &;
+    remote_procedure&& set_execution(const rpc_execution& execution) &&;
+
+    /**
+     * @brief Bounds the number of requests of this RPC in flight on this
+     * process, see admission_limit.
+     *
+     * @param limit Admission limit, possibly shared with other RPCs.
+     *
+     * @return *this
+     */
+    remote_procedure& set_admission(const admission_limit& limit) &;
+    remote_procedure&& set_admission(const admission_limit& limit) &&;
+
+    /**
+     * @brief Spreads the handlers of this RPC across several pools
+     * according to the value of its first argument, of type Key: when
+     * an RPC is received, the first argument is decoded (with the
+     * default serialization context) from the progress loop, and the
+     * handler is pushed into pools[shard(key) % pools.size()]. Requests
+     * with the same key are therefore always handled by the same pool,
+     * which, if each pool is served by a single execution stream, lets
+     * per-shard state be accessed without locks.
+     *
+     * The pools replace the one given to define; the argument is
+     * decoded again when the handler runs.
+     *
+     * \code{.cpp}
+     * provider.define("put", &kv_provider::put).set_sharding<uint64_t>(pools);
+     * \endcode
+     *
+     * @tparam Key Type of the first argument of the RPC.
+     * @param pools Pools to push handlers into (empty to stop sharding).
+     * @param shard Function mapping a key to a shard.
+     *
+     * @return *this
+     */
+    template <typename Key>
+    remote_procedure& set_sharding(const std::vector<pool>& pools,
+                                   std::function<std::size_t(const Key&)> shard
+                                        = std::hash<Key>()) &;
+    template <typename Key>
+    remote_procedure&& set_sharding(const std::vector<pool>& pools,
+                                    std::function<std::size_t(const Key&)> shard
+                                        = std::hash<Key>()) &&;
+
+    /**
+     * @brief Lets the requests of this RPC be cancelled with
+     * async_response::cancel. Each request then carries a token after
+     * its arguments, which the server uses to drop the request if it is
+     * still queued when the cancellation arrives, or to report it with
+     * request::is_cancelled to a handler already running.
+     *
+     * This changes the encoding of the RPC's input, so it must be called
+     * on both the client and the server, before the RPC is sent or
+     * received (typically right after define).
+     *
+     * \code{.cpp}
+     * auto rpc = engine.define("compute", compute_handler).enable_cancellation();
+     * auto response = rpc.on(ep).async(args);
+     * response.cancel();
+     * try { response.wait(); } catch(const tl::cancelled&) {}
+     * \endcode
+     *
+     * @return *this
+     */
+    remote_procedure& enable_cancellation() &;
+    remote_procedure&& enable_cancellation() &&;
+
+    /**
+     * @brief Makes the requests of this RPC sent with a timeout carry
+     * their deadline (the time they were sent plus the timeout, on the
+     * client's system clock) after their arguments. The server drops
+     * requests whose deadline passed while they were queued, instead of
+     * running handlers whose response nobody waits for anymore, and
+     * running handlers can read it with request::deadline(). This
+     * assumes the clocks of the client and the server are synchronized
+     * (e.g. with NTP) to well within the timeouts used.
+     *
+     * Like enable_cancellation, this must be called on both the client
+     * and the server, before the RPC is sent or received.
+     *
+     * @return *this
+     */
+    remote_procedure& enable_deadline_propagation() &;
+    remote_procedure&& enable_deadline_propagation() &&;
+
+    /**
+     * @brief Makes the requests of this RPC carry a trace header (a
+     * 128-bit trace id and the 64-bit id of the client's span) after
+     * their arguments. Each request is a child span of the sending ULT's
+     * current trace (see trace_scope), or the root of a new trace if it
+     * has none. On the server, the handler runs with its own span, child
+     * of the client's, as current trace (so that the RPCs it sends
+     * belong to the same trace), and can read it with request::trace().
+     * If RPC statistics are compiled in, the client and server spans are
+     * recorded by the engines that enabled span collection (see
+     * engine::enable_span_collection).
+     *
+     * Like enable_cancellation, this must be called on both the client
+     * and the server, before the RPC is sent or received. RPCs for which
+     * enable_cancellation or enable_deadline_propagation was called
+     * carry the trace header too.
+     *
+     * @return *this
+     */
+    remote_procedure& enable_tracing() &;
+    remote_procedure&& enable_tracing() &&;
+
     /**
      * @brief Deregisters this RPC from the engine.
      */
@@ -112,7 +347,7 @@ class remote_procedure {
      * @brief Return the ID of the RPC.
      */
     hg_id_t id() const {
-        return m_id;
+        return registered_id();
     }
 };
 
@@ -138,26 +373,83 @@ class auto_remote_procedure : public remote_procedure {
 #include <thallium/callable_remote_procedure.hpp>
 #include <thallium/engine.hpp>
 #include <thallium/provider_handle.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/proc_object.hpp>
+#include <thallium/hedged.hpp>
 
 namespace thallium {
 
+inline hg_id_t remote_procedure::register_lazy() const {
+    std::lock_guard<std::mutex> lock(m_lazy->mutex);
+    hg_id_t id = m_lazy->id.load(std::memory_order_relaxed);
+    if(id == 0) {
+        id = engine(m_mid).define(m_lazy->name.c_str()).m_id;
+        m_lazy->id.store(id, std::memory_order_release);
+    }
+    return id;
+}
+
 inline callable_remote_procedure remote_procedure::on(const endpoint& ep) const {
-    if(m_id == 0)
+    hg_id_t id = registered_id();
+    if(id == 0)
         throw exception("remote_procedure object isn't initialized");
-    return callable_remote_procedure(m_mid, m_id, ep, m_ignore_response, 0);
+    return callable_remote_procedure(m_mid, id, ep, m_ignore_response, 0);
 }
 
 inline callable_remote_procedure
 remote_procedure::on(const provider_handle& ph) const {
-    if(m_id == 0)
+    hg_id_t id = registered_id();
+    if(id == 0)
         throw exception("remote_procedure object isn't initialized");
-    return callable_remote_procedure(m_mid, m_id, ph, m_ignore_response,
-                                     ph.provider_id());
+    callable_remote_procedure c(m_mid, id, ph, m_ignore_response,
+                                ph.provider_id());
+    c.m_window = ph.m_window;
+    c.m_retry  = ph.m_retry;
+    return c;
+}
+
+namespace detail {
+
+template <typename Callable, typename... Args, std::size_t... I>
+async_response async_with_tuple_args(Callable& c, const std::tuple<Args...>& args,
+                                     std::index_sequence<I...>) {
+    (void)args;
+    return c.async(std::get<I>(args)...);
+}
+
+template <typename Callable, typename... Args>
+async_response async_with_args(Callable& c, const std::tuple<Args...>& args) {
+    return async_with_tuple_args(c, args, std::index_sequence_for<Args...>());
+}
+
+template <typename Callable, typename Arg>
+async_response async_with_args(Callable& c, const Arg& arg) {
+    return c.async(arg);
+}
+
+} // namespace detail
+
+template <typename Iterator>
+async_batch remote_procedure::forward_batch(Iterator begin, Iterator end) const {
+    if(registered_id() == 0)
+        throw exception("remote_procedure object isn't initialized");
+    async_batch batch;
+    batch.reserve(static_cast<std::size_t>(std::distance(begin, end)));
+    for(auto it = begin; it != end; ++it) {
+        auto callable = on(std::get<0>(*it));
+        batch.push_back(detail::async_with_args(callable, std::get<1>(*it)));
+    }
+    return batch;
 }
 
 inline void remote_procedure::deregister() {
     MARGO_INSTANCE_MUST_BE_VALID;
-    margo_deregister(m_mid, m_id);
+    // a lazy RPC that was never used was never registered
+    hg_id_t id = m_lazy ? m_lazy->id.load(std::memory_order_acquire) : m_id;
+    if(id == 0) return;
+    // self-calls must not run the handler of a deregistered RPC
+    if(auto local = detail::local_dispatch::find(m_mid)) local->set_type(id, nullptr);
+    margo_deregister(m_mid, id);
 }
 
 inline remote_procedure&& remote_procedure::disable_response() && {
@@ -167,7 +459,127 @@ inline remote_procedure&& remote_procedure::disable_response() && {
 inline remote_procedure& remote_procedure::disable_response() & {
     MARGO_INSTANCE_MUST_BE_VALID;
     m_ignore_response = true;
-    margo_registered_disable_response(m_mid, m_id, HG_TRUE);
+    margo_registered_disable_response(m_mid, registered_id(), HG_TRUE);
+    return *this;
+}
+
+inline remote_procedure&& remote_procedure::set_priority(int priority) && {
+    return std::move(set_priority(priority));
+}
+
+inline remote_procedure& remote_procedure::set_priority(int priority) & {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    if(priority < 0)
+        throw exception("RPC priority must not be negative");
+    detail::rpc_policy_table::of(m_mid, registered_id()).priority.store(priority);
+    return *this;
+}
+
+inline remote_procedure&& remote_procedure::set_execution(const rpc_execution& execution) && {
+    return std::move(set_execution(execution));
+}
+
+inline remote_procedure& remote_procedure::set_execution(const rpc_execution& execution) & {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    if(execution.as_task && execution.stack_size != 0)
+        throw exception("A stack size cannot be given to RPCs running as tasks");
+    if(execution.inline_handler && (execution.as_task || execution.stack_size != 0))
+        throw exception("RPCs running inline cannot also run as tasks or with a stack size");
+    if(execution.stack_size != 0 && execution.stack_size < 4096)
+        throw exception("RPC stack size must be at least 4096 bytes");
+    detail::rpc_policy_table::of(m_mid, registered_id())
+        .execution.store(detail::rpc_execution_registry::add(m_mid, execution));
+    return *this;
+}
+
+inline remote_procedure&& remote_procedure::set_admission(const admission_limit& limit) && {
+    return std::move(set_admission(limit));
+}
+
+inline remote_procedure& remote_procedure::set_admission(const admission_limit& limit) & {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    hg_id_t id = registered_id();
+    detail::rpc_policy_table::of(m_mid, id)
+        .admission.store(detail::rpc_admission_registry::set(m_mid, id, limit.m_state));
+    return *this;
+}
+
+inline remote_procedure&& remote_procedure::enable_cancellation() && {
+    return std::move(enable_cancellation());
+}
+
+inline remote_procedure& remote_procedure::enable_cancellation() & {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    if(detail::rpc_control_registry::cancel_rpc_id(m_mid) == 0) {
+        const char* name = "__thallium_cancel__";
+        hg_bool_t   flag = HG_FALSE;
+        hg_id_t     id   = 0;
+        margo_registered_name(m_mid, name, &id, &flag);
+        if(flag == HG_FALSE)
+            id = engine(m_mid).register_generic_rpc(name, 0, pool());
+        margo_registered_disable_response(m_mid, id, HG_TRUE);
+        detail::rpc_control_registry::set_cancel_rpc_id(m_mid, id);
+    }
+    detail::rpc_policy_table::of(m_mid, registered_id()).control.store(true);
+    return *this;
+}
+
+inline remote_procedure&& remote_procedure::enable_deadline_propagation() && {
+    return std::move(enable_deadline_propagation());
+}
+
+inline remote_procedure& remote_procedure::enable_deadline_propagation() & {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    detail::rpc_policy_table::of(m_mid, registered_id()).control.store(true);
+    return *this;
+}
+
+inline remote_procedure&& remote_procedure::enable_tracing() && {
+    return std::move(enable_tracing());
+}
+
+inline remote_procedure& remote_procedure::enable_tracing() & {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    detail::rpc_policy_table::of(m_mid, registered_id()).control.store(true);
+    return *this;
+}
+
+template <typename Key>
+inline remote_procedure&& remote_procedure::set_sharding(
+        const std::vector<pool>& pools, std::function<std::size_t(const Key&)> shard) && {
+    return std::move(set_sharding<Key>(pools, std::move(shard)));
+}
+
+template <typename Key>
+inline remote_procedure& remote_procedure::set_sharding(
+        const std::vector<pool>& pools, std::function<std::size_t(const Key&)> shard) & {
+    MARGO_INSTANCE_MUST_BE_VALID;
+    std::vector<ABT_pool> handles;
+    handles.reserve(pools.size());
+    for(auto& p : pools) handles.push_back(p.native_handle());
+    margo_instance_id   mid    = m_mid;
+    hg_id_t             id     = registered_id();
+    detail::rpc_policy& policy = detail::rpc_policy_table::of(mid, id);
+    auto selector = [mid, &policy, shard=std::move(shard)](hg_handle_t h) -> std::size_t {
+        // decodes only the key, the rest is skipped as an opaque_payload
+        std::tuple<Key, opaque_payload> args;
+        std::tuple<>                    ctx;
+        detail::opaque_payload_access::set_encoded_size(
+            &std::get<1>(args), HG_Get_input_payload_size(h)
+                              - detail::rpc_control_registry::trailer_size(&policy));
+        meta_proc_fn mproc = [mid, &args, &ctx](hg_proc_t proc) {
+            return proc_object_decode(proc, args, mid, ctx);
+        };
+        try {
+            if(margo_get_input(h, &mproc) != HG_SUCCESS) return 0;
+            margo_free_input(h, &mproc);
+        } catch(...) {
+            return 0;
+        }
+        return shard(std::get<0>(args));
+    };
+    policy.shard.store(detail::rpc_shard_registry::add(m_mid, std::move(handles),
+                                                       std::move(selector)));
     return *this;
 }
 
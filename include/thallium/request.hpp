@@ -6,14 +6,23 @@
 #ifndef __THALLIUM_REQUEST_HPP
 #define __THALLIUM_REQUEST_HPP
 
+#include <chrono>
+#include <cstdint>
 #include <margo.h>
+#include <thallium/async_respond.hpp>
+#include <thallium/cancellation.hpp>
 #include <thallium/margo_exception.hpp>
 #include <thallium/margo_instance_ref.hpp>
+#include <thallium/non_blocking.hpp>
 #include <thallium/proc_object.hpp>
+#include <thallium/proc_size_hints.hpp>
 #include <thallium/serialization/proc_output_archive.hpp>
 #include <thallium/serialization/serialize.hpp>
 #include <thallium/endpoint.hpp>
+#include <thallium/local_dispatch.hpp>
 #include <thallium/packed_data.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/rpc_stats.hpp>
 
 namespace thallium {
 
@@ -38,6 +47,14 @@ class request_with_context {
     hg_handle_t                   m_handle;
     bool                          m_disable_response;
     mutable std::tuple<CtxArg...> m_context;
+    // arguments and response of an RPC the engine sent to itself, set
+    // by the handler if it took the arguments by pointer
+    mutable detail::local_call*   m_local = nullptr;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    // metrics of the RPC, set by thallium_generic_rpc if statistics are
+    // being recorded
+    detail::rpc_metrics*          m_stats = nullptr;
+#endif
 
     /**
      * @brief Constructor. Made private since request_with_context are only created
@@ -56,9 +73,87 @@ class request_with_context {
     , m_handle(h)
     , m_disable_response(disable_resp)
     , m_context(std::move(context)) {
-        margo_ref_incr(m_handle);
+        if(m_handle != HG_HANDLE_NULL) margo_ref_incr(m_handle);
+    }
+
+    void check_can_respond() const {
+        if(m_disable_response) {
+            throw exception(
+                "Calling respond from an RPC that has disabled responses");
+        }
+        if(m_handle == HG_HANDLE_NULL && !m_local) {
+            throw exception("In request_with_context::respond : null internal hg_handle_t");
+        }
+    }
+
+    template <typename... T>
+    hg_return_t encode_response(hg_proc_t proc, std::tuple<T...>& args) const {
+        return detail::encode_with_size_hint(proc, m_handle, true, [this, &args](hg_proc_t p) {
+            return proc_object_encode(p, args, m_mid, m_context);
+        });
+    }
+
+    hg_return_t encode_response(hg_proc_t proc, std::tuple<>&) const {
+        return proc_void_object(proc, m_context);
+    }
+
+    /**
+     * @brief Hands the values of the response to the caller if the
+     * request is an RPC the engine sent to itself and the values can
+     * be passed as they are (see engine::enable_local_dispatch), in
+     * which case the response sent through Mercury is empty.
+     */
+    template <typename... T>
+    bool respond_locally(T&&... t) const {
+        if(!m_local || sizeof...(CtxArg) != 0) return false;
+        return detail::hand_local_response(*m_local, std::forward<T>(t)...);
+    }
+
+    /**
+     * @brief Responds to an RPC the engine sent to itself and ran in the
+     * caller's ULT, without a handle (see local_dispatch::invoke): the
+     * values are handed to the caller, encoded if they can't be handed
+     * as they are.
+     */
+    template <typename... T>
+    void respond_in_place(T&&... t) const {
+        if(sizeof...(T) != 0 && !respond_locally(std::forward<T>(t)...)) {
+            auto args = std::make_tuple(std::cref(t)...);
+            hg_return_t ret = detail::hand_encoded_response(*m_local, args, m_mid, m_context);
+            MARGO_ASSERT(ret, hand_encoded_response);
+        }
+        if(m_local->responded) m_local->responded->set_value();
     }
 
+    static hg_return_t empty_response(hg_proc_t) {
+        return HG_SUCCESS;
+    }
+
+    /**
+     * @brief Meta-serialization function reading (HG_DECODE) the
+     * address of size bytes of a payload left in the Mercury buffer,
+     * or copying (HG_ENCODE) size bytes from data into it.
+     */
+    static meta_proc_fn raw_payload_proc(const char*& data, std::size_t size) {
+        return [&data, size](hg_proc_t proc) {
+            if(size == 0) return HG_SUCCESS;
+            switch(hg_proc_get_op(proc)) {
+            case HG_ENCODE:
+                return hg_proc_memcpy(proc, const_cast<char*>(data), size);
+            case HG_DECODE: {
+                if(hg_proc_get_size_left(proc) < size) return HG_OVERFLOW;
+                void* buf = hg_proc_save_ptr(proc, size);
+                data      = static_cast<const char*>(buf);
+                return hg_proc_restore_ptr(proc, buf, size);
+            }
+            default:
+                return HG_SUCCESS;
+            }
+        };
+    }
+
+    void forward_raw(hg_addr_t addr, bool to_provider, uint16_t provider_id) const;
+
   public:
     /**
      * @brief Copy constructor.
@@ -67,7 +162,13 @@ class request_with_context {
     : m_mid(other.m_mid)
     , m_handle(other.m_handle)
     , m_disable_response(other.m_disable_response)
-    , m_context(other.m_context) {
+    , m_context(other.m_context)
+    , m_local(other.m_local)
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    , m_stats(other.m_stats)
+#endif
+    {
+        if(m_handle == HG_HANDLE_NULL) return;
         hg_return_t ret = margo_ref_incr(m_handle);
         MARGO_ASSERT(ret, margo_ref_incr);
     }
@@ -79,13 +180,18 @@ class request_with_context {
     : m_mid(std::move(other.m_mid))
     , m_handle(std::exchange(other.m_handle, HG_HANDLE_NULL))
     , m_disable_response(other.m_disable_response)
-    , m_context(std::move(other.m_context)) {}
+    , m_context(std::move(other.m_context))
+    , m_local(other.m_local)
+#ifdef THALLIUM_ENABLE_RPC_STATS
+    , m_stats(other.m_stats)
+#endif
+    {}
 
     /**
      * @brief Copy-assignment operator.
      */
     request_with_context& operator=(const request_with_context& other) {
-        if(m_handle == other.m_handle)
+        if(m_handle == other.m_handle && m_local == other.m_local)
             return *this;
         hg_return_t ret;
         ret = margo_destroy(m_handle);
@@ -94,6 +200,11 @@ class request_with_context {
         m_handle           = other.m_handle;
         m_disable_response = other.m_disable_response;
         m_context          = other.m_context;
+        m_local            = other.m_local;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        m_stats            = other.m_stats;
+#endif
+        if(m_handle == HG_HANDLE_NULL) return *this;
         ret                = margo_ref_incr(m_handle);
         MARGO_ASSERT(ret, margo_ref_incr);
         return *this;
@@ -103,13 +214,17 @@ class request_with_context {
      * @brief Move-assignment operator.
      */
     request_with_context& operator=(request_with_context&& other) noexcept {
-        if(m_handle == other.m_handle)
+        if(m_handle == other.m_handle && m_local == other.m_local)
             return *this;
         margo_destroy(m_handle);
         m_mid              = std::move(other.m_mid);
         m_handle           = std::exchange(other.m_handle, HG_HANDLE_NULL);
         m_disable_response = other.m_disable_response;
         m_context          = std::move(other.m_context);
+        m_local            = other.m_local;
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        m_stats            = other.m_stats;
+#endif
         return *this;
     }
 
@@ -148,11 +263,15 @@ class request_with_context {
      */
     template<typename ... NewCtxArg>
     auto with_serialization_context(NewCtxArg&&... args) const {
-        return request_with_context<unwrap_decay_t<NewCtxArg>...>(
+        request_with_context<unwrap_decay_t<NewCtxArg>...> req(
                 m_mid,
                 m_handle,
                 m_disable_response,
                 std::make_tuple<NewCtxArg...>(std::forward<NewCtxArg>(args)...));
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        req.m_stats = m_stats;
+#endif
+        return req;
     }
 
     /**
@@ -169,11 +288,21 @@ class request_with_context {
             throw exception(
                 "Calling respond from an RPC that has disabled responses");
         }
+        if(m_handle == HG_HANDLE_NULL && m_local) {
+            respond_in_place(std::forward<T1>(t1), std::forward<T>(t)...);
+            return;
+        }
         if(m_handle != HG_HANDLE_NULL) {
+            bool local = respond_locally(std::forward<T1>(t1), std::forward<T>(t)...);
             auto args = std::make_tuple(std::cref(t1), std::cref(t)...);
-            meta_proc_fn mproc = [this, &args](hg_proc_t proc) {
-                return proc_object_encode(proc, args, m_mid, m_context);
+            meta_proc_fn mproc = [this, &args, local](hg_proc_t proc) {
+                if(local) return empty_response(proc);
+                return encode_response(proc, args);
             };
+            detail::check_can_block("request::respond");
+#ifdef THALLIUM_ENABLE_RPC_STATS
+            detail::rpc_stats_scope respond_scope(m_stats, detail::rpc_metric::respond);
+#endif
             hg_return_t ret = margo_respond(m_handle, &mproc);
             MARGO_ASSERT(ret, margo_respond);
         } else {
@@ -186,10 +315,18 @@ class request_with_context {
             throw exception(
                 "Calling respond from an RPC that has disabled responses");
         }
+        if(m_handle == HG_HANDLE_NULL && m_local) {
+            respond_in_place();
+            return;
+        }
         if(m_handle != HG_HANDLE_NULL) {
             meta_proc_fn mproc = [this](hg_proc_t proc) {
                 return proc_void_object(proc, m_context);
             };
+            detail::check_can_block("request::respond");
+#ifdef THALLIUM_ENABLE_RPC_STATS
+            detail::rpc_stats_scope respond_scope(m_stats, detail::rpc_metric::respond);
+#endif
             auto ret = margo_respond(m_handle, &mproc);
             MARGO_ASSERT(ret, margo_respond);
         } else {
@@ -197,22 +334,199 @@ class request_with_context {
         }
     }
 
+    /**
+     * @brief Non-blocking version of respond. The arguments are
+     * serialized before the function returns, so they don't need to
+     * outlive the call; the returned async_respond can be used to wait
+     * for the response to be sent.
+     *
+     * @tparam T Types of parameters to serialize.
+     * @param t Parameters to serialize.
+     *
+     * @return an async_respond object.
+     */
+    template <typename... T>
+    async_respond irespond(T&&... t) const {
+        check_can_respond();
+        if(m_handle == HG_HANDLE_NULL) {
+            respond_in_place(std::forward<T>(t)...);
+            return async_respond();
+        }
+        bool local = sizeof...(T) != 0 && respond_locally(std::forward<T>(t)...);
+        auto args = std::make_tuple(std::cref(t)...);
+        meta_proc_fn mproc = [this, &args, local](hg_proc_t proc) {
+            if(local) return empty_response(proc);
+            return encode_response(proc, args);
+        };
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        detail::rpc_stats_scope respond_scope(m_stats, detail::rpc_metric::respond);
+#endif
+        margo_request req = MARGO_REQUEST_NULL;
+        hg_return_t ret = margo_irespond(m_handle, &mproc, &req);
+        MARGO_ASSERT(ret, margo_irespond);
+        return async_respond(m_handle, req);
+    }
+
+    /**
+     * @brief Fire-and-forget version of respond: sends the response
+     * without blocking and without returning anything to wait on.
+     * The RPC handle is kept alive until the response has been sent.
+     * Errors happening after the response was posted are ignored.
+     *
+     * @tparam T Types of parameters to serialize.
+     * @param t Parameters to serialize.
+     */
+    template <typename... T>
+    void respond_detached(T&&... t) const {
+        check_can_respond();
+        if(m_handle == HG_HANDLE_NULL) {
+            respond_in_place(std::forward<T>(t)...);
+            return;
+        }
+        bool local = sizeof...(T) != 0 && respond_locally(std::forward<T>(t)...);
+        auto args = std::make_tuple(std::cref(t)...);
+        meta_proc_fn mproc = [this, &args, local](hg_proc_t proc) {
+            if(local) return empty_response(proc);
+            return encode_response(proc, args);
+        };
+#ifdef THALLIUM_ENABLE_RPC_STATS
+        detail::rpc_stats_scope respond_scope(m_stats, detail::rpc_metric::respond);
+#endif
+        hg_return_t ret = detail::respond_detached(m_handle, &mproc);
+        MARGO_ASSERT(ret, margo_irespond);
+    }
+
+    /**
+     * @brief Forwards the RPC, as received, to another process (which
+     * must have defined the same RPC), waits for the response, and
+     * sends it back as the response to this request. The input and
+     * output payloads are copied between buffers without being decoded,
+     * so this can be called from a handler taking only a request (or
+     * an opaque_payload), after which the request must not be
+     * responded to again. If responses are disabled for this RPC, only
+     * the forward is done.
+     *
+     * @param ep Endpoint to forward the RPC to.
+     */
+    void forward_to(const endpoint& ep) const {
+        forward_raw(ep.get_addr(), false, 0);
+    }
+
+    /**
+     * @brief Same as forward_to(endpoint), forwarding the RPC to the
+     * provider with the id of the provider_handle (the RPC was received
+     * for a possibly different provider id).
+     *
+     * @param ph Provider handle to forward the RPC to.
+     */
+    void forward_to(const provider_handle& ph) const {
+        forward_raw(ph.get_addr(), true, ph.provider_id());
+    }
+
     /**
      * @brief Get the endpoint corresponding to the sender of the RPC.
      *
      * @return endpoint corresponding to the sender of the RPC.
      */
     endpoint get_endpoint() const {
+        hg_addr_t addr;
+        // the sender of a local call run without a handle is the engine
+        if(m_handle == HG_HANDLE_NULL && m_local) {
+            hg_return_t ret = margo_addr_self(m_mid, &addr);
+            MARGO_ASSERT(ret, margo_addr_self);
+            return endpoint(m_mid, addr);
+        }
         const struct hg_info* info = margo_get_info(m_handle);
-        hg_addr_t             addr;
         hg_return_t ret = margo_addr_dup(m_mid, info->addr, &addr);
         MARGO_ASSERT(ret, margo_addr_dup);
         return endpoint(m_mid, addr);
     }
+
+    /**
+     * @brief Returns whether the client cancelled this request (see
+     * remote_procedure::enable_cancellation). Long-running handlers can
+     * poll this to stop early; the client no longer waits for their
+     * response.
+     */
+    bool is_cancelled() const {
+        return detail::rpc_control_registry::is_cancelled(m_mid, m_handle);
+    }
+
+    /**
+     * @brief Returns the deadline the client sent this request with (see
+     * remote_procedure::enable_deadline_propagation), after which it
+     * stops waiting for the response, or time_point::max() if it has
+     * none.
+     */
+    std::chrono::system_clock::time_point deadline() const {
+        std::uint64_t d = detail::rpc_control_registry::deadline(m_mid, m_handle);
+        if(d == 0) return std::chrono::system_clock::time_point::max();
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(d)));
+    }
+
+    /**
+     * @brief Returns the context of the span of this request's handler
+     * (see remote_procedure::enable_tracing), whose parent is the
+     * client's span, or an invalid context if the request isn't traced.
+     */
+    trace_context trace() const {
+        return detail::rpc_control_registry::trace(m_mid, m_handle);
+    }
 };
 
 using request = request_with_context<>;
 
+template <typename... CtxArg>
+void request_with_context<CtxArg...>::forward_raw(hg_addr_t addr, bool to_provider,
+                                                  uint16_t provider_id) const {
+    if(m_handle == HG_HANDLE_NULL)
+        throw exception("In request_with_context::forward_to : null internal hg_handle_t");
+    const struct hg_info* info = margo_get_info(m_handle);
+    // the input payload is referenced in the buffer of this request's
+    // handle, which stays valid as long as the handle does
+    const char*  input      = nullptr;
+    std::size_t  input_size = HG_Get_input_payload_size(m_handle);
+    meta_proc_fn iproc      = raw_payload_proc(input, input_size);
+    hg_return_t ret = margo_get_input(m_handle, &iproc);
+    MARGO_ASSERT(ret, margo_get_input);
+    ret = margo_free_input(m_handle, &iproc);
+    MARGO_ASSERT(ret, margo_free_input);
+
+    hg_handle_t h = HG_HANDLE_NULL;
+    ret = margo_create(m_mid, addr, info->id, &h);
+    MARGO_ASSERT(ret, margo_create);
+    // the payload is only read by the proc callback while forwarding
+    meta_proc_fn fproc = raw_payload_proc(input, input_size);
+    if(to_provider)
+        ret = margo_provider_forward(provider_id, h, &fproc);
+    else
+        ret = margo_forward(h, &fproc);
+    if(ret != HG_SUCCESS) {
+        margo_destroy(h);
+        MARGO_ASSERT(ret, margo_forward);
+    }
+    if(m_disable_response) {
+        margo_destroy(h);
+        return;
+    }
+
+    const char*  output      = nullptr;
+    std::size_t  output_size = HG_Get_output_payload_size(h);
+    meta_proc_fn oproc       = raw_payload_proc(output, output_size);
+    ret = margo_get_output(h, &oproc);
+    if(ret != HG_SUCCESS) {
+        margo_destroy(h);
+        MARGO_ASSERT(ret, margo_get_output);
+    }
+    meta_proc_fn rproc = raw_payload_proc(output, output_size);
+    ret = margo_respond(m_handle, &rproc);
+    margo_free_output(h, &oproc);
+    margo_destroy(h);
+    MARGO_ASSERT(ret, margo_respond);
+}
+
 /**
  * @brief auto_respond is a helper class that prevents
  * users from forgetting to call req.respond() by
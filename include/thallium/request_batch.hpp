@@ -0,0 +1,109 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_REQUEST_BATCH_HPP
+#define __THALLIUM_REQUEST_BATCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <thallium/condition_variable.hpp>
+#include <thallium/mutex.hpp>
+
+namespace thallium {
+
+template <typename ... CtxArg> class request_with_context;
+using request = request_with_context<>;
+
+/**
+ * @brief Type of the batch passed to handlers defined with
+ * engine::define_batched: one (request, arguments) entry per RPC
+ * received. The handler is expected to respond to each request
+ * individually.
+ *
+ * @tparam Args Types of the arguments of the RPC.
+ */
+template <typename... Args>
+using request_batch = std::vector<std::pair<request, std::tuple<Args...>>>;
+
+namespace detail {
+
+/**
+ * @private
+ * @brief State shared by the handler ULTs of an RPC defined with
+ * engine::define_batched. The first request of a batch waits for
+ * the batch to fill up or for the maximum delay to expire; requests
+ * arriving in the meantime are appended to the batch and return
+ * immediately. Whichever ULT completes the batch runs the user
+ * handler on it.
+ */
+template <typename... Args>
+struct request_batch_state {
+    using batch_type   = request_batch<Args...>;
+    using handler_type = std::function<void(batch_type&)>;
+
+    handler_type              m_handler;
+    std::size_t               m_max_size;
+    std::chrono::microseconds m_max_delay;
+    mutex                     m_mutex;
+    condition_variable        m_cv;
+    batch_type                m_batch;
+    std::uint64_t             m_epoch = 0;
+
+    request_batch_state(handler_type handler, std::size_t max_size,
+                        std::chrono::microseconds max_delay)
+    : m_handler(std::move(handler))
+    , m_max_size(max_size ? max_size : 1)
+    , m_max_delay(max_delay) {
+        m_batch.reserve(m_max_size);
+    }
+
+    template <typename... T>
+    void add(const request& req, T&&... args) {
+        std::unique_lock<mutex> lock(m_mutex);
+        m_batch.emplace_back(std::piecewise_construct,
+                             std::forward_as_tuple(req),
+                             std::forward_as_tuple(std::forward<T>(args)...));
+        if(m_batch.size() == 1 && m_max_size > 1 && m_max_delay.count() > 0) {
+            // first request of the batch, wait for it to fill up
+            std::uint64_t epoch = m_epoch;
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            auto usec = m_max_delay.count() + deadline.tv_nsec / 1000;
+            deadline.tv_sec  += usec / 1000000;
+            deadline.tv_nsec  = (usec % 1000000) * 1000 + deadline.tv_nsec % 1000;
+            while(m_epoch == epoch) {
+                if(!m_cv.wait_until(lock, &deadline)) break;
+            }
+            if(m_epoch != epoch) return; // batch was completed by another ULT
+        } else if(m_batch.size() < m_max_size) {
+            return;
+        }
+        flush(lock);
+    }
+
+  private:
+
+    void flush(std::unique_lock<mutex>& lock) {
+        batch_type batch;
+        batch.reserve(m_max_size);
+        batch.swap(m_batch);
+        m_epoch += 1;
+        m_cv.notify_all();
+        lock.unlock();
+        m_handler(batch);
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,577 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RESPONSE_CACHE_HPP
+#define __THALLIUM_RESPONSE_CACHE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <mercury_proc.h>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/local_dispatch.hpp>
+#include <thallium/packed_data.hpp>
+#include <thallium/proc_object.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/request.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+inline std::uint64_t fnv1a64(const void* data, std::size_t size,
+                             std::uint64_t h = 1469598103934665603ULL) noexcept {
+    auto p = static_cast<const unsigned char*>(data);
+    for(std::size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+inline const char* cache_invalidate_rpc_name() {
+    return "__thallium_response_cache_invalidate__";
+}
+
+/**
+ * @private
+ * @brief Encodes the arguments of an RPC the way they are sent, to
+ * identify a call in a response_cache or a lease_tracker.
+ */
+template <typename... T>
+std::vector<char> encode_cache_args(margo_instance_id mid, const T&... args) {
+    auto              t = std::make_tuple(std::cref(args)...);
+    std::tuple<>      ctx;
+    std::vector<char> buffer(get_encoded_size(t, mid, ctx));
+    if(buffer.empty()) return buffer;
+    hg_proc_t   proc = HG_PROC_NULL;
+    hg_return_t ret  = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                          HG_ENCODE, HG_NOHASH, &proc);
+    MARGO_ASSERT(ret, hg_proc_create_set);
+    ret = proc_object_encode(proc, t, mid, ctx);
+    hg_proc_free(proc);
+    MARGO_ASSERT(ret, proc_object_encode);
+    return buffer;
+}
+
+/**
+ * @private
+ * @brief Invalidation sent by a lease_tracker to the clients holding a
+ * lease on the response to a call.
+ */
+struct cache_invalidation {
+    std::uint64_t rpc         = 0; // hash of the RPC's name
+    std::uint16_t provider_id = 0;
+    std::uint64_t args_hash   = 0;
+
+    template <typename A> void serialize(A& ar) {
+        ar(rpc, provider_id, args_hash);
+    }
+};
+
+inline hg_return_t copy_cached_response(const void* values, margo_instance_id,
+                                        std::vector<char>& buffer) {
+    buffer = *static_cast<const std::vector<char>*>(values);
+    return HG_SUCCESS;
+}
+
+/**
+ * @private
+ * @brief Entries of a response_cache. Entries are bucketed by the hash
+ * of the RPC, provider id and arguments, which is what invalidations
+ * carry, and also matched on the address of the provider and the
+ * arguments themselves.
+ */
+class response_cache_state {
+
+  public:
+
+    using clock = std::chrono::steady_clock;
+
+    struct entry {
+        std::string                        address;
+        std::uint64_t                      rpc;
+        std::uint16_t                      provider_id;
+        std::vector<char>                  args;
+        std::shared_ptr<std::vector<char>> response;
+        clock::time_point                  expiry;
+    };
+
+    clock::duration          lease;
+    std::size_t              max_entries;
+    std::atomic<std::uint64_t> invalidations{0};
+    std::atomic<std::size_t> hits{0};
+    std::atomic<std::size_t> misses{0};
+
+    response_cache_state(clock::duration l, std::size_t max)
+    : lease(l)
+    , max_entries(max) {}
+
+    static std::uint64_t bucket_of(std::uint64_t rpc, std::uint16_t provider_id,
+                                   std::uint64_t args_hash) noexcept {
+        std::uint64_t h = fnv1a64(&rpc, sizeof(rpc));
+        h = fnv1a64(&provider_id, sizeof(provider_id), h);
+        return fnv1a64(&args_hash, sizeof(args_hash), h);
+    }
+
+    std::shared_ptr<std::vector<char>> find(const std::string& address, std::uint64_t rpc,
+                                            std::uint16_t provider_id,
+                                            const std::vector<char>& args) {
+        std::uint64_t bucket = bucket_of(rpc, provider_id, fnv1a64(args.data(), args.size()));
+        auto          now    = clock::now();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(bucket);
+        if(it == m_entries.end()) return nullptr;
+        auto& v = it->second;
+        for(auto e = v.begin(); e != v.end(); ++e) {
+            if(e->rpc != rpc || e->provider_id != provider_id || e->address != address
+            || e->args != args)
+                continue;
+            if(e->expiry <= now) {
+                v.erase(e);
+                m_size -= 1;
+                if(v.empty()) m_entries.erase(it);
+                return nullptr;
+            }
+            return e->response;
+        }
+        return nullptr;
+    }
+
+    void insert(entry e) {
+        std::uint64_t bucket =
+            bucket_of(e.rpc, e.provider_id, fnv1a64(e.args.data(), e.args.size()));
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_size >= max_entries) evict();
+        auto& v = m_entries[bucket];
+        for(auto& other : v) {
+            if(other.rpc == e.rpc && other.provider_id == e.provider_id
+            && other.address == e.address && other.args == e.args) {
+                other = std::move(e);
+                return;
+            }
+        }
+        v.push_back(std::move(e));
+        m_size += 1;
+    }
+
+    void invalidate(std::uint64_t rpc, std::uint16_t provider_id, std::uint64_t args_hash) {
+        invalidations += 1;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(bucket_of(rpc, provider_id, args_hash));
+        if(it == m_entries.end()) return;
+        auto& v = it->second;
+        for(auto e = v.begin(); e != v.end();) {
+            if(e->rpc == rpc && e->provider_id == provider_id
+            && fnv1a64(e->args.data(), e->args.size()) == args_hash) {
+                e = v.erase(e);
+                m_size -= 1;
+            } else {
+                ++e;
+            }
+        }
+        if(v.empty()) m_entries.erase(it);
+    }
+
+    void clear() {
+        invalidations += 1;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+        m_size = 0;
+    }
+
+    std::size_t size() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_size;
+    }
+
+  private:
+
+    std::mutex                                             m_mutex;
+    std::unordered_map<std::uint64_t, std::vector<entry>> m_entries;
+    std::size_t                                            m_size = 0;
+
+    // drops the expired entries, or all the entries if none is expired
+    void evict() {
+        auto now = clock::now();
+        for(auto it = m_entries.begin(); it != m_entries.end();) {
+            auto& v = it->second;
+            for(auto e = v.begin(); e != v.end();) {
+                if(e->expiry <= now) {
+                    e = v.erase(e);
+                    m_size -= 1;
+                } else {
+                    ++e;
+                }
+            }
+            if(v.empty()) it = m_entries.erase(it);
+            else ++it;
+        }
+        if(m_size >= max_entries) {
+            m_entries.clear();
+            m_size = 0;
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief An RPC whose responses are cached by a response_cache, created
+ * with response_cache::define. Calling it with the same provider and
+ * arguments as an earlier call whose lease has not expired, and that
+ * has not been invalidated, returns the earlier response without any
+ * network traffic. The RPC must be idempotent and its response must
+ * only depend on its arguments (e.g. a stat-like lookup).
+ */
+class cached_procedure {
+
+    friend class response_cache;
+
+    std::shared_ptr<detail::response_cache_state> m_state;
+    remote_procedure                              m_rpc;
+    std::uint64_t                                 m_key = 0;
+    margo_instance_id                             m_mid = MARGO_INSTANCE_NULL;
+
+    cached_procedure(std::shared_ptr<detail::response_cache_state> state,
+                     remote_procedure rpc, const std::string& name, margo_instance_id mid)
+    : m_state(std::move(state))
+    , m_rpc(std::move(rpc))
+    , m_key(detail::fnv1a64(name.data(), name.size()))
+    , m_mid(mid) {}
+
+    packed_data<> make_cached(std::shared_ptr<std::vector<char>> bytes) const {
+        packed_data<> result;
+        result.m_mid           = margo_instance_ref(m_mid);
+        auto response          = std::make_shared<detail::local_response>();
+        response->values       = std::move(bytes);
+        response->encode       = &detail::copy_cached_response;
+        result.m_local         = std::move(response);
+        return result;
+    }
+
+    // copies the encoded response held by a packed_data
+    static std::shared_ptr<std::vector<char>> encoded_bytes(const packed_data<>& p) {
+        auto bytes = std::make_shared<std::vector<char>>();
+        if(p.m_local) {
+            hg_return_t ret = p.m_local->encode(p.m_local->values.get(), p.m_mid, *bytes);
+            MARGO_ASSERT(ret, encode);
+            return bytes;
+        }
+        bytes->resize(HG_Get_output_payload_size(p.m_handle));
+        meta_proc_fn mproc = [&bytes](hg_proc_t proc) {
+            if(bytes->empty()) return HG_SUCCESS;
+            return hg_proc_memcpy(proc, bytes->data(), bytes->size());
+        };
+        hg_return_t ret = p.m_unpack_fn(p.m_handle, &mproc);
+        MARGO_ASSERT(ret, m_unpack_fn);
+        ret = p.m_free_fn(p.m_handle, &mproc);
+        MARGO_ASSERT(ret, m_free_fn);
+        return bytes;
+    }
+
+  public:
+
+    cached_procedure() = default;
+
+    /**
+     * @brief Calls the RPC on the provided provider, or returns the
+     * cached response to an identical call.
+     *
+     * @param ph Provider to call.
+     * @param args Arguments.
+     *
+     * @return the response.
+     */
+    template <typename... T>
+    packed_data<> operator()(const provider_handle& ph, const T&... args) const {
+        std::vector<char> encoded = detail::encode_cache_args(m_mid, args...);
+        std::string       address = ph;
+        auto cached = m_state->find(address, m_key, ph.provider_id(), encoded);
+        if(cached) {
+            m_state->hits += 1;
+            return make_cached(std::move(cached));
+        }
+        m_state->misses += 1;
+        // the lease starts before the call, and a response is not cached
+        // if an invalidation arrived while it was in flight
+        auto          start         = detail::response_cache_state::clock::now();
+        std::uint64_t invalidations = m_state->invalidations.load();
+        packed_data<> response      = m_rpc.on(ph)(args...);
+        auto          bytes         = encoded_bytes(response);
+        if(m_state->invalidations.load() == invalidations) {
+            m_state->insert(detail::response_cache_state::entry{
+                std::move(address), m_key, ph.provider_id(), std::move(encoded), bytes,
+                start + m_state->lease});
+        }
+        return make_cached(std::move(bytes));
+    }
+
+    /**
+     * @brief Drops the cached response to a call, if any.
+     */
+    template <typename... T>
+    void invalidate(const provider_handle& ph, const T&... args) const {
+        std::vector<char> encoded = detail::encode_cache_args(m_mid, args...);
+        m_state->invalidate(m_key, ph.provider_id(),
+                            detail::fnv1a64(encoded.data(), encoded.size()));
+    }
+
+    /**
+     * @brief Returns the underlying remote_procedure, to call it
+     * without going through the cache.
+     */
+    const remote_procedure& get_remote_procedure() const {
+        return m_rpc;
+    }
+};
+
+/**
+ * @brief A response_cache memoizes, on the client side, the responses
+ * to idempotent RPCs (e.g. metadata lookups), keyed by provider address,
+ * provider id, RPC and encoded arguments. Responses are held for a
+ * lease time, after which the RPC is sent again, and providers using a
+ * lease_tracker can invalidate them earlier by pushing invalidations to
+ * the clients holding them.
+ *
+ * \code{.cpp}
+ * // client
+ * tl::response_cache cache(engine, {500.0, 100000});
+ * tl::cached_procedure stat = cache.define("stat");
+ * auto info = stat(ph, path).as<file_info>();
+ * // server
+ * tl::lease_tracker leases(engine, "stat", provider_id, 500.0);
+ * define("stat", [&](const tl::request& req, const std::string& path) {
+ *     leases.grant(req, path);
+ *     req.respond(lookup(path));
+ * });
+ * ...
+ * update(path);
+ * leases.invalidate(path);
+ * \endcode
+ *
+ * The arguments identify a call by their encoding, so the client and
+ * the provider must use the same argument types. The lease of the
+ * lease_tracker must be at least that of the clients' response_cache.
+ * An engine should have at most one response_cache.
+ */
+class response_cache {
+
+  public:
+
+    /**
+     * @brief Parameters of a response_cache.
+     */
+    struct options {
+        double      lease_ms    = 1000.0; /*!< time a response is held */
+        std::size_t max_entries = 16384;  /*!< responses held at most */
+    };
+
+    /**
+     * @brief Constructor. Defines the RPC through which providers push
+     * invalidations.
+     */
+    response_cache(const engine& e, options opts)
+    : m_engine(e)
+    , m_state(std::make_shared<detail::response_cache_state>(
+          std::chrono::duration_cast<detail::response_cache_state::clock::duration>(
+              std::chrono::duration<double, std::milli>(opts.lease_ms)),
+          opts.max_entries)) {
+        std::weak_ptr<detail::response_cache_state> weak = m_state;
+        m_engine.define(detail::cache_invalidate_rpc_name(),
+            [weak](const request&, const detail::cache_invalidation& inv) {
+                auto state = weak.lock();
+                if(state) state->invalidate(inv.rpc, inv.provider_id, inv.args_hash);
+            }).disable_response();
+    }
+
+    /**
+     * @brief Constructor with the default options.
+     */
+    explicit response_cache(const engine& e)
+    : response_cache(e, options()) {}
+
+    response_cache(const response_cache&)            = delete;
+    response_cache& operator=(const response_cache&) = delete;
+
+    /**
+     * @brief Defines an RPC whose responses go through the cache.
+     *
+     * @param name Name of the RPC.
+     */
+    cached_procedure define(const std::string& name) {
+        return cached_procedure(m_state, m_engine.define(name), name,
+                                m_engine.get_margo_instance());
+    }
+
+    /**
+     * @brief Drops all the cached responses.
+     */
+    void clear() {
+        m_state->clear();
+    }
+
+    /**
+     * @brief Returns the number of cached responses (including expired
+     * ones not dropped yet).
+     */
+    std::size_t size() const {
+        return m_state->size();
+    }
+
+    /**
+     * @brief Returns the number of calls answered from the cache.
+     */
+    std::size_t hits() const {
+        return m_state->hits.load();
+    }
+
+    /**
+     * @brief Returns the number of calls sent to providers.
+     */
+    std::size_t misses() const {
+        return m_state->misses.load();
+    }
+
+  private:
+
+    engine                                        m_engine;
+    std::shared_ptr<detail::response_cache_state> m_state;
+};
+
+/**
+ * @brief A lease_tracker records, on the provider side, which clients
+ * may hold a cached response to an RPC (see response_cache), so that
+ * they can be told when the response changes. Handlers call grant()
+ * before responding, and the code modifying the state the response
+ * depends on calls invalidate() afterwards, which sends a one-way RPC to
+ * each client whose lease has not expired.
+ */
+class lease_tracker {
+
+    using clock = std::chrono::steady_clock;
+
+    struct holder {
+        std::string       address;
+        clock::time_point expiry;
+    };
+
+    engine                                                 m_engine;
+    remote_procedure                                       m_invalidate;
+    std::uint64_t                                          m_key;
+    std::uint16_t                                          m_provider_id;
+    clock::duration                                        m_lease;
+    std::mutex                                             m_mutex;
+    std::unordered_map<std::uint64_t, std::vector<holder>> m_holders;
+    clock::time_point                                      m_last_sweep = clock::now();
+
+    // drops expired leases, at most once per lease period
+    void sweep(clock::time_point now) {
+        if(now - m_last_sweep < m_lease) return;
+        m_last_sweep = now;
+        for(auto it = m_holders.begin(); it != m_holders.end();) {
+            auto& v = it->second;
+            for(auto h = v.begin(); h != v.end();) {
+                if(h->expiry <= now) h = v.erase(h);
+                else ++h;
+            }
+            if(v.empty()) it = m_holders.erase(it);
+            else ++it;
+        }
+    }
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param e Engine of the provider.
+     * @param rpc_name Name of the cached RPC.
+     * @param provider_id Provider id the RPC is defined with.
+     * @param lease_ms Lease, at least that of the clients' caches.
+     */
+    lease_tracker(const engine& e, const std::string& rpc_name, std::uint16_t provider_id,
+                  double lease_ms)
+    : m_engine(e)
+    , m_invalidate(m_engine.define(detail::cache_invalidate_rpc_name()).disable_response())
+    , m_key(detail::fnv1a64(rpc_name.data(), rpc_name.size()))
+    , m_provider_id(provider_id)
+    , m_lease(std::chrono::duration_cast<clock::duration>(
+          std::chrono::duration<double, std::milli>(lease_ms))) {}
+
+    lease_tracker(const lease_tracker&)            = delete;
+    lease_tracker& operator=(const lease_tracker&) = delete;
+
+    /**
+     * @brief Records that the sender of req may cache the response to
+     * the call with the provided arguments.
+     */
+    template <typename... T>
+    void grant(const request& req, const T&... args) {
+        std::vector<char> encoded =
+            detail::encode_cache_args(m_engine.get_margo_instance(), args...);
+        std::uint64_t hash    = detail::fnv1a64(encoded.data(), encoded.size());
+        std::string   address = req.get_endpoint();
+        auto          now     = clock::now();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sweep(now);
+        auto& v = m_holders[hash];
+        for(auto& h : v) {
+            if(h.address == address) {
+                h.expiry = now + m_lease;
+                return;
+            }
+        }
+        v.push_back(holder{std::move(address), now + m_lease});
+    }
+
+    /**
+     * @brief Tells the clients that may hold the response to the call
+     * with the provided arguments to drop it. Clients that cannot be
+     * reached are skipped.
+     */
+    template <typename... T>
+    void invalidate(const T&... args) {
+        std::vector<char> encoded =
+            detail::encode_cache_args(m_engine.get_margo_instance(), args...);
+        detail::cache_invalidation inv;
+        inv.rpc         = m_key;
+        inv.provider_id = m_provider_id;
+        inv.args_hash   = detail::fnv1a64(encoded.data(), encoded.size());
+        std::vector<holder> holders;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_holders.find(inv.args_hash);
+            if(it == m_holders.end()) return;
+            holders = std::move(it->second);
+            m_holders.erase(it);
+        }
+        auto now = clock::now();
+        for(auto& h : holders) {
+            if(h.expiry <= now) continue;
+            try {
+                m_invalidate.on(m_engine.lookup(h.address))(inv);
+            } catch(const exception&) {
+                // the client is gone, its lease will expire anyway
+            }
+        }
+    }
+};
+
+} // namespace thallium
+
+#endif
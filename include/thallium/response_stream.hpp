@@ -0,0 +1,469 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RESPONSE_STREAM_HPP
+#define __THALLIUM_RESPONSE_STREAM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <thallium/async_response.hpp>
+#include <thallium/callable_remote_procedure.hpp>
+#include <thallium/condition_variable.hpp>
+#include <thallium/endpoint.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/mutex.hpp>
+#include <thallium/per_instance.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/request.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+inline const char* stream_pull_rpc_name() {
+    return "__thallium_stream_pull__";
+}
+
+/**
+ * @private
+ * @brief Type-erased server-side state of a stream.
+ */
+struct stream_state_base {
+    virtual ~stream_state_base() = default;
+    // responds to a pull request with up to max elements; returns true
+    // if the stream is over and its state can be removed
+    virtual bool serve(const request& req, std::size_t max) = 0;
+    virtual void cancel() = 0;
+};
+
+/**
+ * @private
+ * @brief Streams opened on a margo instance, and the RPCs through which
+ * clients pull their elements, one per element type so that every
+ * response of a pull RPC has the same type.
+ */
+class stream_registry : public per_instance<stream_registry> {
+
+    margo_instance_id m_mid;
+    std::mutex        m_mutex;
+    std::unordered_map<std::uint64_t, std::shared_ptr<stream_state_base>> m_streams;
+    std::unordered_map<std::string, remote_procedure> m_pull_rpcs;
+
+  public:
+
+    explicit stream_registry(margo_instance_id mid)
+    : m_mid(mid) {}
+
+    /**
+     * @brief Returns the RPC used by clients to pull elements of type T,
+     * defining it on first use. Both sides of a stream go through here,
+     * so that the RPC is registered with its handler even in a process
+     * that streams to itself.
+     */
+    template <typename T>
+    remote_procedure pull_rpc(const std::shared_ptr<stream_registry>& self) {
+        std::string name = std::string(stream_pull_rpc_name()) + "/" + typeid(T).name();
+        // held while defining, so that the RPC is defined only once
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pull_rpcs.find(name);
+        if(it != m_pull_rpcs.end()) return it->second;
+        engine e(m_mid);
+        std::weak_ptr<stream_registry> wreg = self;
+        remote_procedure rpc = e.define(name,
+            [wreg](const request& req, std::uint64_t id, std::uint64_t max) {
+                auto reg = wreg.lock();
+                if(reg) reg->handle_pull<T>(req, id, max);
+                else req.respond(true, std::vector<T>());
+            });
+        return m_pull_rpcs.emplace(name, rpc).first->second;
+    }
+
+    static std::uint64_t next_id() {
+        static std::atomic<std::uint64_t> id{0};
+        return ++id;
+    }
+
+    void add(std::uint64_t id, std::shared_ptr<stream_state_base> s) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_streams[id] = std::move(s);
+    }
+
+    std::shared_ptr<stream_state_base> find(std::uint64_t id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_streams.find(id);
+        if(it == m_streams.end()) return nullptr;
+        return it->second;
+    }
+
+    void remove(std::uint64_t id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_streams.erase(id);
+    }
+
+    void cancel_all() {
+        std::unordered_map<std::uint64_t, std::shared_ptr<stream_state_base>> streams;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            streams.swap(m_streams);
+        }
+        for(auto& s : streams) s.second->cancel();
+    }
+
+    template <typename T>
+    void handle_pull(const request& req, std::uint64_t id, std::uint64_t max) {
+        auto s = find(id);
+        if(!s) { // unknown or cancelled stream
+            req.respond(true, std::vector<T>());
+            return;
+        }
+        if(max == 0) { // the client is no longer interested
+            s->cancel();
+            remove(id);
+            req.respond(true, std::vector<T>());
+            return;
+        }
+        if(s->serve(req, max)) remove(id);
+    }
+
+    /**
+     * @brief Returns the registry of a margo instance, creating it on
+     * first use.
+     */
+    static std::shared_ptr<stream_registry> get(margo_instance_id mid) {
+        bool created = false;
+        auto reg     = find_or_install(
+            mid, [mid]() { return std::make_shared<stream_registry>(mid); }, created);
+        if(created) {
+            engine(mid).push_prefinalize_callback(reg.get(), [mid]() {
+                auto r = uninstall(mid);
+                if(r) r->cancel_all();
+            });
+        }
+        return reg;
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief A stream_writer lets an RPC handler send a sequence of
+ * elements of type T to the caller, who reads them from the
+ * response_stream<T> returned by callable_remote_procedure::stream<T>().
+ *
+ * Creating the stream_writer responds to the RPC; the handler then
+ * calls write() for each element and close() (or lets the writer be
+ * destroyed) when done. Elements are buffered in a queue of bounded
+ * capacity and pulled by the client in batches, so write() blocks the
+ * handler when the client doesn't keep up.
+ *
+ * @tparam T Type of the elements.
+ */
+template <typename T>
+class stream_writer {
+
+    struct state : public detail::stream_state_base {
+        mutex              m_mutex;
+        condition_variable m_cv;
+        std::deque<T>      m_queue;
+        std::size_t        m_capacity;
+        bool               m_closed    = false;
+        bool               m_cancelled = false;
+
+        explicit state(std::size_t capacity)
+        : m_capacity(capacity ? capacity : 1) {}
+
+        bool serve(const request& req, std::size_t max) override {
+            std::vector<T> items;
+            bool           end;
+            {
+                std::unique_lock<mutex> lock(m_mutex);
+                while(m_queue.empty() && !m_closed && !m_cancelled)
+                    m_cv.wait(lock);
+                std::size_t n = std::min(max, m_queue.size());
+                items.reserve(n);
+                for(std::size_t i = 0; i < n; i++) {
+                    items.push_back(std::move(m_queue.front()));
+                    m_queue.pop_front();
+                }
+                end = m_cancelled || (m_closed && m_queue.empty());
+            }
+            m_cv.notify_all();
+            req.respond(end, items);
+            return end;
+        }
+
+        void cancel() override {
+            {
+                std::lock_guard<mutex> lock(m_mutex);
+                m_cancelled = true;
+                m_queue.clear();
+            }
+            m_cv.notify_all();
+        }
+    };
+
+    std::shared_ptr<detail::stream_registry> m_registry;
+    std::shared_ptr<state>                   m_state;
+    std::uint64_t                            m_id = 0;
+
+  public:
+
+    /**
+     * @brief Opens a stream in response to an RPC sent with
+     * callable_remote_procedure::stream<T>(). This responds to the RPC.
+     *
+     * @param req Request of the RPC.
+     * @param capacity Maximum number of elements buffered before
+     * write() blocks.
+     */
+    explicit stream_writer(const request& req, std::size_t capacity = 64)
+    : m_registry(detail::stream_registry::get(
+                    margo_hg_handle_get_instance(req.native_handle())))
+    , m_state(std::make_shared<state>(capacity))
+    , m_id(detail::stream_registry::next_id()) {
+        m_registry->pull_rpc<T>(m_registry);
+        m_registry->add(m_id, m_state);
+        try {
+            req.respond(m_id);
+        } catch(...) {
+            m_registry->remove(m_id);
+            throw;
+        }
+    }
+
+    stream_writer(const stream_writer&)            = delete;
+    stream_writer& operator=(const stream_writer&) = delete;
+    stream_writer(stream_writer&&)                 = default;
+    stream_writer& operator=(stream_writer&&)      = default;
+
+    /**
+     * @brief Destructor. Closes the stream.
+     */
+    ~stream_writer() {
+        close();
+    }
+
+    /**
+     * @brief Adds an element to the stream, blocking while the queue is
+     * full. Returns false if the client has stopped reading the stream,
+     * in which case the element is dropped and the handler should stop
+     * producing elements.
+     */
+    template <typename U>
+    bool write(U&& value) {
+        if(!m_state) throw exception("Writing to a closed stream");
+        std::unique_lock<mutex> lock(m_state->m_mutex);
+        while(m_state->m_queue.size() >= m_state->m_capacity && !m_state->m_cancelled)
+            m_state->m_cv.wait(lock);
+        if(m_state->m_cancelled) return false;
+        m_state->m_queue.emplace_back(std::forward<U>(value));
+        lock.unlock();
+        m_state->m_cv.notify_all();
+        return true;
+    }
+
+    /**
+     * @brief Marks the end of the stream. Elements already written are
+     * still delivered to the client.
+     */
+    void close() {
+        if(!m_state) return;
+        {
+            std::lock_guard<mutex> lock(m_state->m_mutex);
+            m_state->m_closed = true;
+        }
+        m_state->m_cv.notify_all();
+        m_state.reset();
+    }
+
+    /**
+     * @brief Returns true if the client has stopped reading the stream.
+     */
+    bool cancelled() const {
+        if(!m_state) return false;
+        std::lock_guard<mutex> lock(m_state->m_mutex);
+        return m_state->m_cancelled;
+    }
+};
+
+/**
+ * @brief A response_stream is returned by callable_remote_procedure::stream<T>()
+ * and yields the elements the RPC handler writes to its stream_writer<T>,
+ * as they arrive. Elements are pulled in batches, the next batch being
+ * requested while the current one is being consumed. Destroying the
+ * response_stream before the end tells the server to stop the stream.
+ *
+ * @tparam T Type of the elements.
+ */
+template <typename T>
+class response_stream {
+
+    template<typename ... CtxArg> friend class callable_remote_procedure_with_context;
+
+    remote_procedure                m_pull;
+    endpoint                        m_target;
+    std::uint64_t                   m_id;
+    std::size_t                     m_batch_size = 64;
+    std::vector<T>                  m_batch;
+    std::size_t                     m_pos        = 0;
+    bool                            m_ended      = false; // server said so
+    std::unique_ptr<async_response> m_pending;
+
+    response_stream(remote_procedure pull, endpoint target, std::uint64_t id)
+    : m_pull(std::move(pull))
+    , m_target(std::move(target))
+    , m_id(id) {}
+
+    void request_batch() {
+        m_pending = std::make_unique<async_response>(
+            m_pull.on(m_target).async(m_id, static_cast<std::uint64_t>(m_batch_size)));
+    }
+
+  public:
+
+    response_stream(const response_stream&)            = delete;
+    response_stream& operator=(const response_stream&) = delete;
+    response_stream& operator=(response_stream&&)      = delete;
+
+    response_stream(response_stream&& other)
+    : m_pull(std::move(other.m_pull))
+    , m_target(std::move(other.m_target))
+    , m_id(std::exchange(other.m_id, 0))
+    , m_batch_size(other.m_batch_size)
+    , m_batch(std::move(other.m_batch))
+    , m_pos(other.m_pos)
+    , m_ended(other.m_ended)
+    , m_pending(std::move(other.m_pending)) {}
+
+    /**
+     * @brief Destructor. Cancels the stream on the server if it has not
+     * been read until the end.
+     */
+    ~response_stream() {
+        if(m_id == 0 || (m_ended && !m_pending)) return;
+        try {
+            if(m_pending) m_pending->wait();
+            m_pending.reset();
+            if(!m_ended)
+                m_pull.on(m_target)(m_id, static_cast<std::uint64_t>(0));
+        } catch(...) {
+            // the server is gone, nothing to cancel
+        }
+    }
+
+    /**
+     * @brief Sets the maximum number of elements requested at once.
+     */
+    void set_batch_size(std::size_t n) {
+        m_batch_size = n ? n : 1;
+    }
+
+    /**
+     * @brief Gets the next element of the stream, blocking until it
+     * arrives. Returns false if the stream has ended.
+     */
+    bool next(T& value) {
+        while(m_pos == m_batch.size()) {
+            if(m_ended) return false;
+            if(!m_pending) request_batch();
+            auto response = m_pending->wait();
+            m_pending.reset();
+            bool end = false;
+            m_batch.clear();
+            m_pos = 0;
+            response.unpack(end, m_batch);
+            m_ended = end;
+            // prefetch the next batch while this one is consumed
+            if(!m_ended) request_batch();
+        }
+        value = std::move(m_batch[m_pos++]);
+        return true;
+    }
+
+    /**
+     * @brief Input iterator over the elements of a response_stream.
+     */
+    class iterator {
+
+        friend class response_stream;
+
+        response_stream* m_stream = nullptr;
+        T                m_value;
+
+        explicit iterator(response_stream* s)
+        : m_stream(s) {
+            ++(*this);
+        }
+
+      public:
+
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = T*;
+        using reference         = T&;
+
+        iterator() = default;
+
+        T& operator*() { return m_value; }
+        T* operator->() { return &m_value; }
+
+        iterator& operator++() {
+            if(m_stream && !m_stream->next(m_value)) m_stream = nullptr;
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const {
+            return m_stream == other.m_stream;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return m_stream != other.m_stream;
+        }
+    };
+
+    /**
+     * @brief Returns an iterator on the next element of the stream.
+     */
+    iterator begin() {
+        return iterator(this);
+    }
+
+    /**
+     * @brief Returns the end iterator.
+     */
+    iterator end() {
+        return iterator();
+    }
+};
+
+template<typename ... CtxArg>
+template <typename T, typename... A>
+inline response_stream<T>
+callable_remote_procedure_with_context<CtxArg...>::stream(const A&... args) {
+    auto registry = detail::stream_registry::get(m_mid);
+    std::uint64_t id = (*this)(args...);
+    ensure_handle();
+    const struct hg_info* info = margo_get_info(m_handle);
+    hg_addr_t addr = HG_ADDR_NULL;
+    hg_return_t ret = margo_addr_dup(m_mid, info->addr, &addr);
+    MARGO_ASSERT(ret, margo_addr_dup);
+    return response_stream<T>(registry->pull_rpc<T>(registry), endpoint(m_mid, addr), id);
+}
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RESUME_HPP
+#define __THALLIUM_RESUME_HPP
+
+#include <abt.h>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Moves the calling ULT to the target pool, if it is not null
+ * and the ULT is not already there, by migrating it and yielding. Does
+ * nothing if the caller is not a migratable ULT (e.g. the primary ULT
+ * or an external thread).
+ */
+inline void resume_in(ABT_pool target) {
+    if(target == ABT_POOL_NULL) return;
+    ABT_thread self = ABT_THREAD_NULL;
+    if(ABT_self_get_thread(&self) != ABT_SUCCESS || self == ABT_THREAD_NULL) return;
+    ABT_pool current = ABT_POOL_NULL;
+    if(ABT_thread_get_last_pool(self, &current) == ABT_SUCCESS && current == target) return;
+    ABT_bool migratable = ABT_FALSE;
+    if(ABT_thread_is_migratable(self, &migratable) != ABT_SUCCESS || !migratable) return;
+    if(ABT_thread_migrate_to_pool(self, target) == ABT_SUCCESS)
+        ABT_thread_yield();
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RPC_AGGREGATOR_HPP
+#define __THALLIUM_RPC_AGGREGATOR_HPP
+
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <thallium/engine.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/mutex.hpp>
+#include <thallium/provider_handle.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/timed_callback.hpp>
+#include <thallium/serialization/stl/tuple.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace thallium {
+
+/**
+ * @brief An rpc_aggregator packs many calls to a fire-and-forget RPC
+ * targeting the same provider into a single Mercury RPC. Calls are
+ * buffered and sent together when max_batch_size calls are pending,
+ * when max_delay has elapsed since the first pending call, or when
+ * flush() is called explicitly.
+ *
+ * The server must have defined the RPC with engine::define_aggregated,
+ * which unpacks each aggregated RPC and calls the handler once per call,
+ * in the order in which the calls were made.
+ *
+ * Since calls are buffered, errors in sending them are only reported
+ * by an explicit flush(); errors during a time-triggered flush are
+ * logged.
+ *
+ * @tparam Args Types of the arguments of the RPC.
+ */
+template <typename... Args>
+class rpc_aggregator {
+
+    using batch_type = std::vector<std::tuple<typename std::decay<Args>::type...>>;
+
+    struct state {
+        margo_instance_id               m_mid;
+        remote_procedure                m_rpc;
+        provider_handle                 m_target;
+        std::size_t                     m_max_batch_size;
+        double                          m_max_delay_ms;
+        mutex                           m_mutex;
+        batch_type                      m_batch;
+        bool                            m_timer_armed = false;
+        std::unique_ptr<timed_callback> m_timer;
+
+        state(engine& e, const std::string& name, provider_handle target,
+              std::size_t max_batch_size, std::chrono::microseconds max_delay)
+        : m_mid(e.get_margo_instance())
+        , m_rpc(e.define(detail::aggregated_rpc_name(name)))
+        , m_target(std::move(target))
+        , m_max_batch_size(max_batch_size ? max_batch_size : 1)
+        , m_max_delay_ms(max_delay.count() / 1000.0) {
+            m_rpc.disable_response();
+            m_batch.reserve(m_max_batch_size);
+        }
+
+        // the timer holds a weak reference so that a callback already
+        // in flight when the aggregator is destroyed does nothing
+        static void start_timer(const engine& e, const std::shared_ptr<state>& s) {
+            if(s->m_max_delay_ms <= 0.0) return;
+            std::weak_ptr<state> ws = s;
+            s->m_timer = std::make_unique<timed_callback>(
+                e.create_timed_callback([ws]() {
+                    auto s = ws.lock();
+                    if(s) s->on_timer();
+                }));
+        }
+
+        void on_timer() {
+            std::unique_lock<mutex> lock(m_mutex);
+            m_timer_armed = false;
+            send_and_log(lock);
+        }
+
+        // must be called with m_mutex held; the lock is kept while
+        // sending so that batches reach the server in order
+        void send(std::unique_lock<mutex>&) {
+            if(m_batch.empty()) return;
+            batch_type batch;
+            batch.reserve(m_max_batch_size);
+            batch.swap(m_batch);
+            m_rpc.on(m_target)(batch);
+        }
+
+        void send_and_log(std::unique_lock<mutex>& lock) {
+            try {
+                send(lock);
+            } catch(const std::exception& ex) {
+                margo_error(m_mid,
+                    "[thallium] rpc_aggregator failed to send batch: %s", ex.what());
+            }
+        }
+    };
+
+    std::shared_ptr<state> m_state;
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param e Engine.
+     * @param name Name of the RPC, as defined on the server with
+     * engine::define_aggregated.
+     * @param target Provider the calls are sent to.
+     * @param max_batch_size Maximum number of calls packed in one RPC.
+     * @param max_delay Maximum time a call stays buffered. A zero
+     * delay disables time-triggered flushes.
+     */
+    rpc_aggregator(engine& e, const std::string& name,
+                   provider_handle target, std::size_t max_batch_size,
+                   std::chrono::microseconds max_delay)
+    : m_state(std::make_shared<state>(e, name, std::move(target),
+                                      max_batch_size, max_delay)) {
+        state::start_timer(e, m_state);
+    }
+
+    rpc_aggregator(const rpc_aggregator&)            = delete;
+    rpc_aggregator& operator=(const rpc_aggregator&) = delete;
+    rpc_aggregator(rpc_aggregator&&)                 = default;
+    rpc_aggregator& operator=(rpc_aggregator&&)      = default;
+
+    /**
+     * @brief Destructor. Sends any pending call.
+     */
+    ~rpc_aggregator() {
+        if(!m_state) return;
+        // cancelling waits for a callback in flight, which takes m_mutex,
+        // so it must be done before locking it
+        if(m_state->m_timer) {
+            try {
+                m_state->m_timer->cancel();
+            } catch(const exception&) {
+                // the timer was not armed or has already fired
+            }
+        }
+        std::unique_lock<mutex> lock(m_state->m_mutex);
+        m_state->m_timer_armed = false;
+        m_state->send_and_log(lock);
+    }
+
+    /**
+     * @brief Buffers a call to the RPC with the provided arguments.
+     * The call is sent immediately if it completes a batch.
+     */
+    template <typename... T>
+    void operator()(T&&... args) {
+        std::unique_lock<mutex> lock(m_state->m_mutex);
+        m_state->m_batch.emplace_back(std::forward<T>(args)...);
+        if(m_state->m_batch.size() >= m_state->m_max_batch_size) {
+            m_state->send(lock);
+        } else if(m_state->m_timer && !m_state->m_timer_armed) {
+            // a timer armed for a previous batch will fire before
+            // max_delay expires for this one, so we don't re-arm it
+            m_state->m_timer->start(m_state->m_max_delay_ms);
+            m_state->m_timer_armed = true;
+        }
+    }
+
+    /**
+     * @brief Sends all the pending calls now.
+     */
+    void flush() {
+        std::unique_lock<mutex> lock(m_state->m_mutex);
+        m_state->send(lock);
+    }
+
+    /**
+     * @brief Returns the number of buffered calls.
+     */
+    std::size_t pending() const {
+        std::unique_lock<mutex> lock(m_state->m_mutex);
+        return m_state->m_batch.size();
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RPC_CAPTURE_HPP
+#define __THALLIUM_RPC_CAPTURE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <margo.h>
+#include <mercury_proc.h>
+#include <thallium/exception.hpp>
+#include <thallium/inplace_function.hpp>
+#include <thallium/per_instance.hpp>
+#include <thallium/serialization/varint.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Parameters of engine::capture_rpcs.
+ */
+struct rpc_capture_options {
+    /**
+     * @brief RPCs whose encoded arguments are larger than this are
+     * recorded without them (they cannot be replayed).
+     */
+    std::size_t max_args_size = 1024 * 1024;
+    /**
+     * @brief Records are buffered in memory and written to the file
+     * once they reach this size.
+     */
+    std::size_t buffer_size   = 4 * 1024 * 1024;
+};
+
+/**
+ * @brief An RPC received while capturing (see engine::capture_rpcs),
+ * as read back by an rpc_capture_reader.
+ */
+struct rpc_capture_record {
+    std::string       name;                /*!< name of the RPC */
+    std::uint16_t     provider_id = 0;     /*!< provider it was sent to */
+    std::uint64_t     time_ns     = 0;     /*!< arrival since the capture started */
+    std::size_t       args_size   = 0;     /*!< size of the encoded arguments */
+    bool              control     = false; /*!< whether it carried control information */
+    bool              one_way     = false; /*!< whether its response is disabled */
+    std::vector<char> args;                /*!< encoded arguments, if captured */
+
+    /**
+     * @brief Whether the arguments were captured, so that the RPC can
+     * be replayed.
+     */
+    bool complete() const {
+        return args.size() == args_size;
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Format of capture files: a magic string, then a sequence of
+ * records made of a tag byte followed by varints. A name record maps
+ * an index to the name and provider id of an RPC id the first time it
+ * is seen; a call record gives the index of the RPC, the time elapsed
+ * since the previous call, the size of the encoded arguments, flags,
+ * and the arguments themselves unless they were too large.
+ */
+struct rpc_capture_format {
+    static const char* magic() { return "TLCAP001"; }
+    static constexpr std::size_t   magic_size   = 8;
+    static constexpr unsigned char name_tag     = 1;
+    static constexpr unsigned char call_tag     = 2;
+    static constexpr unsigned char flag_control = 1;
+    static constexpr unsigned char flag_omitted = 2;
+    static constexpr unsigned char flag_one_way = 4;
+};
+
+/**
+ * @private
+ * @brief Records the RPCs received by a margo instance into a capture
+ * file. Records are appended to a buffer under a mutex and the buffer
+ * is written with a single fwrite once it is full, so the handlers
+ * only pay for copying their arguments.
+ */
+class rpc_capture : public per_instance<rpc_capture> {
+
+    std::mutex                                m_mutex;
+    std::FILE*                                m_file = nullptr;
+    rpc_capture_options                       m_options;
+    std::vector<unsigned char>                m_buffer;
+    std::unordered_map<hg_id_t, std::uint64_t> m_names;
+    std::chrono::steady_clock::time_point     m_start;
+    std::chrono::steady_clock::time_point     m_last;
+
+    static void on_finalize(void* arg) {
+        auto old = per_instance::uninstall(static_cast<margo_instance_id>(arg));
+        if(old) old->close();
+    }
+
+    void put_varint(std::uint64_t v) {
+        unsigned char buf[varint_max_size];
+        std::size_t   n = varint_encode(v, buf);
+        m_buffer.insert(m_buffer.end(), buf, buf + n);
+    }
+
+    void flush() {
+        if(m_buffer.empty() || !m_file) return;
+        std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+        m_buffer.clear();
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        flush();
+        if(m_file) std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+  public:
+
+    rpc_capture(const std::string& path, const rpc_capture_options& options)
+    : m_options(options)
+    , m_start(std::chrono::steady_clock::now())
+    , m_last(m_start) {
+        m_file = std::fopen(path.c_str(), "wb");
+        if(!m_file) throw exception("Could not open RPC capture file ", path);
+        std::fwrite(rpc_capture_format::magic(), 1, rpc_capture_format::magic_size, m_file);
+        m_buffer.reserve(m_options.buffer_size + 4096);
+    }
+
+    ~rpc_capture() { close(); }
+
+    rpc_capture(const rpc_capture&)            = delete;
+    rpc_capture& operator=(const rpc_capture&) = delete;
+
+    /**
+     * @brief Returns whether any margo instance is capturing its RPCs.
+     */
+    static bool active() {
+        return !empty();
+    }
+
+    /**
+     * @brief Starts capturing the RPCs of a margo instance into a new
+     * file, ending its current capture, if any.
+     */
+    static void install(margo_instance_id mid, const std::string& path,
+                        const rpc_capture_options& options) {
+        auto old = per_instance::install(mid, std::make_shared<rpc_capture>(path, options));
+        if(old)
+            old->close();
+        else
+            margo_provider_push_prefinalize_callback(
+                mid, callback_owner(), &rpc_capture::on_finalize, mid);
+    }
+
+    /**
+     * @brief Ends the capture of a margo instance, writing what remains
+     * of its buffer.
+     */
+    static void uninstall(margo_instance_id mid) {
+        auto old = per_instance::uninstall(mid);
+        if(!old) return;
+        margo_provider_pop_prefinalize_callback(mid, callback_owner());
+        old->close();
+    }
+
+    /**
+     * @brief Records an RPC received with handle h, whose input payload
+     * ends with control_size bytes of control information.
+     */
+    void record(hg_handle_t h, hg_id_t id, const std::string& name,
+                std::uint16_t provider_id, std::size_t control_size) {
+        std::size_t payload   = HG_Get_input_payload_size(h);
+        std::size_t args_size = payload >= control_size ? payload - control_size : 0;
+        bool        omitted   = args_size > m_options.max_args_size;
+        hg_bool_t   one_way   = HG_FALSE;
+        margo_registered_disabled_response(margo_hg_handle_get_instance(h), id, &one_way);
+        // the arguments are referenced in the handle's input buffer
+        const char*  args  = nullptr;
+        meta_proc_fn iproc = [&args, payload](hg_proc_t proc) {
+            if(payload == 0 || hg_proc_get_op(proc) != HG_DECODE) return HG_SUCCESS;
+            if(hg_proc_get_size_left(proc) < payload) return HG_OVERFLOW;
+            void* buf = hg_proc_save_ptr(proc, payload);
+            args      = static_cast<const char*>(buf);
+            return hg_proc_restore_ptr(proc, buf, payload);
+        };
+        bool decoded = false;
+        if(!omitted && args_size) {
+            if(margo_get_input(h, &iproc) != HG_SUCCESS) return;
+            decoded = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_file) {
+                auto it = m_names.find(id);
+                if(it == m_names.end()) {
+                    it = m_names.emplace(id, m_names.size()).first;
+                    m_buffer.push_back(rpc_capture_format::name_tag);
+                    put_varint(it->second);
+                    put_varint(provider_id);
+                    put_varint(name.size());
+                    m_buffer.insert(m_buffer.end(), name.begin(), name.end());
+                }
+                auto now = std::chrono::steady_clock::now();
+                auto gap = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last);
+                m_last   = now;
+                unsigned char flags = (control_size ? rpc_capture_format::flag_control : 0)
+                                    | (omitted ? rpc_capture_format::flag_omitted : 0)
+                                    | (one_way ? rpc_capture_format::flag_one_way : 0);
+                m_buffer.push_back(rpc_capture_format::call_tag);
+                put_varint(it->second);
+                put_varint(static_cast<std::uint64_t>(gap.count()));
+                put_varint(args_size);
+                m_buffer.push_back(flags);
+                if(!omitted && args_size)
+                    m_buffer.insert(m_buffer.end(), args, args + args_size);
+                if(m_buffer.size() >= m_options.buffer_size) flush();
+            }
+        }
+        if(decoded) margo_free_input(h, &iproc);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Reads the RPCs recorded in a capture file (see
+ * engine::capture_rpcs), in the order they were received.
+ *
+ * \code{.cpp}
+ * tl::rpc_capture_reader reader("server.tlcap");
+ * tl::rpc_capture_record r;
+ * while(reader.next(r)) std::cout << r.name << " " << r.args_size << std::endl;
+ * \endcode
+ */
+class rpc_capture_reader {
+
+    struct rpc_info {
+        std::string   name;
+        std::uint16_t provider_id;
+    };
+
+    std::FILE*            m_file = nullptr;
+    std::vector<rpc_info> m_rpcs;
+    std::uint64_t         m_time_ns = 0;
+
+    bool get_varint(std::uint64_t& v) {
+        unsigned char buf[detail::varint_max_size];
+        for(std::size_t n = 0; n < detail::varint_max_size; n++) {
+            int c = std::fgetc(m_file);
+            if(c == EOF) return false;
+            buf[n] = static_cast<unsigned char>(c);
+            if(!(buf[n] & 0x80)) return detail::varint_decode(buf, buf + n + 1, v) != 0;
+        }
+        return false;
+    }
+
+    [[noreturn]] static void corrupted() {
+        throw exception("Corrupted RPC capture file");
+    }
+
+  public:
+
+    /**
+     * @brief Opens a capture file.
+     */
+    explicit rpc_capture_reader(const std::string& path) {
+        m_file = std::fopen(path.c_str(), "rb");
+        if(!m_file) throw exception("Could not open RPC capture file ", path);
+        char magic[detail::rpc_capture_format::magic_size];
+        if(std::fread(magic, 1, sizeof(magic), m_file) != sizeof(magic)
+        || std::memcmp(magic, detail::rpc_capture_format::magic(), sizeof(magic)) != 0) {
+            std::fclose(m_file);
+            throw exception(path, " is not an RPC capture file");
+        }
+    }
+
+    ~rpc_capture_reader() {
+        if(m_file) std::fclose(m_file);
+    }
+
+    rpc_capture_reader(const rpc_capture_reader&)            = delete;
+    rpc_capture_reader& operator=(const rpc_capture_reader&) = delete;
+
+    /**
+     * @brief Reads the next RPC into r.
+     *
+     * @return false at the end of the file.
+     */
+    bool next(rpc_capture_record& r) {
+        while(true) {
+            int tag = std::fgetc(m_file);
+            if(tag == EOF) return false;
+            std::uint64_t index, a, b;
+            if(!get_varint(index) || !get_varint(a) || !get_varint(b)) corrupted();
+            if(tag == detail::rpc_capture_format::name_tag) {
+                if(index != m_rpcs.size() || a > 0xffff) corrupted();
+                std::string name(b, '\0');
+                if(b && std::fread(&name[0], 1, b, m_file) != b) corrupted();
+                m_rpcs.push_back(rpc_info{std::move(name), static_cast<std::uint16_t>(a)});
+                continue;
+            }
+            if(tag != detail::rpc_capture_format::call_tag || index >= m_rpcs.size()) corrupted();
+            int flags = std::fgetc(m_file);
+            if(flags == EOF) corrupted();
+            m_time_ns    += a;
+            r.name        = m_rpcs[index].name;
+            r.provider_id = m_rpcs[index].provider_id;
+            r.time_ns     = m_time_ns;
+            r.args_size   = b;
+            r.control     = flags & detail::rpc_capture_format::flag_control;
+            r.one_way     = flags & detail::rpc_capture_format::flag_one_way;
+            r.args.clear();
+            if(!(flags & detail::rpc_capture_format::flag_omitted) && b) {
+                r.args.resize(b);
+                if(std::fread(r.args.data(), 1, b, m_file) != b) corrupted();
+            }
+            return true;
+        }
+    }
+};
+
+} // namespace thallium
+
+#endif
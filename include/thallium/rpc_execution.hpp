@@ -0,0 +1,279 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RPC_EXECUTION_HPP
+#define __THALLIUM_RPC_EXECUTION_HPP
+
+#include <abt.h>
+#include <cstddef>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <margo.h>
+#include <thallium/non_blocking.hpp>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+/**
+ * @brief An rpc_execution tells how the work unit running the handler
+ * of an RPC is created, see remote_procedure::set_execution.
+ *
+ * By default handlers run in ULTs with the stack size Argobots is
+ * configured with. A handler that uses little stack can be given a
+ * smaller one, and one that recurses deeply a larger one; such stacks
+ * are allocated by thallium and recycled once the ULTs using them have
+ * terminated, so that creating the ULT does not allocate memory. A
+ * handler that never blocks (no respond, no blocking RPC or RDMA, no
+ * mutex) can also run as a tasklet, which has no stack of its own;
+ * request::respond_detached can be used to respond from it. Such a
+ * handler, if it is also short (e.g. a ping or a counter increment),
+ * can even run inline, called directly by the progress loop when the
+ * request is received, which saves the creation of a work unit, its
+ * push into a pool and the context switches to and from it, but delays
+ * the progress of every other RPC until it returns. Unless NDEBUG is
+ * defined, calling a blocking function of thallium (respond, a blocking
+ * RPC, RDMA transfer or wait, locking a mutex, ...) from a handler
+ * running inline aborts the program.
+ *
+ * \code{.cpp}
+ * engine.define("small", small_handler).set_execution(tl::rpc_execution::with_stack_size(4096));
+ * engine.define("ping", ping_handler).set_execution(tl::rpc_execution::task());
+ * engine.define("incr", [&](const tl::request& req) {
+ *     counter++;
+ *     req.respond_detached();
+ * }).set_execution(tl::rpc_execution::run_inline());
+ * \endcode
+ */
+struct rpc_execution {
+    std::size_t stack_size        = 0;     /*!< 0 for the default stack size */
+    bool        as_task           = false; /*!< run the handler as a tasklet */
+    std::size_t max_cached_stacks = 256;   /*!< idle stacks kept for reuse */
+    bool        inline_handler    = false; /*!< run the handler in the progress loop */
+
+    /**
+     * @brief Returns an rpc_execution running handlers in ULTs with
+     * the provided stack size.
+     */
+    static rpc_execution with_stack_size(std::size_t size) {
+        rpc_execution e;
+        e.stack_size = size;
+        return e;
+    }
+
+    /**
+     * @brief Returns an rpc_execution running handlers as tasklets.
+     */
+    static rpc_execution task() {
+        rpc_execution e;
+        e.as_task = true;
+        return e;
+    }
+
+    /**
+     * @brief Returns an rpc_execution running handlers inline in the
+     * progress loop.
+     */
+    static rpc_execution run_inline() {
+        rpc_execution e;
+        e.inline_handler = true;
+        return e;
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Stacks of a given size for the ULTs of an RPC. A stack handed
+ * to a ULT is retired along with the ULT's handle, and becomes free
+ * again once the ULT has terminated, which is checked for all the
+ * retired stacks when a stack is needed.
+ */
+class rpc_stack_cache {
+
+    struct retired_stack {
+        ABT_thread thread;
+        void*      stack;
+    };
+
+    std::mutex                 m_mutex;
+    std::size_t                m_stack_size;
+    std::size_t                m_max_cached;
+    std::vector<void*>         m_free;
+    std::vector<retired_stack> m_retired;
+
+    // must be called with the mutex held; handlers complete in any
+    // order, so a long-running one does not hold back the stacks of
+    // those retired after it
+    void reclaim() {
+        auto kept = m_retired.begin();
+        for(auto it = m_retired.begin(); it != m_retired.end(); ++it) {
+            ABT_thread_state state = ABT_THREAD_STATE_READY;
+            if(ABT_thread_get_state(it->thread, &state) == ABT_SUCCESS
+            && state == ABT_THREAD_STATE_TERMINATED) {
+                ABT_thread_free(&it->thread);
+                release_locked(it->stack);
+            } else {
+                *kept++ = *it;
+            }
+        }
+        m_retired.erase(kept, m_retired.end());
+    }
+
+    void release_locked(void* stack) {
+        if(m_free.size() < m_max_cached) m_free.push_back(stack);
+        else std::free(stack);
+    }
+
+  public:
+
+    rpc_stack_cache(std::size_t stack_size, std::size_t max_cached)
+    : m_stack_size(stack_size), m_max_cached(max_cached) {}
+
+    rpc_stack_cache(const rpc_stack_cache&)            = delete;
+    rpc_stack_cache& operator=(const rpc_stack_cache&) = delete;
+
+    // the margo instance is finalized, hence all the ULTs have completed
+    ~rpc_stack_cache() {
+        for(auto& r : m_retired) {
+            ABT_thread_free(&r.thread);
+            std::free(r.stack);
+        }
+        for(auto s : m_free) std::free(s);
+    }
+
+    std::size_t stack_size() const { return m_stack_size; }
+
+    void* acquire() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            reclaim();
+            if(!m_free.empty()) {
+                void* s = m_free.back();
+                m_free.pop_back();
+                return s;
+            }
+        }
+        return std::malloc(m_stack_size);
+    }
+
+    void retire(ABT_thread thread, void* stack) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_retired.push_back({thread, stack});
+    }
+
+    void release(void* stack) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        release_locked(stack);
+    }
+};
+
+/**
+ * @private
+ * @brief rpc_execution settings of the RPCs of each margo instance,
+ * used by thallium_dispatch_rpc to create the work unit of the handler
+ * itself instead of letting margo create a default ULT. Requests reach
+ * the entry of their RPC through its rpc_policy.
+ */
+class rpc_execution_registry : public per_instance<rpc_execution_registry> {
+
+  public:
+
+    struct entry {
+        rpc_execution                    execution;
+        std::unique_ptr<rpc_stack_cache> stacks;
+    };
+
+  private:
+
+    std::mutex                                  m_mutex;
+    // replaced entries may still be used by running ULTs, so they are
+    // kept until the margo instance is finalized
+    std::list<std::unique_ptr<entry>>           m_all_entries;
+
+    static hg_return_t create_unit(hg_handle_t handle, const entry& e,
+                                   void (*wrapper)(void*), void* arg, ABT_pool pool) {
+        if(pool == ABT_POOL_NULL) pool = margo_hg_handle_get_handler_pool(handle);
+        int ret = ABT_SUCCESS;
+        if(e.execution.inline_handler) {
+            running_inline_scope scope;
+            wrapper(arg);
+            return HG_SUCCESS;
+        }
+        if(e.execution.as_task) {
+            return ABT_task_create(pool, wrapper, arg, nullptr) == ABT_SUCCESS
+                 ? HG_SUCCESS : HG_NOMEM;
+        }
+        ABT_thread_attr attr = ABT_THREAD_ATTR_NULL;
+        ret = ABT_thread_attr_create(&attr);
+        if(ret != ABT_SUCCESS) return HG_NOMEM;
+        if(e.stacks) {
+            void* stack = e.stacks->acquire();
+            if(!stack) {
+                ABT_thread_attr_free(&attr);
+                return HG_NOMEM;
+            }
+            ABT_thread_attr_set_stack(attr, stack, e.stacks->stack_size());
+            ABT_thread thread = ABT_THREAD_NULL;
+            ret = ABT_thread_create(pool, wrapper, arg, attr, &thread);
+            if(ret == ABT_SUCCESS) e.stacks->retire(thread, stack);
+            else e.stacks->release(stack);
+        } else {
+            ABT_thread_attr_set_stacksize(attr, e.execution.stack_size);
+            ret = ABT_thread_create(pool, wrapper, arg, attr, nullptr);
+        }
+        ABT_thread_attr_free(&attr);
+        return ret == ABT_SUCCESS ? HG_SUCCESS : HG_NOMEM;
+    }
+
+  public:
+
+    /**
+     * @brief Creates the entry of an rpc_execution set for an RPC of a
+     * margo instance. Returns nullptr for the default, margo creating
+     * the ULT.
+     */
+    static const entry* add(margo_instance_id mid, const rpc_execution& execution) {
+        if(!execution.as_task && !execution.inline_handler && execution.stack_size == 0)
+            return nullptr;
+        // finalize rather than prefinalize: handlers may still be
+        // running, on stacks owned by the registry
+        auto reg = get(mid, instance_release::at_finalize);
+        std::unique_ptr<entry> e(new entry{execution, nullptr});
+        if(!execution.as_task && execution.stack_size != 0 && execution.max_cached_stacks != 0)
+            e->stacks.reset(new rpc_stack_cache(execution.stack_size, execution.max_cached_stacks));
+        const entry* raw = e.get();
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        reg->m_all_entries.push_back(std::move(e));
+        return raw;
+    }
+
+    /**
+     * @brief Creates the work unit running wrapper(arg) as configured
+     * by an entry, arg being the request's handle or a structure
+     * holding it, with the same bookkeeping as margo. The unit is
+     * pushed into pool, or into the RPC's handler pool if pool is
+     * ABT_POOL_NULL; handlers running inline are called before this
+     * function returns.
+     */
+    static hg_return_t dispatch(margo_instance_id mid, hg_handle_t handle, const entry& e,
+                                void (*wrapper)(void*), void* arg,
+                                ABT_pool pool = ABT_POOL_NULL) {
+        if(__margo_internal_finalize_requested(mid)) return HG_CANCELED;
+        __margo_internal_incr_pending(mid);
+        hg_return_t result = create_unit(handle, e, wrapper, arg, pool);
+        if(result != HG_SUCCESS) __margo_internal_decr_pending(mid);
+        return result;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RPC_POLICY_HPP
+#define __THALLIUM_RPC_POLICY_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <margo.h>
+#include <thallium/admission.hpp>
+#include <thallium/per_instance.hpp>
+#include <thallium/rpc_execution.hpp>
+#include <thallium/rpc_sharding.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Settings of an RPC that are read for each request it receives:
+ * its priority (remote_procedure::set_priority, -1 if none), whether
+ * its input ends with control information (enable_cancellation,
+ * enable_deadline_propagation, enable_tracing), its admission limit,
+ * shard pools and execution. The callback data of the RPC points to
+ * them (see engine::rpc_callback_data), so that requests read them
+ * without a lookup. The objects they point to are owned by their
+ * registries until the margo instance is finalized.
+ */
+struct rpc_policy {
+    std::atomic<int>                                  priority{-1};
+    std::atomic<bool>                                 control{false};
+    std::atomic<admission_state*>                     admission{nullptr};
+    std::atomic<const rpc_shard_registry::entry*>     shard{nullptr};
+    std::atomic<const rpc_execution_registry::entry*> execution{nullptr};
+};
+
+/**
+ * @private
+ * @brief rpc_policy of each RPC of a margo instance, by RPC id. Policies
+ * are created when an RPC is defined or configured and kept until the
+ * instance is finalized, so pointers to them remain valid.
+ */
+class rpc_policy_table : public per_instance<rpc_policy_table> {
+
+    std::mutex                                               m_mutex;
+    std::unordered_map<hg_id_t, std::unique_ptr<rpc_policy>> m_policies;
+
+  public:
+
+    /**
+     * @brief Returns the policy of an RPC of a margo instance, creating
+     * it if needed.
+     */
+    static rpc_policy& of(margo_instance_id mid, hg_id_t id) {
+        auto table = get(mid, instance_release::at_finalize);
+        std::lock_guard<std::mutex> lock(table->m_mutex);
+        auto& p = table->m_policies[id];
+        if(!p) p.reset(new rpc_policy);
+        return *p;
+    }
+
+    /**
+     * @brief Returns the policy of an RPC of a margo instance, or
+     * nullptr if it has none.
+     */
+    static const rpc_policy* find(margo_instance_id mid, hg_id_t id) {
+        auto table = per_instance::find(mid);
+        if(!table) return nullptr;
+        std::lock_guard<std::mutex> lock(table->m_mutex);
+        auto it = table->m_policies.find(id);
+        return it == table->m_policies.end() ? nullptr : it->second.get();
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RPC_PRIORITY_HPP
+#define __THALLIUM_RPC_PRIORITY_HPP
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Priority given to the work units created by the calling OS
+ * thread, read by priority_pool when such a unit is created
+ * (-1 means the pool's default priority).
+ */
+inline int& current_unit_priority() {
+    static thread_local int priority = -1;
+    return priority;
+}
+
+} // namespace detail
+
+/**
+ * @brief While a priority_scope exists, the work units (ULTs and tasks)
+ * created by the calling ULT in a priority_pool are given the provided
+ * priority instead of the pool's default one. The calling ULT must not
+ * yield while the scope exists.
+ *
+ * \code{.cpp}
+ * {
+ *     tl::priority_scope scope(0);
+ *     pool.make_thread(urgent_work, tl::anonymous());
+ * }
+ * \endcode
+ */
+class priority_scope {
+
+    int m_previous;
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param priority Priority (0 is the highest).
+     */
+    explicit priority_scope(int priority)
+    : m_previous(detail::current_unit_priority()) {
+        detail::current_unit_priority() = priority;
+    }
+
+    priority_scope(const priority_scope&)            = delete;
+    priority_scope& operator=(const priority_scope&) = delete;
+
+    ~priority_scope() {
+        detail::current_unit_priority() = m_previous;
+    }
+};
+
+} // namespace thallium
+
+#endif
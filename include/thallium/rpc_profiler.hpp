@@ -0,0 +1,266 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RPC_PROFILER_HPP
+#define __THALLIUM_RPC_PROFILER_HPP
+
+#include <abt.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <margo.h>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Number of samples in which an RPC's handler was running.
+ */
+struct rpc_profile_entry {
+    hg_id_t       id      = 0;
+    std::uint64_t samples = 0;
+};
+
+/**
+ * @brief Flat profile returned by engine::get_rpc_profile(). Each
+ * sample looks at every execution stream that has run an RPC handler;
+ * samples of streams running none are counted as idle (they may be
+ * running other work, such as the progress loop).
+ */
+struct rpc_profile {
+    double                         interval_ms = 0.0; /*!< time between samples */
+    std::uint64_t                  samples     = 0;   /*!< stream samples taken */
+    std::uint64_t                  idle        = 0;   /*!< samples outside handlers */
+    std::vector<rpc_profile_entry> rpcs;              /*!< by decreasing samples */
+
+    /**
+     * @brief Fraction of the samples in which an RPC was running.
+     */
+    double fraction(const rpc_profile_entry& e) const {
+        return samples ? static_cast<double>(e.samples) / samples : 0.0;
+    }
+
+    /**
+     * @brief Formats the profile as a JSON object.
+     */
+    std::string to_json() const {
+        std::string out = "{\"interval_ms\":" + std::to_string(interval_ms);
+        out += ",\"samples\":" + std::to_string(samples);
+        out += ",\"idle\":" + std::to_string(idle);
+        out += ",\"rpcs\":[";
+        for(std::size_t i = 0; i < rpcs.size(); i++) {
+            if(i) out += ",";
+            out += "{\"id\":" + std::to_string(rpcs[i].id);
+            out += ",\"samples\":" + std::to_string(rpcs[i].samples) + "}";
+        }
+        out += "]}";
+        return out;
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief "Current RPC" marker of an OS thread (i.e. an execution
+ * stream), set by thallium_generic_rpc around the handlers it runs.
+ * The ULT that set it is remembered so that a handler that blocked and
+ * resumed on another stream only clears the marker it set if it is
+ * still its own.
+ */
+struct rpc_profile_slot {
+    std::atomic<margo_instance_id> mid{nullptr};
+    std::atomic<hg_id_t>           id{0};
+    std::atomic<ABT_thread>        ult{ABT_THREAD_NULL};
+};
+
+/**
+ * @private
+ * @brief Samples, from its own OS thread (so that samples are taken
+ * even when every execution stream is busy), the markers of the
+ * execution streams running handlers of a margo instance.
+ */
+class rpc_profiler : public per_instance<rpc_profiler> {
+
+    margo_instance_id                        m_mid;
+    double                                   m_interval_ms;
+    std::mutex                               m_mutex;
+    std::condition_variable                  m_cv;
+    bool                                     m_stop = false;
+    std::uint64_t                            m_samples = 0;
+    std::uint64_t                            m_idle    = 0;
+    std::unordered_map<hg_id_t, std::uint64_t> m_counts;
+    std::thread                              m_thread;
+
+    static std::mutex& slots_mutex() {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    // slots of all the OS threads that ran a handler while a profiler
+    // was active; they outlive their thread
+    static std::vector<std::shared_ptr<rpc_profile_slot>>& slots() {
+        static std::vector<std::shared_ptr<rpc_profile_slot>> s;
+        return s;
+    }
+
+    static void on_finalize(void* arg) {
+        auto p = uninstall(static_cast<margo_instance_id>(arg));
+        if(p) p->stop();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if(m_thread.joinable()) m_thread.join();
+    }
+
+    void run() {
+        std::vector<std::shared_ptr<rpc_profile_slot>> local;
+        auto interval = std::chrono::duration<double, std::milli>(m_interval_ms);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while(!m_cv.wait_for(lock, interval, [this]() { return m_stop; })) {
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> slock(slots_mutex());
+                local = slots();
+            }
+            lock.lock();
+            for(auto& s : local) {
+                if(s->mid.load(std::memory_order_relaxed) != m_mid) continue;
+                hg_id_t id = s->id.load(std::memory_order_relaxed);
+                m_samples += 1;
+                if(id == 0) m_idle += 1;
+                else m_counts[id] += 1;
+            }
+        }
+    }
+
+  public:
+
+    rpc_profiler(margo_instance_id mid, double interval_ms)
+    : m_mid(mid)
+    , m_interval_ms(interval_ms) {}
+
+    ~rpc_profiler() { stop(); }
+
+    /**
+     * @brief Returns whether any margo instance is being profiled.
+     */
+    static bool active() {
+        return !empty();
+    }
+
+    /**
+     * @brief Starts profiling a margo instance, taking a sample every
+     * interval_ms, or stops if interval_ms is 0.
+     */
+    static void install(margo_instance_id mid, double interval_ms) {
+        std::shared_ptr<rpc_profiler> old;
+        bool                          start = interval_ms > 0.0;
+        if(start) {
+            auto p = std::make_shared<rpc_profiler>(mid, interval_ms);
+            p->m_thread = std::thread([raw = p.get()]() { raw->run(); });
+            old = per_instance::install(mid, std::move(p));
+        } else {
+            old = uninstall(mid);
+        }
+        // the profiler is replaced when the interval changes, so it
+        // cannot identify the callback
+        if(old) margo_provider_pop_prefinalize_callback(mid, callback_owner());
+        if(start)
+            margo_provider_push_prefinalize_callback(
+                mid, callback_owner(), &rpc_profiler::on_finalize, mid);
+        if(old) old->stop();
+    }
+
+    /**
+     * @brief Returns the marker of the calling OS thread.
+     */
+    static rpc_profile_slot& local_slot() {
+        static thread_local std::shared_ptr<rpc_profile_slot> slot;
+        if(!slot) {
+            slot = std::make_shared<rpc_profile_slot>();
+            std::lock_guard<std::mutex> lock(slots_mutex());
+            slots().push_back(slot);
+        }
+        return *slot;
+    }
+
+    rpc_profile snapshot() {
+        rpc_profile p;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        p.interval_ms = m_interval_ms;
+        p.samples     = m_samples;
+        p.idle        = m_idle;
+        p.rpcs.reserve(m_counts.size());
+        for(auto& c : m_counts) p.rpcs.push_back(rpc_profile_entry{c.first, c.second});
+        std::sort(p.rpcs.begin(), p.rpcs.end(),
+                  [](const rpc_profile_entry& a, const rpc_profile_entry& b) {
+                      return a.samples > b.samples;
+                  });
+        return p;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_samples = 0;
+        m_idle    = 0;
+        m_counts.clear();
+    }
+};
+
+/**
+ * @private
+ * @brief Sets the current RPC marker of the calling execution stream
+ * for the lifetime of a handler. This costs a relaxed load when no
+ * margo instance is being profiled.
+ */
+class rpc_profile_scope {
+
+    rpc_profile_slot* m_slot = nullptr;
+    ABT_thread        m_self = ABT_THREAD_NULL;
+
+  public:
+
+    rpc_profile_scope(margo_instance_id mid, hg_id_t id) {
+        if(!rpc_profiler::active()) return;
+        if(ABT_self_get_thread(&m_self) != ABT_SUCCESS) return;
+        m_slot = &rpc_profiler::local_slot();
+        m_slot->ult.store(m_self, std::memory_order_relaxed);
+        m_slot->mid.store(mid, std::memory_order_relaxed);
+        m_slot->id.store(id, std::memory_order_relaxed);
+    }
+
+    rpc_profile_scope(const rpc_profile_scope&)            = delete;
+    rpc_profile_scope& operator=(const rpc_profile_scope&) = delete;
+
+    ~rpc_profile_scope() {
+        if(!m_slot) return;
+        // another handler may have replaced the marker while this one
+        // was blocked
+        ABT_thread self = m_self;
+        if(m_slot->ult.compare_exchange_strong(self, ABT_THREAD_NULL,
+                                               std::memory_order_relaxed))
+            m_slot->id.store(0, std::memory_order_relaxed);
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
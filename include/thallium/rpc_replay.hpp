@@ -0,0 +1,242 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RPC_REPLAY_HPP
+#define __THALLIUM_RPC_REPLAY_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <margo.h>
+#include <mercury_proc.h>
+#include <thallium/cancellation.hpp>
+#include <thallium/endpoint.hpp>
+#include <thallium/engine.hpp>
+#include <thallium/margo_exception.hpp>
+#include <thallium/remote_procedure.hpp>
+#include <thallium/rpc_capture.hpp>
+#include <thallium/thread.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Parameters of replay_rpc_capture.
+ */
+struct rpc_replay_options {
+    /**
+     * @brief Replay rate relative to the captured one (2.0 sends twice
+     * as fast); 0 sends each RPC as soon as there is room in the window.
+     */
+    double      speed  = 1.0;
+    /**
+     * @brief Maximum number of RPCs in flight.
+     */
+    std::size_t window = 256;
+};
+
+/**
+ * @brief Outcome of replay_rpc_capture. Latencies are measured from
+ * the time each RPC was due to be sent according to the capture, so
+ * that RPCs delayed because the server could not keep up (and the
+ * window was full) count that delay.
+ */
+struct rpc_replay_report {
+    std::size_t sent       = 0; /*!< RPCs sent */
+    std::size_t failed     = 0; /*!< RPCs that could not be sent or failed */
+    std::size_t skipped    = 0; /*!< RPCs captured without their arguments */
+    double      elapsed_s  = 0; /*!< duration of the replay */
+    double      mean_us    = 0; /*!< mean latency */
+    double      p50_us     = 0; /*!< median latency */
+    double      p99_us     = 0; /*!< 99th percentile of the latency */
+    double      max_us     = 0; /*!< largest latency */
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief RPCs of a replay in flight, waited on in completion order.
+ */
+class rpc_replay_window {
+
+    struct pending {
+        hg_handle_t                           handle;
+        std::chrono::steady_clock::time_point due;
+    };
+
+    std::vector<margo_request> m_requests;
+    std::vector<pending>       m_pending;
+    rpc_replay_report&         m_report;
+    std::vector<double>&       m_latencies;
+
+    void complete(std::size_t i, hg_return_t ret) {
+        if(ret == HG_SUCCESS) {
+            m_latencies.push_back(std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - m_pending[i].due).count());
+        } else {
+            m_report.failed += 1;
+        }
+        margo_destroy(m_pending[i].handle);
+        m_requests.erase(m_requests.begin() + i);
+        m_pending.erase(m_pending.begin() + i);
+    }
+
+  public:
+
+    rpc_replay_window(rpc_replay_report& report, std::vector<double>& latencies)
+    : m_report(report)
+    , m_latencies(latencies) {}
+
+    ~rpc_replay_window() {
+        while(!empty()) wait_one();
+    }
+
+    std::size_t size() const { return m_pending.size(); }
+    bool        empty() const { return m_pending.empty(); }
+
+    void add(hg_handle_t h, margo_request req, std::chrono::steady_clock::time_point due) {
+        m_requests.push_back(req);
+        m_pending.push_back(pending{h, due});
+    }
+
+    void wait_one() {
+        std::size_t i   = 0;
+        hg_return_t ret = margo_wait_any(m_requests.size(), m_requests.data(), &i);
+        if(i >= m_pending.size()) {
+            MARGO_ASSERT(ret, margo_wait_any);
+            throw exception("margo_wait_any returned an invalid index");
+        }
+        complete(i, ret);
+    }
+
+    // collects the completed RPCs without blocking
+    std::size_t poll() {
+        std::size_t count = 0;
+        for(std::size_t i = 0; i < m_requests.size();) {
+            int flag = 0;
+            margo_test(m_requests[i], &flag);
+            if(!flag) {
+                i++;
+                continue;
+            }
+            complete(i, margo_wait(m_requests[i]));
+            count += 1;
+        }
+        return count;
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Sends the RPCs recorded in a capture file (see
+ * engine::capture_rpcs) to a server, with their original arguments,
+ * provider ids and inter-arrival times (scaled by options.speed), and
+ * waits for their responses (unless the RPC was captured with its
+ * response disabled). The server must define the same RPCs as
+ * the one the capture was taken on; responses are not decoded. This
+ * allows comparing versions of a server (or of thallium) on a captured
+ * production workload rather than on a synthetic one.
+ *
+ * \code{.cpp}
+ * // on the production server
+ * engine.capture_rpcs("/tmp/server.tlcap");
+ * ...
+ * engine.stop_rpc_capture();
+ * // on a test client
+ * auto report = tl::replay_rpc_capture(engine, "/tmp/server.tlcap",
+ *                                      engine.lookup(test_server));
+ * std::cout << report.p99_us << std::endl;
+ * \endcode
+ *
+ * RPCs captured with control information (cancellation, deadline or
+ * tracing) are replayed with empty control information. RPCs captured
+ * without their arguments are skipped.
+ *
+ * @param e Engine to send the RPCs with.
+ * @param path Capture file.
+ * @param target Server to send them to.
+ * @param options Replay parameters.
+ *
+ * @return a report of the replay.
+ */
+inline rpc_replay_report replay_rpc_capture(engine& e, const std::string& path,
+                                            const endpoint& target,
+                                            const rpc_replay_options& options
+                                                = rpc_replay_options()) {
+    using clock = std::chrono::steady_clock;
+    rpc_capture_reader                       reader(path);
+    rpc_replay_report                        report;
+    std::vector<double>                      latencies;
+    std::unordered_map<std::string, hg_id_t> ids;
+    margo_instance_id                        mid    = e.get_margo_instance();
+    std::size_t                              window = std::max<std::size_t>(options.window, 1);
+    auto                                     start  = clock::now();
+    {
+        detail::rpc_replay_window in_flight(report, latencies);
+        rpc_capture_record        r;
+        while(reader.next(r)) {
+            if(!r.complete()) {
+                report.skipped += 1;
+                continue;
+            }
+            auto due = start;
+            if(options.speed > 0.0)
+                due += std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double, std::nano>(r.time_ns / options.speed));
+            while(clock::now() < due || in_flight.size() >= window) {
+                if(in_flight.size() >= window) in_flight.wait_one();
+                else if(in_flight.poll() == 0) thread::yield();
+            }
+            if(options.speed <= 0.0) due = clock::now();
+            auto it = ids.find(r.name);
+            if(it == ids.end()) {
+                remote_procedure rpc = e.define(r.name);
+                if(r.one_way) rpc.disable_response();
+                it = ids.emplace(r.name, rpc.id()).first;
+            }
+            hg_handle_t h   = HG_HANDLE_NULL;
+            hg_return_t ret = margo_create(mid, target.get_addr(), it->second, &h);
+            if(ret != HG_SUCCESS) {
+                report.failed += 1;
+                continue;
+            }
+            detail::rpc_control control;
+            meta_proc_fn        mproc = [&r, &control](hg_proc_t proc) {
+                hg_return_t ret = HG_SUCCESS;
+                if(!r.args.empty()) ret = hg_proc_memcpy(proc, r.args.data(), r.args.size());
+                if(ret != HG_SUCCESS || !r.control) return ret;
+                return detail::proc_rpc_control(proc, control);
+            };
+            margo_request req = MARGO_REQUEST_NULL;
+            ret = margo_provider_iforward(r.provider_id, h, &mproc, &req);
+            if(ret != HG_SUCCESS) {
+                margo_destroy(h);
+                report.failed += 1;
+                continue;
+            }
+            report.sent += 1;
+            in_flight.add(h, req, due);
+        }
+    }
+    report.elapsed_s = std::chrono::duration<double>(clock::now() - start).count();
+    if(!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        double total = 0.0;
+        for(auto l : latencies) total += l;
+        report.mean_us = total / latencies.size();
+        report.p50_us  = latencies[(latencies.size() - 1) / 2];
+        report.p99_us  = latencies[static_cast<std::size_t>(0.99 * (latencies.size() - 1))];
+        report.max_us  = latencies.back();
+    }
+    return report;
+}
+
+} // namespace thallium
+
+#endif
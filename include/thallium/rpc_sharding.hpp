@@ -0,0 +1,92 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RPC_SHARDING_HPP
+#define __THALLIUM_RPC_SHARDING_HPP
+
+#include <abt.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <margo.h>
+#include <thallium/per_instance.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Pools and shard selectors set with remote_procedure::set_sharding,
+ * for each margo instance. The selector is called by thallium_dispatch_rpc
+ * (from the progress loop) with the handle of a received RPC, and returns
+ * the index of the pool its handler is pushed into. Requests reach the
+ * entry of their RPC through its rpc_policy; replaced entries may still
+ * be in use, so all of them are kept until the instance is finalized.
+ */
+class rpc_shard_registry : public per_instance<rpc_shard_registry> {
+
+  public:
+
+    struct entry {
+        std::vector<ABT_pool>                  pools;
+        std::function<std::size_t(hg_handle_t)> selector;
+    };
+
+  private:
+
+    std::mutex                               m_mutex;
+    std::vector<std::unique_ptr<const entry>> m_entries;
+
+  public:
+
+    /**
+     * @brief Creates the entry holding the pools and shard selector of
+     * an RPC of a margo instance. Returns nullptr if pools is empty.
+     */
+    static const entry* add(margo_instance_id mid, std::vector<ABT_pool> pools,
+                            std::function<std::size_t(hg_handle_t)> selector) {
+        if(pools.empty()) return nullptr;
+        auto reg = get(mid, instance_release::at_finalize);
+        std::unique_ptr<const entry> e(new entry{std::move(pools), std::move(selector)});
+        const entry* raw = e.get();
+        std::lock_guard<std::mutex> lock(reg->m_mutex);
+        reg->m_entries.push_back(std::move(e));
+        return raw;
+    }
+
+    /**
+     * @brief Returns the pool the handler of a request for the RPC of
+     * an entry should be pushed into.
+     */
+    static ABT_pool select(const entry& e, hg_handle_t h) {
+        return e.pools[e.selector(h) % e.pools.size()];
+    }
+
+    /**
+     * @brief Creates the ULT running wrapper(arg) in the provided pool,
+     * with the same bookkeeping as margo. arg is the request's handle,
+     * or a structure holding it.
+     */
+    static hg_return_t create_ult(margo_instance_id mid, ABT_pool pool,
+                                  void (*wrapper)(void*), void* arg) {
+        if(__margo_internal_finalize_requested(mid)) return HG_CANCELED;
+        __margo_internal_incr_pending(mid);
+        int ret = ABT_thread_create(pool, wrapper, arg, ABT_THREAD_ATTR_NULL, nullptr);
+        if(ret != ABT_SUCCESS) {
+            __margo_internal_decr_pending(mid);
+            return HG_NOMEM;
+        }
+        return HG_SUCCESS;
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,602 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_RPC_STATS_HPP
+#define __THALLIUM_RPC_STATS_HPP
+
+#include <abt.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <thallium/admission.hpp>
+#include <thallium/lock_stats.hpp>
+#include <thallium/per_instance.hpp>
+#include <thallium/tsc_clock.hpp>
+#include <thallium/xstream_local.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Snapshot of a latency histogram. Values are in nanoseconds.
+ * Buckets are log-linear: each power of two is split into 8 buckets,
+ * so any recorded value is known within 12.5%.
+ */
+struct histogram_snapshot {
+
+    static constexpr unsigned    sub_bits    = 3;
+    static constexpr std::size_t sub_buckets = std::size_t(1) << sub_bits;
+    static constexpr std::size_t num_buckets = (64 - sub_bits + 1) * sub_buckets;
+
+    std::uint64_t              count = 0;
+    std::uint64_t              sum   = 0;
+    std::uint64_t              min   = 0;
+    std::uint64_t              max   = 0;
+    std::vector<std::uint64_t> buckets; /*!< empty if count is 0 */
+
+    /**
+     * @brief Returns the index of the bucket a value falls in.
+     */
+    static std::size_t bucket_index(std::uint64_t v) {
+        if(v < sub_buckets) return static_cast<std::size_t>(v);
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(v));
+        unsigned shift = msb - sub_bits;
+        return (msb - sub_bits + 1) * sub_buckets
+             + static_cast<std::size_t>((v >> shift) & (sub_buckets - 1));
+    }
+
+    /**
+     * @brief Returns the smallest value falling in bucket i.
+     */
+    static std::uint64_t bucket_lower_bound(std::size_t i) {
+        if(i < sub_buckets) return i;
+        unsigned shift = static_cast<unsigned>(i / sub_buckets) - 1;
+        return (sub_buckets + i % sub_buckets) << shift;
+    }
+
+    /**
+     * @brief Returns the largest value falling in bucket i.
+     */
+    static std::uint64_t bucket_upper_bound(std::size_t i) {
+        if(i < sub_buckets) return i;
+        unsigned shift = static_cast<unsigned>(i / sub_buckets) - 1;
+        return bucket_lower_bound(i) + ((std::uint64_t(1) << shift) - 1);
+    }
+
+    /**
+     * @brief Average of the recorded values.
+     */
+    double mean() const {
+        return count ? static_cast<double>(sum) / count : 0.0;
+    }
+
+    /**
+     * @brief Returns an estimate of the p-th percentile (0 < p <= 100).
+     */
+    std::uint64_t percentile(double p) const {
+        if(count == 0) return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(p / 100.0 * count + 0.5);
+        if(rank == 0) rank = 1;
+        std::uint64_t seen = 0;
+        for(std::size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if(seen >= rank) {
+                std::uint64_t lo  = bucket_lower_bound(i);
+                std::uint64_t mid = lo + (bucket_upper_bound(i) - lo) / 2;
+                return std::max(min, std::min(max, mid));
+            }
+        }
+        return max;
+    }
+};
+
+/**
+ * @brief Latencies of one RPC, as seen by one side. On the server side
+ * queue is the time between the arrival of the RPC and the start
+ * of its ULT, decode the time spent deserializing the arguments,
+ * handler the time spent in the user's function (including respond),
+ * and respond the time spent in request::respond. On the client side
+ * round_trip covers forward and iforward (up to the end of wait()).
+ */
+struct rpc_stats_entry {
+    std::string        name;
+    hg_id_t            id          = 0;
+    std::uint16_t      provider_id = 0;
+    bool               server      = false;
+    histogram_snapshot queue;
+    histogram_snapshot decode;
+    histogram_snapshot handler;
+    histogram_snapshot respond;
+    histogram_snapshot round_trip;
+};
+
+/**
+ * @brief Work unit statistics of one pool (see enable_pool_stats).
+ * wait is the time between a unit becoming ready (created, yielding or
+ * resumed) and a scheduler running it, run the time it runs before
+ * yielding, blocking or finishing. Counts cover elapsed_ns nanoseconds,
+ * e.g. created * 1e9 / elapsed_ns units are created per second.
+ */
+struct pool_stats_entry {
+    int                pool_id    = -1;
+    std::string        name;           /*!< margo's name of the pool, if known */
+    std::uint64_t      elapsed_ns = 0; /*!< time since the statistics were enabled or reset */
+    std::uint64_t      created    = 0; /*!< work units created */
+    std::uint64_t      runs       = 0; /*!< times a unit started or resumed running */
+    std::uint64_t      yields     = 0; /*!< times a unit yielded */
+    std::uint64_t      suspends   = 0; /*!< times a unit blocked */
+    std::uint64_t      finished   = 0; /*!< work units completed */
+    histogram_snapshot wait;
+    histogram_snapshot run;
+};
+
+/**
+ * @brief Snapshot of the RPC statistics of an engine, returned by
+ * engine::get_rpc_stats().
+ */
+struct rpc_stats {
+
+    std::vector<rpc_stats_entry> rpcs;
+
+    /**
+     * @brief Gauges of the RPCs with an admission limit (available
+     * even without THALLIUM_ENABLE_RPC_STATS).
+     */
+    std::vector<rpc_admission_entry> admission;
+
+    /**
+     * @brief Contention of the locks of the process (see
+     * get_lock_stats; available if thallium is compiled with
+     * THALLIUM_ENABLE_LOCK_STATS).
+     */
+    std::vector<lock_stats_entry> locks;
+
+    /**
+     * @brief Work unit statistics of the pools (see enable_pool_stats).
+     */
+    std::vector<pool_stats_entry> pools;
+
+    /**
+     * @brief Formats the statistics as a JSON object.
+     */
+    std::string to_json() const {
+        std::string out = "{\"rpcs\":[";
+        for(std::size_t i = 0; i < rpcs.size(); i++) {
+            auto& e = rpcs[i];
+            if(i) out += ",";
+            out += "{\"name\":\"" + escape(e.name) + "\"";
+            out += ",\"id\":" + std::to_string(e.id);
+            out += ",\"provider_id\":" + std::to_string(e.provider_id);
+            out += std::string(",\"side\":\"") + (e.server ? "server" : "client") + "\"";
+            if(e.server) {
+                append(out, "queue", e.queue);
+                append(out, "decode", e.decode);
+                append(out, "handler", e.handler);
+                append(out, "respond", e.respond);
+            } else {
+                append(out, "round_trip", e.round_trip);
+            }
+            out += "}";
+        }
+        out += "]";
+        if(!admission.empty()) {
+            out += ",\"admission\":[";
+            for(std::size_t i = 0; i < admission.size(); i++) {
+                auto& a = admission[i];
+                if(i) out += ",";
+                out += "{\"id\":" + std::to_string(a.id);
+                out += ",\"in_flight\":" + std::to_string(a.in_flight);
+                out += ",\"max_in_flight\":" + std::to_string(a.max_in_flight);
+                out += ",\"admitted\":" + std::to_string(a.admitted);
+                out += ",\"rejected\":" + std::to_string(a.rejected);
+                out += ",\"bytes_in_flight\":" + std::to_string(a.bytes_in_flight);
+                out += ",\"max_bytes\":" + std::to_string(a.max_bytes);
+                out += ",\"deferred\":" + std::to_string(a.deferred);
+                out += "}";
+            }
+            out += "]";
+        }
+        if(!locks.empty()) {
+            out += ",\"locks\":[";
+            for(std::size_t i = 0; i < locks.size(); i++) {
+                auto& l = locks[i];
+                if(i) out += ",";
+                out += "{\"site\":\"" + escape(l.site) + "\"";
+                out += ",\"kind\":\"" + l.kind + "\"";
+                out += ",\"acquisitions\":" + std::to_string(l.acquisitions);
+                out += ",\"contended\":" + std::to_string(l.contended);
+                out += ",\"wait_ns\":" + std::to_string(l.wait_ns);
+                out += ",\"max_wait_ns\":" + std::to_string(l.max_wait_ns);
+                out += "}";
+            }
+            out += "]";
+        }
+        if(!pools.empty()) {
+            out += ",\"pools\":[";
+            for(std::size_t i = 0; i < pools.size(); i++) {
+                auto& p = pools[i];
+                if(i) out += ",";
+                out += "{\"id\":" + std::to_string(p.pool_id);
+                out += ",\"name\":\"" + escape(p.name) + "\"";
+                out += ",\"elapsed_ns\":" + std::to_string(p.elapsed_ns);
+                out += ",\"created\":" + std::to_string(p.created);
+                out += ",\"runs\":" + std::to_string(p.runs);
+                out += ",\"yields\":" + std::to_string(p.yields);
+                out += ",\"suspends\":" + std::to_string(p.suspends);
+                out += ",\"finished\":" + std::to_string(p.finished);
+                append(out, "wait", p.wait);
+                append(out, "run", p.run);
+                out += "}";
+            }
+            out += "]";
+        }
+        out += "}";
+        return out;
+    }
+
+  private:
+
+    static std::string escape(const std::string& s) {
+        std::string r;
+        for(char c : s) {
+            if(c == '"' || c == '\\') {
+                r += '\\';
+                r += c;
+            } else if(static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                r += buf;
+            } else {
+                r += c;
+            }
+        }
+        return r;
+    }
+
+    static void append(std::string& out, const char* key, const histogram_snapshot& h) {
+        out += std::string(",\"") + key + "\":{";
+        out += "\"count\":" + std::to_string(h.count);
+        out += ",\"sum_ns\":" + std::to_string(h.sum);
+        out += ",\"min_ns\":" + std::to_string(h.min);
+        out += ",\"max_ns\":" + std::to_string(h.max);
+        out += ",\"p50_ns\":" + std::to_string(h.percentile(50));
+        out += ",\"p90_ns\":" + std::to_string(h.percentile(90));
+        out += ",\"p99_ns\":" + std::to_string(h.percentile(99));
+        out += ",\"p999_ns\":" + std::to_string(h.percentile(99.9));
+        out += "}";
+    }
+};
+
+namespace detail {
+
+enum class rpc_metric { queue = 0, decode, handler, respond, round_trip };
+
+constexpr std::size_t rpc_metric_count = 5;
+
+inline std::uint64_t rpc_stats_now() {
+    return tsc_clock::now_ns();
+}
+
+/**
+ * @private
+ * @brief Histogram updated with relaxed atomic operations. Each
+ * execution stream records into its own histograms, so the atomics
+ * are uncontended in practice.
+ */
+class latency_histogram {
+
+    std::atomic<std::uint64_t> m_count{0};
+    std::atomic<std::uint64_t> m_sum{0};
+    std::atomic<std::uint64_t> m_min{UINT64_MAX};
+    std::atomic<std::uint64_t> m_max{0};
+    std::array<std::atomic<std::uint64_t>, histogram_snapshot::num_buckets> m_buckets;
+
+  public:
+
+    latency_histogram() {
+        for(auto& b : m_buckets) b.store(0, std::memory_order_relaxed);
+    }
+
+    void record(std::uint64_t v) {
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(v, std::memory_order_relaxed);
+        m_buckets[histogram_snapshot::bucket_index(v)].fetch_add(1, std::memory_order_relaxed);
+        auto cur = m_min.load(std::memory_order_relaxed);
+        while(v < cur && !m_min.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+        cur = m_max.load(std::memory_order_relaxed);
+        while(v > cur && !m_max.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+    }
+
+    void merge_into(histogram_snapshot& s) const {
+        auto count = m_count.load(std::memory_order_relaxed);
+        if(count == 0) return;
+        if(s.buckets.empty()) s.buckets.resize(histogram_snapshot::num_buckets, 0);
+        auto mn = m_min.load(std::memory_order_relaxed);
+        auto mx = m_max.load(std::memory_order_relaxed);
+        s.min   = s.count ? std::min(s.min, mn) : mn;
+        s.max   = std::max(s.max, mx);
+        s.count += count;
+        s.sum   += m_sum.load(std::memory_order_relaxed);
+        for(std::size_t i = 0; i < m_buckets.size(); i++)
+            s.buckets[i] += m_buckets[i].load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        m_count = 0;
+        m_sum   = 0;
+        m_min   = UINT64_MAX;
+        m_max   = 0;
+        for(auto& b : m_buckets) b.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @private
+ * @brief Histograms of one RPC, one set per execution stream (by rank),
+ * allocated the first time an execution stream records something.
+ * Callers outside of an execution stream, or whose rank is at least
+ * max_xstreams, share an extra set.
+ */
+class rpc_metrics {
+
+    static constexpr std::size_t max_xstreams = 64;
+
+    struct slot {
+        std::array<latency_histogram, rpc_metric_count> histograms;
+    };
+
+    struct slot_ptr {
+        std::atomic<slot*> ptr{nullptr};
+    };
+
+    xstream_local<slot_ptr> m_slots;
+    slot_ptr                m_shared;
+
+    static slot& get_or_create(std::atomic<slot*>& p) {
+        slot* s = p.load(std::memory_order_acquire);
+        if(s) return *s;
+        auto fresh = new slot;
+        if(p.compare_exchange_strong(s, fresh, std::memory_order_acq_rel))
+            return *fresh;
+        delete fresh;
+        return *s;
+    }
+
+    slot& self_slot() {
+        slot_ptr* p = m_slots.local_if();
+        return get_or_create(p ? p->ptr : m_shared.ptr);
+    }
+
+    template <typename F> void for_each_slot(F&& f) const {
+        m_slots.for_each([&f](const slot_ptr& p) {
+            slot* s = p.ptr.load(std::memory_order_acquire);
+            if(s) f(*s);
+        });
+        slot* s = m_shared.ptr.load(std::memory_order_acquire);
+        if(s) f(*s);
+    }
+
+  public:
+
+    const std::string   name;
+    const hg_id_t       id;
+    const std::uint16_t provider_id;
+    const bool          server;
+
+    rpc_metrics(std::string n, hg_id_t i, std::uint16_t pid, bool srv)
+    : m_slots(max_xstreams)
+    , name(std::move(n))
+    , id(i)
+    , provider_id(pid)
+    , server(srv) {}
+
+    rpc_metrics(const rpc_metrics&)            = delete;
+    rpc_metrics& operator=(const rpc_metrics&) = delete;
+
+    ~rpc_metrics() {
+        for_each_slot([](slot& s) { delete &s; });
+    }
+
+    void record(rpc_metric m, std::uint64_t ns) {
+        self_slot().histograms[static_cast<std::size_t>(m)].record(ns);
+    }
+
+    rpc_stats_entry snapshot() const {
+        rpc_stats_entry e;
+        e.name        = name;
+        e.id          = id;
+        e.provider_id = provider_id;
+        e.server      = server;
+        histogram_snapshot* h[] = {&e.queue, &e.decode, &e.handler,
+                                   &e.respond, &e.round_trip};
+        for_each_slot([&h](const slot& s) {
+            for(std::size_t i = 0; i < rpc_metric_count; i++)
+                s.histograms[i].merge_into(*h[i]);
+        });
+        return e;
+    }
+
+    void reset() {
+        for_each_slot([](slot& s) {
+            for(auto& h : s.histograms) h.reset();
+        });
+    }
+};
+
+/**
+ * @private
+ * @brief RPC statistics of a margo instance. Only used when thallium
+ * is compiled with THALLIUM_ENABLE_RPC_STATS; recording further
+ * requires the statistics to be enabled at run time.
+ */
+class rpc_stats_registry : public per_instance<rpc_stats_registry> {
+
+    std::atomic<bool> m_enabled{false};
+    mutable std::mutex m_mutex;
+    // by RPC id, and by name for RPCs shared by several provider ids
+    std::map<std::pair<hg_id_t, std::string>,
+             std::shared_ptr<rpc_metrics>> m_server;
+    std::map<std::pair<hg_id_t, std::uint16_t>,
+             std::shared_ptr<rpc_metrics>> m_client;
+    std::unordered_map<hg_id_t, std::string> m_names;
+
+    // number of registries with statistics enabled, so that clients
+    // look up a registry only if one may record
+    static std::atomic<std::size_t>& enabled_count() {
+        static std::atomic<std::size_t> n{0};
+        return n;
+    }
+
+    static void on_finalize(void* arg) {
+        auto r = uninstall(static_cast<margo_instance_id>(arg));
+        if(r) r->enable(false);
+    }
+
+  public:
+
+    bool enabled() const {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    void enable(bool e) {
+        if(m_enabled.exchange(e) == e) return;
+        if(e) enabled_count().fetch_add(1, std::memory_order_relaxed);
+        else enabled_count().fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Whether the statistics of any margo instance are enabled.
+     */
+    static bool any_enabled() {
+        return enabled_count().load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     * @brief Creates the server-side metrics of an RPC, replacing those
+     * of a previous definition. RPCs shared by several provider ids
+     * (id 0) have one set of metrics for all of them.
+     */
+    std::shared_ptr<rpc_metrics> add_server(hg_id_t id, std::uint16_t provider_id,
+                                            const std::string& name) {
+        auto m = std::make_shared<rpc_metrics>(name, id, provider_id, true);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_server[std::make_pair(id, id == 0 ? name : std::string())] = m;
+        return m;
+    }
+
+    void add_name(hg_id_t id, const std::string& name) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_names[id] = name;
+    }
+
+    std::shared_ptr<rpc_metrics> client(hg_id_t id, std::uint16_t provider_id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& m = m_client[std::make_pair(id, provider_id)];
+        if(!m) {
+            auto it = m_names.find(id);
+            m = std::make_shared<rpc_metrics>(
+                it == m_names.end() ? std::string() : it->second, id, provider_id, false);
+        }
+        return m;
+    }
+
+    rpc_stats snapshot() const {
+        rpc_stats s;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto& p : m_server) s.rpcs.push_back(p.second->snapshot());
+        for(auto& p : m_client) s.rpcs.push_back(p.second->snapshot());
+        return s;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto& p : m_server) p.second->reset();
+        for(auto& p : m_client) p.second->reset();
+    }
+
+    /**
+     * @brief Returns the registry of a margo instance, creating it if
+     * needed. It is dropped when the instance finalizes.
+     */
+    static std::shared_ptr<rpc_stats_registry> get(margo_instance_id mid) {
+        bool created = false;
+        auto r       = find_or_install(
+            mid, []() { return std::make_shared<rpc_stats_registry>(); }, created);
+        if(created)
+            margo_provider_push_prefinalize_callback(
+                mid, r.get(), &rpc_stats_registry::on_finalize, mid);
+        return r;
+    }
+
+    /**
+     * @brief Returns the client-side metrics of the RPC a handle was
+     * created for, or nullptr if statistics are not being recorded.
+     */
+    static std::shared_ptr<rpc_metrics> client_metrics(margo_instance_id mid, hg_handle_t h,
+                                                       std::uint16_t provider_id) {
+        if(!any_enabled()) return nullptr;
+        auto reg = find(mid);
+        if(!reg || !reg->enabled()) return nullptr;
+        const struct hg_info* info = margo_get_info(h);
+        return info ? reg->client(info->id, provider_id) : nullptr;
+    }
+};
+
+/**
+ * @private
+ * @brief Records the time spent in a scope into one of the histograms
+ * of an RPC, if metrics is not null.
+ */
+class rpc_stats_scope {
+
+    std::shared_ptr<rpc_metrics> m_owner;
+    rpc_metrics*                 m_metrics;
+    rpc_metric                   m_metric;
+    std::uint64_t                m_start;
+
+  public:
+
+    rpc_stats_scope(std::shared_ptr<rpc_metrics> metrics, rpc_metric metric)
+    : m_owner(std::move(metrics))
+    , m_metrics(m_owner.get())
+    , m_metric(metric)
+    , m_start(m_metrics ? rpc_stats_now() : 0) {}
+
+    // metrics kept alive by the RPC's callback data
+    rpc_stats_scope(rpc_metrics* metrics, rpc_metric metric)
+    : m_metrics(metrics)
+    , m_metric(metric)
+    , m_start(m_metrics ? rpc_stats_now() : 0) {}
+
+    rpc_stats_scope(const rpc_stats_scope&)            = delete;
+    rpc_stats_scope& operator=(const rpc_stats_scope&) = delete;
+
+    ~rpc_stats_scope() {
+        finish();
+    }
+
+    /**
+     * @brief Records the duration now instead of at the end of the scope.
+     */
+    void finish() {
+        if(m_metrics) m_metrics->record(m_metric, rpc_stats_now() - m_start);
+        m_metrics = nullptr;
+        m_owner.reset();
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -8,6 +8,9 @@
 #define __THALLIUM_RWLOCK_HPP
 
 #include <abt.h>
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+#include <thallium/lock_stats.hpp>
+#endif
 
 namespace thallium {
 
@@ -39,6 +42,16 @@ class rwlock_exception : public exception {
  */
 class rwlock {
     ABT_rwlock m_lock;
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    detail::lock_site* m_site = nullptr;
+
+    template <typename F> void timed(F&& f) {
+        auto start = detail::lock_site::now();
+        f();
+        auto wait = detail::lock_site::now() - start;
+        if(m_site) m_site->record(wait, wait >= detail::lock_contention_ns);
+    }
+#endif
 
   public:
     /**
@@ -49,7 +62,15 @@ class rwlock {
     /**
      * @brief Constructor.
      */
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    explicit rwlock(const char* file = THALLIUM_LOCK_SITE_FILE,
+                    int line = THALLIUM_LOCK_SITE_LINE)
+    : m_site(detail::lock_site::get(file, line, "rwlock")) {
+        TL_RWLOCK_ASSERT(ABT_rwlock_create(&m_lock));
+    }
+#else
     explicit rwlock() { TL_RWLOCK_ASSERT(ABT_rwlock_create(&m_lock)); }
+#endif
 
     /**
      * @brief Copy constructor is deleted.
@@ -62,6 +83,9 @@ class rwlock {
     rwlock(rwlock&& other) {
         m_lock       = other.m_lock;
         other.m_lock = ABT_RWLOCK_NULL;
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        m_site       = other.m_site;
+#endif
     }
 
     /**
@@ -78,6 +102,9 @@ class rwlock {
         TL_RWLOCK_ASSERT(ABT_rwlock_free(&m_lock));
         m_lock       = other.m_lock;
         other.m_lock = ABT_RWLOCK_NULL;
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+        m_site       = other.m_site;
+#endif
         return *this;
     }
 
@@ -89,12 +116,24 @@ class rwlock {
     /**
      * @brief Lock for reading.
      */
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    void rdlock() {
+        timed([this]() { TL_RWLOCK_ASSERT(ABT_rwlock_rdlock(m_lock)); });
+    }
+#else
     void rdlock() { TL_RWLOCK_ASSERT(ABT_rwlock_rdlock(m_lock)); }
+#endif
 
     /**
      * @brief Lock for writing.
      */
+#ifdef THALLIUM_ENABLE_LOCK_STATS
+    void wrlock() {
+        timed([this]() { TL_RWLOCK_ASSERT(ABT_rwlock_wrlock(m_lock)); });
+    }
+#else
     void wrlock() { TL_RWLOCK_ASSERT(ABT_rwlock_wrlock(m_lock)); }
+#endif
 
     /**
      * @brief Unlock.
@@ -0,0 +1,108 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_SCOPED_TIMER_HPP
+#define __THALLIUM_SCOPED_TIMER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <thallium/rpc_stats.hpp>
+#include <thallium/tsc_clock.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Latency histogram with the same log-linear buckets as the RPC
+ * statistics (see histogram_snapshot), recording durations in
+ * nanoseconds. Recording only uses relaxed atomic operations, so a
+ * histogram can be shared by ULTs running on any execution stream.
+ */
+class timing_histogram {
+
+    detail::latency_histogram m_histogram;
+
+  public:
+
+    /**
+     * @brief Records a duration in nanoseconds.
+     */
+    void record(std::uint64_t ns) { m_histogram.record(ns); }
+
+    /**
+     * @brief Records a duration.
+     */
+    template <typename R, typename P>
+    void record(const std::chrono::duration<R, P>& d) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        record(static_cast<std::uint64_t>(ns > 0 ? ns : 0));
+    }
+
+    /**
+     * @brief Returns a copy of the recorded values.
+     */
+    histogram_snapshot snapshot() const {
+        histogram_snapshot s;
+        m_histogram.merge_into(s);
+        return s;
+    }
+
+    /**
+     * @brief Forgets the recorded values.
+     */
+    void reset() { m_histogram.reset(); }
+};
+
+/**
+ * @brief Records the time spent in a scope, measured with tsc_clock,
+ * into a timing_histogram.
+ *
+ * \code{.cpp}
+ * static tl::timing_histogram lookup_times;
+ * {
+ *     tl::scoped_timer t(lookup_times);
+ *     ... lookup ...
+ * }
+ * auto p99 = lookup_times.snapshot().percentile(99);
+ * \endcode
+ */
+class scoped_timer {
+
+    timing_histogram* m_histogram;
+    std::uint64_t     m_start;
+
+  public:
+
+    explicit scoped_timer(timing_histogram& h) noexcept
+    : m_histogram(&h)
+    , m_start(tsc_clock::ticks()) {}
+
+    scoped_timer(const scoped_timer&)            = delete;
+    scoped_timer& operator=(const scoped_timer&) = delete;
+
+    /**
+     * @brief Returns the time elapsed since the timer was created, in
+     * nanoseconds.
+     */
+    std::uint64_t elapsed_ns() const noexcept {
+        return tsc_clock::to_ns(tsc_clock::ticks() - m_start);
+    }
+
+    /**
+     * @brief Records the elapsed time now (once); the destructor then
+     * doesn't record anything.
+     */
+    void stop() noexcept {
+        if(!m_histogram) return;
+        m_histogram->record(elapsed_ns());
+        m_histogram = nullptr;
+    }
+
+    ~scoped_timer() { stop(); }
+};
+
+} // namespace thallium
+
+#endif /* end of include guard */
@@ -7,12 +7,43 @@
 #define __THALLIUM_SELF_HPP
 
 #include <abt.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <thallium/abt_errors.hpp>
 #include <thallium/exception.hpp>
+#include <thallium/tsc_clock.hpp>
 #include <thallium/unit_type.hpp>
 
 namespace thallium {
 
+namespace detail {
+
+/**
+ * @private
+ * @brief Time slice of the ULT running on the calling execution stream,
+ * started the first time it called self::maybe_yield since it was
+ * scheduled. long_runner is the ULT that yielded from maybe_yield, until
+ * a priority_pool receives it back.
+ */
+struct time_slice_state {
+    ABT_thread    owner       = ABT_THREAD_NULL;
+    std::uint64_t start_ns    = 0;
+    ABT_thread    long_runner = ABT_THREAD_NULL;
+};
+
+inline time_slice_state& time_slice() {
+    static thread_local time_slice_state state;
+    return state;
+}
+
+inline std::atomic<std::uint64_t>& time_slice_ns() {
+    static std::atomic<std::uint64_t> ns{2000000};
+    return ns;
+}
+
+} // namespace detail
+
 /**
  * Exception class thrown by the xstream_barrier class.
  */
@@ -92,6 +123,72 @@ class self {
      * @brief Suspend the current ULT.
      */
     static void suspend() { TL_SELF_ASSERT(ABT_self_suspend()); }
+
+    /**
+     * @brief Yields if the calling ULT has run for longer than the time
+     * slice (see set_time_slice) since its slice started, and returns
+     * whether it yielded. ULTs are not preempted, so a handler doing a
+     * long computation (e.g. rebuilding an index) delays every unit
+     * queued behind it on its execution stream; calling maybe_yield in
+     * its loops bounds that delay to about one slice. It only reads the
+     * CPU's cycle counter when the slice has not expired, so it can be
+     * called every few microseconds of work.
+     *
+     * \code{.cpp}
+     * for(auto& entry : entries) {
+     *     index.insert(entry);
+     *     tl::self::maybe_yield();
+     * }
+     * \endcode
+     *
+     * The slice of a ULT starts at its first call to maybe_yield after it
+     * was scheduled, so the time it ran before is not counted. ULTs that
+     * yield from maybe_yield are considered long-running; a priority_pool
+     * can be set to put them back at its lowest priority (see
+     * priority_pool::set_demote_long_runners). Does nothing when called
+     * from a tasklet or from outside Argobots.
+     *
+     * @return true if the ULT yielded.
+     */
+    static bool maybe_yield() {
+        ABT_thread t = ABT_THREAD_NULL;
+        if(ABT_self_get_thread(&t) != ABT_SUCCESS || t == ABT_THREAD_NULL) return false;
+        std::uint64_t now   = tsc_clock::now_ns();
+        auto&         slice = detail::time_slice();
+        if(slice.owner != t) {
+            slice.owner    = t;
+            slice.start_ns = now;
+            return false;
+        }
+        if(now - slice.start_ns < detail::time_slice_ns().load(std::memory_order_relaxed))
+            return false;
+        slice.owner       = ABT_THREAD_NULL;
+        slice.long_runner = t;
+        TL_SELF_ASSERT(ABT_thread_yield());
+        // the ULT may have resumed on another execution stream, whose
+        // slice starts now
+        auto& resumed    = detail::time_slice();
+        resumed.owner    = t;
+        resumed.start_ns = tsc_clock::now_ns();
+        return true;
+    }
+
+    /**
+     * @brief Sets the time slice after which maybe_yield yields (2ms by
+     * default), for all ULTs.
+     */
+    static void set_time_slice(std::chrono::nanoseconds slice) {
+        detail::time_slice_ns().store(static_cast<std::uint64_t>(slice.count()),
+                                      std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the time slice used by maybe_yield.
+     */
+    static std::chrono::nanoseconds get_time_slice() {
+        return std::chrono::nanoseconds(
+            detail::time_slice_ns().load(std::memory_order_relaxed));
+    }
 };
 
 } // namespace thallium
@@ -6,12 +6,19 @@
 #ifndef THALLIUM_CEREAL_ARCHIVES_BINARY_HPP
 #define THALLIUM_CEREAL_ARCHIVES_BINARY_HPP
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <mercury_proc.h>
 #include <cereal/cereal.hpp>
 #include <margo.h>
 #include <thallium/exception.hpp>
+#include <thallium/serialization/varint.hpp>
 
 namespace thallium {
 
@@ -136,20 +143,49 @@ namespace thallium {
     };
 
     template<class T, class... CtxArg> inline
-    typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+    typename std::enable_if<std::is_arithmetic<T>::value
+        && !detail::uses_varint<T, CtxArg...>::value, void>::type
     CEREAL_SAVE_FUNCTION_NAME(proc_output_archive<CtxArg...> & ar, T const & t)
     {
         ar.write(std::addressof(t), sizeof(t));
     }
 
     template<class T, class... CtxArg> inline
-    typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+    typename std::enable_if<std::is_arithmetic<T>::value
+        && !detail::uses_varint<T, CtxArg...>::value, void>::type
     CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar, T & t)
     {
         t = T{};
         ar.read(std::addressof(t), sizeof(t));
     }
 
+    template<class T, class... CtxArg> inline
+    typename std::enable_if<detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(proc_output_archive<CtxArg...> & ar, T const & t)
+    {
+        unsigned char buf[detail::varint_max_size];
+        ar.write(buf, detail::varint_encode(detail::zigzag_encode(t), buf));
+    }
+
+    template<class T, class... CtxArg> inline
+    typename std::enable_if<detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar, T & t)
+    {
+        std::uint64_t v     = 0;
+        unsigned      shift = 0;
+        for(std::size_t i = 0; i < detail::varint_max_size; i++) {
+            unsigned char b;
+            ar.read(&b, 1);
+            v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if(!(b & 0x80)) {
+                t = detail::zigzag_decode<T>(v);
+                return;
+            }
+            shift += 7;
+        }
+        throw exception("Error during deserialization, invalid varint");
+    }
+
     template <class T, class... CtxArg> inline
     void CEREAL_SERIALIZE_FUNCTION_NAME(proc_output_archive<CtxArg...>& ar, cereal::NameValuePair<T>& t)
     {
@@ -185,6 +221,272 @@ namespace thallium {
     {
         ar.read(bd.data, static_cast<std::size_t>(bd.size));
     }
+
+    /**
+     * @brief Trait indicating whether a contiguous sequence of T can be
+     * serialized as a single block of bytes. This is true for arithmetic
+     * types (except bool) and enums. Users can specialize it for their own
+     * trivially-copyable types to benefit from the same fast path when
+     * such types are stored in std::vector, std::array, or C arrays.
+     *
+     * @tparam T Element type.
+     */
+    template<typename T>
+    struct is_trivially_serializable
+    : std::integral_constant<bool,
+        (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value)
+        || std::is_enum<T>::value> {};
+
+    template<class T, class A, class... CtxArg> inline
+    typename std::enable_if<is_trivially_serializable<T>::value
+        && !detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(proc_output_archive<CtxArg...>& ar, std::vector<T, A> const & v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+            "is_trivially_serializable specialized for a type that isn't trivially copyable");
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(v.size())));
+        if(!v.empty()) ar.write(v.data(), v.size()*sizeof(T));
+    }
+
+    template<class T, class A, class... CtxArg> inline
+    typename std::enable_if<is_trivially_serializable<T>::value
+        && !detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar, std::vector<T, A>& v)
+    {
+        cereal::size_type size;
+        ar(cereal::make_size_tag(size));
+        v.resize(static_cast<std::size_t>(size));
+        if(!v.empty()) ar.read(v.data(), v.size()*sizeof(T));
+    }
+
+    /**
+     * @brief Trait opting a struct type into the column-oriented (SoA)
+     * serialization of std::vector: instead of one call to serialize()
+     * per element, each field is written for all the elements as one
+     * contiguous array, which takes a single copy per field and leaves
+     * same-typed values next to each other for compression.
+     * Specializations define a static fields() function returning a
+     * std::tuple of pointers to data members, whose types must satisfy
+     * is_trivially_serializable. T must be default constructible, and
+     * both sides of an RPC must use the same specialization.
+     *
+     * \code{.cpp}
+     * namespace thallium {
+     * template<> struct soa_fields<particle> {
+     *     static auto fields() {
+     *         return std::make_tuple(&particle::x, &particle::y, &particle::id);
+     *     }
+     * };
+     * }
+     * \endcode
+     *
+     * Types that are trivially copyable and have no padding are better
+     * off specializing is_trivially_serializable, which copies the whole
+     * vector at once; a type cannot opt into both.
+     *
+     * @tparam T Element type.
+     */
+    template<typename T> struct soa_fields;
+
+    namespace detail {
+
+    template<typename T, typename = void>
+    struct has_soa_fields : std::false_type {};
+
+    template<typename T>
+    struct has_soa_fields<T, decltype((void)soa_fields<T>::fields())> : std::true_type {};
+
+    template<typename T, typename M>
+    constexpr std::size_t soa_field_size(M T::*) {
+        static_assert(is_trivially_serializable<M>::value,
+            "soa_fields lists a member that isn't trivially serializable");
+        return sizeof(M);
+    }
+
+    template<typename T, typename Fields, std::size_t... I>
+    std::size_t soa_row_size(const Fields& f, std::index_sequence<I...>) {
+        std::size_t sizes[] = {0, soa_field_size<T>(std::get<I>(f))...};
+        std::size_t total = 0;
+        for(auto s : sizes) total += s;
+        return total;
+    }
+
+    /**
+     * @private
+     * @brief Number of bytes taken by the fields listed in soa_fields<T>
+     * for one element.
+     */
+    template<typename T>
+    std::size_t soa_row_size() {
+        auto f = soa_fields<T>::fields();
+        return soa_row_size<T>(f, std::make_index_sequence<std::tuple_size<decltype(f)>::value>());
+    }
+
+    template<typename T, typename A, typename M>
+    void soa_gather(const std::vector<T, A>& v, M T::* field, char*& out) {
+        for(const auto& x : v) {
+            std::memcpy(out, &(x.*field), sizeof(M));
+            out += sizeof(M);
+        }
+    }
+
+    template<typename T, typename A, typename M>
+    void soa_scatter(std::vector<T, A>& v, M T::* field, const char*& in) {
+        for(auto& x : v) {
+            std::memcpy(&(x.*field), in, sizeof(M));
+            in += sizeof(M);
+        }
+    }
+
+    template<typename T, typename A, typename Fields, std::size_t... I>
+    void soa_gather_all(const std::vector<T, A>& v, const Fields& f, char* out,
+                        std::index_sequence<I...>) {
+        int x[] = {0, (soa_gather(v, std::get<I>(f), out), 0)...};
+        (void)x;
+    }
+
+    template<typename T, typename A, typename Fields, std::size_t... I>
+    void soa_scatter_all(std::vector<T, A>& v, const Fields& f, const char* in,
+                         std::index_sequence<I...>) {
+        int x[] = {0, (soa_scatter(v, std::get<I>(f), in), 0)...};
+        (void)x;
+    }
+
+    } // namespace detail
+
+    // vectors of types with soa_fields are written as their size, then
+    // each field of all the elements, gathered (and scattered back)
+    // directly in the Mercury buffer
+    template<class T, class A, class... CtxArg> inline
+    typename std::enable_if<detail::has_soa_fields<T>::value
+        && !is_trivially_serializable<T>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(proc_output_archive<CtxArg...>& ar, std::vector<T, A> const & v)
+    {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(v.size())));
+        std::size_t bytes = v.size() * detail::soa_row_size<T>();
+        if(bytes == 0) return;
+        auto f   = soa_fields<T>::fields();
+        auto ptr = static_cast<char*>(ar.save_ptr(bytes));
+        detail::soa_gather_all(v, f, ptr,
+            std::make_index_sequence<std::tuple_size<decltype(f)>::value>());
+        ar.restore_ptr(ptr, bytes);
+    }
+
+    template<class T, class A, class... CtxArg> inline
+    typename std::enable_if<detail::has_soa_fields<T>::value
+        && !is_trivially_serializable<T>::value, void>::type
+    CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar, std::vector<T, A>& v)
+    {
+        cereal::size_type size;
+        ar(cereal::make_size_tag(size));
+        std::size_t row = detail::soa_row_size<T>();
+        if(row != 0 && size > hg_proc_get_size_left(ar.get_proc()) / row)
+            throw exception("Error during deserialization, invalid vector size");
+        v.resize(static_cast<std::size_t>(size));
+        std::size_t bytes = v.size() * row;
+        if(bytes == 0) return;
+        auto f   = soa_fields<T>::fields();
+        auto ptr = static_cast<char*>(ar.save_ptr(bytes));
+        detail::soa_scatter_all(v, f, ptr,
+            std::make_index_sequence<std::tuple_size<decltype(f)>::value>());
+        ar.restore_ptr(ptr, bytes);
+    }
+
+    // with varint_encoding, vectors of integers are written as their
+    // size, the number of bytes of their encoded elements, then the
+    // elements, so that they are encoded and decoded in place in the
+    // Mercury buffer rather than one hg_proc_memcpy per element
+    template<class T, class A, class... CtxArg> inline
+    typename std::enable_if<detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(proc_output_archive<CtxArg...>& ar, std::vector<T, A> const & v)
+    {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(v.size())));
+        std::uint64_t bytes = 0;
+        for(const auto& x : v) bytes += detail::varint_size(detail::zigzag_encode(x));
+        ar(bytes);
+        if(bytes == 0) return;
+        auto ptr = static_cast<unsigned char*>(ar.save_ptr(bytes));
+        auto out = ptr;
+        for(const auto& x : v) out += detail::varint_encode(detail::zigzag_encode(x), out);
+        ar.restore_ptr(ptr, bytes);
+    }
+
+    template<class T, class A, class... CtxArg> inline
+    typename std::enable_if<detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar, std::vector<T, A>& v)
+    {
+        cereal::size_type size;
+        ar(cereal::make_size_tag(size));
+        std::uint64_t bytes = 0;
+        ar(bytes);
+        if(size > bytes || bytes > hg_proc_get_size_left(ar.get_proc()))
+            throw exception("Error during deserialization, invalid varint vector");
+        v.resize(static_cast<std::size_t>(size));
+        if(bytes == 0) return;
+        auto ptr = static_cast<const unsigned char*>(ar.save_ptr(bytes));
+        auto in  = ptr;
+        auto end = ptr + bytes;
+        for(auto& x : v) {
+            std::uint64_t u = 0;
+            std::size_t   n = detail::varint_decode(in, end, u);
+            if(n == 0) throw exception("Error during deserialization, invalid varint");
+            x = detail::zigzag_decode<T>(u);
+            in += n;
+        }
+        ar.restore_ptr(const_cast<unsigned char*>(ptr), bytes);
+    }
+
+    template<class T, std::size_t N, class... CtxArg> inline
+    typename std::enable_if<is_trivially_serializable<T>::value
+        && !detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(proc_output_archive<CtxArg...>& ar, std::array<T, N> const & a)
+    {
+        ar.write(a.data(), sizeof(a));
+    }
+
+    template<class T, std::size_t N, class... CtxArg> inline
+    typename std::enable_if<is_trivially_serializable<T>::value
+        && !detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar, std::array<T, N>& a)
+    {
+        ar.read(a.data(), sizeof(a));
+    }
+
+    template<class CharT, class Traits, class A, class... CtxArg> inline
+    void CEREAL_SAVE_FUNCTION_NAME(proc_output_archive<CtxArg...>& ar,
+                                   std::basic_string<CharT, Traits, A> const & str)
+    {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(str.size())));
+        if(!str.empty()) ar.write(str.data(), str.size()*sizeof(CharT));
+    }
+
+    template<class CharT, class Traits, class A, class... CtxArg> inline
+    void CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar,
+                                   std::basic_string<CharT, Traits, A>& str)
+    {
+        cereal::size_type size;
+        ar(cereal::make_size_tag(size));
+        str.resize(static_cast<std::size_t>(size));
+        if(!str.empty()) ar.read(&str[0], str.size()*sizeof(CharT));
+    }
+
+    template<class T, class... CtxArg> inline
+    typename std::enable_if<std::is_array<T>::value
+        && is_trivially_serializable<typename std::remove_all_extents<T>::type>::value
+        && !detail::uses_varint<typename std::remove_all_extents<T>::type, CtxArg...>::value, void>::type
+    CEREAL_SERIALIZE_FUNCTION_NAME(proc_output_archive<CtxArg...>& ar, T& array)
+    {
+        ar.write(array, sizeof(array));
+    }
+
+    template<class T, class... CtxArg> inline
+    typename std::enable_if<std::is_array<T>::value
+        && is_trivially_serializable<typename std::remove_all_extents<T>::type>::value
+        && !detail::uses_varint<typename std::remove_all_extents<T>::type, CtxArg...>::value, void>::type
+    CEREAL_SERIALIZE_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar, T& array)
+    {
+        ar.read(array, sizeof(array));
+    }
 }
 
 // register archives for polymorphic support
@@ -0,0 +1,209 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_COMPRESSION_HPP
+#define __THALLIUM_COMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <thallium/exception.hpp>
+
+#ifdef THALLIUM_HAS_LZ4
+#include <lz4.h>
+#endif
+#ifdef THALLIUM_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace thallium {
+
+/**
+ * @brief When present in a serialization context, a compression object
+ * makes thallium compress the serialized arguments (or response) of an
+ * RPC whose encoded size is at least threshold bytes. A header byte
+ * tells the receiver whether the payload is compressed and with which
+ * codec, so both sides only need to agree on using a compression
+ * context, not on the codec or the threshold.
+ *
+ * Codecs are available when thallium is used through the thallium_lz4
+ * or thallium_zstd CMake targets (which define THALLIUM_HAS_LZ4 and
+ * THALLIUM_HAS_ZSTD). If the codec is not available to the sender, the
+ * payload is sent uncompressed; if it is not available to the receiver,
+ * decoding fails.
+ *
+ * Compressed payloads are decoded from a temporary buffer, so types
+ * decoded without copying (e.g. buffer_view) cannot be used with it.
+ *
+ * \code{.cpp}
+ * auto z = tl::compression::zstd(64*1024);
+ * auto resp = rpc.on(ep).with_serialization_context(z)(big_vector);
+ * engine.define("store", [](const tl::request_with_context<tl::compression>& req,
+ *                           const std::vector<double>& v) { ... });
+ * \endcode
+ */
+struct compression {
+
+    enum class codec : std::uint8_t {
+        none = 0,
+        lz4  = 1,
+        zstd = 2
+    };
+
+    codec       algorithm = codec::none;    /*!< codec used when sending */
+    std::size_t threshold = 64 * 1024;      /*!< minimum size to compress */
+    int         level     = 1;              /*!< codec-specific level */
+
+    static compression lz4(std::size_t threshold = 64 * 1024) {
+        compression c;
+        c.algorithm = codec::lz4;
+        c.threshold = threshold;
+        return c;
+    }
+
+    static compression zstd(std::size_t threshold = 64 * 1024, int level = 1) {
+        compression c;
+        c.algorithm = codec::zstd;
+        c.threshold = threshold;
+        c.level     = level;
+        return c;
+    }
+
+    /**
+     * @brief Returns whether a codec was compiled in.
+     */
+    static bool available(codec c) {
+        switch(c) {
+        case codec::none: return true;
+#ifdef THALLIUM_HAS_LZ4
+        case codec::lz4: return true;
+#endif
+#ifdef THALLIUM_HAS_ZSTD
+        case codec::zstd: return true;
+#endif
+        default: return false;
+        }
+    }
+
+    /**
+     * @brief Returns the largest ratio between the decompressed and
+     * compressed sizes of data compressed with codec c (0 if the codec
+     * is unknown). Receivers check the sizes they are sent against it
+     * before allocating the decompressed buffer: lz4 expands each byte
+     * at most 255 times, and zstd at most 128 KiB per block of at least
+     * 4 bytes.
+     */
+    static std::size_t max_expansion(codec c) {
+        switch(c) {
+        case codec::none: return 1;
+        case codec::lz4:  return 255;
+        case codec::zstd: return 32*1024;
+        default: return 0;
+        }
+    }
+
+    /**
+     * @brief Compresses [src, src+size) into out (resized to the
+     * compressed size). Returns false if the codec is not available or
+     * if the data did not shrink.
+     */
+    bool compress(const void* src, std::size_t size, std::vector<char>& out) const {
+        switch(algorithm) {
+#ifdef THALLIUM_HAS_LZ4
+        case codec::lz4: {
+            if(size > static_cast<std::size_t>(LZ4_MAX_INPUT_SIZE)) return false;
+            out.resize(LZ4_compressBound(static_cast<int>(size)));
+            int n = LZ4_compress_default(static_cast<const char*>(src), out.data(),
+                                         static_cast<int>(size), static_cast<int>(out.size()));
+            if(n <= 0 || static_cast<std::size_t>(n) >= size) return false;
+            out.resize(n);
+            return true;
+        }
+#endif
+#ifdef THALLIUM_HAS_ZSTD
+        case codec::zstd: {
+            out.resize(ZSTD_compressBound(size));
+            std::size_t n = ZSTD_compress(out.data(), out.size(), src, size, level);
+            if(ZSTD_isError(n) || n >= size) return false;
+            out.resize(n);
+            return true;
+        }
+#endif
+        default:
+            (void)src; (void)size; (void)out;
+            return false;
+        }
+    }
+
+    /**
+     * @brief Decompresses [src, src+size) compressed with codec c into
+     * [dst, dst+raw_size). Throws if the codec is not available or the
+     * data is corrupted.
+     */
+    static void decompress(codec c, const void* src, std::size_t size,
+                           void* dst, std::size_t raw_size) {
+        switch(c) {
+#ifdef THALLIUM_HAS_LZ4
+        case codec::lz4: {
+            int n = LZ4_decompress_safe(static_cast<const char*>(src), static_cast<char*>(dst),
+                                        static_cast<int>(size), static_cast<int>(raw_size));
+            if(n < 0 || static_cast<std::size_t>(n) != raw_size)
+                throw exception("Corrupted lz4-compressed payload");
+            return;
+        }
+#endif
+#ifdef THALLIUM_HAS_ZSTD
+        case codec::zstd: {
+            std::size_t n = ZSTD_decompress(dst, raw_size, src, size);
+            if(ZSTD_isError(n) || n != raw_size)
+                throw exception("Corrupted zstd-compressed payload");
+            return;
+        }
+#endif
+        default:
+            (void)src; (void)size; (void)dst; (void)raw_size;
+            throw exception("Received a payload compressed with codec ",
+                            static_cast<int>(c), " which is not available");
+        }
+    }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Finds a compression object in a serialization context,
+ * returns nullptr if there is none.
+ */
+inline const compression* get_compression_if(const compression& c, std::true_type) {
+    return &c;
+}
+
+template <typename T>
+inline const compression* get_compression_if(const T&, std::false_type) { return nullptr; }
+
+template <std::size_t I = 0, typename... CtxArg>
+inline typename std::enable_if<I == sizeof...(CtxArg), const compression*>::type
+find_compression(const std::tuple<CtxArg...>&) {
+    return nullptr;
+}
+
+template <std::size_t I = 0, typename... CtxArg>
+inline typename std::enable_if<(I < sizeof...(CtxArg)), const compression*>::type
+find_compression(const std::tuple<CtxArg...>& ctx) {
+    using element = typename std::decay<
+        typename std::tuple_element<I, std::tuple<CtxArg...>>::type>::type;
+    const compression* c = get_compression_if(std::get<I>(ctx),
+                                              std::is_same<element, compression>());
+    return c ? c : find_compression<I + 1>(ctx);
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_SIGNATURE_HASH_HPP
+#define __THALLIUM_SIGNATURE_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief 64-bit FNV-1a hash of a null-terminated string.
+ */
+constexpr std::uint64_t fnv1a(const char* s, std::uint64_t h = 14695981039346656037ull) {
+    return *s == '\0' ? h : fnv1a(s + 1, (h ^ static_cast<unsigned char>(*s)) * 1099511628211ull);
+}
+
+/**
+ * @private
+ * @brief Type an argument is decoded as: the client serializes tuples
+ * of std::reference_wrapper to its arguments while the server decodes
+ * tuples of values, so both are reduced to the decayed value types.
+ */
+template <typename T> struct signature_element {
+    using type = typename std::decay<T>::type;
+};
+
+template <typename T> struct signature_element<std::reference_wrapper<T>> {
+    using type = typename std::decay<T>::type;
+};
+
+template <typename T> struct signature_of {
+    using type = typename signature_element<T>::type;
+};
+
+template <typename... T> struct signature_of<std::tuple<T...>> {
+    using type = std::tuple<typename signature_element<T>::type...>;
+};
+
+/**
+ * @private
+ * @brief Returns the hash identifying the type T of a payload. It is
+ * computed from the mangled name of the type, which is the same for
+ * all compilers following the Itanium C++ ABI (GCC, Clang, ICX), and
+ * only once per type.
+ */
+template <typename T> inline std::uint64_t signature_hash() {
+    static const std::uint64_t hash =
+        fnv1a(typeid(typename signature_of<T>::type).name());
+    return hash;
+}
+
+/**
+ * @private
+ * @brief Hash of payloads with no value (responses to respond()).
+ */
+inline std::uint64_t void_signature_hash() {
+    static const std::uint64_t hash = fnv1a(typeid(void).name());
+    return hash;
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
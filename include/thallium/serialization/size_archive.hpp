@@ -0,0 +1,193 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_SIZE_ARCHIVE_HPP
+#define __THALLIUM_SIZE_ARCHIVE_HPP
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <thallium/serialization/cereal/archives.hpp>
+#include <thallium/engine.hpp>
+
+namespace thallium {
+
+    /**
+     * @brief size_archive is an output archive that doesn't write
+     * anything but counts the number of bytes that a proc_output_archive
+     * would write into the Mercury buffer for the same data. It is used
+     * to know ahead of time whether the arguments of an RPC fit in the
+     * eager buffer.
+     *
+     * Types with custom serialization functions written for a generic
+     * archive type (template <typename A> void serialize(A& ar)) work
+     * with a size_archive the same way they do with a proc_output_archive.
+     * Serialization functions calling ar.get_proc() directly cannot work
+     * with this archive, since it has no hg_proc_t; the bulk class has a
+     * dedicated overload.
+     */
+    template<typename ... CtxArg>
+    class size_archive :
+        public cereal::OutputArchive<
+            size_archive<CtxArg...>,
+            cereal::AllowEmptyClassElision>
+    {
+
+    public:
+
+        size_archive(std::tuple<CtxArg...>& context,
+                     margo_instance_id mid = MARGO_INSTANCE_NULL)
+        : cereal::OutputArchive<size_archive, cereal::AllowEmptyClassElision>(this)
+        , m_context(context)
+        , m_mid(mid)
+        {}
+
+        ~size_archive() = default;
+
+        inline void write(const void* data, size_t size) {
+            (void)data;
+            m_size += size;
+        }
+
+        /**
+         * @brief Adds size bytes to the count without providing data.
+         */
+        void add(size_t size) {
+            m_size += size;
+        }
+
+        /**
+         * @brief Returns the number of bytes counted so far.
+         */
+        size_t size() const {
+            return m_size;
+        }
+
+        engine get_engine() const {
+            return engine(m_mid);
+        }
+
+        hg_proc_t get_proc() const {
+            return HG_PROC_NULL;
+        }
+
+        auto& get_context() {
+            return m_context;
+        }
+
+        // save_ptr hands out scratch memory, since callers are allowed
+        // to write into the returned pointer before calling restore_ptr
+        void* save_ptr(size_t size) {
+            if(m_scratch.size() < size) m_scratch.resize(size);
+            return m_scratch.data();
+        }
+
+        void restore_ptr(void* buf, size_t size) {
+            (void)buf;
+            m_size += size;
+        }
+
+    private:
+
+        std::tuple<CtxArg...>& m_context;
+        margo_instance_id      m_mid;
+        size_t                 m_size = 0;
+        std::vector<char>      m_scratch;
+    };
+
+    template<class T, class... CtxArg> inline
+    typename std::enable_if<std::is_arithmetic<T>::value
+        && !detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(size_archive<CtxArg...>& ar, T const & t)
+    {
+        (void)t;
+        ar.add(sizeof(T));
+    }
+
+    template<class T, class... CtxArg> inline
+    typename std::enable_if<detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(size_archive<CtxArg...>& ar, T const & t)
+    {
+        ar.add(detail::varint_size(detail::zigzag_encode(t)));
+    }
+
+    template <class T, class... CtxArg> inline
+    void CEREAL_SERIALIZE_FUNCTION_NAME(size_archive<CtxArg...>& ar, cereal::NameValuePair<T>& t)
+    {
+        ar(t.value);
+    }
+
+    template <class T, class... CtxArg> inline
+    void CEREAL_SERIALIZE_FUNCTION_NAME(size_archive<CtxArg...>& ar, cereal::SizeTag<T>& t)
+    {
+        ar(t.size);
+    }
+
+    template <class T, class... CtxArg> inline
+    void CEREAL_SAVE_FUNCTION_NAME(size_archive<CtxArg...>& ar, cereal::BinaryData<T> const & bd)
+    {
+        ar.add(static_cast<std::size_t>(bd.size));
+    }
+
+    template<class T, class A, class... CtxArg> inline
+    typename std::enable_if<is_trivially_serializable<T>::value
+        && !detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(size_archive<CtxArg...>& ar, std::vector<T, A> const & v)
+    {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(v.size())));
+        ar.add(v.size()*sizeof(T));
+    }
+
+    template<class T, class A, class... CtxArg> inline
+    typename std::enable_if<detail::has_soa_fields<T>::value
+        && !is_trivially_serializable<T>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(size_archive<CtxArg...>& ar, std::vector<T, A> const & v)
+    {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(v.size())));
+        ar.add(v.size()*detail::soa_row_size<T>());
+    }
+
+    template<class T, class A, class... CtxArg> inline
+    typename std::enable_if<detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(size_archive<CtxArg...>& ar, std::vector<T, A> const & v)
+    {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(v.size())));
+        std::uint64_t bytes = 0;
+        for(const auto& x : v) bytes += detail::varint_size(detail::zigzag_encode(x));
+        ar(bytes);
+        ar.add(static_cast<std::size_t>(bytes));
+    }
+
+    template<class T, std::size_t N, class... CtxArg> inline
+    typename std::enable_if<is_trivially_serializable<T>::value
+        && !detail::uses_varint<T, CtxArg...>::value, void>::type
+    CEREAL_SAVE_FUNCTION_NAME(size_archive<CtxArg...>& ar, std::array<T, N> const & a)
+    {
+        (void)a;
+        ar.add(sizeof(a));
+    }
+
+    template<class CharT, class Traits, class A, class... CtxArg> inline
+    void CEREAL_SAVE_FUNCTION_NAME(size_archive<CtxArg...>& ar,
+                                   std::basic_string<CharT, Traits, A> const & str)
+    {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(str.size())));
+        ar.add(str.size()*sizeof(CharT));
+    }
+
+    template<class T, class... CtxArg> inline
+    typename std::enable_if<std::is_array<T>::value
+        && is_trivially_serializable<typename std::remove_all_extents<T>::type>::value
+        && !detail::uses_varint<typename std::remove_all_extents<T>::type, CtxArg...>::value, void>::type
+    CEREAL_SERIALIZE_FUNCTION_NAME(size_archive<CtxArg...>& ar, T& array)
+    {
+        ar.add(sizeof(array));
+    }
+}
+
+CEREAL_REGISTER_ARCHIVE(thallium::size_archive<>)
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_ASSOCIATIVE_CONTAINER_SERIALIZATION_HPP
+#define __THALLIUM_ASSOCIATIVE_CONTAINER_SERIALIZATION_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <thallium/serialization/cereal/archives.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Maps and sets are serialized by cereal as a size tag followed
+ * by the elements (key then value for maps), which is left unchanged.
+ * Loading from a proc_input_archive is specialized so that:
+ * - unordered containers reserve their buckets from the size tag
+ *   instead of rehashing repeatedly while growing;
+ * - ordered containers insert with end() as hint, which is constant
+ *   time for the sorted sequence they were serialized as;
+ * - when the underlying library supports node extraction (C++17), the
+ *   nodes already owned by the container are reused for the incoming
+ *   elements, so that decoding into a container kept across RPCs does
+ *   not allocate one node per element.
+ * The container is cleared and refilled in place, hence it keeps its
+ * allocator (e.g. an arena or std::pmr allocator) and, for unordered
+ * containers, its hash function and bucket array.
+ */
+template <typename Container>
+struct associative_container_loader {
+
+    static void reserve(Container&, std::size_t, std::false_type) {}
+
+    template <typename C = Container>
+    static auto reserve(C& c, std::size_t n, std::true_type)
+        -> decltype(c.reserve(n), void()) {
+        c.reserve(n);
+    }
+
+    template <typename C>
+    static auto has_reserve(int) -> decltype(std::declval<C&>().reserve(0), std::true_type());
+
+    template <typename C>
+    static std::false_type has_reserve(...);
+
+    static void prepare(Container& c, std::size_t n) {
+        c.clear();
+        reserve(c, n, decltype(has_reserve<Container>(0))());
+    }
+
+#if defined(__cpp_lib_node_extract)
+    using node_type = typename Container::node_type;
+
+    static std::vector<node_type> recycle(Container& c, std::size_t n) {
+        std::vector<node_type> nodes;
+        if(c.empty() || n == 0) return nodes;
+        nodes.reserve(c.size() < n ? c.size() : n);
+        while(!c.empty() && nodes.size() < n) nodes.push_back(c.extract(c.begin()));
+        return nodes;
+    }
+#endif
+
+    template <typename Archive>
+    static void load_map(Archive& ar, Container& c) {
+        cereal::size_type size;
+        ar(cereal::make_size_tag(size));
+        auto n = static_cast<std::size_t>(size);
+#if defined(__cpp_lib_node_extract)
+        auto nodes = recycle(c, n);
+#endif
+        prepare(c, n);
+        for(std::size_t i = 0; i < n; i++) {
+#if defined(__cpp_lib_node_extract)
+            if(!nodes.empty()) {
+                node_type node = std::move(nodes.back());
+                nodes.pop_back();
+                ar(node.key(), node.mapped());
+                c.insert(c.end(), std::move(node));
+                continue;
+            }
+#endif
+            typename Container::key_type    key{};
+            typename Container::mapped_type value{};
+            ar(key, value);
+            c.emplace_hint(c.end(), std::move(key), std::move(value));
+        }
+    }
+
+    template <typename Archive>
+    static void load_set(Archive& ar, Container& c) {
+        cereal::size_type size;
+        ar(cereal::make_size_tag(size));
+        auto n = static_cast<std::size_t>(size);
+#if defined(__cpp_lib_node_extract)
+        auto nodes = recycle(c, n);
+#endif
+        prepare(c, n);
+        for(std::size_t i = 0; i < n; i++) {
+#if defined(__cpp_lib_node_extract)
+            if(!nodes.empty()) {
+                node_type node = std::move(nodes.back());
+                nodes.pop_back();
+                ar(node.value());
+                c.insert(c.end(), std::move(node));
+                continue;
+            }
+#endif
+            typename Container::key_type key{};
+            ar(key);
+            c.emplace_hint(c.end(), std::move(key));
+        }
+    }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -6,6 +6,18 @@
 #ifndef __THALLIUM_MULTIMAP_SERIALIZATION_HPP
 #define __THALLIUM_MULTIMAP_SERIALIZATION_HPP
 
+#include <map>
 #include <cereal/types/map.hpp>
+#include <thallium/serialization/stl/associative_container.hpp>
+
+namespace thallium {
+
+template <class K, class T, class C, class A, class... CtxArg>
+inline void CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar,
+                                      std::multimap<K, T, C, A>& c) {
+    detail::associative_container_loader<std::multimap<K, T, C, A>>::load_map(ar, c);
+}
+
+} // namespace thallium
 
 #endif
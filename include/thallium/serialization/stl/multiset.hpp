@@ -6,6 +6,18 @@
 #ifndef __THALLIUM_MULTISET_SERIALIZATION_HPP
 #define __THALLIUM_MULTISET_SERIALIZATION_HPP
 
+#include <set>
 #include <cereal/types/set.hpp>
+#include <thallium/serialization/stl/associative_container.hpp>
+
+namespace thallium {
+
+template <class K, class C, class A, class... CtxArg>
+inline void CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar,
+                                      std::multiset<K, C, A>& c) {
+    detail::associative_container_loader<std::multiset<K, C, A>>::load_set(ar, c);
+}
+
+} // namespace thallium
 
 #endif
@@ -6,6 +6,18 @@
 #ifndef __THALLIUM_UNORDERED_MAP_SERIALIZATION_HPP
 #define __THALLIUM_UNORDERED_MAP_SERIALIZATION_HPP
 
+#include <unordered_map>
 #include <cereal/types/unordered_map.hpp>
+#include <thallium/serialization/stl/associative_container.hpp>
+
+namespace thallium {
+
+template <class K, class T, class H, class E, class A, class... CtxArg>
+inline void CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar,
+                                      std::unordered_map<K, T, H, E, A>& c) {
+    detail::associative_container_loader<std::unordered_map<K, T, H, E, A>>::load_map(ar, c);
+}
+
+} // namespace thallium
 
 #endif
@@ -6,6 +6,18 @@
 #ifndef __THALLIUM_UNORDERED_SET_SERIALIZATION_HPP
 #define __THALLIUM_UNORDERED_SET_SERIALIZATION_HPP
 
+#include <unordered_set>
 #include <cereal/types/unordered_set.hpp>
+#include <thallium/serialization/stl/associative_container.hpp>
+
+namespace thallium {
+
+template <class K, class H, class E, class A, class... CtxArg>
+inline void CEREAL_LOAD_FUNCTION_NAME(proc_input_archive<CtxArg...>& ar,
+                                      std::unordered_set<K, H, E, A>& c) {
+    detail::associative_container_loader<std::unordered_set<K, H, E, A>>::load_set(ar, c);
+}
+
+} // namespace thallium
 
 #endif
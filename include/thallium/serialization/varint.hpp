@@ -0,0 +1,139 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_VARINT_HPP
+#define __THALLIUM_VARINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace thallium {
+
+/**
+ * @brief Tag selecting the compact integer encoding when present in a
+ * serialization context: integers wider than one byte (and container
+ * sizes) are written as LEB128 varints, zigzag-encoded for signed
+ * types, so that small values take one or two bytes instead of their
+ * full width. Both sides of an RPC must use the same encoding.
+ *
+ * \code{.cpp}
+ * // client
+ * auto resp = rpc.on(ep).with_serialization_context(tl::varint_encoding{})(ids);
+ * auto n = resp.with_serialization_context(tl::varint_encoding{}).as<std::size_t>();
+ * // server: the handler's request type selects the encoding of the
+ * // arguments and of the response
+ * engine.define("index", [](const tl::request_with_context<tl::varint_encoding>& req,
+ *                           const std::vector<uint64_t>& ids) { req.respond(ids.size()); });
+ * \endcode
+ */
+struct varint_encoding {};
+
+namespace detail {
+
+template <typename Tag, typename... CtxArg> struct context_has;
+
+template <typename Tag> struct context_has<Tag> : std::false_type {};
+
+template <typename Tag, typename C1, typename... Cn>
+struct context_has<Tag, C1, Cn...>
+: std::integral_constant<bool,
+    std::is_same<typename std::decay<C1>::type, Tag>::value
+    || context_has<Tag, Cn...>::value> {};
+
+/**
+ * @private
+ * @brief Whether values of type T are varint-encoded by archives with
+ * the provided serialization context.
+ */
+template <typename T, typename... CtxArg>
+struct uses_varint
+: std::integral_constant<bool,
+    std::is_integral<T>::value && (sizeof(T) > 1)
+    && context_has<varint_encoding, CtxArg...>::value> {};
+
+template <typename T>
+inline typename std::enable_if<std::is_unsigned<T>::value, std::uint64_t>::type
+zigzag_encode(T v) noexcept {
+    return static_cast<std::uint64_t>(v);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_signed<T>::value, std::uint64_t>::type
+zigzag_encode(T v) noexcept {
+    auto x = static_cast<std::int64_t>(v);
+    return (static_cast<std::uint64_t>(x) << 1) ^ static_cast<std::uint64_t>(x >> 63);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_unsigned<T>::value, T>::type
+zigzag_decode(std::uint64_t v) noexcept {
+    return static_cast<T>(v);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_signed<T>::value, T>::type
+zigzag_decode(std::uint64_t v) noexcept {
+    return static_cast<T>(static_cast<std::int64_t>((v >> 1) ^ (~(v & 1) + 1)));
+}
+
+/**
+ * @private
+ * @brief Maximum number of bytes of a varint.
+ */
+constexpr std::size_t varint_max_size = 10;
+
+inline std::size_t varint_size(std::uint64_t v) noexcept {
+    std::size_t n = 1;
+    while(v >= 0x80) {
+        v >>= 7;
+        n += 1;
+    }
+    return n;
+}
+
+/**
+ * @private
+ * @brief Writes v into buf (which must have varint_max_size bytes
+ * available) and returns the number of bytes written.
+ */
+inline std::size_t varint_encode(std::uint64_t v, unsigned char* buf) noexcept {
+    std::size_t n = 0;
+    while(v >= 0x80) {
+        buf[n++] = static_cast<unsigned char>(v | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = static_cast<unsigned char>(v);
+    return n;
+}
+
+/**
+ * @private
+ * @brief Reads a varint from [buf, end), returns the number of bytes
+ * read, or 0 if the buffer ends before the varint or the varint is
+ * longer than varint_max_size.
+ */
+inline std::size_t varint_decode(const unsigned char* buf, const unsigned char* end,
+                                 std::uint64_t& v) noexcept {
+    std::uint64_t result = 0;
+    unsigned      shift  = 0;
+    std::size_t   n      = 0;
+    while(buf + n < end && n < varint_max_size) {
+        unsigned char b = buf[n++];
+        result |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+        if(!(b & 0x80)) {
+            v = result;
+            return n;
+        }
+        shift += 7;
+    }
+    return 0;
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
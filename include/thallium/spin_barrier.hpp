@@ -0,0 +1,186 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_SPIN_BARRIER_HPP
+#define __THALLIUM_SPIN_BARRIER_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thallium/adaptive_mutex.hpp>
+#include <thallium/exception.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Called by a waiter spinning on a barrier: pauses the CPU for
+ * the first iterations, then yields if the caller is a ULT so that the
+ * ULTs it waits for can run on the same execution stream.
+ */
+inline void barrier_backoff(int& iteration) noexcept {
+    iteration += 1;
+    if(iteration < 128) {
+        cpu_relax();
+        return;
+    }
+    ABT_unit_type type = ABT_UNIT_TYPE_EXT;
+    if(ABT_self_get_type(&type) == ABT_SUCCESS && type == ABT_UNIT_TYPE_THREAD)
+        ABT_thread_yield();
+    else
+        cpu_relax();
+}
+
+} // namespace detail
+
+/**
+ * @brief A spin_barrier is a sense-reversing barrier: waiters decrement
+ * a counter and spin on a generation number (read once per wait, so no
+ * waiter-local sense is needed) that the last one to arrive increments.
+ * It has the interface of barrier and xstream_barrier, and works from
+ * ULTs and execution streams alike, without going through the Argobots
+ * scheduler when the waiters arrive close together.
+ *
+ * All the waiters spin on the same cache line, which is fine up to a
+ * few tens of waiters; dissemination_barrier scales further.
+ */
+class spin_barrier {
+
+    const std::uint32_t        m_num_waiters;
+    alignas(64) std::atomic<std::uint32_t> m_remaining;
+    alignas(64) std::atomic<std::uint64_t> m_generation{0};
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param num_waiters Number of waiters.
+     */
+    explicit spin_barrier(std::uint32_t num_waiters)
+    : m_num_waiters(num_waiters ? num_waiters : 1)
+    , m_remaining(m_num_waiters) {}
+
+    spin_barrier(const spin_barrier&)            = delete;
+    spin_barrier& operator=(const spin_barrier&) = delete;
+
+    /**
+     * @brief Waits on the barrier.
+     */
+    void wait() {
+        std::uint64_t generation = m_generation.load(std::memory_order_acquire);
+        if(m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_remaining.store(m_num_waiters, std::memory_order_relaxed);
+            m_generation.store(generation + 1, std::memory_order_release);
+            return;
+        }
+        int iteration = 0;
+        while(m_generation.load(std::memory_order_acquire) == generation)
+            detail::barrier_backoff(iteration);
+    }
+
+    /**
+     * @brief Returns the number of waiters.
+     */
+    std::uint32_t get_num_waiters() const {
+        return m_num_waiters;
+    }
+};
+
+/**
+ * @brief A dissemination_barrier synchronizes N participants in
+ * ceil(log2(N)) rounds: in round k, participant i signals participant
+ * (i + 2^k) mod N and waits for the signal of (i - 2^k) mod N. Each
+ * flag has a single writer and a single reader and sits on its own
+ * cache line, so there is no shared counter to contend on, which makes
+ * it the barrier of choice for many execution streams synchronizing
+ * often.
+ *
+ * Participants are numbered from 0 to N-1: wait(i) waits as participant
+ * i, and wait() as the participant given by the rank of the calling
+ * execution stream, for the common case of one waiter per execution
+ * stream with ranks 0 to N-1. Each participant must wait exactly once
+ * per episode.
+ */
+class dissemination_barrier {
+
+    struct flag {
+        std::atomic<std::uint64_t> value{0};
+        char                       padding[64 - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    struct participant {
+        std::uint64_t episode = 0;
+        char          padding[64 - sizeof(std::uint64_t)];
+    };
+
+    std::size_t                    m_num_waiters;
+    std::size_t                    m_rounds = 0;
+    std::unique_ptr<flag[]>        m_flags;        // m_rounds flags per participant
+    std::unique_ptr<participant[]> m_participants;
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param num_waiters Number of participants.
+     */
+    explicit dissemination_barrier(std::uint32_t num_waiters)
+    : m_num_waiters(num_waiters ? num_waiters : 1) {
+        while((std::size_t(1) << m_rounds) < m_num_waiters) m_rounds += 1;
+        m_flags.reset(new flag[m_num_waiters * (m_rounds ? m_rounds : 1)]);
+        m_participants.reset(new participant[m_num_waiters]);
+    }
+
+    dissemination_barrier(const dissemination_barrier&)            = delete;
+    dissemination_barrier& operator=(const dissemination_barrier&) = delete;
+
+    /**
+     * @brief Waits on the barrier as participant i.
+     */
+    void wait(std::size_t i) {
+        if(i >= m_num_waiters)
+            throw exception("dissemination_barrier: invalid participant ", i);
+        // flags hold the last episode they were signaled for, so a
+        // participant already in the next episode cannot be mistaken
+        // for one in the current episode
+        std::uint64_t episode = ++m_participants[i].episode;
+        for(std::size_t k = 0; k < m_rounds; k++) {
+            std::size_t partner = (i + (std::size_t(1) << k)) % m_num_waiters;
+            m_flags[partner * m_rounds + k].value.store(episode, std::memory_order_release);
+            auto& mine      = m_flags[i * m_rounds + k].value;
+            int   iteration = 0;
+            while(mine.load(std::memory_order_acquire) < episode)
+                detail::barrier_backoff(iteration);
+        }
+    }
+
+    /**
+     * @brief Waits on the barrier as the participant given by the rank
+     * of the calling execution stream.
+     */
+    void wait() {
+        int rank = -1;
+        if(ABT_self_get_xstream_rank(&rank) != ABT_SUCCESS || rank < 0)
+            throw exception("dissemination_barrier::wait() called outside of an execution stream");
+        wait(static_cast<std::size_t>(rank));
+    }
+
+    /**
+     * @brief Returns the number of participants.
+     */
+    std::uint32_t get_num_waiters() const {
+        return static_cast<std::uint32_t>(m_num_waiters);
+    }
+};
+
+} // namespace thallium
+
+#endif
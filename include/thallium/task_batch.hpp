@@ -0,0 +1,149 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_TASK_BATCH_HPP
+#define __THALLIUM_TASK_BATCH_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thallium/abt_errors.hpp>
+#include <thallium/exception.hpp>
+
+namespace thallium {
+
+class pool;
+
+/**
+ * @brief A task_batch is returned by pool::make_tasks and allows waiting
+ * for all the tasks of the batch at once. The function run by the tasks
+ * and the per-task arguments are allocated once for the whole batch,
+ * and the tasks are anonymous, so no per-task handle has to be joined
+ * and freed.
+ *
+ * The destructor waits for the tasks to complete.
+ */
+class task_batch {
+
+    friend class pool;
+
+    struct state;
+
+    struct piece {
+        state*      m_state;
+        std::size_t m_begin;
+        std::size_t m_end;
+    };
+
+    struct state {
+        std::function<void(std::size_t)> m_body;
+        std::unique_ptr<piece[]>         m_pieces;
+        std::size_t                      m_num_pieces = 0;
+        std::atomic<std::size_t>         m_remaining{0};
+        ABT_eventual                     m_eventual = ABT_EVENTUAL_NULL;
+        std::mutex                       m_error_mutex;
+        std::exception_ptr               m_error;
+
+        state() {
+            int ret = ABT_eventual_create(0, &m_eventual);
+            if(ret != ABT_SUCCESS)
+                throw exception("ABT_eventual_create returned ", abt_error_get_name(ret),
+                                " in ", __FILE__, ":", __LINE__);
+        }
+
+        ~state() {
+            ABT_eventual_free(&m_eventual);
+        }
+
+        // called when a piece is done or could not be submitted
+        void complete(std::size_t n) {
+            if(m_remaining.fetch_sub(n, std::memory_order_acq_rel) == n)
+                ABT_eventual_set(m_eventual, nullptr, 0);
+        }
+    };
+
+    static void run_piece(void* arg) {
+        auto p = static_cast<piece*>(arg);
+        auto s = p->m_state;
+        try {
+            for(std::size_t i = p->m_begin; i < p->m_end; i++) s->m_body(i);
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(s->m_error_mutex);
+            if(!s->m_error) s->m_error = std::current_exception();
+        }
+        s->complete(1);
+    }
+
+    std::unique_ptr<state> m_state;
+
+    void wait_noexcept() {
+        if(m_state) ABT_eventual_wait(m_state->m_eventual, nullptr);
+    }
+
+  public:
+
+    /**
+     * @brief Creates an empty batch.
+     */
+    task_batch() = default;
+
+    task_batch(const task_batch&)            = delete;
+    task_batch& operator=(const task_batch&) = delete;
+
+    task_batch(task_batch&&) = default;
+
+    task_batch& operator=(task_batch&& other) {
+        if(&other == this) return *this;
+        wait_noexcept();
+        m_state = std::move(other.m_state);
+        return *this;
+    }
+
+    /**
+     * @brief Destructor. Waits for the tasks of the batch to complete.
+     */
+    ~task_batch() {
+        wait_noexcept();
+    }
+
+    /**
+     * @brief Returns the number of tasks of the batch.
+     */
+    std::size_t size() const {
+        return m_state ? m_state->m_num_pieces : 0;
+    }
+
+    /**
+     * @brief Returns true if all the tasks have completed.
+     */
+    bool test() const {
+        if(!m_state) return true;
+        return m_state->m_remaining.load(std::memory_order_acquire) == 0;
+    }
+
+    /**
+     * @brief Blocks until all the tasks have completed. If any of them
+     * threw an exception, the first one is rethrown.
+     */
+    void wait() {
+        if(!m_state) return;
+        wait_noexcept();
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(m_state->m_error_mutex);
+            std::swap(error, m_state->m_error);
+        }
+        if(error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace thallium
+
+#endif
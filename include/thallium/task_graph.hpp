@@ -0,0 +1,242 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_TASK_GRAPH_HPP
+#define __THALLIUM_TASK_GRAPH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <thallium/anonymous.hpp>
+#include <thallium/eventual.hpp>
+#include <thallium/exception.hpp>
+#include <thallium/pool.hpp>
+
+namespace thallium {
+
+/**
+ * @brief A task_graph runs a set of callables (nodes) with dependencies
+ * (edges) between them: each node is pushed into its pool as soon as
+ * all the nodes it depends on have completed, so independent branches
+ * run concurrently without the caller having to join them in a fixed
+ * order.
+ *
+ * \code{.cpp}
+ * tl::task_graph g;
+ * auto meta   = g.add([&] { m = get_meta.on(ep)(key).as<meta_t>(); }, pool);
+ * auto data   = g.add_async([&] { return remote.on(ep) >> local; }, pool);
+ * auto verify = g.add([&] { check(m, buffer); }, pool, {meta, data});
+ * auto r1     = g.add([&] { put.on(replica1)(key, buffer); }, pool, {verify});
+ * auto r2     = g.add([&] { put.on(replica2)(key, buffer); }, pool, {verify});
+ * g.add([&] { req.respond(0); }, pool, {r1, r2});
+ * g.run();
+ * \endcode
+ *
+ * Nodes run as anonymous ULTs, so they may block (e.g. send RPCs or
+ * wait for bulk transfers); nodes added with add_tasklet run as
+ * tasklets, which is cheaper but requires them not to block. If a node
+ * throws, the nodes depending on it (directly or not) are skipped, the
+ * other ones still run, and run() rethrows the first exception.
+ *
+ * The graph must not be modified, nor destroyed, while it runs. It can
+ * be run again once a run completed.
+ */
+class task_graph {
+
+  public:
+
+    using node_id = std::size_t;
+
+  private:
+
+    struct node {
+        std::function<void()> fn;
+        pool                  where;
+        bool                  tasklet = false;
+        std::vector<node_id>  successors;
+        std::size_t           num_deps = 0;
+    };
+
+    struct run_state {
+        const task_graph*                             graph;
+        std::unique_ptr<std::atomic<std::size_t>[]>   pending;
+        std::unique_ptr<std::atomic<bool>[]>          skipped;
+        std::atomic<std::size_t>                      remaining{0};
+        std::mutex                                    error_mutex;
+        std::exception_ptr                            error;
+        std::shared_ptr<detail::eventual_state<void>> done;
+    };
+
+    std::vector<node> m_nodes;
+
+    static void launch(const std::shared_ptr<run_state>& s, node_id i) {
+        const node& n = s->graph->m_nodes[i];
+        if(s->skipped[i]) {
+            finish(s, i, true);
+            return;
+        }
+        auto body = [s, i]() {
+            bool failed = false;
+            try {
+                s->graph->m_nodes[i].fn();
+            } catch(...) {
+                failed = true;
+                std::lock_guard<std::mutex> lock(s->error_mutex);
+                if(!s->error) s->error = std::current_exception();
+            }
+            finish(s, i, failed);
+        };
+        if(n.tasklet) n.where.make_task(std::move(body), anonymous());
+        else n.where.make_thread(std::move(body), anonymous());
+    }
+
+    static void finish(const std::shared_ptr<run_state>& s, node_id i, bool failed) {
+        for(node_id next : s->graph->m_nodes[i].successors) {
+            if(failed) s->skipped[next] = true;
+            if(s->pending[next].fetch_sub(1) == 1) launch(s, next);
+        }
+        if(s->remaining.fetch_sub(1) == 1) {
+            s->done->complete([]() {}, s->error);
+        }
+    }
+
+    void check_acyclic() const {
+        std::vector<std::size_t> deps(m_nodes.size());
+        std::vector<node_id>     ready;
+        for(node_id i = 0; i < m_nodes.size(); i++) {
+            deps[i] = m_nodes[i].num_deps;
+            if(deps[i] == 0) ready.push_back(i);
+        }
+        std::size_t visited = 0;
+        while(!ready.empty()) {
+            node_id i = ready.back();
+            ready.pop_back();
+            visited += 1;
+            for(node_id next : m_nodes[i].successors)
+                if(--deps[next] == 0) ready.push_back(next);
+        }
+        if(visited != m_nodes.size())
+            throw exception("task_graph: the dependencies contain a cycle");
+    }
+
+  public:
+
+    /**
+     * @brief Adds a node running f as a ULT in pool p.
+     *
+     * @param f Callable to run.
+     * @param p Pool in which to run it.
+     * @param deps Nodes that must complete before f runs.
+     *
+     * @return the id of the node.
+     */
+    template <typename F>
+    node_id add(F&& f, const pool& p, std::initializer_list<node_id> deps = {}) {
+        return add_node(std::function<void()>(std::forward<F>(f)), p, false, deps);
+    }
+
+    /**
+     * @brief Same as add, but runs f as a tasklet, which must not block.
+     */
+    template <typename F>
+    node_id add_tasklet(F&& f, const pool& p, std::initializer_list<node_id> deps = {}) {
+        return add_node(std::function<void()>(std::forward<F>(f)), p, true, deps);
+    }
+
+    /**
+     * @brief Adds a node that starts an asynchronous operation and
+     * completes when it does: start is called in a ULT of pool p and
+     * must return an object with a wait() method (e.g. an async_response
+     * or an async_bulk_op), which is then waited on.
+     */
+    template <typename F>
+    node_id add_async(F&& start, const pool& p, std::initializer_list<node_id> deps = {}) {
+        typename std::decay<F>::type fn(std::forward<F>(start));
+        return add([fn]() mutable { fn().wait(); }, p, deps);
+    }
+
+    /**
+     * @brief Makes node \p to depend on node \p from.
+     */
+    void add_edge(node_id from, node_id to) {
+        if(from >= m_nodes.size() || to >= m_nodes.size())
+            throw exception("task_graph: invalid node id");
+        m_nodes[from].successors.push_back(to);
+        m_nodes[to].num_deps += 1;
+    }
+
+    /**
+     * @brief Number of nodes.
+     */
+    std::size_t size() const {
+        return m_nodes.size();
+    }
+
+    /**
+     * @brief Starts running the graph and returns an eventual set when
+     * all the nodes have completed or been skipped (holding the first
+     * exception thrown by a node, if any).
+     */
+    eventual<void> run_async() const {
+        check_acyclic();
+        auto s     = std::make_shared<run_state>();
+        s->graph   = this;
+        s->pending.reset(new std::atomic<std::size_t>[m_nodes.size()]);
+        s->skipped.reset(new std::atomic<bool>[m_nodes.size()]);
+        s->remaining = m_nodes.size();
+        for(node_id i = 0; i < m_nodes.size(); i++) {
+            s->pending[i] = m_nodes[i].num_deps;
+            s->skipped[i] = false;
+        }
+        eventual<void> done;
+        s->done = done.m_state;
+        if(m_nodes.empty()) {
+            done.set_value();
+            return done;
+        }
+        // the roots are collected first since launching them may run
+        // other nodes concurrently
+        std::vector<node_id> roots;
+        for(node_id i = 0; i < m_nodes.size(); i++)
+            if(m_nodes[i].num_deps == 0) roots.push_back(i);
+        for(node_id i : roots) launch(s, i);
+        return done;
+    }
+
+    /**
+     * @brief Runs the graph and blocks until all the nodes have
+     * completed or been skipped, rethrowing the first exception thrown
+     * by a node, if any.
+     */
+    void run() const {
+        run_async().wait();
+    }
+
+  private:
+
+    node_id add_node(std::function<void()> f, const pool& p, bool tasklet,
+                     std::initializer_list<node_id> deps) {
+        node n;
+        n.fn      = std::move(f);
+        n.where   = p;
+        n.tasklet = tasklet;
+        m_nodes.push_back(std::move(n));
+        node_id id = m_nodes.size() - 1;
+        for(node_id d : deps) add_edge(d, id);
+        return id;
+    }
+};
+
+} // namespace thallium
+
+#endif
@@ -13,6 +13,7 @@
 #include <thallium/anonymous.hpp>
 #include <thallium/exception.hpp>
 #include <thallium/managed.hpp>
+#include <thallium/resume.hpp>
 
 namespace thallium {
 
@@ -395,6 +396,11 @@ class thread {
         return flag == ABT_TRUE;
     }
 
+    /**
+     * @brief Returns the underlying ABT_thread handle.
+     */
+    ABT_thread native_handle() const { return m_thread; }
+
     /**
      * @brief Comparison operator for threads.
      *
@@ -523,6 +529,16 @@ class thread {
      */
     static void yield() { TL_THREAD_ASSERT(ABT_thread_yield()); }
 
+    /**
+     * @brief Moves the calling ULT to the provided pool: the ULT is
+     * migrated and yields, and returns from this call once a scheduler
+     * of the target pool runs it. Does nothing if the caller is already
+     * in this pool or is not a migratable ULT.
+     *
+     * @param p pool to move to.
+     */
+    static void migrate_self_to(const pool& p);
+
     /**
      * Yield the processor from the current running thread
      * to the specific thread. This function can be used for users
@@ -567,6 +583,10 @@ inline void thread::migrate_to(const pool& p) {
     ABT_thread_migrate_to_pool(m_thread, p.native_handle());
 }
 
+inline void thread::migrate_self_to(const pool& p) {
+    detail::resume_in(p.native_handle());
+}
+
 inline pool thread::get_last_pool() const {
     ABT_pool p;
     ABT_thread_get_last_pool(m_thread, &p);
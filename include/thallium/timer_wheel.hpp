@@ -0,0 +1,387 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_TIMER_WHEEL_HPP
+#define __THALLIUM_TIMER_WHEEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <margo.h>
+#include <margo-timer.h>
+#include <thallium/exception.hpp>
+#include <thallium/inplace_function.hpp>
+#include <thallium/per_instance.hpp>
+#include <thallium/tsc_clock.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Hierarchical timer wheel of a margo instance (see
+ * engine::schedule). Deadlines are rounded up to ticks of
+ * resolution_ms; level l has slots of 64^l ticks and holds the
+ * callbacks due within 64^(l+1) ticks, which are moved down a level
+ * when their slot comes up. A single margo timer, armed while callbacks
+ * are pending, advances the wheel once per tick and runs all the
+ * callbacks that expired since the previous one.
+ *
+ * Entries live in a slab of fixed-size chunks recycled through a free
+ * list, and callbacks are stored inline in them, so scheduling doesn't
+ * allocate once the slab is warm.
+ */
+class timer_wheel : public per_instance<timer_wheel> {
+
+  public:
+
+    using callback_type = inplace_function<void(), 6*sizeof(void*)>;
+
+    static constexpr double resolution_ms = 1.0;
+
+  private:
+
+    static constexpr unsigned      level_bits = 6;
+    static constexpr std::size_t   slots      = std::size_t(1) << level_bits;
+    static constexpr std::size_t   levels     = 4;
+    static constexpr std::uint64_t slot_mask  = slots - 1;
+    static constexpr std::uint64_t max_delta  = (std::uint64_t(1) << (level_bits * levels)) - 1;
+    static constexpr std::size_t   chunk_size = 256;
+
+    enum class entry_state : std::uint8_t { free, scheduled, firing };
+
+    struct slot_list;
+
+    struct entry {
+        entry*        prev       = nullptr;
+        entry*        next       = nullptr;
+        slot_list*    slot       = nullptr;
+        std::uint64_t expiry     = 0;
+        std::uint32_t index      = 0;
+        std::uint32_t generation = 0;
+        entry_state   state      = entry_state::free;
+        callback_type callback;
+    };
+
+    struct slot_list {
+        entry* head = nullptr;
+    };
+
+    margo_instance_id                        m_mid;
+    margo_timer_t                            m_timer = MARGO_TIMER_NULL;
+    std::mutex                               m_mutex;
+    std::vector<std::unique_ptr<entry[]>>    m_chunks;
+    entry*                                   m_free    = nullptr;
+    std::size_t                              m_pending = 0;
+    bool                                     m_armed   = false;
+    bool                                     m_stopped = false;
+    std::uint64_t                            m_start_ns;
+    std::uint64_t                            m_tick = 0; // last tick processed
+    slot_list                                m_wheel[levels][slots];
+
+    std::uint64_t current_tick() const {
+        std::uint64_t ns = tsc_clock::now_ns() - m_start_ns;
+        return static_cast<std::uint64_t>(ns / (resolution_ms * 1e6));
+    }
+
+    entry* allocate() {
+        if(!m_free) {
+            std::unique_ptr<entry[]> chunk(new entry[chunk_size]);
+            std::uint32_t base = static_cast<std::uint32_t>(m_chunks.size() * chunk_size);
+            for(std::size_t i = chunk_size; i-- > 0;) {
+                chunk[i].index = base + static_cast<std::uint32_t>(i);
+                chunk[i].next  = m_free;
+                m_free         = &chunk[i];
+            }
+            m_chunks.push_back(std::move(chunk));
+        }
+        entry* e = m_free;
+        m_free   = e->next;
+        e->prev  = e->next = nullptr;
+        return e;
+    }
+
+    void release(entry* e) {
+        e->callback   = nullptr;
+        e->state      = entry_state::free;
+        e->generation += 1;
+        e->prev       = nullptr;
+        e->slot       = nullptr;
+        e->next       = m_free;
+        m_free        = e;
+    }
+
+    entry* find(std::uint32_t index) {
+        std::size_t c = index / chunk_size;
+        if(c >= m_chunks.size()) return nullptr;
+        return &m_chunks[c][index % chunk_size];
+    }
+
+    static void link(slot_list& s, entry* e) {
+        e->slot = &s;
+        e->prev = nullptr;
+        e->next = s.head;
+        if(s.head) s.head->prev = e;
+        s.head = e;
+    }
+
+    static void unlink(entry* e) {
+        if(e->prev) e->prev->next = e->next;
+        else e->slot->head = e->next;
+        if(e->next) e->next->prev = e->prev;
+        e->prev = e->next = nullptr;
+        e->slot = nullptr;
+    }
+
+    slot_list& slot_of(std::uint64_t expiry) {
+        std::uint64_t delta = expiry > m_tick ? expiry - m_tick : 0;
+        if(delta > max_delta) expiry = m_tick + max_delta;
+        for(std::size_t l = 0; l < levels - 1; l++) {
+            if(delta < (std::uint64_t(1) << (level_bits * (l + 1))))
+                return m_wheel[l][(expiry >> (level_bits * l)) & slot_mask];
+        }
+        return m_wheel[levels - 1][(expiry >> (level_bits * (levels - 1))) & slot_mask];
+    }
+
+    void insert(entry* e) {
+        // due now or in the past: run at the next tick
+        if(e->expiry <= m_tick) e->expiry = m_tick + 1;
+        link(slot_of(e->expiry), e);
+    }
+
+    // moves the entries of a slot of a higher level down the wheel
+    void cascade(std::size_t level) {
+        slot_list& s = m_wheel[level][(m_tick >> (level_bits * level)) & slot_mask];
+        entry* e = s.head;
+        s.head   = nullptr;
+        while(e) {
+            entry* next = e->next;
+            insert(e);
+            e = next;
+        }
+    }
+
+    // advances the wheel to tick now, moving expired entries to list
+    void advance(std::uint64_t now, entry*& expired) {
+        while(m_tick < now) {
+            m_tick += 1;
+            for(std::size_t l = levels - 1; l > 0; l--) {
+                if((m_tick & ((std::uint64_t(1) << (level_bits * l)) - 1)) == 0)
+                    cascade(l);
+            }
+            slot_list& s = m_wheel[0][m_tick & slot_mask];
+            while(entry* e = s.head) {
+                s.head   = e->next;
+                e->state = entry_state::firing;
+                e->prev  = nullptr;
+                e->slot  = nullptr;
+                e->next  = expired;
+                expired  = e;
+                m_pending -= 1;
+            }
+        }
+    }
+
+    void arm() {
+        if(m_armed || m_stopped || m_pending == 0) return;
+        if(margo_timer_start(m_timer, resolution_ms) == 0) m_armed = true;
+    }
+
+    static void on_tick(void* arg) {
+        static_cast<timer_wheel*>(arg)->tick();
+    }
+
+    void tick() {
+        entry* expired = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_armed = false;
+            if(m_stopped) return;
+            advance(current_tick(), expired);
+        }
+        // expired was filled newest tick first: runs the callbacks
+        // in expiry order
+        entry* ordered = nullptr;
+        while(expired) {
+            entry* next   = expired->next;
+            expired->next = ordered;
+            ordered       = expired;
+            expired       = next;
+        }
+        for(entry* e = ordered; e;) {
+            entry* next = e->next;
+            try {
+                e->callback();
+            } catch(...) {}
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                release(e);
+            }
+            e = next;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        arm();
+    }
+
+  public:
+
+    explicit timer_wheel(margo_instance_id mid)
+    : m_mid(mid)
+    , m_start_ns(tsc_clock::now_ns()) {
+        if(margo_timer_create(mid, &timer_wheel::on_tick, this, &m_timer) != 0)
+            throw exception("Could not create the margo timer of the timer wheel");
+    }
+
+    ~timer_wheel() {
+        if(m_timer != MARGO_TIMER_NULL) margo_timer_destroy(m_timer);
+    }
+
+    timer_wheel(const timer_wheel&)            = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    /**
+     * @brief Schedules a callback delay_ms milliseconds from now and
+     * returns the index and generation of its entry.
+     */
+    std::pair<std::uint32_t, std::uint32_t> schedule(double delay_ms, callback_type&& cb) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_stopped)
+            throw exception("Callback scheduled on a finalized engine");
+        // the wheel may be behind if no tick ran recently
+        std::uint64_t now = current_tick();
+        if(m_pending == 0) m_tick = now;
+        double ticks = std::max(0.0, delay_ms) / resolution_ms;
+        entry* e     = allocate();
+        e->callback  = std::move(cb);
+        e->state     = entry_state::scheduled;
+        e->expiry    = now + static_cast<std::uint64_t>(ticks)
+                     + (ticks > static_cast<double>(static_cast<std::uint64_t>(ticks)) ? 1 : 0);
+        insert(e);
+        m_pending += 1;
+        arm();
+        return {e->index, e->generation};
+    }
+
+    /**
+     * @brief Cancels a callback. Returns false if it already ran (or
+     * is running) or was already cancelled.
+     */
+    bool cancel(std::uint32_t index, std::uint32_t generation) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry* e = find(index);
+        if(!e || e->generation != generation || e->state != entry_state::scheduled)
+            return false;
+        unlink(e);
+        m_pending -= 1;
+        release(e);
+        return true;
+    }
+
+    /**
+     * @brief Returns the number of callbacks waiting to run.
+     */
+    std::size_t pending() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pending;
+    }
+
+    /**
+     * @brief Drops the callbacks still scheduled and stops the timer
+     * (called before the margo instance is finalized).
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+            m_armed   = false;
+            for(auto& level : m_wheel) {
+                for(auto& s : level) {
+                    while(entry* e = s.head) {
+                        s.head = e->next;
+                        release(e);
+                    }
+                }
+            }
+            m_pending = 0;
+        }
+        // outside the lock: margo waits for a tick already running
+        margo_timer_cancel(m_timer);
+        margo_timer_destroy(m_timer);
+        m_timer = MARGO_TIMER_NULL;
+    }
+
+    static std::shared_ptr<timer_wheel> get(margo_instance_id mid) {
+        bool created = false;
+        auto w       = find_or_install(
+            mid, [mid]() { return std::make_shared<timer_wheel>(mid); }, created);
+        if(created)
+            margo_provider_push_prefinalize_callback(
+                mid, w.get(), &timer_wheel::on_finalize, mid);
+        return w;
+    }
+
+  private:
+
+    static void on_finalize(void* arg) {
+        auto w = uninstall(static_cast<margo_instance_id>(arg));
+        if(w) w->stop();
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Token returned by engine::schedule, used to cancel the
+ * callback. Tokens are cheap to copy; a token whose callback already
+ * ran or was cancelled is simply stale.
+ */
+class timer_token {
+
+    friend class engine;
+
+    std::shared_ptr<detail::timer_wheel> m_wheel;
+    std::uint32_t                        m_index      = 0;
+    std::uint32_t                        m_generation = 0;
+
+    timer_token(std::shared_ptr<detail::timer_wheel> wheel,
+                std::pair<std::uint32_t, std::uint32_t> entry)
+    : m_wheel(std::move(wheel))
+    , m_index(entry.first)
+    , m_generation(entry.second) {}
+
+  public:
+
+    timer_token() = default;
+
+    /**
+     * @brief Cancels the callback if it hasn't run yet.
+     *
+     * @return true if the callback was cancelled, false if it already
+     * ran, is running, or was already cancelled.
+     */
+    bool cancel() {
+        if(!m_wheel) return false;
+        bool cancelled = m_wheel->cancel(m_index, m_generation);
+        m_wheel.reset();
+        return cancelled;
+    }
+
+    /**
+     * @brief Returns whether the token refers to a callback (which may
+     * have run since).
+     */
+    explicit operator bool() const { return static_cast<bool>(m_wheel); }
+};
+
+} // namespace thallium
+
+#endif /* end of include guard */
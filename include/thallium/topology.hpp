@@ -0,0 +1,277 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_TOPOLOGY_HPP
+#define __THALLIUM_TOPOLOGY_HPP
+
+#include <abt.h>
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <thallium/exception.hpp>
+#include <thallium/managed.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/scheduler.hpp>
+#include <thallium/xstream.hpp>
+
+namespace thallium {
+
+/**
+ * @brief The topology class describes the NUMA nodes of the machine and
+ * the CPUs they contain, as found in /sys/devices/system/node, and
+ * helps creating execution streams bound to CPUs of given NUMA nodes.
+ * On systems without this information, all the CPUs are reported as
+ * belonging to a single node 0.
+ *
+ * Memory is generally placed on the NUMA node of the CPU that first
+ * touches it, and registering memory with engine::expose touches it.
+ * Hence a buffer created by a ULT running on an execution stream bound
+ * to a node is local to that node. A bulk_pool instead splits its slabs
+ * into one arena per node and serves each execution stream from the
+ * arena of its node (see xstream_numa_node).
+ *
+ * \code{.cpp}
+ * const auto& topo = tl::topology::get();
+ * auto pool = tl::pool::create(tl::pool::access::mpmc);
+ * // 4 handler xstreams on the node of the calling CPU
+ * auto ess = topo.create_xstreams(tl::topology::current_numa_node(), 4,
+ *                                 tl::scheduler::predef::basic_wait, *pool);
+ * \endcode
+ */
+class topology {
+
+    struct numa_node {
+        int              id;
+        std::vector<int> cpus;
+    };
+
+    std::vector<numa_node> m_nodes;
+    std::vector<int>       m_cpu_to_node; // indexed by CPU id, -1 if unknown
+
+    static std::vector<int> parse_cpulist(const std::string& list) {
+        // format: "0-3,8,10-11"
+        std::vector<int>  cpus;
+        std::stringstream ss(list);
+        std::string       item;
+        while(std::getline(ss, item, ',')) {
+            if(item.empty() || item == "\n") continue;
+            auto dash  = item.find('-');
+            int  first = std::atoi(item.substr(0, dash).c_str());
+            int  last  = dash == std::string::npos ? first
+                                                   : std::atoi(item.substr(dash + 1).c_str());
+            for(int c = first; c <= last; c++) cpus.push_back(c);
+        }
+        return cpus;
+    }
+
+    topology() {
+        const std::string root = "/sys/devices/system/node";
+        DIR* dir = opendir(root.c_str());
+        if(dir) {
+            while(struct dirent* e = readdir(dir)) {
+                std::string name = e->d_name;
+                if(name.compare(0, 4, "node") != 0 || name.size() == 4
+                || name.find_first_not_of("0123456789", 4) != std::string::npos)
+                    continue;
+                std::ifstream f(root + "/" + name + "/cpulist");
+                std::string   list;
+                if(!std::getline(f, list)) continue;
+                numa_node n;
+                n.id   = std::atoi(name.c_str() + 4);
+                n.cpus = parse_cpulist(list);
+                if(!n.cpus.empty()) m_nodes.push_back(std::move(n));
+            }
+            closedir(dir);
+        }
+        if(m_nodes.empty()) {
+            numa_node n;
+            n.id = 0;
+            long num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+            for(long c = 0; c < std::max(num_cpus, 1L); c++)
+                n.cpus.push_back(static_cast<int>(c));
+            m_nodes.push_back(std::move(n));
+        }
+        std::sort(m_nodes.begin(), m_nodes.end(),
+                  [](const numa_node& a, const numa_node& b) { return a.id < b.id; });
+        for(auto& n : m_nodes) {
+            for(int c : n.cpus) {
+                if(c >= static_cast<int>(m_cpu_to_node.size()))
+                    m_cpu_to_node.resize(c + 1, -1);
+                m_cpu_to_node[c] = n.id;
+            }
+        }
+    }
+
+    const numa_node& node(int id) const {
+        for(auto& n : m_nodes)
+            if(n.id == id) return n;
+        throw exception("Unknown NUMA node ", id);
+    }
+
+    // node shared by all the CPUs the calling OS thread may run on, or -1
+    int affinity_node() const {
+        std::vector<int> cpus;
+        ABT_xstream      es;
+        int              num = 0;
+        if(ABT_xstream_self(&es) == ABT_SUCCESS
+        && ABT_xstream_get_affinity(es, 0, nullptr, &num) == ABT_SUCCESS && num > 0) {
+            cpus.resize(num);
+            if(ABT_xstream_get_affinity(es, num, cpus.data(), &num) != ABT_SUCCESS)
+                cpus.clear();
+        }
+        if(cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if(sched_getaffinity(0, sizeof(set), &set) != 0) return -1;
+            for(int c = 0; c < CPU_SETSIZE; c++)
+                if(CPU_ISSET(c, &set)) cpus.push_back(c);
+        }
+        int node = -1;
+        for(int c : cpus) {
+            int n = numa_node_of(c);
+            if(n < 0 || (node >= 0 && n != node)) return -1;
+            node = n;
+        }
+        return node;
+    }
+
+  public:
+
+    topology(const topology&)            = delete;
+    topology& operator=(const topology&) = delete;
+
+    /**
+     * @brief Returns the topology of the machine, read the first time
+     * this function is called.
+     */
+    static const topology& get() {
+        static topology t;
+        return t;
+    }
+
+    /**
+     * @brief Returns the ids of the NUMA nodes, in increasing order.
+     */
+    std::vector<int> numa_nodes() const {
+        std::vector<int> ids;
+        for(auto& n : m_nodes) ids.push_back(n.id);
+        return ids;
+    }
+
+    /**
+     * @brief Returns the number of NUMA nodes.
+     */
+    std::size_t num_numa_nodes() const {
+        return m_nodes.size();
+    }
+
+    /**
+     * @brief Returns the CPUs of a NUMA node.
+     */
+    const std::vector<int>& cpus(int numa_node) const {
+        return node(numa_node).cpus;
+    }
+
+    /**
+     * @brief Returns the NUMA node of a CPU, or -1 if unknown.
+     */
+    int numa_node_of(int cpu) const {
+        if(cpu < 0 || cpu >= static_cast<int>(m_cpu_to_node.size())) return -1;
+        return m_cpu_to_node[cpu];
+    }
+
+    /**
+     * @brief Returns the CPU the caller is currently running on, or -1.
+     */
+    static int current_cpu() {
+        return sched_getcpu();
+    }
+
+    /**
+     * @brief Returns the NUMA node the caller is currently running on,
+     * or -1 if unknown. Unless the caller's execution stream is bound to
+     * CPUs of a single node, the result may change at any time.
+     */
+    static int current_numa_node() {
+        return get().numa_node_of(current_cpu());
+    }
+
+    /**
+     * @brief Returns the NUMA node of the calling execution stream: the
+     * node of its CPU affinity if all its CPUs belong to one node (e.g.
+     * execution streams created by create_xstreams or bound with bind),
+     * otherwise the node it is currently running on. The affinity is
+     * read the first time an execution stream calls this function, so
+     * later changes to it are not seen.
+     */
+    static int xstream_numa_node() {
+        static thread_local int node = -2;
+        if(node == -2) node = get().affinity_node();
+        return node >= 0 ? node : current_numa_node();
+    }
+
+    /**
+     * @brief Binds an execution stream to all the CPUs of a NUMA node.
+     */
+    void bind(xstream& es, int numa_node) const {
+        const auto& c = cpus(numa_node);
+        es.set_affinity(c.begin(), c.end());
+    }
+
+    /**
+     * @brief Creates an execution stream with a predefined scheduler
+     * over the provided pool, bound to a single CPU.
+     */
+    static managed<xstream> create_xstream(int cpu, scheduler::predef spd, const pool& p) {
+        auto es = xstream::create(spd, p);
+        es->set_cpubind(cpu);
+        return es;
+    }
+
+    /**
+     * @brief Creates count execution streams with a predefined scheduler
+     * over the provided pool, each bound to one CPU of the NUMA node,
+     * in a round-robin manner if count exceeds the number of CPUs.
+     *
+     * @param numa_node NUMA node.
+     * @param count Number of execution streams.
+     * @param spd Predefined scheduler type.
+     * @param p Pool used by the schedulers.
+     *
+     * @return the execution streams.
+     */
+    std::vector<managed<xstream>> create_xstreams(int numa_node, std::size_t count,
+                                                  scheduler::predef spd,
+                                                  const pool& p) const {
+        const auto& c = cpus(numa_node);
+        std::vector<managed<xstream>> result;
+        for(std::size_t i = 0; i < count; i++)
+            result.push_back(create_xstream(c[i % c.size()], spd, p));
+        return result;
+    }
+
+    /**
+     * @brief Creates an execution stream for each of the provided CPUs,
+     * bound to it, with a predefined scheduler over the provided pool.
+     */
+    static std::vector<managed<xstream>> create_xstreams(const std::vector<int>& cpus,
+                                                         scheduler::predef spd,
+                                                         const pool& p) {
+        std::vector<managed<xstream>> result;
+        for(int c : cpus) result.push_back(create_xstream(c, spd, p));
+        return result;
+    }
+};
+
+} // namespace thallium
+
+#endif
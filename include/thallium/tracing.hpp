@@ -0,0 +1,314 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_TRACING_HPP
+#define __THALLIUM_TRACING_HPP
+
+#include <abt.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <margo.h>
+#include <thallium/per_instance.hpp>
+#include <thallium/tsc_clock.hpp>
+
+namespace thallium {
+
+/**
+ * @brief Trace and span identifiers of the work being done by a ULT,
+ * propagated to the servers of the RPCs it sends (see
+ * remote_procedure::enable_tracing). A trace_id of 0 means no trace.
+ */
+struct trace_context {
+    std::uint64_t trace_id_high  = 0;
+    std::uint64_t trace_id_low   = 0;
+    std::uint64_t span_id        = 0;
+    std::uint64_t parent_span_id = 0; /*!< 0 for the root span of a trace */
+
+    /**
+     * @brief Returns whether this context belongs to a trace.
+     */
+    bool valid() const { return trace_id_high != 0 || trace_id_low != 0; }
+
+    /**
+     * @brief Returns a random, non-zero identifier.
+     */
+    static std::uint64_t new_id() {
+        static thread_local std::mt19937_64 rng([] {
+            std::random_device rd;
+            return (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+        }());
+        std::uint64_t id;
+        do id = rng(); while(id == 0);
+        return id;
+    }
+
+    /**
+     * @brief Returns the root span of a new trace.
+     */
+    static trace_context new_root() {
+        trace_context c;
+        c.trace_id_high = new_id();
+        c.trace_id_low  = new_id();
+        c.span_id       = new_id();
+        return c;
+    }
+
+    /**
+     * @brief Returns a new span of the same trace, child of this one.
+     */
+    trace_context child() const {
+        trace_context c;
+        c.trace_id_high  = trace_id_high;
+        c.trace_id_low   = trace_id_low;
+        c.span_id        = new_id();
+        c.parent_span_id = span_id;
+        return c;
+    }
+};
+
+/**
+ * @brief Span recorded for an RPC when span collection is enabled (see
+ * engine::enable_span_collection). Records are 64-byte PODs meant to be
+ * written out as they are, e.g. with fwrite(spans.data(), sizeof(span_record),
+ * spans.size(), file), and decoded offline.
+ */
+struct span_record {
+    enum kind_type : std::uint8_t {
+        client = 0, /*!< from forward/async to the response */
+        server = 1  /*!< handler of the RPC */
+    };
+
+    std::uint64_t trace_id_high  = 0;
+    std::uint64_t trace_id_low   = 0;
+    std::uint64_t span_id        = 0;
+    std::uint64_t parent_span_id = 0;
+    std::uint64_t start_ns       = 0; /*!< tsc_clock time */
+    std::uint64_t duration_ns    = 0;
+    std::uint64_t rpc_id         = 0;
+    std::uint8_t  kind           = client;
+    std::uint8_t  reserved[7]    = {0, 0, 0, 0, 0, 0, 0};
+};
+
+static_assert(sizeof(span_record) == 64, "span_record should be 64 bytes");
+
+/**
+ * @brief Returns the trace context of the calling ULT (invalid if none).
+ * Inside a handler of an RPC with tracing enabled, this is the span of
+ * the handler.
+ */
+trace_context current_trace();
+
+/**
+ * @brief Makes a trace context the current one of the calling ULT for
+ * its lifetime, e.g. to start a trace on a client before sending the
+ * RPCs that belong to it. RPCs sent without a current trace start a new
+ * one each.
+ *
+ * \code{.cpp}
+ * tl::trace_scope scope(tl::trace_context::new_root());
+ * put.on(router)(key, value);
+ * \endcode
+ */
+class trace_scope {
+
+    trace_context  m_context;
+    trace_context* m_previous = nullptr;
+    bool           m_active   = false;
+
+    static ABT_key key() {
+        static ABT_key k = [] {
+            ABT_key k = ABT_KEY_NULL;
+            ABT_key_create(nullptr, &k);
+            return k;
+        }();
+        return k;
+    }
+
+    static trace_context*& thread_current() {
+        static thread_local trace_context* c = nullptr;
+        return c;
+    }
+
+    friend trace_context current_trace();
+
+    // the context is a ULT-local value when called from a ULT, and a
+    // thread-local one otherwise (e.g. from a thread outside Argobots)
+    static bool in_ult() {
+        ABT_thread self = ABT_THREAD_NULL;
+        return ABT_self_get_thread(&self) == ABT_SUCCESS && self != ABT_THREAD_NULL;
+    }
+
+    static trace_context* get() {
+        void* p = nullptr;
+        if(in_ult() && ABT_key_get(key(), &p) == ABT_SUCCESS)
+            return static_cast<trace_context*>(p);
+        return thread_current();
+    }
+
+    static void set(trace_context* c) {
+        if(in_ult() && ABT_key_set(key(), c) == ABT_SUCCESS) return;
+        thread_current() = c;
+    }
+
+  public:
+
+    explicit trace_scope(const trace_context& c)
+    : m_context(c) {
+        if(!c.valid()) return;
+        m_previous = get();
+        set(&m_context);
+        m_active = true;
+    }
+
+    trace_scope(const trace_scope&)            = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+    ~trace_scope() {
+        if(m_active) set(m_previous);
+    }
+
+    /**
+     * @brief Returns the context made current by this scope.
+     */
+    const trace_context& context() const { return m_context; }
+};
+
+inline trace_context current_trace() {
+    trace_context* c = trace_scope::get();
+    return c ? *c : trace_context();
+}
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Bounded buffer of the spans recorded for a margo instance,
+ * drained by engine::collect_spans. Spans recorded while it is full
+ * are dropped.
+ */
+class span_collector : public per_instance<span_collector> {
+
+    std::mutex               m_mutex;
+    std::vector<span_record> m_spans;
+    std::size_t              m_capacity;
+    std::atomic<std::uint64_t> m_dropped{0};
+
+  public:
+
+    explicit span_collector(std::size_t capacity)
+    : m_capacity(capacity) {}
+
+    /**
+     * @brief Starts collecting spans with a given capacity, or stops if
+     * capacity is 0.
+     */
+    static void install(margo_instance_id mid, std::size_t capacity) {
+        if(capacity == 0) {
+            auto c = uninstall(mid);
+            if(c) margo_provider_pop_finalize_callback(mid, c.get());
+            return;
+        }
+        bool created = false;
+        auto c       = find_or_install(
+            mid, [capacity]() { return std::make_shared<span_collector>(capacity); }, created);
+        if(created) {
+            margo_provider_push_finalize_callback(mid, c.get(), &span_collector::release, mid);
+        } else {
+            std::lock_guard<std::mutex> lock(c->m_mutex);
+            c->m_capacity = capacity;
+        }
+    }
+
+    void record(const span_record& s) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_spans.size() >= m_capacity) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_spans.push_back(s);
+    }
+
+    std::vector<span_record> drain() {
+        std::vector<span_record> spans;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        spans.swap(m_spans);
+        return spans;
+    }
+
+    std::uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @private
+ * @brief Start of a span, recorded into the span collector of its margo
+ * instance (if any) by finish().
+ */
+struct span_start {
+    trace_context context;
+    std::uint64_t rpc_id   = 0;
+    std::uint64_t start_ns = 0;
+    std::uint8_t  kind     = span_record::client;
+
+    void begin(const trace_context& c, std::uint64_t id, std::uint8_t k) {
+        if(!c.valid()) return;
+        context  = c;
+        rpc_id   = id;
+        kind     = k;
+        start_ns = tsc_clock::now_ns();
+    }
+
+    void finish(margo_instance_id mid) {
+        if(start_ns == 0) return;
+        auto collector = span_collector::find(mid);
+        if(collector) {
+            span_record s;
+            s.trace_id_high  = context.trace_id_high;
+            s.trace_id_low   = context.trace_id_low;
+            s.span_id        = context.span_id;
+            s.parent_span_id = context.parent_span_id;
+            s.start_ns       = start_ns;
+            s.duration_ns    = tsc_clock::now_ns() - start_ns;
+            s.rpc_id         = rpc_id;
+            s.kind           = kind;
+            collector->record(s);
+        }
+        start_ns = 0;
+    }
+};
+
+/**
+ * @private
+ * @brief Records a span from its construction to its destruction.
+ */
+class span_scope {
+
+    margo_instance_id m_mid;
+    span_start        m_span;
+
+  public:
+
+    span_scope(margo_instance_id mid, const trace_context& c,
+               std::uint64_t rpc_id, std::uint8_t kind)
+    : m_mid(mid) {
+        m_span.begin(c, rpc_id, kind);
+    }
+
+    span_scope(const span_scope&)            = delete;
+    span_scope& operator=(const span_scope&) = delete;
+
+    ~span_scope() { m_span.finish(m_mid); }
+};
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef __THALLIUM_TSC_CLOCK_HPP
+#define __THALLIUM_TSC_CLOCK_HPP
+
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+namespace thallium {
+
+/**
+ * @brief Clock reading the CPU's cycle counter (the TSC on x86, the
+ * virtual counter on ARM), with the std::chrono clock interface.
+ * Reading it costs a few nanoseconds, doesn't allocate and doesn't
+ * require any object to be created, so it can be used from any ULT.
+ *
+ * The counter's frequency is calibrated against std::chrono::steady_clock
+ * the first time the clock is used (which takes about 2 milliseconds), and
+ * time points are expressed relative to the steady_clock's epoch. If the
+ * CPU has no invariant counter (one that runs at a constant rate and is
+ * synchronized across cores), steady_clock is used instead.
+ *
+ * \code{.cpp}
+ * auto start = tl::tsc_clock::now();
+ * ...
+ * auto elapsed = tl::tsc_clock::now() - start; // std::chrono::nanoseconds
+ * \endcode
+ */
+class tsc_clock {
+
+  public:
+
+    using rep        = std::int64_t;
+    using period     = std::nano;
+    using duration   = std::chrono::duration<rep, period>;
+    using time_point = std::chrono::time_point<tsc_clock>;
+
+    static constexpr bool is_steady = true;
+
+    /**
+     * @brief Returns the current time.
+     */
+    static time_point now() noexcept {
+        return time_point(duration(static_cast<rep>(now_ns())));
+    }
+
+    /**
+     * @brief Returns the current time in nanoseconds.
+     */
+    static std::uint64_t now_ns() noexcept {
+        const calibration& c = get_calibration();
+        if(!c.use_counter) return steady_ns();
+        return c.base_ns + to_ns(ticks() - c.base_ticks);
+    }
+
+    /**
+     * @brief Returns the raw value of the counter. Differences between
+     * values can be converted with to_ns.
+     */
+    static std::uint64_t ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        std::uint64_t v;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+        return v;
+#else
+        return steady_ns();
+#endif
+    }
+
+    /**
+     * @brief Converts a number of ticks into nanoseconds.
+     */
+    static std::uint64_t to_ns(std::uint64_t ticks) noexcept {
+        const calibration& c = get_calibration();
+        if(!c.use_counter) return ticks;
+        return static_cast<std::uint64_t>(static_cast<double>(ticks) * c.ns_per_tick);
+    }
+
+    /**
+     * @brief Returns the calibrated frequency of the counter, in Hz.
+     */
+    static double frequency() noexcept {
+        return 1e9 / get_calibration().ns_per_tick;
+    }
+
+    /**
+     * @brief Returns whether the cycle counter is used (rather than
+     * steady_clock).
+     */
+    static bool uses_counter() noexcept {
+        return get_calibration().use_counter;
+    }
+
+  private:
+
+    struct calibration {
+        bool          use_counter = false;
+        double        ns_per_tick = 1.0;
+        std::uint64_t base_ticks  = 0;
+        std::uint64_t base_ns     = 0;
+    };
+
+    static std::uint64_t steady_ns() noexcept {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static bool has_invariant_counter() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned eax, ebx, ecx, edx;
+        if(!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+            return false;
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        return (edx & (1u << 8)) != 0;
+#elif defined(__aarch64__)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // reads the counter and steady_clock at (nearly) the same time,
+    // taking the tightest of a few tries
+    static void sample(std::uint64_t& t, std::uint64_t& ns) noexcept {
+        std::uint64_t best = UINT64_MAX;
+        for(int i = 0; i < 8; i++) {
+            std::uint64_t t0 = ticks();
+            std::uint64_t n  = steady_ns();
+            std::uint64_t t1 = ticks();
+            if(t1 - t0 < best) {
+                best = t1 - t0;
+                t    = t0 + (t1 - t0) / 2;
+                ns   = n;
+            }
+        }
+    }
+
+    static calibration calibrate() noexcept {
+        calibration c;
+        if(!has_invariant_counter()) return c;
+        // spins for ~2ms and takes the ratio of the elapsed steady_clock
+        // nanoseconds to the elapsed ticks
+        std::uint64_t t0 = 0, n0 = 0, t1 = 0, n1 = 0;
+        sample(t0, n0);
+        do sample(t1, n1); while(n1 - n0 < 2000000);
+        if(t1 <= t0) return c;
+        c.use_counter = true;
+        c.ns_per_tick = static_cast<double>(n1 - n0) / static_cast<double>(t1 - t0);
+        c.base_ticks  = t1;
+        c.base_ns     = n1;
+        return c;
+    }
+
+    static const calibration& get_calibration() noexcept {
+        static const calibration c = calibrate();
+        return c;
+    }
+};
+
+} // namespace thallium
+
+#endif /* end of include guard */
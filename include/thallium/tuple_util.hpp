@@ -6,7 +6,10 @@
 #ifndef __THALLIUM_TUPLE_UTIL_HPP
 #define __THALLIUM_TUPLE_UTIL_HPP
 
+#include <cstddef>
+#include <functional>
 #include <tuple>
+#include <utility>
 
 namespace thallium {
 
@@ -38,6 +41,15 @@ template <> struct apply_f_to_t_impl<0> {
     }
 };
 
+/**
+ * @private
+ */
+template <typename... ArgsF, typename F, typename Tuple, std::size_t... I>
+decltype(auto) apply_f_to_fwd_t_impl(F&& f, Tuple& t, std::index_sequence<I...>) {
+    (void)t;
+    return std::forward<F>(f)(std::forward<ArgsF>(std::get<I>(t))...);
+}
+
 } // namespace detail
 
 /**
@@ -68,6 +80,27 @@ R apply_function_to_tuple(R (*f)(ArgsF...), std::tuple<ArgsT...>& t) {
     return apply_function_to_tuple(fun, t);
 }
 
+/**
+ * Applies a function to a tuple of arguments, forwarding each element t_i
+ * of the tuple as std::forward<ArgsF_i>(t_i). Elements for which ArgsF_i
+ * is a value type or an rvalue reference are moved into the function,
+ * while elements for which ArgsF_i is an lvalue reference are passed
+ * as lvalues. The tuple should be considered in a moved-from state
+ * after the call.
+ *
+ * \tparam ArgsF : declared types of the function's parameters.
+ * \param f : function to call on the tuple.
+ * \param t : tupe of arguments.
+ * \return the value returned by f.
+ */
+template <typename... ArgsF, typename F, typename... ArgsT>
+decltype(auto) apply_function_to_forwarded_tuple(F&& f, std::tuple<ArgsT...>& t) {
+    static_assert(sizeof...(ArgsF) == sizeof...(ArgsT),
+                  "Number of parameter types must match the tuple size");
+    return detail::apply_f_to_fwd_t_impl<ArgsF...>(
+        std::forward<F>(f), t, std::index_sequence_for<ArgsT...>());
+}
+
 } // namespace thallium
 
 #endif
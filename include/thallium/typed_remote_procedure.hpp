@@ -0,0 +1,286 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_TYPED_REMOTE_PROCEDURE_HPP
+#define __THALLIUM_TYPED_REMOTE_PROCEDURE_HPP
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <thallium/async_response.hpp>
+#include <thallium/callable_remote_procedure.hpp>
+#include <thallium/packed_data.hpp>
+#include <thallium/remote_procedure.hpp>
+
+namespace thallium {
+
+template <typename Signature> class remote_procedure_t;
+template <typename Signature> class callable_remote_procedure_t;
+template <typename R> class async_response_t;
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Converts the packed_data of a response into R.
+ */
+template <typename R> struct typed_result {
+    template <typename Packed> static R get(Packed&& data) {
+        return data.template as<R>();
+    }
+};
+
+template <> struct typed_result<void> {
+    template <typename Packed> static void get(Packed&&) {}
+};
+
+/**
+ * @private
+ * @brief Calls a typed handler and responds with its return value.
+ */
+template <typename R> struct typed_handler {
+    template <typename F, typename... A>
+    static void call(const F& f, const request& req, A&&... args) {
+        req.respond(f(req, std::forward<A>(args)...));
+    }
+};
+
+template <> struct typed_handler<void> {
+    template <typename F, typename... A>
+    static void call(const F& f, const request& req, A&&... args) {
+        f(req, std::forward<A>(args)...);
+        req.respond();
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief async_response_t<R> is the typed counterpart of
+ * async_response, returned by callable_remote_procedure_t::async.
+ */
+template <typename R> class async_response_t {
+
+    template <typename Signature> friend class callable_remote_procedure_t;
+
+    async_response m_response;
+
+    explicit async_response_t(async_response&& r)
+    : m_response(std::move(r)) {}
+
+  public:
+
+    async_response_t(async_response_t&&)            = default;
+    async_response_t& operator=(async_response_t&&) = default;
+
+    /**
+     * @brief Waits for the response and returns it as an R.
+     */
+    R wait() {
+        return detail::typed_result<R>::get(m_response.wait());
+    }
+
+    /**
+     * @brief Tests without blocking if the response has been received.
+     */
+    bool received() const {
+        return m_response.received();
+    }
+
+    /**
+     * @brief Returns the underlying (untyped) async_response.
+     */
+    async_response& untyped() {
+        return m_response;
+    }
+};
+
+/**
+ * @brief callable_remote_procedure_t<R(Args...)> is the typed
+ * counterpart of callable_remote_procedure, created by
+ * remote_procedure_t::on. Calling it serializes exactly the
+ * (decayed) Args of the signature, whatever the types of the
+ * expressions passed by the caller, and returns an R.
+ */
+template <typename R, typename... Args>
+class callable_remote_procedure_t<R(Args...)> {
+
+    template <typename Signature> friend class remote_procedure_t;
+
+    callable_remote_procedure m_callable;
+
+    explicit callable_remote_procedure_t(callable_remote_procedure&& c)
+    : m_callable(std::move(c)) {}
+
+  public:
+
+    callable_remote_procedure_t(callable_remote_procedure_t&&)            = default;
+    callable_remote_procedure_t& operator=(callable_remote_procedure_t&&) = default;
+
+    /**
+     * @brief Sends the RPC and waits for its response.
+     */
+    R operator()(const typename std::decay<Args>::type&... args) {
+        return detail::typed_result<R>::get(m_callable(args...));
+    }
+
+    /**
+     * @brief Same as operator() with a timeout, after which the request
+     * is cancelled and tl::timeout is thrown.
+     */
+    template <typename Rep, typename Period>
+    R timed(const std::chrono::duration<Rep, Period>& t,
+            const typename std::decay<Args>::type&... args) {
+        return detail::typed_result<R>::get(m_callable.timed(t, args...));
+    }
+
+    /**
+     * @brief Sends the RPC without blocking.
+     */
+    async_response_t<R> async(const typename std::decay<Args>::type&... args) {
+        return async_response_t<R>(m_callable.async(args...));
+    }
+
+    /**
+     * @brief Returns the underlying (untyped) callable_remote_procedure.
+     */
+    callable_remote_procedure& untyped() {
+        return m_callable;
+    }
+};
+
+/**
+ * @brief remote_procedure_t<R(Args...)> is a remote_procedure whose
+ * signature is known at compile time. It is returned by
+ * engine::define<R(Args...)>, on clients (with only a name) as well as
+ * on servers (with a handler returning R, whose return value is sent
+ * as the response), so that the arguments the client serializes and
+ * the type of the response are checked by the compiler against the
+ * signature rather than left to the caller.
+ *
+ * \code{.cpp}
+ * // server
+ * engine.define<int(int,int)>("sum",
+ *     [](const tl::request&, int x, int y) { return x + y; });
+ * // client
+ * auto sum = engine.define<int(int,int)>("sum");
+ * int z = sum.on(ep)(40, 2);
+ * \endcode
+ *
+ * Both sides must of course be compiled with the same signature; the
+ * untyped remote_procedure remains available through untyped().
+ */
+template <typename R, typename... Args>
+class remote_procedure_t<R(Args...)> {
+
+    remote_procedure m_rpc;
+
+  public:
+
+    remote_procedure_t() = default;
+
+    /**
+     * @brief Wraps an untyped remote_procedure.
+     */
+    explicit remote_procedure_t(remote_procedure rpc)
+    : m_rpc(std::move(rpc)) {}
+
+    /**
+     * @brief Associates the procedure with an endpoint.
+     */
+    callable_remote_procedure_t<R(Args...)> on(const endpoint& ep) const {
+        return callable_remote_procedure_t<R(Args...)>(m_rpc.on(ep));
+    }
+
+    /**
+     * @brief Associates the procedure with a provider_handle.
+     */
+    callable_remote_procedure_t<R(Args...)> on(const provider_handle& ph) const {
+        return callable_remote_procedure_t<R(Args...)>(m_rpc.on(ph));
+    }
+
+    /**
+     * @brief See remote_procedure::set_priority.
+     */
+    remote_procedure_t& set_priority(int priority) {
+        m_rpc.set_priority(priority);
+        return *this;
+    }
+
+    /**
+     * @brief See remote_procedure::set_execution.
+     */
+    remote_procedure_t& set_execution(const rpc_execution& execution) {
+        m_rpc.set_execution(execution);
+        return *this;
+    }
+
+    /**
+     * @brief Deregisters this RPC from the engine.
+     */
+    void deregister() {
+        m_rpc.deregister();
+    }
+
+    /**
+     * @brief Returns the ID of the RPC.
+     */
+    hg_id_t id() const {
+        return m_rpc.id();
+    }
+
+    /**
+     * @brief Returns the underlying (untyped) remote_procedure.
+     */
+    const remote_procedure& untyped() const {
+        return m_rpc;
+    }
+};
+
+} // namespace thallium
+
+#include <thallium/engine.hpp>
+#include <thallium/request.hpp>
+
+namespace thallium {
+
+template <typename Signature>
+typename std::enable_if<std::is_function<Signature>::value,
+                        remote_procedure_t<Signature>>::type
+engine::define(const std::string& name) {
+    return remote_procedure_t<Signature>(define(name));
+}
+
+namespace detail {
+
+template <typename Signature> struct typed_define;
+
+template <typename R, typename... Args> struct typed_define<R(Args...)> {
+    template <typename Func>
+    static std::function<void(const request&, Args...)> wrap(Func&& fun) {
+        return [fun=std::forward<Func>(fun)](const request& req, Args... args) {
+            typed_handler<R>::call(fun, req, std::forward<Args>(args)...);
+        };
+    }
+};
+
+} // namespace detail
+
+template <typename Signature, typename Func>
+typename std::enable_if<std::is_function<Signature>::value,
+                        remote_procedure_t<Signature>>::type
+engine::define(const std::string& name, Func&& fun,
+               uint16_t provider_id, const pool& p) {
+    return remote_procedure_t<Signature>(define(name,
+        detail::typed_define<Signature>::wrap(std::forward<Func>(fun)),
+        provider_id, p));
+}
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_ULT_LOCAL_HPP
+#define __THALLIUM_ULT_LOCAL_HPP
+
+#include <abt.h>
+#include <thallium/abt_errors.hpp>
+#include <thallium/exception.hpp>
+
+namespace thallium {
+
+/**
+ * @brief An ult_local<T> gives each ULT its own T, stored under an
+ * ABT_key: unlike a thread_local, the value follows the ULT when it
+ * migrates to another execution stream, and unlike a map indexed by
+ * ULT id, it is reached without a lock. The value is default-constructed
+ * by the first call to get() made by a ULT, and destroyed when the ULT
+ * is freed.
+ *
+ * \code{.cpp}
+ * static tl::ult_local<std::vector<char>> scratch;
+ * engine.define("put", [](const tl::request& req, const std::string& v) {
+ *     auto& buf = scratch.get();
+ *     ...
+ * });
+ * \endcode
+ *
+ * Values are only destroyed with their ULT if the ult_local still
+ * exists at that point, so ult_local objects should outlive the ULTs
+ * using them (e.g. be static). get() must be called from a ULT.
+ *
+ * @tparam T Type of the values, default-constructible.
+ */
+template <typename T> class ult_local {
+
+    ABT_key m_key = ABT_KEY_NULL;
+
+    static void destroy(void* value) {
+        delete static_cast<T*>(value);
+    }
+
+  public:
+
+    ult_local() {
+        int ret = ABT_key_create(destroy, &m_key);
+        if(ret != ABT_SUCCESS)
+            throw exception("ABT_key_create returned ", abt_error_get_name(ret));
+    }
+
+    ult_local(const ult_local&)            = delete;
+    ult_local& operator=(const ult_local&) = delete;
+
+    ~ult_local() {
+        ABT_key_free(&m_key);
+    }
+
+    /**
+     * @brief Returns the value of the calling ULT, or nullptr if it did
+     * not create one yet. The lookup is a single ABT_key_get.
+     */
+    T* get_if() const {
+        void* p = nullptr;
+        if(ABT_key_get(m_key, &p) != ABT_SUCCESS) return nullptr;
+        return static_cast<T*>(p);
+    }
+
+    /**
+     * @brief Returns the value of the calling ULT, creating it on the
+     * first call.
+     */
+    T& get() const {
+        T* value = get_if();
+        if(value) return *value;
+        value   = new T();
+        int ret = ABT_key_set(m_key, value);
+        if(ret != ABT_SUCCESS) {
+            delete value;
+            throw exception("ult_local::get() called outside of a ULT (ABT_key_set returned ",
+                            abt_error_get_name(ret), ")");
+        }
+        return *value;
+    }
+
+    /**
+     * @brief Destroys the value of the calling ULT, if any.
+     */
+    void reset() const {
+        T* value = get_if();
+        if(!value) return;
+        ABT_key_set(m_key, nullptr);
+        delete value;
+    }
+
+    T& operator*() const { return get(); }
+
+    T* operator->() const { return &get(); }
+};
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_UNIT_ALLOCATOR_HPP
+#define __THALLIUM_UNIT_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace thallium {
+
+/**
+ * @brief Allocator that pool::create<P, U> can use (as its Ualloc
+ * parameter) to allocate the units of custom pools, which are created
+ * and freed each time a ULT or task is created and completes.
+ *
+ * Freed units are kept in a free list local to the calling OS thread
+ * (i.e. execution stream), which serves the next allocations without
+ * synchronization. When the local list is empty it is refilled with
+ * up to half its capacity from a shared list, and when it is full half
+ * of it is moved to the shared list, so units freed on one execution
+ * stream and allocated on another circulate in batches. New memory is
+ * allocated by chunks of chunk_size units.
+ *
+ * Memory, once allocated, is never given back to the system.
+ *
+ * @tparam T Type of unit.
+ */
+template <typename T> class pooled_unit_allocator {
+
+    static constexpr std::size_t local_capacity = 256;
+    static constexpr std::size_t chunk_size     = 64;
+
+    union block {
+        block* next;
+        alignas(T) char storage[sizeof(T)];
+    };
+
+    struct shared_list {
+        std::mutex          mutex;
+        std::vector<block*> free;
+    };
+
+    static shared_list& shared() {
+        static shared_list* s = new shared_list; // never destroyed
+        return *s;
+    }
+
+    struct local_list {
+        std::vector<block*> free;
+
+        local_list() { free.reserve(local_capacity); }
+
+        ~local_list() {
+            auto& s = shared();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.free.insert(s.free.end(), free.begin(), free.end());
+        }
+    };
+
+    static local_list& local() {
+        static thread_local local_list l;
+        return l;
+    }
+
+  public:
+
+    using value_type = T;
+
+    template <typename U> struct rebind {
+        using other = pooled_unit_allocator<U>;
+    };
+
+    pooled_unit_allocator() noexcept = default;
+
+    template <typename U>
+    pooled_unit_allocator(const pooled_unit_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if(n != 1) return static_cast<T*>(::operator new(n*sizeof(T)));
+        auto& l = local();
+        if(l.free.empty()) {
+            auto& s = shared();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            std::size_t count = std::min(s.free.size(), local_capacity/2);
+            l.free.insert(l.free.end(), s.free.end() - count, s.free.end());
+            s.free.resize(s.free.size() - count);
+        }
+        if(l.free.empty()) {
+            block* chunk = new block[chunk_size];
+            for(std::size_t i = 0; i < chunk_size; i++)
+                l.free.push_back(&chunk[chunk_size - 1 - i]);
+        }
+        block* b = l.free.back();
+        l.free.pop_back();
+        return reinterpret_cast<T*>(b->storage);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if(n != 1) {
+            ::operator delete(p);
+            return;
+        }
+        auto& l = local();
+        auto  b = reinterpret_cast<block*>(p);
+        if(l.free.size() < local_capacity) {
+            l.free.push_back(b);
+            return;
+        }
+        auto& s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.free.insert(s.free.end(), l.free.begin() + local_capacity/2, l.free.end());
+        l.free.resize(local_capacity/2);
+        s.free.push_back(b);
+    }
+
+    template <typename U>
+    bool operator==(const pooled_unit_allocator<U>&) const noexcept { return true; }
+
+    template <typename U>
+    bool operator!=(const pooled_unit_allocator<U>&) const noexcept { return false; }
+};
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Hash map whose nodes come from a pooled_unit_allocator, for
+ * the maps of in-flight RPCs, to which an entry is added and removed
+ * for every RPC: once warmed up, they no longer allocate memory.
+ */
+template <typename K, typename V>
+using pooled_unordered_map =
+    std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                       pooled_unit_allocator<std::pair<const K, V>>>;
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,597 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_WORK_STEALING_POOL_HPP
+#define __THALLIUM_WORK_STEALING_POOL_HPP
+
+#include <abt.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <vector>
+#include <thallium/exception.hpp>
+#include <thallium/managed.hpp>
+#include <thallium/pool.hpp>
+#include <thallium/scheduler.hpp>
+#include <thallium/task.hpp>
+#include <thallium/thread.hpp>
+#include <thallium/unit_type.hpp>
+#include <thallium/xstream.hpp>
+
+namespace thallium {
+
+namespace detail {
+
+/**
+ * @private
+ * @brief Allocator whose memory, once allocated, is never given back
+ * to the system: freed objects are kept in a free list local to the
+ * calling OS thread, and in a shared list when the local one is full.
+ * Lock-free structures may therefore keep stale pointers to freed
+ * objects and safely read them.
+ */
+template <typename T> class type_stable_allocator {
+
+    static constexpr std::size_t local_capacity = 256;
+    static constexpr std::size_t chunk_size     = 64;
+
+    union block {
+        block* next;
+        alignas(T) char storage[sizeof(T)];
+    };
+
+    struct shared_list {
+        std::mutex          mutex;
+        std::vector<block*> free;
+    };
+
+    static shared_list& shared() {
+        static shared_list* s = new shared_list; // never destroyed
+        return *s;
+    }
+
+    struct local_list {
+        std::vector<block*> free;
+
+        local_list() { free.reserve(local_capacity); }
+
+        ~local_list() {
+            auto& s = shared();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.free.insert(s.free.end(), free.begin(), free.end());
+        }
+    };
+
+    static local_list& local() {
+        static thread_local local_list l;
+        return l;
+    }
+
+  public:
+
+    using value_type = T;
+
+    template <typename U> struct rebind {
+        using other = type_stable_allocator<U>;
+    };
+
+    type_stable_allocator() noexcept = default;
+
+    template <typename U>
+    type_stable_allocator(const type_stable_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if(n != 1) return static_cast<T*>(::operator new(n*sizeof(T)));
+        auto& l = local();
+        if(l.free.empty()) {
+            auto& s = shared();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            std::size_t count = std::min(s.free.size(), local_capacity/2);
+            l.free.insert(l.free.end(), s.free.end() - count, s.free.end());
+            s.free.resize(s.free.size() - count);
+        }
+        if(l.free.empty()) {
+            block* chunk = new block[chunk_size];
+            for(std::size_t i = 0; i < chunk_size; i++)
+                l.free.push_back(&chunk[chunk_size - 1 - i]);
+        }
+        block* b = l.free.back();
+        l.free.pop_back();
+        return reinterpret_cast<T*>(b->storage);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if(n != 1) {
+            ::operator delete(p);
+            return;
+        }
+        auto& l = local();
+        auto  b = reinterpret_cast<block*>(p);
+        if(l.free.size() < local_capacity) {
+            l.free.push_back(b);
+            return;
+        }
+        auto& s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.free.insert(s.free.end(), l.free.begin() + local_capacity/2, l.free.end());
+        l.free.resize(local_capacity/2);
+        s.free.push_back(b);
+    }
+
+    template <typename U>
+    bool operator==(const type_stable_allocator<U>&) const noexcept { return true; }
+
+    template <typename U>
+    bool operator!=(const type_stable_allocator<U>&) const noexcept { return false; }
+};
+
+} // namespace detail
+
+class work_stealing_pool;
+
+/**
+ * @brief Unit type of a work_stealing_pool.
+ */
+class work_stealing_unit {
+
+    friend class work_stealing_pool;
+
+    thread    m_thread;
+    task      m_task;
+    unit_type m_type;
+    // bit 0: queued, bits 1-16: id of the pool, bits 17-63: ticket
+    // of the push that queued the unit
+    std::atomic<std::uint64_t> m_state{0};
+
+  public:
+
+    work_stealing_unit(const thread& t)
+    : m_thread(t)
+    , m_type(unit_type::thread) {}
+
+    work_stealing_unit(const task& t)
+    : m_task(t)
+    , m_type(unit_type::task) {}
+
+    unit_type get_type() const {
+        return m_type;
+    }
+
+    const thread& get_thread() const {
+        return m_thread;
+    }
+
+    const task& get_task() const {
+        return m_task;
+    }
+
+    bool is_in_pool() const {
+        return m_state.load(std::memory_order_acquire) & 1;
+    }
+};
+
+/**
+ * @brief work_stealing_pool is a pool meant to be used with one pool per
+ * execution stream, each execution stream running a
+ * work_stealing_scheduler whose first pool is its own and whose other
+ * pools are the ones it steals from.
+ *
+ * Units pushed by the execution stream owning the pool (e.g. ULTs
+ * created by RPC handlers) go into a lock-free Chase-Lev deque that
+ * only the owner pushes to and pops from (LIFO), while other execution
+ * streams steal from its other end (FIFO). Units pushed from other
+ * execution streams (e.g. RPC handlers pushed by the progress loop) go
+ * into a mutex-protected inbox, which is consumed by the owner and by
+ * thieves alike.
+ *
+ * Such a pool can also be created with
+ * pool::create(access, pool::kind::work_stealing). When used by a
+ * scheduler that is not a work_stealing_scheduler, it has no owner and
+ * behaves as a FIFO pool.
+ */
+class work_stealing_pool {
+
+    struct cell {
+        std::atomic<work_stealing_unit*> unit{nullptr};
+        std::atomic<std::uint64_t>       ticket{0};
+    };
+
+    struct array {
+        std::int64_t            mask;
+        std::unique_ptr<cell[]> cells;
+
+        explicit array(std::int64_t size)
+        : mask(size - 1)
+        , cells(new cell[size]) {}
+
+        std::int64_t size() const { return mask + 1; }
+
+        void put(std::int64_t i, work_stealing_unit* u, std::uint64_t t) {
+            cells[i & mask].unit.store(u, std::memory_order_relaxed);
+            cells[i & mask].ticket.store(t, std::memory_order_relaxed);
+        }
+
+        void get(std::int64_t i, work_stealing_unit*& u, std::uint64_t& t) const {
+            u = cells[i & mask].unit.load(std::memory_order_relaxed);
+            t = cells[i & mask].ticket.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct entry {
+        work_stealing_unit* unit;
+        std::uint64_t       ticket;
+    };
+
+    static std::atomic<std::uint16_t>& next_id() {
+        static std::atomic<std::uint16_t> id{0};
+        return id;
+    }
+
+    // top and bottom are kept on separate cache lines, since thieves
+    // only write the former and the owner mostly writes the latter
+    std::atomic<std::int64_t>             m_top{0};
+    char                                  m_pad0[56];
+    std::atomic<std::int64_t>             m_bottom{0};
+    std::atomic<array*>                   m_array;
+    std::vector<std::unique_ptr<array>>   m_arrays; // current and retired arrays
+    char                                  m_pad1[64];
+    std::atomic<std::size_t>              m_size{0};
+    std::atomic<std::uint64_t>            m_next_ticket{1};
+    std::atomic<ABT_xstream>              m_owner{ABT_XSTREAM_NULL};
+    std::uint16_t                         m_id;
+    std::mutex                            m_inbox_mutex;
+    std::deque<entry>                     m_inbox;
+
+    std::uint64_t state_of(std::uint64_t ticket) const {
+        return (ticket << 17) | (static_cast<std::uint64_t>(m_id) << 1) | 1;
+    }
+
+    // a deque or inbox entry may be stale (the unit was removed from
+    // the pool and possibly pushed again since), so units are claimed
+    // by clearing the queued bit only if the entry's ticket is current
+    bool claim(work_stealing_unit* u, std::uint64_t ticket) {
+        std::uint64_t expected = state_of(ticket);
+        if(!u->m_state.compare_exchange_strong(expected, expected & ~std::uint64_t(1),
+                                               std::memory_order_acq_rel))
+            return false;
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool is_owner() const {
+        ABT_xstream self;
+        if(ABT_xstream_self(&self) != ABT_SUCCESS) return false;
+        return self == m_owner.load(std::memory_order_relaxed);
+    }
+
+    void deque_push(work_stealing_unit* u, std::uint64_t ticket) {
+        std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+        std::int64_t t = m_top.load(std::memory_order_acquire);
+        array*       a = m_array.load(std::memory_order_relaxed);
+        if(b - t > a->size() - 1) {
+            auto bigger = std::make_unique<array>(a->size()*2);
+            for(std::int64_t i = t; i < b; i++) {
+                work_stealing_unit* x;
+                std::uint64_t       xt;
+                a->get(i, x, xt);
+                bigger->put(i, x, xt);
+            }
+            a = bigger.get();
+            // thieves may still be reading the old array, so it is
+            // only freed with the pool
+            m_arrays.push_back(std::move(bigger));
+            m_array.store(a, std::memory_order_release);
+        }
+        a->put(b, u, ticket);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    bool deque_take(work_stealing_unit*& u, std::uint64_t& ticket) {
+        std::int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        array*       a = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = m_top.load(std::memory_order_relaxed);
+        if(t > b) {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        a->get(b, u, ticket);
+        if(t == b) {
+            // last element, race against thieves
+            bool won = m_top.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool deque_steal(work_stealing_unit*& u, std::uint64_t& ticket) {
+        std::int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = m_bottom.load(std::memory_order_acquire);
+        if(t >= b) return false;
+        array* a = m_array.load(std::memory_order_acquire);
+        a->get(t, u, ticket);
+        return m_top.compare_exchange_strong(t, t + 1,
+            std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    work_stealing_unit* pop_inbox(bool blocking) {
+        std::unique_lock<std::mutex> lock(m_inbox_mutex, std::defer_lock);
+        if(blocking) lock.lock();
+        else if(!lock.try_lock()) return nullptr;
+        while(!m_inbox.empty()) {
+            entry e = m_inbox.front();
+            m_inbox.pop_front();
+            if(claim(e.unit, e.ticket)) return e.unit;
+        }
+        return nullptr;
+    }
+
+  public:
+
+    static const pool::access access_type = pool::access::mpmc;
+
+    work_stealing_pool()
+    : m_id(next_id().fetch_add(1, std::memory_order_relaxed)) {
+        m_arrays.push_back(std::make_unique<array>(256));
+        m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    work_stealing_pool(const work_stealing_pool&)            = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    /**
+     * @brief Returns the work_stealing_pool implementing the provided pool,
+     * which must have been created as a work-stealing pool.
+     */
+    static work_stealing_pool* from(const pool& p) {
+        void* data = nullptr;
+        if(ABT_pool_get_data(p.native_handle(), &data) != ABT_SUCCESS)
+            return nullptr;
+        return static_cast<work_stealing_pool*>(data);
+    }
+
+    /**
+     * @brief Sets the execution stream that owns the pool's deque.
+     * Called by the work_stealing_scheduler using it as first pool.
+     */
+    void set_owner(ABT_xstream es) {
+        m_owner.store(es, std::memory_order_relaxed);
+    }
+
+    size_t get_size() const {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    void push(work_stealing_unit* u) {
+        std::uint64_t ticket = m_next_ticket.fetch_add(1, std::memory_order_relaxed);
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        u->m_state.store(state_of(ticket), std::memory_order_release);
+        if(is_owner()) {
+            deque_push(u, ticket);
+        } else {
+            std::lock_guard<std::mutex> lock(m_inbox_mutex);
+            m_inbox.push_back(entry{u, ticket});
+        }
+    }
+
+    work_stealing_unit* pop() {
+        if(!is_owner()) return steal(true);
+        work_stealing_unit* u;
+        std::uint64_t       ticket;
+        while(deque_take(u, ticket)) {
+            if(claim(u, ticket)) return u;
+        }
+        return pop_inbox(true);
+    }
+
+    /**
+     * @brief Takes a unit from the end of the deque opposite to the
+     * owner, or from the inbox. This function may be called from any
+     * execution stream.
+     *
+     * @param wait_for_inbox whether to wait for the inbox's mutex
+     * if another execution stream holds it.
+     */
+    work_stealing_unit* steal(bool wait_for_inbox = false) {
+        work_stealing_unit* u;
+        std::uint64_t       ticket;
+        while(deque_steal(u, ticket)) {
+            if(claim(u, ticket)) return u;
+        }
+        return pop_inbox(wait_for_inbox);
+    }
+
+    // the entry referencing a removed unit stays in the deque or
+    // inbox and is dropped when reached; units are allocated with a
+    // type_stable_allocator so that such entries never dangle
+    void remove(work_stealing_unit* u) {
+        std::uint64_t s = u->m_state.load(std::memory_order_acquire);
+        while((s & 1) && ((s >> 1) & 0xffff) == m_id) {
+            if(u->m_state.compare_exchange_weak(s, s & ~std::uint64_t(1),
+                                                std::memory_order_acq_rel)) {
+                m_size.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+};
+
+/**
+ * @brief Scheduler running units from its first pool and, when it is
+ * empty, stealing from its other pools, starting at a random victim.
+ * All its pools must be work_stealing_pool instances.
+ */
+class work_stealing_scheduler : private scheduler {
+
+    static constexpr unsigned event_freq = 64;
+
+  public:
+
+    template <typename... Args>
+    work_stealing_scheduler(Args&&... args)
+    : scheduler(std::forward<Args>(args)...) {}
+
+    void run() {
+        std::size_t                       n = num_pools();
+        std::vector<pool>                 pools;
+        std::vector<work_stealing_pool*>  impls;
+        for(std::size_t i = 0; i < n; i++) {
+            pools.push_back(get_pool(i));
+            impls.push_back(work_stealing_pool::from(pools.back()));
+        }
+        ABT_xstream self;
+        ABT_xstream_self(&self);
+        impls[0]->set_owner(self);
+        std::minstd_rand rng(static_cast<unsigned>(reinterpret_cast<std::uintptr_t>(this)));
+        unsigned count = 0;
+        while(true) {
+            bool ran = false;
+            work_stealing_unit* u = impls[0]->pop();
+            if(u) {
+                pools[0].run_unit(u);
+                ran = true;
+            } else if(n > 1) {
+                std::size_t start = 1 + rng() % (n - 1);
+                for(std::size_t i = 0; i < n - 1 && !ran; i++) {
+                    std::size_t v = 1 + (start - 1 + i) % (n - 1);
+                    u = impls[v]->steal();
+                    if(u) {
+                        pools[v].run_unit(u);
+                        ran = true;
+                    }
+                }
+            }
+            if(!ran || ++count >= event_freq) {
+                count = 0;
+                if(has_to_stop()) break;
+                xstream::check_events(*this);
+            }
+        }
+        impls[0]->set_owner(ABT_XSTREAM_NULL);
+    }
+
+    pool get_migr_pool() const {
+        return get_pool(0);
+    }
+};
+
+/**
+ * @brief Creates a set of execution streams, each with its own
+ * work_stealing_pool and a work_stealing_scheduler stealing from all
+ * the other pools. Any of the pools (typically the first one) can be
+ * used as a handler pool, e.g. given to engine's constructor or to
+ * engine::define; work pushed into it gets spread across all the
+ * execution streams.
+ *
+ * \code{.cpp}
+ * tl::work_stealing_xstreams handlers(8);
+ * tl::engine engine("na+sm", THALLIUM_SERVER_MODE,
+ *                   progress_pool, handlers.get_pool());
+ * ...
+ * engine.wait_for_finalize();
+ * handlers.join();
+ * \endcode
+ */
+class work_stealing_xstreams {
+
+    std::vector<managed<pool>>      m_pools;
+    std::vector<managed<scheduler>> m_scheds;
+    std::vector<managed<xstream>>   m_xstreams;
+    bool                            m_joined = false;
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param num_xstreams Number of execution streams to create.
+     */
+    explicit work_stealing_xstreams(std::size_t num_xstreams) {
+        if(num_xstreams == 0)
+            throw exception("work_stealing_xstreams requires at least one xstream");
+        for(std::size_t i = 0; i < num_xstreams; i++)
+            m_pools.push_back(pool::create<work_stealing_pool, work_stealing_unit,
+                std::allocator<work_stealing_pool>,
+                detail::type_stable_allocator<work_stealing_unit>>());
+        for(std::size_t i = 0; i < num_xstreams; i++) {
+            std::vector<pool> sched_pools;
+            for(std::size_t j = 0; j < num_xstreams; j++)
+                sched_pools.push_back(*m_pools[(i + j) % num_xstreams]);
+            m_scheds.push_back(scheduler::create<work_stealing_scheduler>(
+                sched_pools.begin(), sched_pools.end()));
+        }
+        for(auto& s : m_scheds)
+            m_xstreams.push_back(xstream::create(*s));
+    }
+
+    work_stealing_xstreams(const work_stealing_xstreams&)            = delete;
+    work_stealing_xstreams& operator=(const work_stealing_xstreams&) = delete;
+
+    /**
+     * @brief Destructor. Joins the execution streams if join() wasn't called.
+     */
+    ~work_stealing_xstreams() {
+        join();
+    }
+
+    /**
+     * @brief Returns the number of execution streams.
+     */
+    std::size_t size() const {
+        return m_xstreams.size();
+    }
+
+    /**
+     * @brief Returns the pool owned by the i-th execution stream.
+     */
+    pool get_pool(std::size_t i = 0) {
+        return *m_pools.at(i);
+    }
+
+    /**
+     * @brief Returns the i-th execution stream.
+     */
+    xstream get_xstream(std::size_t i) {
+        return *m_xstreams.at(i);
+    }
+
+    /**
+     * @brief Joins and destroys the execution streams, schedulers and
+     * pools. Must not be called while the pools are still used by an
+     * engine.
+     */
+    void join() {
+        if(m_joined) return;
+        m_joined = true;
+        for(auto& x : m_xstreams) x->join();
+        m_xstreams.clear();
+        m_scheds.clear();
+        m_pools.clear();
+    }
+};
+
+namespace detail {
+
+inline managed<pool> create_work_stealing_pool() {
+    return pool::create<work_stealing_pool, work_stealing_unit,
+                        std::allocator<work_stealing_pool>,
+                        type_stable_allocator<work_stealing_unit>>();
+}
+
+} // namespace detail
+
+} // namespace thallium
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __THALLIUM_XSTREAM_LOCAL_HPP
+#define __THALLIUM_XSTREAM_LOCAL_HPP
+
+#include <abt.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thallium/exception.hpp>
+
+namespace thallium {
+
+/**
+ * @brief An xstream_local<T> holds one T per execution stream, indexed
+ * by rank, each on its own cache lines so that execution streams
+ * updating their own slot (counters, free lists...) do not contend.
+ *
+ * \code{.cpp}
+ * tl::xstream_local<std::uint64_t> served(64);
+ * ... in a handler:
+ * served.local() += 1;
+ * ... when reporting:
+ * std::uint64_t total = 0;
+ * served.for_each([&](std::uint64_t n) { total += n; });
+ * \endcode
+ *
+ * local() returns the slot of the execution stream running the caller:
+ * a ULT that may migrate must not keep the reference across a yield
+ * point. Other execution streams may read a slot while its owner writes
+ * it (e.g. in for_each), so values read that way should be atomics or
+ * tolerate torn reads.
+ *
+ * @tparam T Type of the values, default-constructible.
+ */
+template <typename T> class xstream_local {
+
+    static constexpr std::size_t cache_line = 64;
+    static constexpr std::size_t stride =
+        (sizeof(T) + cache_line - 1) / cache_line * cache_line;
+
+    std::size_t             m_size;
+    std::unique_ptr<char[]> m_buffer;
+    char*                   m_slots = nullptr;
+
+    T* slot(std::size_t i) const {
+        return reinterpret_cast<T*>(m_slots + i * stride);
+    }
+
+  public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param max_xstreams Number of slots, which must exceed the largest
+     * rank of the execution streams calling local().
+     */
+    explicit xstream_local(std::size_t max_xstreams = 64)
+    : m_size(max_xstreams ? max_xstreams : 1)
+    , m_buffer(new char[m_size * stride + cache_line]) {
+        // the buffer is aligned by hand since new ignores over-alignment
+        // before C++17
+        auto addr = reinterpret_cast<std::uintptr_t>(m_buffer.get());
+        m_slots   = m_buffer.get() + (cache_line - addr % cache_line) % cache_line;
+        std::size_t i = 0;
+        try {
+            for(; i < m_size; i++) new(slot(i)) T();
+        } catch(...) {
+            while(i > 0) slot(--i)->~T();
+            throw;
+        }
+    }
+
+    xstream_local(const xstream_local&)            = delete;
+    xstream_local& operator=(const xstream_local&) = delete;
+
+    ~xstream_local() {
+        for(std::size_t i = 0; i < m_size; i++) slot(i)->~T();
+    }
+
+    /**
+     * @brief Returns the slot of the calling execution stream, or
+     * nullptr if the caller does not run in an execution stream or its
+     * rank has no slot.
+     */
+    T* local_if() const {
+        int rank;
+        if(ABT_self_get_xstream_rank(&rank) != ABT_SUCCESS
+        || rank < 0 || static_cast<std::size_t>(rank) >= m_size)
+            return nullptr;
+        return slot(static_cast<std::size_t>(rank));
+    }
+
+    /**
+     * @brief Returns the slot of the calling execution stream, throwing
+     * an exception if it has none (see local_if).
+     */
+    T& local() const {
+        T* value = local_if();
+        if(!value)
+            throw exception("xstream_local::local() called from an execution stream without a slot");
+        return *value;
+    }
+
+    /**
+     * @brief Number of slots.
+     */
+    std::size_t size() const {
+        return m_size;
+    }
+
+    T& operator[](std::size_t i) { return *slot(i); }
+
+    const T& operator[](std::size_t i) const { return *slot(i); }
+
+    /**
+     * @brief Calls f on the value of each slot, in rank order.
+     */
+    template <typename F> void for_each(F&& f) const {
+        for(std::size_t i = 0; i < m_size; i++) f(*slot(i));
+    }
+};
+
+} // namespace thallium
+
+#endif
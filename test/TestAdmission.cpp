@@ -0,0 +1,82 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+void WaitForInFlight(const tl::admission_limit& limit, std::size_t n) {
+    while(limit.in_flight() != n) tl::thread::yield();
+}
+
+bool IsBusy(const tl::remote_procedure& rpc, const tl::endpoint& self) {
+    try {
+        rpc.on(self)();
+    } catch(const tl::busy&) { return true; }
+    return false;
+}
+
+void RejectsAboveLimit(tl::engine& engine, const tl::endpoint& self) {
+    tl::eventual<void> gate;
+    tl::admission_limit limit(1);
+    auto slow = engine.define("slow", [&gate](const tl::request& req) {
+        gate.wait();
+        req.respond();
+    });
+    slow.set_admission(limit);
+    // the first request holds the only slot until the gate opens
+    auto first = slow.on(self).async();
+    WaitForInFlight(limit, 1);
+    assert(IsBusy(slow, self));
+    assert(!slow.on(self).try_call());
+    assert(limit.rejected() == 2);
+    gate.set_value();
+    first.wait();
+    WaitForInFlight(limit, 0);
+    // the slot is released when the handler returns
+    assert(!IsBusy(slow, self));
+    assert(limit.admitted() == 2);
+    assert(limit.in_flight() == 0);
+    slow.deregister();
+}
+
+void ShedsByPriority(tl::engine& engine, const tl::endpoint& self) {
+    tl::eventual<void> gate;
+    tl::admission_limit limit(2, tl::admission_limit::policy::shed_by_priority);
+    auto handler = [&gate](const tl::request& req) {
+        gate.wait();
+        req.respond();
+    };
+    auto high = engine.define("high", handler);
+    auto low  = engine.define("low", handler);
+    high.set_admission(limit);
+    low.set_priority(1).set_admission(limit);
+    // with one request in flight, priority 1 is already over its share
+    // of 2/(1+1) while priority 0 still fits
+    auto first = high.on(self).async();
+    WaitForInFlight(limit, 1);
+    assert(IsBusy(low, self));
+    auto second = high.on(self).async();
+    WaitForInFlight(limit, 2);
+    assert(IsBusy(high, self));
+    gate.set_value();
+    first.wait();
+    second.wait();
+    WaitForInFlight(limit, 0);
+    assert(!IsBusy(low, self));
+    assert(limit.rejected() == 2);
+    high.deregister();
+    low.deregister();
+}
+
+int main(int argc, char** argv) {
+    tl::engine   engine("na+sm", THALLIUM_SERVER_MODE);
+    tl::endpoint self = engine.self();
+    RejectsAboveLimit(engine, self);
+    ShedsByPriority(engine, self);
+    engine.finalize();
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+void FifoAndCapacity() {
+    // rounded up to a power of 2
+    tl::channel<int> ch(5);
+    assert(ch.capacity() == 8);
+    for(int i = 0; i < 8; i++) assert(ch.try_push(i));
+    assert(!ch.try_push(8));
+    assert(ch.size() == 8);
+    for(int i = 0; i < 8; i++) {
+        int v = -1;
+        assert(ch.try_pop(v));
+        assert(v == i);
+    }
+    int v;
+    assert(!ch.try_pop(v));
+    assert(ch.size() == 0);
+}
+
+void MovesValues() {
+    tl::channel<std::string> ch(2);
+    std::string s(1000, 'x');
+    ch.push(std::move(s));
+    std::string out;
+    assert(ch.pop(out));
+    assert(out.size() == 1000);
+}
+
+void Batches() {
+    tl::channel<int> ch(16);
+    std::vector<int> in{1, 2, 3, 4, 5};
+    assert(ch.push_batch(in.begin(), in.end()) == 5);
+    std::vector<int> out;
+    assert(ch.try_pop_batch(std::back_inserter(out), 3) == 3);
+    assert(ch.pop_batch(std::back_inserter(out), 10) == 2);
+    assert(out == in);
+}
+
+void Close() {
+    tl::channel<int> ch(4);
+    ch.push(1);
+    ch.close();
+    assert(ch.is_closed());
+    assert(!ch.try_push(2));
+    bool thrown = false;
+    try {
+        ch.push(2);
+    } catch(const tl::channel_exception&) { thrown = true; }
+    assert(thrown);
+    // the values pushed before closing are still delivered
+    int v = 0;
+    assert(ch.pop(v) && v == 1);
+    assert(!ch.pop(v));
+    std::vector<int> out;
+    assert(ch.pop_batch(std::back_inserter(out), 4) == 0);
+}
+
+void AsyncPop() {
+    tl::channel<int> ch(4);
+    ch.push(7);
+    // ready at once if a value is there, set by the next push otherwise
+    auto first  = ch.async_pop();
+    auto second = ch.async_pop();
+    assert(first.test());
+    assert(first.wait() == 7);
+    assert(!second.test());
+    ch.push(8);
+    assert(second.wait() == 8);
+    auto closed = ch.async_pop();
+    ch.close();
+    bool thrown = false;
+    try {
+        closed.wait();
+    } catch(const tl::channel_exception&) { thrown = true; }
+    assert(thrown);
+}
+
+void ProducersAndConsumers() {
+    // ULTs on several execution streams block on a small channel both
+    // when it is full and when it is empty; every value is popped once
+    const int            num_xstreams  = 4;
+    const int            num_producers = 4;
+    const int            num_consumers = 4;
+    const std::uint64_t  per_producer  = 20000;
+    tl::channel<std::uint64_t> ch(16);
+    std::atomic<std::uint64_t> sum{0};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<int>           producing{num_producers};
+    std::vector<tl::managed<tl::xstream>> xstreams;
+    std::vector<tl::managed<tl::thread>>  threads;
+    for(int i = 0; i < num_xstreams; i++) xstreams.push_back(tl::xstream::create());
+    for(int p = 0; p < num_producers; p++) {
+        threads.push_back(xstreams[p % num_xstreams]->make_thread([&, p]() {
+            for(std::uint64_t i = 0; i < per_producer; i++)
+                ch.push(p * per_producer + i);
+            if(producing.fetch_sub(1) == 1) ch.close();
+        }));
+    }
+    for(int c = 0; c < num_consumers; c++) {
+        threads.push_back(xstreams[c % num_xstreams]->make_thread([&]() {
+            std::uint64_t v;
+            while(ch.pop(v)) {
+                sum += v;
+                count += 1;
+            }
+        }));
+    }
+    for(auto& t : threads) t->join();
+    for(auto& x : xstreams) x->join();
+    const std::uint64_t n = num_producers * per_producer;
+    assert(count.load() == n);
+    assert(sum.load() == n * (n - 1) / 2);
+}
+
+int main(int argc, char** argv) {
+    tl::abt scope;
+    FifoAndCapacity();
+    MovesValues();
+    Batches();
+    Close();
+    AsyncPop();
+    ProducersAndConsumers();
+    return 0;
+}
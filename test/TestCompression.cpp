@@ -0,0 +1,115 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <vector>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace tl = thallium;
+
+// the codec linked in (see test/CMakeLists.txt), if any
+tl::compression Codec() {
+#if defined(THALLIUM_HAS_ZSTD)
+    return tl::compression::zstd(1024);
+#elif defined(THALLIUM_HAS_LZ4)
+    return tl::compression::lz4(1024);
+#else
+    tl::compression c;
+    c.threshold = 1024;
+    return c;
+#endif
+}
+
+bool HasCodec() {
+    return Codec().algorithm != tl::compression::codec::none;
+}
+
+// encodes v with a compression context and returns the bytes produced
+std::vector<char> Encode(margo_instance_id mid, std::vector<double>& v) {
+    auto              ctx = std::make_tuple(Codec());
+    std::vector<char> buffer(1024 * 1024);
+    hg_proc_t         proc = HG_PROC_NULL;
+    hg_return_t ret = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                         HG_ENCODE, HG_NOHASH, &proc);
+    assert(ret == HG_SUCCESS);
+    ret = tl::proc_object_encode(proc, v, mid, ctx);
+    assert(ret == HG_SUCCESS);
+    buffer.resize(hg_proc_get_size_used(proc));
+    hg_proc_free(proc);
+    return buffer;
+}
+
+hg_return_t Decode(margo_instance_id mid, std::vector<char>& buffer, std::vector<double>& v) {
+    auto        ctx  = std::make_tuple(Codec());
+    hg_proc_t   proc = HG_PROC_NULL;
+    hg_return_t ret  = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                          HG_DECODE, HG_NOHASH, &proc);
+    assert(ret == HG_SUCCESS);
+    ret = tl::proc_object_decode(proc, v, mid, ctx);
+    hg_proc_free(proc);
+    return ret;
+}
+
+void RoundTrip(margo_instance_id mid) {
+    std::vector<double> in(16 * 1024, 1.5);
+    auto                bytes = Encode(mid, in);
+    // compressible data shrinks, if a codec is there
+    if(HasCodec()) assert(bytes.size() < in.size() * sizeof(double) / 4);
+    else           assert(bytes.size() > in.size() * sizeof(double));
+    std::vector<double> out;
+    assert(Decode(mid, bytes, out) == HG_SUCCESS);
+    assert(out == in);
+    // small payloads are sent as they are
+    std::vector<double> small(4, 2.0);
+    bytes = Encode(mid, small);
+    assert(bytes[0] == 0);
+    out.clear();
+    assert(Decode(mid, bytes, out) == HG_SUCCESS);
+    assert(out == small);
+}
+
+void RejectsBadPayloads(margo_instance_id mid) {
+    // a decompressed size beyond what the codec can produce is refused
+    // before anything is allocated
+    std::vector<char> forged(1 + 2 * sizeof(std::uint64_t) + 16, 0);
+    forged[0] = static_cast<char>(tl::compression::codec::lz4);
+    std::uint64_t sizes[2] = {std::uint64_t(1) << 40, 16};
+    std::memcpy(forged.data() + 1, sizes, sizeof(sizes));
+    std::vector<double> out;
+    assert(Decode(mid, forged, out) == HG_PROTOCOL_ERROR);
+    if(!HasCodec()) return;
+    // corrupted compressed bytes are reported, not thrown through Mercury
+    std::vector<double> in(16 * 1024, 1.5);
+    auto bytes = Encode(mid, in);
+    assert(bytes[0] != 0);
+    for(std::size_t i = 1 + 2 * sizeof(std::uint64_t); i < bytes.size(); i++) bytes[i] ^= 0x5a;
+    assert(Decode(mid, bytes, out) == HG_PROTOCOL_ERROR);
+}
+
+void ThroughRpc(tl::engine& engine) {
+    auto echo = engine.define("echo",
+        [](const tl::request_with_context<tl::compression>& req, const std::vector<double>& v) {
+            req.respond(v);
+        });
+    std::vector<double> in(64 * 1024);
+    for(std::size_t i = 0; i < in.size(); i++) in[i] = static_cast<double>(i % 7);
+    std::vector<double> out =
+        echo.on(engine.self()).with_serialization_context(Codec())(in)
+            .with_serialization_context(Codec());
+    assert(out == in);
+}
+
+int main(int argc, char** argv) {
+    tl::engine engine("na+sm", THALLIUM_SERVER_MODE);
+    RoundTrip(engine.get_margo_instance());
+    RejectsBadPayloads(engine.get_margo_instance());
+    ThroughRpc(engine);
+    engine.finalize();
+    return 0;
+}
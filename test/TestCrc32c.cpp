@@ -0,0 +1,82 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <thallium/bulk_checksum.hpp>
+
+namespace tl = thallium;
+
+void KnownValues() {
+    // check values of the CRC-32C specification (RFC 3720, B.4)
+    assert(tl::crc32c("123456789", 9) == 0xe3069283u);
+    assert(tl::crc32c("", 0) == 0);
+    std::vector<unsigned char> zeros(32, 0x00);
+    assert(tl::crc32c(zeros.data(), zeros.size()) == 0x8a9136aau);
+    std::vector<unsigned char> ones(32, 0xff);
+    assert(tl::crc32c(ones.data(), ones.size()) == 0x62a8ab43u);
+    std::vector<unsigned char> increasing(32);
+    for(std::size_t i = 0; i < increasing.size(); i++)
+        increasing[i] = static_cast<unsigned char>(i);
+    assert(tl::crc32c(increasing.data(), increasing.size()) == 0x46dd794eu);
+}
+
+std::vector<unsigned char> Data(std::size_t size) {
+    std::vector<unsigned char> data(size);
+    std::uint32_t              x = 2463534242u;
+    for(auto& b : data) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        b = static_cast<unsigned char>(x);
+    }
+    return data;
+}
+
+void SoftwareMatchesHardware() {
+    // every length and alignment around the 8-byte words of both paths
+    auto data = Data(4096 + 16);
+    for(std::size_t offset = 0; offset < 8; offset++) {
+        for(std::size_t size = 0; size < 130; size++) {
+            const unsigned char* p  = data.data() + offset;
+            std::uint32_t        sw = ~tl::detail::crc32c_software(~0u, p, size);
+            assert(tl::crc32c(p, size) == sw);
+        }
+        const unsigned char* p = data.data() + offset;
+        assert(tl::crc32c(p, 4096) == ~tl::detail::crc32c_software(~0u, p, 4096));
+    }
+}
+
+void Continuation() {
+    // the checksum of a then b is crc32c(b, crc32c(a))
+    auto data = Data(1000);
+    auto full = tl::crc32c(data.data(), data.size());
+    for(std::size_t split : {0, 1, 7, 8, 9, 500, 999, 1000}) {
+        auto first = tl::crc32c(data.data(), split);
+        assert(tl::crc32c(data.data() + split, data.size() - split, first) == full);
+    }
+}
+
+void DetectsCorruption() {
+    auto data = Data(256);
+    auto crc  = tl::crc32c(data.data(), data.size());
+    for(std::size_t i = 0; i < data.size(); i++) {
+        for(int bit = 0; bit < 8; bit++) {
+            data[i] ^= static_cast<unsigned char>(1 << bit);
+            assert(tl::crc32c(data.data(), data.size()) != crc);
+            data[i] ^= static_cast<unsigned char>(1 << bit);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    KnownValues();
+    SoftwareMatchesHardware();
+    Continuation();
+    DetectsCorruption();
+    return 0;
+}
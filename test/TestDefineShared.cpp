@@ -0,0 +1,109 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+class tenant : public tl::provider<tenant> {
+
+    int                 m_value;
+    tl::eventual<void>* m_gate;
+
+    int get() const { return m_value; }
+
+    int get_after_gate() const {
+        entered = true;
+        m_gate->wait();
+        return m_value;
+    }
+
+  public:
+
+    static std::atomic<bool> entered;
+
+    tenant(const tl::engine& e, uint16_t provider_id, tl::eventual<void>* gate)
+    : tl::provider<tenant>(e, provider_id)
+    , m_value(100 * provider_id)
+    , m_gate(gate) {
+        define_shared<decltype(&tenant::get), &tenant::get>("get");
+        define_shared<decltype(&tenant::get_after_gate), &tenant::get_after_gate>("slow_get");
+    }
+
+    ~tenant() {
+        leave_shared_rpcs();
+    }
+};
+
+std::atomic<bool> tenant::entered{false};
+
+bool IsBusy(const tl::remote_procedure& rpc, const tl::provider_handle& ph) {
+    try {
+        rpc.on(ph)();
+    } catch(const tl::busy&) { return true; }
+    return false;
+}
+
+void ReachesEachTenant(const tl::remote_procedure& get, const tl::endpoint& self) {
+    for(uint16_t id = 1; id <= 4; id++) {
+        int r = get.on(tl::provider_handle(self, id))();
+        assert(r == 100 * id);
+    }
+}
+
+void DestroyedTenantIsBusy(std::vector<std::unique_ptr<tenant>>& tenants,
+                           const tl::remote_procedure& get, const tl::endpoint& self) {
+    // provider id 3
+    tenants[2].reset();
+    assert(IsBusy(get, tl::provider_handle(self, 3)));
+    // the others still answer
+    int r = get.on(tl::provider_handle(self, 4))();
+    assert(r == 400);
+}
+
+void LeaveWaitsForHandlers(tenant& t, tl::eventual<void>& gate,
+                           const tl::remote_procedure& get, const tl::remote_procedure& slow_get,
+                           const tl::endpoint& self) {
+    tl::provider_handle ph(self, t.get_provider_id());
+    auto                response = slow_get.on(ph).async();
+    while(!tenant::entered) tl::thread::yield();
+    std::atomic<bool> left{false};
+    auto leaving = tl::xstream::self().make_thread([&t, &left]() {
+        t.leave_shared_rpcs();
+        left = true;
+    });
+    // requests arriving while it leaves are turned away
+    while(!IsBusy(get, ph)) tl::thread::yield();
+    for(int i = 0; i < 10; i++) tl::thread::yield();
+    assert(!left);
+    gate.set_value();
+    int r = response.wait();
+    assert(r == 100 * t.get_provider_id());
+    leaving->join();
+    assert(left);
+    assert(IsBusy(get, ph));
+}
+
+int main(int argc, char** argv) {
+    tl::engine         engine("na+sm", THALLIUM_SERVER_MODE);
+    tl::endpoint       self = engine.self();
+    tl::eventual<void> gate;
+    {
+        std::vector<std::unique_ptr<tenant>> tenants;
+        for(uint16_t id = 1; id <= 4; id++)
+            tenants.emplace_back(new tenant(engine, id, &gate));
+        auto get      = engine.define("get");
+        auto slow_get = engine.define("slow_get");
+        ReachesEachTenant(get, self);
+        DestroyedTenantIsBusy(tenants, get, self);
+        LeaveWaitsForHandlers(*tenants[0], gate, get, slow_get, self);
+    }
+    engine.finalize();
+    return 0;
+}
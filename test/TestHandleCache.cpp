@@ -0,0 +1,73 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+void ReusesHandles(tl::engine& engine, const tl::remote_procedure& twice,
+                   const tl::endpoint& self) {
+    for(int i = 0; i < 10; i++) {
+        int r = twice.on(self)(i);
+        assert(r == 2 * i);
+    }
+    auto stats = engine.get_handle_cache_stats();
+    assert(stats.misses == 1);
+    assert(stats.hits == 9);
+    assert(stats.cached == 1);
+}
+
+void SeparatesRpcs(tl::engine& engine, const tl::remote_procedure& negate,
+                   const tl::endpoint& self) {
+    auto before = engine.get_handle_cache_stats();
+    int  r      = negate.on(self)(5);
+    assert(r == -5);
+    auto after = engine.get_handle_cache_stats();
+    assert(after.misses == before.misses + 1);
+    assert(after.cached == 2);
+}
+
+void BoundsIdleHandles(tl::engine& engine, const tl::remote_procedure& twice,
+                       const tl::endpoint& self) {
+    {
+        // handles in use are not shared: the ones past the cached one
+        // are created, and only max_handles of them are kept
+        std::vector<tl::callable_remote_procedure> calls;
+        calls.reserve(4);
+        for(int i = 0; i < 4; i++) calls.push_back(twice.on(self));
+        for(int i = 0; i < 4; i++) {
+            int r = calls[i](i);
+            assert(r == 2 * i);
+        }
+    }
+    // the cache held the handle of "negate", so only two of the four
+    // handles released fit
+    auto stats = engine.get_handle_cache_stats();
+    assert(stats.cached == 3);
+}
+
+int main(int argc, char** argv) {
+    tl::engine engine("na+sm", THALLIUM_SERVER_MODE);
+    engine.enable_handle_cache(3);
+    auto twice  = engine.define("twice", [](const tl::request& req, int x) {
+        req.respond(2 * x);
+    });
+    auto negate = engine.define("negate", [](const tl::request& req, int x) {
+        req.respond(-x);
+    });
+    tl::endpoint self = engine.self();
+    ReusesHandles(engine, twice, self);
+    SeparatesRpcs(engine, negate, self);
+    BoundsIdleHandles(engine, twice, self);
+    engine.disable_handle_cache();
+    auto stats = engine.get_handle_cache_stats();
+    assert(stats.hits == 0 && stats.misses == 0 && stats.cached == 0);
+    int r = twice.on(self)(21);
+    assert(r == 42);
+    engine.finalize();
+    return 0;
+}
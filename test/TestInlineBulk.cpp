@@ -0,0 +1,120 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+std::vector<char> Encode(margo_instance_id mid, tl::bulk& b) {
+    auto              args = std::make_tuple(std::ref(b));
+    std::tuple<>      ctx;
+    std::vector<char> buffer(4096);
+    hg_proc_t         proc = HG_PROC_NULL;
+    hg_return_t ret = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                         HG_ENCODE, HG_NOHASH, &proc);
+    assert(ret == HG_SUCCESS);
+    ret = tl::proc_object_encode(proc, args, mid, ctx);
+    assert(ret == HG_SUCCESS);
+    buffer.resize(hg_proc_get_size_used(proc));
+    hg_proc_free(proc);
+    return buffer;
+}
+
+// returns false if decoding failed or threw
+bool Decode(margo_instance_id mid, std::vector<char>& buffer, tl::bulk& b) {
+    std::tuple<tl::bulk> args;
+    std::tuple<>         ctx;
+    hg_proc_t            proc = HG_PROC_NULL;
+    hg_return_t ret = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                         HG_DECODE, HG_NOHASH, &proc);
+    assert(ret == HG_SUCCESS);
+    bool ok = false;
+    try {
+        ok = tl::proc_object_decode(proc, args, mid, ctx) == HG_SUCCESS;
+    } catch(const tl::exception&) {}
+    hg_proc_free(proc);
+    if(ok) b = std::get<0>(args);
+    return ok;
+}
+
+void InlinesSmallBulks(tl::engine& engine) {
+    auto              mid = engine.get_margo_instance();
+    std::vector<char> data(64, 'a');
+    tl::bulk          local = engine.expose({{data.data(), data.size()}},
+                                            tl::bulk_mode::read_only);
+    engine.disable_inline_bulk();
+    auto plain = Encode(mid, local);
+    engine.enable_inline_bulk(1024);
+    auto inlined = Encode(mid, local);
+    // the data and its size come before the handle
+    assert(inlined.size() == plain.size() + sizeof(std::uint64_t) + data.size());
+    // the receiver copies the data as it was when the bulk was sent
+    std::fill(data.begin(), data.end(), 'b');
+    tl::bulk remote;
+    assert(Decode(mid, inlined, remote));
+    std::vector<char> dest(64, 0);
+    tl::bulk dest_bulk = engine.expose({{dest.data(), dest.size()}}, tl::bulk_mode::write_only);
+    assert((remote.on(engine.self()) >> dest_bulk) == 64);
+    assert(dest == std::vector<char>(64, 'a'));
+    // an offset past the inlined data is refused
+    bool thrown = false;
+    try {
+        remote.on(engine.self())(96, 8) >> dest_bulk;
+    } catch(const tl::exception&) { thrown = true; }
+    assert(thrown);
+}
+
+void SkipsOtherBulks(tl::engine& engine) {
+    auto              mid = engine.get_margo_instance();
+    std::vector<char> data(64, 'a');
+    engine.disable_inline_bulk();
+    tl::bulk readable = engine.expose({{data.data(), data.size()}}, tl::bulk_mode::read_only);
+    auto     plain    = Encode(mid, readable);
+    engine.enable_inline_bulk(32);
+    // above the threshold
+    assert(Encode(mid, readable).size() == plain.size());
+    engine.enable_inline_bulk(1024);
+    // write-only destinations
+    tl::bulk write_only = engine.expose({{data.data(), data.size()}},
+                                        tl::bulk_mode::write_only);
+    assert(Encode(mid, write_only).size() == plain.size());
+}
+
+void RejectsForgedLengths(tl::engine& engine) {
+    auto              mid = engine.get_margo_instance();
+    std::vector<char> data(64, 'a');
+    engine.disable_inline_bulk();
+    tl::bulk local = engine.expose({{data.data(), data.size()}}, tl::bulk_mode::read_only);
+    auto     plain = Encode(mid, local);
+    tl::bulk remote;
+    // a length beyond the end of the payload
+    std::vector<char> overflow(sizeof(std::uint64_t) + 16, 0);
+    std::uint64_t     head = tl::detail::inline_bulk::tag | (std::uint64_t(1) << 40);
+    std::memcpy(overflow.data(), &head, sizeof(head));
+    assert(!Decode(mid, overflow, remote));
+    // a length that is not the size of the bulk
+    std::vector<char> mismatch(sizeof(std::uint64_t) + 3, 'z');
+    head = tl::detail::inline_bulk::tag | 3;
+    std::memcpy(mismatch.data(), &head, sizeof(head));
+    mismatch.insert(mismatch.end(), plain.begin(), plain.end());
+    assert(!Decode(mid, mismatch, remote));
+    // the handle alone still decodes
+    assert(Decode(mid, plain, remote));
+    assert(remote.size() == data.size());
+}
+
+int main(int argc, char** argv) {
+    tl::engine engine("na+sm", THALLIUM_SERVER_MODE);
+    InlinesSmallBulks(engine);
+    SkipsOtherBulks(engine);
+    RejectsForgedLengths(engine);
+    engine.finalize();
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+
+namespace tl = thallium;
+
+// counts its copies, which local dispatch avoids for rvalues
+struct tracked {
+    static int& copies() {
+        static int n = 0;
+        return n;
+    }
+
+    std::vector<int> data;
+
+    tracked() = default;
+    explicit tracked(std::size_t n) : data(n, 42) {}
+    tracked(const tracked& other) : data(other.data) { copies() += 1; }
+    tracked(tracked&&) = default;
+    tracked& operator=(const tracked& other) {
+        data = other.data;
+        copies() += 1;
+        return *this;
+    }
+    tracked& operator=(tracked&&) = default;
+
+    template <typename A> void serialize(A& ar) { ar & data; }
+};
+
+std::uint64_t handler_ult = 0;
+
+void RunsInCallerUlt(tl::engine& engine, const tl::remote_procedure& echo) {
+    tracked arg(1000);
+    tracked::copies() = 0;
+    handler_ult       = 0;
+    // the argument and the response are moved all the way
+    tracked r = echo.on(engine.self())(std::move(arg));
+    assert(r.data.size() == 1000 && r.data[0] == 42);
+    assert(tracked::copies() == 0);
+    assert(handler_ult == tl::thread::self_id());
+}
+
+void CopiesLvalues(tl::engine& engine, const tl::remote_procedure& echo) {
+    tracked arg(1000);
+    tracked::copies() = 0;
+    tracked r = echo.on(engine.self())(arg);
+    // the caller's argument is left intact
+    assert(arg.data.size() == 1000);
+    assert(r.data.size() == 1000);
+    assert(tracked::copies() == 1);
+}
+
+void FallsBackToMercury(tl::engine& engine) {
+    // admission limits need a handle, so the call goes through Mercury
+    auto limited = engine.define("limited", [](const tl::request& req, tracked t) {
+        handler_ult = tl::thread::self_id();
+        req.respond(std::move(t));
+    });
+    limited.set_admission(tl::admission_limit(16));
+    handler_ult = 0;
+    tracked r   = limited.on(engine.self())(tracked(10));
+    assert(r.data.size() == 10);
+    assert(handler_ult != 0 && handler_ult != tl::thread::self_id());
+}
+
+void OtherResponseTypes(tl::engine& engine) {
+    // a caller unpacking other types gets the response encoded
+    auto sum = engine.define("sum", [](const tl::request& req, int a, int b) {
+        req.respond(a + b);
+    });
+    long r = sum.on(engine.self())(2, 3).as<long>();
+    assert(r == 5);
+}
+
+int main(int argc, char** argv) {
+    tl::engine engine("na+sm", THALLIUM_SERVER_MODE);
+    engine.enable_local_dispatch();
+    auto echo = engine.define("echo", [](const tl::request& req, tracked t) {
+        handler_ult = tl::thread::self_id();
+        req.respond(std::move(t));
+    });
+    RunsInCallerUlt(engine, echo);
+    CopiesLvalues(engine, echo);
+    FallsBackToMercury(engine);
+    OtherResponseTypes(engine);
+    engine.finalize();
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/string.hpp>
+
+namespace tl = thallium;
+
+enum class color : std::uint16_t { red = 1, green = 2 };
+
+using numbers = std::tuple<std::int32_t, double, std::uint8_t, color, std::int64_t>;
+
+// only tuples of numbers and enums take the fixed-layout path, whether
+// they hold values (server) or references (client)
+static_assert(tl::detail::uses_pod_payload<numbers>::value, "");
+static_assert(tl::detail::uses_pod_payload<
+                  std::tuple<std::reference_wrapper<const std::int32_t>,
+                             std::reference_wrapper<const double>>>::value, "");
+static_assert(!tl::detail::uses_pod_payload<std::tuple<int, bool>>::value, "");
+static_assert(!tl::detail::uses_pod_payload<std::tuple<int, std::string>>::value, "");
+static_assert(!tl::detail::uses_pod_payload<std::tuple<>>::value, "");
+static_assert(!tl::detail::uses_pod_payload<numbers, tl::compression>::value, "");
+static_assert(tl::detail::pod_payload_size<std::int32_t, double, std::uint8_t, color,
+                                           std::int64_t>::value == 4 + 8 + 1 + 2 + 8, "");
+
+// encodes data through the archives (pod = false) or as a fixed-layout
+// block (pod = true)
+template <bool Pod, typename T>
+std::vector<char> Encode(margo_instance_id mid, T& data) {
+    std::tuple<>      ctx;
+    std::vector<char> buffer(4096);
+    hg_proc_t         proc = HG_PROC_NULL;
+    hg_return_t ret = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                         HG_ENCODE, HG_NOHASH, &proc);
+    assert(ret == HG_SUCCESS);
+    ret = tl::detail::proc_object_encode_archive(proc, data, mid, ctx,
+                                                 std::integral_constant<bool, Pod>());
+    assert(ret == HG_SUCCESS);
+    buffer.resize(hg_proc_get_size_used(proc));
+    hg_proc_free(proc);
+    return buffer;
+}
+
+template <bool Pod, typename T>
+void Decode(margo_instance_id mid, std::vector<char>& buffer, T& data) {
+    std::tuple<> ctx;
+    hg_proc_t    proc = HG_PROC_NULL;
+    hg_return_t  ret  = hg_proc_create_set(margo_get_class(mid), buffer.data(), buffer.size(),
+                                           HG_DECODE, HG_NOHASH, &proc);
+    assert(ret == HG_SUCCESS);
+    ret = tl::detail::proc_object_decode_archive(proc, data, mid, ctx,
+                                                 std::integral_constant<bool, Pod>());
+    assert(ret == HG_SUCCESS);
+    assert(hg_proc_get_size_used(proc) == buffer.size());
+    hg_proc_free(proc);
+}
+
+void SameBytesAsArchives(margo_instance_id mid) {
+    numbers in{-7, 3.25, 200, color::green, -(std::int64_t(1) << 40)};
+    auto    block   = Encode<true>(mid, in);
+    auto    archive = Encode<false>(mid, in);
+    assert(block == archive);
+    std::tuple<> ctx;
+    assert(tl::get_encoded_size(in, mid, ctx) == block.size());
+    // either side may decode either way
+    numbers out;
+    Decode<false>(mid, block, out);
+    assert(out == in);
+    out = numbers{};
+    Decode<true>(mid, archive, out);
+    assert(out == in);
+}
+
+void ClientTuples(margo_instance_id mid) {
+    // the client encodes references to its arguments
+    std::int32_t a = 12;
+    double       b = -0.5;
+    auto         refs = std::make_tuple(std::cref(a), std::cref(b));
+    auto         block = Encode<true>(mid, refs);
+    std::tuple<std::int32_t, double> out;
+    Decode<true>(mid, block, out);
+    assert(std::get<0>(out) == a && std::get<1>(out) == b);
+}
+
+void ThroughRpc(tl::engine& engine) {
+    auto mix = engine.define("mix",
+        [](const tl::request& req, std::int32_t i, double d, std::uint8_t u, color c) {
+            req.respond(static_cast<double>(i) + d + u, c == color::green ? color::red : c);
+        });
+    std::tuple<double, color> r = mix.on(engine.self())(std::int32_t(2), 0.5, std::uint8_t(3),
+                                                        color::green)
+                                      .as<double, color>();
+    assert(std::get<0>(r) == 5.5);
+    assert(std::get<1>(r) == color::red);
+}
+
+int main(int argc, char** argv) {
+    tl::engine engine("na+sm", THALLIUM_SERVER_MODE);
+    SameBytesAsArchives(engine.get_margo_instance());
+    ClientTuples(engine.get_margo_instance());
+    ThroughRpc(engine);
+    engine.finalize();
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// encodes payload_size bytes, in 1 KiB fields, into a proc starting
+// with a 4 KiB buffer, and returns the number of times its size changed
+int CountGrowths(const tl::engine& engine, hg_handle_t handle, std::size_t payload_size) {
+    std::vector<char> buffer(4096);
+    std::vector<char> field(1024, 'x');
+    hg_proc_t         proc = HG_PROC_NULL;
+    hg_return_t ret = hg_proc_create_set(margo_get_class(engine.get_margo_instance()),
+                                         buffer.data(), buffer.size(), HG_ENCODE,
+                                         HG_NOHASH, &proc);
+    assert(ret == HG_SUCCESS);
+    int growths = 0;
+    ret = tl::detail::encode_with_size_hint(proc, handle, false, [&](hg_proc_t p) {
+        hg_size_t size = hg_proc_get_size(p);
+        for(std::size_t done = 0; done < payload_size; done += field.size()) {
+            hg_return_t r = hg_proc_memcpy(p, field.data(), field.size());
+            if(r != HG_SUCCESS) return r;
+            if(hg_proc_get_size(p) != size) growths += 1;
+            size = hg_proc_get_size(p);
+        }
+        return HG_SUCCESS;
+    });
+    assert(ret == HG_SUCCESS);
+    hg_proc_free(proc);
+    return growths;
+}
+
+void FewerReallocations(const tl::engine& engine, hg_handle_t handle) {
+    const std::size_t payload = 256 * 1024;
+    tl::enable_proc_size_hints(false);
+    int without = CountGrowths(engine, handle, payload);
+    assert(without > 1);
+    tl::enable_proc_size_hints(true);
+    // the first payload teaches the hint, the next ones are presized
+    int first = CountGrowths(engine, handle, payload);
+    assert(first == without);
+    assert(CountGrowths(engine, handle, payload) == 0);
+    // a smaller payload halves the gap: the next full one grows less
+    assert(CountGrowths(engine, handle, payload / 2) == 0);
+    assert(CountGrowths(engine, handle, payload) < without);
+    assert(CountGrowths(engine, handle, payload) == 0);
+}
+
+void OutliersAreCappedAndForgotten(hg_id_t id) {
+    auto& hints = tl::detail::proc_size_hints::instance();
+    hints.record(id, true, 1000);
+    assert(hints.get(id, true) == 1000);
+    hints.record(id, true, std::size_t(1) << 30);
+    assert(hints.get(id, true) == tl::detail::proc_size_hints::max_hint);
+    hints.record(id, true, 1000);
+    assert(hints.get(id, true) < tl::detail::proc_size_hints::max_hint / 2 + 1000);
+    for(int i = 0; i < 32; i++) hints.record(id, true, 1000);
+    assert(hints.get(id, true) == 1000);
+}
+
+int main(int argc, char** argv) {
+    tl::engine   engine("na+sm", THALLIUM_SERVER_MODE);
+    auto         rpc    = engine.define("presized", [](const tl::request& req, int) {});
+    tl::endpoint self   = engine.self();
+    hg_handle_t  handle = HG_HANDLE_NULL;
+    hg_return_t  ret    = margo_create(engine.get_margo_instance(), self.get_addr(),
+                                       rpc.id(), &handle);
+    assert(ret == HG_SUCCESS);
+    FewerReallocations(engine, handle);
+    OutliersAreCappedAndForgotten(rpc.id());
+    margo_destroy(handle);
+    engine.finalize();
+    return 0;
+}
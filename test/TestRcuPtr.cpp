@@ -0,0 +1,142 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+// counts the versions alive, and checks that readers never see a
+// version being modified or deleted
+struct version {
+    static std::atomic<int>& alive() {
+        static std::atomic<int> n{0};
+        return n;
+    }
+
+    std::uint64_t a;
+    std::uint64_t b;
+
+    explicit version(std::uint64_t v)
+    : a(v), b(~v) { alive() += 1; }
+
+    version(const version& other)
+    : a(other.a), b(other.b) { alive() += 1; }
+
+    ~version() {
+        b = a; // breaks the invariant for readers of deleted versions
+        alive() -= 1;
+    }
+
+    bool valid() const { return b == ~a; }
+};
+
+void ReadAndUpdate() {
+    {
+        tl::rcu_ptr<version> p(std::unique_ptr<version>(new version(1)));
+        assert(p.read()->a == 1);
+        p.update([](version& v) { v.a = 2; v.b = ~v.a; });
+        assert(p.read()->a == 2);
+        p.store(std::unique_ptr<version>(new version(3)));
+        assert(p.read()->a == 3);
+        p.synchronize();
+        assert(p.pending() == 0);
+        assert(version::alive() == 1);
+    }
+    assert(version::alive() == 0);
+}
+
+void ReadersHoldBackDeletion() {
+    tl::rcu_ptr<version> p(std::unique_ptr<version>(new version(1)));
+    {
+        auto guard = p.read();
+        p.store(std::unique_ptr<version>(new version(2)));
+        p.store(std::unique_ptr<version>(new version(3)));
+        // the version read is still alive, and so is the one retired
+        // after it (its deletion waits for the same readers)
+        assert(!p.reclaim());
+        assert(p.pending() == 2);
+        assert(guard->a == 1 && guard->valid());
+        // new readers see the new version
+        assert(p.read()->a == 3);
+    }
+    assert(p.reclaim());
+    assert(p.pending() == 0);
+    assert(version::alive() == 1);
+}
+
+void MovedGuard() {
+    tl::rcu_ptr<version> p(std::unique_ptr<version>(new version(1)));
+    auto first  = p.read();
+    auto second = std::move(first);
+    assert(!first);
+    assert(second->a == 1);
+    p.store(std::unique_ptr<version>(new version(2)));
+    assert(!p.reclaim());
+    second = p.read(); // leaves the first read section
+    assert(second->a == 2);
+    assert(p.reclaim());
+}
+
+void ConcurrentReaders() {
+    // ULTs on several execution streams (each counting in its own slot)
+    // and a thread that is not an execution stream (counting in the
+    // shared counter) read while the main ULT publishes new versions
+    const int            num_xstreams = 4;
+    const std::uint64_t  num_updates  = 20000;
+    tl::rcu_ptr<version> p(std::unique_ptr<version>(new version(0)));
+    std::atomic<bool>    stop{false};
+    std::atomic<int>     invalid{0};
+    auto reader = [&p, &stop, &invalid]() {
+        std::uint64_t last = 0;
+        while(!stop.load()) {
+            auto v = p.read();
+            if(!v->valid() || v->a < last) invalid += 1;
+            last = v->a;
+            tl::thread::yield();
+        }
+    };
+    std::vector<tl::managed<tl::xstream>> xstreams;
+    std::vector<tl::managed<tl::thread>>  threads;
+    for(int i = 0; i < num_xstreams; i++) {
+        xstreams.push_back(tl::xstream::create());
+        threads.push_back(xstreams.back()->make_thread(reader));
+    }
+    std::thread external([&p, &stop, &invalid]() {
+        while(!stop.load()) {
+            auto v = p.read();
+            if(!v->valid()) invalid += 1;
+        }
+    });
+    for(std::uint64_t i = 1; i <= num_updates; i++) {
+        if(i % 2) p.store(std::unique_ptr<version>(new version(i)));
+        else p.update([i](version& v) { v.a = i; v.b = ~i; });
+    }
+    stop = true;
+    for(auto& t : threads) t->join();
+    external.join();
+    for(auto& x : xstreams) x->join();
+    assert(invalid.load() == 0);
+    assert(p.read()->a == num_updates);
+    p.synchronize();
+    assert(p.pending() == 0);
+    assert(version::alive() == 1);
+}
+
+int main(int argc, char** argv) {
+    tl::abt scope;
+    ReadAndUpdate();
+    ReadersHoldBackDeletion();
+    assert(version::alive() == 0);
+    MovedGuard();
+    ConcurrentReaders();
+    assert(version::alive() == 0);
+    return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <thallium/serialization/signature_hash.hpp>
+
+using namespace thallium::detail;
+
+static_assert(fnv1a("") == 14695981039346656037ull, "FNV-1a offset basis");
+static_assert(fnv1a("a") == 0xaf63dc4c8601ec8cull, "FNV-1a of \"a\"");
+
+void ClientMatchesServer() {
+    // the client encodes references to its arguments, the server
+    // decodes values: both must hash the same
+    using client = std::tuple<std::reference_wrapper<const int>,
+                              std::reference_wrapper<std::string>>;
+    using server = std::tuple<int, std::string>;
+    using forwarded = std::tuple<const int&, std::string&&>;
+    assert(signature_hash<client>() == signature_hash<server>());
+    assert(signature_hash<forwarded>() == signature_hash<server>());
+    assert(signature_hash<const std::vector<double>&>()
+           == signature_hash<std::vector<double>>());
+}
+
+void DifferentSignatures() {
+    using int_string = std::tuple<int, std::string>;
+    using string_int = std::tuple<std::string, int>;
+    assert(signature_hash<int_string>() != signature_hash<string_int>());
+    assert(signature_hash<std::tuple<int>>() != signature_hash<std::tuple<long>>());
+    assert(signature_hash<std::tuple<int>>() != signature_hash<int>());
+    assert(signature_hash<std::tuple<>>() != void_signature_hash());
+    assert(signature_hash<std::vector<int>>() != signature_hash<std::vector<unsigned>>());
+}
+
+void Stable() {
+    // computed once per type, and the same on every call
+    assert(signature_hash<std::string>() == signature_hash<std::string>());
+    assert(void_signature_hash() == fnv1a(typeid(void).name()));
+    assert(signature_hash<int>() == fnv1a(typeid(int).name()));
+}
+
+int main(int argc, char** argv) {
+    ClientMatchesServer();
+    DifferentSignatures();
+    Stable();
+    return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <vector>
+#include <thallium.hpp>
+
+namespace tl = thallium;
+
+using std::chrono::milliseconds;
+
+// sleeps until cond() holds, for at most timeout_ms
+template <typename F> bool WaitFor(const tl::engine& engine, F&& cond, int timeout_ms) {
+    for(int waited = 0; waited < timeout_ms; waited += 5) {
+        if(cond()) return true;
+        tl::thread::sleep(engine, 5);
+    }
+    return cond();
+}
+
+void ExpiryOrder(const tl::engine& engine) {
+    std::mutex       mtx;
+    std::vector<int> order;
+    auto record = [&mtx, &order](int i) {
+        std::lock_guard<std::mutex> lock(mtx);
+        order.push_back(i);
+    };
+    // 100 and 300 ms are beyond the 64 ticks of the first level, so
+    // they are cascaded down before they run
+    engine.schedule(milliseconds(300), [&record]() { record(300); });
+    engine.schedule(milliseconds(30), [&record]() { record(30); });
+    engine.schedule(milliseconds(100), [&record]() { record(100); });
+    engine.schedule(milliseconds(0), [&record]() { record(0); });
+    engine.schedule(milliseconds(10), [&record]() { record(10); });
+    bool done = WaitFor(engine, [&]() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return order.size() == 5;
+    }, 5000);
+    assert(done);
+    assert((order == std::vector<int>{0, 10, 30, 100, 300}));
+}
+
+void NotEarly(const tl::engine& engine) {
+    std::atomic<bool> ran{false};
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<long> elapsed_ms{0};
+    engine.schedule(milliseconds(50), [&ran, &elapsed_ms, start]() {
+        elapsed_ms = std::chrono::duration_cast<milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        ran = true;
+    });
+    bool done = WaitFor(engine, [&]() { return ran.load(); }, 5000);
+    assert(done);
+    assert(elapsed_ms.load() >= 49);
+}
+
+void Cancel(const tl::engine& engine) {
+    std::atomic<int> ran{0};
+    auto cancelled = engine.schedule(milliseconds(20), [&ran]() { ran += 100; });
+    auto kept      = engine.schedule(milliseconds(40), [&ran]() { ran += 1; });
+    assert(cancelled);
+    assert(cancelled.cancel());
+    // a token is stale once cancelled
+    assert(!cancelled.cancel());
+    bool done = WaitFor(engine, [&]() { return ran.load() != 0; }, 5000);
+    assert(done);
+    tl::thread::sleep(engine, 50);
+    assert(ran.load() == 1);
+    // or once its callback ran
+    assert(!kept.cancel());
+}
+
+void ReusedEntries(const tl::engine& engine) {
+    // the entry of a callback that ran is reused: an old token must not
+    // cancel the callback now using it
+    std::atomic<int> ran{0};
+    auto first = engine.schedule(milliseconds(1), [&ran]() { ran += 1; });
+    bool done  = WaitFor(engine, [&]() { return ran.load() == 1; }, 5000);
+    assert(done);
+    auto second = engine.schedule(milliseconds(20), [&ran]() { ran += 1; });
+    assert(!first.cancel());
+    done = WaitFor(engine, [&]() { return ran.load() == 2; }, 5000);
+    assert(done);
+    (void)second;
+}
+
+void Many(const tl::engine& engine) {
+    const int                          count = 20000;
+    std::atomic<int>                   ran{0};
+    std::atomic<int>                   cancelled{0};
+    std::vector<tl::timer_token>       tokens;
+    std::mt19937                       rng(42);
+    std::uniform_int_distribution<int> delay(0, 200);
+    for(int i = 0; i < count; i++)
+        tokens.push_back(engine.schedule(milliseconds(delay(rng)), [&ran]() { ran += 1; }));
+    for(int i = 0; i < count; i += 4)
+        if(tokens[i].cancel()) cancelled += 1;
+    bool done = WaitFor(engine, [&]() { return ran.load() + cancelled.load() == count; }, 10000);
+    assert(done);
+    tl::thread::sleep(engine, 50);
+    assert(ran.load() + cancelled.load() == count);
+}
+
+int main(int argc, char** argv) {
+    tl::engine engine("na+sm", THALLIUM_SERVER_MODE);
+    ExpiryOrder(engine);
+    NotEarly(engine);
+    Cancel(engine);
+    ReusedEntries(engine);
+    Many(engine);
+    engine.finalize();
+    return 0;
+}
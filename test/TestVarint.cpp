@@ -0,0 +1,114 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <thallium/serialization/varint.hpp>
+
+using namespace thallium::detail;
+
+template <typename T> void RoundTrip(T v) {
+    unsigned char buf[varint_max_size];
+    std::uint64_t z = zigzag_encode(v);
+    std::size_t   n = varint_encode(z, buf);
+    assert(n == varint_size(z));
+    assert(n >= 1 && n <= varint_max_size);
+    std::uint64_t decoded = 0;
+    assert(varint_decode(buf, buf + n, decoded) == n);
+    assert(decoded == z);
+    assert(zigzag_decode<T>(decoded) == v);
+}
+
+template <typename T> void RoundTripLimits() {
+    RoundTrip<T>(0);
+    RoundTrip<T>(1);
+    RoundTrip<T>(std::numeric_limits<T>::min());
+    RoundTrip<T>(std::numeric_limits<T>::max());
+    RoundTrip<T>(std::numeric_limits<T>::max() - 1);
+    RoundTrip<T>(static_cast<T>(std::numeric_limits<T>::min() + 1));
+}
+
+void ZigzagSmallValues() {
+    // small magnitudes of either sign map to small unsigned values
+    assert(zigzag_encode<std::int32_t>(0) == 0);
+    assert(zigzag_encode<std::int32_t>(-1) == 1);
+    assert(zigzag_encode<std::int32_t>(1) == 2);
+    assert(zigzag_encode<std::int32_t>(-2) == 3);
+    assert(zigzag_encode<std::int64_t>(std::numeric_limits<std::int64_t>::max())
+           == std::numeric_limits<std::uint64_t>::max() - 1);
+    assert(zigzag_encode<std::int64_t>(std::numeric_limits<std::int64_t>::min())
+           == std::numeric_limits<std::uint64_t>::max());
+    // unsigned values are not transformed
+    assert(zigzag_encode<std::uint32_t>(7) == 7);
+}
+
+void Sizes() {
+    assert(varint_size(0) == 1);
+    assert(varint_size(127) == 1);
+    assert(varint_size(128) == 2);
+    assert(varint_size(16383) == 2);
+    assert(varint_size(16384) == 3);
+    assert(varint_size(std::numeric_limits<std::uint64_t>::max()) == varint_max_size);
+}
+
+void KnownEncoding() {
+    unsigned char buf[varint_max_size];
+    assert(varint_encode(300, buf) == 2);
+    assert(buf[0] == 0xac && buf[1] == 0x02);
+}
+
+void Truncated() {
+    unsigned char buf[varint_max_size];
+    std::size_t   n = varint_encode(1ull << 40, buf);
+    std::uint64_t v = 42;
+    for(std::size_t i = 0; i < n; i++) {
+        assert(varint_decode(buf, buf + i, v) == 0);
+        assert(v == 42);
+    }
+}
+
+void TooLong() {
+    // eleven continuation bytes: longer than any valid varint
+    std::vector<unsigned char> buf(varint_max_size + 1, 0x80);
+    std::uint64_t v = 0;
+    assert(varint_decode(buf.data(), buf.data() + buf.size(), v) == 0);
+}
+
+void Sequence() {
+    // values written back to back are read back in order
+    std::vector<std::int64_t>  values = {0, -1, 1, 63, -64, 64, 1000000, -1000000000000ll};
+    std::vector<unsigned char> buf(values.size() * varint_max_size);
+    std::size_t                pos = 0;
+    for(auto v : values) pos += varint_encode(zigzag_encode(v), buf.data() + pos);
+    const unsigned char* p   = buf.data();
+    const unsigned char* end = buf.data() + pos;
+    for(auto v : values) {
+        std::uint64_t z = 0;
+        std::size_t   n = varint_decode(p, end, z);
+        assert(n != 0);
+        assert(zigzag_decode<std::int64_t>(z) == v);
+        p += n;
+    }
+    assert(p == end);
+}
+
+int main(int argc, char** argv) {
+    ZigzagSmallValues();
+    Sizes();
+    KnownEncoding();
+    RoundTripLimits<std::int16_t>();
+    RoundTripLimits<std::uint16_t>();
+    RoundTripLimits<std::int32_t>();
+    RoundTripLimits<std::uint32_t>();
+    RoundTripLimits<std::int64_t>();
+    RoundTripLimits<std::uint64_t>();
+    for(std::int64_t v = -70000; v <= 70000; v += 7) RoundTrip(v);
+    Truncated();
+    TooLong();
+    Sequence();
+    return 0;
+}
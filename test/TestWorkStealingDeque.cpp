@@ -0,0 +1,151 @@
+/*
+ * (C) 2026 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <thallium/abt.hpp>
+#include <thallium/work_stealing_pool.hpp>
+
+namespace tl = thallium;
+
+using units = std::vector<std::unique_ptr<tl::work_stealing_unit>>;
+
+// the pool only queues units, so they need no actual ULT
+units MakeUnits(std::size_t n) {
+    units u;
+    for(std::size_t i = 0; i < n; i++)
+        u.push_back(std::unique_ptr<tl::work_stealing_unit>(
+            new tl::work_stealing_unit(tl::thread())));
+    return u;
+}
+
+void Own(tl::work_stealing_pool& pool) {
+    ABT_xstream self;
+    ABT_xstream_self(&self);
+    pool.set_owner(self);
+}
+
+void OwnerPopsLifo() {
+    tl::work_stealing_pool pool;
+    Own(pool);
+    // more units than the initial array holds, so that it grows
+    auto u = MakeUnits(1000);
+    for(auto& x : u) pool.push(x.get());
+    assert(pool.get_size() == u.size());
+    for(std::size_t i = u.size(); i-- > 0;) {
+        auto x = pool.pop();
+        assert(x == u[i].get());
+        assert(!x->is_in_pool());
+    }
+    assert(pool.pop() == nullptr);
+    assert(pool.get_size() == 0);
+}
+
+void ThievesStealFifo() {
+    tl::work_stealing_pool pool;
+    Own(pool);
+    auto u = MakeUnits(600);
+    for(auto& x : u) pool.push(x.get());
+    for(std::size_t i = 0; i < 300; i++) assert(pool.steal() == u[i].get());
+    // the owner takes the other end
+    assert(pool.pop() == u.back().get());
+    for(std::size_t i = 300; i < u.size() - 1; i++) assert(pool.steal() == u[i].get());
+    assert(pool.steal() == nullptr);
+    assert(pool.pop() == nullptr);
+}
+
+void ForeignPushesGoToInbox() {
+    tl::work_stealing_pool pool;
+    Own(pool);
+    auto u = MakeUnits(100);
+    // a thread that is not an execution stream is not the owner
+    std::thread pusher([&]() {
+        for(auto& x : u) pool.push(x.get());
+    });
+    pusher.join();
+    assert(pool.get_size() == u.size());
+    // the inbox is FIFO for the owner too
+    for(auto& x : u) assert(pool.pop() == x.get());
+    assert(pool.pop() == nullptr);
+}
+
+void RemovedUnitsAreSkipped() {
+    tl::work_stealing_pool pool;
+    Own(pool);
+    auto u = MakeUnits(10);
+    for(auto& x : u) pool.push(x.get());
+    pool.remove(u[3].get());
+    pool.remove(u[9].get());
+    assert(!u[3]->is_in_pool());
+    assert(pool.get_size() == 8);
+    // a removed unit pushed again is returned once, by its new entry
+    pool.push(u[3].get());
+    assert(pool.pop() == u[3].get());
+    for(std::size_t i = 9; i-- > 0;) {
+        if(i == 3) continue;
+        assert(pool.pop() == u[i].get());
+    }
+    assert(pool.pop() == nullptr);
+    assert(pool.get_size() == 0);
+}
+
+void ConcurrentSteals() {
+    // the owner pushes and pops while thieves steal: every unit must
+    // be taken exactly once
+    const std::size_t      num_units   = 200000;
+    const std::size_t      num_thieves = 3;
+    tl::work_stealing_pool pool;
+    Own(pool);
+    auto u = MakeUnits(num_units);
+    std::unordered_map<tl::work_stealing_unit*, std::size_t> index;
+    for(std::size_t i = 0; i < num_units; i++) index[u[i].get()] = i;
+    std::vector<std::atomic<int>> taken(num_units);
+    for(auto& t : taken) t.store(0);
+    std::atomic<std::size_t> total{0};
+
+    std::vector<std::thread> thieves;
+    for(std::size_t t = 0; t < num_thieves; t++) {
+        thieves.emplace_back([&]() {
+            while(total.load() < num_units) {
+                auto x = pool.steal();
+                if(!x) continue;
+                taken[index.at(x)].fetch_add(1);
+                total.fetch_add(1);
+            }
+        });
+    }
+    for(std::size_t i = 0; i < num_units; i++) {
+        pool.push(u[i].get());
+        if(i % 3 == 0) {
+            auto x = pool.pop();
+            if(x) {
+                taken[index.at(x)].fetch_add(1);
+                total.fetch_add(1);
+            }
+        }
+    }
+    while(auto x = pool.pop()) {
+        taken[index.at(x)].fetch_add(1);
+        total.fetch_add(1);
+    }
+    for(auto& t : thieves) t.join();
+    assert(total.load() == num_units);
+    for(auto& t : taken) assert(t.load() == 1);
+    assert(pool.get_size() == 0);
+}
+
+int main(int argc, char** argv) {
+    tl::abt scope;
+    OwnerPopsLifo();
+    ThievesStealFifo();
+    ForeignPushesGoToInbox();
+    RemovedUnitsAreSkipped();
+    ConcurrentSteals();
+    return 0;
+}